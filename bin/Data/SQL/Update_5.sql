@@ -0,0 +1,41 @@
+CREATE INDEX IF NOT EXISTS "User_userName" ON "User" ("userName");
+CREATE INDEX IF NOT EXISTS "User_registerIP" ON "User" ("registerIP");
+CREATE INDEX IF NOT EXISTS "UserCharacter_gameName" ON "UserCharacter" ("gameName");
+CREATE INDEX IF NOT EXISTS "UserSessionHistory_userID" ON "UserSessionHistory" ("userID");
+CREATE INDEX IF NOT EXISTS "UserInventory_userID_slot" ON "UserInventory" ("userID", "slot");
+CREATE INDEX IF NOT EXISTS "UserInventory_userID_itemID" ON "UserInventory" ("userID", "itemID");
+CREATE INDEX IF NOT EXISTS "UserInventory_expiryDate" ON "UserInventory" ("expiryDate") WHERE "expiryDate" != 0 AND "inUse" = 1;
+CREATE INDEX IF NOT EXISTS "UserBan_term" ON "UserBan" ("term");
+CREATE INDEX IF NOT EXISTS "UserLoadout_userID_loadoutID" ON "UserLoadout" ("userID", "loadoutID");
+CREATE INDEX IF NOT EXISTS "UserBuyMenu_userID" ON "UserBuyMenu" ("userID");
+CREATE INDEX IF NOT EXISTS "UserFastBuy_userID_fastBuyID" ON "UserFastBuy" ("userID", "fastBuyID");
+CREATE INDEX IF NOT EXISTS "UserBookmark_userID" ON "UserBookmark" ("userID");
+CREATE INDEX IF NOT EXISTS "UserQuestProgress_userID_questID" ON "UserQuestProgress" ("userID", "questID");
+CREATE INDEX IF NOT EXISTS "UserQuestTaskProgress_userID_questID_taskID" ON "UserQuestTaskProgress" ("userID", "questID", "taskID");
+CREATE INDEX IF NOT EXISTS "UserCostumeLoadout_userID" ON "UserCostumeLoadout" ("userID");
+CREATE INDEX IF NOT EXISTS "UserZBCostumeLoadout_userID_slot" ON "UserZBCostumeLoadout" ("userID", "slot");
+CREATE INDEX IF NOT EXISTS "UserRewardNotice_userID" ON "UserRewardNotice" ("userID");
+CREATE INDEX IF NOT EXISTS "UserExpiryNotice_userID" ON "UserExpiryNotice" ("userID");
+CREATE INDEX IF NOT EXISTS "UserDailyReward_userID" ON "UserDailyReward" ("userID");
+CREATE INDEX IF NOT EXISTS "UserDailyRewardItems_userID" ON "UserDailyRewardItems" ("userID");
+CREATE INDEX IF NOT EXISTS "UserMiniGameBingo_userID" ON "UserMiniGameBingo" ("userID");
+CREATE INDEX IF NOT EXISTS "UserMiniGameBingoSlot_userID_number" ON "UserMiniGameBingoSlot" ("userID", "number");
+CREATE INDEX IF NOT EXISTS "UserMiniGameBingoPrizeSlot_userID_idx" ON "UserMiniGameBingoPrizeSlot" ("userID", "idx");
+CREATE INDEX IF NOT EXISTS "UserQuestEventProgress_userID_questID" ON "UserQuestEventProgress" ("userID", "questID");
+CREATE INDEX IF NOT EXISTS "UserQuestEventTaskProgress_userID_questID_taskID" ON "UserQuestEventTaskProgress" ("userID", "questID", "taskID");
+CREATE INDEX IF NOT EXISTS "UserBanList_userID_gameName" ON "UserBanList" ("userID", "gameName");
+CREATE INDEX IF NOT EXISTS "Clan_name" ON "Clan" ("name");
+CREATE INDEX IF NOT EXISTS "Clan_markID" ON "Clan" ("markID");
+CREATE INDEX IF NOT EXISTS "Clan_score" ON "Clan" ("score");
+CREATE INDEX IF NOT EXISTS "ClanMember_clanID" ON "ClanMember" ("clanID");
+CREATE INDEX IF NOT EXISTS "ClanMemberRequest_clanID" ON "ClanMemberRequest" ("clanID");
+CREATE INDEX IF NOT EXISTS "ClanStoragePage_clanID_pageID" ON "ClanStoragePage" ("clanID", "pageID");
+CREATE INDEX IF NOT EXISTS "ClanStorageItem_clanID_pageID_slot" ON "ClanStorageItem" ("clanID", "pageID", "slot");
+CREATE INDEX IF NOT EXISTS "ClanStorageItem_itemDuration" ON "ClanStorageItem" ("itemDuration") WHERE "itemID" != 0;
+CREATE INDEX IF NOT EXISTS "ClanChronicle_clanID" ON "ClanChronicle" ("clanID");
+CREATE INDEX IF NOT EXISTS "ClanInvite_destUserID_clanID" ON "ClanInvite" ("destUserID", "clanID");
+CREATE INDEX IF NOT EXISTS "UserSurveyAnswer_userID_surveyID" ON "UserSurveyAnswer" ("userID", "surveyID");
+CREATE INDEX IF NOT EXISTS "SuspectAction_hwid" ON "SuspectAction" ("hwid");
+CREATE INDEX IF NOT EXISTS "UserMiniGameWeaponReleaseItemProgress_userID_slot" ON "UserMiniGameWeaponReleaseItemProgress" ("userID", "slot");
+CREATE INDEX IF NOT EXISTS "UserMiniGameWeaponReleaseCharacters_userID_character" ON "UserMiniGameWeaponReleaseCharacters" ("userID", "character");
+CREATE INDEX IF NOT EXISTS "UserAddon_userID" ON "UserAddon" ("userID");
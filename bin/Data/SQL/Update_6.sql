@@ -0,0 +1 @@
+ALTER TABLE UserSession ADD COLUMN loginTime INT DEFAULT 0;
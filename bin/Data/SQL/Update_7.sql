@@ -0,0 +1,2 @@
+ALTER TABLE TimeConfig ADD COLUMN resetFlags INT DEFAULT 0;
+ALTER TABLE TimeConfig ADD COLUMN resetUserID INT DEFAULT 0;
@@ -0,0 +1 @@
+ALTER TABLE TimeConfig ADD COLUMN lastAliveTime INT DEFAULT 0;
@@ -13,6 +13,7 @@ CChannel::CChannel(CChannelServer* server, int id, const std::string& channelNam
 	m_pParentChannelServer = server;
 	m_nMaxPlayers = maxPlayers;
 	m_LoginMsg = loginMsg;
+	m_nPresenceSeq = 0;
 
 	m_Users.reserve(maxPlayers);
 }
@@ -36,13 +37,10 @@ bool CChannel::UserJoin(IUser* user, bool unhide)
 {
 	if (unhide)
 	{
-		for (auto u : m_Users)
-		{
-			if (u == user || u->GetCurrentRoom())
-				continue;
+		AddPresenceChange(user, true);
 
-			g_PacketManager.SendLobbyUserJoin(u->GetExtendedSocket(), user);
-		}
+		// callers send the lobby user list right after
+		m_PresenceSync[user->GetID()] = m_nPresenceSeq;
 
 		return true;
 	}
@@ -54,17 +52,17 @@ bool CChannel::UserJoin(IUser* user, bool unhide)
 		return false;
 	}
 
-	m_Users.push_back(user);
+	// the full list below already includes pending room list changes
+	FlushRoomListUpdates();
 
-	for (auto u : m_Users) // send lobby update packet for all users in channel
-	{
-		if (u == user)
-			continue;
+	m_Users.push_back(user);
 
-		g_PacketManager.SendLobbyUserJoin(u->GetExtendedSocket(), user);
-	}
+	// other users get the join on the next presence flush
+	AddPresenceChange(user, true);
 
 	g_PacketManager.SendLobbyJoin(user->GetExtendedSocket(), this);
+	m_PresenceSync[user->GetID()] = m_nPresenceSeq;
+
 	g_PacketManager.SendRoomListFull(user->GetExtendedSocket(), m_Rooms);
 
 	if (!m_LoginMsg.empty())
@@ -88,82 +86,312 @@ void CChannel::UserLeft(IUser* user, bool hide)
 		Logger().Info(OBFUSCATE("CChannel::UserLeft: couldn't find user with %d ID. User will remain in channel user list\n"), user->GetID());
 	}
 
-	for (auto u : m_Users) // send lobby update packet for all users in channel
-	{
-		if (/*u == user || */u->GetCurrentRoom())
-			continue;
+	// other users get the leave on the next presence flush
+	AddPresenceChange(user, false);
 
-		g_PacketManager.SendLobbyUserLeft(u->GetExtendedSocket(), user);
+	if (!hide)
+	{
+		// the user may be deleted before the flush, pending info changes are not sent anymore
+		LobbyPresence_s& presence = m_Presence[user->GetID()];
+		presence.lowFlag = 0;
+		presence.highFlag = 0;
 	}
 }
 
 void CChannel::SendFullUpdateRoomList()
 {
-	for (auto u : m_Users)
-	{
-		if (u->GetCurrentRoom())
-			continue;
+	FlushRoomListUpdates();
 
-		g_PacketManager.SendRoomListFull(u->GetExtendedSocket(), m_Rooms);
-	}
+	g_PacketManager.SendRoomListFull(GetOutsideUserSockets(), m_Rooms);
 }
 
 void CChannel::SendFullUpdateRoomList(IUser* user)
 {
+	// other lobby users must not miss the pending changes included in the full list
+	FlushRoomListUpdates();
+
 	g_PacketManager.SendRoomListFull(user->GetExtendedSocket(), m_Rooms);
 }
 
-void CChannel::SendUpdateRoomList(IRoom* room)
+/**
+ * Marks room list fields of the room as changed, they are sent to the lobby on the next flush
+ * @param lowFlag RLFLAG_* fields
+ * @param highFlag RLHFLAG_* fields
+ */
+void CChannel::SendUpdateRoomList(IRoom* room, int lowFlag, int highFlag)
 {
-	for (auto u : m_Users)
+	auto it = m_RoomListDeltas.find(room->GetID());
+	if (it == m_RoomListDeltas.end())
 	{
-		if (u->GetCurrentRoom())
-			continue;
+		m_RoomListDeltas.emplace(room->GetID(), RoomListDelta_s{ room, false, lowFlag, highFlag });
+		return;
+	}
+
+	it->second.lowFlag |= lowFlag;
+	it->second.highFlag |= highFlag;
+}
+
+struct RoomListFlagMap_s
+{
+	int roomFlag;
+	int lowFlag;
+	int highFlag;
+};
 
-		g_PacketManager.SendRoomListUpdate(u->GetExtendedSocket(), room);
+// room settings flags that are visible in the room list
+static const RoomListFlagMap_s s_LowFlagMap[] =
+{
+	{ ROOM_LOW_ROOMNAME, RLFLAG_NAME, 0 },
+	{ ROOM_LOW_CLANBATTLE, RLFLAG_CLANBATTLE, 0 },
+	{ ROOM_LOW_PASSWORD, RLFLAG_HASPASSWORD, 0 },
+	{ ROOM_LOW_LEVELLIMIT, RLFLAG_LEVELLIMIT, 0 },
+	{ ROOM_LOW_GAMEMODEID, RLFLAG_GAMEMODE, 0 },
+	{ ROOM_LOW_MAPID, RLFLAG_MAPID, 0 },
+	{ ROOM_LOW_MAXPLAYERS, RLFLAG_MAXPLAYERS, 0 },
+	{ ROOM_LOW_WEAPONLIMIT, RLFLAG_WEAPONLIMIT, 0 },
+	{ ROOM_LOW_FRIENDLYFIRE, RLFLAG_FRIENDLYFIRE, 0 },
+	{ ROOM_LOW_STATUS, RLFLAG_STATUSSYMBOL, 0 },
+};
+
+static const RoomListFlagMap_s s_LowMidFlagMap[] =
+{
+	{ ROOM_LOWMID_KDRULE, RLFLAG_KDRULE, 0 },
+	{ ROOM_LOWMID_STATUSSYMBOL, RLFLAG_STATUSSYMBOL, 0 },
+	{ ROOM_LOWMID_RANDOMMAP, RLFLAG_RANDOMMAP, 0 },
+	{ ROOM_LOWMID_MAPPLAYLIST, RLFLAG_MAPPLAYLIST, 0 },
+	{ ROOM_LOWMID_SD, RLFLAG_SD, 0 },
+	{ ROOM_LOWMID_ZSDIFFICULTY, RLFLAG_ZSDIFFICULTY, 0 },
+	{ ROOM_LOWMID_LEAGUERULE, RLFLAG_LEAGUERULE, 0 },
+	{ ROOM_LOWMID_MANNERLIMIT, RLFLAG_MANNERLIMIT, 0 },
+	{ ROOM_LOWMID_MAPID2, RLFLAG_MAPID, 0 },
+	{ ROOM_LOWMID_ZBLIMIT, RLFLAG_ZBLIMIT, 0 },
+	{ ROOM_LOWMID_VOXEL, RLFLAG_MAPID, 0 }, // voxel info is written with studio map
+	{ ROOM_LOWMID_SUPERROOM, RLFLAG_SUPERROOM, 0 },
+	{ ROOM_LOWMID_ISZBCOMPETITIVE, 0, RLHFLAG_ISZBCOMPETITIVE },
+	{ ROOM_LOWMID_ZBAUTOHUNTING, 0, RLHFLAG_ZBAUTOHUNTING },
+};
+
+static const RoomListFlagMap_s s_HighMidFlagMap[] =
+{
+	{ ROOM_HIGHMID_FIREBOMB, 0, RLHFLAG_FIREBOMB },
+	{ ROOM_HIGHMID_MUTATIONRESTRICT, 0, RLHFLAG_MUTATIONRESTRICT },
+	{ ROOM_HIGHMID_MUTATIONLIMIT, 0, RLHFLAG_MUTATIONLIMIT },
+	{ ROOM_HIGHMID_WEAPONRESTRICT, 0, RLHFLAG_WEAPONRESTRICT },
+	{ ROOM_HIGHMID_FAMILYBATTLE, 0, RLHFLAG_FAMILYBATTLE | RLHFLAG_FAMILYBATTLECLANIDS },
+	{ ROOM_HIGHMID_WEAPONBUYCOOLTIME, 0, RLHFLAG_WEAPONBUYCOOLTIME },
+	{ ROOM_HIGHMID_ZBREBALANCE, 0, RLHFLAG_ZBREBALANCE },
+};
+
+template <size_t N>
+static void MapRoomListFlags(const RoomListFlagMap_s (&map)[N], int roomFlag, int& lowFlag, int& highFlag)
+{
+	for (auto& entry : map)
+	{
+		if (roomFlag & entry.roomFlag)
+		{
+			lowFlag |= entry.lowFlag;
+			highFlag |= entry.highFlag;
+		}
 	}
 }
 
+/**
+ * Marks room list fields affected by the room settings update as changed
+ * @param lowFlag ROOM_LOW_* flags of the update
+ * @param lowMidFlag ROOM_LOWMID_* flags of the update
+ * @param highMidFlag ROOM_HIGHMID_* flags of the update
+ * @param highFlag ROOM_HIGH_* flags of the update
+ */
+void CChannel::SendUpdateRoomListSettings(IRoom* room, int lowFlag, int lowMidFlag, int highMidFlag, int highFlag)
+{
+	int roomListLowFlag = 0;
+	int roomListHighFlag = 0;
+
+	MapRoomListFlags(s_LowFlagMap, lowFlag, roomListLowFlag, roomListHighFlag);
+	MapRoomListFlags(s_LowMidFlagMap, lowMidFlag, roomListLowFlag, roomListHighFlag);
+	MapRoomListFlags(s_HighMidFlagMap, highMidFlag, roomListLowFlag, roomListHighFlag);
+
+	if (!roomListLowFlag && !roomListHighFlag)
+		return;
+
+	SendUpdateRoomList(room, roomListLowFlag, roomListHighFlag);
+}
+
 void CChannel::SendAddRoomToRoomList(IRoom* room)
 {
-	for (auto u : m_Users)
+	m_RoomListDeltas[room->GetID()] = RoomListDelta_s{ room, true, RLFLAG_ALL, RLHFLAG_ALL };
+}
+
+void CChannel::SendRemoveFromRoomList(int roomId)
+{
+	auto it = m_RoomListDeltas.find(roomId);
+	if (it != m_RoomListDeltas.end())
 	{
-		if (u->GetCurrentRoom())
-			continue;
+		bool added = it->second.added;
+		m_RoomListDeltas.erase(it);
 
-		g_PacketManager.SendRoomListAdd(u->GetExtendedSocket(), room);
+		// lobby has never seen the room
+		if (added)
+			return;
 	}
+
+	m_RemovedRoomIDs.push_back(roomId);
 }
 
-void CChannel::SendRemoveFromRoomList(int roomId)
+/**
+ * Sends room list changes collected since the last flush to the lobby, every room at most once
+ */
+void CChannel::FlushRoomListUpdates()
 {
-	for (auto u : m_Users)
+	if (m_RemovedRoomIDs.empty() && m_RoomListDeltas.empty())
+		return;
+
+	vector<IExtendedSocket*> sockets = GetOutsideUserSockets();
+	if (!sockets.empty())
 	{
-		if (u->GetCurrentRoom())
-			continue;
+		for (int roomId : m_RemovedRoomIDs)
+			g_PacketManager.SendRoomListRemove(sockets, roomId);
 
-		g_PacketManager.SendRoomListRemove(u->GetExtendedSocket(), roomId);
+		for (auto& it : m_RoomListDeltas)
+		{
+			const RoomListDelta_s& delta = it.second;
+			if (delta.added)
+				g_PacketManager.SendRoomListAdd(sockets, delta.room);
+			else
+				g_PacketManager.SendRoomListUpdate(sockets, delta.room, delta.lowFlag, delta.highFlag);
+		}
 	}
+
+	m_RemovedRoomIDs.clear();
+	m_RoomListDeltas.clear();
 }
 
 void CChannel::SendUserMessageToAllUser(int type, int senderUserID, const std::string& senderName, const std::string& msg)
 {
+	vector<IExtendedSocket*> sockets;
+	sockets.reserve(m_Users.size());
 	for (auto userDest : m_Users)
 	{
-		CUserCharacterExtended characterExtendedDest = userDest->GetCharacterExtended(EXT_UFLAG_BANSETTINGS);
-
 		// you can't send lobby message if dest is blocking your chat
-		if (~characterExtendedDest.banSettings & 2 || characterExtendedDest.banSettings & 2 && !g_UserDatabase.IsInBanList(userDest->GetID(), senderUserID))
-			g_PacketManager.SendUMsgUserMessage(userDest->GetExtendedSocket(), type, senderName, msg);
+		if (!userDest->IsBlocking(senderName, BANSETTINGS_CHAT))
+			sockets.push_back(userDest->GetExtendedSocket());
 	}
+
+	g_PacketManager.SendUMsgUserMessage(sockets, type, senderName, msg);
 }
 
 void CChannel::UpdateUserInfo(IUser* user, const CUserCharacter& character)
 {
-	for (auto u : m_Users)
+	// the user sees own changes immediately, other users on the next presence flush
+	g_PacketManager.SendUserUpdateInfo(user->GetExtendedSocket(), user, character);
+
+	LobbyPresence_s& presence = GetPresence(user, !user->GetCurrentRoom());
+	presence.lowFlag |= character.lowFlag;
+	presence.highFlag |= character.highFlag;
+	presence.infoSeq = ++m_nPresenceSeq;
+}
+
+/**
+ * Gets pending presence changes of the user, adds an empty entry if the user has none
+ * @param visible Whether the user is visible in the lobby now, used for a new entry
+ */
+LobbyPresence_s& CChannel::GetPresence(IUser* user, bool visible)
+{
+	auto it = m_Presence.find(user->GetID());
+	if (it != m_Presence.end())
+		return it->second;
+
+	return m_Presence.emplace(user->GetID(), LobbyPresence_s{ user, visible, {}, 0, 0, 0 }).first->second;
+}
+
+/**
+ * Adds lobby join or leave of the user to the presence journal
+ * @param visible true if the user joined the lobby, false if the user left it
+ */
+void CChannel::AddPresenceChange(IUser* user, bool visible)
+{
+	LobbyPresence_s& presence = GetPresence(user, !visible);
+
+	bool visibleNow = presence.visibleBefore ^ (presence.changes.size() & 1);
+	if (visibleNow == visible)
+		return;
+
+	presence.user = user;
+	presence.changes.push_back(++m_nPresenceSeq);
+}
+
+/**
+ * Sends presence changes collected since the last flush. Every user gets at most one packet per changed user: join, leave or
+ * info update. A join followed by a leave is never sent, users that got the lobby user list during the interval only get
+ * changes made after it
+ */
+void CChannel::FlushPresenceUpdates()
+{
+	if (m_Presence.empty())
+		return;
+
+	for (auto& it : m_Presence)
 	{
-		g_PacketManager.SendUserUpdateInfo(u->GetExtendedSocket(), user, character);
+		int userID = it.first;
+		LobbyPresence_s& presence = it.second;
+
+		bool visibleNow = presence.visibleBefore ^ (presence.changes.size() & 1);
+
+		vector<IExtendedSocket*> joinSockets;
+		vector<IExtendedSocket*> leftSockets;
+		vector<IExtendedSocket*> fullInfoSockets;
+		vector<IExtendedSocket*> infoSockets;
+
+		for (auto u : m_Users)
+		{
+			if (u->GetID() == userID)
+				continue;
+
+			auto sync = m_PresenceSync.find(u->GetID());
+			unsigned int syncSeq = sync != m_PresenceSync.end() ? sync->second : 0;
+
+			if (!u->GetCurrentRoom())
+			{
+				// state of the user in the lobby list of the recipient
+				int seenChanges = (int)count_if(presence.changes.begin(), presence.changes.end(), [syncSeq](unsigned int seq) { return seq <= syncSeq; });
+				bool seen = presence.visibleBefore ^ (seenChanges & 1);
+
+				if (seen != visibleNow)
+				{
+					(visibleNow ? joinSockets : leftSockets).push_back(u->GetExtendedSocket());
+					continue;
+				}
+
+				if (!visibleNow)
+					continue;
+
+				// left and joined back, the recipient has never seen the leave but the info may be outdated
+				if (seenChanges != (int)presence.changes.size())
+				{
+					fullInfoSockets.push_back(u->GetExtendedSocket());
+					continue;
+				}
+			}
+
+			if ((presence.lowFlag || presence.highFlag) && presence.infoSeq > syncSeq)
+				infoSockets.push_back(u->GetExtendedSocket());
+		}
+
+		if (!leftSockets.empty())
+			g_PacketManager.SendLobbyUserLeft(leftSockets, userID);
+
+		if (!joinSockets.empty())
+			g_PacketManager.SendLobbyUserJoin(joinSockets, presence.user);
+
+		if (!fullInfoSockets.empty())
+			g_PacketManager.SendUserUpdateInfo(fullInfoSockets, presence.user, presence.user->GetCharacter(UFLAG_LOW_ALL, UFLAG_HIGH_ALL));
+
+		if (!infoSockets.empty())
+			g_PacketManager.SendUserUpdateInfo(infoSockets, presence.user, presence.user->GetCharacter(presence.lowFlag, presence.highFlag));
 	}
+
+	m_Presence.clear();
+	m_PresenceSync.clear();
 }
 
 IRoom* CChannel::GetRoomById(int id)
@@ -188,12 +416,18 @@ IUser* CChannel::GetUserById(int userId)
 
 IRoom* CChannel::CreateRoom(IUser* host, CRoomSettings* settings)
 {
-	m_Rooms.push_back(new CRoom(m_nNextRoomID++, host, this, settings));
-	return m_Rooms.back();
+	IRoom* room = new CRoom(m_nNextRoomID++, host, this, settings);
+	m_Rooms.push_back(room);
+
+	SendAddRoomToRoomList(room);
+
+	return room;
 }
 
 void CChannel::RemoveRoom(IRoom* room)
 {
+	SendRemoveFromRoomList(room->GetID());
+
 	m_Rooms.erase(remove(begin(m_Rooms), end(m_Rooms), room), end(m_Rooms));
 	delete room;
 }
@@ -203,6 +437,7 @@ bool CChannel::RemoveUser(IUser* user)
 	const auto oldSize = m_Users.size();
 
 	m_Users.erase(remove(begin(m_Users), end(m_Users), user), end(m_Users));
+	m_PresenceSync.erase(user->GetID());
 
 	return oldSize != m_Users.size();
 }
@@ -237,6 +472,25 @@ std::vector<IUser*> CChannel::GetOutsideUsers()
 	return outsideUsers;
 }
 
+/**
+ * Gets sockets of users that are in the lobby (not in a room), recipients of lobby broadcasts
+ * @param except User to skip
+ */
+std::vector<IExtendedSocket*> CChannel::GetOutsideUserSockets(IUser* except)
+{
+	std::vector<IExtendedSocket*> sockets;
+	sockets.reserve(m_Users.size());
+	for (auto u : m_Users)
+	{
+		if (u == except || u->GetCurrentRoom())
+			continue;
+
+		sockets.push_back(u->GetExtendedSocket());
+	}
+
+	return sockets;
+}
+
 CChannelServer* CChannel::GetParentChannelServer()
 {
 	return m_pParentChannelServer;
@@ -2,8 +2,34 @@
 
 #include "room/room.h"
 
+#include <unordered_map>
+
 class CChannelServer;
 
+/**
+ * Pending room list changes of a room, sent to the lobby on the next flush
+ */
+struct RoomListDelta_s
+{
+	IRoom* room;
+	bool added; // not announced yet, sent with all fields
+	int lowFlag; // RLFLAG_*
+	int highFlag; // RLHFLAG_*
+};
+
+/**
+ * Pending lobby presence changes of a user, sent on the next flush
+ */
+struct LobbyPresence_s
+{
+	IUser* user; // not valid after the user left the channel, only used while visible
+	bool visibleBefore; // visible in the lobby before the first change
+	std::vector<unsigned int> changes; // sequence numbers of joins and leaves, they alternate
+	int lowFlag; // UFLAG_LOW_* info changes
+	int highFlag; // UFLAG_HIGH_*
+	unsigned int infoSeq; // sequence number of the last info change
+};
+
 class CChannel
 {
 public:
@@ -16,9 +42,12 @@ public:
 	void UserLeft(IUser* user, bool hide = false);
 	void SendFullUpdateRoomList();
 	void SendFullUpdateRoomList(IUser* user);
-	void SendUpdateRoomList(IRoom* room);
+	void SendUpdateRoomList(IRoom* room, int lowFlag = RLFLAG_ALL, int highFlag = RLHFLAG_ALL);
+	void SendUpdateRoomListSettings(IRoom* room, int lowFlag, int lowMidFlag, int highMidFlag, int highFlag);
 	void SendAddRoomToRoomList(IRoom* room);
 	void SendRemoveFromRoomList(int roomId);
+	void FlushRoomListUpdates();
+	void FlushPresenceUpdates();
 	void SendUserMessageToAllUser(int type, int senderUserID, const std::string& senderName, const std::string& msg);
 	void UpdateUserInfo(IUser* user, const CUserCharacter& character);
 	IRoom* CreateRoom(IUser* host, CRoomSettings* settings);
@@ -36,6 +65,10 @@ public:
 	CChannelServer* GetParentChannelServer();
 
 private:
+	std::vector<IExtendedSocket*> GetOutsideUserSockets(IUser* except = NULL);
+	LobbyPresence_s& GetPresence(IUser* user, bool visible);
+	void AddPresenceChange(IUser* user, bool visible);
+
 	CChannelServer* m_pParentChannelServer;
 
 	int m_nID;
@@ -46,4 +79,14 @@ private:
 
 	std::vector<IRoom*> m_Rooms;
 	std::vector<IUser*> m_Users;
+
+	// room list changes since the last flush
+	std::unordered_map<int, RoomListDelta_s> m_RoomListDeltas;
+	std::vector<int> m_RemovedRoomIDs;
+
+	// lobby presence changes since the last flush
+	std::unordered_map<int, LobbyPresence_s> m_Presence;
+	// users that got the lobby user list after the last flush, by the sequence number they are up to date with
+	std::unordered_map<int, unsigned int> m_PresenceSync;
+	unsigned int m_nPresenceSeq;
 };
\ No newline at end of file
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <unordered_set>
+#include <algorithm>
+
+// ban settings flags (EXT_UFLAG_BANSETTINGS)
+#define BANSETTINGS_ROOMJOIN 1 // banned users can't join rooms hosted by the user
+#define BANSETTINGS_CHAT 2 // chat and whispers of banned users are not received
+#define BANSETTINGS_WHISPERALL 4 // whispers are blocked for everyone
+
+/**
+ * In-memory copy of the user's ban list (UserBanList rows), game names are looked up in constant time.
+ * Kept in the order of the database rows, the client shows the list as it is sent
+ */
+class CBanList
+{
+public:
+	void Load(const std::vector<std::string>& gameNames)
+	{
+		m_GameNames = gameNames;
+		m_Lookup.clear();
+		m_Lookup.insert(gameNames.begin(), gameNames.end());
+	}
+
+	void Add(const std::string& gameName)
+	{
+		if (m_Lookup.insert(gameName).second)
+			m_GameNames.push_back(gameName);
+	}
+
+	void Remove(const std::string& gameName)
+	{
+		if (m_Lookup.erase(gameName))
+			m_GameNames.erase(std::remove(m_GameNames.begin(), m_GameNames.end(), gameName), m_GameNames.end());
+	}
+
+	bool Contains(const std::string& gameName) const
+	{
+		return m_Lookup.find(gameName) != m_Lookup.end();
+	}
+
+	/**
+	 * Checks if the owner of the list blocks the user
+	 * @param banSettings Ban settings of the owner
+	 * @param setting BANSETTINGS_* feature to check
+	 * @param gameName Game name of the other user
+	 */
+	bool IsBlocking(int banSettings, int setting, const std::string& gameName) const
+	{
+		return (banSettings & setting) && Contains(gameName);
+	}
+
+	const std::vector<std::string>& Get() const
+	{
+		return m_GameNames;
+	}
+
+	void Clear()
+	{
+		m_GameNames.clear();
+		m_Lookup.clear();
+	}
+
+private:
+	std::vector<std::string> m_GameNames;
+	std::unordered_set<std::string> m_Lookup;
+};
@@ -0,0 +1,166 @@
+#pragma once
+
+#include <atomic>
+#include <vector>
+#include <cstdint>
+
+/**
+ * Bounded lock-free queue (Dmitry Vyukov's array based MPMC queue).
+ * Every cell has a sequence number that tells producers and consumers whether the cell is free or filled for their position,
+ * so a push or a pop is a single CAS on the position counter
+ */
+template <typename T>
+class CBoundedQueue
+{
+public:
+	/**
+	 * Constructor.
+	 * @param capacity Queue capacity, rounded up to a power of two
+	 */
+	CBoundedQueue(size_t capacity)
+	{
+		size_t size = 2;
+		while (size < capacity)
+			size <<= 1;
+
+		m_Cells.resize(size);
+		m_nMask = size - 1;
+
+		for (size_t i = 0; i < size; i++)
+			m_Cells[i].sequence.store(i, std::memory_order_relaxed);
+
+		m_nEnqueuePos.store(0, std::memory_order_relaxed);
+		m_nDequeuePos.store(0, std::memory_order_relaxed);
+	}
+
+	/**
+	 * Adds value to the queue
+	 * @param value
+	 * @param pos Receives position of the value in the queue, optional
+	 * @return False if the queue is full
+	 */
+	bool Push(const T& value, size_t* pos = NULL)
+	{
+		size_t enqueuePos = m_nEnqueuePos.load(std::memory_order_relaxed);
+		Cell* cell;
+
+		while (true)
+		{
+			cell = &m_Cells[enqueuePos & m_nMask];
+			size_t sequence = cell->sequence.load(std::memory_order_acquire);
+			intptr_t diff = (intptr_t)sequence - (intptr_t)enqueuePos;
+			if (diff == 0)
+			{
+				if (m_nEnqueuePos.compare_exchange_weak(enqueuePos, enqueuePos + 1))
+					break;
+			}
+			else if (diff < 0)
+			{
+				// the cell still holds a value from the previous lap
+				return false;
+			}
+			else
+			{
+				enqueuePos = m_nEnqueuePos.load(std::memory_order_relaxed);
+			}
+		}
+
+		cell->value = value;
+		cell->sequence.store(enqueuePos + 1, std::memory_order_release);
+
+		if (pos)
+			*pos = enqueuePos;
+
+		return true;
+	}
+
+	/**
+	 * Removes value from the queue
+	 * @param value Receives removed value
+	 * @param pos Receives position of the value in the queue, optional
+	 * @return False if the queue is empty
+	 */
+	bool Pop(T& value, size_t* pos = NULL)
+	{
+		size_t dequeuePos = m_nDequeuePos.load(std::memory_order_relaxed);
+		Cell* cell;
+
+		while (true)
+		{
+			cell = &m_Cells[dequeuePos & m_nMask];
+			size_t sequence = cell->sequence.load(std::memory_order_acquire);
+			intptr_t diff = (intptr_t)sequence - (intptr_t)(dequeuePos + 1);
+			if (diff == 0)
+			{
+				if (m_nDequeuePos.compare_exchange_weak(dequeuePos, dequeuePos + 1))
+					break;
+			}
+			else if (diff < 0)
+			{
+				// the cell has not been filled yet
+				return false;
+			}
+			else
+			{
+				dequeuePos = m_nDequeuePos.load(std::memory_order_relaxed);
+			}
+		}
+
+		value = cell->value;
+		cell->sequence.store(dequeuePos + m_nMask + 1, std::memory_order_release);
+
+		if (pos)
+			*pos = dequeuePos;
+
+		return true;
+	}
+
+	/**
+	 * Gets position that the next pushed value will get. Values pushed before the call have lower positions
+	 */
+	size_t GetEnqueuePos()
+	{
+		return m_nEnqueuePos.load();
+	}
+
+	/**
+	 * Gets approximate number of values in the queue
+	 */
+	size_t Size()
+	{
+		size_t dequeuePos = m_nDequeuePos.load();
+		size_t enqueuePos = m_nEnqueuePos.load();
+
+		return enqueuePos > dequeuePos ? enqueuePos - dequeuePos : 0;
+	}
+
+	bool Empty()
+	{
+		return Size() == 0;
+	}
+
+	size_t Capacity()
+	{
+		return m_nMask + 1;
+	}
+
+	// queues are non-copyable
+	CBoundedQueue(const CBoundedQueue&) = delete;
+	CBoundedQueue& operator=(const CBoundedQueue&) = delete;
+
+private:
+	struct Cell
+	{
+		Cell() : sequence(0), value() {}
+		Cell(const Cell& other) : sequence(other.sequence.load()), value(other.value) {}
+
+		std::atomic<size_t> sequence;
+		T value;
+	};
+
+	// keep positions on different cache lines, they are written by different threads
+	alignas(64) std::atomic<size_t> m_nEnqueuePos;
+	alignas(64) std::atomic<size_t> m_nDequeuePos;
+	alignas(64) std::vector<Cell> m_Cells;
+	size_t m_nMask;
+};
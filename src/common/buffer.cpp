@@ -1,72 +1,160 @@
 #include "buffer.h"
+#include "bufferpool.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
 
 /************************* WRITING *************************/
 
-Buffer::Buffer() {
-	buffer.reserve(20000);
+Buffer::Buffer() :
+	buffer(CBufferPool::Get(0)) {
+	viewData = NULL;
+	viewSize = 0;
 	readOffset = 0;
 	writeOffset = 0;
 	overrideBuf = 0;
 }
 Buffer::Buffer(const std::vector<unsigned char>& _buffer) :
-	buffer(_buffer) {
+	buffer(CBufferPool::Get(_buffer.size())) {
+	buffer.assign(_buffer.begin(), _buffer.end());
+	viewData = NULL;
+	viewSize = 0;
+	readOffset = 0;
+	writeOffset = 0;
+	overrideBuf = 0;
+}
+/**
+ * Creates read-only view of size bytes at offset of data without copying them.
+ * The data is kept alive by the view and must not be changed while any view references it
+ */
+Buffer::Buffer(const std::shared_ptr<std::vector<unsigned char>>& data, unsigned long long offset, unsigned long long size) :
+	view(data) {
+	viewData = data->data() + offset;
+	viewSize = size;
 	readOffset = 0;
 	writeOffset = 0;
 	overrideBuf = 0;
 }
 
 void Buffer::setBuffer(std::vector<unsigned char>& _buffer) {
+	view.reset();
 	buffer = _buffer;
 }
 const std::vector<unsigned char>& Buffer::getBuffer() const {
+	// views have no vector, make a copy
+	if (view && buffer.size() != viewSize)
+		buffer.assign(viewData, viewData + viewSize);
+
 	return buffer;
 }
+const unsigned char* Buffer::getData() const {
+	return view ? viewData : buffer.data();
+}
+unsigned char* Buffer::getWritableData() {
+	detach();
+	return buffer.data();
+}
+unsigned long long Buffer::getSize() const {
+	return view ? viewSize : buffer.size();
+}
 void Buffer::clear() {
+	view.reset();
 	buffer.clear();
 	readOffset = 0;
 	writeOffset = 0;
 }
+void Buffer::detach() {
+	if (!view)
+		return;
+
+	reserve(viewSize);
+	buffer.assign(viewData, viewData + viewSize);
+	view.reset();
+}
+void Buffer::reserve(unsigned long long size) {
+	if (size <= buffer.capacity())
+		return;
+
+	// move to a pooled buffer of the next size class instead of letting vector reallocate
+	std::vector<unsigned char> newBuffer = CBufferPool::Get(std::max((size_t)size, buffer.capacity() * 2));
+	newBuffer.assign(buffer.begin(), buffer.end());
+	CBufferPool::Release(buffer);
+	buffer.swap(newBuffer);
+}
+inline void Buffer::write(const unsigned char* data, unsigned long long len) {
+	unsigned long long size = buffer.size();
+
+	// append without reallocation, the common case
+	if (writeOffset == size && size + len <= buffer.capacity() && !overrideBuf && !view) {
+		// push_back is inlined for numbers, bigger arrays are copied with memcpy by insert
+		if (len <= sizeof(unsigned long long)) {
+			for (unsigned long long i = 0; i < len; ++i)
+				buffer.push_back(data[i]);
+		}
+		else
+			buffer.insert(buffer.end(), data, data + len);
+
+		writeOffset += len;
+	}
+	else
+		writeSlow(data, len);
+}
+void Buffer::writeSlow(const unsigned char* data, unsigned long long len) {
+	detach();
+
+	if (overrideBuf) {
+		// overwrite existing data, out of range writes throw like vector::at
+		if (writeOffset + len > buffer.size())
+			throw std::out_of_range("Buffer::write: override out of range");
+
+		memcpy(buffer.data() + writeOffset, data, len);
+	}
+	else {
+		// insert at write offset, append if it's the end of buffer
+		if (writeOffset > buffer.size())
+			buffer.resize(writeOffset);
+
+		reserve(buffer.size() + len);
+		buffer.insert(buffer.begin() + writeOffset, data, data + len);
+	}
+
+	writeOffset += len;
+}
 
 std::string Buffer::byteStr(bool LE) const {
 	std::stringstream byteStr;
 	byteStr << std::hex << std::setfill('0');
 
+	const unsigned char* data = getData();
+	unsigned long long size = getSize();
 	if (LE == true) {
-		for (unsigned long long i = 0; i < buffer.size(); ++i)
-			byteStr << std::setw(2) << (unsigned short)buffer[i] << " ";
+		for (unsigned long long i = 0; i < size; ++i)
+			byteStr << std::setw(2) << (unsigned short)data[i] << " ";
 	}
 	else {
-		unsigned long long size = buffer.size();
 		for (unsigned long long i = 0; i < size; ++i)
-			byteStr << std::setw(2) << (unsigned short)buffer[size - i - 1] << " ";
+			byteStr << std::setw(2) << (unsigned short)data[size - i - 1] << " ";
 	}
 
 	return byteStr.str();
 }
 
 template <class T> inline void Buffer::writeBytes(const T& val, bool LE) {
-	unsigned int size = sizeof(T);
+	const unsigned int size = sizeof(T);
+	unsigned char bytes[size];
 
 	if (LE == true) {
 		for (unsigned int i = 0, mask = 0; i < size; ++i, mask += 8)
-		{
-			if (overrideBuf)
-				buffer.at(writeOffset + i) = val >> mask;
-			else
-				buffer.insert(buffer.begin() + writeOffset + i, val >> mask);
-		}
+			bytes[i] = val >> mask;
 	}
 	else {
 		unsigned const char* array = reinterpret_cast<unsigned const char*>(&val);
 		for (unsigned int i = 0; i < size; ++i)
-		{
-			if (overrideBuf)
-				buffer.at(writeOffset + i) = array[size - i - 1];
-			else
-				buffer.insert(buffer.begin() + writeOffset + i, array[size - i - 1]);
-		}
+			bytes[i] = array[size - i - 1];
 	}
-	writeOffset += size;
+
+	write(bytes, size);
 }
 
 unsigned long long Buffer::getWriteOffset() const {
@@ -84,8 +172,7 @@ void Buffer::writeBool(bool val) {
 	writeBytes<bool>(val);
 }
 void Buffer::writeStr(const std::string& str) {
-	for (unsigned char s : str) writeInt8(s);
-	writeInt8('\0');
+	write((const unsigned char*)str.c_str(), str.size() + 1);
 }
 void Buffer::writeWStr(const std::wstring& str) {
 	for (unsigned char s : str) writeInt8(s);
@@ -98,19 +185,10 @@ void Buffer::writeUInt8(unsigned char val) {
 	writeBytes<unsigned char>(val, false);
 }
 void Buffer::writeArray(const std::vector<unsigned char>& vec) {
-	if (overrideBuf)
-		printf("writeArray override not implemented\n");
-	else
-		buffer.insert(buffer.begin() + writeOffset, vec.begin(), vec.end());
-	
-	writeOffset += vec.size();
+	write(vec.data(), vec.size());
 }
 void Buffer::writeData(void* data, int len) {
-	if (overrideBuf)
-		printf("writeArray override not implemented\n");
-	else
-		buffer.insert(buffer.begin() + writeOffset, (unsigned char*)data, (unsigned char*)data + len);
-	writeOffset += len;
+	write((const unsigned char*)data, len);
 }
 
 void Buffer::writeInt16_LE(short val) {
@@ -186,13 +264,13 @@ template <class T> inline T Buffer::readBytes(bool LE) {
 	unsigned int size = sizeof(T);
 
 	// Do not overflow
-	if (readOffset + size > buffer.size())
+	if (readOffset + size > getSize())
 	{
 		return result;
 	}
 
 	char* dst = (char*)&result;
-	char* src = (char*)&buffer[readOffset];
+	const char* src = (const char*)getData() + readOffset;
 
 	if (LE == true) {
 		for (unsigned int i = 0; i < size; ++i)
@@ -224,15 +302,15 @@ std::string Buffer::readStr()
 }
 std::vector<unsigned char> Buffer::readArr(int size)
 {
-	if (readOffset + size > buffer.size())
+	if (readOffset + size > getSize())
 	{
 		return std::vector<unsigned char>();
 	}
 
-	unsigned long long oldReadOffset = readOffset;
+	const unsigned char* src = getData() + readOffset;
 	readOffset += size;
 
-	return std::vector<unsigned char>(buffer.begin() + oldReadOffset, buffer.begin() + oldReadOffset + size);
+	return std::vector<unsigned char>(src, src + size);
 }
 
 /*std::string Buffer::readStr()  {
@@ -302,5 +380,5 @@ Buffer::~Buffer() {
 	//{
 	//	printf("Buffer::~Buffer: unread data remained\n");
 	//}
-	clear();
+	CBufferPool::Release(buffer);
 }
\ No newline at end of file
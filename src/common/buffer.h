@@ -1,5 +1,6 @@
 #pragma once
 #include <vector>  // buffers
+#include <memory>  // shared views
 #include <sstream> // strings, byteStr()
 #include <iomanip>
 
@@ -7,9 +8,13 @@ class Buffer {
 public:
 	Buffer();
 	Buffer(const std::vector<unsigned char>&);
+	Buffer(const std::shared_ptr<std::vector<unsigned char>>& data, unsigned long long offset, unsigned long long size);
 
 	void setBuffer(std::vector<unsigned char>&);
 	const std::vector<unsigned char>& getBuffer() const;
+	const unsigned char* getData() const;
+	unsigned char* getWritableData();
+	unsigned long long getSize() const;
 	void clear();
 
 	std::string byteStr(bool LE = true) const;
@@ -84,7 +89,18 @@ public:
 
 	~Buffer();
 private:
-	std::vector<unsigned char> buffer;
+	void detach();
+	void reserve(unsigned long long size);
+	void write(const unsigned char* data, unsigned long long len);
+	void writeSlow(const unsigned char* data, unsigned long long len);
+
+	mutable std::vector<unsigned char> buffer;
+
+	// read-only view of shared memory (received packets), copied to buffer on first write or getBuffer() call
+	std::shared_ptr<std::vector<unsigned char>> view;
+	const unsigned char* viewData;
+	unsigned long long viewSize;
+
 	unsigned long long readOffset;
 	unsigned long long writeOffset;
 	bool overrideBuf;
@@ -0,0 +1,161 @@
+#include "bufferpool.h"
+#include "thread.h"
+
+using namespace std;
+
+static const size_t s_ClassSizes[BUFFER_POOL_CLASSES] = { 64, 512, 4096, 65536 };
+
+// number of free buffers kept by each thread and in the shared lists, per class
+static const size_t s_LocalMax[BUFFER_POOL_CLASSES] = { 256, 128, 64, 16 };
+static const size_t s_SharedMax[BUFFER_POOL_CLASSES] = { 4096, 2048, 512, 64 };
+
+struct SharedFreeLists_s
+{
+	CCriticalSection mutex;
+	vector<vector<unsigned char>> lists[BUFFER_POOL_CLASSES];
+};
+
+// never deleted, buffers of static objects are released after everything else has been destroyed
+static SharedFreeLists_s* GetSharedFreeLists()
+{
+	static SharedFreeLists_s* freeLists = new SharedFreeLists_s();
+	return freeLists;
+}
+
+struct LocalFreeLists_s
+{
+	~LocalFreeLists_s();
+
+	vector<vector<unsigned char>> lists[BUFFER_POOL_CLASSES];
+};
+
+static thread_local LocalFreeLists_s t_FreeLists;
+static thread_local bool t_bFreeListsDestroyed = false;
+
+/**
+ * Moves buffers of exiting thread to the shared lists
+ */
+LocalFreeLists_s::~LocalFreeLists_s()
+{
+	t_bFreeListsDestroyed = true;
+
+	SharedFreeLists_s* shared = GetSharedFreeLists();
+	shared->mutex.Enter();
+
+	for (int i = 0; i < BUFFER_POOL_CLASSES; i++)
+	{
+		for (auto& buf : lists[i])
+		{
+			if (shared->lists[i].size() >= s_SharedMax[i])
+				break;
+
+			shared->lists[i].push_back(move(buf));
+		}
+	}
+
+	shared->mutex.Leave();
+}
+
+/**
+ * Gets the smallest class that fits capacity
+ * @return Class index, -1 if capacity is too big
+ */
+static int GetSizeClass(size_t capacity)
+{
+	for (int i = 0; i < BUFFER_POOL_CLASSES; i++)
+	{
+		if (capacity <= s_ClassSizes[i])
+			return i;
+	}
+
+	return -1;
+}
+
+/**
+ * Gets empty buffer
+ * @param capacity Minimum capacity
+ * @return Buffer from the pool or a new one if there are no free buffers of the class
+ */
+vector<unsigned char> CBufferPool::Get(size_t capacity)
+{
+	vector<unsigned char> buf;
+
+	int sizeClass = GetSizeClass(capacity);
+	if (sizeClass < 0 || t_bFreeListsDestroyed)
+	{
+		buf.reserve(capacity);
+		return buf;
+	}
+
+	vector<vector<unsigned char>>& list = t_FreeLists.lists[sizeClass];
+	if (list.empty())
+	{
+		// take a batch released by other threads
+		SharedFreeLists_s* shared = GetSharedFreeLists();
+		shared->mutex.Enter();
+
+		vector<vector<unsigned char>>& sharedList = shared->lists[sizeClass];
+		for (int i = 0; i < BUFFER_POOL_BATCH && !sharedList.empty(); i++)
+		{
+			list.push_back(move(sharedList.back()));
+			sharedList.pop_back();
+		}
+
+		shared->mutex.Leave();
+	}
+
+	if (list.empty())
+	{
+		buf.reserve(s_ClassSizes[sizeClass]);
+		return buf;
+	}
+
+	buf.swap(list.back());
+	list.pop_back();
+
+	return buf;
+}
+
+/**
+ * Returns buffer storage to the pool. The buffer is left empty and without storage
+ * @param buf
+ */
+void CBufferPool::Release(vector<unsigned char>& buf)
+{
+	size_t capacity = buf.capacity();
+
+	// find the largest class the buffer can serve, too big buffers are freed to not keep too much memory
+	int sizeClass = -1;
+	for (int i = 0; i < BUFFER_POOL_CLASSES && capacity >= s_ClassSizes[i]; i++)
+		sizeClass = i;
+
+	if (sizeClass < 0 || capacity > s_ClassSizes[BUFFER_POOL_CLASSES - 1] * 2 || t_bFreeListsDestroyed)
+	{
+		vector<unsigned char>().swap(buf);
+		return;
+	}
+
+	buf.clear();
+
+	vector<vector<unsigned char>>& list = t_FreeLists.lists[sizeClass];
+	list.push_back(vector<unsigned char>());
+	list.back().swap(buf);
+
+	if (list.size() > s_LocalMax[sizeClass])
+	{
+		// give a batch to other threads
+		SharedFreeLists_s* shared = GetSharedFreeLists();
+		shared->mutex.Enter();
+
+		vector<vector<unsigned char>>& sharedList = shared->lists[sizeClass];
+		for (int i = 0; i < BUFFER_POOL_BATCH && !list.empty(); i++)
+		{
+			if (sharedList.size() < s_SharedMax[sizeClass])
+				sharedList.push_back(move(list.back()));
+
+			list.pop_back();
+		}
+
+		shared->mutex.Leave();
+	}
+}
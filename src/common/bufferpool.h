@@ -0,0 +1,20 @@
+#pragma once
+
+#include <vector>
+#include <cstddef>
+
+#define BUFFER_POOL_CLASSES 4 // 64 B, 512 B, 4 KB, 64 KB
+#define BUFFER_POOL_BATCH 16 // number of buffers moved between thread and shared free lists at once
+
+/**
+ * Pool of byte vectors used as Buffer storage. Vectors are grouped by capacity into size classes,
+ * every thread keeps its own free lists, so taking and returning a buffer doesn't lock anything.
+ * Packets are usually built by one thread and released by another (the I/O thread after sending),
+ * extra buffers are moved between thread and shared free lists in batches
+ */
+class CBufferPool
+{
+public:
+	static std::vector<unsigned char> Get(size_t capacity);
+	static void Release(std::vector<unsigned char>& buf);
+};
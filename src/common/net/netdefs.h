@@ -5,8 +5,20 @@
 #define PACKET_MAX_SIZE 0x10000
 #define PACKET_HEADER_SIZE 4 // without packet ID
 
+#define RECV_BUFFER_SIZE 0x4000 // initial size of per-connection receive buffer, grows to fit the largest packet
+#define RECV_BUFFER_MIN_FREE 0x400 // receive buffer is compacted when there is less free space
+
+#define SEND_BATCH_SIZE 64 // maximum number of buffers sent with one writev call
+
+#define TCP_SSL_HANDSHAKE_TIMEOUT 10 // seconds, clients that don't finish TLS handshake in time are disconnected
+
+#define PACKET_READ_INVALID -2 // CExtendedSocket::Read() result: packet is not valid, wrong sequence or decryption failed
+
 #define TCP_PACKET_SIGNATURE 'U'
 
+#define PACKET_ID_CRYPT 7 // output encryption starts after this packet
+#define PACKET_ID_RECVCRYPT 12 // input encryption starts after this packet
+
 // not sure about them
 #define UDP_HOLEPUNCH_PACKET_SIGNATURE_1 'W'
 #define UDP_HOLEPUNCH_PACKET_SIGNATURE_2 'X'
@@ -0,0 +1,161 @@
+#pragma once
+
+#include <vector>
+#include <unordered_map>
+#include <algorithm>
+
+#define PACKET_STATS_LATENCY_BUCKETS 24 // microseconds: 0, 1, 2-3, 4-7, ..., 4194304+
+#define PACKET_STATS_SIZE_BUCKETS 20 // bytes: 0, 1, 2-3, 4-7, ..., 262144+
+#define PACKET_STATS_NO_SUBTYPE -1
+
+/**
+ * Counters of one packet ID and sub type
+ */
+struct PacketStats_s
+{
+	int id;
+	int subType; // first payload byte or PACKET_STATS_NO_SUBTYPE
+	unsigned long long count;
+	unsigned long long bytes;
+	unsigned long long time; // microseconds spent in the handler
+	unsigned long long latency[PACKET_STATS_LATENCY_BUCKETS];
+	unsigned long long size[PACKET_STATS_SIZE_BUCKETS];
+};
+
+/**
+ * Per packet counters with log2 histograms of handler latency and packet size.
+ * Bucket 0 counts zero, bucket N counts 2^(N-1)..2^N-1, the last bucket counts everything above.
+ * Not thread safe, packets are handled on the event thread
+ */
+class CPacketStats
+{
+public:
+	/**
+	 * Counts handled packet
+	 * @param id Packet ID
+	 * @param subType First payload byte or PACKET_STATS_NO_SUBTYPE
+	 * @param bytes Packet length
+	 * @param time Microseconds spent in the handler
+	 */
+	void Add(int id, int subType, unsigned long long bytes, unsigned long long time)
+	{
+		auto it = m_Stats.find(Key(id, subType));
+		if (it == m_Stats.end())
+		{
+			PacketStats_s stats = {};
+			stats.id = id;
+			stats.subType = subType;
+			it = m_Stats.emplace(Key(id, subType), stats).first;
+		}
+
+		PacketStats_s& stats = it->second;
+		stats.count++;
+		stats.bytes += bytes;
+		stats.time += time;
+		stats.latency[GetBucket(time, PACKET_STATS_LATENCY_BUCKETS)]++;
+		stats.size[GetBucket(bytes, PACKET_STATS_SIZE_BUCKETS)]++;
+	}
+
+	/**
+	 * Gets counters of every seen packet ID and sub type
+	 * @return Counters sorted by the time spent in the handler, the most expensive first
+	 */
+	std::vector<PacketStats_s> GetStats()
+	{
+		std::vector<PacketStats_s> stats;
+		stats.reserve(m_Stats.size());
+		for (auto& it : m_Stats)
+			stats.push_back(it.second);
+
+		std::sort(stats.begin(), stats.end(), [](const PacketStats_s& a, const PacketStats_s& b) { return a.time > b.time; });
+
+		return stats;
+	}
+
+	/**
+	 * Gets counters of all packets summed up, id and subType are -1
+	 */
+	PacketStats_s GetTotal()
+	{
+		PacketStats_s total = {};
+		total.id = -1;
+		total.subType = PACKET_STATS_NO_SUBTYPE;
+
+		for (auto& it : m_Stats)
+		{
+			const PacketStats_s& stats = it.second;
+			total.count += stats.count;
+			total.bytes += stats.bytes;
+			total.time += stats.time;
+
+			for (int i = 0; i < PACKET_STATS_LATENCY_BUCKETS; i++)
+				total.latency[i] += stats.latency[i];
+
+			for (int i = 0; i < PACKET_STATS_SIZE_BUCKETS; i++)
+				total.size[i] += stats.size[i];
+		}
+
+		return total;
+	}
+
+	void Reset()
+	{
+		m_Stats.clear();
+	}
+
+	/**
+	 * Gets percentile from histogram
+	 * @param histogram Log2 histogram
+	 * @param buckets Number of buckets
+	 * @param percentile 0..100
+	 * @return Upper bound of the bucket that contains the percentile, lower bound for the last bucket
+	 */
+	static unsigned long long GetPercentile(const unsigned long long* histogram, int buckets, double percentile)
+	{
+		unsigned long long count = 0;
+		for (int i = 0; i < buckets; i++)
+			count += histogram[i];
+
+		if (!count)
+			return 0;
+
+		unsigned long long rank = (unsigned long long)(count * percentile / 100.0);
+		if (rank >= count)
+			rank = count - 1;
+
+		unsigned long long seen = 0;
+		for (int i = 0; i < buckets; i++)
+		{
+			seen += histogram[i];
+			if (seen > rank)
+			{
+				if (i == 0)
+					return 0;
+
+				return i == buckets - 1 ? 1ULL << (i - 1) : (1ULL << i) - 1;
+			}
+		}
+
+		return 0;
+	}
+
+private:
+	static int Key(int id, int subType)
+	{
+		return (id << 16) | (subType & 0xFFFF);
+	}
+
+	static int GetBucket(unsigned long long value, int buckets)
+	{
+		int bucket = 0;
+		while (value && bucket < buckets - 1)
+		{
+			value >>= 1;
+			bucket++;
+		}
+
+		return bucket;
+	}
+
+	std::unordered_map<int, PacketStats_s> m_Stats;
+};
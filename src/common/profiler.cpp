@@ -0,0 +1,172 @@
+#include "profiler.h"
+#include "logger.h"
+
+#include <algorithm>
+
+using namespace std;
+
+// innermost profiled call of the thread
+static thread_local ProfilerSite_s* s_pCurrentSite = NULL;
+// calls of the thread since the last sampled call
+static thread_local unsigned int s_nSampleCounter = 0;
+
+CProfiler::CProfiler(const string& name)
+{
+	m_Name = name;
+	m_bEnabled = true;
+	m_nSampleRate = PROFILER_DEFAULT_SAMPLE_RATE;
+	m_nSlowThreshold = PROFILER_DEFAULT_SLOW_THRESHOLD;
+}
+
+/**
+ * Adds profiled function. Sites are never removed, so the pointer stays valid
+ */
+ProfilerSite_s* CProfiler::AddSite(const string& name)
+{
+	lock_guard<mutex> lock(m_Mutex);
+
+	ProfilerSite_s* site = new ProfilerSite_s();
+	site->name = name;
+	site->calls = 0;
+	site->sampledCalls = 0;
+	site->time = 0;
+	site->maxTime = 0;
+	site->rows = 0;
+
+	m_Sites.emplace_back(site);
+
+	return site;
+}
+
+void CProfiler::SetEnabled(bool enabled)
+{
+	m_bEnabled = enabled;
+}
+
+bool CProfiler::IsEnabled()
+{
+	return m_bEnabled;
+}
+
+/**
+ * Sets how often calls are timed
+ * @param rate 1 times every call, N times every N-th call of a thread
+ */
+void CProfiler::SetSampleRate(int rate)
+{
+	m_nSampleRate = max(rate, 1);
+}
+
+int CProfiler::GetSampleRate()
+{
+	return m_nSampleRate;
+}
+
+/**
+ * Sets minimal duration of logged calls
+ * @param ms Milliseconds, 0 disables the log
+ */
+void CProfiler::SetSlowThreshold(int ms)
+{
+	m_nSlowThreshold = max(ms, 0);
+}
+
+int CProfiler::GetSlowThreshold()
+{
+	return m_nSlowThreshold;
+}
+
+/**
+ * Adds rows to the innermost profiled call of the current thread, does nothing outside of profiled calls
+ */
+void CProfiler::AddRows(int rows)
+{
+	if (s_pCurrentSite && rows > 0)
+		s_pCurrentSite->rows.fetch_add(rows, memory_order_relaxed);
+}
+
+void CProfiler::Reset()
+{
+	lock_guard<mutex> lock(m_Mutex);
+
+	for (auto& site : m_Sites)
+	{
+		site->calls = 0;
+		site->sampledCalls = 0;
+		site->time = 0;
+		site->maxTime = 0;
+		site->rows = 0;
+	}
+}
+
+/**
+ * Gets counters of called sites
+ * @return Counters sorted by the time spent, the most expensive first
+ */
+vector<ProfilerStats_s> CProfiler::GetStats()
+{
+	vector<ProfilerStats_s> stats;
+
+	{
+		lock_guard<mutex> lock(m_Mutex);
+
+		for (auto& site : m_Sites)
+		{
+			if (!site->calls)
+				continue;
+
+			stats.push_back({ site->name, site->calls, site->sampledCalls, site->time, site->maxTime, site->rows });
+		}
+	}
+
+	sort(stats.begin(), stats.end(), [](const ProfilerStats_s& a, const ProfilerStats_s& b) { return a.time > b.time; });
+
+	return stats;
+}
+
+CProfilerScope::CProfilerScope(CProfiler& profiler, ProfilerSite_s* site) : m_Profiler(profiler)
+{
+	m_pSite = NULL;
+	m_pPrevSite = NULL;
+	m_bSampled = false;
+
+	if (!profiler.m_bEnabled.load(memory_order_relaxed))
+		return;
+
+	m_pSite = site;
+	m_pSite->calls.fetch_add(1, memory_order_relaxed);
+
+	m_pPrevSite = s_pCurrentSite;
+	s_pCurrentSite = m_pSite;
+
+	if (++s_nSampleCounter >= (unsigned int)profiler.m_nSampleRate.load(memory_order_relaxed))
+	{
+		s_nSampleCounter = 0;
+		m_bSampled = true;
+		m_StartTime = chrono::steady_clock::now();
+	}
+}
+
+CProfilerScope::~CProfilerScope()
+{
+	if (!m_pSite)
+		return;
+
+	s_pCurrentSite = m_pPrevSite;
+
+	if (!m_bSampled)
+		return;
+
+	unsigned long long time = chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now() - m_StartTime).count();
+
+	m_pSite->sampledCalls.fetch_add(1, memory_order_relaxed);
+	m_pSite->time.fetch_add(time, memory_order_relaxed);
+
+	unsigned long long maxTime = m_pSite->maxTime.load(memory_order_relaxed);
+	while (time > maxTime && !m_pSite->maxTime.compare_exchange_weak(maxTime, time, memory_order_relaxed))
+		;
+
+	int slowThreshold = m_Profiler.m_nSlowThreshold.load(memory_order_relaxed);
+	if (slowThreshold && time >= (unsigned long long)slowThreshold * 1000)
+		Logger().Warn("%s: slow call %s: %llu ms\n", m_Profiler.m_Name.c_str(), m_pSite->name.c_str(), time / 1000);
+}
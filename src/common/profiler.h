@@ -0,0 +1,97 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+
+#define PROFILER_DEFAULT_SAMPLE_RATE 1 // time every call
+#define PROFILER_DEFAULT_SLOW_THRESHOLD 100 // ms, 0 disables slow call log
+
+/**
+ * Counters of one profiled function
+ */
+struct ProfilerSite_s
+{
+	std::string name;
+	std::atomic<unsigned long long> calls;
+	std::atomic<unsigned long long> sampledCalls; // calls that were timed
+	std::atomic<unsigned long long> time; // microseconds of sampled calls
+	std::atomic<unsigned long long> maxTime;
+	std::atomic<unsigned long long> rows;
+};
+
+struct ProfilerStats_s
+{
+	std::string name;
+	unsigned long long calls;
+	unsigned long long sampledCalls;
+	unsigned long long time;
+	unsigned long long maxTime;
+	unsigned long long rows;
+};
+
+/**
+ * Runtime profiler of function calls. Every profiled function gets a site with relaxed atomic counters, so the profiler
+ * can be called from any thread and stay enabled in production. Only every N-th call of a thread is timed (sample rate),
+ * the call count is exact. Sampled calls slower than the threshold are logged
+ */
+class CProfiler
+{
+public:
+	CProfiler(const std::string& name);
+
+	ProfilerSite_s* AddSite(const std::string& name);
+
+	void SetEnabled(bool enabled);
+	bool IsEnabled();
+	void SetSampleRate(int rate);
+	int GetSampleRate();
+	void SetSlowThreshold(int ms);
+	int GetSlowThreshold();
+
+	static void AddRows(int rows);
+
+	void Reset();
+	std::vector<ProfilerStats_s> GetStats();
+
+private:
+	friend class CProfilerScope;
+
+	std::string m_Name;
+
+	std::atomic<bool> m_bEnabled;
+	std::atomic<int> m_nSampleRate;
+	std::atomic<int> m_nSlowThreshold;
+
+	// protects the site list, counters are atomic
+	std::mutex m_Mutex;
+	std::vector<std::unique_ptr<ProfilerSite_s>> m_Sites;
+};
+
+/**
+ * Counts the call of the site while the object is alive. Rows added by CProfiler::AddRows go to the innermost scope of the thread
+ */
+class CProfilerScope
+{
+public:
+	CProfilerScope(CProfiler& profiler, ProfilerSite_s* site);
+	~CProfilerScope();
+
+	CProfilerScope(const CProfilerScope&) = delete;
+	CProfilerScope& operator=(const CProfilerScope&) = delete;
+
+private:
+	CProfiler& m_Profiler;
+	ProfilerSite_s* m_pSite; // NULL if the profiler is disabled
+	ProfilerSite_s* m_pPrevSite;
+	bool m_bSampled;
+	std::chrono::steady_clock::time_point m_StartTime;
+};
+
+// profiles the rest of the enclosing block, the site is added on the first call
+#define PROFILE_SCOPE(profiler, name) \
+	static ProfilerSite_s* profilerSite_ = (profiler).AddSite(name); \
+	CProfilerScope profilerScope_(profiler, profilerSite_)
@@ -71,6 +71,9 @@ void CThread::Join()
 #else
     if (pthread_join(m_ID, NULL) != 0)
         printf("CThread::Join: pthread_join != 0\n");
+
+    // joined thread can't be joined again
+    m_ID = 0;
 #endif
 }
 
@@ -0,0 +1,139 @@
+#pragma once
+
+#include <vector>
+#include <ctime>
+
+#define TIMER_WHEEL_BITS 6 // 64 slots per level
+#define TIMER_WHEEL_SLOTS (1 << TIMER_WHEEL_BITS)
+#define TIMER_WHEEL_LEVELS 4 // level 0 covers 64 ticks, level 3 covers 64^4 ticks (~31 years of minutes)
+
+/**
+ * Hierarchical timer wheel. Level 0 has a slot for every tick, every next level has 64 times wider slots.
+ * When level 0 wraps around, the next slot of level 1 is moved down, and so on, so scheduling is O(1)
+ * and advancing costs one slot per tick plus the timers that actually move or expire, no matter how many timers wait.
+ * Timers further than the last level wait in the overflow list.
+ * Timers can't be cancelled, owners check whether the timer is still valid when it expires
+ */
+template <typename T>
+class CTimerWheel
+{
+public:
+	CTimerWheel()
+	{
+		m_nCurrentTick = 0;
+		m_nCount = 0;
+	}
+
+	/**
+	 * Removes all timers and sets the current tick
+	 */
+	void Reset(time_t currentTick)
+	{
+		for (auto& level : m_Slots)
+		{
+			for (auto& slot : level)
+				slot.clear();
+		}
+
+		m_Overflow.clear();
+		m_nCurrentTick = currentTick;
+		m_nCount = 0;
+	}
+
+	/**
+	 * Adds timer
+	 * @param tick Tick when the timer expires, timers in the past expire on the next Advance call
+	 * @param value
+	 */
+	void Schedule(time_t tick, const T& value)
+	{
+		if (tick <= m_nCurrentTick)
+			tick = m_nCurrentTick + 1;
+
+		m_nCount++;
+		Insert(tick, value);
+	}
+
+	/**
+	 * Moves the wheel to the current tick
+	 * @param currentTick
+	 * @param expired Receives values of the timers with tick <= currentTick
+	 */
+	void Advance(time_t currentTick, std::vector<T>& expired)
+	{
+		while (m_nCurrentTick < currentTick)
+		{
+			m_nCurrentTick++;
+
+			// move timers of higher levels down when lower level wraps around
+			for (int level = 1; level < TIMER_WHEEL_LEVELS; level++)
+			{
+				if ((m_nCurrentTick >> (TIMER_WHEEL_BITS * (level - 1))) & (TIMER_WHEEL_SLOTS - 1))
+					break;
+
+				Cascade(m_Slots[level][(m_nCurrentTick >> (TIMER_WHEEL_BITS * level)) & (TIMER_WHEEL_SLOTS - 1)]);
+
+				// overflow timers come in range gradually, check them every time the last level moves
+				if (level == TIMER_WHEEL_LEVELS - 1)
+					Cascade(m_Overflow);
+			}
+
+			std::vector<Timer>& slot = m_Slots[0][m_nCurrentTick & (TIMER_WHEEL_SLOTS - 1)];
+			for (auto& timer : slot)
+				expired.push_back(timer.value);
+
+			m_nCount -= slot.size();
+			slot.clear();
+		}
+	}
+
+	/**
+	 * Gets number of waiting timers
+	 */
+	size_t Size()
+	{
+		return m_nCount;
+	}
+
+	time_t GetCurrentTick()
+	{
+		return m_nCurrentTick;
+	}
+
+private:
+	struct Timer
+	{
+		time_t tick;
+		T value;
+	};
+
+	// tick >= m_nCurrentTick, timers of the current tick are placed to the level 0 slot that is processed next
+	void Insert(time_t tick, const T& value)
+	{
+		time_t delta = tick - m_nCurrentTick;
+		for (int level = 0; level < TIMER_WHEEL_LEVELS; level++)
+		{
+			if (delta < ((time_t)1 << (TIMER_WHEEL_BITS * (level + 1))))
+			{
+				m_Slots[level][(tick >> (TIMER_WHEEL_BITS * level)) & (TIMER_WHEEL_SLOTS - 1)].push_back({ tick, value });
+				return;
+			}
+		}
+
+		m_Overflow.push_back({ tick, value });
+	}
+
+	void Cascade(std::vector<Timer>& timers)
+	{
+		std::vector<Timer> moved;
+		moved.swap(timers);
+
+		for (auto& timer : moved)
+			Insert(timer.tick, timer.value);
+	}
+
+	std::vector<Timer> m_Slots[TIMER_WHEEL_LEVELS][TIMER_WHEEL_SLOTS];
+	std::vector<Timer> m_Overflow;
+	time_t m_nCurrentTick; // last processed tick
+	size_t m_nCount;
+};
@@ -2,6 +2,15 @@
 
 #include "interface/ievent.h"
 #include "common/thread.h"
+#include "common/boundedqueue.h"
+
+#include <unordered_map>
+#include <deque>
+
+#define EVENT_QUEUE_SIZE 65536
+#define EVENT_POOL_SIZE 4096
+#define EVENT_BATCH_SIZE 256 // max events executed under one critical section enter
+#define EVENT_QUEUE_DEPTH_BUCKETS 18 // 0, 1, 2-3, 4-7, ..., 65536+
 
 /**
  * Representation of event as a function
@@ -9,7 +18,7 @@
 class CEvent_Function : public IEvent
 {
 public:
-	CEvent_Function(const std::function<void()>& func, EventFunctionType type = EventFunctionType::NotSpecified)
+	CEvent_Function(const std::function<void()>& func = nullptr, EventFunctionType type = EventFunctionType::NotSpecified)
 	{
 		m_Func = func;
 		m_Type = type;
@@ -25,6 +34,19 @@ public:
 		return m_Type;
 	}
 
+	void SetFunction(const std::function<void()>& func)
+	{
+		m_Func = func;
+	}
+
+	/**
+	 * Releases the function and objects bound to it, called when event returns to the pool
+	 */
+	virtual void Reset()
+	{
+		m_Func = nullptr;
+	}
+
 private:
 	EventFunctionType m_Type;
 	std::function<void()> m_Func;
@@ -39,7 +61,7 @@ class CReceiveMessage;
 class CEvent_TCPPacket : public CEvent_Function
 {
 public:
-	CEvent_TCPPacket(IExtendedSocket* socket, const std::function<void()>& func) : CEvent_Function(func, EventFunctionType::TCPPacket)
+	CEvent_TCPPacket(IExtendedSocket* socket = NULL, const std::function<void()>& func = nullptr) : CEvent_Function(func, EventFunctionType::TCPPacket)
 	{
 		m_pSocket = socket;
 	}
@@ -49,26 +71,94 @@ public:
 		return m_pSocket;
 	}
 
+	void SetSocket(IExtendedSocket* socket)
+	{
+		m_pSocket = socket;
+	}
+
+	virtual void Reset()
+	{
+		CEvent_Function::Reset();
+		m_pSocket = NULL;
+	}
+
 private:
 	IExtendedSocket* m_pSocket;
 };
 
 /**
- * Class that implements a queue of server events such as incoming message, second tick, console command
+ * Free list of preallocated event objects. Events are taken by producer threads and returned by the event thread
+ */
+template <typename T>
+class CEventPool
+{
+public:
+	CEventPool(size_t size) : m_FreeEvents(size)
+	{
+	}
+
+	~CEventPool()
+	{
+		T* ev;
+		while (m_FreeEvents.Pop(ev))
+			delete ev;
+	}
+
+	T* Get()
+	{
+		T* ev;
+		if (m_FreeEvents.Pop(ev))
+			return ev;
+
+		return new T();
+	}
+
+	void Release(T* ev)
+	{
+		ev->Reset();
+
+		if (!m_FreeEvents.Push(ev))
+			delete ev;
+	}
+
+private:
+	CBoundedQueue<T*> m_FreeEvents;
+};
+
+/**
+ * Class that implements a queue of server events such as incoming message, second tick, console command.
+ * The queue is a bounded lock-free ring, any thread can add events, only the event thread takes them.
+ * When the ring is full events go to an overflow list until the event thread drains it, producers never wait
+ * (a worker may hold a lock the event thread needs, and the event thread adds events itself).
  * To process events, use WaitForSignal() method which waits until event is added
  */
 class CEvents : public IEvents
 {
 public:
-	CEvents()
+	CEvents() : m_Queue(EVENT_QUEUE_SIZE), m_FunctionPool(EVENT_POOL_SIZE), m_TCPPacketPool(EVENT_POOL_SIZE)
 	{
-		m_pCurrentEvent = NULL;
+		m_CurrentEvent.ev = NULL;
+		m_CurrentEvent.pooled = false;
+		m_CurrentEvent.removed = false;
+		m_bWaiting = false;
+		m_nTombstones = 0;
+		m_nOverflow = 0;
+		m_nOverflowEvents = 0;
+
+		for (auto& bucket : m_QueueDepthHistogram)
+			bucket = 0;
 	}
 
 	~CEvents()
 	{
-		if (m_pCurrentEvent)
-			delete m_pCurrentEvent;
+		ReleaseEvent(m_CurrentEvent);
+
+		QueuedEvent_s queuedEvent;
+		while (m_Queue.Pop(queuedEvent))
+			ReleaseEvent(queuedEvent);
+
+		for (auto& overflowEvent : m_Overflow)
+			ReleaseEvent(overflowEvent);
 	}
 
 	/**
@@ -76,50 +166,53 @@ public:
 	 */
 	virtual void AddEvent(IEvent* ev)
 	{
-		m_Mutex.Enter();
-
-		if (m_Events.size() >= 50)
-			printf("m_Events.size() >= 50\n");
-
-		m_Events.push_back(ev);
-		m_Object.Signal();
-
-		m_Mutex.Leave();
+		PushEvent(ev, false);
 	}
 
 	virtual void AddEventFunction(const std::function<void()>& func)
 	{
-		CEvent_Function* ev = new CEvent_Function(func);
-		AddEvent(ev);
+		CEvent_Function* ev = m_FunctionPool.Get();
+		ev->SetFunction(func);
+		PushEvent(ev, true);
 	}
 
 	void AddEventTCPPacket(IExtendedSocket* socket, const std::function<void()>& func)
 	{
-		CEvent_TCPPacket* ev = new CEvent_TCPPacket(socket, func);
-		AddEvent(ev);
+		CEvent_TCPPacket* ev = m_TCPPacketPool.Get();
+		ev->SetSocket(socket);
+		ev->SetFunction(func);
+		PushEvent(ev, true);
 	}
 
 	/**
-	 * Removes all events associated with socket obj 
+	 * Removes all events associated with socket obj.
+	 * Events stay in the queue and are skipped by GetNextEvent(). No new events for the socket must be added after the call
 	 */
 	void RemoveEventsBySocket(IExtendedSocket* socket)
 	{
-		m_Events.erase(std::remove_if(m_Events.begin(), m_Events.end(),
-			[socket](IEvent* ev)
-			{
-				if (ev->GetType() == EventFunctionType::TCPPacket)
-				{
-					CEvent_TCPPacket* evPacket = static_cast<CEvent_TCPPacket*>(ev);
-					if (evPacket->GetSocket() == socket)
-					{
-						delete evPacket; /// @todo: use unique_ptr...
-						return true;
-					}
-				}
-
-				return false;
-			}
-		), m_Events.end());
+		// events of the socket that are already queued have lower positions
+		size_t pos = m_Queue.GetEnqueuePos();
+
+		m_TombstoneMutex.Enter();
+
+		m_Tombstones[socket] = pos;
+		m_nTombstones = m_Tombstones.size();
+
+		m_TombstoneMutex.Leave();
+
+		// overflow events have no ring position, mark them directly
+		if (!m_nOverflow)
+			return;
+
+		m_OverflowMutex.Enter();
+
+		for (auto& queuedEvent : m_Overflow)
+		{
+			if (queuedEvent.ev->GetType() == EventFunctionType::TCPPacket && static_cast<CEvent_TCPPacket*>(queuedEvent.ev)->GetSocket() == socket)
+				queuedEvent.removed = true;
+		}
+
+		m_OverflowMutex.Leave();
 	}
 
 	/**
@@ -127,30 +220,59 @@ public:
 	 */
 	IEvent* GetNextEvent()
 	{
-		if (m_pCurrentEvent)
+		ReleaseEvent(m_CurrentEvent);
+		m_CurrentEvent.ev = NULL;
+
+		QueuedEvent_s queuedEvent;
+		while (PopEvent(queuedEvent))
 		{
-			delete m_pCurrentEvent;
-			m_pCurrentEvent = NULL;
+			if (queuedEvent.removed)
+			{
+				ReleaseEvent(queuedEvent);
+				continue;
+			}
+
+			m_CurrentEvent = queuedEvent;
+			break;
 		}
 
-		m_Mutex.Enter();
-		if (!m_Events.empty())
+		return m_CurrentEvent.ev;
+	}
+
+	/**
+	 * Executes queued events including ones added by executed events
+	 * @param maxEvents Maximum number of events to execute
+	 * @return Number of executed events
+	 */
+	size_t ExecuteEvents(size_t maxEvents)
+	{
+		size_t count = 0;
+		while (count < maxEvents)
 		{
-			// get first event and remove it from vector
-			m_pCurrentEvent = m_Events.front();
-			m_Events.erase(m_Events.begin());
-		}
+			IEvent* ev = GetNextEvent();
+			if (!ev)
+				break;
 
-		m_Mutex.Leave();
+			ev->Execute();
+			count++;
+		}
 
-		return m_pCurrentEvent;
+		return count;
 	}
 
 	/**
-	 * Waits until event is added
+	 * Waits until event is added. Returns immediately if there are queued events
 	 */
 	void WaitForSignal()
 	{
+		// producers signal only if we are waiting
+		m_bWaiting = true;
+		if (!m_Queue.Empty() || m_nOverflow)
+		{
+			m_bWaiting = false;
+			return;
+		}
+
 		m_Object.WaitForSignal();
 	}
 
@@ -162,9 +284,165 @@ public:
 		m_Object.Signal();
 	}
 
+	/**
+	 * Gets number of events that were in the queue when an event was added.
+	 * Bucket 0 counts empty queue, bucket N counts 2^(N-1)..2^N-1 events, the last bucket counts everything above
+	 * @return Vector of EVENT_QUEUE_DEPTH_BUCKETS counters
+	 */
+	std::vector<unsigned long long> GetQueueDepthHistogram()
+	{
+		std::vector<unsigned long long> histogram;
+		for (auto& bucket : m_QueueDepthHistogram)
+			histogram.push_back(bucket);
+
+		return histogram;
+	}
+
+	/**
+	 * Gets number of events that didn't fit into the ring and were added to the overflow list
+	 */
+	unsigned long long GetOverflowEvents()
+	{
+		return m_nOverflowEvents;
+	}
+
 private:
-	std::vector<IEvent*> m_Events;
+	struct QueuedEvent_s
+	{
+		IEvent* ev;
+		bool pooled;
+		bool removed;
+	};
+
+	void PushEvent(IEvent* ev, bool pooled)
+	{
+		QueuedEvent_s queuedEvent;
+		queuedEvent.ev = ev;
+		queuedEvent.pooled = pooled;
+		queuedEvent.removed = false;
+
+		size_t depth = m_Queue.Size();
+		int bucket = 0;
+		while (depth && bucket < EVENT_QUEUE_DEPTH_BUCKETS - 1)
+		{
+			depth >>= 1;
+			bucket++;
+		}
+
+		m_QueueDepthHistogram[bucket].fetch_add(1, std::memory_order_relaxed);
+
+		// once events overflow, later events follow them until the event thread drains the list, so the order is kept
+		if (m_nOverflow || !m_Queue.Push(queuedEvent))
+		{
+			// the event thread is behind by EVENT_QUEUE_SIZE events
+			m_OverflowMutex.Enter();
+			m_Overflow.push_back(queuedEvent);
+			m_nOverflow = m_Overflow.size();
+			m_OverflowMutex.Leave();
+
+			m_nOverflowEvents.fetch_add(1, std::memory_order_relaxed);
+		}
+
+		if (m_bWaiting.exchange(false))
+			m_Object.Signal();
+	}
+
+	/**
+	 * Takes the next event from the ring, then from the overflow list.
+	 * Events in the ring were added before the overflowed ones or concurrently with them
+	 */
+	bool PopEvent(QueuedEvent_s& queuedEvent)
+	{
+		size_t pos;
+		if (m_Queue.Pop(queuedEvent, &pos))
+		{
+			queuedEvent.removed = IsRemoved(queuedEvent.ev, pos);
+			return true;
+		}
+
+		if (!m_nOverflow)
+			return false;
+
+		m_OverflowMutex.Enter();
+
+		bool popped = !m_Overflow.empty();
+		if (popped)
+		{
+			queuedEvent = m_Overflow.front();
+			m_Overflow.pop_front();
+			m_nOverflow = m_Overflow.size();
+		}
+
+		m_OverflowMutex.Leave();
+
+		return popped;
+	}
+
+	void ReleaseEvent(const QueuedEvent_s& queuedEvent)
+	{
+		if (!queuedEvent.ev)
+			return;
+
+		if (!queuedEvent.pooled)
+			delete queuedEvent.ev;
+		else if (queuedEvent.ev->GetType() == EventFunctionType::TCPPacket)
+			m_TCPPacketPool.Release(static_cast<CEvent_TCPPacket*>(queuedEvent.ev));
+		else
+			m_FunctionPool.Release(static_cast<CEvent_Function*>(queuedEvent.ev));
+	}
+
+	/**
+	 * Checks if event was queued before its socket was removed. Drops tombstones that are behind the queue position
+	 */
+	bool IsRemoved(IEvent* ev, size_t pos)
+	{
+		if (!m_nTombstones)
+			return false;
+
+		bool removed = false;
+
+		m_TombstoneMutex.Enter();
+
+		if (ev->GetType() == EventFunctionType::TCPPacket)
+		{
+			auto it = m_Tombstones.find(static_cast<CEvent_TCPPacket*>(ev)->GetSocket());
+			if (it != m_Tombstones.end() && pos < it->second)
+				removed = true;
+		}
+
+		for (auto it = m_Tombstones.begin(); it != m_Tombstones.end();)
+		{
+			if (pos + 1 >= it->second)
+				it = m_Tombstones.erase(it);
+			else
+				it++;
+		}
+
+		m_nTombstones = m_Tombstones.size();
+
+		m_TombstoneMutex.Leave();
+
+		return removed;
+	}
+
+	CBoundedQueue<QueuedEvent_s> m_Queue;
+	CEventPool<CEvent_Function> m_FunctionPool;
+	CEventPool<CEvent_TCPPacket> m_TCPPacketPool;
+	QueuedEvent_s m_CurrentEvent;
+
 	CObjectSync m_Object;
-	CCriticalSection m_Mutex;
-	IEvent* m_pCurrentEvent;
-};
\ No newline at end of file
+	std::atomic<bool> m_bWaiting;
+
+	// sockets removed by RemoveEventsBySocket() and the queue position at the removal time
+	CCriticalSection m_TombstoneMutex;
+	std::unordered_map<IExtendedSocket*, size_t> m_Tombstones;
+	std::atomic<size_t> m_nTombstones;
+
+	// events that didn't fit into the ring, in the order they were added
+	CCriticalSection m_OverflowMutex;
+	std::deque<QueuedEvent_s> m_Overflow;
+	std::atomic<size_t> m_nOverflow;
+	std::atomic<unsigned long long> m_nOverflowEvents;
+
+	std::atomic<unsigned long long> m_QueueDepthHistogram[EVENT_QUEUE_DEPTH_BUCKETS];
+};
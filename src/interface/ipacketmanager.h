@@ -22,11 +22,16 @@ class IPacketManager : public IBaseManager
 {
 public:
 	virtual CSendPacket* CreatePacket(IExtendedSocket* socket, int msgID) = 0;
+	virtual CSendPacket* CreateBroadcastPacket(int msgID) = 0;
+	virtual void SendBroadcastPacket(const std::vector<IExtendedSocket*>& sockets, CSendPacket* body) = 0;
 
 	virtual void SendUMsgNoticeMsgBoxToUuid(IExtendedSocket* socket, const std::string& text) = 0;
+	virtual void SendUMsgNoticeMsgBoxToUuid(const std::vector<IExtendedSocket*>& sockets, const std::string& text) = 0;
 	virtual void SendUMsgNoticeMessageInChat(IExtendedSocket* socket, const std::string& text) = 0;
+	virtual void SendUMsgNoticeMessageInChat(const std::vector<IExtendedSocket*>& sockets, const std::string& text) = 0;
 	virtual void SendUMsgSystemReply(IExtendedSocket* socket, int type, const std::string& msg, const std::vector<std::string>& additionalText = {}) = 0;
 	virtual void SendUMsgUserMessage(IExtendedSocket* socket, int type, const std::string& senderName, const std::string& text, int whisperType = 0) = 0;
+	virtual void SendUMsgUserMessage(const std::vector<IExtendedSocket*>& sockets, int type, const std::string& senderName, const std::string& text, int whisperType = 0) = 0;
 	virtual void SendUMsgNotice(IExtendedSocket* socket, const Notice_s& notice, bool unk = 1) = 0;
 	virtual void SendUMsgExpiryNotice(IExtendedSocket* socket, const std::vector<int>& expiryItems) = 0;
 	virtual void SendUMsgRewardNotice(IExtendedSocket* socket, const RewardNotice& reward, std::string title = "", std::string description = "", bool localized = false, bool inGame = false, bool scen = false) = 0;
@@ -45,6 +50,7 @@ public:
 
 	virtual void SendUserStart(IExtendedSocket* socket, int userID, const std::string& userName, const std::string& gameName, bool firstConnect) = 0;
 	virtual void SendUserUpdateInfo(IExtendedSocket* socket, IUser* user, const CUserCharacter& character) = 0;
+	virtual void SendUserUpdateInfo(const std::vector<IExtendedSocket*>& sockets, IUser* user, const CUserCharacter& character) = 0;
 	virtual void SendUserSurvey(IExtendedSocket* socket, const Survey& survey) = 0;
 	virtual void SendUserSurveyReply(IExtendedSocket* socket, int result) = 0;
 
@@ -114,12 +120,18 @@ public:
 
 	virtual void SendLobbyJoin(IExtendedSocket* socket, CChannel* channel) = 0;
 	virtual void SendLobbyUserJoin(IExtendedSocket* socket, IUser* joinedUser) = 0;
+	virtual void SendLobbyUserJoin(const std::vector<IExtendedSocket*>& sockets, IUser* joinedUser) = 0;
 	virtual void SendLobbyUserLeft(IExtendedSocket* socket, IUser* user) = 0;
+	virtual void SendLobbyUserLeft(const std::vector<IExtendedSocket*>& sockets, int userID) = 0;
 
 	virtual void SendRoomListFull(IExtendedSocket* socket, const std::vector<IRoom*>& rooms) = 0;
+	virtual void SendRoomListFull(const std::vector<IExtendedSocket*>& sockets, const std::vector<IRoom*>& rooms) = 0;
 	virtual void SendRoomListAdd(IExtendedSocket* socket, IRoom* room) = 0;
-	virtual void SendRoomListUpdate(IExtendedSocket* socket, IRoom* room) = 0;
+	virtual void SendRoomListAdd(const std::vector<IExtendedSocket*>& sockets, IRoom* room) = 0;
+	virtual void SendRoomListUpdate(IExtendedSocket* socket, IRoom* room, int lFlag = RLFLAG_ALL, int hFlag = RLHFLAG_ALL) = 0;
+	virtual void SendRoomListUpdate(const std::vector<IExtendedSocket*>& sockets, IRoom* room, int lFlag, int hFlag) = 0;
 	virtual void SendRoomListRemove(IExtendedSocket* socket, int roomID) = 0;
+	virtual void SendRoomListRemove(const std::vector<IExtendedSocket*>& sockets, int roomID) = 0;
 
 	virtual void SendShopUpdate(IExtendedSocket* socket, const std::vector<Product>& products) = 0;
 	virtual void SendShopBuyProductReply(IExtendedSocket* socket, int replyCode) = 0;
@@ -132,10 +144,13 @@ public:
 	virtual void SendRoomCreateAndJoin(IExtendedSocket* socket, IRoom* roomInfo) = 0;
 	virtual void SendRoomPlayerJoin(IExtendedSocket* socket, IUser* user, RoomTeamNum num) = 0;
 	virtual void SendRoomUpdateSettings(IExtendedSocket* socket, CRoomSettings* newSettings, int low = 0, int lowMid = 0, int highMid = 0, int high = 0) = 0;
+	virtual void SendRoomUpdateSettings(const std::vector<IExtendedSocket*>& sockets, CRoomSettings* newSettings, int low = 0, int lowMid = 0, int highMid = 0, int high = 0) = 0;
 	virtual void SendRoomSetUserTeam(IExtendedSocket* socket, IUser* user, int teamNum) = 0;
 	virtual void SendRoomSetPlayerReady(IExtendedSocket* socket, IUser* user, RoomReadyStatus readyStatus) = 0;
 	virtual void SendRoomSetHost(IExtendedSocket* socket, IUser* user) = 0;
+	virtual void SendRoomSetHost(const std::vector<IExtendedSocket*>& sockets, IUser* user) = 0;
 	virtual void SendRoomPlayerLeave(IExtendedSocket* socket, int userId) = 0;
+	virtual void SendRoomPlayerLeave(const std::vector<IExtendedSocket*>& sockets, int userId) = 0;
 	virtual void SendRoomPlayerLeaveIngame(IExtendedSocket* socket) = 0;
 	virtual void SendRoomInviteUserList(IExtendedSocket* socket, IUser* user) = 0;
 	virtual void SendRoomGameResult(IExtendedSocket* socket, IRoom* room, CGameMatch* match) = 0;
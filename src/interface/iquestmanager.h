@@ -43,6 +43,7 @@ public:
 	virtual void OnMatchEndEvent(CGameMatchUserStat* userStat, CGameMatch* gameMatch, int userTeam) = 0;
 	virtual void OnGameMatchLeave(IUser* user, std::vector<UserQuestProgress>& questProgress, std::vector<UserQuestProgress>& questsEventsProgress) = 0;
 	virtual void OnUserLogin(IUser* user) = 0;
+	virtual void OnQuestsReset(const std::vector<int>& userIDs) = 0;
 
 	virtual void OnQuestTaskFinished(IUser* user, UserQuestTaskProgress& taskProgress, CQuestTask* task, CQuest* quest) = 0;
 	virtual void OnQuestEventTaskFinished(IUser* user, UserQuestTaskProgress& taskProgress, CQuestEventTask* task, CQuestEvent* quest) = 0;
@@ -15,6 +15,7 @@ public:
 
 	virtual void OnShopPacket(CReceivePacket* msg, IExtendedSocket* socket) = 0;
 	virtual void GetProductBySubId(int productId, Product& product, SubProduct& subProduct) = 0;
+	virtual void RequestBuyProduct(IUser* user, int productTypeId, int productId) = 0;
 	virtual bool BuyProduct(IUser* user, int productTypeId, int productId) = 0;
 	
 	virtual const std::vector<Product>& GetProducts() = 0;
@@ -13,6 +13,7 @@ class CChannelServer;
 class CUserData;
 class CUserCharacter;
 class CUserCharacterExtended;
+struct UserCache_s;
 
 struct UserData
 {
@@ -50,6 +51,12 @@ public:
 	virtual CUserData GetUser(int flag) = 0;
 	virtual CUserCharacter GetCharacter(int lowFlag, int highFlag = 0) = 0;
 	virtual CUserCharacterExtended GetCharacterExtended(int flag) = 0;
+	virtual std::vector<std::string> GetBanList() = 0;
+	virtual bool IsBlocking(const std::string& gameName, int setting) = 0;
+
+	virtual void UpdateUser(CUserData& data) = 0;
+	virtual int UpdateCharacter(CUserCharacter& character) = 0;
+	virtual int UpdateCharacterExtended(CUserCharacterExtended& character) = 0;
 
 	virtual int UpdateHolepunch(int portId, const std::string& localIpAddress, int localPort, int externalPort) = 0;
 	virtual void UpdateClientUserInfo(CUserCharacter character) = 0;
@@ -81,4 +88,11 @@ public:
 
 	virtual bool IsCharacterExists() = 0;
 	virtual bool CreateCharacter(const std::string& gameName) = 0;
+
+	virtual bool LoadCache() = 0;
+	virtual bool IsCacheLoaded() = 0;
+	virtual void ApplyCache(const UserCache_s& cache) = 0;
+	virtual int FlushCache() = 0;
+	virtual void OnCacheFlushed(bool committed) = 0;
+	virtual void InvalidateCache() = 0;
 };
\ No newline at end of file
@@ -14,7 +14,8 @@ class CUserFastBuy;
 class IUserDatabase : public IBaseManager
 {
 public:
-	virtual int Login(const std::string& userName, const std::string& password, IExtendedSocket* socket, UserBan& ban, UserRestoreData* restoreData) = 0;
+	virtual int Login(const std::string& userName, const std::string& password, UserBan& ban, UserRestoreData* restoreData) = 0;
+	virtual int CreateSession(int userID, const std::string& ip, const std::vector<unsigned char>& hwid) = 0;
 	virtual int AddToRestoreList(int userID, int channelServerID, int channelID) = 0;
 	virtual int Register(const std::string& userName, const std::string& password, const std::string& ip) = 0;
 	virtual int GetUserSessions(std::vector<UserSession>& sessions) = 0;
@@ -34,6 +35,11 @@ public:
 	virtual int GetFirstExtendableItemByItemID(int userID, int itemID, CUserInventoryItem& item) = 0;
 	virtual int GetInventoryItemsCount(int userID) = 0;
 	virtual int IsInventoryFull(int userID) = 0;
+	virtual int ReadInventory(int userID, std::vector<CUserInventoryItem>& items, int& nextSlot, unsigned int& version) = 0;
+	virtual int CacheInventory(int userID, const std::vector<CUserInventoryItem>& items, int nextSlot, unsigned int version) = 0;
+	virtual int FlushInventory(int userID) = 0;
+	virtual void OnInventoryFlushed(int userID, bool committed) = 0;
+	virtual void UnloadInventory(int userID) = 0;
 	virtual int GetUserData(int userID, CUserData& data) = 0;
 	virtual int UpdateUserData(int userID, CUserData data) = 0;
 	virtual int CreateCharacter(int userID, const std::string& gameName) = 0;
@@ -125,7 +131,7 @@ public:
 	virtual int ClanRejectAll(int userID) = 0;
 	virtual int ClanApprove(int userID, const std::string& userName) = 0;
 	virtual int IsClanWithMarkExists(int markID) = 0;
-	virtual int ClanInvite(int userID, const std::string& gameName, IUser*& destUser, int& clanID) = 0;
+	virtual int ClanInvite(int userID, int destUserID, int& clanID) = 0;
 	virtual int ClanKick(int userID, const std::string& userName) = 0;
 	virtual int ClanMasterDelegate(int userID, const std::string& userName) = 0;
 	virtual int IsClanExists(const std::string& clanName) = 0;
@@ -161,6 +167,13 @@ public:
 
 	virtual void ResetQuestEvent(int questID) = 0;
 
+	virtual void RecordStatements(bool record) = 0;
+	virtual int AuditQueryPlans() = 0;
+	virtual void PrintStatementStats(int count) = 0;
+
+	virtual void StartBackup() = 0;
+	virtual void PrintBackupList() = 0;
+
 	virtual void CreateTransaction() = 0;
 	virtual bool CommitTransaction() = 0;
 };
\ No newline at end of file
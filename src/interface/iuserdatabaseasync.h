@@ -0,0 +1,12 @@
+#pragma once
+
+#include "imanager.h"
+
+#include <functional>
+
+class IUserDatabaseAsync : public IBaseManager
+{
+public:
+	virtual void AddJob(const std::function<void()>& job) = 0;
+	virtual bool IsDatabaseThread() = 0;
+};
@@ -5,8 +5,10 @@
 
 #include <string>
 #include <vector>
+#include <functional>
 
 class CUserInventoryItem;
+struct ClanUser;
 class CReceivePacket;
 class IExtendedSocket;
 class IUser;
@@ -37,7 +39,7 @@ public:
 	virtual void SendNoticeMessageToAll(const std::string& msg) = 0;
 	virtual void SendNoticeMsgBoxToAll(const std::string& msg) = 0;
 
-	virtual int LoginUser(IExtendedSocket* socket, const std::string& userName, const std::string& password) = 0;
+	virtual void LoginUser(IExtendedSocket* socket, const std::string& userName, const std::string& password, const std::function<void(IExtendedSocket*, int)>& onResult) = 0;
 	virtual int RegisterUser(IExtendedSocket* socket, const std::string& userName, const std::string& password) = 0;
 	virtual void DisconnectUser(IUser* user) = 0;
 	virtual void DisconnectAllFromServer() = 0;
@@ -46,12 +48,14 @@ public:
 	virtual IUser* GetUserBySocket(IExtendedSocket* socket) = 0;
 	virtual IUser* GetUserByUsername(const std::string& userName) = 0;
 	virtual IUser* GetUserByNickname(const std::string& nickname) = 0;
+	virtual void FindClanUsers(std::vector<ClanUser>& clanUsers) = 0;
 	virtual void RemoveUser(IUser* user) = 0;
 	virtual void RemoveUserById(int userID) = 0;
 	virtual void RemoveUserBySocket(IExtendedSocket* socket) = 0;
 	virtual void CleanUpUser(IUser* user) = 0;
 
-	virtual std::vector<IUser*> GetUsers() = 0;
+	virtual const std::vector<IUser*>& GetUsers() = 0;
+	virtual void FlushUserCache() = 0;
 
 	virtual int ChangeUserNickname(IUser* user, const std::string& newNickname, bool createCharacter = false) = 0;
 
@@ -10,10 +10,13 @@ typedef int SOCKET;
 
 #include <string>
 #include <vector>
+#include <deque>
 
 struct GuestData_s;
 class CSendPacket;
 class CReceivePacket;
+class IUser;
+class CDedicatedServer;
 
 class IExtendedSocket
 {
@@ -36,15 +39,19 @@ public:
 	virtual void ResetSeq() = 0;
 	virtual CReceivePacket* Read() = 0;
 	virtual int Send(std::vector<unsigned char>& buffer, bool serverHelloMsg = false) = 0;
-	virtual int Send(CSendPacket* msg, bool forceSend = false) = 0;
+	virtual int Send(CSendPacket* msg) = 0;
 
 	virtual unsigned int GetID() = 0;
 	virtual SOCKET GetSocket() = 0;
-	virtual void SetMsg(CReceivePacket* msg) = 0;
-	virtual CReceivePacket* GetMsg() = 0;
 	virtual int GetReadResult() = 0;
 	virtual int GetBytesReceived() = 0;
 	virtual int GetBytesSent() = 0;
-	virtual std::vector<CSendPacket*>& GetPacketsToSend() = 0;
+	virtual std::deque<CSendPacket*>& GetPacketsToSend() = 0;
 	virtual GuestData_s& GetGuestData() = 0;
+
+	// session of the connection, set by the user and dedicated server managers
+	virtual IUser* GetUser() = 0;
+	virtual void SetUser(IUser* user) = 0;
+	virtual CDedicatedServer* GetServer() = 0;
+	virtual void SetServer(CDedicatedServer* server) = 0;
 };
@@ -0,0 +1,166 @@
+#include "itemattributetable.h"
+#include "csvtable.h"
+#include "common/logger.h"
+
+#include <algorithm>
+#include <stdlib.h>
+
+using namespace std;
+
+// item IDs above are rejected, the table is dense
+#define ITEM_ATTRIBUTE_MAX_ITEMID 100000
+
+const string CItemAttributeTable::s_EmptyString;
+
+CItemAttributeTable::CItemAttributeTable()
+{
+	m_nItemCount = 0;
+}
+
+/**
+ * Gets column index by name
+ * @return Column index or -1 if the column doesn't exist
+ */
+static int FindColumn(const vector<string>& columns, const string& name)
+{
+	auto it = find(columns.begin(), columns.end(), name);
+	if (it == columns.end())
+	{
+		Logger().Warn("CItemAttributeTable::Load: Item.csv has no %s column, using default value\n", name.c_str());
+		return -1;
+	}
+
+	return (int)(it - columns.begin());
+}
+
+/**
+ * Compiles Item.csv rows into the table, called once per load so the lookups don't touch the CSV anymore
+ * @return false if the table has invalid item IDs
+ */
+bool CItemAttributeTable::Load(CCSVTable* table)
+{
+	vector<string> rows = table->GetRowNames();
+	vector<string> columns = table->GetColumnNames();
+
+	vector<int> itemIDs(rows.size(), -1);
+	int maxItemID = -1;
+	for (size_t i = 0; i < rows.size(); i++)
+	{
+		char* end = NULL;
+		long itemID = strtol(rows[i].c_str(), &end, 10);
+		if (rows[i].empty() || *end || itemID < 0 || itemID > ITEM_ATTRIBUTE_MAX_ITEMID)
+		{
+			Logger().Error("CItemAttributeTable::Load: invalid item ID '%s' in Item.csv\n", rows[i].c_str());
+			return false;
+		}
+
+		itemIDs[i] = itemID;
+		maxItemID = max(maxItemID, (int)itemID);
+	}
+
+	int category = FindColumn(columns, "Category");
+	int useType = FindColumn(columns, "UseType");
+	int zombieSkin = FindColumn(columns, "ZombieSkin");
+	int rewardID = FindColumn(columns, "rewardID");
+	int itemGrade = FindColumn(columns, "ItemGrade");
+	int inGameItem = FindColumn(columns, "InGameItem");
+	int name = FindColumn(columns, "Name");
+	int className = FindColumn(columns, "ClassName");
+	int resourceName = FindColumn(columns, "recourcename");
+
+	size_t size = maxItemID + 1;
+	m_Exists.assign(size, 0);
+	m_Category.assign(size, 0);
+	m_UseType.assign(size, 0);
+	m_ZombieSkin.assign(size, 0);
+	m_RewardID.assign(size, 0);
+	m_ItemGrade.assign(size, 0);
+	m_InGameItem.assign(size, 0);
+	m_Name.assign(size, string());
+	m_ClassName.assign(size, string());
+	m_ResourceName.assign(size, string());
+
+	for (size_t i = 0; i < rows.size(); i++)
+	{
+		int itemID = itemIDs[i];
+		m_Exists[itemID] = 1;
+
+		if (category >= 0)
+			m_Category[itemID] = table->GetCell<int>((size_t)category, i);
+		if (useType >= 0)
+			m_UseType[itemID] = table->GetCell<int>((size_t)useType, i);
+		if (zombieSkin >= 0)
+			m_ZombieSkin[itemID] = table->GetCell<int>((size_t)zombieSkin, i);
+		if (rewardID >= 0)
+			m_RewardID[itemID] = table->GetCell<int>((size_t)rewardID, i);
+		if (itemGrade >= 0)
+			m_ItemGrade[itemID] = table->GetCell<int>((size_t)itemGrade, i);
+		if (inGameItem >= 0)
+			m_InGameItem[itemID] = table->GetCell<int>((size_t)inGameItem, i) != 0;
+		if (name >= 0)
+			m_Name[itemID] = table->GetCell<string>((size_t)name, i);
+		if (className >= 0)
+			m_ClassName[itemID] = table->GetCell<string>((size_t)className, i);
+		if (resourceName >= 0)
+			m_ResourceName[itemID] = table->GetCell<string>((size_t)resourceName, i);
+	}
+
+	m_nItemCount = (int)rows.size();
+
+	return true;
+}
+
+bool CItemAttributeTable::IsExists(int itemID) const
+{
+	return IsValid(itemID);
+}
+
+int CItemAttributeTable::GetCategory(int itemID) const
+{
+	return IsValid(itemID) ? m_Category[itemID] : 0;
+}
+
+int CItemAttributeTable::GetUseType(int itemID) const
+{
+	return IsValid(itemID) ? m_UseType[itemID] : 0;
+}
+
+int CItemAttributeTable::GetZombieSkin(int itemID) const
+{
+	return IsValid(itemID) ? m_ZombieSkin[itemID] : 0;
+}
+
+int CItemAttributeTable::GetRewardID(int itemID) const
+{
+	return IsValid(itemID) ? m_RewardID[itemID] : 0;
+}
+
+int CItemAttributeTable::GetItemGrade(int itemID) const
+{
+	return IsValid(itemID) ? m_ItemGrade[itemID] : 0;
+}
+
+bool CItemAttributeTable::IsInGameItem(int itemID) const
+{
+	return IsValid(itemID) && m_InGameItem[itemID];
+}
+
+const string& CItemAttributeTable::GetName(int itemID) const
+{
+	return IsValid(itemID) ? m_Name[itemID] : s_EmptyString;
+}
+
+const string& CItemAttributeTable::GetClassName(int itemID) const
+{
+	return IsValid(itemID) ? m_ClassName[itemID] : s_EmptyString;
+}
+
+const string& CItemAttributeTable::GetResourceName(int itemID) const
+{
+	return IsValid(itemID) ? m_ResourceName[itemID] : s_EmptyString;
+}
+
+int CItemAttributeTable::GetItemCount() const
+{
+	return m_nItemCount;
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+class CCSVTable;
+
+/**
+ * Item.csv columns used by item grants and usage, compiled into arrays indexed by item ID.
+ * Accessors don't format or parse strings, unknown item IDs return 0 or empty string
+ */
+class CItemAttributeTable
+{
+public:
+	CItemAttributeTable();
+
+	bool Load(CCSVTable* table);
+
+	bool IsExists(int itemID) const;
+	int GetCategory(int itemID) const;
+	int GetUseType(int itemID) const;
+	int GetZombieSkin(int itemID) const;
+	int GetRewardID(int itemID) const;
+	int GetItemGrade(int itemID) const;
+	bool IsInGameItem(int itemID) const;
+	const std::string& GetName(int itemID) const;
+	const std::string& GetClassName(int itemID) const;
+	const std::string& GetResourceName(int itemID) const;
+
+	int GetItemCount() const;
+
+private:
+	bool IsValid(int itemID) const
+	{
+		return itemID >= 0 && itemID < (int)m_Exists.size() && m_Exists[itemID];
+	}
+
+	int m_nItemCount;
+
+	std::vector<char> m_Exists;
+	std::vector<int> m_Category;
+	std::vector<int> m_UseType;
+	std::vector<int> m_ZombieSkin;
+	std::vector<int> m_RewardID;
+	std::vector<int> m_ItemGrade;
+	std::vector<char> m_InGameItem;
+	std::vector<std::string> m_Name;
+	std::vector<std::string> m_ClassName;
+	std::vector<std::string> m_ResourceName;
+
+	static const std::string s_EmptyString;
+};
@@ -21,7 +21,7 @@ using namespace std;
 CChannelManager g_ChannelManager;
 
 // TODO: Should we implement multi channels?
-CChannelManager::CChannelManager() : CBaseManager("ChannelManager")
+CChannelManager::CChannelManager() : CBaseManager("ChannelManager", true)
 {
 }
 
@@ -50,6 +50,21 @@ void CChannelManager::Shutdown()
 	}
 }
 
+/**
+ * Sends room list and presence changes of every channel, so a lobby gets at most one update per room or user and second
+ */
+void CChannelManager::OnSecondTick(time_t curTime)
+{
+	for (auto& cs : channelServers)
+	{
+		for (auto& c : cs->GetChannels())
+		{
+			c->FlushRoomListUpdates();
+			c->FlushPresenceUpdates();
+		}
+	}
+}
+
 bool CChannelManager::OnChannelListPacket(IExtendedSocket* socket)
 {
 	LOG_PACKET;
@@ -285,7 +300,7 @@ bool CChannelManager::OnWhisperMessage(CReceivePacket* msg, IUser* userSender)
 	{
 		CUserCharacterExtended characterExtendedSender = userSender->GetCharacterExtended(EXT_UFLAG_BANSETTINGS);
 
-		if (characterExtendedSender.banSettings & 4)
+		if (characterExtendedSender.banSettings & BANSETTINGS_WHISPERALL)
 		{
 			// you can't send whisper message if you're blocking all whisper
 			g_PacketManager.SendUMsgSystemReply(socket, UMsgPacketType::SystemReply_Red, "MSG_TELL_SENDER_USING_BAN_CHAT_ALL");
@@ -294,13 +309,13 @@ bool CChannelManager::OnWhisperMessage(CReceivePacket* msg, IUser* userSender)
 		{
 			CUserCharacterExtended characterExtendedDest = userDest->GetCharacterExtended(EXT_UFLAG_BANSETTINGS);
 
-			if (characterExtendedDest.banSettings & 4)
+			if (characterExtendedDest.banSettings & BANSETTINGS_WHISPERALL)
 			{
 				// you can't send whisper message if dest is blocking all whisper
 				g_PacketManager.SendUMsgSystemReply(socket, UMsgPacketType::SystemReply_Red, "MSG_TELL_LISTENER_USING_BAN_CHAT_ALL");
 			}
 			// you can't send whisper message if you're blocking the dest's chat/whisper
-			else if (~characterExtendedSender.banSettings & 2 || characterExtendedSender.banSettings & 2 && !g_UserDatabase.IsInBanList(userSender->GetID(), userDest->GetID()))
+			else if (!userSender->IsBlocking(userDest->GetCharacter(UFLAG_LOW_GAMENAME).gameName, BANSETTINGS_CHAT))
 			{
 				g_PacketManager.SendUMsgUserMessage(socket, UMsgPacketType::WhisperUserMessage, userNameDest, message, UMsgWhisperType::To);
 				CUserCharacter character = userSender->GetCharacter(UFLAG_LOW_GAMENAME);
@@ -386,22 +401,24 @@ bool CChannelManager::OnCommandHandler(IExtendedSocket* socket, IUser* user, con
 				string login = args[1];
 				string password = args[2];
 
-				int loginResult = g_UserManager.LoginUser(socket, login, password);
-				switch (loginResult)
+				g_UserManager.LoginUser(socket, login, password, [](IExtendedSocket* socket, int loginResult)
 				{
-				case LOGIN_DB_ERROR:
-					g_PacketManager.SendUMsgNoticeMsgBoxToUuid(socket, OBFUSCATE("DB_QUERY_FAILED"));
-					break;
-				case LOGIN_NO_SUCH_USER:
-					g_PacketManager.SendUMsgNoticeMsgBoxToUuid(socket, OBFUSCATE("Wrong password or username."));
-					break;
-				case LOGIN_USER_BANNED:
-					g_pServerInstance->DisconnectClient(socket);
-					break;
-				case LOGIN_SERVER_CANNOT_VALIDATE_CLIENT:
-					g_PacketManager.SendUMsgNoticeMsgBoxToUuid(socket, OBFUSCATE("Failed to validate client. Contact administrator and try to reinstall the game."));
-					break;
-				}
+					switch (loginResult)
+					{
+					case LOGIN_DB_ERROR:
+						g_PacketManager.SendUMsgNoticeMsgBoxToUuid(socket, OBFUSCATE("DB_QUERY_FAILED"));
+						break;
+					case LOGIN_NO_SUCH_USER:
+						g_PacketManager.SendUMsgNoticeMsgBoxToUuid(socket, OBFUSCATE("Wrong password or username."));
+						break;
+					case LOGIN_USER_BANNED:
+						g_pServerInstance->DisconnectClient(socket);
+						break;
+					case LOGIN_SERVER_CANNOT_VALIDATE_CLIENT:
+						g_PacketManager.SendUMsgNoticeMsgBoxToUuid(socket, OBFUSCATE("Failed to validate client. Contact administrator and try to reinstall the game."));
+						break;
+					}
+				});
 			}
 			else
 			{
@@ -1259,6 +1276,8 @@ bool CChannelManager::OnNewRoomRequest(CReceivePacket* msg, IUser* user)
 			return false;
 		}
 
+		g_UserManager.FindClanUsers(userList);
+
 		for (auto clanUser : userList)
 		{
 			if (clanUser.user)
@@ -1313,8 +1332,7 @@ bool CChannelManager::OnJoinRoomRequest(CReceivePacket* msg, IUser* user)
 		}
 	}
 
-	CUserCharacterExtended hostCharacterExtended = room->GetHostUser()->GetCharacterExtended(EXT_UFLAG_BANSETTINGS);
-	if (hostCharacterExtended.banSettings & 1 && g_UserDatabase.IsInBanList(room->GetHostUser()->GetID(), user->GetID()))
+	if (room->GetHostUser()->IsBlocking(user->GetCharacter(UFLAG_LOW_GAMENAME).gameName, BANSETTINGS_ROOMJOIN))
 	{
 		g_PacketManager.SendUMsgNoticeMsgBoxToUuid(user->GetExtendedSocket(), OBFUSCATE("ROOM_JOIN_FAILED_BAN"));
 		return false;
@@ -1397,8 +1415,6 @@ bool CChannelManager::OnJoinRoomRequest(CReceivePacket* msg, IUser* user)
 	// hide user from channel users list
 	channel->UserLeft(user, true);
 
-	channel->SendUpdateRoomList(room);
-
 	Logger().Info("User '%s' joined a room (RID: %d)\n", user->GetLogName(), room->GetID());
 
 	return true;
@@ -1798,7 +1814,7 @@ bool CChannelManager::OnRoomUpdateSettings(CReceivePacket* msg, IUser* user)
 		currentRoom->SendUpdateRoomSettings(u, roomSettings, newSettings.lowFlag, newSettings.lowMidFlag, newSettings.highMidFlag, newSettings.highFlag);
 	}
 
-	currentChannel->SendUpdateRoomList(currentRoom);
+	currentChannel->SendUpdateRoomListSettings(currentRoom, newSettings.lowFlag, newSettings.lowMidFlag, newSettings.highMidFlag, newSettings.highFlag);
 
 	Logger().Info("Host '%s' updated room settings (RID: %d)\n", user->GetLogName(), currentRoom->GetID());
 
@@ -1878,7 +1894,7 @@ bool CChannelManager::OnRoomSetZBAddonRequest(CReceivePacket* msg, IUser* user)
 	{
 		int itemID = msg->ReadUInt16();
 
-		if (g_pItemTable->GetCell<string>("ClassName", to_string(itemID)) == "zbsaddonitem")
+		if (g_pItemAttributeTable->GetClassName(itemID) == "zbsaddonitem")
 		{
 			vector<CUserInventoryItem> items;
 			if (g_UserDatabase.GetInventoryItemsByID(user->GetID(), itemID, items))
@@ -2077,6 +2093,8 @@ bool CChannelManager::OnRoomNoticeClanRequest(CReceivePacket* msg, IUser* user)
 		return false;
 	}
 
+	g_UserManager.FindClanUsers(userList);
+
 	for (auto clanUser : userList)
 	{
 		if (clanUser.user)
@@ -15,6 +15,7 @@ public:
 
 	virtual bool Init();
 	virtual void Shutdown();
+	virtual void OnSecondTick(time_t curTime);
 
 	bool OnChannelListPacket(IExtendedSocket* socket);
 	bool OnRoomRequest(CReceivePacket* msg, IExtendedSocket* socket);
@@ -2,6 +2,7 @@
 #include "manager/usermanager.h"
 #include "manager/packetmanager.h"
 #include "manager/userdatabase.h"
+#include "manager/userdatabaseasync.h"
 
 #include "user/userinventoryitem.h"
 
@@ -9,6 +10,8 @@
 
 #include "serverconfig.h"
 
+#include <memory>
+
 using namespace std;
 
 CClanManager g_ClanManager;
@@ -183,11 +186,19 @@ bool CClanManager::OnClanListRequest(CReceivePacket* msg, IUser* user)
 	string clanName = msg->ReadString();
 
 	// TODO: handle GetClanList error?
-	vector<ClanList_s> clans;
-	int pageMax = 0;
-	g_UserDatabase.GetClanList(clans, clanName, flag, gameModeID, playTime, pageID, pageMax);
-
-	g_PacketManager.SendClanList(user->GetExtendedSocket(), clans, pageID, pageMax);
+	auto clans = make_shared<vector<ClanList_s>>();
+	auto pageMax = make_shared<int>(0);
+	int userID = user->GetID();
+	g_UserDatabaseAsync.Execute([clans, pageMax, clanName, flag, gameModeID, playTime, pageID]()
+	{
+		g_UserDatabase.GetClanList(*clans, clanName, flag, gameModeID, playTime, pageID, *pageMax);
+	},
+	[clans, pageMax, userID, pageID]()
+	{
+		IUser* user = g_UserManager.GetUserById(userID);
+		if (user)
+			g_PacketManager.SendClanList(user->GetExtendedSocket(), *clans, pageID, *pageMax);
+	});
 
 	if (unk3 != 0)
 	{
@@ -200,14 +211,23 @@ bool CClanManager::OnClanListRequest(CReceivePacket* msg, IUser* user)
 bool CClanManager::OnClanInfoRequest(CReceivePacket* msg, IUser* user)
 {
 	int clanID = msg->ReadUInt32();
-	Clan_s clan = {};
-	if (g_UserDatabase.GetClanInfo(clanID, clan) <= 0)
+	auto clan = make_shared<Clan_s>();
+	int userID = user->GetID();
+	g_UserDatabaseAsync.Execute([clan, clanID]()
 	{
-		// TODO: send failed reply
-		return false;
-	}
+		return g_UserDatabase.GetClanInfo(clanID, *clan);
+	},
+	[clan, userID](int result)
+	{
+		IUser* user = g_UserManager.GetUserById(userID);
+		if (!user || result <= 0)
+		{
+			// TODO: send failed reply
+			return;
+		}
 
-	g_PacketManager.SendClanInfo(user->GetExtendedSocket(), clan);
+		g_PacketManager.SendClanInfo(user->GetExtendedSocket(), *clan);
+	});
 
 	return true;
 }
@@ -237,7 +257,12 @@ bool CClanManager::OnClanCreateRequest(CReceivePacket* msg, IUser* user)
 		return false;
 	}
 
-	CUserCharacter character = user->GetCharacter(UFLAG_LOW_LOCATION);
+	CUserCharacter character = user->GetCharacter(UFLAG_LOW_LOCATION | UFLAG_LOW_POINTS);
+	if (character.points < 30000) // 30k points
+	{
+		g_PacketManager.SendClanReply(user->GetExtendedSocket(), RequestClanCreate, 0, OBFUSCATE("CSO_CLAN_CREATE_MORE_POINT"));
+		return false;
+	}
 
 	// default config for clan
 	ClanCreateConfig clanCfg = {};
@@ -262,14 +287,12 @@ bool CClanManager::OnClanCreateRequest(CReceivePacket* msg, IUser* user)
 	case -2:
 		g_PacketManager.SendClanReply(user->GetExtendedSocket(), RequestClanCreate, 0, OBFUSCATE("CSO_CLAN_CREATE_ALREADY_IN_CLAN"));
 		return false;
-	case -3:
-		g_PacketManager.SendClanReply(user->GetExtendedSocket(), RequestClanCreate, 0, OBFUSCATE("CSO_CLAN_CREATE_MORE_POINT"));
-		return false;
 	case 0:
 		g_PacketManager.SendClanReply(user->GetExtendedSocket(), RequestClanCreate, 0, OBFUSCATE("CSO_CLAN_DB_SYSTEM_ERROR"));
 		return false;
 	}
 
+	user->UpdatePoints(-30000);
 	user->UpdateClan(clanID);
 
 	g_PacketManager.SendClanReply(user->GetExtendedSocket(), RequestClanCreate, 1, NULL);
@@ -368,6 +391,7 @@ bool CClanManager::OnClanJoinApproveRequest(CReceivePacket* msg, IUser* user)
 		ClanUser targetMember{};
 		vector<ClanUser> users;
 		g_UserDatabase.GetClanUserList(user->GetID(), true, users);
+		g_UserManager.FindClanUsers(users);
 		for (auto member : users)
 		{
 			if (member.userName == userName)
@@ -458,6 +482,7 @@ bool CClanManager::OnClanLeaveRequest(CReceivePacket* msg, IUser* user)
 
 	std::vector<ClanUser> users;
 	g_UserDatabase.GetClanUserList(user->GetID(), true, users);
+	g_UserManager.FindClanUsers(users);
 	for (auto member : users)
 	{
 		if (member.user)
@@ -481,10 +506,18 @@ bool CClanManager::OnClanInviteRequest(CReceivePacket* msg, IUser* user)
 		return true;
 	}
 
-	IUser* destUser = NULL;
-	int clanID = 0;
 	string gameName = msg->ReadString();
-	int result = g_UserDatabase.ClanInvite(user->GetID(), gameName, destUser, clanID);
+	int destUserID = g_UserDatabase.IsUserExists(gameName, false);
+	IUser* destUser = g_UserManager.GetUserById(destUserID);
+	if (destUserID && !destUser)
+	{
+		// user is offline(TODO: are there more conditions?)
+		g_PacketManager.SendClanReply(user->GetExtendedSocket(), RequestClanInvite, 0, OBFUSCATE("CSO_CLAN_INVITE_FAILED"));
+		return false;
+	}
+
+	int clanID = 0;
+	int result = g_UserDatabase.ClanInvite(user->GetID(), destUserID, clanID);
 	switch (result)
 	{
 	case 0:
@@ -493,9 +526,6 @@ bool CClanManager::OnClanInviteRequest(CReceivePacket* msg, IUser* user)
 	case -1:
 		g_PacketManager.SendClanReply(user->GetExtendedSocket(), RequestClanInvite, 0, OBFUSCATE("CSO_CLAN_INVITE_NO_AUTH"));
 		return false;
-	case -2:
-		g_PacketManager.SendClanReply(user->GetExtendedSocket(), RequestClanInvite, 0, OBFUSCATE("CSO_CLAN_INVITE_FAILED"));
-		return false;
 	case -3:
 		g_PacketManager.SendClanReply(user->GetExtendedSocket(), RequestClanInvite, 0, OBFUSCATE("CSO_CLAN_INVITE_FAIL_NOT_EXIST"));
 		return false;
@@ -539,6 +569,7 @@ bool CClanManager::OnClanChangeMemberGradeRequest(CReceivePacket* msg, IUser* us
 	}
 
 	// TODO: test this
+	targetMember.user = g_UserManager.GetUserById(targetMember.userID);
 	if (targetMember.user)
 	{
 		Clan_s clan = {};
@@ -583,6 +614,7 @@ bool CClanManager::OnClanKickMemberRequest(CReceivePacket* msg, IUser* user)
 
 	vector<ClanUser> users;
 	g_UserDatabase.GetClanMemberList(user->GetID(), users);
+	g_UserManager.FindClanUsers(users);
 	for (auto member : users)
 	{
 		if (!member.user)
@@ -759,6 +791,7 @@ bool CClanManager::OnClanSetNoticeRequest(CReceivePacket* msg, IUser* user)
 		// TODO: test this
 		vector<ClanUser> users;
 		g_UserDatabase.GetClanUserList(user->GetID(), true, users);
+		g_UserManager.FindClanUsers(users);
 		for (auto member : users)
 		{
 			if (member.user)
@@ -846,26 +879,50 @@ bool CClanManager::OnClanStorageRequest(CReceivePacket* msg, IUser* user)
 	if (type == 0) // request storage page
 	{
 		int storagePageID = msg->ReadUInt8();
-		ClanStoragePage storagePage = {};
-		storagePage.pageID = storagePageID;
-		if (g_UserDatabase.GetClanStoragePage(user->GetID(), storagePage) <= 0)
+		auto storagePage = make_shared<ClanStoragePage>();
+		storagePage->pageID = storagePageID;
+		int userID = user->GetID();
+		g_UserDatabaseAsync.Execute([storagePage, userID]()
 		{
-			g_PacketManager.SendClanStorageReply(user->GetExtendedSocket(), 0, OBFUSCATE("CSO_CLAN_DB_SYSTEM_ERROR"));
-			return false;
-		}
+			return g_UserDatabase.GetClanStoragePage(userID, *storagePage);
+		},
+		[storagePage, userID](int result)
+		{
+			IUser* user = g_UserManager.GetUserById(userID);
+			if (!user)
+				return;
+
+			if (result <= 0)
+			{
+				g_PacketManager.SendClanStorageReply(user->GetExtendedSocket(), 0, OBFUSCATE("CSO_CLAN_DB_SYSTEM_ERROR"));
+				return;
+			}
 
-		g_PacketManager.SendClanStoragePage(user->GetExtendedSocket(), storagePage);
+			g_PacketManager.SendClanStoragePage(user->GetExtendedSocket(), *storagePage);
+		});
 	}
 	else if (type == 1) // request storage usage history
 	{
-		ClanStorageHistory storageHistory = {};
-		if (g_UserDatabase.GetClanStorageHistory(user->GetID(), storageHistory) <= 0)
+		int userID = user->GetID();
+		g_UserDatabaseAsync.Execute([userID]()
 		{
-			g_PacketManager.SendClanStorageReply(user->GetExtendedSocket(), 0, OBFUSCATE("CSO_CLAN_DB_SYSTEM_ERROR"));
-			return false;
-		}
+			ClanStorageHistory storageHistory = {};
+			return g_UserDatabase.GetClanStorageHistory(userID, storageHistory);
+		},
+		[userID](int result)
+		{
+			IUser* user = g_UserManager.GetUserById(userID);
+			if (!user)
+				return;
 
-		g_PacketManager.SendClanStorageHistory(user->GetExtendedSocket()); // client crashes
+			if (result <= 0)
+			{
+				g_PacketManager.SendClanStorageReply(user->GetExtendedSocket(), 0, OBFUSCATE("CSO_CLAN_DB_SYSTEM_ERROR"));
+				return;
+			}
+
+			g_PacketManager.SendClanStorageHistory(user->GetExtendedSocket()); // client crashes
+		});
 	}
 	else if (type == 2) // request storage set access grade 
 	{
@@ -882,6 +939,8 @@ bool CClanManager::OnClanStorageRequest(CReceivePacket* msg, IUser* user)
 			vector<ClanUser> userList;
 			if (g_UserDatabase.GetClanUserList(user->GetID(), true, userList) > 0)
 			{
+				g_UserManager.FindClanUsers(userList);
+
 				for (auto clanUser : userList)
 				{
 					if (clanUser.user)
@@ -966,6 +1025,8 @@ bool CClanManager::OnClanMemberUserListRequest(CReceivePacket* msg, IUser* user)
 		return false;
 	}
 
+	g_UserManager.FindClanUsers(users);
+
 	if (users.size())
 		g_PacketManager.SendClanCreateMemberUserList(user->GetExtendedSocket(), users);
 
@@ -974,16 +1035,21 @@ bool CClanManager::OnClanMemberUserListRequest(CReceivePacket* msg, IUser* user)
 
 bool CClanManager::OnClanJoinUserListRequest(CReceivePacket* msg, IUser* user)
 {
-	vector<ClanUserJoinRequest> users;
-	int result = g_UserDatabase.GetClanMemberJoinUserList(user->GetID(), users);
-	switch (result)
+	auto users = make_shared<vector<ClanUserJoinRequest>>();
+	int userID = user->GetID();
+	g_UserDatabaseAsync.Execute([users, userID]()
 	{
-	case 0:
-		return false;
-	}
+		return g_UserDatabase.GetClanMemberJoinUserList(userID, *users);
+	},
+	[users, userID](int result)
+	{
+		IUser* user = g_UserManager.GetUserById(userID);
+		if (!user || !result)
+			return;
 
-	if (users.size())
-		g_PacketManager.SendClanCreateJoinUserList(user->GetExtendedSocket(), users);
+		if (users->size())
+			g_PacketManager.SendClanCreateJoinUserList(user->GetExtendedSocket(), *users);
+	});
 
 	return true;
 }
@@ -999,21 +1065,16 @@ bool CClanManager::OnClanChatMessage(CReceivePacket* msg, IUser* user)
 		return false;
 	}
 
+	g_UserManager.FindClanUsers(userList);
+
+	CUserCharacter character = user->GetCharacter(UFLAG_LOW_GAMENAME);
+
 	// send message to all clan users
 	for (auto clanUser : userList)
 	{
-		if (clanUser.user)
-		{
-			CUserCharacterExtended characterExtendedDest = clanUser.user->GetCharacterExtended(EXT_UFLAG_BANSETTINGS);
-
-			// you can't send clan message if dest is blocking your chat
-			if (~characterExtendedDest.banSettings & 2 || characterExtendedDest.banSettings & 2 && !g_UserDatabase.IsInBanList(clanUser.userID, user->GetID()))
-			{
-				CUserCharacter character = user->GetCharacter(UFLAG_LOW_GAMENAME);
-
-				g_PacketManager.SendClanChatMessage(clanUser.user->GetExtendedSocket(), character.gameName, message);
-			}
-		}
+		// you can't send clan message if dest is blocking your chat
+		if (clanUser.user && !clanUser.user->IsBlocking(character.gameName, BANSETTINGS_CHAT))
+			g_PacketManager.SendClanChatMessage(clanUser.user->GetExtendedSocket(), character.gameName, message);
 	}
 
 	return true;
@@ -1028,6 +1089,8 @@ void CClanManager::OnUserLogin(IUser* user)
 		return;
 	}
 
+	g_UserManager.FindClanUsers(userList);
+
 	g_PacketManager.SendClanCreateUserList(user->GetExtendedSocket(), userList);
 
 	// TODO: move it to new func?
@@ -1053,6 +1116,8 @@ void CClanManager::OnUserLogin(IUser* user)
 	vector<ClanUser> users;
 	if (g_UserDatabase.GetClanMemberList(user->GetID(), users) > 0 && users.size())
 	{
+		g_UserManager.FindClanUsers(users);
+
 		g_PacketManager.SendClanCreateMemberUserList(user->GetExtendedSocket(), users);
 	}
 
@@ -177,15 +177,13 @@ void CDedicatedServerManager::AddServer(IExtendedSocket* socket, int ip, int por
 
 	CDedicatedServer* server = new CDedicatedServer(socket, ip, port);
 	m_vServerPools.push_back(server);
+
+	socket->SetServer(server);
 }
 
 CDedicatedServer* CDedicatedServerManager::GetServerBySocket(IExtendedSocket* socket)
 {
-	for (auto server : m_vServerPools)
-		if (server->GetSocket() == socket)
-			return server;
-
-	return NULL;
+	return socket->GetServer();
 }
 
 /**
@@ -206,6 +204,8 @@ void CDedicatedServerManager::RemoveServer(IExtendedSocket* socket)
 			room->EndGame(true);
 	}
 
+	socket->SetServer(NULL);
+
 	delete server;
 	m_vServerPools.erase(remove(m_vServerPools.begin(), m_vServerPools.end(), server), m_vServerPools.end());
 }
@@ -26,8 +26,8 @@ bool CHostManager::OnPacket(CReceivePacket* msg, IExtendedSocket* socket)
 {
 	LOG_PACKET;
 
-	CDedicatedServer* server = g_DedicatedServerManager.GetServerBySocket(socket);
-	IUser* user = g_UserManager.GetUserBySocket(socket);
+	CDedicatedServer* server = socket->GetServer();
+	IUser* user = socket->GetUser();
 	IRoom* room = server != NULL ? server->GetRoom() : (user != NULL ? user->GetCurrentRoom() : NULL);
 
 	if (room == NULL)
@@ -176,7 +176,7 @@ bool CHostManager::OnSetUserInventory(CReceivePacket* msg, IExtendedSocket* sock
 			inGameItems.begin(),
 			inGameItems.end(),
 			[](const CUserInventoryItem& item) -> bool {
-				return !(item.m_nItemID && item.m_nInUse && g_pItemTable->GetCell<int>("InGameItem", to_string(item.m_nItemID)));
+				return !(item.m_nItemID && item.m_nInUse && g_pItemAttributeTable->IsInGameItem(item.m_nItemID));
 			}
 		),
 		inGameItems.end()
@@ -188,7 +188,7 @@ bool CHostManager::OnSetUserInventory(CReceivePacket* msg, IExtendedSocket* sock
 			inGameItems.begin(),
 			inGameItems.end(),
 			[](const CUserInventoryItem& item) -> bool {
-				int category = g_pItemTable->GetCell<int>("Category", to_string(item.m_nItemID));
+				int category = g_pItemAttributeTable->GetCategory(item.m_nItemID);
 				return ((category >= 1 && category <= 6 || category == 11) ? !item.m_nStatus : false);
 			}
 		),
@@ -505,8 +505,8 @@ bool CHostManager::OnZbsResult(CReceivePacket* msg, IExtendedSocket* socket)
 
 bool CHostManager::OnGameEnd(IExtendedSocket* socket)
 {
-	CDedicatedServer* server = g_DedicatedServerManager.GetServerBySocket(socket);
-	IRoom* room = server != NULL ? server->GetRoom() : g_UserManager.GetUserBySocket(socket)->GetCurrentRoom();
+	CDedicatedServer* server = socket->GetServer();
+	IRoom* room = server != NULL ? server->GetRoom() : socket->GetUser()->GetCurrentRoom();
 
 	Logger().Info("Room (RID: %d) ending game\n", room->GetID());
 
@@ -415,7 +415,7 @@ bool CItemManager::OnItemPacket(CReceivePacket* msg, IExtendedSocket* socket)
 {
 	LOG_PACKET;
 
-	IUser* user = g_UserManager.GetUserBySocket(socket);
+	IUser* user = socket->GetUser();
 	if (!user)
 	{
 		return false;
@@ -438,7 +438,7 @@ bool CItemManager::OnItemPacket(CReceivePacket* msg, IExtendedSocket* socket)
 		if (!item.m_nItemID)
 			return false;
 
-		string className = g_pItemTable->GetCell<string>("ClassName", to_string(item.m_nItemID));
+		string className = g_pItemAttributeTable->GetClassName(item.m_nItemID);
 
 		if (inventoryType == 1 || className == "LobbyBG" || className == "zbRespawnEffect" || className == "CombatInfoItem") // switch status
 		{
@@ -674,7 +674,7 @@ int CItemManager::AddItem(int userID, IUser* user, int itemID, int count, int du
 	if (g_UserDatabase.IsInventoryFull(userID))
 		return ITEM_ADD_INVENTORY_FULL;
 
-	if (g_pItemTable->GetRowIdx(to_string(itemID)) < 0)
+	if (!g_pItemAttributeTable->IsExists(itemID))
 		return ITEM_ADD_UNKNOWN_ITEMID;
 
 	if (count <= 0)
@@ -738,8 +738,8 @@ int CItemManager::AddItem(int userID, IUser* user, int itemID, int count, int du
 		duration = currentTimestamp + duration * CSO_24_HOURS_IN_MINUTES; // !!! items must have inuse = 1 and status = 1
 
 	// Category: 1 - pistols, 2 - shotguns, 3 - SMG, 4 - rifle, 5 - machine guns, 6 - equipment,  7 - class, 12 - costume, 13 - weapon parts, 
-	int useType = g_pItemTable->GetCell<int>(OBFUSCATE("UseType"), to_string(itemID));
-	int category = g_pItemTable->GetCell<int>("Category", to_string(itemID));
+	int useType = g_pItemAttributeTable->GetUseType(itemID);
+	int category = g_pItemAttributeTable->GetCategory(itemID);
 	// countable items with use button
 	if ((category == 9 && (useType == 0 || useType == 1 || useType == 2)) || (category == 8 && (useType == 0 || useType == 2)))
 	{
@@ -775,7 +775,7 @@ int CItemManager::AddItem(int userID, IUser* user, int itemID, int count, int du
 		return ITEM_ADD_SUCCESS;
 	}
 
-	string className = g_pItemTable->GetCell<string>("ClassName", to_string(itemID));
+	string className = g_pItemAttributeTable->GetClassName(itemID);
 	if (category == 12 || className == "Tattoo")
 	{
 		CUserCostumeLoadout loadout;
@@ -834,7 +834,7 @@ int CItemManager::AddItem(int userID, IUser* user, int itemID, int count, int du
 		}
 		else if (className == "ZombieSkinCostume")
 		{
-			zombieSkinType = g_pItemTable->GetCell<int>("ZombieSkin", to_string(itemID));
+			zombieSkinType = g_pItemAttributeTable->GetZombieSkin(itemID);
 			if (zombieSkinType >= ZB_COSTUME_SLOT_COUNT_MAX)
 			{
 				Logger().Warn("CItemManager::AddItem: can't setup zb costume loadout (zombieSkinType >= ZB_COSTUME_SLOT_COUNT_MAX)!!!\n");
@@ -903,7 +903,7 @@ int CItemManager::AddItem(int userID, IUser* user, int itemID, int count, int du
 			user->UpdateKillerMarkEffect(itemID);
 	}
 
-	string resourceName = g_pItemTable->GetCell<string>("recourcename", to_string(itemID));
+	string resourceName = g_pItemAttributeTable->GetResourceName(itemID);
 	if (resourceName.find("chatcolor_") != std::string::npos)
 	{
 		CUserCharacter character = user->GetCharacter(NULL, UFLAG_HIGH_CHATCOLOR);
@@ -1005,7 +1005,7 @@ int CItemManager::AddItems(int userID, IUser* user, vector<RewardItem>& items)
 		int count = item.count;
 		int lockStatus = item.lockStatus;
 
-		if (g_pItemTable->GetRowIdx(to_string(itemID)) < 0)
+		if (!g_pItemAttributeTable->IsExists(itemID))
 			continue;
 
 		if (count <= 0)
@@ -1087,8 +1087,8 @@ int CItemManager::AddItems(int userID, IUser* user, vector<RewardItem>& items)
 			duration = currentTimestamp + duration * CSO_24_HOURS_IN_MINUTES;
 
 		// Category: 1 - pistols, 2 - shotguns, 3 - SMG, 4 - rifle, 5 - machine guns, 6 - equipment,  7 - class, 12 - costume, 13 - weapon parts, 
-		int useType = g_pItemTable->GetCell<int>(OBFUSCATE("UseType"), to_string(itemID));
-		int category = g_pItemTable->GetCell<int>("Category", to_string(itemID));
+		int useType = g_pItemAttributeTable->GetUseType(itemID);
+		int category = g_pItemAttributeTable->GetCategory(itemID);
 		// countable items with use button
 		if ((category == 9 && (useType == 0 || useType == 2)) || (category == 8 && (useType == 0 || useType == 2)))
 		{
@@ -1111,7 +1111,7 @@ int CItemManager::AddItems(int userID, IUser* user, vector<RewardItem>& items)
 			continue;
 		}
 
-		string className = g_pItemTable->GetCell<string>("ClassName", to_string(itemID));
+		string className = g_pItemAttributeTable->GetClassName(itemID);
 		if (category == 12 || className == "Tattoo")
 		{
 			CUserCostumeLoadout loadout;
@@ -1167,7 +1167,7 @@ int CItemManager::AddItems(int userID, IUser* user, vector<RewardItem>& items)
 			}
 			else if (className == "ZombieSkinCostume")
 			{
-				zombieSkinType = g_pItemTable->GetCell<int>("ZombieSkin", to_string(itemID));
+				zombieSkinType = g_pItemAttributeTable->GetZombieSkin(itemID);
 				if (zombieSkinType >= ZB_COSTUME_SLOT_COUNT_MAX)
 				{
 					Logger().Warn("CItemManager::AddItem: can't setup zb costume loadout (zombieSkinType >= ZB_COSTUME_SLOT_COUNT_MAX)!!!\n");
@@ -1246,7 +1246,7 @@ int CItemManager::AddItems(int userID, IUser* user, vector<RewardItem>& items)
 				user->UpdateKillerMarkEffect(itemID);
 		}
 
-		string resourceName = g_pItemTable->GetCell<string>("recourcename", to_string(itemID));
+		string resourceName = g_pItemAttributeTable->GetResourceName(itemID);
 		if (resourceName.find("chatcolor_") != std::string::npos)
 		{
 			CUserCharacter character = user->GetCharacter(NULL, UFLAG_HIGH_CHATCOLOR);
@@ -1363,8 +1363,8 @@ int CItemManager::UseItem(IUser* user, int slot, int additionalArg, int addition
 		return ITEM_USE_BAD_SLOT;
 	}
 
-	string className = g_pItemTable->GetCell<string>("ClassName", to_string(item.m_nItemID));
-	string name = g_pItemTable->GetCell<string>("Name", to_string(item.m_nItemID));
+	string className = g_pItemAttributeTable->GetClassName(item.m_nItemID);
+	string name = g_pItemAttributeTable->GetName(item.m_nItemID);
 
 	if (!CanUseItem(item))
 	{
@@ -1401,7 +1401,7 @@ int CItemManager::UseItem(IUser* user, int slot, int additionalArg, int addition
 	}
 	default:
 	{
-		int category = g_pItemTable->GetCell<int>("Category", to_string(item.m_nItemID));
+		int category = g_pItemAttributeTable->GetCategory(item.m_nItemID);
 		if (category < 9 || category == 11) // if extentable item(should be moved to onitemuse)
 		{
 			int flag = 0;
@@ -1456,7 +1456,7 @@ bool CItemManager::OnItemUse(IUser* user, CUserInventoryItem& item, int count)
 
 	item.m_nCount -= count;
 
-	int rewardID = g_pItemTable->GetCell<int>("rewardID", to_string(item.m_nItemID));
+	int rewardID = g_pItemAttributeTable->GetRewardID(item.m_nItemID);
 	if (rewardID)
 	{
 		RewardNotice notice = {};
@@ -1607,7 +1607,7 @@ bool CItemManager::RemoveItem(int userID, IUser* user, CUserInventoryItem& item)
 		}
 	}
 
-	string className = g_pItemTable->GetCell<string>("ClassName", to_string(item.m_nItemID));
+	string className = g_pItemAttributeTable->GetClassName(item.m_nItemID);
 	if (className == "LobbyBG")
 	{
 		CUserCharacter character = user->GetCharacter(UFLAG_LOW_NAMEPLATE);
@@ -1675,7 +1675,7 @@ bool CItemManager::RemoveItem(int userID, IUser* user, CUserInventoryItem& item)
 		}
 	}
 
-	string resourceName = g_pItemTable->GetCell<string>("recourcename", to_string(item.m_nItemID));
+	string resourceName = g_pItemAttributeTable->GetResourceName(item.m_nItemID);
 	if (resourceName.find("chatcolor_") != std::string::npos)
 	{
 		CUserCharacter character = user->GetCharacter(NULL, UFLAG_HIGH_CHATCOLOR);
@@ -1997,13 +1997,13 @@ void CItemManager::InsertExp(IUser* user, CUserInventoryItem& targetItem, vector
 		static vector<int> itemsExp{0, 10, 20, 50, 100, 200, 500};
 		int totalExp = 0;
 
-		int grade = g_pItemTable->GetCell<int>("ItemGrade", to_string(targetItem.m_nItemID));
+		int grade = g_pItemAttributeTable->GetItemGrade(targetItem.m_nItemID);
 		vector<int> row = m_pReinforceMaxExpTable->GetRow<int>(to_string(targetItem.m_nEnhancementLevel));
 		int expToUpgrade = row[grade];
 
 		for (auto& i : items)
 		{
-			int grade = g_pItemTable->GetCell<int>("ItemGrade", to_string(i.m_nItemID));
+			int grade = g_pItemAttributeTable->GetItemGrade(i.m_nItemID);
 			switch (i.m_nItemID)
 			{
 			case 8481: // WeaponReinforceExp100
@@ -2019,8 +2019,8 @@ void CItemManager::InsertExp(IUser* user, CUserInventoryItem& targetItem, vector
 
 			if (!grade)
 			{
-				string targetItemName = g_pItemTable->GetCell<string>("Name", to_string(targetItem.m_nItemID));
-				string enhName = g_pItemTable->GetCell<string>("Name", to_string(i.m_nItemID));
+				string targetItemName = g_pItemAttributeTable->GetName(targetItem.m_nItemID);
+				string enhName = g_pItemAttributeTable->GetName(i.m_nItemID);
 				if (enhName.find("Enh") == 0)
 				{
 					g_PacketManager.SendUMsgNoticeMsgBoxToUuid(user->GetExtendedSocket(), "this material is under dev");
@@ -2167,7 +2167,7 @@ bool CItemManager::OnEnhancementRequest(IUser* user, CReceivePacket* msg)
 			return false;
 		}
 
-		int grade = g_pItemTable->GetCell<int>("ItemGrade", to_string(targetItem.m_nItemID)); // get target item grade
+		int grade = g_pItemAttributeTable->GetItemGrade(targetItem.m_nItemID); // get target item grade
 		vector<int> row = m_pReinforceMaxExpTable->GetRow<int>(to_string(targetItem.m_nEnhancementLevel));
 		int expToUpgrade = row[grade]; // get max exp upgrade value for the target item
 
@@ -2319,7 +2319,7 @@ bool CItemManager::OnEnhancementRequest(IUser* user, CReceivePacket* msg)
 			int totalExp = 0;
 			for (auto& i : items)
 			{
-				int grade = g_pItemTable->GetCell<int>("ItemGrade", to_string(i.m_nItemID));
+				int grade = g_pItemAttributeTable->GetItemGrade(i.m_nItemID);
 				if (!grade)
 				{
 					switch (i.m_nItemID)
@@ -2343,7 +2343,7 @@ bool CItemManager::OnEnhancementRequest(IUser* user, CReceivePacket* msg)
 				OnItemUse(user, i); // used as exp for target item
 			}
 
-			int grade = g_pItemTable->GetCell<int>("ItemGrade", to_string(targetItem.m_nItemID));
+			int grade = g_pItemAttributeTable->GetItemGrade(targetItem.m_nItemID);
 			vector<int> row = m_pReinforceMaxExpTable->GetRow<int>(to_string(targetItem.m_nEnhancementLevel));
 			int expToUpgrade = row[grade];
 
@@ -2599,7 +2599,7 @@ bool CItemManager::OnWeaponPaintSwitchRequest(IUser* user, CReceivePacket* msg)
 	if (std::find(paintIDs.begin(), paintIDs.end(), paintID) == paintIDs.end())
 		return false;
 
-	string paintClassName = g_pItemTable->GetCell<string>("ClassName", to_string(paintID));
+	string paintClassName = g_pItemAttributeTable->GetClassName(paintID);
 
 	if (paintClassName != "WeaponPaintRemoveItem")
 	{
@@ -2680,8 +2680,8 @@ bool CItemManager::OnPartEquipRequest(IUser* user, CReceivePacket* msg)
 		if (!weapon.m_nItemID || !part.m_nItemID)
 			return false;
 
-		int weaponCategory = g_pItemTable->GetCell<int>("Category", to_string(weapon.m_nItemID));
-		int partCategory = g_pItemTable->GetCell<int>("Category", to_string(part.m_nItemID));
+		int weaponCategory = g_pItemAttributeTable->GetCategory(weapon.m_nItemID);
+		int partCategory = g_pItemAttributeTable->GetCategory(part.m_nItemID);
 
 		if (weaponCategory != 11 && (weaponCategory < 1 || weaponCategory > 6) || partCategory != 13)
 			return false;
@@ -2841,8 +2841,8 @@ void CItemManager::OnCostumeEquip(IUser* user, int gameSlot)
 
 	vector<CUserInventoryItem> items; // temp vector
 
-	string className = g_pItemTable->GetCell<string>("ClassName", to_string(item.m_nItemID));
-	int zombieSkinID = className == "ZombieSkinCostume" ? g_pItemTable->GetCell<int>("ZombieSkin", to_string(item.m_nItemID)) : -1;
+	string className = g_pItemAttributeTable->GetClassName(item.m_nItemID);
+	int zombieSkinID = className == "ZombieSkinCostume" ? g_pItemAttributeTable->GetZombieSkin(item.m_nItemID) : -1;
 
 	CUserCostumeLoadout loadout;
 	if (g_UserDatabase.GetCostumeLoadout(user->GetID(), loadout) <= 0)
@@ -50,6 +50,8 @@ CPacketManager::CPacketManager() : CBaseManager("PacketManager")
 	m_pUnk49 = NULL;
 	m_pUnk54 = NULL;
 	m_pUnk55 = NULL;
+	m_pModeList = NULL;
+	m_pEncyclopedia = NULL;
 }
 
 CPacketManager::~CPacketManager()
@@ -58,29 +60,29 @@ CPacketManager::~CPacketManager()
 
 bool CPacketManager::Init()
 {
-	m_pMapListZip = LoadBinaryMetadata("MapList.csv", true);
-	m_pClientTableZip = LoadBinaryMetadata("ClientTable.csv", true);
-	m_pWeaponPartsZip = LoadBinaryMetadata("weaponparts.csv", true);
-	m_pMileageShopZip = LoadBinaryMetadata("MileageShop.csv", true);
-	m_pMatchingZip = LoadBinaryMetadata("MatchOption.csv", true);
-	m_pProgressUnlockZip = LoadBinaryMetadata("progress_unlock.csv", true);
-	m_pGameModeListZip = LoadBinaryMetadata("GameModeList.csv", true);
-	m_pReinforceMaxLvlZip = LoadBinaryMetadata("ReinforceMaxLv.csv", true);
-	m_pReinforceMaxExpZip = LoadBinaryMetadata("ReinforceMaxEXP.csv", true);
-	m_pItemExpireTimeZip = LoadBinaryMetadata("ItemExpireTime.csv", true);
-	m_pHonorMoneyShopZip = LoadBinaryMetadata("HonorMoneyShop.csv", true);
-	m_pScenarioTX_CommonZip = LoadBinaryMetadata("scenariotx_common.json", true);
-	m_pScenarioTX_DediZip = LoadBinaryMetadata("scenariotx_dedi.json", true);
-	m_pShopItemList_DediZip = LoadBinaryMetadata("shopitemlist_dedi.json", true);
-	m_pZBCompetitiveZip = LoadBinaryMetadata("ZBCompetitive.json", true);
-	m_pPPSystemZip = LoadBinaryMetadata("ppsystem.json", true);
-	m_pItemZip = LoadBinaryMetadata("Item.csv", true);
-	m_pCodisDataZip = LoadBinaryMetadata("CodisData.csv", true);
-	m_pWeaponPropZip = LoadBinaryMetadata("WeaponProp.json", true);
-	m_pModeEventZip = LoadBinaryMetadata("ModeEvent.csv", true);
-	m_pEventShopZip = LoadBinaryMetadata("EventShop.csv", true);
-	m_pFamilyTotalWarMapZip = LoadBinaryMetadata("FamilyTotalWarMap.csv", true);
-	m_pFamilyTotalWarZip = LoadBinaryMetadata("FamilyTotalWar.json", true);
+	m_pMapListZip = LoadBinaryMetadata("MapList.csv", kPacket_Metadata_MapList);
+	m_pClientTableZip = LoadBinaryMetadata("ClientTable.csv", kPacket_Metadata_ClientTable);
+	m_pWeaponPartsZip = LoadBinaryMetadata("weaponparts.csv", kPacket_Metadata_WeaponParts);
+	m_pMileageShopZip = LoadBinaryMetadata("MileageShop.csv", kPacket_Metadata_MileageShop);
+	m_pMatchingZip = LoadBinaryMetadata("MatchOption.csv", kPacket_Metadata_MatchOption);
+	m_pProgressUnlockZip = LoadBinaryMetadata("progress_unlock.csv", kPacket_Metadata_ProgressUnlock);
+	m_pGameModeListZip = LoadBinaryMetadata("GameModeList.csv", kPacket_Metadata_GameModeList);
+	m_pReinforceMaxLvlZip = LoadBinaryMetadata("ReinforceMaxLv.csv", kPacket_Metadata_ReinforceMaxLvl);
+	m_pReinforceMaxExpZip = LoadBinaryMetadata("ReinforceMaxEXP.csv", kPacket_Metadata_ReinforceMaxEXP);
+	m_pItemExpireTimeZip = LoadBinaryMetadata("ItemExpireTime.csv", kPacket_Metadata_ItemExpireTime);
+	m_pHonorMoneyShopZip = LoadBinaryMetadata("HonorMoneyShop.csv", kPacket_Metadata_HonorMoneyShop);
+	m_pScenarioTX_CommonZip = LoadBinaryMetadata("scenariotx_common.json", kPacket_Metadata_ScenarioTX_Common);
+	m_pScenarioTX_DediZip = LoadBinaryMetadata("scenariotx_dedi.json", kPacket_Metadata_ScenarioTX_Dedi);
+	m_pShopItemList_DediZip = LoadBinaryMetadata("shopitemlist_dedi.json", kPacket_Metadata_ShopItemList_Dedi);
+	m_pZBCompetitiveZip = LoadBinaryMetadata("ZBCompetitive.json", kPacket_Metadata_ZBCompetitive);
+	m_pPPSystemZip = LoadBinaryMetadata("ppsystem.json", kPacket_Metadata_PPSystem);
+	m_pItemZip = LoadBinaryMetadata("Item.csv", kPacket_Metadata_Item);
+	m_pCodisDataZip = LoadBinaryMetadata("CodisData.csv", kPacket_Metadata_CodisData);
+	m_pWeaponPropZip = LoadBinaryMetadata("WeaponProp.json", kPacket_Metadata_WeaponProp);
+	m_pModeEventZip = LoadBinaryMetadata("ModeEvent.csv", kPacket_Metadata_ModeEvent);
+	m_pEventShopZip = LoadBinaryMetadata("EventShop.csv", kPacket_Metadata_EventShop);
+	m_pFamilyTotalWarMapZip = LoadBinaryMetadata("FamilyTotalWarMap.csv", kPacket_Metadata_FamilyTotalWarMap);
+	m_pFamilyTotalWarZip = LoadBinaryMetadata("FamilyTotalWar.json", kPacket_Metadata_FamilyTotalWar);
 	m_pReinforceItemsExp = LoadBinaryMetadata("Metadata_ReinforceItemsExp.bin");
 	m_pUnk3 = LoadBinaryMetadata("Metadata_Unk3.bin");
 	m_pUnk8 = LoadBinaryMetadata("Metadata_Unk8.bin");
@@ -90,6 +92,8 @@ bool CPacketManager::Init()
 	m_pUnk49 = LoadBinaryMetadata("Metadata_Unk49.bin");
 	m_pUnk54 = LoadBinaryMetadata("Metadata_Unk54.bin");
 	m_pUnk55 = LoadBinaryMetadata("Metadata_Unk55.bin");
+	m_pModeList = new CBinMetadata(metaData2, sizeof(metaData2), kPacket_Metadata_ModeList);
+	m_pEncyclopedia = new CBinMetadata(metaData_Encyclopedia, sizeof(metaData_Encyclopedia));
 
 	if (!m_pMapListZip || !m_pClientTableZip || !m_pWeaponPartsZip || !m_pMileageShopZip || !m_pMatchingZip || !m_pProgressUnlockZip || !m_pGameModeListZip ||
 		!m_pReinforceMaxLvlZip || !m_pReinforceMaxExpZip || !m_pItemExpireTimeZip || !m_pHonorMoneyShopZip || !m_pScenarioTX_CommonZip || !m_pScenarioTX_DediZip ||
@@ -173,6 +177,10 @@ void CPacketManager::Shutdown()
 		delete m_pUnk54;
 	if (m_pUnk55)
 		delete m_pUnk55;
+	if (m_pModeList)
+		delete m_pModeList;
+	if (m_pEncyclopedia)
+		delete m_pEncyclopedia;
 }
 
 CSendPacket* CPacketManager::CreatePacket(IExtendedSocket* socket, int msgID)
@@ -180,7 +188,59 @@ CSendPacket* CPacketManager::CreatePacket(IExtendedSocket* socket, int msgID)
 	return new CSendPacket(socket->GetSeq(), msgID);
 }
 
-CBinMetadata* CPacketManager::LoadBinaryMetadata(const char* fileName, bool zip)
+/**
+ * Creates packet body that is serialized once and sent to many sockets by SendBroadcastPacket. The body has no header
+ * @param msgID
+ * @return Body packet, write the payload without calling BuildHeader
+ */
+CSendPacket* CPacketManager::CreateBroadcastPacket(int msgID)
+{
+	return new CSendPacket(0, msgID);
+}
+
+/**
+ * Sends broadcast body to sockets. Every socket gets its own header (sequence) and encryption, the payload is shared.
+ * Deletes the body
+ * @param sockets Recipients, NULL entries are skipped
+ * @param body Packet created by CreateBroadcastPacket
+ */
+void CPacketManager::SendBroadcastPacket(const vector<IExtendedSocket*>& sockets, CSendPacket* body)
+{
+	const Buffer& buf = body->GetData();
+	shared_ptr<vector<unsigned char>> payload = make_shared<vector<unsigned char>>(buf.getData(), buf.getData() + buf.getSize());
+	int msgID = body->m_nPacketID;
+	delete body;
+
+	size_t last = sockets.size();
+	while (last && !sockets[last - 1])
+		last--;
+
+	for (size_t i = 0; i < last; i++)
+	{
+		IExtendedSocket* socket = sockets[i];
+		if (!socket)
+			continue;
+
+		CSendPacket* msg = CreatePacket(socket, msgID);
+		msg->BuildHeader();
+
+		// the last packet takes the payload over, so a single recipient can encrypt it in place
+		if (i == last - 1)
+			msg->WriteSharedData(move(payload));
+		else
+			msg->WriteSharedData(payload);
+
+		socket->Send(msg);
+	}
+}
+
+/**
+ * Loads metadata file and encodes its frame body
+ * @param fileName File name in Data directory
+ * @param zipType Metadata type of zipped tables, the file is zipped and prefixed with the type and size. -1 to send the file as is
+ * @return Metadata, NULL on failure
+ */
+CBinMetadata* CPacketManager::LoadBinaryMetadata(const char* fileName, int zipType)
 {
 	char path[MAX_PATH];
 	snprintf(path, MAX_PATH, "Data/%s", fileName);
@@ -215,7 +275,7 @@ CBinMetadata* CPacketManager::LoadBinaryMetadata(const char* fileName, bool zip)
 
 	fclose(f);
 
-	if (zip)
+	if (zipType >= 0)
 	{
 		// create zip and get stream data
 		zip_t *zipStream = zip_stream_open(NULL, 0, ZIP_DEFAULT_COMPRESSION_LEVEL, 'w');
@@ -229,27 +289,72 @@ CBinMetadata* CPacketManager::LoadBinaryMetadata(const char* fileName, bool zip)
 		zip_stream_close(zipStream);
 	}
 
-	return new CBinMetadata(buffer, size);
+	CBinMetadata* metadata = new CBinMetadata(buffer, size, zipType);
+	free(buffer);
+
+	return metadata;
 }
 
-void CPacketManager::SendUMsgNoticeMsgBoxToUuid(IExtendedSocket* socket, const string& text)
+/**
+ * Sends pre-encoded metadata. Only the packet header is built for the socket, the frame body is shared
+ * @param socket
+ * @param metadata
+ */
+void CPacketManager::SendMetadataFrame(IExtendedSocket* socket, CBinMetadata* metadata)
 {
-	CSendPacket* msg = CreatePacket(socket, PacketId::UMsg);
+	if (!metadata)
+		return;
+
+	CSendPacket* msg = CreatePacket(socket, PacketId::Metadata);
 	msg->BuildHeader();
+
+	msg->WriteSharedData(metadata->GetFrameBody());
+
+	socket->Send(msg);
+}
+
+void BuildUMsgNoticeMsgBoxToUuid(CSendPacket* msg, const string& text)
+{
 	msg->WriteUInt8(UMsgPacketType::ServerNoticeMessageMsgBox);
 	msg->WriteString(text);
-	socket->Send(msg);
 }
 
-void CPacketManager::SendUMsgNoticeMessageInChat(IExtendedSocket* socket, const string& text)
+void CPacketManager::SendUMsgNoticeMsgBoxToUuid(IExtendedSocket* socket, const string& text)
 {
 	CSendPacket* msg = CreatePacket(socket, PacketId::UMsg);
 	msg->BuildHeader();
+	BuildUMsgNoticeMsgBoxToUuid(msg, text);
+	socket->Send(msg);
+}
+
+void CPacketManager::SendUMsgNoticeMsgBoxToUuid(const vector<IExtendedSocket*>& sockets, const string& text)
+{
+	CSendPacket* msg = CreateBroadcastPacket(PacketId::UMsg);
+	BuildUMsgNoticeMsgBoxToUuid(msg, text);
+	SendBroadcastPacket(sockets, msg);
+}
+
+void BuildUMsgNoticeMessageInChat(CSendPacket* msg, const string& text)
+{
 	msg->WriteUInt8(UMsgPacketType::ServerNoticeMessageInChat);
 	msg->WriteString(text);
+}
+
+void CPacketManager::SendUMsgNoticeMessageInChat(IExtendedSocket* socket, const string& text)
+{
+	CSendPacket* msg = CreatePacket(socket, PacketId::UMsg);
+	msg->BuildHeader();
+	BuildUMsgNoticeMessageInChat(msg, text);
 	socket->Send(msg);
 }
 
+void CPacketManager::SendUMsgNoticeMessageInChat(const vector<IExtendedSocket*>& sockets, const string& text)
+{
+	CSendPacket* msg = CreateBroadcastPacket(PacketId::UMsg);
+	BuildUMsgNoticeMessageInChat(msg, text);
+	SendBroadcastPacket(sockets, msg);
+}
+
 /*void CPacketManager::SendUMsgNoticeMsgBoxToUuid(IExtendedSocket* socket, const string& text)
 {
 	CSendPacket* msg = CreatePacket(socket, PacketId::UMsg);
@@ -275,11 +380,8 @@ void CPacketManager::SendUMsgSystemReply(IExtendedSocket* socket, int type, cons
 	socket->Send(msg);
 }
 
-void CPacketManager::SendUMsgUserMessage(IExtendedSocket* socket, int type, const string& senderName, const string& text, int whisperType)
+void BuildUMsgUserMessage(CSendPacket* msg, int type, const string& senderName, const string& text, int whisperType)
 {
-	CSendPacket* msg = CreatePacket(socket, PacketId::UMsg);
-	msg->BuildHeader();
-
 	msg->WriteUInt8(type);
 
 	if (type == UMsgPacketType::WhisperUserMessage)
@@ -287,10 +389,23 @@ void CPacketManager::SendUMsgUserMessage(IExtendedSocket* socket, int type, cons
 
 	msg->WriteString(senderName);
 	msg->WriteString(text);
+}
 
+void CPacketManager::SendUMsgUserMessage(IExtendedSocket* socket, int type, const string& senderName, const string& text, int whisperType)
+{
+	CSendPacket* msg = CreatePacket(socket, PacketId::UMsg);
+	msg->BuildHeader();
+	BuildUMsgUserMessage(msg, type, senderName, text, whisperType);
 	socket->Send(msg);
 }
 
+void CPacketManager::SendUMsgUserMessage(const vector<IExtendedSocket*>& sockets, int type, const string& senderName, const string& text, int whisperType)
+{
+	CSendPacket* msg = CreateBroadcastPacket(PacketId::UMsg);
+	BuildUMsgUserMessage(msg, type, senderName, text, whisperType);
+	SendBroadcastPacket(sockets, msg);
+}
+
 unsigned char rawData4[1290] = {
 	0x41, 0xE3, 0x27, 0x01, 0x68, 0x74, 0x74, 0x70, 0x3A, 0x2F, 0x2F, 0x77,
 	0x77, 0x77, 0x2E, 0x63, 0x73, 0x6E, 0x73, 0x74, 0x75, 0x64, 0x69, 0x6F,
@@ -803,109 +918,38 @@ void CPacketManager::SendOptionUnk3(IExtendedSocket* socket)
 
 void CPacketManager::SendMetadataMaplist(IExtendedSocket* socket)
 {
-	if (!m_pMapListZip)
-		return;
-
-	CSendPacket* msg = CreatePacket(socket, PacketId::Metadata);
-	msg->BuildHeader();
-
-	msg->WriteUInt8(kPacket_Metadata_MapList);
-
-	msg->WriteUInt16(m_pMapListZip->GetBufSize());
-	msg->WriteData(m_pMapListZip->GetBuf(), m_pMapListZip->GetBufSize());
-
-	socket->Send(msg);
+	SendMetadataFrame(socket, m_pMapListZip);
 }
 
 void CPacketManager::SendMetadataClientTable(IExtendedSocket* socket)
 {
-	if (!m_pClientTableZip)
-		return;
-
-	CSendPacket* msg = CreatePacket(socket, PacketId::Metadata);
-	msg->BuildHeader();
-
-	msg->WriteUInt8(kPacket_Metadata_ClientTable);
-
-	msg->WriteUInt16(m_pClientTableZip->GetBufSize());
-	msg->WriteData(m_pClientTableZip->GetBuf(), m_pClientTableZip->GetBufSize());
-
-	socket->Send(msg);
+	SendMetadataFrame(socket, m_pClientTableZip);
 }
 
 void CPacketManager::SendMetadataWeaponParts(IExtendedSocket* socket)
 {
-	if (!m_pWeaponPartsZip)
-		return;
-
-	CSendPacket* msg = CreatePacket(socket, PacketId::Metadata);
-	msg->BuildHeader();
-
-	msg->WriteUInt8(kPacket_Metadata_WeaponParts);
-
-	msg->WriteUInt16(m_pWeaponPartsZip->GetBufSize());
-	msg->WriteData(m_pWeaponPartsZip->GetBuf(), m_pWeaponPartsZip->GetBufSize());
-
-	socket->Send(msg);
+	SendMetadataFrame(socket, m_pWeaponPartsZip);
 }
 
 // unused
 void CPacketManager::SendMetadataModelist(IExtendedSocket* socket)
 {
-	CSendPacket* msg = CreatePacket(socket, PacketId::Metadata);
-	msg->BuildHeader();
-
-	msg->WriteUInt8(kPacket_Metadata_ModeList);
-	msg->WriteUInt16(sizeof(metaData2)); // size
-
-	msg->WriteData(metaData2, sizeof(metaData2));
-
-	socket->Send(msg);
+	SendMetadataFrame(socket, m_pModeList);
 }
 
 void CPacketManager::SendMetadataMatchOption(IExtendedSocket* socket)
 {
-	if (!m_pMatchingZip)
-		return;
-
-	CSendPacket* msg = CreatePacket(socket, PacketId::Metadata);
-	msg->BuildHeader();
-
-	msg->WriteUInt8(kPacket_Metadata_MatchOption);
-
-	msg->WriteUInt16(m_pMatchingZip->GetBufSize());
-	msg->WriteData(m_pMatchingZip->GetBuf(), m_pMatchingZip->GetBufSize());
-
-	socket->Send(msg);
+	SendMetadataFrame(socket, m_pMatchingZip);
 }
 
 void CPacketManager::SendMetadataProgressUnlock(IExtendedSocket* socket)
 {
-	if (!m_pProgressUnlockZip)
-		return;
-
-	CSendPacket* msg = CreatePacket(socket, PacketId::Metadata);
-	msg->BuildHeader();
-
-	msg->WriteUInt8(kPacket_Metadata_ProgressUnlock); // progress_unlock.csv
-
-	msg->WriteUInt16(m_pProgressUnlockZip->GetBufSize());
-	msg->WriteData(m_pProgressUnlockZip->GetBuf(), m_pProgressUnlockZip->GetBufSize());
-
-	socket->Send(msg);
+	SendMetadataFrame(socket, m_pProgressUnlockZip);
 }
 
 void CPacketManager::SendMetadataUnk8(IExtendedSocket* socket)
 {
-	if (!m_pUnk8)
-		return;
-
-	CSendPacket* msg = CreatePacket(socket, PacketId::Metadata);
-	msg->BuildHeader();
-
-	msg->WriteData(m_pUnk8->GetBuf(), m_pUnk8->GetBufSize());
-
-	socket->Send(msg);
+	SendMetadataFrame(socket, m_pUnk8);
 }
 
 void CPacketManager::SendMetadataWeaponPaints(IExtendedSocket* socket, std::vector<WeaponPaint>& weaponPaints)
@@ -932,15 +976,7 @@ void CPacketManager::SendMetadataWeaponPaints(IExtendedSocket* socket, std::vect
 
 void CPacketManager::SendMetadataUnk3(IExtendedSocket* socket)
 {
-	if (!m_pUnk3)
-		return;
-
-	CSendPacket* msg = CreatePacket(socket, PacketId::Metadata);
-	msg->BuildHeader();
-
-	msg->WriteData(m_pUnk3->GetBuf(), m_pUnk3->GetBufSize());
-
-	socket->Send(msg);
+	SendMetadataFrame(socket, m_pUnk3);
 }
 
 void CPacketManager::SendMetadataItemBox(IExtendedSocket* socket, const vector<ItemBoxItem>& items)
@@ -980,102 +1016,37 @@ void CPacketManager::SendMetadataItemBox(IExtendedSocket* socket, const vector<I
 
 void CPacketManager::SendMetadataEncyclopedia(IExtendedSocket* socket)
 {
-	CSendPacket* msg = CreatePacket(socket, PacketId::Metadata);
-	msg->BuildHeader();
-
-	msg->WriteData(metaData_Encyclopedia, sizeof(metaData_Encyclopedia));
-
-	socket->Send(msg);
+	SendMetadataFrame(socket, m_pEncyclopedia);
 }
 
 void CPacketManager::SendMetadataGameModeList(IExtendedSocket* socket)
 {
-	if (!m_pGameModeListZip)
-		return;
-
-	CSendPacket* msg = CreatePacket(socket, PacketId::Metadata);
-	msg->BuildHeader();
-
-	msg->WriteUInt8(kPacket_Metadata_GameModeList);
-
-	msg->WriteUInt16(m_pGameModeListZip->GetBufSize());
-	msg->WriteData(m_pGameModeListZip->GetBuf(), m_pGameModeListZip->GetBufSize());
-
-	socket->Send(msg);
+	SendMetadataFrame(socket, m_pGameModeListZip);
 }
 
 void CPacketManager::SendMetadataReinforceMaxLvl(IExtendedSocket* socket)
 {
-	if (!m_pReinforceMaxLvlZip)
-		return;
-
-	CSendPacket* msg = CreatePacket(socket, PacketId::Metadata);
-	msg->BuildHeader();
-
-	msg->WriteUInt8(kPacket_Metadata_ReinforceMaxLvl);
-
-	msg->WriteUInt16(m_pReinforceMaxLvlZip->GetBufSize());
-	msg->WriteData(m_pReinforceMaxLvlZip->GetBuf(), m_pReinforceMaxLvlZip->GetBufSize());
-
-	socket->Send(msg);
+	SendMetadataFrame(socket, m_pReinforceMaxLvlZip);
 }
 
 void CPacketManager::SendMetadataReinforceMaxEXP(IExtendedSocket* socket)
 {
-	if (!m_pReinforceMaxExpZip)
-		return;
-
-	CSendPacket* msg = CreatePacket(socket, PacketId::Metadata);
-	msg->BuildHeader();
-
-	msg->WriteUInt8(kPacket_Metadata_ReinforceMaxEXP);
-
-	msg->WriteUInt16(m_pReinforceMaxExpZip->GetBufSize());
-	msg->WriteData(m_pReinforceMaxExpZip->GetBuf(), m_pReinforceMaxExpZip->GetBufSize());
-
-	socket->Send(msg);
+	SendMetadataFrame(socket, m_pReinforceMaxExpZip);
 }
 
 void CPacketManager::SendMetadataReinforceItemsExp(IExtendedSocket* socket)
 {
-	if (!m_pReinforceItemsExp)
-		return;
-
-	CSendPacket* msg = CreatePacket(socket, PacketId::Metadata);
-	msg->BuildHeader();
-
-	msg->WriteData(m_pReinforceItemsExp->GetBuf(), m_pReinforceItemsExp->GetBufSize());
-
-	socket->Send(msg);
+	SendMetadataFrame(socket, m_pReinforceItemsExp);
 }
 
 void CPacketManager::SendMetadataItemExpireTime(IExtendedSocket* socket)
 {
-	if (!m_pItemExpireTimeZip)
-		return;
-
-	CSendPacket* msg = CreatePacket(socket, PacketId::Metadata);
-	msg->BuildHeader();
-
-	msg->WriteUInt8(kPacket_Metadata_ItemExpireTime);
-
-	msg->WriteUInt16(m_pItemExpireTimeZip->GetBufSize());
-	msg->WriteData(m_pItemExpireTimeZip->GetBuf(), m_pItemExpireTimeZip->GetBufSize());
-
-	socket->Send(msg);
+	SendMetadataFrame(socket, m_pItemExpireTimeZip);
 }
 
 void CPacketManager::SendMetadataUnk20(IExtendedSocket* socket)
 {
-	if (!m_pUnk20)
-		return;
-
-	CSendPacket* msg = CreatePacket(socket, PacketId::Metadata);
-	msg->BuildHeader();
-
-	msg->WriteData(m_pUnk20->GetBuf(), m_pUnk20->GetBufSize());
-
-	socket->Send(msg);
+	SendMetadataFrame(socket, m_pUnk20);
 }
 
 void CPacketManager::SendMetadataZombieWarWeaponList(IExtendedSocket* socket, std::vector<int>& zombieWarWeapons)
@@ -1129,291 +1100,97 @@ void CPacketManager::SendMetadataHash(IExtendedSocket* socket)
 
 void CPacketManager::SendMetadataUnk31(IExtendedSocket* socket)
 {
-	if (!m_pUnk31)
-		return;
-
-	CSendPacket* msg = CreatePacket(socket, PacketId::Metadata);
-	msg->BuildHeader();
-
-	msg->WriteData(m_pUnk31->GetBuf(), m_pUnk31->GetBufSize());
-
-	socket->Send(msg);
+	SendMetadataFrame(socket, m_pUnk31);
 }
 
 void CPacketManager::SendMetadataHonorMoneyShop(IExtendedSocket* socket)
 {
-	if (!m_pHonorMoneyShopZip)
-		return;
-
-	CSendPacket* msg = CreatePacket(socket, PacketId::Metadata);
-	msg->BuildHeader();
-
-	msg->WriteUInt8(kPacket_Metadata_HonorMoneyShop);
-
-	msg->WriteUInt16(m_pHonorMoneyShopZip->GetBufSize());
-	msg->WriteData(m_pHonorMoneyShopZip->GetBuf(), m_pHonorMoneyShopZip->GetBufSize());
-
-	socket->Send(msg);
+	SendMetadataFrame(socket, m_pHonorMoneyShopZip);
 }
 
 void CPacketManager::SendMetadataScenarioTX_Common(IExtendedSocket* socket)
 {
-	if (!m_pScenarioTX_CommonZip)
-		return;
-
-	CSendPacket* msg = CreatePacket(socket, PacketId::Metadata);
-	msg->BuildHeader();
-
-	msg->WriteUInt8(kPacket_Metadata_ScenarioTX_Common);
-
-	msg->WriteUInt16(m_pScenarioTX_CommonZip->GetBufSize());
-	msg->WriteData(m_pScenarioTX_CommonZip->GetBuf(), m_pScenarioTX_CommonZip->GetBufSize());
-
-	socket->Send(msg);
+	SendMetadataFrame(socket, m_pScenarioTX_CommonZip);
 }
 
 void CPacketManager::SendMetadataScenarioTX_Dedi(IExtendedSocket* socket)
 {
-	if (!m_pScenarioTX_DediZip)
-		return;
-
-	CSendPacket* msg = CreatePacket(socket, PacketId::Metadata);
-	msg->BuildHeader();
-
-	msg->WriteUInt8(kPacket_Metadata_ScenarioTX_Dedi);
-
-	msg->WriteUInt16(m_pScenarioTX_DediZip->GetBufSize());
-	msg->WriteData(m_pScenarioTX_DediZip->GetBuf(), m_pScenarioTX_DediZip->GetBufSize());
-
-	socket->Send(msg);
+	SendMetadataFrame(socket, m_pScenarioTX_DediZip);
 }
 
 void CPacketManager::SendMetadataShopItemList_Dedi(IExtendedSocket* socket)
 {
-	if (!m_pShopItemList_DediZip)
-		return;
-
-	CSendPacket* msg = CreatePacket(socket, PacketId::Metadata);
-	msg->BuildHeader();
-
-	msg->WriteUInt8(kPacket_Metadata_ShopItemList_Dedi);
-
-	msg->WriteUInt16(m_pShopItemList_DediZip->GetBufSize());
-	msg->WriteData(m_pShopItemList_DediZip->GetBuf(), m_pShopItemList_DediZip->GetBufSize());
-
-	socket->Send(msg);
+	SendMetadataFrame(socket, m_pShopItemList_DediZip);
 }
 
 void CPacketManager::SendMetadataZBCompetitive(IExtendedSocket* socket)
 {
-	if (!m_pZBCompetitiveZip)
-		return;
-
-	CSendPacket* msg = CreatePacket(socket, PacketId::Metadata);
-	msg->BuildHeader();
-
-	msg->WriteUInt8(kPacket_Metadata_ZBCompetitive);
-
-	msg->WriteUInt16(m_pZBCompetitiveZip->GetBufSize());
-	msg->WriteData(m_pZBCompetitiveZip->GetBuf(), m_pZBCompetitiveZip->GetBufSize());
-
-	socket->Send(msg);
+	SendMetadataFrame(socket, m_pZBCompetitiveZip);
 }
 
 void CPacketManager::SendMetadataUnk43(IExtendedSocket* socket)
 {
-	if (!m_pUnk43)
-		return;
-
-	CSendPacket* msg = CreatePacket(socket, PacketId::Metadata);
-	msg->BuildHeader();
-
-	msg->WriteData(m_pUnk43->GetBuf(), m_pUnk43->GetBufSize());
-
-	socket->Send(msg);
+	SendMetadataFrame(socket, m_pUnk43);
 }
 
 void CPacketManager::SendMetadataUnk49(IExtendedSocket* socket)
 {
-	if (!m_pUnk49)
-		return;
-
-	CSendPacket* msg = CreatePacket(socket, PacketId::Metadata);
-	msg->BuildHeader();
-
-	msg->WriteData(m_pUnk49->GetBuf(), m_pUnk49->GetBufSize());
-
-	socket->Send(msg);
+	SendMetadataFrame(socket, m_pUnk49);
 }
 
 void CPacketManager::SendMetadataWeaponProp(IExtendedSocket* socket)
 {
-	if (!m_pWeaponPropZip)
-		return;
-
-	CSendPacket* msg = CreatePacket(socket, PacketId::Metadata);
-	msg->BuildHeader();
-
-	msg->WriteUInt8(kPacket_Metadata_WeaponProp);
-
-	msg->WriteUInt16(m_pWeaponPropZip->GetBufSize());
-	msg->WriteData(m_pWeaponPropZip->GetBuf(), m_pWeaponPropZip->GetBufSize());
-
-	socket->Send(msg);
+	SendMetadataFrame(socket, m_pWeaponPropZip);
 }
 
 void CPacketManager::SendMetadataPPSystem(IExtendedSocket* socket)
 {
-	if (!m_pPPSystemZip)
-		return;
-
-	CSendPacket* msg = CreatePacket(socket, PacketId::Metadata);
-	msg->BuildHeader();
-
-	msg->WriteUInt8(kPacket_Metadata_PPSystem);
-
-	msg->WriteUInt16(m_pPPSystemZip->GetBufSize());
-	msg->WriteData(m_pPPSystemZip->GetBuf(), m_pPPSystemZip->GetBufSize());
-
-	socket->Send(msg);
+	SendMetadataFrame(socket, m_pPPSystemZip);
 }
 
 void CPacketManager::SendMetadataCodisData(IExtendedSocket* socket)
 {
-	if (!m_pCodisDataZip)
-		return;
-
-	CSendPacket* msg = CreatePacket(socket, PacketId::Metadata);
-	msg->BuildHeader();
-
-	msg->WriteUInt8(kPacket_Metadata_CodisData);
-
-	msg->WriteUInt16(m_pCodisDataZip->GetBufSize());
-	msg->WriteData(m_pCodisDataZip->GetBuf(), m_pCodisDataZip->GetBufSize());
-
-	socket->Send(msg);
+	SendMetadataFrame(socket, m_pCodisDataZip);
 }
 
 void CPacketManager::SendMetadataItem(IExtendedSocket* socket)
 {
-	if (!m_pItemZip)
-		return;
-
-	CSendPacket* msg = CreatePacket(socket, PacketId::Metadata);
-	msg->BuildHeader();
-
-	msg->WriteUInt8(kPacket_Metadata_Item);
-
-	msg->WriteUInt16(m_pItemZip->GetBufSize());
-	msg->WriteData(m_pItemZip->GetBuf(), m_pItemZip->GetBufSize());
-
-	socket->Send(msg);
+	SendMetadataFrame(socket, m_pItemZip);
 }
 
 void CPacketManager::SendMetadataModeEvent(IExtendedSocket* socket)
 {
-	if (!m_pModeEventZip)
-		return;
-
-	CSendPacket* msg = CreatePacket(socket, PacketId::Metadata);
-	msg->BuildHeader();
-
-	msg->WriteUInt8(kPacket_Metadata_ModeEvent);
-
-	msg->WriteUInt16(m_pModeEventZip->GetBufSize());
-	msg->WriteData(m_pModeEventZip->GetBuf(), m_pModeEventZip->GetBufSize());
-
-	socket->Send(msg);
+	SendMetadataFrame(socket, m_pModeEventZip);
 }
 
 void CPacketManager::SendMetadataMileageShop(IExtendedSocket* socket)
 {
-	if (!m_pMileageShopZip)
-		return;
-
-	CSendPacket* msg = CreatePacket(socket, PacketId::Metadata);
-	msg->BuildHeader();
-
-	msg->WriteUInt8(kPacket_Metadata_MileageShop);
-
-	msg->WriteUInt16(m_pMileageShopZip->GetBufSize());
-	msg->WriteData(m_pMileageShopZip->GetBuf(), m_pMileageShopZip->GetBufSize());
-
-	socket->Send(msg);
+	SendMetadataFrame(socket, m_pMileageShopZip);
 }
 
 void CPacketManager::SendMetadataEventShop(IExtendedSocket* socket)
 {
-	if (!m_pEventShopZip)
-		return;
-
-	CSendPacket* msg = CreatePacket(socket, PacketId::Metadata);
-	msg->BuildHeader();
-
-	msg->WriteUInt8(kPacket_Metadata_EventShop);
-
-	msg->WriteUInt16(m_pEventShopZip->GetBufSize());
-	msg->WriteData(m_pEventShopZip->GetBuf(), m_pEventShopZip->GetBufSize());
-
-	socket->Send(msg);
+	SendMetadataFrame(socket, m_pEventShopZip);
 }
 
 void CPacketManager::SendMetadataFamilyTotalWarMap(IExtendedSocket* socket)
 {
-	if (!m_pFamilyTotalWarMapZip)
-		return;
-
-	CSendPacket* msg = CreatePacket(socket, PacketId::Metadata);
-	msg->BuildHeader();
-
-	msg->WriteUInt8(kPacket_Metadata_FamilyTotalWarMap);
-
-	msg->WriteUInt16(m_pFamilyTotalWarMapZip->GetBufSize());
-	msg->WriteData(m_pFamilyTotalWarMapZip->GetBuf(), m_pFamilyTotalWarMapZip->GetBufSize());
-
-	socket->Send(msg);
+	SendMetadataFrame(socket, m_pFamilyTotalWarMapZip);
 }
 
 void CPacketManager::SendMetadataFamilyTotalWar(IExtendedSocket* socket)
 {
-	if (!m_pFamilyTotalWarZip)
-		return;
-
-	CSendPacket* msg = CreatePacket(socket, PacketId::Metadata);
-	msg->BuildHeader();
-
-	msg->WriteUInt8(kPacket_Metadata_FamilyTotalWar);
-
-	msg->WriteUInt16(m_pFamilyTotalWarZip->GetBufSize());
-	msg->WriteData(m_pFamilyTotalWarZip->GetBuf(), m_pFamilyTotalWarZip->GetBufSize());
-
-	socket->Send(msg);
+	SendMetadataFrame(socket, m_pFamilyTotalWarZip);
 }
 
 void CPacketManager::SendMetadataUnk54(IExtendedSocket* socket)
 {
-	if (!m_pUnk54)
-		return;
-
-	CSendPacket* msg = CreatePacket(socket, PacketId::Metadata);
-	msg->BuildHeader();
-
-	msg->WriteData(m_pUnk54->GetBuf(), m_pUnk54->GetBufSize());
-
-	socket->Send(msg);
+	SendMetadataFrame(socket, m_pUnk54);
 }
 
 void CPacketManager::SendMetadataUnk55(IExtendedSocket* socket)
 {
-	if (!m_pUnk55)
-		return;
-
-	CSendPacket* msg = CreatePacket(socket, PacketId::Metadata);
-	msg->BuildHeader();
-
-	msg->WriteData(m_pUnk55->GetBuf(), m_pUnk55->GetBufSize());
-
-	socket->Send(msg);
+	SendMetadataFrame(socket, m_pUnk55);
 }
 
 void CPacketManager::SendGameMatchInfo(IExtendedSocket* socket)
@@ -1760,11 +1537,8 @@ void CPacketManager::SendLobbyJoin(IExtendedSocket* socket, CChannel* channel)
 	socket->Send(msg);
 }
 
-void CPacketManager::SendLobbyUserJoin(IExtendedSocket* socket, IUser* joinedUser)
+void BuildLobbyUserJoin(CSendPacket* msg, IUser* joinedUser)
 {
-	CSendPacket* msg = CreatePacket(socket, PacketId::Lobby);
-	msg->BuildHeader();
-
 	msg->WriteUInt8(LobbyPacketType::UserJoin);
 	msg->WriteUInt32(joinedUser->GetID()); // userid
 	msg->WriteString("TIBE YEBAT'?");
@@ -1773,21 +1547,44 @@ void CPacketManager::SendLobbyUserJoin(IExtendedSocket* socket, IUser* joinedUse
 
 	CPacketHelper_FullUserInfo fullUserInfo;
 	fullUserInfo.Build(msg->m_OutStream, joinedUser->GetID(), character);
-
-	socket->Send(msg);
 }
 
-void CPacketManager::SendLobbyUserLeft(IExtendedSocket* socket, IUser* user)
+void CPacketManager::SendLobbyUserJoin(IExtendedSocket* socket, IUser* joinedUser)
 {
 	CSendPacket* msg = CreatePacket(socket, PacketId::Lobby);
 	msg->BuildHeader();
+	BuildLobbyUserJoin(msg, joinedUser);
+	socket->Send(msg);
+}
 
+void CPacketManager::SendLobbyUserJoin(const vector<IExtendedSocket*>& sockets, IUser* joinedUser)
+{
+	CSendPacket* msg = CreateBroadcastPacket(PacketId::Lobby);
+	BuildLobbyUserJoin(msg, joinedUser);
+	SendBroadcastPacket(sockets, msg);
+}
+
+void BuildLobbyUserLeft(CSendPacket* msg, int userID)
+{
 	msg->WriteUInt8(LobbyPacketType::UserLeft);
-	msg->WriteUInt32(user->GetID());
+	msg->WriteUInt32(userID);
+}
 
+void CPacketManager::SendLobbyUserLeft(IExtendedSocket* socket, IUser* user)
+{
+	CSendPacket* msg = CreatePacket(socket, PacketId::Lobby);
+	msg->BuildHeader();
+	BuildLobbyUserLeft(msg, user->GetID());
 	socket->Send(msg);
 }
 
+void CPacketManager::SendLobbyUserLeft(const vector<IExtendedSocket*>& sockets, int userID)
+{
+	CSendPacket* msg = CreateBroadcastPacket(PacketId::Lobby);
+	BuildLobbyUserLeft(msg, userID);
+	SendBroadcastPacket(sockets, msg);
+}
+
 void BuildRoomInfo(CSendPacket* msg, IRoom* room, int lFlag, int hFlag)
 {
 	msg->WriteUInt8(0);
@@ -1975,11 +1772,8 @@ void BuildRoomInfo(CSendPacket* msg, IRoom* room, int lFlag, int hFlag)
 	}
 }
 
-void CPacketManager::SendRoomListFull(IExtendedSocket* socket, const vector<IRoom*>& rooms)
+void BuildRoomListFull(CSendPacket* msg, const vector<IRoom*>& rooms)
 {
-	CSendPacket* msg = CreatePacket(socket, PacketId::GameMatchRoomList);
-	msg->BuildHeader();
-
 	msg->WriteUInt8(RoomListPacketType::FullRoomList);
 	msg->WriteUInt8(4);
 	msg->WriteUInt16(0xFFFF);
@@ -1995,46 +1789,91 @@ void CPacketManager::SendRoomListFull(IExtendedSocket* socket, const vector<IRoo
 	{
 		BuildRoomInfo(msg, room, RLFLAG_ALL, RLHFLAG_ALL);
 	}
+}
 
+void CPacketManager::SendRoomListFull(IExtendedSocket* socket, const vector<IRoom*>& rooms)
+{
+	CSendPacket* msg = CreatePacket(socket, PacketId::GameMatchRoomList);
+	msg->BuildHeader();
+	BuildRoomListFull(msg, rooms);
 	socket->Send(msg);
 }
 
-void CPacketManager::SendRoomListAdd(IExtendedSocket* socket, IRoom* room)
+void CPacketManager::SendRoomListFull(const vector<IExtendedSocket*>& sockets, const vector<IRoom*>& rooms)
 {
-	/*CSendPacket* msg = CreatePacket(socket, PacketId::GameMatchRoomList);
-	msg->BuildHeader();
+	CSendPacket* msg = CreateBroadcastPacket(PacketId::GameMatchRoomList);
+	BuildRoomListFull(msg, rooms);
+	SendBroadcastPacket(sockets, msg);
+}
 
+void BuildRoomListAdd(CSendPacket* msg, IRoom* room)
+{
 	msg->WriteUInt8(RoomListPacketType::AddRoom);
 
-	BuildRoomInfo(msg, room);
+	BuildRoomInfo(msg, room, RLFLAG_ALL, RLHFLAG_ALL);
+}
 
+void CPacketManager::SendRoomListAdd(IExtendedSocket* socket, IRoom* room)
+{
+	CSendPacket* msg = CreatePacket(socket, PacketId::GameMatchRoomList);
+	msg->BuildHeader();
+	BuildRoomListAdd(msg, room);
 	socket->Send(msg);
-*/
 }
 
-void CPacketManager::SendRoomListUpdate(IExtendedSocket* socket, IRoom* room)
+void CPacketManager::SendRoomListAdd(const vector<IExtendedSocket*>& sockets, IRoom* room)
 {
-	/*CSendPacket* msg = CreatePacket(socket, PacketId::GameMatchRoomList);
-	msg->BuildHeader();
+	CSendPacket* msg = CreateBroadcastPacket(PacketId::GameMatchRoomList);
+	BuildRoomListAdd(msg, room);
+	SendBroadcastPacket(sockets, msg);
+}
 
+void BuildRoomListUpdate(CSendPacket* msg, IRoom* room, int lFlag, int hFlag)
+{
 	msg->WriteUInt8(RoomListPacketType::UpdateRoom);
 
-	BuildRoomInfo(msg, room);
+	BuildRoomInfo(msg, room, lFlag, hFlag);
+}
 
+void CPacketManager::SendRoomListUpdate(IExtendedSocket* socket, IRoom* room, int lFlag, int hFlag)
+{
+	CSendPacket* msg = CreatePacket(socket, PacketId::GameMatchRoomList);
+	msg->BuildHeader();
+	BuildRoomListUpdate(msg, room, lFlag, hFlag);
 	socket->Send(msg);
-*/
 }
 
-void CPacketManager::SendRoomListRemove(IExtendedSocket* socket, int roomID)
+/**
+ * Sends changed fields of the room to the lobby
+ * @param lFlag RLFLAG_* fields to write
+ * @param hFlag RLHFLAG_* fields to write
+ */
+void CPacketManager::SendRoomListUpdate(const vector<IExtendedSocket*>& sockets, IRoom* room, int lFlag, int hFlag)
 {
-	/*CSendPacket* msg = CreatePacket(socket, PacketId::GameMatchRoomList);
-	msg->BuildHeader();
+	CSendPacket* msg = CreateBroadcastPacket(PacketId::GameMatchRoomList);
+	BuildRoomListUpdate(msg, room, lFlag, hFlag);
+	SendBroadcastPacket(sockets, msg);
+}
 
+void BuildRoomListRemove(CSendPacket* msg, int roomID)
+{
 	msg->WriteUInt8(RoomListPacketType::RemoveRoom);
 	msg->WriteUInt16(roomID);
+}
 
+void CPacketManager::SendRoomListRemove(IExtendedSocket* socket, int roomID)
+{
+	CSendPacket* msg = CreatePacket(socket, PacketId::GameMatchRoomList);
+	msg->BuildHeader();
+	BuildRoomListRemove(msg, roomID);
 	socket->Send(msg);
-*/
+}
+
+void CPacketManager::SendRoomListRemove(const vector<IExtendedSocket*>& sockets, int roomID)
+{
+	CSendPacket* msg = CreateBroadcastPacket(PacketId::GameMatchRoomList);
+	BuildRoomListRemove(msg, roomID);
+	SendBroadcastPacket(sockets, msg);
 }
 
 void CPacketManager::SendShopUpdate(IExtendedSocket* socket, const vector<Product>& products)
@@ -2210,18 +2049,29 @@ void CPacketManager::SendSearchRoomNotice(IExtendedSocket* socket, IRoom* room,
 	socket->Send(msg);
 }
 
-void CPacketManager::SendUserUpdateInfo(IExtendedSocket* socket, IUser* user, const CUserCharacter& character)
+void BuildUserUpdateInfo(CSendPacket* msg, IUser* user, const CUserCharacter& character)
 {
-	CSendPacket* msg = CreatePacket(socket, PacketId::UserUpdateInfo);
-	msg->BuildHeader();
 	msg->WriteUInt32(user->GetID());
 
 	CPacketHelper_FullUserInfo fullUserInfo;
 	fullUserInfo.Build(msg->m_OutStream, user->GetID(), character);
+}
 
+void CPacketManager::SendUserUpdateInfo(IExtendedSocket* socket, IUser* user, const CUserCharacter& character)
+{
+	CSendPacket* msg = CreatePacket(socket, PacketId::UserUpdateInfo);
+	msg->BuildHeader();
+	BuildUserUpdateInfo(msg, user, character);
 	socket->Send(msg);
 }
 
+void CPacketManager::SendUserUpdateInfo(const vector<IExtendedSocket*>& sockets, IUser* user, const CUserCharacter& character)
+{
+	CSendPacket* msg = CreateBroadcastPacket(PacketId::UserUpdateInfo);
+	BuildUserUpdateInfo(msg, user, character);
+	SendBroadcastPacket(sockets, msg);
+}
+
 void CPacketManager::SendUserSurvey(IExtendedSocket* socket, const Survey& survey)
 {
 	CSendPacket* msg = CreatePacket(socket, PacketId::UserSurvey);
@@ -2767,18 +2617,28 @@ void CPacketManager::SendRoomPlayerJoin(IExtendedSocket* socket, IUser* user, Ro
 	socket->Send(msg);
 }
 
-void CPacketManager::SendRoomUpdateSettings(IExtendedSocket* socket, CRoomSettings* newSettings, int low, int lowMid, int highMid, int high)
+void BuildRoomUpdateSettings(CSendPacket* msg, CRoomSettings* newSettings, int low, int lowMid, int highMid, int high)
 {
-	CSendPacket* msg = CreatePacket(socket, PacketId::Room);
-	msg->BuildHeader();
-
 	msg->WriteUInt8(OutRoomType::UpdateSettings);
 
 	WriteSettings(msg, newSettings, low, lowMid, highMid, high);
+}
 
+void CPacketManager::SendRoomUpdateSettings(IExtendedSocket* socket, CRoomSettings* newSettings, int low, int lowMid, int highMid, int high)
+{
+	CSendPacket* msg = CreatePacket(socket, PacketId::Room);
+	msg->BuildHeader();
+	BuildRoomUpdateSettings(msg, newSettings, low, lowMid, highMid, high);
 	socket->Send(msg);
 }
 
+void CPacketManager::SendRoomUpdateSettings(const vector<IExtendedSocket*>& sockets, CRoomSettings* newSettings, int low, int lowMid, int highMid, int high)
+{
+	CSendPacket* msg = CreateBroadcastPacket(PacketId::Room);
+	BuildRoomUpdateSettings(msg, newSettings, low, lowMid, highMid, high);
+	SendBroadcastPacket(sockets, msg);
+}
+
 void CPacketManager::SendRoomSetUserTeam(IExtendedSocket* socket, IUser* user, int teamNum)
 {
 	CSendPacket* msg = CreatePacket(socket, PacketId::Room);
@@ -2805,29 +2665,49 @@ void CPacketManager::SendRoomSetPlayerReady(IExtendedSocket* socket, IUser* user
 	socket->Send(msg);
 }
 
-void CPacketManager::SendRoomSetHost(IExtendedSocket* socket, IUser* user)
+void BuildRoomSetHost(CSendPacket* msg, IUser* user)
 {
-	CSendPacket* msg = CreatePacket(socket, PacketId::Room);
-	msg->BuildHeader();
-
 	msg->WriteUInt8(OutRoomType::SetHost);
 	msg->WriteUInt32(user->GetID());
 	msg->WriteUInt8(1);
-
-	socket->Send(msg);
 }
 
-void CPacketManager::SendRoomPlayerLeave(IExtendedSocket* socket, int userId)
+void CPacketManager::SendRoomSetHost(IExtendedSocket* socket, IUser* user)
 {
 	CSendPacket* msg = CreatePacket(socket, PacketId::Room);
 	msg->BuildHeader();
+	BuildRoomSetHost(msg, user);
+	socket->Send(msg);
+}
+
+void CPacketManager::SendRoomSetHost(const vector<IExtendedSocket*>& sockets, IUser* user)
+{
+	CSendPacket* msg = CreateBroadcastPacket(PacketId::Room);
+	BuildRoomSetHost(msg, user);
+	SendBroadcastPacket(sockets, msg);
+}
 
+void BuildRoomPlayerLeave(CSendPacket* msg, int userId)
+{
 	msg->WriteUInt8(OutRoomType::PlayerLeave);
 	msg->WriteUInt32(userId);
+}
 
+void CPacketManager::SendRoomPlayerLeave(IExtendedSocket* socket, int userId)
+{
+	CSendPacket* msg = CreatePacket(socket, PacketId::Room);
+	msg->BuildHeader();
+	BuildRoomPlayerLeave(msg, userId);
 	socket->Send(msg);
 }
 
+void CPacketManager::SendRoomPlayerLeave(const vector<IExtendedSocket*>& sockets, int userId)
+{
+	CSendPacket* msg = CreateBroadcastPacket(PacketId::Room);
+	BuildRoomPlayerLeave(msg, userId);
+	SendBroadcastPacket(sockets, msg);
+}
+
 void CPacketManager::SendRoomPlayerLeaveIngame(IExtendedSocket* socket)
 {
 	CSendPacket* msg = CreatePacket(socket, PacketId::Room);
@@ -9,34 +9,42 @@
 
 struct Notice_s;
 
+/**
+ * Metadata frame body, encoded once when metadata is loaded. Packets of all users share it,
+ * the body is never modified so packets queued before reload can still use the old one
+ */
 class CBinMetadata
 {
 public:
-	CBinMetadata(void* buf, size_t bufsize)
+	/**
+	 * Constructor
+	 * @param buf Metadata
+	 * @param bufsize Metadata size
+	 * @param type Metadata type, the body is prefixed with the type and size. -1 to use metadata as is
+	 */
+	CBinMetadata(const void* buf, size_t bufsize, int type = -1)
 	{
-		m_pBuf = buf;
-		m_nBufsize = bufsize;
+		m_pFrameBody = std::make_shared<std::vector<unsigned char>>();
+		m_pFrameBody->reserve(bufsize + 3);
+
+		if (type >= 0)
+		{
+			m_pFrameBody->push_back((unsigned char)type);
+			m_pFrameBody->push_back((unsigned char)(bufsize & 0xFF));
+			m_pFrameBody->push_back((unsigned char)((bufsize >> 8) & 0xFF));
+		}
+
+		const unsigned char* data = (const unsigned char*)buf;
+		m_pFrameBody->insert(m_pFrameBody->end(), data, data + bufsize);
 	}
 
-	~CBinMetadata()
+	const std::shared_ptr<std::vector<unsigned char>>& GetFrameBody()
 	{
-		if (m_pBuf)
-			free(m_pBuf);
-	}
-
-	void* GetBuf()
-	{
-		return m_pBuf;
-	}
-
-	size_t GetBufSize()
-	{
-		return m_nBufsize;
+		return m_pFrameBody;
 	}
 
 private:
-	void* m_pBuf;
-	size_t m_nBufsize;
+	std::shared_ptr<std::vector<unsigned char>> m_pFrameBody;
 };
 
 class CPacketManager : public CBaseManager<IPacketManager>
@@ -49,11 +57,16 @@ public:
 	virtual void Shutdown();
 
 	CSendPacket* CreatePacket(IExtendedSocket* socket, int msgID);
+	CSendPacket* CreateBroadcastPacket(int msgID);
+	void SendBroadcastPacket(const std::vector<IExtendedSocket*>& sockets, CSendPacket* body);
 
 	void SendUMsgNoticeMsgBoxToUuid(IExtendedSocket* socket, const std::string& text);
+	void SendUMsgNoticeMsgBoxToUuid(const std::vector<IExtendedSocket*>& sockets, const std::string& text);
 	void SendUMsgNoticeMessageInChat(IExtendedSocket* socket, const std::string& text);
+	void SendUMsgNoticeMessageInChat(const std::vector<IExtendedSocket*>& sockets, const std::string& text);
 	void SendUMsgSystemReply(IExtendedSocket* socket, int type, const std::string& msg, const std::vector<std::string>& additionalText = {});
 	void SendUMsgUserMessage(IExtendedSocket* socket, int type, const std::string& senderName, const std::string& text, int whisperType = 0);
+	void SendUMsgUserMessage(const std::vector<IExtendedSocket*>& sockets, int type, const std::string& senderName, const std::string& text, int whisperType = 0);
 	void SendUMsgNotice(IExtendedSocket* socket, const Notice_s& notice, bool unk = 1);
 	void SendUMsgExpiryNotice(IExtendedSocket* socket, const std::vector<int>& expiryItems);
 	void SendUMsgRewardNotice(IExtendedSocket* socket, const RewardNotice& reward, std::string title = "", std::string description = "", bool localized = false, bool inGame = false, bool scen = false);
@@ -72,6 +85,7 @@ public:
 
 	void SendUserStart(IExtendedSocket* socket, int userID, const std::string& userName, const std::string& gameName, bool firstConnect);
 	void SendUserUpdateInfo(IExtendedSocket* socket, IUser* user, const CUserCharacter& character);
+	void SendUserUpdateInfo(const std::vector<IExtendedSocket*>& sockets, IUser* user, const CUserCharacter& character);
 	void SendUserSurvey(IExtendedSocket* socket, const Survey& survey);
 	void SendUserSurveyReply(IExtendedSocket* socket, int result);
 
@@ -141,12 +155,18 @@ public:
 
 	void SendLobbyJoin(IExtendedSocket* socket, CChannel* channel);
 	void SendLobbyUserJoin(IExtendedSocket* socket, IUser* joinedUser);
+	void SendLobbyUserJoin(const std::vector<IExtendedSocket*>& sockets, IUser* joinedUser);
 	void SendLobbyUserLeft(IExtendedSocket* socket, IUser* user);
+	void SendLobbyUserLeft(const std::vector<IExtendedSocket*>& sockets, int userID);
 
 	void SendRoomListFull(IExtendedSocket* socket, const std::vector<IRoom*>& rooms);
+	void SendRoomListFull(const std::vector<IExtendedSocket*>& sockets, const std::vector<IRoom*>& rooms);
 	void SendRoomListAdd(IExtendedSocket* socket, IRoom* room);
-	void SendRoomListUpdate(IExtendedSocket* socket, IRoom* room);
+	void SendRoomListAdd(const std::vector<IExtendedSocket*>& sockets, IRoom* room);
+	void SendRoomListUpdate(IExtendedSocket* socket, IRoom* room, int lFlag = RLFLAG_ALL, int hFlag = RLHFLAG_ALL);
+	void SendRoomListUpdate(const std::vector<IExtendedSocket*>& sockets, IRoom* room, int lFlag, int hFlag);
 	void SendRoomListRemove(IExtendedSocket* socket, int roomID);
+	void SendRoomListRemove(const std::vector<IExtendedSocket*>& sockets, int roomID);
 
 	void SendShopUpdate(IExtendedSocket* socket, const std::vector<Product>& products);
 	void SendShopBuyProductReply(IExtendedSocket* socket, int replyCode);
@@ -159,10 +179,13 @@ public:
 	void SendRoomCreateAndJoin(IExtendedSocket* socket, IRoom* roomInfo);
 	void SendRoomPlayerJoin(IExtendedSocket* socket, IUser* user, RoomTeamNum num);
 	void SendRoomUpdateSettings(IExtendedSocket* socket, CRoomSettings* newSettings, int low = 0, int lowMid = 0, int highMid = 0, int high = 0);
+	void SendRoomUpdateSettings(const std::vector<IExtendedSocket*>& sockets, CRoomSettings* newSettings, int low = 0, int lowMid = 0, int highMid = 0, int high = 0);
 	void SendRoomSetUserTeam(IExtendedSocket* socket, IUser* user, int teamNum);
 	void SendRoomSetPlayerReady(IExtendedSocket* socket, IUser* user, RoomReadyStatus readyStatus);
 	void SendRoomSetHost(IExtendedSocket* socket, IUser* user);
+	void SendRoomSetHost(const std::vector<IExtendedSocket*>& sockets, IUser* user);
 	void SendRoomPlayerLeave(IExtendedSocket* socket, int userId);
+	void SendRoomPlayerLeave(const std::vector<IExtendedSocket*>& sockets, int userId);
 	void SendRoomPlayerLeaveIngame(IExtendedSocket* socket);
 	void SendRoomInviteUserList(IExtendedSocket* socket, IUser* user);
 	void SendRoomGameResult(IExtendedSocket* socket, IRoom* room, CGameMatch* match);
@@ -286,7 +309,8 @@ public:
 	void SendVoxelUnk58(IExtendedSocket* socket);
 
 private:
-	CBinMetadata* LoadBinaryMetadata(const char* fileName, bool zip = false);
+	CBinMetadata* LoadBinaryMetadata(const char* fileName, int zipType = -1);
+	void SendMetadataFrame(IExtendedSocket* socket, CBinMetadata* metadata);
 
 	CBinMetadata* m_pMapListZip;
 	CBinMetadata* m_pClientTableZip;
@@ -320,6 +344,8 @@ private:
 	CBinMetadata* m_pFamilyTotalWarZip;
 	CBinMetadata* m_pUnk54;
 	CBinMetadata* m_pUnk55;
+	CBinMetadata* m_pModeList;
+	CBinMetadata* m_pEncyclopedia;
 };
 
 extern CPacketManager g_PacketManager;
\ No newline at end of file
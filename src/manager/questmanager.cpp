@@ -225,6 +225,14 @@ void CQuestManager::OnPacket(CReceivePacket* msg, IExtendedSocket* socket)
 	if (user == NULL)
 		return;
 
+	// daily/weekly reset changed progress since the last quest list
+	if (m_OutdatedQuestUsers.erase(user->GetID()))
+	{
+		vector<UserQuestProgress> progress;
+		g_UserDatabase.GetQuestsProgress(user->GetID(), progress);
+		g_PacketManager.SendQuests(socket, user->GetID(), m_Quests, progress, 0xFFFF, 0xFFFF, 0, 0);
+	}
+
 	int requestID = msg->ReadUInt8();
 	switch (requestID)
 	{
@@ -422,12 +430,25 @@ void CQuestManager::OnGameMatchLeave(IUser* user, vector<UserQuestProgress>& que
 
 void CQuestManager::OnUserLogin(IUser* user)
 {
+	// the quest list is sent with the login
+	m_OutdatedQuestUsers.erase(user->GetID());
+
 	for (auto quest : m_EventQuests)
 	{
 		quest->OnUserLogin(user);
 	}
 }
 
+// called after daily/weekly reset of a batch of users, online users get the quest list again with their next quest request
+void CQuestManager::OnQuestsReset(const vector<int>& userIDs)
+{
+	for (int userID : userIDs)
+	{
+		if (g_UserManager.GetUserById(userID))
+			m_OutdatedQuestUsers.insert(userID);
+	}
+}
+
 void CQuestManager::OnQuestTaskFinished(IUser* user, UserQuestTaskProgress& taskProgress, CQuestTask* task, CQuest* quest)
 {
 	if (!quest->IsAllTaskFinished(user))
@@ -9,6 +9,8 @@
 
 #include "nlohmann/json.hpp"
 
+#include <unordered_set>
+
 class CQuestManager : public CBaseManager<IQuestManager>
 {
 public:
@@ -45,6 +47,7 @@ public:
 	void OnMatchEndEvent(CGameMatchUserStat* userStat, CGameMatch* gameMatch, int userTeam);
 	void OnGameMatchLeave(IUser* user, std::vector<UserQuestProgress>& questProgress, std::vector<UserQuestProgress>& questsEventsProgress);
 	void OnUserLogin(IUser* user);
+	void OnQuestsReset(const std::vector<int>& userIDs);
 
 	void OnQuestTaskFinished(IUser* user, UserQuestTaskProgress& taskProgress, CQuestTask* task, CQuest* quest);
 	void OnQuestEventTaskFinished(IUser* user, UserQuestTaskProgress& taskProgress, CQuestEventTask* task, CQuestEvent* quest);
@@ -66,6 +69,7 @@ private:
 	std::vector<CQuest*> m_Quests;
 	std::vector<CQuestEvent*> m_EventQuests;
 	std::vector<CQuest*> m_ClanQuests;
+	std::unordered_set<int> m_OutdatedQuestUsers; // online users whose progress was reset after they got the quest list
 };
 
 extern CQuestManager g_QuestManager;
\ No newline at end of file
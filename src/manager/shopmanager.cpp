@@ -2,6 +2,9 @@
 #include "packetmanager.h"
 #include "usermanager.h"
 #include "itemmanager.h"
+#include "userdatabase.h"
+#include "userdatabaseasync.h"
+#include "user/user.h"
 #include "nlohmann/json.hpp"
 #include "keyvalues.hpp"
 
@@ -270,7 +273,7 @@ void CShopManager::OnShopPacket(CReceivePacket* msg, IExtendedSocket* socket)
 	switch (type)
 	{
 	case ShopPacketType::RequestBuyProduct:
-		BuyProduct(user, msg->ReadUInt8(), msg->ReadUInt8());
+		RequestBuyProduct(user, msg->ReadUInt8(), msg->ReadUInt8());
 		break;
 	}
 }
@@ -291,6 +294,52 @@ void CShopManager::GetProductBySubId(int productId, Product& product, SubProduct
 	}
 }
 
+/**
+ * Starts purchase. If the character and inventory of the user aren't in memory yet (new character, cache invalidated by a command),
+ * they are read on the database thread and the purchase is made on the event thread after that
+ */
+void CShopManager::RequestBuyProduct(IUser* user, int productTypeId, int productId)
+{
+	if (user->IsCacheLoaded())
+	{
+		BuyProduct(user, productTypeId, productId);
+		return;
+	}
+
+	int userID = user->GetID();
+	unsigned int socketID = user->GetExtendedSocket()->GetID();
+
+	g_UserDatabaseAsync.Execute([userID]()
+	{
+		pair<bool, UserCache_s> result;
+		result.first = CUser::ReadCache(userID, result.second);
+		return result;
+	},
+	[this, userID, socketID, productTypeId, productId](const pair<bool, UserCache_s>& result)
+	{
+		IUser* user = g_UserManager.GetUserById(userID);
+		if (!user)
+			return;
+
+		// request of the previous session
+		if (user->GetExtendedSocket()->GetID() != socketID)
+			return;
+
+		if (!result.first)
+		{
+			g_PacketManager.SendShopBuyProductReply(user->GetExtendedSocket(), ShopBuyProductReply::BUY_FAIL_SYSTEM_ERROR);
+			return;
+		}
+
+		user->ApplyCache(result.second);
+
+		BuyProduct(user, productTypeId, productId);
+	});
+}
+
+/**
+ * Makes purchase. Works on the character and inventory caches, so it doesn't query the database if the cache is loaded
+ */
 bool CShopManager::BuyProduct(IUser* user, int productTypeId, int productId)
 {
 	Product product = {};
@@ -16,6 +16,7 @@ public:
 
 	void OnShopPacket(CReceivePacket* msg, IExtendedSocket* socket);
 	void GetProductBySubId(int productId, Product& product, SubProduct& subProduct);
+	void RequestBuyProduct(IUser* user, int productTypeId, int productId);
 	bool BuyProduct(IUser* user, int productTypeId, int productId);
 	
 	const std::vector<Product>& GetProducts();
@@ -6,6 +6,9 @@ using namespace std;
 
 CUserDatabaseProxy g_UserDatabase;
 
+// methods are called by the event and database threads
+static thread_local chrono::high_resolution_clock::time_point s_StartTime;
+
 CUserDatabaseProxy::CUserDatabaseProxy() : CBaseManager("UserDatabase")
 {
 	m_pDatabase = NULL;
@@ -18,10 +21,18 @@ bool CUserDatabaseProxy::Init()
 	return m_pDatabase != NULL;
 }
 
-int CUserDatabaseProxy::Login(const string& userName, const string& password, IExtendedSocket* socket, UserBan& ban, UserRestoreData* restoreData)
+int CUserDatabaseProxy::Login(const string& userName, const string& password, UserBan& ban, UserRestoreData* restoreData)
+{
+	ExecCalcStart();
+	int result = m_pDatabase->Login(userName, password, ban, restoreData);
+	ExecCalcEnd(__FUNCTION__);
+	return result;
+}
+
+int CUserDatabaseProxy::CreateSession(int userID, const string& ip, const vector<unsigned char>& hwid)
 {
 	ExecCalcStart();
-	int result = m_pDatabase->Login(userName, password, socket, ban, restoreData);
+	int result = m_pDatabase->CreateSession(userID, ip, hwid);
 	ExecCalcEnd(__FUNCTION__);
 	return result;
 }
@@ -162,6 +173,44 @@ int CUserDatabaseProxy::IsInventoryFull(int userID)
 	return result;
 }
 
+int CUserDatabaseProxy::ReadInventory(int userID, vector<CUserInventoryItem>& items, int& nextSlot, unsigned int& version)
+{
+	ExecCalcStart();
+	int result = m_pDatabase->ReadInventory(userID, items, nextSlot, version);
+	ExecCalcEnd(__FUNCTION__);
+	return result;
+}
+
+int CUserDatabaseProxy::CacheInventory(int userID, const vector<CUserInventoryItem>& items, int nextSlot, unsigned int version)
+{
+	ExecCalcStart();
+	int result = m_pDatabase->CacheInventory(userID, items, nextSlot, version);
+	ExecCalcEnd(__FUNCTION__);
+	return result;
+}
+
+int CUserDatabaseProxy::FlushInventory(int userID)
+{
+	ExecCalcStart();
+	int result = m_pDatabase->FlushInventory(userID);
+	ExecCalcEnd(__FUNCTION__);
+	return result;
+}
+
+void CUserDatabaseProxy::OnInventoryFlushed(int userID, bool committed)
+{
+	ExecCalcStart();
+	m_pDatabase->OnInventoryFlushed(userID, committed);
+	ExecCalcEnd(__FUNCTION__);
+}
+
+void CUserDatabaseProxy::UnloadInventory(int userID)
+{
+	ExecCalcStart();
+	m_pDatabase->UnloadInventory(userID);
+	ExecCalcEnd(__FUNCTION__);
+}
+
 int CUserDatabaseProxy::GetUserData(int userID, CUserData& data)
 {
 	ExecCalcStart();
@@ -834,10 +883,10 @@ int CUserDatabaseProxy::IsClanWithMarkExists(int markID)
 	return result;
 }
 
-int CUserDatabaseProxy::ClanInvite(int userID, const string& gameName, IUser*& destUser, int& clanID)
+int CUserDatabaseProxy::ClanInvite(int userID, int destUserID, int& clanID)
 {
 	ExecCalcStart();
-	int result = m_pDatabase->ClanInvite(userID, gameName, destUser, clanID);
+	int result = m_pDatabase->ClanInvite(userID, destUserID, clanID);
 	ExecCalcEnd(__FUNCTION__);
 	return result;
 }
@@ -1023,6 +1072,42 @@ void CUserDatabaseProxy::ResetQuestEvent(int questID)
 	ExecCalcEnd(__FUNCTION__);
 }
 
+void CUserDatabaseProxy::RecordStatements(bool record)
+{
+	ExecCalcStart();
+	m_pDatabase->RecordStatements(record);
+	ExecCalcEnd(__FUNCTION__);
+}
+
+int CUserDatabaseProxy::AuditQueryPlans()
+{
+	ExecCalcStart();
+	int result = m_pDatabase->AuditQueryPlans();
+	ExecCalcEnd(__FUNCTION__);
+	return result;
+}
+
+void CUserDatabaseProxy::PrintStatementStats(int count)
+{
+	ExecCalcStart();
+	m_pDatabase->PrintStatementStats(count);
+	ExecCalcEnd(__FUNCTION__);
+}
+
+void CUserDatabaseProxy::StartBackup()
+{
+	ExecCalcStart();
+	m_pDatabase->StartBackup();
+	ExecCalcEnd(__FUNCTION__);
+}
+
+void CUserDatabaseProxy::PrintBackupList()
+{
+	ExecCalcStart();
+	m_pDatabase->PrintBackupList();
+	ExecCalcEnd(__FUNCTION__);
+}
+
 void CUserDatabaseProxy::CreateTransaction()
 {
 	ExecCalcStart();
@@ -1040,15 +1125,17 @@ bool CUserDatabaseProxy::CommitTransaction()
 
 void CUserDatabaseProxy::ExecCalcStart()
 {
-	m_StartTime = chrono::high_resolution_clock::now();
+	s_StartTime = chrono::high_resolution_clock::now();
 }
 
 void CUserDatabaseProxy::ExecCalcEnd(const string& funcName)
 {
 	auto end = chrono::high_resolution_clock::now();
-	auto duration = chrono::duration_cast<chrono::milliseconds>(end - m_StartTime).count();
+	auto duration = chrono::duration_cast<chrono::milliseconds>(end - s_StartTime).count();
 
-	if (duration > 0)
+	// the database is profiled by g_UserDatabaseProfiler, log only slow calls here
+	int slowThreshold = g_UserDatabaseProfiler.GetSlowThreshold();
+	if (slowThreshold && duration >= slowThreshold)
 		Logger().Warn(OBFUSCATE("%s: %d ms\n"), funcName.c_str(), duration);
 }
 #endif
\ No newline at end of file
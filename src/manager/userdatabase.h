@@ -35,7 +35,8 @@ public:
 
 	virtual bool Init();
 
-	virtual int Login(const std::string& userName, const std::string& password, IExtendedSocket* socket, UserBan& ban, UserRestoreData* restoreData);
+	virtual int Login(const std::string& userName, const std::string& password, UserBan& ban, UserRestoreData* restoreData);
+	virtual int CreateSession(int userID, const std::string& ip, const std::vector<unsigned char>& hwid);
 	virtual int AddToRestoreList(int userID, int channelServerID, int channelID);
 	virtual int Register(const std::string& userName, const std::string& password, const std::string& ip);
 	virtual int GetUserSessions(std::vector<UserSession>& sessions);
@@ -55,6 +56,11 @@ public:
 	virtual int GetFirstExtendableItemByItemID(int userID, int itemID, CUserInventoryItem& item);
 	virtual int GetInventoryItemsCount(int userID);
 	virtual int IsInventoryFull(int userID);
+	virtual int ReadInventory(int userID, std::vector<CUserInventoryItem>& items, int& nextSlot, unsigned int& version);
+	virtual int CacheInventory(int userID, const std::vector<CUserInventoryItem>& items, int nextSlot, unsigned int version);
+	virtual int FlushInventory(int userID);
+	virtual void OnInventoryFlushed(int userID, bool committed);
+	virtual void UnloadInventory(int userID);
 	virtual int GetUserData(int userID, CUserData& data);
 	virtual int UpdateUserData(int userID, CUserData data);
 	virtual int CreateCharacter(int userID, const std::string& gameName);
@@ -146,7 +152,7 @@ public:
 	virtual int ClanRejectAll(int userID);
 	virtual int ClanApprove(int userID, const std::string& userName);
 	virtual int IsClanWithMarkExists(int markID);
-	virtual int ClanInvite(int userID, const std::string& gameName, IUser*& destUser, int& clanID);
+	virtual int ClanInvite(int userID, int destUserID, int& clanID);
 	virtual int ClanKick(int userID, const std::string& userName);
 	virtual int ClanMasterDelegate(int userID, const std::string& userName);
 	virtual int IsClanExists(const std::string& clanName);
@@ -182,6 +188,13 @@ public:
 
 	virtual void ResetQuestEvent(int questID);
 
+	virtual void RecordStatements(bool record);
+	virtual int AuditQueryPlans();
+	virtual void PrintStatementStats(int count);
+
+	virtual void StartBackup();
+	virtual void PrintBackupList();
+
 	virtual void CreateTransaction();
 	virtual bool CommitTransaction();
 
@@ -189,8 +202,6 @@ private:
 	void ExecCalcStart();
 	void ExecCalcEnd(const std::string& funcName);
 
-	std::chrono::high_resolution_clock::time_point m_StartTime;
-
 	// pointer to the real database
 	IUserDatabase* m_pDatabase;
 };
@@ -5,25 +5,43 @@
 #include "packetmanager.h"
 #include "itemmanager.h"
 #include "questmanager.h"
+#include "userdatabaseasync.h"
 
 #include "common/utils.h"
 
 #include "user/userfastbuy.h"
 #include "user/userinventoryitem.h"
+#include "user/userinventory.h"
+
+#include <sqlite3.h>
 #ifdef WIN32
 #include <direct.h>
 #else
 #include <sys/stat.h>
+#include <dirent.h>
+#include <fnmatch.h>
 #endif
 
+#include <chrono>
+
 using namespace std;
 
-#define LAST_DB_VERSION 4
+#define LAST_DB_VERSION 8
+#define MAX_RECORDED_STATEMENTS 4096
 
 //#define OBFUSCATE(data) (string)AY_OBFUSCATE_KEY(data, 'F')
 #undef OBFUSCATE
 #define OBFUSCATE(data) (char*)AY_OBFUSCATE_KEY(data, 'F')
 
+// gets statement from the cache by call site, the statement is prepared on first use
+#define CACHED_STATEMENT(sql) GetStatement(__COUNTER__, OBFUSCATE(sql))
+// the same for statements of read-only connection
+#define READ_STATEMENT(connection, sql) connection.GetStatement(__COUNTER__, OBFUSCATE(sql))
+
+// profiles the rest of the method, the site is named after the method
+#define PROFILE_DB() PROFILE_SCOPE(g_UserDatabaseProfiler, __FUNCTION__)
+
+CProfiler g_UserDatabaseProfiler("UserDatabase");
 CUserDatabaseSQLite g_UserDatabase;
 
 CUserDatabaseSQLite::CUserDatabaseSQLite()
@@ -31,6 +49,20 @@ try : CBaseManager(REAL_DATABASE_NAME, true, true), m_Database(OBFUSCATE("UserDa
 {
 	m_bInited = false;
 	m_pTransaction = NULL;
+	m_nInventoryVersion = 0;
+	m_pCheckpointDatabase = NULL;
+	m_bWAL = false;
+	m_pAsyncDatabase = NULL;
+	m_pBackupSource = NULL;
+	m_pBackupDest = NULL;
+	m_pBackup = NULL;
+	m_BackupStartTime = 0;
+	m_nBackupProgress = 0;
+	m_bBackupRunning = false;
+	m_bBackupStepQueued = false;
+	m_nQuestResetFlags = 0;
+	m_nQuestResetUserID = 0;
+	m_bQuestResetStepQueued = false;
 }
 catch (exception& e)
 {
@@ -39,15 +71,38 @@ catch (exception& e)
 
 CUserDatabaseSQLite::~CUserDatabaseSQLite()
 {
+	ClearStatementCache();
+	CloseReadConnections();
+
+	// the database thread is already stopped
+	if (m_pBackup)
+		EndBackup(false);
+
+	for (auto& cached : m_AsyncStatements)
+		delete cached.second.statement;
+
+	for (auto& cached : m_AsyncQueryStatements)
+		delete cached.second.statement;
+
+	delete m_pAsyncDatabase;
+	delete m_pCheckpointDatabase;
 }
 
 bool CUserDatabaseSQLite::Init()
 {
+	lock_guard<recursive_mutex> lock(m_Mutex);
+
 	if (!m_bInited)
 	{
-		// set synchronous to OFF to speed up db execution
-		m_Database.exec(OBFUSCATE("PRAGMA synchronous=OFF"));
-		m_Database.exec(OBFUSCATE("PRAGMA foreign_keys=ON"));
+		// WAL lets readers work while the main connection writes, with synchronous=NORMAL commits don't wait for fsync,
+		// a crash can lose the last transactions but doesn't corrupt the database.
+		// Checkpoints are made by OnMinuteTick on the database thread, not by commits on the event thread
+		string journalMode = m_Database.execAndGet(OBFUSCATE("PRAGMA journal_mode=WAL")).getString();
+		m_bWAL = journalMode == OBFUSCATE("wal");
+		if (!m_bWAL)
+			Logger().Warn(OBFUSCATE("CUserDatabaseSQLite::Init: failed to enable WAL (journal mode: %s), heavy reads will use the main connection\n"), journalMode.c_str());
+
+		ConfigureConnection(m_Database);
 
 		if (!CheckForTables())
 			return false;
@@ -56,12 +111,91 @@ bool CUserDatabaseSQLite::Init()
 
 		ExecuteOnce();
 
+		LoadExpiryTimers(time(NULL) / 60);
+
+		LoadIPBanList();
+
+		// resume quest reset interrupted by shutdown or crash
+		{
+			CCachedStatement query = CACHED_STATEMENT("SELECT resetFlags, resetUserID FROM TimeConfig LIMIT 1");
+			if (query->executeStep())
+			{
+				m_nQuestResetFlags = (int)query->getColumn(0);
+				m_nQuestResetUserID = query->getColumn(1);
+				m_QuestResetStartTime = chrono::steady_clock::now();
+
+				if (m_nQuestResetFlags)
+					Logger().Info(OBFUSCATE("CUserDatabaseSQLite::Init: resuming quest reset (flags: %d) after userID %d\n"), (int)m_nQuestResetFlags, m_nQuestResetUserID);
+			}
+		}
+
+		AuditQueryPlans();
+
+		OpenAsyncConnection();
+
+		if (m_bWAL)
+			OpenReadConnections();
+
 		m_bInited = true;
 	}
 
 	return true;
 }
 
+// applies per-connection settings, the journal mode is kept in the database file
+void CUserDatabaseSQLite::ConfigureConnection(SQLite::Database& database)
+{
+	if (m_bWAL)
+	{
+		database.exec(OBFUSCATE("PRAGMA synchronous=NORMAL"));
+		database.exec(OBFUSCATE("PRAGMA wal_autocheckpoint=0"));
+		database.exec(va(OBFUSCATE("PRAGMA journal_size_limit=%d"), DB_WAL_SIZE_LIMIT));
+	}
+	else
+	{
+		database.exec(OBFUSCATE("PRAGMA synchronous=FULL"));
+	}
+	database.exec(OBFUSCATE("PRAGMA foreign_keys=ON"));
+
+	// the other write connection holds the write lock for one transaction at most
+	database.setBusyTimeout(DB_BUSY_TIMEOUT);
+}
+
+// opens connection of the database thread
+void CUserDatabaseSQLite::OpenAsyncConnection()
+{
+	try
+	{
+		m_pAsyncDatabase = new SQLite::Database(OBFUSCATE("UserDatabase.db3"), SQLite::OPEN_READWRITE);
+		ConfigureConnection(*m_pAsyncDatabase);
+	}
+	catch (exception& e)
+	{
+		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::OpenAsyncConnection: failed to open connection: %s, the database thread will use the main connection\n"), e.what());
+
+		delete m_pAsyncDatabase;
+		m_pAsyncDatabase = NULL;
+	}
+}
+
+// gets connection of the calling thread
+SQLite::Database& CUserDatabaseSQLite::GetDatabase()
+{
+	if (m_pAsyncDatabase && g_UserDatabaseAsync.IsDatabaseThread())
+		return *m_pAsyncDatabase;
+
+	return m_Database;
+}
+
+// gets mutex of the calling thread's connection
+recursive_mutex& CUserDatabaseSQLite::GetMutex()
+{
+	if (m_pAsyncDatabase && g_UserDatabaseAsync.IsDatabaseThread())
+		return m_AsyncMutex;
+
+	return m_Mutex;
+}
+
 // check if tables we need exist, if not create them
 bool CUserDatabaseSQLite::CheckForTables()
 {
@@ -118,6 +252,9 @@ bool CUserDatabaseSQLite::UpgradeDatabase(int& currentDatabaseVer)
 	{
 		m_Database.exec(va(OBFUSCATE("PRAGMA user_version = %d"), LAST_DB_VERSION));
 		currentDatabaseVer = LAST_DB_VERSION;
+
+		// statements prepared for the old schema
+		ClearStatementCache();
 	}
 
 	return true;
@@ -127,6 +264,8 @@ bool CUserDatabaseSQLite::UpgradeDatabase(int& currentDatabaseVer)
 // returns 1 on success, 0 on failure
 bool CUserDatabaseSQLite::ExecuteScript(string scriptPath)
 {
+	lock_guard<recursive_mutex> lock(m_Mutex);
+
 	FILE* file = fopen(scriptPath.c_str(), OBFUSCATE("rb"));
 	if (!file)
 		return false;
@@ -159,7 +298,7 @@ bool CUserDatabaseSQLite::ExecuteScript(string scriptPath)
 			return false;
 		}
 
-		SQLite::Transaction transaction(m_Database);
+		CWriteTransaction transaction(m_Database);
 
 		char* token = strtok(buffer, OBFUSCATE(";"));
 		while (token)
@@ -168,7 +307,7 @@ bool CUserDatabaseSQLite::ExecuteScript(string scriptPath)
 			token = strtok(NULL, OBFUSCATE(";"));
 		}
 
-		transaction.commit();
+		transaction.Commit();
 	}
 	catch (exception& e)
 	{
@@ -245,38 +384,41 @@ bool CUserDatabaseSQLite::ExecuteOnce()
 	return true;
 }
 
-// creates a new session for user
-// returns > 0 == userID, 0 == database error, -1 == no such user or not in restore list, -2 == user already logged in, -4 == user banned
-int CUserDatabaseSQLite::Login(const string& userName, const string& password, IExtendedSocket* socket, UserBan& ban, UserRestoreData* restoreData)
+// checks user credentials and ban, takes restore data if transferring server. The session is created by CreateSession
+// returns > 0 == userID, 0 == database error, -1 == no such user or not in restore list, -4 == user banned
+int CUserDatabaseSQLite::Login(const string& userName, const string& password, UserBan& ban, UserRestoreData* restoreData)
 {
+	PROFILE_DB();
+	lock_guard<recursive_mutex> lock(GetMutex());
+
 	try
 	{
 		int userID = 0;
 		if (restoreData)
 		{
 			// get userID if transferring server
-			SQLite::Statement queryGetUser(m_Database, OBFUSCATE("SELECT userID FROM User WHERE userName = ? LIMIT 1"));
-			queryGetUser.bind(1, userName);
+			CCachedStatement queryGetUser = CACHED_STATEMENT("SELECT userID FROM User WHERE userName = ? LIMIT 1");
+			queryGetUser->bind(1, userName);
 
-			if (!queryGetUser.executeStep())
+			if (!queryGetUser->executeStep())
 			{
 				return LOGIN_NO_SUCH_USER;
 			}
 
-			userID = queryGetUser.getColumn(0);
+			userID = queryGetUser->getColumn(0);
 		}
 		else
 		{
-			SQLite::Statement queryGetUser(m_Database, OBFUSCATE("SELECT userID FROM User WHERE userName = ? AND password = ? LIMIT 1"));
-			queryGetUser.bind(1, userName);
-			queryGetUser.bind(2, password);
+			CCachedStatement queryGetUser = CACHED_STATEMENT("SELECT userID FROM User WHERE userName = ? AND password = ? LIMIT 1");
+			queryGetUser->bind(1, userName);
+			queryGetUser->bind(2, password);
 
-			if (!queryGetUser.executeStep())
+			if (!queryGetUser->executeStep())
 			{
 				return LOGIN_NO_SUCH_USER;
 			}
 
-			userID = queryGetUser.getColumn(0);
+			userID = queryGetUser->getColumn(0);
 		}
 
 		GetUserBan(userID, ban);
@@ -285,80 +427,88 @@ int CUserDatabaseSQLite::Login(const string& userName, const string& password, I
 			return LOGIN_USER_BANNED;
 		}
 
-		// check if user present in UserSession table
-		SQLite::Statement queryGetUserSession(m_Database, OBFUSCATE("SELECT userID FROM UserSession WHERE userID = ? LIMIT 1"));
-		queryGetUserSession.bind(1, userID);
-		if (queryGetUserSession.executeStep())
-		{
-			IUser* user = g_UserManager.GetUserById(userID);
-			if (user)
-			{
-				g_UserManager.DisconnectUser(user);
-			}
-			else
-			{
-				DropSession(userID);
-			}
-		}
-
 		if (restoreData)
 		{
-			SQLite::Statement query(m_Database, OBFUSCATE("SELECT channelServerID, channelID FROM UserRestore WHERE userID = ? LIMIT 1"));
-			query.bind(1, userID);
+			CCachedStatement query = CACHED_STATEMENT("SELECT channelServerID, channelID FROM UserRestore WHERE userID = ? LIMIT 1");
+			query->bind(1, userID);
 
-			if (!query.executeStep())
+			if (!query->executeStep())
 			{
 				return LOGIN_NO_SUCH_USER;
 			}
 
-			restoreData->channelServerID = query.getColumn(0);
-			restoreData->channelID = query.getColumn(1);
+			restoreData->channelServerID = query->getColumn(0);
+			restoreData->channelID = query->getColumn(1);
 
 			{
-				SQLite::Statement query(m_Database, OBFUSCATE("DELETE FROM UserRestore WHERE userID = ?"));
-				query.bind(1, userName);
-				query.exec();
+				CCachedStatement query = CACHED_STATEMENT("DELETE FROM UserRestore WHERE userID = ?");
+				query->bind(1, userName);
+				query->exec();
 			}
 		}
 
-		// create user session in db
-		SQLite::Statement queryInsertUserSession(m_Database, OBFUSCATE("INSERT INTO UserSession VALUES (?, ?, ?, ?, ?, ?)"));
-		queryInsertUserSession.bind(1, userID);
-		queryInsertUserSession.bind(2, socket->GetIP());
-		queryInsertUserSession.bind(3, ""); // TODO: remove
-		queryInsertUserSession.bind(4, socket->GetHWID().data(), socket->GetHWID().size());
-		queryInsertUserSession.bind(5, UserStatus::STATUS_MENU);
-		queryInsertUserSession.bind(6, 0);
-		queryInsertUserSession.exec();
-
 		return userID;
 	}
 	catch (exception& e)
 	{
-		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::Login: database internal error: %s, %d\n"), e.what(), m_Database.getErrorCode());
+		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::Login: database internal error: %s, %d\n"), e.what(), GetDatabase().getErrorCode());
+		return 0;
+	}
+}
+
+// creates a new session for user, replaces the session left by the previous login. Online user with the same ID must be disconnected before
+// returns 1 on success, 0 on database error
+int CUserDatabaseSQLite::CreateSession(int userID, const string& ip, const vector<unsigned char>& hwid)
+{
+	PROFILE_DB();
+	lock_guard<recursive_mutex> lock(GetMutex());
+
+	try
+	{
+		DropSession(userID);
+
+		// session time is counted from loginTime, the login can run on the database thread, so the server time isn't used
+		CCachedStatement queryInsertUserSession = CACHED_STATEMENT("INSERT INTO UserSession (userID, ip, uuid, hwid, status, sessionTime, loginTime) VALUES (?, ?, ?, ?, ?, ?, ?)");
+		queryInsertUserSession->bind(1, userID);
+		queryInsertUserSession->bind(2, ip);
+		queryInsertUserSession->bind(3, ""); // TODO: remove
+		queryInsertUserSession->bind(4, hwid.data(), hwid.size());
+		queryInsertUserSession->bind(5, UserStatus::STATUS_MENU);
+		queryInsertUserSession->bind(6, 0);
+		queryInsertUserSession->bind(7, time(NULL) / 60);
+		queryInsertUserSession->exec();
+	}
+	catch (exception& e)
+	{
+		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::CreateSession: database internal error: %s, %d\n"), e.what(), GetDatabase().getErrorCode());
 		return 0;
 	}
+
+	return 1;
 }
 
 int CUserDatabaseSQLite::AddToRestoreList(int userID, int channelServerID, int channelID)
 {
+	PROFILE_DB();
+	lock_guard<recursive_mutex> lock(GetMutex());
+
 	try
 	{
 		{
-			SQLite::Statement query(m_Database, OBFUSCATE("DELETE FROM UserRestore WHERE userID = ?"));
-			query.bind(1, userID);
-			query.exec();
+			CCachedStatement query = CACHED_STATEMENT("DELETE FROM UserRestore WHERE userID = ?");
+			query->bind(1, userID);
+			query->exec();
 		}
 
-		SQLite::Statement query(m_Database, OBFUSCATE("INSERT INTO UserRestore VALUES (?, ?, ?)"));
-		query.bind(1, userID);
-		query.bind(2, channelServerID);
-		query.bind(3, channelID);
-		query.exec();
+		CCachedStatement query = CACHED_STATEMENT("INSERT INTO UserRestore VALUES (?, ?, ?)");
+		query->bind(1, userID);
+		query->bind(2, channelServerID);
+		query->bind(3, channelID);
+		query->exec();
 	}
 	catch (exception& e)
 	{
-		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::AddToRestoreList: database internal error: %s, %d\n"), e.what(), m_Database.getErrorCode());
+		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::AddToRestoreList: database internal error: %s, %d\n"), e.what(), GetDatabase().getErrorCode());
 		return 0;
 	}
 
@@ -369,45 +519,48 @@ int CUserDatabaseSQLite::AddToRestoreList(int userID, int channelServerID, int c
 // returns 0 == database error, 1 on success, -1 == user with the same username already exists, -4 == ip limit
 int CUserDatabaseSQLite::Register(const string& userName, const string& password, const string& ip)
 {
+	PROFILE_DB();
+	lock_guard<recursive_mutex> lock(GetMutex());
+
 	try
 	{
-		SQLite::Statement queryuser(m_Database, OBFUSCATE("SELECT userID FROM User WHERE userName = ? LIMIT 1"));
-		queryuser.bind(1, userName);
-		queryuser.executeStep();
+		CCachedStatement queryuser = CACHED_STATEMENT("SELECT userID FROM User WHERE userName = ? LIMIT 1");
+		queryuser->bind(1, userName);
+		queryuser->executeStep();
 
-		if (queryuser.hasRow())
+		if (queryuser->hasRow())
 		{
-			queryuser.reset();
+			queryuser->reset();
 
 			return -1;
 		}
 
 		// check registrations per IP limit
 		{
-			SQLite::Statement query(m_Database, OBFUSCATE("SELECT COUNT(1) FROM User WHERE registerIP = ?"));
-			query.bind(1, ip);
-			if (query.executeStep() && (int)query.getColumn(0) >= g_pServerConfig->maxRegistrationsPerIP)
+			CCachedStatement query = CACHED_STATEMENT("SELECT COUNT(1) FROM User WHERE registerIP = ?");
+			query->bind(1, ip);
+			if (query->executeStep() && (int)query->getColumn(0) >= g_pServerConfig->maxRegistrationsPerIP)
 			{
 				return -4;
 			}
 		}
 
 
-		SQLite::Statement query(m_Database, OBFUSCATE("INSERT INTO User VALUES ((SELECT userIDNext FROM UserDist), ?, ?, ?, ?, 0, 0, 0, 0)"));
-		query.bind(1, userName);
-		query.bind(2, password);
-		query.bind(3, g_pServerInstance->GetCurrentTime());
-		query.bind(4, ip);
-		query.exec();
+		CCachedStatement query = CACHED_STATEMENT("INSERT INTO User VALUES ((SELECT userIDNext FROM UserDist), ?, ?, ?, ?, 0, 0, 0, 0)");
+		query->bind(1, userName);
+		query->bind(2, password);
+		query->bind(3, g_pServerInstance->GetCurrentTime());
+		query->bind(4, ip);
+		query->exec();
 
 		{
-			SQLite::Statement query(m_Database, OBFUSCATE("UPDATE UserDist SET userIDNext = userIDNext + 1"));
-			query.exec();
+			CCachedStatement query = CACHED_STATEMENT("UPDATE UserDist SET userIDNext = userIDNext + 1");
+			query->exec();
 		}
 	}
 	catch (exception& e)
 	{
-		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::Register: database internal error: %s, %d\n"), e.what(), m_Database.getErrorCode());
+		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::Register: database internal error: %s, %d\n"), e.what(), GetDatabase().getErrorCode());
 		return 0;
 	}
 
@@ -416,31 +569,35 @@ int CUserDatabaseSQLite::Register(const string& userName, const string& password
 
 // get info about all sessions
 // returns 0 == database error, 1 on success
+// uses read-only connection, can be called by any thread
 int CUserDatabaseSQLite::GetUserSessions(std::vector<UserSession>& sessions)
 {
+	PROFILE_DB();
 	try
 	{
-		SQLite::Statement query(m_Database, "SELECT UserSession.userID, UserSession.ip, UserSession.sessionTime, User.userName, UserCharacter.gameName "
+		CReadConnection connection(*this);
+		CCachedStatement query = READ_STATEMENT(connection, "SELECT UserSession.userID, UserSession.ip, ? - UserSession.loginTime, User.userName, UserCharacter.gameName "
 			"FROM UserSession "
 			"INNER JOIN User "
 			"ON UserSession.userID = User.userID "
 			"INNER JOIN UserCharacter "
 			"ON UserSession.userID = UserCharacter.userID");
-		while (query.executeStep())
+		query->bind(1, time(NULL) / 60);
+		while (query->executeStep())
 		{
 			UserSession session;
-			session.userID = query.getColumn(0);
-			session.ip = query.getColumn(1).getString();
-			session.uptime = query.getColumn(2);
-			//session.roomID = query.getColumn(3);
-			session.userName = query.getColumn(3).getString();
-			session.gameName = query.getColumn(4).getString();
+			session.userID = query->getColumn(0);
+			session.ip = query->getColumn(1).getString();
+			session.uptime = query->getColumn(2);
+			//session.roomID = query->getColumn(3);
+			session.userName = query->getColumn(3).getString();
+			session.gameName = query->getColumn(4).getString();
 			sessions.push_back(session);
 		}
 	}
 	catch (exception& e)
 	{
-		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::GetUserSessions: database internal error: %s, %d\n"), e.what(), m_Database.getErrorCode());
+		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::GetUserSessions: database internal error: %s\n"), e.what());
 		return 0;
 	}
 
@@ -451,22 +608,26 @@ int CUserDatabaseSQLite::GetUserSessions(std::vector<UserSession>& sessions)
 // returns 0 == database error, 1 on success, -1 == user with such userID is not logged in
 int CUserDatabaseSQLite::DropSession(int userID)
 {
+	PROFILE_DB();
+	lock_guard<recursive_mutex> lock(GetMutex());
+
 	try
 	{
 		{
-			SQLite::Statement query(m_Database, OBFUSCATE("INSERT INTO UserSessionHistory SELECT UserSession.userID, UserSession.ip, UserSession.hwid, (SELECT lastLogonTime FROM User WHERE userID = UserSession.userID LIMIT 1), UserSession.sessionTime FROM UserSession WHERE UserSession.userID = ?"));
-			query.bind(1, userID);
-			query.exec();
+			CCachedStatement query = CACHED_STATEMENT("INSERT INTO UserSessionHistory SELECT UserSession.userID, UserSession.ip, UserSession.hwid, (SELECT lastLogonTime FROM User WHERE userID = UserSession.userID LIMIT 1), ? - UserSession.loginTime FROM UserSession WHERE UserSession.userID = ?");
+			query->bind(1, time(NULL) / 60);
+			query->bind(2, userID);
+			query->exec();
 		}
 		{
-			SQLite::Statement query(m_Database, OBFUSCATE("DELETE FROM UserSession WHERE userID = ?"));
-			query.bind(1, userID);
-			query.exec();
+			CCachedStatement query = CACHED_STATEMENT("DELETE FROM UserSession WHERE userID = ?");
+			query->bind(1, userID);
+			query->exec();
 		}
 	}
 	catch (exception& e)
 	{
-		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::DropSession: database internal error: %s, %d\n"), e.what(), m_Database.getErrorCode());
+		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::DropSession: database internal error: %s, %d\n"), e.what(), GetDatabase().getErrorCode());
 		return 0;
 	}
 
@@ -477,20 +638,35 @@ int CUserDatabaseSQLite::DropSession(int userID)
 // returns 0 == database error, 1 on success
 int CUserDatabaseSQLite::DropSessions()
 {
+	PROFILE_DB();
+	lock_guard<recursive_mutex> lock(GetMutex());
+
 	try
 	{
+		// sessions left by a stopped or crashed server end at the last minute tick, so the downtime isn't counted
+		time_t lastAliveTime = 0;
 		{
-			SQLite::Statement query(m_Database, OBFUSCATE("INSERT INTO UserSessionHistory SELECT UserSession.userID, UserSession.ip, UserSession.hwid, User.lastLogonTime, UserSession.sessionTime FROM UserSession, User WHERE User.userID = UserSession.userID"));
-			query.exec();
+			CCachedStatement query = CACHED_STATEMENT("SELECT lastAliveTime FROM TimeConfig LIMIT 1");
+			if (query->executeStep())
+				lastAliveTime = query->getColumn(0).getInt64();
+		}
+		if (!lastAliveTime)
+			lastAliveTime = time(NULL) / 60;
+
+		{
+			// sessions created before loginTime was added keep their counted time
+			CCachedStatement query = CACHED_STATEMENT("INSERT INTO UserSessionHistory SELECT UserSession.userID, UserSession.ip, UserSession.hwid, User.lastLogonTime, CASE WHEN UserSession.loginTime != 0 THEN MAX(?, UserSession.loginTime) - UserSession.loginTime ELSE UserSession.sessionTime END FROM UserSession, User WHERE User.userID = UserSession.userID");
+			query->bind(1, lastAliveTime);
+			query->exec();
 		}
 		{
-			SQLite::Statement query(m_Database, OBFUSCATE("DELETE FROM UserSession"));
-			query.exec();
+			CCachedStatement query = CACHED_STATEMENT("DELETE FROM UserSession");
+			query->exec();
 		}
 	}
 	catch (exception& e)
 	{
-		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::DropSessions: database internal error: %s, %d\n"), e.what(), m_Database.getErrorCode());
+		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::DropSessions: database internal error: %s, %d\n"), e.what(), GetDatabase().getErrorCode());
 		return 0;
 	}
 
@@ -499,26 +675,33 @@ int CUserDatabaseSQLite::DropSessions()
 
 void CUserDatabaseSQLite::PrintUserList()
 {
+	lock_guard<recursive_mutex> lock(GetMutex());
+
 	try
 	{
-		static SQLite::Statement query(m_Database, OBFUSCATE("SELECT userID, userName FROM User"));
+		CCachedStatement query = CACHED_STATEMENT("SELECT userID, userName FROM User");
 		cout << OBFUSCATE("Database user list:\n");
-		while (query.executeStep())
+		while (query->executeStep())
 		{
-			cout << OBFUSCATE("UserID: ") << query.getColumn(0) << OBFUSCATE(", Username: ") << query.getColumn(1) << OBFUSCATE("\n");
+			cout << OBFUSCATE("UserID: ") << query->getColumn(0) << OBFUSCATE(", Username: ") << query->getColumn(1) << OBFUSCATE("\n");
 		}
-		query.reset();
+		query->reset();
 	}
 	catch (exception& e)
 	{
-		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::PrintUserList: database internal error: %s, %d\n"), e.what(), m_Database.getErrorCode());
+		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::PrintUserList: database internal error: %s, %d\n"), e.what(), GetDatabase().getErrorCode());
 	}
 }
 
 void CUserDatabaseSQLite::LoadBackup(const string& backupDate)
 {
+	lock_guard<recursive_mutex> lock(m_Mutex);
+
 	try
 	{
+		// cached statements must not be active during restore
+		ClearStatementCache();
+
 		m_Database.backup(va(OBFUSCATE("UserDatabase_%s.db3"), backupDate.c_str()), SQLite::Database::BackupType::Load);
 
 		CheckForTables();
@@ -531,54 +714,354 @@ void CUserDatabaseSQLite::LoadBackup(const string& backupDate)
 	}
 }
 
+// starts online backup to UserDatabase_<year>_<month>_<day>_<hour>.db3, the copy is made in small steps on the database thread
+void CUserDatabaseSQLite::StartBackup()
+{
+	tm* time = g_pServerInstance->GetCurrentLocalTime();
+	string fileName = va(OBFUSCATE("UserDatabase_%d_%d_%d_%d.db3"), time->tm_year + 1900, time->tm_mon, time->tm_mday, time->tm_hour);
+
+	g_UserDatabaseAsync.AddJob([this, fileName]() { BeginBackup(fileName); });
+}
+
 void CUserDatabaseSQLite::PrintBackupList()
+{
+	vector<pair<string, time_t>> files;
+	GetBackupFiles(files);
+
+	Logger().Info(OBFUSCATE("SQLite user database backup list:\n"));
+	for (auto& file : files)
+	{
+		Logger().Info(OBFUSCATE("%s\n"), file.first.c_str());
+	}
+
+	if (m_bBackupRunning)
+	{
+		Logger().Info(OBFUSCATE("Backup is in progress\n"));
+	}
+}
+
+// gets backup files ordered from newest to oldest
+void CUserDatabaseSQLite::GetBackupFiles(vector<pair<string, time_t>>& files)
 {
 #ifdef WIN32
 	HANDLE hFind;
 	WIN32_FIND_DATA FindFileData;
 
-	Logger().Info(OBFUSCATE("SQLite user database backup list:\n"));
 	if ((hFind = FindFirstFile(OBFUSCATE("UserDatabase_*.db3"), &FindFileData)) != INVALID_HANDLE_VALUE)
 	{
 		do
 		{
-			Logger().Info(OBFUSCATE("%s\n"), FindFileData.cFileName);
+			// FILETIME is in 100 ns intervals since 1601
+			ULARGE_INTEGER writeTime;
+			writeTime.LowPart = FindFileData.ftLastWriteTime.dwLowDateTime;
+			writeTime.HighPart = FindFileData.ftLastWriteTime.dwHighDateTime;
+
+			files.push_back(make_pair(string(FindFileData.cFileName), (time_t)(writeTime.QuadPart / 10000000ULL - 11644473600ULL)));
 		} while (FindNextFile(hFind, &FindFileData));
 
 		FindClose(hFind);
 	}
 #else
-	Logger().Warn(OBFUSCATE("CUserDatabaseSQLite::PrintBackupList: not implemented\n"));
+	DIR* dir = opendir(".");
+	if (!dir)
+	{
+		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::GetBackupFiles: failed to open working directory\n"));
+		return;
+	}
+
+	dirent* entry;
+	while ((entry = readdir(dir)) != NULL)
+	{
+		if (fnmatch(OBFUSCATE("UserDatabase_*.db3"), entry->d_name, 0))
+			continue;
+
+		struct stat fileStat;
+		if (stat(entry->d_name, &fileStat))
+			continue;
+
+		files.push_back(make_pair(string(entry->d_name), fileStat.st_mtime));
+	}
+
+	closedir(dir);
 #endif
+
+	sort(files.begin(), files.end(), [](const pair<string, time_t>& a, const pair<string, time_t>& b) { return a.second > b.second; });
+}
+
+// opens source and destination connections of backup. Called on the database thread
+void CUserDatabaseSQLite::BeginBackup(const string& fileName)
+{
+	if (m_pBackup)
+	{
+		Logger().Warn(OBFUSCATE("CUserDatabaseSQLite::BeginBackup: backup to %s is in progress, %s is skipped\n"), m_BackupFileName.c_str(), fileName.c_str());
+		return;
+	}
+
+	m_BackupFileName = fileName;
+	m_BackupStartTime = time(NULL);
+	m_nBackupProgress = 0;
+
+	try
+	{
+		m_pBackupSource = new SQLite::Database(OBFUSCATE("UserDatabase.db3"), SQLite::OPEN_READONLY);
+		m_pBackupSource->setBusyTimeout(1000);
+
+		// in WAL mode the read transaction keeps one snapshot for all steps, so writes of the main connection don't restart the backup.
+		// Without WAL it would block writers, the backup restarts on changes instead
+		if (m_bWAL)
+		{
+			m_pBackupSource->exec(OBFUSCATE("BEGIN"));
+			m_pBackupSource->execAndGet(OBFUSCATE("SELECT COUNT(1) FROM sqlite_master"));
+		}
+	}
+	catch (exception& e)
+	{
+		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::BeginBackup: failed to open database: %s\n"), e.what());
+		EndBackup(false);
+		return;
+	}
+
+	string tempFileName = m_BackupFileName + OBFUSCATE(".tmp");
+	if (sqlite3_open_v2(tempFileName.c_str(), &m_pBackupDest, SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE, NULL) != SQLITE_OK)
+	{
+		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::BeginBackup: failed to open %s: %s\n"), tempFileName.c_str(), sqlite3_errmsg(m_pBackupDest));
+		EndBackup(false);
+		return;
+	}
+
+	m_pBackup = sqlite3_backup_init(m_pBackupDest, "main", m_pBackupSource->getHandle(), "main");
+	if (!m_pBackup)
+	{
+		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::BeginBackup: failed to start backup: %s\n"), sqlite3_errmsg(m_pBackupDest));
+		EndBackup(false);
+		return;
+	}
+
+	m_bBackupRunning = true;
+
+	Logger().Info(OBFUSCATE("User database backup to %s started\n"), m_BackupFileName.c_str());
+}
+
+// copies pages for up to DB_BACKUP_STEP_TIME ms. Called on the database thread
+void CUserDatabaseSQLite::BackupStep()
+{
+	if (!m_pBackup)
+		return;
+
+	auto start = chrono::steady_clock::now();
+	int result;
+	do
+	{
+		result = sqlite3_backup_step(m_pBackup, DB_BACKUP_STEP_PAGES);
+	} while (result == SQLITE_OK && chrono::steady_clock::now() - start < chrono::milliseconds(DB_BACKUP_STEP_TIME));
+
+	if (result == SQLITE_DONE)
+	{
+		EndBackup(true);
+		return;
+	}
+
+	if (result != SQLITE_OK && result != SQLITE_BUSY && result != SQLITE_LOCKED)
+	{
+		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::BackupStep: backup to %s failed: %s\n"), m_BackupFileName.c_str(), sqlite3_errmsg(m_pBackupDest));
+		EndBackup(false);
+		return;
+	}
+
+	// busy and locked are retried on the next second
+	int pageCount = sqlite3_backup_pagecount(m_pBackup);
+	if (pageCount > 0)
+	{
+		int progress = (pageCount - sqlite3_backup_remaining(m_pBackup)) * 100 / pageCount;
+		if (progress / 10 > m_nBackupProgress / 10)
+		{
+			Logger().Info(OBFUSCATE("User database backup to %s: %d%% (%d pages)\n"), m_BackupFileName.c_str(), progress, pageCount);
+		}
+
+		m_nBackupProgress = progress;
+	}
+}
+
+// closes backup connections, renames the finished file and deletes old backups
+void CUserDatabaseSQLite::EndBackup(bool success)
+{
+	if (m_pBackup)
+	{
+		if (sqlite3_backup_finish(m_pBackup) != SQLITE_OK)
+			success = false;
+
+		m_pBackup = NULL;
+	}
+
+	if (m_pBackupDest)
+	{
+		sqlite3_close(m_pBackupDest);
+		m_pBackupDest = NULL;
+	}
+
+	// closing the connection ends the read transaction
+	delete m_pBackupSource;
+	m_pBackupSource = NULL;
+
+	string tempFileName = m_BackupFileName + OBFUSCATE(".tmp");
+	if (success)
+	{
+		// rename doesn't replace existing file on Windows
+		remove(m_BackupFileName.c_str());
+
+		if (rename(tempFileName.c_str(), m_BackupFileName.c_str()))
+		{
+			Logger().Error(OBFUSCATE("CUserDatabaseSQLite::EndBackup: failed to rename %s\n"), tempFileName.c_str());
+			success = false;
+		}
+		else
+		{
+			Logger().Info(OBFUSCATE("User database backup to %s finished in %d s\n"), m_BackupFileName.c_str(), (int)(time(NULL) - m_BackupStartTime));
+
+			RotateBackups();
+		}
+	}
+
+	if (!success)
+	{
+		remove(tempFileName.c_str());
+	}
+
+	m_bBackupRunning = false;
+}
+
+// deletes backups beyond DB_BACKUP_RETENTION newest ones
+void CUserDatabaseSQLite::RotateBackups()
+{
+	vector<pair<string, time_t>> files;
+	GetBackupFiles(files);
+
+	for (size_t i = DB_BACKUP_RETENTION; i < files.size(); i++)
+	{
+		if (remove(files[i].first.c_str()))
+		{
+			Logger().Warn(OBFUSCATE("CUserDatabaseSQLite::RotateBackups: failed to delete %s\n"), files[i].first.c_str());
+			continue;
+		}
+
+		Logger().Info(OBFUSCATE("Old user database backup %s deleted\n"), files[i].first.c_str());
+	}
 }
 
 void CUserDatabaseSQLite::ResetQuestEvent(int questID)
 {
+	PROFILE_DB();
+	lock_guard<recursive_mutex> lock(GetMutex());
+
 	try
 	{
 		{
-			SQLite::Statement query(m_Database, OBFUSCATE("DELETE FROM UserQuestEventProgress WHERE questID = ?"));
-			query.bind(1, questID);
-			query.exec();
+			CCachedStatement query = CACHED_STATEMENT("DELETE FROM UserQuestEventProgress WHERE questID = ?");
+			query->bind(1, questID);
+			query->exec();
 		}
 		{
-			SQLite::Statement query(m_Database, OBFUSCATE("DELETE FROM UserQuestEventTaskProgress WHERE questID = ?"));
-			query.bind(1, questID);
-			query.exec();
+			CCachedStatement query = CACHED_STATEMENT("DELETE FROM UserQuestEventTaskProgress WHERE questID = ?");
+			query->bind(1, questID);
+			query->exec();
 		}
 	}
 	catch (exception& e)
 	{
-		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::ResetQuestEvent: database internal error: %s, %d\n"), e.what(), m_Database.getErrorCode());
+		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::ResetQuestEvent: database internal error: %s, %d\n"), e.what(), GetDatabase().getErrorCode());
+	}
+}
+
+// starts or stops recording of executed statements for AuditQueryPlans
+void CUserDatabaseSQLite::RecordStatements(bool record)
+{
+	lock_guard<recursive_mutex> lock(m_Mutex);
+
+	if (record)
+		sqlite3_trace_v2(m_Database.getHandle(), SQLITE_TRACE_STMT, OnStatementTrace, this);
+	else
+		sqlite3_trace_v2(m_Database.getHandle(), 0, NULL, NULL);
+}
+
+// runs EXPLAIN QUERY PLAN over hot and recorded statements and prints the ones which scan whole tables
+// returns number of statements with full table scans
+int CUserDatabaseSQLite::AuditQueryPlans()
+{
+	lock_guard<recursive_mutex> lock(m_Mutex);
+
+	// statements that must always use an index
+	set<string> statements = {
+		OBFUSCATE("SELECT userID FROM User WHERE userName = ? AND password = ? LIMIT 1"),
+		OBFUSCATE("SELECT COUNT(1) FROM User WHERE registerIP = ?"),
+		OBFUSCATE("SELECT userID FROM UserCharacter WHERE gameName = ? LIMIT 1"),
+		OBFUSCATE("SELECT * FROM UserInventory WHERE userID = ? AND slot = ? LIMIT 1"),
+		OBFUSCATE("SELECT * FROM UserInventory WHERE userID = ? AND itemID = ? LIMIT 1"),
+		OBFUSCATE("SELECT itemID, status, inUse, expiryDate FROM UserInventory WHERE userID = ? AND slot = ? LIMIT 1"),
+		OBFUSCATE("SELECT expiryDate FROM UserInventory WHERE userID = ? AND slot = ? AND itemID != 0 AND expiryDate != 0 AND inUse = 1 LIMIT 1"),
+		OBFUSCATE("DELETE FROM UserBan WHERE term <= ?"),
+		OBFUSCATE("SELECT MAX(userID) FROM (SELECT userID FROM User WHERE userID > ? ORDER BY userID LIMIT ?)"),
+		OBFUSCATE("UPDATE UserQuestProgress SET status = 0 WHERE userID > ? AND userID <= ? AND questID > 0 AND questID < 2000"),
+		OBFUSCATE("DELETE FROM UserQuestEventTaskProgress WHERE userID > ? AND userID <= ? AND questID > 2000 AND questID < 4000"),
+		OBFUSCATE("UPDATE ClanStorageItem SET itemID = 0, itemDuration = 0, itemCount = 0 WHERE clanID = ? AND pageID = ? AND slot = ? AND itemID != 0 AND itemDuration <= ?"),
+		OBFUSCATE("SELECT Clan.clanID, gameName, name, notice, gameModeID, time, region, memberCount, joinMethod, score, markID FROM Clan, UserCharacter WHERE userID = Clan.masterUserID AND CASE WHEN ? == 0 THEN name LIKE ('%' || ? || '%') WHEN ? == 1 THEN gameModeID = ? WHEN ? == 2 THEN time = ? WHEN ? == 3 THEN gameModeID = ? AND time = ? END ORDER BY score DESC LIMIT 15 OFFSET ? * 15"),
+	};
+	statements.insert(m_RecordedStatements.begin(), m_RecordedStatements.end());
+
+	int count = 0;
+	for (auto& statement : statements)
+	{
+		vector<string> scans;
+		if (!GetFullScans(statement, scans) || scans.empty())
+			continue;
+
+		Logger().Warn(OBFUSCATE("CUserDatabaseSQLite::AuditQueryPlans: %s\n"), statement.c_str());
+		for (auto& scan : scans)
+			Logger().Warn("    %s\n", scan.c_str());
+
+		count++;
+	}
+
+	Logger().Info(OBFUSCATE("CUserDatabaseSQLite::AuditQueryPlans: %d of %d statements scan whole tables\n"), count, (int)statements.size());
+
+	return count;
+}
+
+// prints cached statements with the most executions
+void CUserDatabaseSQLite::PrintStatementStats(int count)
+{
+	lock_guard<recursive_mutex> lock(m_Mutex);
+
+	vector<pair<unsigned long long, string>> stats;
+	for (auto& cached : m_Statements)
+	{
+		if (cached.second.statement)
+			stats.push_back(make_pair(cached.second.executions, cached.second.statement->getQuery()));
+	}
+
+	for (auto& cached : m_QueryStatements)
+	{
+		if (cached.second.statement)
+			stats.push_back(make_pair(cached.second.executions, cached.first));
+	}
+
+	sort(stats.begin(), stats.end(), [](const pair<unsigned long long, string>& a, const pair<unsigned long long, string>& b) { return a.first > b.first; });
+
+	Logger().Info("%-12s|%s (cached: %d)\n", "Executions", "Statement", (int)stats.size());
+	for (int i = 0; i < count && i < (int)stats.size(); i++)
+	{
+		// statement may contain '%', don't use it as format
+		Logger().Info("%-12llu|%s\n", stats[i].first, stats[i].second.c_str());
 	}
 }
 
+// uses read-only connection, can be called by any thread
 void CUserDatabaseSQLite::WriteUserStatistic(const string& fdate, const string& sdate)
 {
 	try
 	{
-		SQLite::Statement query(m_Database, OBFUSCATE("SELECT * FROM User"));
-		while (query.executeStep())
+		CReadConnection connection(*this);
+		CCachedStatement query = READ_STATEMENT(connection, "SELECT * FROM User");
+		while (query->executeStep())
 		{
 			int registeredUsers = 0;
 			int sessions = 0;
@@ -590,7 +1073,7 @@ void CUserDatabaseSQLite::WriteUserStatistic(const string& fdate, const string&
 	}
 	catch (exception& e)
 	{
-		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::WriteUserStatistic: database internal error: %s, %d\n"), e.what(), m_Database.getErrorCode());
+		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::WriteUserStatistic: database internal error: %s\n"), e.what());
 	}
 }
 
@@ -598,30 +1081,50 @@ void CUserDatabaseSQLite::WriteUserStatistic(const string& fdate, const string&
 // returns 0 == database error, 1 on success
 int CUserDatabaseSQLite::AddInventoryItem(int userID, CUserInventoryItem& item)
 {
+	PROFILE_DB();
+	lock_guard<recursive_mutex> lock(GetMutex());
+
+	CUserInventory* inventory = GetCachedInventory(userID);
+	if (inventory)
+	{
+		if (item.m_nIsClanItem)
+		{
+			if (inventory->GetFirstItem(item.m_nItemID, [](const CUserInventoryItem& i) { return i.m_nExpiryDate == 0; }))
+				return -1; // user already has permanent item
+
+			if (inventory->GetFirstItem(item.m_nItemID, [](const CUserInventoryItem& i) { return i.m_nIsClanItem == 1; }))
+				return -2; // user already has this clan item
+		}
+
+		inventory->AddItem(item);
+		ScheduleItemExpiry(userID, item);
+		return 1;
+	}
+
 	try
 	{
 		if (item.m_nIsClanItem)
 		{
 			{
-				SQLite::Statement query(m_Database, OBFUSCATE("SELECT EXISTS(SELECT 1 FROM UserInventory WHERE userID = ? AND itemID = ? AND expiryDate = 0 LIMIT 1)"));
-				query.bind(1, userID);
-				query.bind(2, item.m_nItemID);
+				CCachedStatement query = CACHED_STATEMENT("SELECT EXISTS(SELECT 1 FROM UserInventory WHERE userID = ? AND itemID = ? AND expiryDate = 0 LIMIT 1)");
+				query->bind(1, userID);
+				query->bind(2, item.m_nItemID);
 
-				if (query.executeStep())
+				if (query->executeStep())
 				{
-					if ((int)query.getColumn(0))
+					if ((int)query->getColumn(0))
 						return -1; // user already has permanent item
 				}
 			}
 
 			{
-				SQLite::Statement query(m_Database, OBFUSCATE("SELECT EXISTS(SELECT 1 FROM UserInventory WHERE userID = ? AND itemID = ? AND isClanItem = 1 LIMIT 1)"));
-				query.bind(1, userID);
-				query.bind(2, item.m_nItemID);
+				CCachedStatement query = CACHED_STATEMENT("SELECT EXISTS(SELECT 1 FROM UserInventory WHERE userID = ? AND itemID = ? AND isClanItem = 1 LIMIT 1)");
+				query->bind(1, userID);
+				query->bind(2, item.m_nItemID);
 
-				if (query.executeStep())
+				if (query->executeStep())
 				{
-					if ((int)query.getColumn(0))
+					if ((int)query->getColumn(0))
 						return -2; // user already has this clan item
 				}
 			}
@@ -630,76 +1133,83 @@ int CUserDatabaseSQLite::AddInventoryItem(int userID, CUserInventoryItem& item)
 		int slot = -1;
 
 		// find free slot
-		SQLite::Statement queryGetFreeInvSlot(m_Database, OBFUSCATE("SELECT slot FROM UserInventory WHERE userID = ? AND itemID = 0 LIMIT 1"));
-		queryGetFreeInvSlot.bind(1, userID);
-
-		if (queryGetFreeInvSlot.executeStep())
-		{
-			slot = queryGetFreeInvSlot.getColumn(0);
-
-			SQLite::Statement queryUpdateItem(m_Database, OBFUSCATE("UPDATE UserInventory SET itemID = ?, count = ?, status = ?, inUse = ?, obtainDate = ?, expiryDate = ?, isClanItem = ?, enhancementLevel = ?, enhancementExp = ?, enhanceValue = ?, paintID = ?, paintIDList = ?, partSlot1 = ?, partSlot2 = ?, lockStatus = ? WHERE userID = ? AND slot = ?"));
-			queryUpdateItem.bind(1, item.m_nItemID);
-			queryUpdateItem.bind(2, item.m_nCount);
-			queryUpdateItem.bind(3, item.m_nStatus);
-			queryUpdateItem.bind(4, item.m_nInUse);
-			queryUpdateItem.bind(5, item.m_nObtainDate);
-			queryUpdateItem.bind(6, item.m_nExpiryDate);
-			queryUpdateItem.bind(7, item.m_nIsClanItem);
-			queryUpdateItem.bind(8, item.m_nEnhancementLevel);
-			queryUpdateItem.bind(9, item.m_nEnhancementExp);
-			queryUpdateItem.bind(10, item.m_nEnhanceValue);
-			queryUpdateItem.bind(11, item.m_nPaintID);
-			queryUpdateItem.bind(12, serialize_array_int(item.m_nPaintIDList));
-			queryUpdateItem.bind(13, item.m_nPartSlot1);
-			queryUpdateItem.bind(14, item.m_nPartSlot2);
-			queryUpdateItem.bind(15, item.m_nLockStatus);
-			queryUpdateItem.bind(16, userID);
-			queryUpdateItem.bind(17, slot);
-
-			queryUpdateItem.exec();
+		CCachedStatement queryGetFreeInvSlot = CACHED_STATEMENT("SELECT slot FROM UserInventory WHERE userID = ? AND itemID = 0 LIMIT 1");
+		queryGetFreeInvSlot->bind(1, userID);
+
+		if (queryGetFreeInvSlot->executeStep())
+		{
+			slot = queryGetFreeInvSlot->getColumn(0);
+
+			CCachedStatement queryUpdateItem = CACHED_STATEMENT("UPDATE UserInventory SET itemID = ?, count = ?, status = ?, inUse = ?, obtainDate = ?, expiryDate = ?, isClanItem = ?, enhancementLevel = ?, enhancementExp = ?, enhanceValue = ?, paintID = ?, paintIDList = ?, partSlot1 = ?, partSlot2 = ?, lockStatus = ? WHERE userID = ? AND slot = ?");
+			queryUpdateItem->bind(1, item.m_nItemID);
+			queryUpdateItem->bind(2, item.m_nCount);
+			queryUpdateItem->bind(3, item.m_nStatus);
+			queryUpdateItem->bind(4, item.m_nInUse);
+			queryUpdateItem->bind(5, item.m_nObtainDate);
+			queryUpdateItem->bind(6, item.m_nExpiryDate);
+			queryUpdateItem->bind(7, item.m_nIsClanItem);
+			queryUpdateItem->bind(8, item.m_nEnhancementLevel);
+			queryUpdateItem->bind(9, item.m_nEnhancementExp);
+			queryUpdateItem->bind(10, item.m_nEnhanceValue);
+			queryUpdateItem->bind(11, item.m_nPaintID);
+			queryUpdateItem->bind(12, serialize_array_int(item.m_nPaintIDList));
+			queryUpdateItem->bind(13, item.m_nPartSlot1);
+			queryUpdateItem->bind(14, item.m_nPartSlot2);
+			queryUpdateItem->bind(15, item.m_nLockStatus);
+			queryUpdateItem->bind(16, userID);
+			queryUpdateItem->bind(17, slot);
+
+			queryUpdateItem->exec();
 		}
 		else
 		{
-			SQLite::Statement queryGetNextInvSlot(m_Database, OBFUSCATE("SELECT nextInventorySlot FROM UserCharacterExtended WHERE userID = ? LIMIT 1"));
-			queryGetNextInvSlot.bind(1, userID);
-			queryGetNextInvSlot.executeStep();
-
-			slot = queryGetNextInvSlot.getColumn(0);
-
-			SQLite::Statement queryInsertNewInvItem(m_Database, OBFUSCATE("INSERT INTO UserInventory VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?)"));
-			queryInsertNewInvItem.bind(1, userID);
-			queryInsertNewInvItem.bind(2, slot);
-			queryInsertNewInvItem.bind(3, item.m_nItemID);
-			queryInsertNewInvItem.bind(4, item.m_nCount);
-			queryInsertNewInvItem.bind(5, item.m_nStatus);
-			queryInsertNewInvItem.bind(6, item.m_nInUse);
-			queryInsertNewInvItem.bind(7, item.m_nObtainDate);
-			queryInsertNewInvItem.bind(8, item.m_nExpiryDate);
-			queryInsertNewInvItem.bind(9, item.m_nIsClanItem);
-			queryInsertNewInvItem.bind(10, item.m_nEnhancementLevel);
-			queryInsertNewInvItem.bind(11, item.m_nEnhancementExp);
-			queryInsertNewInvItem.bind(12, item.m_nEnhanceValue);
-			queryInsertNewInvItem.bind(13, item.m_nPaintID);
-			queryInsertNewInvItem.bind(14, serialize_array_int(item.m_nPaintIDList));
-			queryInsertNewInvItem.bind(15, item.m_nPartSlot1);
-			queryInsertNewInvItem.bind(16, item.m_nPartSlot2);
-			queryInsertNewInvItem.bind(17, item.m_nLockStatus);
-
-			queryInsertNewInvItem.exec();
+			CCachedStatement queryGetNextInvSlot = CACHED_STATEMENT("SELECT nextInventorySlot FROM UserCharacterExtended WHERE userID = ? LIMIT 1");
+			queryGetNextInvSlot->bind(1, userID);
+			queryGetNextInvSlot->executeStep();
+
+			slot = queryGetNextInvSlot->getColumn(0);
+
+			CCachedStatement queryInsertNewInvItem = CACHED_STATEMENT("INSERT INTO UserInventory VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?)");
+			queryInsertNewInvItem->bind(1, userID);
+			queryInsertNewInvItem->bind(2, slot);
+			queryInsertNewInvItem->bind(3, item.m_nItemID);
+			queryInsertNewInvItem->bind(4, item.m_nCount);
+			queryInsertNewInvItem->bind(5, item.m_nStatus);
+			queryInsertNewInvItem->bind(6, item.m_nInUse);
+			queryInsertNewInvItem->bind(7, item.m_nObtainDate);
+			queryInsertNewInvItem->bind(8, item.m_nExpiryDate);
+			queryInsertNewInvItem->bind(9, item.m_nIsClanItem);
+			queryInsertNewInvItem->bind(10, item.m_nEnhancementLevel);
+			queryInsertNewInvItem->bind(11, item.m_nEnhancementExp);
+			queryInsertNewInvItem->bind(12, item.m_nEnhanceValue);
+			queryInsertNewInvItem->bind(13, item.m_nPaintID);
+			queryInsertNewInvItem->bind(14, serialize_array_int(item.m_nPaintIDList));
+			queryInsertNewInvItem->bind(15, item.m_nPartSlot1);
+			queryInsertNewInvItem->bind(16, item.m_nPartSlot2);
+			queryInsertNewInvItem->bind(17, item.m_nLockStatus);
+
+			queryInsertNewInvItem->exec();
 		}
 
 		item.m_nSlot = slot;
 
-		SQLite::Statement queryUpdateNextInvSlot(m_Database, OBFUSCATE("UPDATE UserCharacterExtended SET nextInventorySlot = nextInventorySlot + 1 WHERE userID = ?"));
-		queryUpdateNextInvSlot.bind(1, userID);
-		queryUpdateNextInvSlot.exec();
+		ScheduleItemExpiry(userID, item);
+
+		CCachedStatement queryUpdateNextInvSlot = CACHED_STATEMENT("UPDATE UserCharacterExtended SET nextInventorySlot = nextInventorySlot + 1 WHERE userID = ?");
+		queryUpdateNextInvSlot->bind(1, userID);
+		queryUpdateNextInvSlot->exec();
 	}
 	catch (exception& e)
 	{
-		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::AddInventoryItem: database internal error: %s, %d\n"), e.what(), m_Database.getErrorCode());
+		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::AddInventoryItem: database internal error: %s, %d\n"), e.what(), GetDatabase().getErrorCode());
+
+		m_nInventoryVersion++;
 		return 0;
 	}
 
+	// inventory rows read before this write are outdated
+	m_nInventoryVersion++;
+
 	return 1;
 }
 
@@ -707,6 +1217,21 @@ int CUserDatabaseSQLite::AddInventoryItem(int userID, CUserInventoryItem& item)
 // returns 0 == database error, 1 on success
 int CUserDatabaseSQLite::AddInventoryItems(int userID, std::vector<CUserInventoryItem>& items)
 {
+	PROFILE_DB();
+	lock_guard<recursive_mutex> lock(GetMutex());
+
+	CUserInventory* inventory = GetCachedInventory(userID);
+	if (inventory)
+	{
+		for (auto& item : items)
+		{
+			inventory->AddItem(item);
+			ScheduleItemExpiry(userID, item);
+		}
+
+		return 1;
+	}
+
 	try
 	{
 		std::vector<std::vector<CUserInventoryItem>> itemsInsert;
@@ -721,20 +1246,20 @@ int CUserDatabaseSQLite::AddInventoryItems(int userID, std::vector<CUserInventor
 		std:vector<int> freeSlots;
 
 		// find free slots
-		SQLite::Statement queryGetFreeInvSlot(m_Database, OBFUSCATE("SELECT slot FROM UserInventory WHERE userID = ? AND itemID = 0 LIMIT ?"));
-		queryGetFreeInvSlot.bind(1, userID);
-		queryGetFreeInvSlot.bind(2, (int)items.size());
+		CCachedStatement queryGetFreeInvSlot = CACHED_STATEMENT("SELECT slot FROM UserInventory WHERE userID = ? AND itemID = 0 LIMIT ?");
+		queryGetFreeInvSlot->bind(1, userID);
+		queryGetFreeInvSlot->bind(2, (int)items.size());
 
-		while (queryGetFreeInvSlot.executeStep())
+		while (queryGetFreeInvSlot->executeStep())
 		{
-			freeSlots.push_back((int)queryGetFreeInvSlot.getColumn(0));
+			freeSlots.push_back((int)queryGetFreeInvSlot->getColumn(0));
 		}
 
-		SQLite::Statement queryGetNextInvSlot(m_Database, OBFUSCATE("SELECT nextInventorySlot FROM UserCharacterExtended WHERE userID = ? LIMIT 1"));
-		queryGetNextInvSlot.bind(1, userID);
-		queryGetNextInvSlot.executeStep();
+		CCachedStatement queryGetNextInvSlot = CACHED_STATEMENT("SELECT nextInventorySlot FROM UserCharacterExtended WHERE userID = ? LIMIT 1");
+		queryGetNextInvSlot->bind(1, userID);
+		queryGetNextInvSlot->executeStep();
 
-		int slot = (int)queryGetNextInvSlot.getColumn(0);
+		int slot = (int)queryGetNextInvSlot->getColumn(0);
 
 		for (auto& item : items)
 		{
@@ -776,7 +1301,7 @@ int CUserDatabaseSQLite::AddInventoryItems(int userID, std::vector<CUserInventor
 				for (int j = 1; j < itemsInsertSize; j++)
 					queryInsertNewInvItemStr += OBFUSCATE(", (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?)");
 
-				SQLite::Statement queryInsertNewInvItem(m_Database, queryInsertNewInvItemStr);
+				SQLite::Statement queryInsertNewInvItem(GetDatabase(), queryInsertNewInvItemStr);
 
 				for (auto& item : itemsInsert[i])
 				{
@@ -804,10 +1329,10 @@ int CUserDatabaseSQLite::AddInventoryItems(int userID, std::vector<CUserInventor
 				queryInsertNewInvItemStr.clear();
 			}
 
-			SQLite::Statement queryUpdateNextInvSlot(m_Database, OBFUSCATE("UPDATE UserCharacterExtended SET nextInventorySlot = nextInventorySlot + ? WHERE userID = ?"));
-			queryUpdateNextInvSlot.bind(1, (1927 * itemsInsertIndex) + (int)itemsInsert[itemsInsertIndex].size());
-			queryUpdateNextInvSlot.bind(2, userID);
-			queryUpdateNextInvSlot.exec();
+			CCachedStatement queryUpdateNextInvSlot = CACHED_STATEMENT("UPDATE UserCharacterExtended SET nextInventorySlot = nextInventorySlot + ? WHERE userID = ?");
+			queryUpdateNextInvSlot->bind(1, (1927 * itemsInsertIndex) + (int)itemsInsert[itemsInsertIndex].size());
+			queryUpdateNextInvSlot->bind(2, userID);
+			queryUpdateNextInvSlot->exec();
 		}
 
 		if (itemsUpdate[0].size())
@@ -898,7 +1423,7 @@ int CUserDatabaseSQLite::AddInventoryItems(int userID, std::vector<CUserInventor
 				}
 				queryUpdateItemStr += OBFUSCATE(" ELSE lockStatus END WHERE userID = ?");
 
-				SQLite::Statement queryUpdateItem(m_Database, queryUpdateItemStr);
+				SQLite::Statement queryUpdateItem(GetDatabase(), queryUpdateItemStr);
 
 				for (auto& item : itemsUpdate[i])
 				{
@@ -983,13 +1508,20 @@ int CUserDatabaseSQLite::AddInventoryItems(int userID, std::vector<CUserInventor
 				queryUpdateItemStr.clear();
 			}
 		}
+
+		for (auto& item : items)
+			ScheduleItemExpiry(userID, item);
 	}
 	catch (exception& e)
 	{
-		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::AddInventoryItems: database internal error: %s, %d\n"), e.what(), m_Database.getErrorCode());
+		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::AddInventoryItems: database internal error: %s, %d\n"), e.what(), GetDatabase().getErrorCode());
+
+		m_nInventoryVersion++;
 		return 0;
 	}
 
+	m_nInventoryVersion++;
+
 	return 1;
 }
 
@@ -1035,88 +1567,109 @@ string UpdateInventoryItemString(int flag)
 // returns 0 == database error, 1 on success
 int CUserDatabaseSQLite::UpdateInventoryItem(int userID, const CUserInventoryItem& item, int flag)
 {
-	try
+	PROFILE_DB();
+	lock_guard<recursive_mutex> lock(GetMutex());
+
+	CUserInventory* inventory = GetCachedInventory(userID);
+	if (inventory)
+	{
+		inventory->UpdateItem(item, flag);
+
+		if (flag & (UITEM_FLAG_ITEMID | UITEM_FLAG_INUSE | UITEM_FLAG_EXPIRYDATE))
+			ScheduleItemExpiry(userID, item.m_nSlot);
+
+		return 1;
+	}
+
+	try
 	{
 		// format query
 		string query = UpdateInventoryItemString(flag);
 		query[query.size() - 1] = ' ';
 		query += OBFUSCATE("WHERE userID = ? AND slot = ?"); // TODO: use stringstream
 
-		SQLite::Statement statement(m_Database, query);
+		CCachedStatement statement = GetStatement(query);
 		int index = 1;
 
 		if (flag & UITEM_FLAG_ITEMID)
 		{
-			statement.bind(index++, item.m_nItemID);
+			statement->bind(index++, item.m_nItemID);
 		}
 		if (flag & UITEM_FLAG_COUNT)
 		{
-			statement.bind(index++, item.m_nCount);
+			statement->bind(index++, item.m_nCount);
 		}
 		if (flag & UITEM_FLAG_STATUS)
 		{
-			statement.bind(index++, item.m_nStatus);
+			statement->bind(index++, item.m_nStatus);
 		}
 		if (flag & UITEM_FLAG_INUSE)
 		{
-			statement.bind(index++, item.m_nInUse);
+			statement->bind(index++, item.m_nInUse);
 		}
 		if (flag & UITEM_FLAG_OBTAINDATE)
 		{
-			statement.bind(index++, item.m_nObtainDate);
+			statement->bind(index++, item.m_nObtainDate);
 		}
 		if (flag & UITEM_FLAG_EXPIRYDATE)
 		{
-			statement.bind(index++, item.m_nExpiryDate);
+			statement->bind(index++, item.m_nExpiryDate);
 		}
 		if (flag & UITEM_FLAG_ISCLANITEM)
 		{
-			statement.bind(index++, item.m_nIsClanItem);
+			statement->bind(index++, item.m_nIsClanItem);
 		}
 		if (flag & UITEM_FLAG_ENHANCEMENTLEVEL)
 		{
-			statement.bind(index++, item.m_nEnhancementLevel);
+			statement->bind(index++, item.m_nEnhancementLevel);
 		}
 		if (flag & UITEM_FLAG_ENHANCEMENTEXP)
 		{
-			statement.bind(index++, item.m_nEnhancementExp);
+			statement->bind(index++, item.m_nEnhancementExp);
 		}
 		if (flag & UITEM_FLAG_ENHANCEVALUE)
 		{
-			statement.bind(index++, item.m_nEnhanceValue);
+			statement->bind(index++, item.m_nEnhanceValue);
 		}
 		if (flag & UITEM_FLAG_PAINTID)
 		{
-			statement.bind(index++, item.m_nPaintID);
+			statement->bind(index++, item.m_nPaintID);
 		}
 		if (flag & UITEM_FLAG_PAINTIDLIST)
 		{
-			statement.bind(index++, serialize_array_int(item.m_nPaintIDList));
+			statement->bind(index++, serialize_array_int(item.m_nPaintIDList));
 		}
 		if (flag & UITEM_FLAG_PARTSLOT1)
 		{
-			statement.bind(index++, item.m_nPartSlot1);
+			statement->bind(index++, item.m_nPartSlot1);
 		}
 		if (flag & UITEM_FLAG_PARTSLOT2)
 		{
-			statement.bind(index++, item.m_nPartSlot2);
+			statement->bind(index++, item.m_nPartSlot2);
 		}
 		if (flag & UITEM_FLAG_LOCKSTATUS)
 		{
-			statement.bind(index++, item.m_nLockStatus);
+			statement->bind(index++, item.m_nLockStatus);
 		}
 
-		statement.bind(index++, userID);
-		statement.bind(index++, item.m_nSlot);
+		statement->bind(index++, userID);
+		statement->bind(index++, item.m_nSlot);
+
+		statement->exec();
 
-		statement.exec();
+		if (flag & (UITEM_FLAG_ITEMID | UITEM_FLAG_INUSE | UITEM_FLAG_EXPIRYDATE))
+			ScheduleItemExpiry(userID, item.m_nSlot);
 	}
 	catch (exception& e)
 	{
-		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::UpdateInventoryItem: database internal error: %s, %d\n"), e.what(), m_Database.getErrorCode());
+		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::UpdateInventoryItem: database internal error: %s, %d\n"), e.what(), GetDatabase().getErrorCode());
+
+		m_nInventoryVersion++;
 		return 0;
 	}
 
+	m_nInventoryVersion++;
+
 	return 1;
 }
 
@@ -1124,6 +1677,26 @@ int CUserDatabaseSQLite::UpdateInventoryItem(int userID, const CUserInventoryIte
 // returns 0 == database error, 1 on success
 int CUserDatabaseSQLite::UpdateInventoryItems(int userID, std::vector<CUserInventoryItem>& items, int flag)
 {
+	PROFILE_DB();
+	lock_guard<recursive_mutex> lock(GetMutex());
+
+	CUserInventory* inventory = GetCachedInventory(userID);
+	if (inventory)
+	{
+		if (!(flag & 0x7FFF))
+			return 0;
+
+		for (auto& item : items)
+		{
+			inventory->UpdateItem(item, flag);
+
+			if (flag & (UITEM_FLAG_ITEMID | UITEM_FLAG_INUSE | UITEM_FLAG_EXPIRYDATE))
+				ScheduleItemExpiry(userID, item.m_nSlot);
+		}
+
+		return 1;
+	}
+
 	try
 	{
 		int flagBinds = 0;
@@ -1302,7 +1875,7 @@ int CUserDatabaseSQLite::UpdateInventoryItems(int userID, std::vector<CUserInven
 			queryUpdateItemStr[queryUpdateItemStr.size() - 1] = ' ';
 			queryUpdateItemStr += OBFUSCATE("WHERE userID = ?");
 
-			SQLite::Statement queryUpdateItem(m_Database, queryUpdateItemStr);
+			SQLite::Statement queryUpdateItem(GetDatabase(), queryUpdateItemStr);
 
 			if (flag & UITEM_FLAG_ITEMID)
 			{
@@ -1431,13 +2004,23 @@ int CUserDatabaseSQLite::UpdateInventoryItems(int userID, std::vector<CUserInven
 			index = 1;
 			queryUpdateItemStr.clear();
 		}
+
+		if (flag & (UITEM_FLAG_ITEMID | UITEM_FLAG_INUSE | UITEM_FLAG_EXPIRYDATE))
+		{
+			for (auto& item : items)
+				ScheduleItemExpiry(userID, item.m_nSlot);
+		}
 	}
 	catch (exception& e)
 	{
-		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::UpdateInventoryItem: database internal error: %s, %d\n"), e.what(), m_Database.getErrorCode());
+		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::UpdateInventoryItem: database internal error: %s, %d\n"), e.what(), GetDatabase().getErrorCode());
+
+		m_nInventoryVersion++;
 		return 0;
 	}
 
+	m_nInventoryVersion++;
+
 	return 1;
 }
 
@@ -1445,198 +2028,879 @@ int CUserDatabaseSQLite::UpdateInventoryItems(int userID, std::vector<CUserInven
 // returns 0 == database error, 1 on success
 int CUserDatabaseSQLite::GetInventoryItems(int userID, vector<CUserInventoryItem>& items)
 {
+	PROFILE_DB();
+	lock_guard<recursive_mutex> lock(GetMutex());
+
+	CUserInventory* inventory = GetCachedInventory(userID);
+	if (inventory)
+	{
+		inventory->GetItems(items);
+		return 1;
+	}
+
 	try
 	{
-		SQLite::Statement query(m_Database, OBFUSCATE("SELECT * FROM UserInventory WHERE userID = ?"));
-		query.bind(1, userID);
+		CCachedStatement query = CACHED_STATEMENT("SELECT * FROM UserInventory WHERE userID = ?");
+		query->bind(1, userID);
 
-		while (query.executeStep())
+		while (query->executeStep())
 		{
-			CUserInventoryItem item = query.getColumns<CUserInventoryItem, 17>();
+			CUserInventoryItem item = query->getColumns<CUserInventoryItem, 17>();
 			items.push_back(item);
 		}
 	}
 	catch (exception& e)
 	{
-		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::GetInventoryItems: database internal error: %s, %d\n"), e.what(), m_Database.getErrorCode());
-		return 0;
+		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::GetInventoryItems: database internal error: %s, %d\n"), e.what(), GetDatabase().getErrorCode());
+		return 0;
+	}
+
+	return 1;
+}
+
+// gets user inventory items by itemID
+// returns -1 == database error, 0 == no such item, 1 on success
+int CUserDatabaseSQLite::GetInventoryItemsByID(int userID, int itemID, vector<CUserInventoryItem>& items)
+{
+	PROFILE_DB();
+	lock_guard<recursive_mutex> lock(GetMutex());
+
+	CUserInventory* inventory = GetCachedInventory(userID);
+	if (inventory)
+	{
+		inventory->GetItemsByID(itemID, items);
+		return items.empty() ? 0 : 1;
+	}
+
+	try
+	{
+		CCachedStatement query = CACHED_STATEMENT("SELECT * FROM UserInventory WHERE userID = ? AND itemID = ?");
+		query->bind(1, userID);
+		query->bind(2, itemID);
+
+		while (query->executeStep())
+		{
+			CUserInventoryItem item = query->getColumns<CUserInventoryItem, 17>();
+			items.push_back(item);
+		}
+
+		if (items.empty())
+			return 0;
+	}
+	catch (exception& e)
+	{
+		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::GetInventoryItemByID: database internal error: %s, %d\n"), e.what(), GetDatabase().getErrorCode());
+		return -1;
+	}
+
+	return 1;
+}
+
+// gets user inventory item by slot
+// returns -1 == database error, 0 == no such slot, 1 on success
+int CUserDatabaseSQLite::GetInventoryItemBySlot(int userID, int slot, CUserInventoryItem& item)
+{
+	PROFILE_DB();
+	lock_guard<recursive_mutex> lock(GetMutex());
+
+	CUserInventory* inventory = GetCachedInventory(userID);
+	if (inventory)
+	{
+		CUserInventoryItem* cachedItem = inventory->GetItemBySlot(slot);
+		if (!cachedItem)
+			return 0;
+
+		item = *cachedItem;
+		return 1;
+	}
+
+	try
+	{
+		CCachedStatement query = CACHED_STATEMENT("SELECT * FROM UserInventory WHERE userID = ? AND slot = ? LIMIT 1");
+		query->bind(1, userID);
+		query->bind(2, slot);
+
+		if (!query->executeStep())
+		{
+			return 0;
+		}
+
+		item = query->getColumns<CUserInventoryItem, 17>();
+	}
+	catch (exception& e)
+	{
+		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::GetInventoryItemBySlot: database internal error: %s, %d\n"), e.what(), GetDatabase().getErrorCode());
+		return -1;
+	}
+
+	return 1;
+}
+
+// gets first user inventory item by itemID
+// returns -1 == database error, 0 == no such item, 1 on success
+int CUserDatabaseSQLite::GetFirstItemByItemID(int userID, int itemID, CUserInventoryItem& item)
+{
+	PROFILE_DB();
+	lock_guard<recursive_mutex> lock(GetMutex());
+
+	CUserInventory* inventory = GetCachedInventory(userID);
+	if (inventory)
+	{
+		CUserInventoryItem* cachedItem = inventory->GetFirstItem(itemID);
+		if (!cachedItem)
+			return 0;
+
+		item = *cachedItem;
+		return 1;
+	}
+
+	try
+	{
+		CCachedStatement query = CACHED_STATEMENT("SELECT * FROM UserInventory WHERE userID = ? AND itemID = ? LIMIT 1");
+		query->bind(1, userID);
+		query->bind(2, itemID);
+
+		if (!query->executeStep())
+		{
+			return 0;
+		}
+
+		item = query->getColumns<CUserInventoryItem, 17>();
+	}
+	catch (exception& e)
+	{
+		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::GetFirstItemByItemID: database internal error: %s, %d\n"), e.what(), GetDatabase().getErrorCode());
+		return -1;
+	}
+
+	return 1;
+}
+
+// gets first active user inventory item by itemID
+// returns -1 == database error, 0 == no such item, 1 on success
+int CUserDatabaseSQLite::GetFirstActiveItemByItemID(int userID, int itemID, CUserInventoryItem& item)
+{
+	PROFILE_DB();
+	lock_guard<recursive_mutex> lock(GetMutex());
+
+	CUserInventory* inventory = GetCachedInventory(userID);
+	if (inventory)
+	{
+		CUserInventoryItem* cachedItem = inventory->GetFirstItem(itemID, [](const CUserInventoryItem& i) { return i.m_nStatus == 1 && i.m_nInUse == 1; });
+		if (!cachedItem)
+			return 0;
+
+		item = *cachedItem;
+		return 1;
+	}
+
+	try
+	{
+		CCachedStatement query = CACHED_STATEMENT("SELECT * FROM UserInventory WHERE userID = ? AND itemID = ? AND status = 1 AND inUse = 1 LIMIT 1");
+		query->bind(1, userID);
+		query->bind(2, itemID);
+
+		if (!query->executeStep())
+		{
+			return 0;
+		}
+
+		item = query->getColumns<CUserInventoryItem, 17>();
+	}
+	catch (exception& e)
+	{
+		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::GetFirstActiveItemByItemID: database internal error: %s, %d\n"), e.what(), GetDatabase().getErrorCode());
+		return -1;
+	}
+
+	return 1;
+}
+
+// gets first user extendable inventory item by itemID
+// returns -1 == database error, 0 == no such item, 1 on success
+int CUserDatabaseSQLite::GetFirstExtendableItemByItemID(int userID, int itemID, CUserInventoryItem& item)
+{
+	PROFILE_DB();
+	lock_guard<recursive_mutex> lock(GetMutex());
+
+	CUserInventory* inventory = GetCachedInventory(userID);
+	if (inventory)
+	{
+		CUserInventoryItem* cachedItem = inventory->GetFirstItem(itemID, [](const CUserInventoryItem& i) { return i.m_nExpiryDate != 0 && i.m_nEnhanceValue == 0 && i.m_nPartSlot1 == 0 && i.m_nPartSlot2 == 0; });
+		if (!cachedItem)
+			return 0;
+
+		item = *cachedItem;
+		return 1;
+	}
+
+	try
+	{
+		CCachedStatement query = CACHED_STATEMENT("SELECT * FROM UserInventory WHERE userID = ? AND itemID = ? AND expiryDate != 0 AND enhanceValue = 0 AND partSlot1 = 0 AND partSlot2 = 0 LIMIT 1");
+		query->bind(1, userID);
+		query->bind(2, itemID);
+
+		if (!query->executeStep())
+		{
+			return 0;
+		}
+
+		item = query->getColumns<CUserInventoryItem, 17>();
+	}
+	catch (exception& e)
+	{
+		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::GetFirstExtendableItemByItemID: database internal error: %s, %d\n"), e.what(), GetDatabase().getErrorCode());
+		return -1;
+	}
+
+	return 1;
+}
+
+// gets user inventory items count
+// returns -1 == database error, items count on success
+int CUserDatabaseSQLite::GetInventoryItemsCount(int userID)
+{
+	PROFILE_DB();
+	lock_guard<recursive_mutex> lock(GetMutex());
+
+	CUserInventory* inventory = GetCachedInventory(userID);
+	if (inventory)
+		return inventory->GetItemCount();
+
+	try
+	{
+		CCachedStatement query = CACHED_STATEMENT("SELECT COUNT(1) FROM UserInventory WHERE userID = ? AND itemID != 0");
+		query->bind(1, userID);
+		query->executeStep();
+
+		return (int)query->getColumn(0);
+	}
+	catch (exception& e)
+	{
+		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::GetInventoryItemsCount: database internal error: %s, %d\n"), e.what(), GetDatabase().getErrorCode());
+		return -1;
+	}
+}
+
+// checks if user inventory is full
+// returns 0 == inventory is not full, 1 == database error or inventory is full
+int CUserDatabaseSQLite::IsInventoryFull(int userID)
+{
+	PROFILE_DB();
+	lock_guard<recursive_mutex> lock(GetMutex());
+
+	CUserInventory* inventory = GetCachedInventory(userID);
+	if (inventory)
+		return inventory->GetItemCount() >= g_pServerConfig->inventorySlotMax;
+
+	try
+	{
+		CCachedStatement query = CACHED_STATEMENT("SELECT COUNT(1) FROM UserInventory WHERE userID = ? AND itemID != 0");
+		query->bind(1, userID);
+		query->executeStep();
+
+		if ((int)query->getColumn(0) >= g_pServerConfig->inventorySlotMax)
+		{
+			return 1;
+		}
+	}
+	catch (exception& e)
+	{
+		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::IsInventoryFull: database internal error: %s, %d\n"), e.what(), GetDatabase().getErrorCode());
+		return 1;
+	}
+
+	return 0;
+}
+
+// reads user inventory rows for CacheInventory, doesn't use the inventory cache, so it can be called on the database thread.
+// version receives the inventory version the rows belong to
+// returns 0 == database error, 1 on success
+int CUserDatabaseSQLite::ReadInventory(int userID, vector<CUserInventoryItem>& items, int& nextSlot, unsigned int& version)
+{
+	PROFILE_DB();
+	lock_guard<recursive_mutex> lock(GetMutex());
+
+	// taken before the read, a write committed after this is treated as not read
+	version = m_nInventoryVersion;
+
+	try
+	{
+		CCachedStatement query = CACHED_STATEMENT("SELECT * FROM UserInventory WHERE userID = ?");
+		query->bind(1, userID);
+
+		while (query->executeStep())
+		{
+			items.push_back(query->getColumns<CUserInventoryItem, 17>());
+		}
+
+		nextSlot = 0;
+
+		CCachedStatement queryGetNextInvSlot = CACHED_STATEMENT("SELECT nextInventorySlot FROM UserCharacterExtended WHERE userID = ? LIMIT 1");
+		queryGetNextInvSlot->bind(1, userID);
+		if (queryGetNextInvSlot->executeStep())
+			nextSlot = queryGetNextInvSlot->getColumn(0);
+	}
+	catch (exception& e)
+	{
+		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::ReadInventory: database internal error: %s, %d\n"), e.what(), GetDatabase().getErrorCode());
+		return 0;
+	}
+
+	return 1;
+}
+
+// loads inventory rows read by ReadInventory to memory, the inventory methods use it instead of UserInventory table until UnloadInventory is called.
+// Outdated rows (the inventory was written without the cache after they were read) are read again. Called on the event thread
+// returns 0 == database error, 1 on success
+int CUserDatabaseSQLite::CacheInventory(int userID, const vector<CUserInventoryItem>& items, int nextSlot, unsigned int version)
+{
+	PROFILE_DB();
+	lock_guard<recursive_mutex> lock(GetMutex());
+
+	if (GetCachedInventory(userID))
+		return 1;
+
+	if (version != m_nInventoryVersion)
+	{
+		vector<CUserInventoryItem> currentItems;
+		int currentNextSlot = 0;
+		if (!ReadInventory(userID, currentItems, currentNextSlot, version))
+			return 0;
+
+		m_Inventories[userID] = new CUserInventory(currentItems, currentNextSlot);
+		return 1;
+	}
+
+	m_Inventories[userID] = new CUserInventory(items, nextSlot);
+
+	return 1;
+}
+
+// writes changed rows of loaded user inventory, must be followed by OnInventoryFlushed after transaction is committed
+// returns -1 == database error, number of written rows on success
+int CUserDatabaseSQLite::FlushInventory(int userID)
+{
+	PROFILE_DB();
+	lock_guard<recursive_mutex> lock(GetMutex());
+
+	CUserInventory* inventory = GetCachedInventory(userID);
+	if (!inventory || !inventory->IsDirty())
+		return 0;
+
+	vector<CUserInventoryItem> insertedItems;
+	vector<CUserInventoryItem> updatedItems;
+	inventory->GetChanges(insertedItems, updatedItems);
+
+	try
+	{
+		if (!insertedItems.empty())
+		{
+			CCachedStatement query = CACHED_STATEMENT("INSERT INTO UserInventory VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?)");
+			for (auto& item : insertedItems)
+			{
+				query->bind(1, userID);
+				query->bind(2, item.m_nSlot);
+				query->bind(3, item.m_nItemID);
+				query->bind(4, item.m_nCount);
+				query->bind(5, item.m_nStatus);
+				query->bind(6, item.m_nInUse);
+				query->bind(7, item.m_nObtainDate);
+				query->bind(8, item.m_nExpiryDate);
+				query->bind(9, item.m_nIsClanItem);
+				query->bind(10, item.m_nEnhancementLevel);
+				query->bind(11, item.m_nEnhancementExp);
+				query->bind(12, item.m_nEnhanceValue);
+				query->bind(13, item.m_nPaintID);
+				query->bind(14, serialize_array_int(item.m_nPaintIDList));
+				query->bind(15, item.m_nPartSlot1);
+				query->bind(16, item.m_nPartSlot2);
+				query->bind(17, item.m_nLockStatus);
+				query->exec();
+				query->reset();
+			}
+
+			CCachedStatement queryUpdateNextInvSlot = CACHED_STATEMENT("UPDATE UserCharacterExtended SET nextInventorySlot = ? WHERE userID = ?");
+			queryUpdateNextInvSlot->bind(1, inventory->GetNextSlot());
+			queryUpdateNextInvSlot->bind(2, userID);
+			queryUpdateNextInvSlot->exec();
+		}
+
+		if (!updatedItems.empty())
+		{
+			CCachedStatement query = CACHED_STATEMENT("UPDATE UserInventory SET itemID = ?, count = ?, status = ?, inUse = ?, obtainDate = ?, expiryDate = ?, isClanItem = ?, enhancementLevel = ?, enhancementExp = ?, enhanceValue = ?, paintID = ?, paintIDList = ?, partSlot1 = ?, partSlot2 = ?, lockStatus = ? WHERE userID = ? AND slot = ?");
+			for (auto& item : updatedItems)
+			{
+				query->bind(1, item.m_nItemID);
+				query->bind(2, item.m_nCount);
+				query->bind(3, item.m_nStatus);
+				query->bind(4, item.m_nInUse);
+				query->bind(5, item.m_nObtainDate);
+				query->bind(6, item.m_nExpiryDate);
+				query->bind(7, item.m_nIsClanItem);
+				query->bind(8, item.m_nEnhancementLevel);
+				query->bind(9, item.m_nEnhancementExp);
+				query->bind(10, item.m_nEnhanceValue);
+				query->bind(11, item.m_nPaintID);
+				query->bind(12, serialize_array_int(item.m_nPaintIDList));
+				query->bind(13, item.m_nPartSlot1);
+				query->bind(14, item.m_nPartSlot2);
+				query->bind(15, item.m_nLockStatus);
+				query->bind(16, userID);
+				query->bind(17, item.m_nSlot);
+				query->exec();
+				query->reset();
+			}
+		}
+	}
+	catch (exception& e)
+	{
+		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::FlushInventory: database internal error: %s, %d\n"), e.what(), GetDatabase().getErrorCode());
+
+		// keep rows dirty to write them on the next flush
+		inventory->OnFlushed(false);
+		return -1;
+	}
+
+	return insertedItems.size() + updatedItems.size();
+}
+
+// called after transaction with FlushInventory is finished
+void CUserDatabaseSQLite::OnInventoryFlushed(int userID, bool committed)
+{
+	PROFILE_DB();
+	lock_guard<recursive_mutex> lock(GetMutex());
+
+	CUserInventory* inventory = GetCachedInventory(userID);
+	if (inventory)
+		inventory->OnFlushed(committed);
+}
+
+// writes and removes loaded user inventory
+void CUserDatabaseSQLite::UnloadInventory(int userID)
+{
+	PROFILE_DB();
+	lock_guard<recursive_mutex> lock(GetMutex());
+
+	auto it = m_Inventories.find(userID);
+	if (it == m_Inventories.end())
+		return;
+
+	bool transaction = !m_pTransaction;
+	if (transaction)
+		CreateTransaction();
+
+	bool committed = FlushInventory(userID) >= 0;
+	if (transaction)
+		committed = CommitTransaction() && committed;
+
+	if (!committed)
+		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::UnloadInventory: failed to write inventory of user %d\n"), userID);
+
+	delete it->second;
+	m_Inventories.erase(it);
+}
+
+CUserInventory* CUserDatabaseSQLite::GetCachedInventory(int userID)
+{
+	auto it = m_Inventories.find(userID);
+	if (it == m_Inventories.end())
+		return NULL;
+
+	return it->second;
+}
+
+CCachedStatement::CCachedStatement(SQLite::Database& database, CachedStatement_s& cached, const char* sql) : m_Cached(cached)
+{
+	bool write;
+	if (m_Cached.inUse)
+	{
+		m_pStatement = new SQLite::Statement(database, sql);
+		write = strncmp(sql, "SELECT", 6) != 0;
+	}
+	else
+	{
+		if (!m_Cached.statement)
+		{
+			m_Cached.statement = new SQLite::Statement(database, sql);
+			m_Cached.write = strncmp(sql, "SELECT", 6) != 0;
+		}
+
+		m_pStatement = m_Cached.statement;
+		m_Cached.inUse = true;
+		write = m_Cached.write;
+	}
+
+	m_Cached.executions++;
+
+	m_pDatabase = database.getHandle();
+	m_nTotalChanges = write ? sqlite3_total_changes(m_pDatabase) : -1;
+}
+
+CCachedStatement::~CCachedStatement()
+{
+	// sqlite3_changes() belongs to the last finished write, count it only if this statement changed something
+	if (m_nTotalChanges != -1 && sqlite3_total_changes(m_pDatabase) != m_nTotalChanges)
+		CProfiler::AddRows(sqlite3_changes(m_pDatabase));
+
+	if (m_pStatement != m_Cached.statement)
+	{
+		delete m_pStatement;
+		return;
+	}
+
+	try
+	{
+		m_pStatement->reset();
+	}
+	catch (exception&)
+	{
+		// reset returns error of the last step, it was already reported by the caller
+	}
+
+	m_pStatement->clearBindings();
+	m_Cached.inUse = false;
+}
+
+CWriteTransaction::CWriteTransaction(SQLite::Database& database) : m_Database(database)
+{
+	m_bCommitted = false;
+
+	m_Database.exec(OBFUSCATE("BEGIN IMMEDIATE"));
+}
+
+CWriteTransaction::~CWriteTransaction()
+{
+	if (m_bCommitted)
+		return;
+
+	try
+	{
+		m_Database.exec(OBFUSCATE("ROLLBACK"));
+	}
+	catch (exception&)
+	{
+		// some errors roll back the transaction by themselves
+	}
+}
+
+void CWriteTransaction::Commit()
+{
+	m_Database.exec(OBFUSCATE("COMMIT"));
+	m_bCommitted = true;
+}
+
+CCachedStatement CUserDatabaseSQLite::GetStatement(int callSite, const char* sql)
+{
+	if (m_pAsyncDatabase && g_UserDatabaseAsync.IsDatabaseThread())
+		return CCachedStatement(*m_pAsyncDatabase, m_AsyncStatements[callSite], sql);
+
+	return CCachedStatement(m_Database, m_Statements[callSite], sql);
+}
+
+CCachedStatement CUserDatabaseSQLite::GetStatement(const string& sql)
+{
+	if (m_pAsyncDatabase && g_UserDatabaseAsync.IsDatabaseThread())
+		return CCachedStatement(*m_pAsyncDatabase, m_AsyncQueryStatements[sql], sql.c_str());
+
+	return CCachedStatement(m_Database, m_QueryStatements[sql], sql.c_str());
+}
+
+// finalizes cached statements of the main connection, execution counters are kept
+void CUserDatabaseSQLite::ClearStatementCache()
+{
+	for (auto& cached : m_Statements)
+	{
+		delete cached.second.statement;
+		cached.second.statement = NULL;
 	}
 
-	return 1;
+	for (auto& cached : m_QueryStatements)
+	{
+		delete cached.second.statement;
+		cached.second.statement = NULL;
+	}
 }
 
-// gets user inventory items by itemID
-// returns -1 == database error, 0 == no such item, 1 on success
-int CUserDatabaseSQLite::GetInventoryItemsByID(int userID, int itemID, vector<CUserInventoryItem>& items)
+// opens read-only connections and the checkpoint connection, the database must be in WAL mode
+void CUserDatabaseSQLite::OpenReadConnections()
 {
 	try
 	{
-		SQLite::Statement query(m_Database, OBFUSCATE("SELECT * FROM UserInventory WHERE userID = ? AND itemID = ?"));
-		query.bind(1, userID);
-		query.bind(2, itemID);
-
-		while (query.executeStep())
+		for (int i = 0; i < DB_READ_CONNECTIONS; i++)
 		{
-			CUserInventoryItem item = query.getColumns<CUserInventoryItem, 17>();
-			items.push_back(item);
+			ReadConnection_s* connection = new ReadConnection_s();
+			connection->database = new SQLite::Database(OBFUSCATE("UserDatabase.db3"), SQLite::OPEN_READONLY);
+			connection->database->setBusyTimeout(1000);
+
+			m_ReadConnections.push_back(connection);
 		}
 
-		if (items.empty())
-			return 0;
+		m_pCheckpointDatabase = new SQLite::Database(OBFUSCATE("UserDatabase.db3"), SQLite::OPEN_READWRITE);
 	}
 	catch (exception& e)
 	{
-		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::GetInventoryItemByID: database internal error: %s, %d\n"), e.what(), m_Database.getErrorCode());
-		return -1;
+		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::OpenReadConnections: failed to open connection: %s\n"), e.what());
 	}
 
-	return 1;
+	lock_guard<mutex> lock(m_ReadMutex);
+	m_FreeReadConnections = m_ReadConnections;
 }
 
-// gets user inventory item by slot
-// returns -1 == database error, 0 == no such slot, 1 on success
-int CUserDatabaseSQLite::GetInventoryItemBySlot(int userID, int slot, CUserInventoryItem& item)
+// must not be called while connections are in use
+void CUserDatabaseSQLite::CloseReadConnections()
 {
-	try
-	{
-		SQLite::Statement query(m_Database, OBFUSCATE("SELECT * FROM UserInventory WHERE userID = ? AND slot = ? LIMIT 1"));
-		query.bind(1, userID);
-		query.bind(2, slot);
+	lock_guard<mutex> lock(m_ReadMutex);
 
-		if (!query.executeStep())
-		{
-			return 0;
-		}
+	for (auto connection : m_ReadConnections)
+	{
+		for (auto& cached : connection->statements)
+			delete cached.second.statement;
 
-		item = query.getColumns<CUserInventoryItem, 17>();
+		delete connection->database;
+		delete connection;
 	}
-	catch (exception& e)
+
+	m_ReadConnections.clear();
+	m_FreeReadConnections.clear();
+}
+
+// copies committed WAL pages to the database file. PASSIVE checkpoint doesn't block the main connection and readers,
+// pages that are still read are copied by the next one. Called on the database thread
+void CUserDatabaseSQLite::Checkpoint()
+{
+	if (!m_pCheckpointDatabase)
+		return;
+
+	int logFrames = 0;
+	int checkpointedFrames = 0;
+	int result = sqlite3_wal_checkpoint_v2(m_pCheckpointDatabase->getHandle(), NULL, SQLITE_CHECKPOINT_PASSIVE, &logFrames, &checkpointedFrames);
+	if (result != SQLITE_OK)
 	{
-		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::GetInventoryItemBySlot: database internal error: %s, %d\n"), e.what(), m_Database.getErrorCode());
-		return -1;
+		Logger().Warn(OBFUSCATE("CUserDatabaseSQLite::Checkpoint: checkpoint failed: %d\n"), result);
+		return;
 	}
 
-	return 1;
+	if (checkpointedFrames < logFrames)
+	{
+		Logger().Info(OBFUSCATE("CUserDatabaseSQLite::Checkpoint: %d of %d WAL frames checkpointed\n"), checkpointedFrames, logFrames);
+	}
 }
 
-// gets first user inventory item by itemID
-// returns -1 == database error, 0 == no such item, 1 on success
-int CUserDatabaseSQLite::GetFirstItemByItemID(int userID, int itemID, CUserInventoryItem& item)
+// fills expiry timers with in use inventory items and clan storage items
+void CUserDatabaseSQLite::LoadExpiryTimers(time_t curTime)
 {
+	m_ExpiryTimers.Reset(curTime);
+
 	try
 	{
-		SQLite::Statement query(m_Database, OBFUSCATE("SELECT * FROM UserInventory WHERE userID = ? AND itemID = ? LIMIT 1"));
-		query.bind(1, userID);
-		query.bind(2, itemID);
-
-		if (!query.executeStep())
 		{
-			return 0;
+			CCachedStatement query = CACHED_STATEMENT("SELECT userID, slot, expiryDate FROM UserInventory WHERE expiryDate != 0 AND inUse = 1 AND itemID != 0");
+			while (query->executeStep())
+			{
+				int userID = query->getColumn(0);
+				int slot = query->getColumn(1);
+				int expiryDate = query->getColumn(2);
+
+				m_ExpiryTimers.Schedule(expiryDate + 1, ExpiryTimer_s{ EXPIRY_TIMER_INVENTORY, userID, 0, slot });
+			}
 		}
 
-		item = query.getColumns<CUserInventoryItem, 17>();
+		{
+			CCachedStatement query = CACHED_STATEMENT("SELECT clanID, pageID, slot, itemDuration FROM ClanStorageItem WHERE itemID != 0");
+			while (query->executeStep())
+			{
+				int clanID = query->getColumn(0);
+				int pageID = query->getColumn(1);
+				int slot = query->getColumn(2);
+				int itemDuration = query->getColumn(3);
+
+				m_ExpiryTimers.Schedule(itemDuration, ExpiryTimer_s{ EXPIRY_TIMER_CLAN_STORAGE, clanID, pageID, slot });
+			}
+		}
 	}
 	catch (exception& e)
 	{
-		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::GetFirstItemByItemID: database internal error: %s, %d\n"), e.what(), m_Database.getErrorCode());
-		return -1;
+		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::LoadExpiryTimers: database internal error: %s, %d\n"), e.what(), GetDatabase().getErrorCode());
 	}
 
-	return 1;
+	Logger().Info(OBFUSCATE("CUserDatabaseSQLite::LoadExpiryTimers: %d expiry timers loaded\n"), (int)m_ExpiryTimers.Size());
 }
 
-// gets first active user inventory item by itemID
-// returns -1 == database error, 0 == no such item, 1 on success
-int CUserDatabaseSQLite::GetFirstActiveItemByItemID(int userID, int itemID, CUserInventoryItem& item)
+// adds expiry timer for item with expiry date that is in use. Timers aren't removed when item changes,
+// ExpireInventoryItem checks the slot again
+void CUserDatabaseSQLite::ScheduleItemExpiry(int userID, const CUserInventoryItem& item)
 {
-	try
-	{
-		SQLite::Statement query(m_Database, OBFUSCATE("SELECT * FROM UserInventory WHERE userID = ? AND itemID = ? AND status = 1 AND inUse = 1 LIMIT 1"));
-		query.bind(1, userID);
-		query.bind(2, itemID);
+	if (item.m_nItemID && item.m_nExpiryDate != 0 && item.m_nInUse == 1)
+		m_ExpiryTimers.Schedule(item.m_nExpiryDate + 1, ExpiryTimer_s{ EXPIRY_TIMER_INVENTORY, userID, 0, item.m_nSlot });
+}
 
-		if (!query.executeStep())
-		{
-			return 0;
-		}
+// adds expiry timer for updated slot, update may contain only some of the fields
+void CUserDatabaseSQLite::ScheduleItemExpiry(int userID, int slot)
+{
+	CUserInventory* inventory = GetCachedInventory(userID);
+	if (inventory)
+	{
+		CUserInventoryItem* item = inventory->GetItemBySlot(slot);
+		if (item)
+			ScheduleItemExpiry(userID, *item);
 
-		item = query.getColumns<CUserInventoryItem, 17>();
+		return;
 	}
-	catch (exception& e)
+
+	CCachedStatement query = CACHED_STATEMENT("SELECT expiryDate FROM UserInventory WHERE userID = ? AND slot = ? AND itemID != 0 AND expiryDate != 0 AND inUse = 1 LIMIT 1");
+	query->bind(1, userID);
+	query->bind(2, slot);
+	if (query->executeStep())
 	{
-		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::GetFirstActiveItemByItemID: database internal error: %s, %d\n"), e.what(), m_Database.getErrorCode());
-		return -1;
+		int expiryDate = query->getColumn(0);
+		m_ExpiryTimers.Schedule(expiryDate + 1, ExpiryTimer_s{ EXPIRY_TIMER_INVENTORY, userID, 0, slot });
 	}
-
-	return 1;
 }
 
-// gets first user extendable inventory item by itemID
-// returns -1 == database error, 0 == no such item, 1 on success
-int CUserDatabaseSQLite::GetFirstExtendableItemByItemID(int userID, int itemID, CUserInventoryItem& item)
+// removes inventory item if it is still expired, the item may be removed, replaced or extended after the timer was added
+void CUserDatabaseSQLite::ExpireInventoryItem(int userID, int slot, time_t curTime)
 {
-	try
+	CUserInventoryItem item;
+	CUserInventory* inventory = GetCachedInventory(userID);
+	if (inventory)
+	{
+		CUserInventoryItem* cachedItem = inventory->GetItemBySlot(slot);
+		if (!cachedItem)
+			return;
+
+		item = *cachedItem;
+	}
+	else
 	{
-		SQLite::Statement query(m_Database, OBFUSCATE("SELECT * FROM UserInventory WHERE userID = ? AND itemID = ? AND expiryDate != 0 AND enhanceValue = 0 AND partSlot1 = 0 AND partSlot2 = 0 LIMIT 1"));
-		query.bind(1, userID);
-		query.bind(2, itemID);
+		try
+		{
+			CCachedStatement query = CACHED_STATEMENT("SELECT itemID, status, inUse, expiryDate FROM UserInventory WHERE userID = ? AND slot = ? LIMIT 1");
+			query->bind(1, userID);
+			query->bind(2, slot);
+			if (!query->executeStep())
+				return;
 
-		if (!query.executeStep())
+			item = CUserInventoryItem(slot, query->getColumn(0), 0, query->getColumn(1), query->getColumn(2), 0, query->getColumn(3), 0, 0, 0, 0, 0, {}, 0, 0, 0);
+		}
+		catch (exception& e)
 		{
-			return 0;
+			Logger().Error(OBFUSCATE("CUserDatabaseSQLite::ExpireInventoryItem: database internal error: %s, %d\n"), e.what(), GetDatabase().getErrorCode());
+			return;
 		}
+	}
+
+	if (!item.m_nItemID || item.m_nExpiryDate == 0 || item.m_nInUse != 1 || item.m_nExpiryDate >= curTime)
+		return;
+
+	IUser* user = g_UserManager.GetUserById(userID);
+	if (user)
+		g_PacketManager.SendUMsgExpiryNotice(user->GetExtendedSocket(), vector<int>{ item.m_nItemID });
+	else
+		UpdateExpiryNotices(userID, item.m_nItemID);
 
-		item = query.getColumns<CUserInventoryItem, 17>();
+	g_ItemManager.RemoveItem(userID, user, item);
+}
+
+void CUserDatabaseSQLite::ExpireClanStorageItem(int clanID, int pageID, int slot, time_t curTime)
+{
+	try
+	{
+		CCachedStatement query = CACHED_STATEMENT("UPDATE ClanStorageItem SET itemID = 0, itemDuration = 0, itemCount = 0 WHERE clanID = ? AND pageID = ? AND slot = ? AND itemID != 0 AND itemDuration <= ?");
+		query->bind(1, clanID);
+		query->bind(2, pageID);
+		query->bind(3, slot);
+		query->bind(4, curTime);
+		query->exec();
 	}
 	catch (exception& e)
 	{
-		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::GetFirstExtendableItemByItemID: database internal error: %s, %d\n"), e.what(), m_Database.getErrorCode());
-		return -1;
+		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::ExpireClanStorageItem: database internal error: %s, %d\n"), e.what(), GetDatabase().getErrorCode());
 	}
-
-	return 1;
 }
 
-// gets user inventory items count
-// returns -1 == database error, items count on success
-int CUserDatabaseSQLite::GetInventoryItemsCount(int userID)
+CReadConnection::CReadConnection(CUserDatabaseSQLite& userDatabase) : m_UserDatabase(userDatabase)
 {
-	try
+	m_pConnection = NULL;
+
+	unique_lock<mutex> lock(m_UserDatabase.m_ReadMutex);
+	if (m_UserDatabase.m_ReadConnections.empty())
 	{
-		SQLite::Statement query(m_Database, OBFUSCATE("SELECT COUNT(1) FROM UserInventory WHERE userID = ? AND itemID != 0"));
-		query.bind(1, userID);
-		query.executeStep();
+		lock.unlock();
 
-		return (int)query.getColumn(0);
+		m_UserDatabase.GetMutex().lock();
+		return;
 	}
-	catch (exception& e)
+
+	m_UserDatabase.m_ReadCondition.wait(lock, [this]() { return !m_UserDatabase.m_FreeReadConnections.empty(); });
+
+	m_pConnection = m_UserDatabase.m_FreeReadConnections.back();
+	m_UserDatabase.m_FreeReadConnections.pop_back();
+}
+
+CReadConnection::~CReadConnection()
+{
+	if (!m_pConnection)
 	{
-		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::GetInventoryItemsCount: database internal error: %s, %d\n"), e.what(), m_Database.getErrorCode());
-		return -1;
+		m_UserDatabase.GetMutex().unlock();
+		return;
 	}
+
+	{
+		lock_guard<mutex> lock(m_UserDatabase.m_ReadMutex);
+		m_UserDatabase.m_FreeReadConnections.push_back(m_pConnection);
+	}
+
+	m_UserDatabase.m_ReadCondition.notify_one();
 }
 
-// checks if user inventory is full
-// returns 0 == inventory is not full, 1 == database error or inventory is full
-int CUserDatabaseSQLite::IsInventoryFull(int userID)
+CCachedStatement CReadConnection::GetStatement(int callSite, const char* sql)
+{
+	if (!m_pConnection)
+		return m_UserDatabase.GetStatement(callSite, sql);
+
+	return CCachedStatement(*m_pConnection->database, m_pConnection->statements[callSite], sql);
+}
+
+// gets query plan steps of statement which scan whole table without index
+// returns false on database error
+bool CUserDatabaseSQLite::GetFullScans(const string& statement, vector<string>& scans)
 {
 	try
 	{
-		SQLite::Statement query(m_Database, OBFUSCATE("SELECT COUNT(1) FROM UserInventory WHERE userID = ? AND itemID != 0"));
-		query.bind(1, userID);
-		query.executeStep();
-
-		if ((int)query.getColumn(0) >= g_pServerConfig->inventorySlotMax)
+		SQLite::Statement query(m_Database, OBFUSCATE("EXPLAIN QUERY PLAN ") + statement);
+		while (query.executeStep())
 		{
-			return 1;
+			string detail = query.getColumn(3).getString();
+
+			// "SCAN table" without "USING INDEX" reads every row (older SQLite versions print "SCAN TABLE table")
+			if (detail.compare(0, 4, "SCAN") == 0 && detail.find(" USING ") == string::npos)
+				scans.push_back(detail);
 		}
 	}
 	catch (exception& e)
 	{
-		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::IsInventoryFull: database internal error: %s, %d\n"), e.what(), m_Database.getErrorCode());
-		return 1;
+		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::GetFullScans(%s): database internal error: %s, %d\n"), statement.c_str(), e.what(), m_Database.getErrorCode());
+		return false;
 	}
 
+	return true;
+}
+
+int CUserDatabaseSQLite::OnStatementTrace(unsigned int type, void* context, void* p, void* x)
+{
+	CUserDatabaseSQLite* database = (CUserDatabaseSQLite*)context;
+
+	const char* sql = sqlite3_sql((sqlite3_stmt*)p);
+	if (!sql || database->m_RecordedStatements.size() >= MAX_RECORDED_STATEMENTS)
+		return 0;
+
+	// skip statements of the audit itself and transaction control
+	if (!strncmp(sql, "EXPLAIN", 7) || !strncmp(sql, "PRAGMA", 6) || !strncmp(sql, "BEGIN", 5) || !strncmp(sql, "COMMIT", 6) || !strncmp(sql, "ROLLBACK", 8))
+		return 0;
+
+	database->m_RecordedStatements.insert(sql);
+
 	return 0;
 }
 
@@ -1668,6 +2932,9 @@ string GetUserDataString(int flag, bool update)
 // returns 0 == database error, 1 on success
 int CUserDatabaseSQLite::GetUserData(int userID, CUserData& data)
 {
+	PROFILE_DB();
+	lock_guard<recursive_mutex> lock(GetMutex());
+
 	try
 	{
 		// format query
@@ -1675,46 +2942,46 @@ int CUserDatabaseSQLite::GetUserData(int userID, CUserData& data)
 		query[query.size() - 1] = ' ';
 		query += OBFUSCATE("FROM User WHERE userID = ? LIMIT 1"); // TODO: use stringstream
 
-		SQLite::Statement statement(m_Database, query);
-		statement.bind(1, userID);
+		CCachedStatement statement = GetStatement(query);
+		statement->bind(1, userID);
 
-		if (statement.executeStep())
+		if (statement->executeStep())
 		{
 			int index = 0;
 			if (data.flag & UDATA_FLAG_USERNAME)
 			{
-				string userName = statement.getColumn(index++);
+				string userName = statement->getColumn(index++);
 				data.userName = userName;
 			}
 			if (data.flag & UDATA_FLAG_PASSWORD)
 			{
-				string password = statement.getColumn(index++);
+				string password = statement->getColumn(index++);
 				data.password = password;
 			}
 			if (data.flag & UDATA_FLAG_REGISTERTIME)
 			{
-				data.registerTime = statement.getColumn(index++);
+				data.registerTime = statement->getColumn(index++);
 			}
 			if (data.flag & UDATA_FLAG_REGISTERIP)
 			{
-				data.registerIP = statement.getColumn(index++).getString();
+				data.registerIP = statement->getColumn(index++).getString();
 			}
 			if (data.flag & UDATA_FLAG_FIRSTLOGONTIME)
 			{
-				data.firstLogonTime = statement.getColumn(index++);
+				data.firstLogonTime = statement->getColumn(index++);
 			}
 			if (data.flag & UDATA_FLAG_LASTLOGONTIME)
 			{
-				data.lastLogonTime = statement.getColumn(index++);
+				data.lastLogonTime = statement->getColumn(index++);
 			}
 			if (data.flag & UDATA_FLAG_LASTIP)
 			{
-				string lastIP = statement.getColumn(index++);
+				string lastIP = statement->getColumn(index++);
 				data.lastIP = lastIP;
 			}
 			if (data.flag & UDATA_FLAG_LASTHWID)
 			{
-				SQLite::Column lastHWID = statement.getColumn(index++);
+				SQLite::Column lastHWID = statement->getColumn(index++);
 				data.lastHWID.assign((unsigned char*)lastHWID.getBlob(), (unsigned char*)lastHWID.getBlob() + lastHWID.getBytes());
 			}
 		}
@@ -1725,7 +2992,7 @@ int CUserDatabaseSQLite::GetUserData(int userID, CUserData& data)
 	}
 	catch (exception& e)
 	{
-		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::GetUserData: database internal error: %s, %d\n"), e.what(), m_Database.getErrorCode());
+		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::GetUserData: database internal error: %s, %d\n"), e.what(), GetDatabase().getErrorCode());
 		return 0;
 	}
 
@@ -1736,6 +3003,9 @@ int CUserDatabaseSQLite::GetUserData(int userID, CUserData& data)
 // returns 0 == database error, 1 on success
 int CUserDatabaseSQLite::UpdateUserData(int userID, CUserData data)
 {
+	PROFILE_DB();
+	lock_guard<recursive_mutex> lock(GetMutex());
+
 	try
 	{
 		// format query
@@ -1743,48 +3013,48 @@ int CUserDatabaseSQLite::UpdateUserData(int userID, CUserData data)
 		query[query.size() - 1] = ' ';
 		query += OBFUSCATE("WHERE userID = ?");
 
-		SQLite::Statement statement(m_Database, query);
+		CCachedStatement statement = GetStatement(query);
 		int index = 1;
 
 		if (data.flag & UDATA_FLAG_USERNAME)
 		{
-			statement.bind(index++, data.userName);
+			statement->bind(index++, data.userName);
 		}
 		if (data.flag & UDATA_FLAG_PASSWORD)
 		{
-			statement.bind(index++, data.password);
+			statement->bind(index++, data.password);
 		}
 		if (data.flag & UDATA_FLAG_REGISTERTIME)
 		{
-			statement.bind(index++, data.registerTime);
+			statement->bind(index++, data.registerTime);
 		}
 		if (data.flag & UDATA_FLAG_REGISTERIP)
 		{
-			statement.bind(index++, data.registerIP);
+			statement->bind(index++, data.registerIP);
 		}
 		if (data.flag & UDATA_FLAG_FIRSTLOGONTIME)
 		{
-			statement.bind(index++, data.firstLogonTime);
+			statement->bind(index++, data.firstLogonTime);
 		}
 		if (data.flag & UDATA_FLAG_LASTLOGONTIME)
 		{
-			statement.bind(index++, data.lastLogonTime);
+			statement->bind(index++, data.lastLogonTime);
 		}
 		if (data.flag & UDATA_FLAG_LASTIP)
 		{
-			statement.bind(index++, data.lastIP);
+			statement->bind(index++, data.lastIP);
 		}
 		if (data.flag & UDATA_FLAG_LASTHWID)
 		{
 			void* hwid = data.lastHWID.data();
-			statement.bind(index++, hwid, data.lastHWID.size());
+			statement->bind(index++, hwid, data.lastHWID.size());
 		}
-		statement.bind(index++, userID);
-		statement.exec();
+		statement->bind(index++, userID);
+		statement->exec();
 	}
 	catch (exception& e)
 	{
-		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::UpdateUserData: database internal error: %s, %d\n"), e.what(), m_Database.getErrorCode());
+		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::UpdateUserData: database internal error: %s, %d\n"), e.what(), GetDatabase().getErrorCode());
 		return 0;
 	}
 
@@ -1795,53 +3065,56 @@ int CUserDatabaseSQLite::UpdateUserData(int userID, CUserData data)
 // returns 0 == database error, 1 on success
 int CUserDatabaseSQLite::CreateCharacter(int userID, const string& gameName)
 {
+	PROFILE_DB();
+	lock_guard<recursive_mutex> lock(GetMutex());
+
 	try
 	{
 		DefaultUser defUser = g_pServerConfig->defUser;
 
-		SQLite::Transaction transcation(m_Database);
-		SQLite::Statement insertCharacter(m_Database, OBFUSCATE("INSERT INTO UserCharacter VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?)"));
-		insertCharacter.bind(1, userID);
-		insertCharacter.bind(2, gameName);
-		insertCharacter.bind(3, (int64_t)defUser.exp);
-		insertCharacter.bind(4, defUser.level);
-		insertCharacter.bind(5, (int64_t)defUser.points);
-		insertCharacter.bind(6, 0); // cash
-		insertCharacter.bind(7, defUser.battles);
-		insertCharacter.bind(8, defUser.win);
-		insertCharacter.bind(9, defUser.kills);
-		insertCharacter.bind(10, defUser.deaths);
-		insertCharacter.bind(11, 0); // nation
-		insertCharacter.bind(12, 0); // city
-		insertCharacter.bind(13, 0); // town
-		insertCharacter.bind(14, 0); // league
-		insertCharacter.bind(15, defUser.passwordBoxes);
-		insertCharacter.bind(16, defUser.mileagePoints);
-		insertCharacter.bind(17, defUser.honorPoints);
-		insertCharacter.bind(18, defUser.prefixID);
-		insertCharacter.bind(19, OBFUSCATE(""));
-		insertCharacter.bind(20, OBFUSCATE("0,0,0,0,0"));
-		insertCharacter.bind(21, 0); // clan
-		insertCharacter.bind(22, 0); // tournament hud
-		insertCharacter.bind(23, 0); // nameplateID
-		insertCharacter.bind(24, 0); // chatColorID
-		insertCharacter.exec();
-
-		SQLite::Statement insertCharacterExtended(m_Database, OBFUSCATE("INSERT INTO UserCharacterExtended VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?)"));
-		insertCharacterExtended.bind(1, userID);
-		insertCharacterExtended.bind(2, defUser.gameMaster);
-		insertCharacterExtended.bind(3, 100); // gachapon kills
-		insertCharacterExtended.bind(4, 1);
-		insertCharacterExtended.bind(5, OBFUSCATE(""));
-		insertCharacterExtended.bind(6, 0);
-		insertCharacterExtended.bind(7, 0);
-		insertCharacterExtended.bind(8, 2); // ban settings
-		insertCharacterExtended.bind(9, ""); // 2nd password
-		insertCharacterExtended.bind(10, 0); // security question
-		insertCharacterExtended.bind(11, ""); // security answer
-		insertCharacterExtended.bind(12, 0); // zbRespawnEffect
-		insertCharacterExtended.bind(13, 0); // killerMarkEffect
-		insertCharacterExtended.exec();
+		CWriteTransaction transcation(GetDatabase());
+		CCachedStatement insertCharacter = CACHED_STATEMENT("INSERT INTO UserCharacter VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?)");
+		insertCharacter->bind(1, userID);
+		insertCharacter->bind(2, gameName);
+		insertCharacter->bind(3, (int64_t)defUser.exp);
+		insertCharacter->bind(4, defUser.level);
+		insertCharacter->bind(5, (int64_t)defUser.points);
+		insertCharacter->bind(6, 0); // cash
+		insertCharacter->bind(7, defUser.battles);
+		insertCharacter->bind(8, defUser.win);
+		insertCharacter->bind(9, defUser.kills);
+		insertCharacter->bind(10, defUser.deaths);
+		insertCharacter->bind(11, 0); // nation
+		insertCharacter->bind(12, 0); // city
+		insertCharacter->bind(13, 0); // town
+		insertCharacter->bind(14, 0); // league
+		insertCharacter->bind(15, defUser.passwordBoxes);
+		insertCharacter->bind(16, defUser.mileagePoints);
+		insertCharacter->bind(17, defUser.honorPoints);
+		insertCharacter->bind(18, defUser.prefixID);
+		insertCharacter->bind(19, OBFUSCATE(""));
+		insertCharacter->bind(20, OBFUSCATE("0,0,0,0,0"));
+		insertCharacter->bind(21, 0); // clan
+		insertCharacter->bind(22, 0); // tournament hud
+		insertCharacter->bind(23, 0); // nameplateID
+		insertCharacter->bind(24, 0); // chatColorID
+		insertCharacter->exec();
+
+		CCachedStatement insertCharacterExtended = CACHED_STATEMENT("INSERT INTO UserCharacterExtended VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?)");
+		insertCharacterExtended->bind(1, userID);
+		insertCharacterExtended->bind(2, defUser.gameMaster);
+		insertCharacterExtended->bind(3, 100); // gachapon kills
+		insertCharacterExtended->bind(4, 1);
+		insertCharacterExtended->bind(5, OBFUSCATE(""));
+		insertCharacterExtended->bind(6, 0);
+		insertCharacterExtended->bind(7, 0);
+		insertCharacterExtended->bind(8, 2); // ban settings
+		insertCharacterExtended->bind(9, ""); // 2nd password
+		insertCharacterExtended->bind(10, 0); // security question
+		insertCharacterExtended->bind(11, ""); // security answer
+		insertCharacterExtended->bind(12, 0); // zbRespawnEffect
+		insertCharacterExtended->bind(13, 0); // killerMarkEffect
+		insertCharacterExtended->exec();
 
 		if ((int)defUser.loadouts.size())
 		{
@@ -1853,7 +3126,7 @@ int CUserDatabaseSQLite::CreateCharacter(int userID, const string& gameName)
 				query += OBFUSCATE(", (?, ?, ?, ?, ?, ?)");
 			}
 
-			SQLite::Statement statement(m_Database, query);
+			SQLite::Statement statement(GetDatabase(), query);
 
 			int bindIndex = 1;
 
@@ -1880,7 +3153,7 @@ int CUserDatabaseSQLite::CreateCharacter(int userID, const string& gameName)
 				query += OBFUSCATE(", (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?)");
 			}
 
-			SQLite::Statement statement(m_Database, query);
+			SQLite::Statement statement(GetDatabase(), query);
 
 			int bindIndex = 1;
 
@@ -1906,7 +3179,7 @@ int CUserDatabaseSQLite::CreateCharacter(int userID, const string& gameName)
 				query += OBFUSCATE(", (?, ?, ?, ?)");
 			}
 
-			SQLite::Statement statement(m_Database, query);
+			SQLite::Statement statement(GetDatabase(), query);
 
 			int bindIndex = 1;
 
@@ -1922,13 +3195,13 @@ int CUserDatabaseSQLite::CreateCharacter(int userID, const string& gameName)
 		}
 
 		{
-			SQLite::Statement statement(m_Database, OBFUSCATE("INSERT INTO UserRank VALUES (?, ?, ?, ?, ?)"));
-			statement.bind(1, userID);
-			statement.bind(2, 71); // No Record tier Original
-			statement.bind(3, 71); // No Record tier Zombie
-			statement.bind(4, 71); // No Record tier Zombie PVE
-			statement.bind(5, 71); // No Record tier Death Match
-			statement.exec();
+			CCachedStatement statement = CACHED_STATEMENT("INSERT INTO UserRank VALUES (?, ?, ?, ?, ?)");
+			statement->bind(1, userID);
+			statement->bind(2, 71); // No Record tier Original
+			statement->bind(3, 71); // No Record tier Zombie
+			statement->bind(4, 71); // No Record tier Zombie PVE
+			statement->bind(5, 71); // No Record tier Death Match
+			statement->exec();
 		}
 
 		// init daily rewards
@@ -1937,11 +3210,11 @@ int CUserDatabaseSQLite::CreateCharacter(int userID, const string& gameName)
 		g_ItemManager.UpdateDailyRewardsRandomItems(dailyReward);
 		UpdateDailyRewards(userID, dailyReward);*/
 
-		transcation.commit();
+		transcation.Commit();
 	}
 	catch (exception& e)
 	{
-		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::CreateCharacter: database internal error: %s, %d\n"), e.what(), m_Database.getErrorCode());
+		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::CreateCharacter: database internal error: %s, %d\n"), e.what(), GetDatabase().getErrorCode());
 		return 0;
 	}
 
@@ -1952,15 +3225,18 @@ int CUserDatabaseSQLite::CreateCharacter(int userID, const string& gameName)
 // returns 0 == database error, 1 on success
 int CUserDatabaseSQLite::DeleteCharacter(int userID)
 {
+	PROFILE_DB();
+	lock_guard<recursive_mutex> lock(GetMutex());
+
 	try
 	{
-		SQLite::Statement query(m_Database, OBFUSCATE("DELETE FROM UserCharacter WHERE userID = ?"));
-		query.bind(1, userID);
-		query.exec();
+		CCachedStatement query = CACHED_STATEMENT("DELETE FROM UserCharacter WHERE userID = ?");
+		query->bind(1, userID);
+		query->exec();
 	}
 	catch (exception& e)
 	{
-		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::DeleteCharacter: database internal error: %s, %d\n"), e.what(), m_Database.getErrorCode());
+		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::DeleteCharacter: database internal error: %s, %d\n"), e.what(), GetDatabase().getErrorCode());
 		return 0;
 	}
 
@@ -2041,6 +3317,9 @@ string GetCharacterString(CUserCharacter& character, bool update)
 // returns -1 == character doesn't exist, 0 == database error, 1 on success
 int CUserDatabaseSQLite::GetCharacter(int userID, CUserCharacter& character)
 {
+	PROFILE_DB();
+	lock_guard<recursive_mutex> lock(GetMutex());
+
 	try
 	{
 		// format query
@@ -2048,102 +3327,102 @@ int CUserDatabaseSQLite::GetCharacter(int userID, CUserCharacter& character)
 		query[query.size() - 1] = ' ';
 		query += OBFUSCATE("FROM UserCharacter WHERE userID = ? LIMIT 1"); // TODO: use stringstream
 
-		SQLite::Statement statement(m_Database, query);
-		statement.bind(1, userID);
+		CCachedStatement statement = GetStatement(query);
+		statement->bind(1, userID);
 
-		if (statement.executeStep())
+		if (statement->executeStep())
 		{
 			int index = 0;
 			if (character.lowFlag & UFLAG_LOW_NAMEPLATE)
 			{
-				character.nameplateID = statement.getColumn(index++);
+				character.nameplateID = statement->getColumn(index++);
 			}
 			if (character.lowFlag & UFLAG_LOW_GAMENAME)
 			{
-				string gameName = statement.getColumn(index++);
+				string gameName = statement->getColumn(index++);
 				character.gameName = gameName;
 			}
 			if (character.lowFlag & UFLAG_LOW_LEVEL)
 			{
-				character.level = statement.getColumn(index++);
+				character.level = statement->getColumn(index++);
 			}
 			if (character.lowFlag & UFLAG_LOW_EXP)
 			{
-				character.exp = statement.getColumn(index++); // no uint64 support ;(
+				character.exp = statement->getColumn(index++); // no uint64 support ;(
 			}
 			if (character.lowFlag & UFLAG_LOW_CASH)
 			{
-				character.cash = statement.getColumn(index++);
+				character.cash = statement->getColumn(index++);
 			}
 			if (character.lowFlag & UFLAG_LOW_POINTS)
 			{
-				character.points = statement.getColumn(index++);
+				character.points = statement->getColumn(index++);
 			}
 			if (character.lowFlag & UFLAG_LOW_STAT)
 			{
-				character.battles = statement.getColumn(index++);
-				character.win = statement.getColumn(index++);
-				character.kills = statement.getColumn(index++);
-				character.deaths = statement.getColumn(index++);
+				character.battles = statement->getColumn(index++);
+				character.win = statement->getColumn(index++);
+				character.kills = statement->getColumn(index++);
+				character.deaths = statement->getColumn(index++);
 			}
 			if (character.lowFlag & UFLAG_LOW_LOCATION)
 			{
-				character.nation = statement.getColumn(index++);
-				character.city = statement.getColumn(index++);
-				character.town = statement.getColumn(index++);
+				character.nation = statement->getColumn(index++);
+				character.city = statement->getColumn(index++);
+				character.town = statement->getColumn(index++);
 			}
 			if (character.lowFlag & UFLAG_LOW_RANK)
 			{
-				character.leagueID = statement.getColumn(index++);
+				character.leagueID = statement->getColumn(index++);
 
 				// TODO: rewrite
 				{
-					SQLite::Statement query(m_Database, OBFUSCATE("SELECT tierOri, tierZM, tierZPVE, tierDM FROM UserRank WHERE userID = ? LIMIT 1"));
-					query.bind(1, userID);
-					if (query.executeStep())
+					CCachedStatement query = CACHED_STATEMENT("SELECT tierOri, tierZM, tierZPVE, tierDM FROM UserRank WHERE userID = ? LIMIT 1");
+					query->bind(1, userID);
+					if (query->executeStep())
 					{
 						for (int i = 0; i < 4; i++)
 						{
-							character.tier[i] = query.getColumn(i);
+							character.tier[i] = query->getColumn(i);
 						}
 					}
 				}
 			}
 			if (character.lowFlag & UFLAG_LOW_PASSWORDBOXES)
 			{
-				character.passwordBoxes = statement.getColumn(index++);
+				character.passwordBoxes = statement->getColumn(index++);
 			}
 			if (character.lowFlag & UFLAG_LOW_ACHIEVEMENT)
 			{
-				character.honorPoints = statement.getColumn(index++);
-				character.prefixId = statement.getColumn(index++);
+				character.honorPoints = statement->getColumn(index++);
+				character.prefixId = statement->getColumn(index++);
 			}
 			if (character.lowFlag & UFLAG_LOW_ACHIEVEMENTLIST)
 			{
-				character.achievementList = deserialize_array_int(statement.getColumn(index++));
+				character.achievementList = deserialize_array_int(statement->getColumn(index++));
 			}
 			if (character.lowFlag & UFLAG_LOW_TITLES)
 			{
-				string serialized = statement.getColumn(index++);
+				string serialized = statement->getColumn(index++);
 				character.titles = deserialize_array_int(serialized);
 			}
 			if (character.lowFlag & UFLAG_LOW_CLAN)
 			{
-				character.clanID = statement.getColumn(index++);
-				character.clanMarkID = statement.getColumn(index++);
-				character.clanName = (const char*)statement.getColumn(index++);
+				character.clanID = statement->getColumn(index++);
+				character.clanMarkID = statement->getColumn(index++);
+				character.clanName = (const char*)statement->getColumn(index++);
 			}
 			if (character.lowFlag & UFLAG_LOW_TOURNAMENT)
 			{
-				character.tournament = statement.getColumn(index++);
+				character.tournament = statement->getColumn(index++);
 			}
 			if (character.lowFlag & UFLAG_LOW_UNK26)
 			{
-				character.mileagePoints = statement.getColumn(index++);
+				character.mileagePoints = statement->getColumn(index++);
 			}
 			if (character.highFlag & UFLAG_HIGH_CHATCOLOR)
 			{
-				character.chatColorID = statement.getColumn(index++);
+				character.chatColorID = statement->getColumn(index++);
 			}
 		}
 		else
@@ -2153,7 +3432,7 @@ int CUserDatabaseSQLite::GetCharacter(int userID, CUserCharacter& character)
 	}
 	catch (exception& e)
 	{
-		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::GetCharacter: database internal error: %s, %d\n"), e.what(), m_Database.getErrorCode());
+		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::GetCharacter: database internal error: %s, %d\n"), e.what(), GetDatabase().getErrorCode());
 		return 0;
 	}
 
@@ -2164,6 +3443,9 @@ int CUserDatabaseSQLite::GetCharacter(int userID, CUserCharacter& character)
 // returns 0 == database error, 1 on success
 int CUserDatabaseSQLite::UpdateCharacter(int userID, CUserCharacter& character)
 {
+	PROFILE_DB();
+	lock_guard<recursive_mutex> lock(GetMutex());
+
 	try
 	{
 		// format query
@@ -2171,111 +3453,111 @@ int CUserDatabaseSQLite::UpdateCharacter(int userID, CUserCharacter& character)
 		query[query.size() - 1] = ' ';
 		query += OBFUSCATE("WHERE userID = ?"); // TODO: use stringstream
 
-		SQLite::Statement statement(m_Database, query);
+		CCachedStatement statement = GetStatement(query);
 		int index = 1;
 
 		if (character.lowFlag & UFLAG_LOW_NAMEPLATE)
 		{
-			statement.bind(index++, character.nameplateID);
+			statement->bind(index++, character.nameplateID);
 		}
 		if (character.lowFlag & UFLAG_LOW_GAMENAME)
 		{
-			statement.bind(index++, character.gameName);
+			statement->bind(index++, character.gameName);
 		}
 		if (character.lowFlag & UFLAG_LOW_LEVEL)
 		{
-			statement.bind(index++, character.level);
+			statement->bind(index++, character.level);
 		}
 		if (character.lowFlag & UFLAG_LOW_EXP)
 		{
-			statement.bind(index++, (int64_t)character.exp);
+			statement->bind(index++, (int64_t)character.exp);
 		}
 		if (character.lowFlag & UFLAG_LOW_CASH)
 		{
-			statement.bind(index++, character.cash);
+			statement->bind(index++, character.cash);
 		}
 		if (character.lowFlag & UFLAG_LOW_POINTS)
 		{
-			statement.bind(index++, character.points);
+			statement->bind(index++, character.points);
 		}
 		if (character.lowFlag & UFLAG_LOW_STAT)
 		{
 			if (character.statFlag & 0x1)
 			{
-				statement.bind(index++, character.battles);
+				statement->bind(index++, character.battles);
 			}
 			if (character.statFlag & 0x2)
 			{
-				statement.bind(index++, character.win);
+				statement->bind(index++, character.win);
 			}
 			if (character.statFlag & 0x4)
 			{
-				statement.bind(index++, character.kills);
+				statement->bind(index++, character.kills);
 			}
 			if (character.statFlag & 0x8)
 			{
-				statement.bind(index++, character.deaths);
+				statement->bind(index++, character.deaths);
 			}
 		}
 		if (character.lowFlag & UFLAG_LOW_LOCATION)
 		{
-			statement.bind(index++, character.nation);
-			statement.bind(index++, character.city);
-			statement.bind(index++, character.town);
+			statement->bind(index++, character.nation);
+			statement->bind(index++, character.city);
+			statement->bind(index++, character.town);
 		}
 		if (character.lowFlag & UFLAG_LOW_RANK)
 		{
-			statement.bind(index++, character.leagueID);
+			statement->bind(index++, character.leagueID);
 		}
 		if (character.lowFlag & UFLAG_LOW_PASSWORDBOXES)
 		{
-			statement.bind(index++, character.passwordBoxes);
+			statement->bind(index++, character.passwordBoxes);
 		}
 		if (character.lowFlag & UFLAG_LOW_ACHIEVEMENT)
 		{
 			if (character.achievementFlag & 0x1)
 			{
-				statement.bind(index++, character.honorPoints);
+				statement->bind(index++, character.honorPoints);
 			}
 			if (character.achievementFlag & 0x2)
 			{
-				statement.bind(index++, character.prefixId);
+				statement->bind(index++, character.prefixId);
 			}
 		}
 		if (character.lowFlag & UFLAG_LOW_ACHIEVEMENTLIST)
 		{
 			string serialized = serialize_array_int(character.achievementList);
-			statement.bind(index++, serialized);
+			statement->bind(index++, serialized);
 		}
 		if (character.lowFlag & UFLAG_LOW_TITLES)
 		{
 			string serialized = serialize_array_int(character.titles);
-			statement.bind(index++, serialized);
+			statement->bind(index++, serialized);
 		}
 		if (character.lowFlag & UFLAG_LOW_CLAN)
 		{
-			statement.bind(index++, character.clanID);
+			statement->bind(index++, character.clanID);
 		}
 		if (character.lowFlag & UFLAG_LOW_TOURNAMENT)
 		{
-			statement.bind(index++, character.tournament);
+			statement->bind(index++, character.tournament);
 		}
 		if (character.lowFlag & UFLAG_LOW_UNK26)
 		{
-			statement.bind(index++, character.mileagePoints);
+			statement->bind(index++, character.mileagePoints);
 		}
 		if (character.highFlag & UFLAG_HIGH_CHATCOLOR)
 		{
-			statement.bind(index++, character.chatColorID);
+			statement->bind(index++, character.chatColorID);
 		}
 
-		statement.bind(index++, userID);
+		statement->bind(index++, userID);
 
-		statement.exec();
+		statement->exec();
 	}
 	catch (exception& e)
 	{
-		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::UpdateCharacter: database internal error: %s, %d\n"), e.what(), m_Database.getErrorCode());
+		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::UpdateCharacter: database internal error: %s, %d\n"), e.what(), GetDatabase().getErrorCode());
 		return 0;
 	}
 
@@ -2316,6 +3598,9 @@ string GetCharacterExtendedString(int flag, bool update)
 // returns 0 == database error, 1 on success
 int CUserDatabaseSQLite::GetCharacterExtended(int userID, CUserCharacterExtended& character)
 {
+	PROFILE_DB();
+	lock_guard<recursive_mutex> lock(GetMutex());
+
 	try
 	{
 		// format query
@@ -2323,65 +3608,65 @@ int CUserDatabaseSQLite::GetCharacterExtended(int userID, CUserCharacterExtended
 		query[query.size() - 1] = ' ';
 		query += OBFUSCATE("FROM UserCharacterExtended WHERE userID = ? LIMIT 1"); // TODO: use stringstream
 
-		SQLite::Statement statement(m_Database, query);
-		statement.bind(1, userID);
+		CCachedStatement statement = GetStatement(query);
+		statement->bind(1, userID);
 
-		if (statement.executeStep())
+		if (statement->executeStep())
 		{
 			int index = 0;
 			if (character.flag & EXT_UFLAG_GAMEMASTER)
 			{
-				character.gameMaster = (int)statement.getColumn(index++);
+				character.gameMaster = (int)statement->getColumn(index++);
 			}
 			if (character.flag & EXT_UFLAG_KILLSTOGETGACHAPONITEM)
 			{
-				character.killsToGetGachaponItem = statement.getColumn(index++);
+				character.killsToGetGachaponItem = statement->getColumn(index++);
 			}
 			if (character.flag & EXT_UFLAG_NEXTINVENTORYSLOT)
 			{
-				character.nextInventorySlot = statement.getColumn(index++);
+				character.nextInventorySlot = statement->getColumn(index++);
 			}
 			if (character.flag & EXT_UFLAG_CONFIG)
 			{
-				SQLite::Column config = statement.getColumn(index++);
+				SQLite::Column config = statement->getColumn(index++);
 				character.config.assign((unsigned char*)config.getBlob(), (unsigned char*)config.getBlob() + config.getBytes());
 			}
 			if (character.flag & EXT_UFLAG_CURLOADOUT)
 			{
-				character.curLoadout = statement.getColumn(index++);
+				character.curLoadout = statement->getColumn(index++);
 			}
 			if (character.flag & EXT_UFLAG_CHARACTERID)
 			{
-				character.characterID = statement.getColumn(index++);
+				character.characterID = statement->getColumn(index++);
 			}
 			if (character.flag & EXT_UFLAG_BANSETTINGS)
 			{
-				character.banSettings = statement.getColumn(index++);
+				character.banSettings = statement->getColumn(index++);
 			}
 			if (character.flag & EXT_UFLAG_2NDPASSWORD)
 			{
-				SQLite::Column _2ndPassword = statement.getColumn(index++);
+				SQLite::Column _2ndPassword = statement->getColumn(index++);
 				character._2ndPassword.assign((unsigned char*)_2ndPassword.getBlob(), (unsigned char*)_2ndPassword.getBlob() + _2ndPassword.getBytes());
 			}
 			if (character.flag & EXT_UFLAG_SECURITYQNA)
 			{
-				character.securityQuestion = statement.getColumn(index++);
-				SQLite::Column securityAnswer = statement.getColumn(index++);
+				character.securityQuestion = statement->getColumn(index++);
+				SQLite::Column securityAnswer = statement->getColumn(index++);
 				character.securityAnswer.assign((unsigned char*)securityAnswer.getBlob(), (unsigned char*)securityAnswer.getBlob() + securityAnswer.getBytes());
 			}
 			if (character.flag & EXT_UFLAG_ZBRESPAWNEFFECT)
 			{
-				character.zbRespawnEffect = statement.getColumn(index++);
+				character.zbRespawnEffect = statement->getColumn(index++);
 			}
 			if (character.flag & EXT_UFLAG_KILLERMARKEFFECT)
 			{
-				character.killerMarkEffect = statement.getColumn(index++);
+				character.killerMarkEffect = statement->getColumn(index++);
 			}
 		}
 	}
 	catch (exception& e)
 	{
-		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::GetCharacterExtended: database internal error: %s, %d\n"), e.what(), m_Database.getErrorCode());
+		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::GetCharacterExtended: database internal error: %s, %d\n"), e.what(), GetDatabase().getErrorCode());
 		return 0;
 	}
 
@@ -2392,6 +3677,9 @@ int CUserDatabaseSQLite::GetCharacterExtended(int userID, CUserCharacterExtended
 // returns 0 == database error, 1 on success
 int CUserDatabaseSQLite::UpdateCharacterExtended(int userID, CUserCharacterExtended& character)
 {
+	PROFILE_DB();
+	lock_guard<recursive_mutex> lock(GetMutex());
+
 	try
 	{
 		// format query
@@ -2399,65 +3687,65 @@ int CUserDatabaseSQLite::UpdateCharacterExtended(int userID, CUserCharacterExten
 		query[query.size() - 1] = ' ';
 		query += OBFUSCATE("WHERE userID = ?"); // TODO: use stringstream
 
-		SQLite::Statement statement(m_Database, query);
+		CCachedStatement statement = GetStatement(query);
 		int index = 1;
 
 		if (character.flag & EXT_UFLAG_GAMEMASTER)
 		{
-			statement.bind(index++, character.gameMaster);
+			statement->bind(index++, character.gameMaster);
 		}
 		if (character.flag & EXT_UFLAG_KILLSTOGETGACHAPONITEM)
 		{
-			statement.bind(index++, character.killsToGetGachaponItem);
+			statement->bind(index++, character.killsToGetGachaponItem);
 		}
 		if (character.flag & EXT_UFLAG_NEXTINVENTORYSLOT)
 		{
-			statement.bind(index++, character.nextInventorySlot);
+			statement->bind(index++, character.nextInventorySlot);
 		}
 		if (character.flag & EXT_UFLAG_CONFIG)
 		{
 			void* config = character.config.data();
-			statement.bind(index++, config, character.config.size());
+			statement->bind(index++, config, character.config.size());
 		}
 		if (character.flag & EXT_UFLAG_CURLOADOUT)
 		{
-			statement.bind(index++, character.curLoadout);
+			statement->bind(index++, character.curLoadout);
 		}
 		if (character.flag & EXT_UFLAG_CHARACTERID)
 		{
-			statement.bind(index++, character.characterID);
+			statement->bind(index++, character.characterID);
 		}
 		if (character.flag & EXT_UFLAG_BANSETTINGS)
 		{
-			statement.bind(index++, character.banSettings);
+			statement->bind(index++, character.banSettings);
 		}
 		if (character.flag & EXT_UFLAG_2NDPASSWORD)
 		{
 			void* _2ndPassword = character._2ndPassword.data();
-			statement.bind(index++, _2ndPassword, character._2ndPassword.size());
+			statement->bind(index++, _2ndPassword, character._2ndPassword.size());
 		}
 		if (character.flag & EXT_UFLAG_SECURITYQNA)
 		{
-			statement.bind(index++, character.securityQuestion);
+			statement->bind(index++, character.securityQuestion);
 			void* securityAnswer = character.securityAnswer.data();
-			statement.bind(index++, securityAnswer, character.securityAnswer.size());
+			statement->bind(index++, securityAnswer, character.securityAnswer.size());
 		}
 		if (character.flag & EXT_UFLAG_ZBRESPAWNEFFECT)
 		{
-			statement.bind(index++, character.zbRespawnEffect);
+			statement->bind(index++, character.zbRespawnEffect);
 		}
 		if (character.flag & EXT_UFLAG_KILLERMARKEFFECT)
 		{
-			statement.bind(index++, character.killerMarkEffect);
+			statement->bind(index++, character.killerMarkEffect);
 		}
 
-		statement.bind(index++, userID);
+		statement->bind(index++, userID);
 
-		statement.exec();
+		statement->exec();
 	}
 	catch (exception& e)
 	{
-		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::UpdateCharacterExtended: database internal error: %s, %d\n"), e.what(), m_Database.getErrorCode());
+		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::UpdateCharacterExtended: database internal error: %s, %d\n"), e.what(), GetDatabase().getErrorCode());
 		return 0;
 	}
 
@@ -2468,22 +3756,25 @@ int CUserDatabaseSQLite::UpdateCharacterExtended(int userID, CUserCharacterExten
 // returns 0 == database error, 1 on success
 int CUserDatabaseSQLite::GetUserBan(int userID, UserBan& ban)
 {
+	PROFILE_DB();
+	lock_guard<recursive_mutex> lock(GetMutex());
+
 	try
 	{
-		SQLite::Statement statement(m_Database, OBFUSCATE("SELECT type, reason, term FROM UserBan WHERE userID = ? LIMIT 1"));
-		statement.bind(1, userID);
+		CCachedStatement statement = CACHED_STATEMENT("SELECT type, reason, term FROM UserBan WHERE userID = ? LIMIT 1");
+		statement->bind(1, userID);
 
-		if (statement.executeStep())
+		if (statement->executeStep())
 		{
-			ban.banType = statement.getColumn(0);
-			string reason = statement.getColumn(1);
+			ban.banType = statement->getColumn(0);
+			string reason = statement->getColumn(1);
 			ban.reason = reason;
-			ban.term = statement.getColumn(2);
+			ban.term = statement->getColumn(2);
 		}
 	}
 	catch (exception& e)
 	{
-		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::GetUserBan: database internal error: %s, %d\n"), e.what(), m_Database.getErrorCode());
+		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::GetUserBan: database internal error: %s, %d\n"), e.what(), GetDatabase().getErrorCode());
 		return 0;
 	}
 
@@ -2494,39 +3785,42 @@ int CUserDatabaseSQLite::GetUserBan(int userID, UserBan& ban)
 // returns 0 == database error, 1 on success
 int CUserDatabaseSQLite::UpdateUserBan(int userID, UserBan ban)
 {
+	PROFILE_DB();
+	lock_guard<recursive_mutex> lock(GetMutex());
+
 	try
 	{
 		if (ban.banType == 0)
 		{
-			SQLite::Statement statement(m_Database, OBFUSCATE("DELETE FROM UserBan WHERE userID = ?"));
-			statement.bind(1, userID);
-			statement.exec();
+			CCachedStatement statement = CACHED_STATEMENT("DELETE FROM UserBan WHERE userID = ?");
+			statement->bind(1, userID);
+			statement->exec();
 
 			return 1;
 		}
 
-		SQLite::Statement statement(m_Database, OBFUSCATE("UPDATE UserBan SET type = ?, reason = ?, term = ? WHERE userID = ?"));
-		statement.bind(1, ban.banType);
-		statement.bind(2, ban.reason);
-		statement.bind(3, ban.term);
-		statement.bind(4, userID);
-		if (!statement.exec())
+		CCachedStatement statement = CACHED_STATEMENT("UPDATE UserBan SET type = ?, reason = ?, term = ? WHERE userID = ?");
+		statement->bind(1, ban.banType);
+		statement->bind(2, ban.reason);
+		statement->bind(3, ban.term);
+		statement->bind(4, userID);
+		if (!statement->exec())
 		{
-			SQLite::Statement statement(m_Database, OBFUSCATE("INSERT INTO UserBan VALUES (?, ?, ?, ?)"));
-			statement.bind(1, userID);
-			statement.bind(2, ban.banType);
-			statement.bind(3, ban.reason);
-			statement.bind(4, ban.term);
-			if (!statement.exec())
+			CCachedStatement statement = CACHED_STATEMENT("INSERT INTO UserBan VALUES (?, ?, ?, ?)");
+			statement->bind(1, userID);
+			statement->bind(2, ban.banType);
+			statement->bind(3, ban.reason);
+			statement->bind(4, ban.term);
+			if (!statement->exec())
 			{
-				//Logger().Error(OBFUSCATE("CUserDatabaseSQLite::UpdateUserBan: database internal error: %s, %d\n"), e.what(), m_Database.getErrorCode());
+				//Logger().Error(OBFUSCATE("CUserDatabaseSQLite::UpdateUserBan: database internal error: %s, %d\n"), e.what(), GetDatabase().getErrorCode());
 				return 0;
 			}
 		}
 	}
 	catch (exception& e)
 	{
-		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::UpdateUserBan: database internal error: %s, %d\n"), e.what(), m_Database.getErrorCode());
+		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::UpdateUserBan: database internal error: %s, %d\n"), e.what(), GetDatabase().getErrorCode());
 		return 0;
 	}
 
@@ -2537,18 +3831,21 @@ int CUserDatabaseSQLite::UpdateUserBan(int userID, UserBan ban)
 // returns 0 == database error, 1 on success
 int CUserDatabaseSQLite::GetLoadouts(int userID, vector<CUserLoadout>& loadouts)
 {
+	PROFILE_DB();
+	lock_guard<recursive_mutex> lock(GetMutex());
+
 	try
 	{
-		SQLite::Statement statement(m_Database, OBFUSCATE("SELECT slot0, slot1, slot2, slot3 FROM UserLoadout WHERE userID = ? LIMIT ?"));
-		statement.bind(1, userID);
-		statement.bind(2, LOADOUT_COUNT);
+		CCachedStatement statement = CACHED_STATEMENT("SELECT slot0, slot1, slot2, slot3 FROM UserLoadout WHERE userID = ? LIMIT ?");
+		statement->bind(1, userID);
+		statement->bind(2, LOADOUT_COUNT);
 
-		while (statement.executeStep())
+		while (statement->executeStep())
 		{
 			vector<int> ld;
 			for (int i = 0; i < LOADOUT_SLOT_COUNT; i++)
 			{
-				ld.push_back(statement.getColumn(i));
+				ld.push_back(statement->getColumn(i));
 			}
 
 			loadouts.push_back(CUserLoadout(ld));
@@ -2556,7 +3853,7 @@ int CUserDatabaseSQLite::GetLoadouts(int userID, vector<CUserLoadout>& loadouts)
 	}
 	catch (exception& e)
 	{
-		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::GetLoadout: database internal error: %s, %d\n"), e.what(), m_Database.getErrorCode());
+		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::GetLoadout: database internal error: %s, %d\n"), e.what(), GetDatabase().getErrorCode());
 		return 0;
 	}
 
@@ -2567,6 +3864,9 @@ int CUserDatabaseSQLite::GetLoadouts(int userID, vector<CUserLoadout>& loadouts)
 // returns 0 == database error, 1 on success
 int CUserDatabaseSQLite::UpdateLoadout(int userID, int loadoutID, int slot, int value)
 {
+	PROFILE_DB();
+	lock_guard<recursive_mutex> lock(GetMutex());
+
 	try
 	{
 		string query;
@@ -2574,25 +3874,25 @@ int CUserDatabaseSQLite::UpdateLoadout(int userID, int loadoutID, int slot, int
 		query += OBFUSCATE("slot") + to_string(slot) + OBFUSCATE(" = ? ");
 		query += OBFUSCATE("WHERE userID = ? AND loadoutID = ?");
 
-		SQLite::Statement statement(m_Database, query);
-		statement.bind(1, value);
-		statement.bind(2, userID);
-		statement.bind(3, loadoutID);
-		if (!statement.exec())
-		{
-			SQLite::Statement statement(m_Database, OBFUSCATE("INSERT INTO UserLoadout VALUES (?, ?, ?, ?, ?, ?)"));
-			statement.bind(1, userID);
-			statement.bind(2, loadoutID);
-			statement.bind(3, slot == 0 ? value : 0);
-			statement.bind(4, slot == 1 ? value : 0);
-			statement.bind(5, slot == 2 ? value : 0);
-			statement.bind(6, slot == 3 ? value : 0);
-			statement.exec();
+		CCachedStatement statement = GetStatement(query);
+		statement->bind(1, value);
+		statement->bind(2, userID);
+		statement->bind(3, loadoutID);
+		if (!statement->exec())
+		{
+			CCachedStatement statement = CACHED_STATEMENT("INSERT INTO UserLoadout VALUES (?, ?, ?, ?, ?, ?)");
+			statement->bind(1, userID);
+			statement->bind(2, loadoutID);
+			statement->bind(3, slot == 0 ? value : 0);
+			statement->bind(4, slot == 1 ? value : 0);
+			statement->bind(5, slot == 2 ? value : 0);
+			statement->bind(6, slot == 3 ? value : 0);
+			statement->exec();
 		}
 	}
 	catch (exception& e)
 	{
-		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::UpdateLoadout: database internal error: %s, %d\n"), e.what(), m_Database.getErrorCode());
+		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::UpdateLoadout: database internal error: %s, %d\n"), e.what(), GetDatabase().getErrorCode());
 		return 0;
 	}
 
@@ -2603,20 +3903,23 @@ int CUserDatabaseSQLite::UpdateLoadout(int userID, int loadoutID, int slot, int
 // returns 0 == database error, 1 on success
 int CUserDatabaseSQLite::GetFastBuy(int userID, vector<CUserFastBuy>& fastBuy)
 {
+	PROFILE_DB();
+	lock_guard<recursive_mutex> lock(GetMutex());
+
 	try
 	{
-		SQLite::Statement statement(m_Database, OBFUSCATE("SELECT name, items FROM UserFastBuy WHERE userID = ? LIMIT ?"));
-		statement.bind(1, userID);
-		statement.bind(2, FASTBUY_COUNT);
+		CCachedStatement statement = CACHED_STATEMENT("SELECT name, items FROM UserFastBuy WHERE userID = ? LIMIT ?");
+		statement->bind(1, userID);
+		statement->bind(2, FASTBUY_COUNT);
 
-		while (statement.executeStep())
+		while (statement->executeStep())
 		{
-			fastBuy.push_back(CUserFastBuy(statement.getColumn(0), deserialize_array_int(statement.getColumn(1))));
+			fastBuy.push_back(CUserFastBuy(statement->getColumn(0), deserialize_array_int(statement->getColumn(1))));
 		}
 	}
 	catch (exception& e)
 	{
-		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::GetFastBuy: database internal error: %s, %d\n"), e.what(), m_Database.getErrorCode());
+		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::GetFastBuy: database internal error: %s, %d\n"), e.what(), GetDatabase().getErrorCode());
 		return 0;
 	}
 
@@ -2627,26 +3930,29 @@ int CUserDatabaseSQLite::GetFastBuy(int userID, vector<CUserFastBuy>& fastBuy)
 // returns 0 == database error, 1 on success
 int CUserDatabaseSQLite::UpdateFastBuy(int userID, int slot, const string& name, const vector<int>& items)
 {
+	PROFILE_DB();
+	lock_guard<recursive_mutex> lock(GetMutex());
+
 	try
 	{
-		SQLite::Statement statement(m_Database, OBFUSCATE("UPDATE UserFastBuy SET name = ?, items = ? WHERE userID = ? AND fastBuyID = ?"));
-		statement.bind(1, name);
-		statement.bind(2, serialize_array_int(items));
-		statement.bind(3, userID);
-		statement.bind(4, slot);
-		if (!statement.exec())
+		CCachedStatement statement = CACHED_STATEMENT("UPDATE UserFastBuy SET name = ?, items = ? WHERE userID = ? AND fastBuyID = ?");
+		statement->bind(1, name);
+		statement->bind(2, serialize_array_int(items));
+		statement->bind(3, userID);
+		statement->bind(4, slot);
+		if (!statement->exec())
 		{
-			SQLite::Statement statement(m_Database, OBFUSCATE("INSERT INTO UserFastBuy VALUES (?, ?, ?, ?)"));
-			statement.bind(1, userID);
-			statement.bind(2, slot);
-			statement.bind(3, name);
-			statement.bind(4, serialize_array_int(items));
-			statement.exec();
+			CCachedStatement statement = CACHED_STATEMENT("INSERT INTO UserFastBuy VALUES (?, ?, ?, ?)");
+			statement->bind(1, userID);
+			statement->bind(2, slot);
+			statement->bind(3, name);
+			statement->bind(4, serialize_array_int(items));
+			statement->exec();
 		}
 	}
 	catch (exception& e)
 	{
-		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::UpdateFastBuy: database internal error: %s, %d\n"), e.what(), m_Database.getErrorCode());
+		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::UpdateFastBuy: database internal error: %s, %d\n"), e.what(), GetDatabase().getErrorCode());
 		return 0;
 	}
 
@@ -2657,18 +3963,21 @@ int CUserDatabaseSQLite::UpdateFastBuy(int userID, int slot, const string& name,
 // returns 0 == database error, 1 on success
 int CUserDatabaseSQLite::GetBuyMenu(int userID, vector<CUserBuyMenu>& buyMenu)
 {
+	PROFILE_DB();
+	lock_guard<recursive_mutex> lock(GetMutex());
+
 	try
 	{
-		SQLite::Statement statement(m_Database, OBFUSCATE("SELECT slot1, slot2, slot3, slot4, slot5, slot6, slot7, slot8, slot9 FROM UserBuyMenu WHERE userID = ? LIMIT ?"));
-		statement.bind(1, userID);
-		statement.bind(2, BUYMENU_COUNT);
+		CCachedStatement statement = CACHED_STATEMENT("SELECT slot1, slot2, slot3, slot4, slot5, slot6, slot7, slot8, slot9 FROM UserBuyMenu WHERE userID = ? LIMIT ?");
+		statement->bind(1, userID);
+		statement->bind(2, BUYMENU_COUNT);
 
-		while (statement.executeStep())
+		while (statement->executeStep())
 		{
 			vector<int> bm;
 			for (int i = 0; i < BUYMENU_SLOT_COUNT; i++)
 			{
-				bm.push_back(statement.getColumn(i));
+				bm.push_back(statement->getColumn(i));
 			}
 
 			buyMenu.push_back(CUserBuyMenu(bm));
@@ -2676,7 +3985,7 @@ int CUserDatabaseSQLite::GetBuyMenu(int userID, vector<CUserBuyMenu>& buyMenu)
 	}
 	catch (exception& e)
 	{
-		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::GetBuyMenu: database internal error: %s, %d\n"), e.what(), m_Database.getErrorCode());
+		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::GetBuyMenu: database internal error: %s, %d\n"), e.what(), GetDatabase().getErrorCode());
 		return 0;
 	}
 
@@ -2687,6 +3996,9 @@ int CUserDatabaseSQLite::GetBuyMenu(int userID, vector<CUserBuyMenu>& buyMenu)
 // returns 0 == database error, 1 on success
 int CUserDatabaseSQLite::UpdateBuyMenu(int userID, int subMenuID, int subMenuSlot, int itemID)
 {
+	PROFILE_DB();
+	lock_guard<recursive_mutex> lock(GetMutex());
+
 	try
 	{
 		string query;
@@ -2694,11 +4006,11 @@ int CUserDatabaseSQLite::UpdateBuyMenu(int userID, int subMenuID, int subMenuSlo
 		query += OBFUSCATE("slot") + to_string(subMenuSlot + 1) + OBFUSCATE(" = ? ");
 		query += OBFUSCATE("WHERE userID = ? AND buyMenuID = ?");
 
-		SQLite::Statement statement(m_Database, query);
-		statement.bind(1, itemID);
-		statement.bind(2, userID);
-		statement.bind(3, subMenuID);
-		if (!statement.exec())
+		CCachedStatement statement = GetStatement(query);
+		statement->bind(1, itemID);
+		statement->bind(2, userID);
+		statement->bind(3, subMenuID);
+		if (!statement->exec())
 		{
 			// insert?
 			Logger().Error(OBFUSCATE("CUserDatabaseSQLite::UpdateBuyMenu: UserBuyMenu is empty(userID: %d)???\n"), userID);
@@ -2706,7 +4018,7 @@ int CUserDatabaseSQLite::UpdateBuyMenu(int userID, int subMenuID, int subMenuSlo
 	}
 	catch (exception& e)
 	{
-		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::UpdateBuyMenu: database internal error: %s, %d\n"), e.what(), m_Database.getErrorCode());
+		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::UpdateBuyMenu: database internal error: %s, %d\n"), e.what(), GetDatabase().getErrorCode());
 		return 0;
 	}
 
@@ -2715,20 +4027,23 @@ int CUserDatabaseSQLite::UpdateBuyMenu(int userID, int subMenuID, int subMenuSlo
 
 int CUserDatabaseSQLite::GetBookmark(int userID, vector<int>& bookmark)
 {
+	PROFILE_DB();
+	lock_guard<recursive_mutex> lock(GetMutex());
+
 	try
 	{
-		SQLite::Statement query(m_Database, OBFUSCATE("SELECT itemID FROM UserBookmark WHERE userID = ? LIMIT ?"));
-		query.bind(1, userID);
-		query.bind(2, BOOKMARK_COUNT);
+		CCachedStatement query = CACHED_STATEMENT("SELECT itemID FROM UserBookmark WHERE userID = ? LIMIT ?");
+		query->bind(1, userID);
+		query->bind(2, BOOKMARK_COUNT);
 
-		while (query.executeStep())
+		while (query->executeStep())
 		{
-			bookmark.push_back(query.getColumn(0));
+			bookmark.push_back(query->getColumn(0));
 		}
 	}
 	catch (exception& e)
 	{
-		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::GetBookmark: database internal error: %s, %d\n"), e.what(), m_Database.getErrorCode());
+		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::GetBookmark: database internal error: %s, %d\n"), e.what(), GetDatabase().getErrorCode());
 		return 0;
 	}
 
@@ -2737,15 +4052,18 @@ int CUserDatabaseSQLite::GetBookmark(int userID, vector<int>& bookmark)
 
 int CUserDatabaseSQLite::UpdateBookmark(int userID, int bookmarkID, int itemID)
 {
+	PROFILE_DB();
+	lock_guard<recursive_mutex> lock(GetMutex());
+
 	try
 	{
-		SQLite::Statement query(m_Database, "UPDATE UserBookmark SET itemID = ? WHERE userID = ? AND bookmarkID = ?");
+		SQLite::Statement query(GetDatabase(), "UPDATE UserBookmark SET itemID = ? WHERE userID = ? AND bookmarkID = ?");
 		query.bind(1, itemID);
 		query.bind(2, userID);
 		query.bind(3, bookmarkID);
 		if (!query.exec())
 		{
-			SQLite::Statement query(m_Database, "INSERT INTO UserBookmark VALUES (?, ?, ?)");
+			SQLite::Statement query(GetDatabase(), "INSERT INTO UserBookmark VALUES (?, ?, ?)");
 			query.bind(1, userID);
 			query.bind(2, bookmarkID);
 			query.bind(3, itemID);
@@ -2754,7 +4072,7 @@ int CUserDatabaseSQLite::UpdateBookmark(int userID, int bookmarkID, int itemID)
 	}
 	catch (exception& e)
 	{
-		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::UpdateBookmark: database internal error: %s, %d\n"), e.what(), m_Database.getErrorCode());
+		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::UpdateBookmark: database internal error: %s, %d\n"), e.what(), GetDatabase().getErrorCode());
 		return 0;
 	}
 
@@ -2765,29 +4083,32 @@ int CUserDatabaseSQLite::UpdateBookmark(int userID, int bookmarkID, int itemID)
 // returns 0 == database error, 1 on success
 int CUserDatabaseSQLite::GetCostumeLoadout(int userID, CUserCostumeLoadout& loadout)
 {
+	PROFILE_DB();
+	lock_guard<recursive_mutex> lock(GetMutex());
+
 	try
 	{
-		SQLite::Statement query(m_Database, OBFUSCATE("SELECT head, back, arm, pelvis, face, tattoo, pet FROM UserCostumeLoadout WHERE userID = ? LIMIT 1"));
-		query.bind(1, userID);
-		if (query.executeStep())
+		CCachedStatement query = CACHED_STATEMENT("SELECT head, back, arm, pelvis, face, tattoo, pet FROM UserCostumeLoadout WHERE userID = ? LIMIT 1");
+		query->bind(1, userID);
+		if (query->executeStep())
 		{
-			loadout.m_nHeadCostumeID = query.getColumn(0);
-			loadout.m_nBackCostumeID = query.getColumn(1);
-			loadout.m_nArmCostumeID = query.getColumn(2);
-			loadout.m_nPelvisCostumeID = query.getColumn(3);
-			loadout.m_nFaceCostumeID = query.getColumn(4);
-			loadout.m_nTattooID = query.getColumn(5);
-			loadout.m_nPetCostumeID = query.getColumn(6);
+			loadout.m_nHeadCostumeID = query->getColumn(0);
+			loadout.m_nBackCostumeID = query->getColumn(1);
+			loadout.m_nArmCostumeID = query->getColumn(2);
+			loadout.m_nPelvisCostumeID = query->getColumn(3);
+			loadout.m_nFaceCostumeID = query->getColumn(4);
+			loadout.m_nTattooID = query->getColumn(5);
+			loadout.m_nPetCostumeID = query->getColumn(6);
 		}
 
 		{
-			SQLite::Statement query(m_Database, OBFUSCATE("SELECT slot, itemID FROM UserZBCostumeLoadout WHERE userID = ? LIMIT ?"));
-			query.bind(1, userID);
-			query.bind(2, ZB_COSTUME_SLOT_COUNT_MAX);
-			while (query.executeStep())
+			CCachedStatement query = CACHED_STATEMENT("SELECT slot, itemID FROM UserZBCostumeLoadout WHERE userID = ? LIMIT ?");
+			query->bind(1, userID);
+			query->bind(2, ZB_COSTUME_SLOT_COUNT_MAX);
+			while (query->executeStep())
 			{
-				int slot = query.getColumn(0);
-				int itemID = query.getColumn(1);
+				int slot = query->getColumn(0);
+				int itemID = query->getColumn(1);
 
 				loadout.m_ZombieSkinCostumeID[slot] = itemID;
 			}
@@ -2795,7 +4116,7 @@ int CUserDatabaseSQLite::GetCostumeLoadout(int userID, CUserCostumeLoadout& load
 	}
 	catch (exception& e)
 	{
-		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::GetCostumeLoadout: database internal error: %s, %d\n"), e.what(), m_Database.getErrorCode());
+		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::GetCostumeLoadout: database internal error: %s, %d\n"), e.what(), GetDatabase().getErrorCode());
 		return 0;
 	}
 
@@ -2806,33 +4127,36 @@ int CUserDatabaseSQLite::GetCostumeLoadout(int userID, CUserCostumeLoadout& load
 // returns 0 == database error, 1 on success
 int CUserDatabaseSQLite::UpdateCostumeLoadout(int userID, CUserCostumeLoadout& loadout, int zbSlot)
 {
+	PROFILE_DB();
+	lock_guard<recursive_mutex> lock(GetMutex());
+
 	try
 	{
 		// update zombie loadout
 		if (zbSlot == -1)
 		{
-			SQLite::Statement query(m_Database, OBFUSCATE("UPDATE UserCostumeLoadout SET head = ?, back = ?, arm = ?, pelvis = ?, face = ?, tattoo = ?, pet = ? WHERE userID = ?"));
-			query.bind(1, loadout.m_nHeadCostumeID);
-			query.bind(2, loadout.m_nBackCostumeID);
-			query.bind(3, loadout.m_nArmCostumeID);
-			query.bind(4, loadout.m_nPelvisCostumeID);
-			query.bind(5, loadout.m_nFaceCostumeID);
-			query.bind(6, loadout.m_nTattooID);
-			query.bind(7, loadout.m_nPetCostumeID);
-			query.bind(8, userID);
-			if (!query.exec())
-			{
-				SQLite::Statement query(m_Database, OBFUSCATE("INSERT INTO UserCostumeLoadout VALUES (?, ?, ?, ?, ?, ?, ?, ?)"));
-				query.bind(1, userID);
-				query.bind(2, loadout.m_nHeadCostumeID);
-				query.bind(3, loadout.m_nBackCostumeID);
-				query.bind(4, loadout.m_nArmCostumeID);
-				query.bind(5, loadout.m_nPelvisCostumeID);
-				query.bind(6, loadout.m_nFaceCostumeID);
-				query.bind(7, loadout.m_nTattooID);
-				query.bind(8, loadout.m_nPetCostumeID);
-
-				query.exec();
+			CCachedStatement query = CACHED_STATEMENT("UPDATE UserCostumeLoadout SET head = ?, back = ?, arm = ?, pelvis = ?, face = ?, tattoo = ?, pet = ? WHERE userID = ?");
+			query->bind(1, loadout.m_nHeadCostumeID);
+			query->bind(2, loadout.m_nBackCostumeID);
+			query->bind(3, loadout.m_nArmCostumeID);
+			query->bind(4, loadout.m_nPelvisCostumeID);
+			query->bind(5, loadout.m_nFaceCostumeID);
+			query->bind(6, loadout.m_nTattooID);
+			query->bind(7, loadout.m_nPetCostumeID);
+			query->bind(8, userID);
+			if (!query->exec())
+			{
+				CCachedStatement query = CACHED_STATEMENT("INSERT INTO UserCostumeLoadout VALUES (?, ?, ?, ?, ?, ?, ?, ?)");
+				query->bind(1, userID);
+				query->bind(2, loadout.m_nHeadCostumeID);
+				query->bind(3, loadout.m_nBackCostumeID);
+				query->bind(4, loadout.m_nArmCostumeID);
+				query->bind(5, loadout.m_nPelvisCostumeID);
+				query->bind(6, loadout.m_nFaceCostumeID);
+				query->bind(7, loadout.m_nTattooID);
+				query->bind(8, loadout.m_nPetCostumeID);
+
+				query->exec();
 			}
 		}
 		else
@@ -2841,31 +4165,31 @@ int CUserDatabaseSQLite::UpdateCostumeLoadout(int userID, CUserCostumeLoadout& l
 			{
 				loadout.m_ZombieSkinCostumeID.erase(zbSlot);
 
-				SQLite::Statement query(m_Database, OBFUSCATE("DELETE FROM UserZBCostumeLoadout WHERE userID = ? AND slot = ?"));
-				query.bind(1, userID);
-				query.bind(2, zbSlot);
-				query.exec();
+				CCachedStatement query = CACHED_STATEMENT("DELETE FROM UserZBCostumeLoadout WHERE userID = ? AND slot = ?");
+				query->bind(1, userID);
+				query->bind(2, zbSlot);
+				query->exec();
 			}
 			else
 			{
-				SQLite::Statement query(m_Database, OBFUSCATE("UPDATE UserZBCostumeLoadout SET itemID = ? WHERE slot = ? AND userID = ?"));
-				query.bind(1, loadout.m_ZombieSkinCostumeID[zbSlot]);
-				query.bind(2, zbSlot);
-				query.bind(3, userID);
-				if (!query.exec())
+				CCachedStatement query = CACHED_STATEMENT("UPDATE UserZBCostumeLoadout SET itemID = ? WHERE slot = ? AND userID = ?");
+				query->bind(1, loadout.m_ZombieSkinCostumeID[zbSlot]);
+				query->bind(2, zbSlot);
+				query->bind(3, userID);
+				if (!query->exec())
 				{
-					SQLite::Statement query(m_Database, OBFUSCATE("INSERT INTO UserZBCostumeLoadout VALUES (?, ?, ?)"));
-					query.bind(1, userID);
-					query.bind(2, zbSlot);
-					query.bind(3, loadout.m_ZombieSkinCostumeID[zbSlot]);
-					query.exec();
+					CCachedStatement query = CACHED_STATEMENT("INSERT INTO UserZBCostumeLoadout VALUES (?, ?, ?)");
+					query->bind(1, userID);
+					query->bind(2, zbSlot);
+					query->bind(3, loadout.m_ZombieSkinCostumeID[zbSlot]);
+					query->exec();
 				}
 			}
 		}
 	}
 	catch (exception& e)
 	{
-		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::UpdateCostumeLoadout: database internal error: %s, %d\n"), e.what(), m_Database.getErrorCode());
+		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::UpdateCostumeLoadout: database internal error: %s, %d\n"), e.what(), GetDatabase().getErrorCode());
 		return 0;
 	}
 
@@ -2877,19 +4201,22 @@ int CUserDatabaseSQLite::UpdateCostumeLoadout(int userID, CUserCostumeLoadout& l
 // returns 0 == database error, 1 on success
 int CUserDatabaseSQLite::GetRewardNotices(int userID, vector<int>& notices)
 {
+	PROFILE_DB();
+	lock_guard<recursive_mutex> lock(GetMutex());
+
 	try
 	{
-		SQLite::Statement statement(m_Database, OBFUSCATE("SELECT rewardID FROM UserRewardNotice WHERE userID = ?"));
-		statement.bind(1, userID);
+		CCachedStatement statement = CACHED_STATEMENT("SELECT rewardID FROM UserRewardNotice WHERE userID = ?");
+		statement->bind(1, userID);
 
-		while (statement.executeStep())
+		while (statement->executeStep())
 		{
-			notices.push_back(statement.getColumn(0));
+			notices.push_back(statement->getColumn(0));
 		}
 	}
 	catch (exception& e)
 	{
-		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::GetRewardNotices: database internal error: %s, %d\n"), e.what(), m_Database.getErrorCode());
+		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::GetRewardNotices: database internal error: %s, %d\n"), e.what(), GetDatabase().getErrorCode());
 		return 0;
 	}
 
@@ -2900,26 +4227,29 @@ int CUserDatabaseSQLite::GetRewardNotices(int userID, vector<int>& notices)
 // returns 0 == database error, 1 on success
 int CUserDatabaseSQLite::UpdateRewardNotices(int userID, int rewardID)
 {
+	PROFILE_DB();
+	lock_guard<recursive_mutex> lock(GetMutex());
+
 	try
 	{
 		if (!rewardID)
 		{
 			// delete all records
-			SQLite::Statement statement(m_Database, OBFUSCATE("DELETE FROM UserRewardNotice WHERE userID = ?"));
-			statement.bind(1, userID);
-			statement.exec();
+			CCachedStatement statement = CACHED_STATEMENT("DELETE FROM UserRewardNotice WHERE userID = ?");
+			statement->bind(1, userID);
+			statement->exec();
 
 			return 1;
 		}
 
-		SQLite::Statement statement(m_Database, OBFUSCATE("INSERT INTO UserRewardNotice VALUES (?, ?)"));
-		statement.bind(1, userID);
-		statement.bind(2, rewardID);
-		statement.exec();
+		CCachedStatement statement = CACHED_STATEMENT("INSERT INTO UserRewardNotice VALUES (?, ?)");
+		statement->bind(1, userID);
+		statement->bind(2, rewardID);
+		statement->exec();
 	}
 	catch (exception& e)
 	{
-		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::UpdateRewardNotices: database internal error: %s, %d\n"), e.what(), m_Database.getErrorCode());
+		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::UpdateRewardNotices: database internal error: %s, %d\n"), e.what(), GetDatabase().getErrorCode());
 		return 0;
 	}
 
@@ -2928,19 +4258,22 @@ int CUserDatabaseSQLite::UpdateRewardNotices(int userID, int rewardID)
 
 int CUserDatabaseSQLite::GetExpiryNotices(int userID, vector<int>& notices)
 {
+	PROFILE_DB();
+	lock_guard<recursive_mutex> lock(GetMutex());
+
 	try
 	{
-		SQLite::Statement statement(m_Database, OBFUSCATE("SELECT itemID FROM UserExpiryNotice WHERE userID = ?"));
-		statement.bind(1, userID);
+		CCachedStatement statement = CACHED_STATEMENT("SELECT itemID FROM UserExpiryNotice WHERE userID = ?");
+		statement->bind(1, userID);
 
-		while (statement.executeStep())
+		while (statement->executeStep())
 		{
-			notices.push_back(statement.getColumn(0));
+			notices.push_back(statement->getColumn(0));
 		}
 	}
 	catch (exception& e)
 	{
-		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::GetExpiryNotices: database internal error: %s, %d\n"), e.what(), m_Database.getErrorCode());
+		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::GetExpiryNotices: database internal error: %s, %d\n"), e.what(), GetDatabase().getErrorCode());
 		return 0;
 	}
 
@@ -2949,26 +4282,29 @@ int CUserDatabaseSQLite::GetExpiryNotices(int userID, vector<int>& notices)
 
 int CUserDatabaseSQLite::UpdateExpiryNotices(int userID, int itemID)
 {
+	PROFILE_DB();
+	lock_guard<recursive_mutex> lock(GetMutex());
+
 	try
 	{
 		if (!itemID)
 		{
 			// delete all records
-			SQLite::Statement statement(m_Database, OBFUSCATE("DELETE FROM UserExpiryNotice WHERE userID = ?"));
-			statement.bind(1, userID);
-			statement.exec();
+			CCachedStatement statement = CACHED_STATEMENT("DELETE FROM UserExpiryNotice WHERE userID = ?");
+			statement->bind(1, userID);
+			statement->exec();
 
 			return 1;
 		}
 
-		SQLite::Statement statement(m_Database, OBFUSCATE("INSERT INTO UserExpiryNotice VALUES (?, ?)"));
-		statement.bind(1, userID);
-		statement.bind(2, itemID);
-		statement.exec();
+		CCachedStatement statement = CACHED_STATEMENT("INSERT INTO UserExpiryNotice VALUES (?, ?)");
+		statement->bind(1, userID);
+		statement->bind(2, itemID);
+		statement->exec();
 	}
 	catch (exception& e)
 	{
-		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::UpdateRewardNotices: database internal error: %s, %d\n"), e.what(), m_Database.getErrorCode());
+		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::UpdateRewardNotices: database internal error: %s, %d\n"), e.what(), GetDatabase().getErrorCode());
 		return 0;
 	}
 
@@ -2977,34 +4313,37 @@ int CUserDatabaseSQLite::UpdateExpiryNotices(int userID, int itemID)
 
 int CUserDatabaseSQLite::GetDailyRewards(int userID, UserDailyRewards& dailyRewards)
 {
+	PROFILE_DB();
+	lock_guard<recursive_mutex> lock(GetMutex());
+
 	try
 	{
-		SQLite::Statement statement(m_Database, OBFUSCATE("SELECT day, canGetReward FROM UserDailyReward WHERE userID = ? LIMIT 1"));
-		statement.bind(1, userID);
+		CCachedStatement statement = CACHED_STATEMENT("SELECT day, canGetReward FROM UserDailyReward WHERE userID = ? LIMIT 1");
+		statement->bind(1, userID);
 
-		if (statement.executeStep())
+		if (statement->executeStep())
 		{
-			dailyRewards.day = statement.getColumn(0);
-			dailyRewards.canGetReward = (char)statement.getColumn(1);
+			dailyRewards.day = statement->getColumn(0);
+			dailyRewards.canGetReward = (char)statement->getColumn(1);
 		}
 
-		SQLite::Statement statement_getItems(m_Database, OBFUSCATE("SELECT itemID, count, duration, eventFlag FROM UserDailyRewardItems WHERE userID = ?"));
-		statement_getItems.bind(1, userID);
+		CCachedStatement statement_getItems = CACHED_STATEMENT("SELECT itemID, count, duration, eventFlag FROM UserDailyRewardItems WHERE userID = ?");
+		statement_getItems->bind(1, userID);
 
-		while (statement_getItems.executeStep())
+		while (statement_getItems->executeStep())
 		{
 			RewardItem item;
-			item.itemID = statement_getItems.getColumn(0);
-			item.count = statement_getItems.getColumn(1);
-			item.duration = statement_getItems.getColumn(2);
-			item.eventFlag = statement_getItems.getColumn(3);
+			item.itemID = statement_getItems->getColumn(0);
+			item.count = statement_getItems->getColumn(1);
+			item.duration = statement_getItems->getColumn(2);
+			item.eventFlag = statement_getItems->getColumn(3);
 
 			dailyRewards.randomItems.push_back(item);
 		}
 	}
 	catch (exception& e)
 	{
-		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::GetDailyRewards: database internal error: %s, %d\n"), e.what(), m_Database.getErrorCode());
+		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::GetDailyRewards: database internal error: %s, %d\n"), e.what(), GetDatabase().getErrorCode());
 		return 0;
 	}
 
@@ -3013,51 +4352,54 @@ int CUserDatabaseSQLite::GetDailyRewards(int userID, UserDailyRewards& dailyRewa
 
 int CUserDatabaseSQLite::UpdateDailyRewards(int userID, UserDailyRewards& dailyRewards)
 {
+	PROFILE_DB();
+	lock_guard<recursive_mutex> lock(GetMutex());
+
 	try
 	{
-		SQLite::Statement statement(m_Database, OBFUSCATE("UPDATE UserDailyReward SET day = ?, canGetReward = ? WHERE userID = ?"));
-		statement.bind(1, dailyRewards.day);
-		statement.bind(2, dailyRewards.canGetReward);
-		statement.bind(3, userID);
-		if (!statement.exec())
+		CCachedStatement statement = CACHED_STATEMENT("UPDATE UserDailyReward SET day = ?, canGetReward = ? WHERE userID = ?");
+		statement->bind(1, dailyRewards.day);
+		statement->bind(2, dailyRewards.canGetReward);
+		statement->bind(3, userID);
+		if (!statement->exec())
 		{
-			SQLite::Statement statement(m_Database, OBFUSCATE("INSERT INTO UserDailyReward VALUES (?, ?, ?)"));
-			statement.bind(1, userID);
-			statement.bind(2, dailyRewards.day);
-			statement.bind(3, dailyRewards.canGetReward);
-			statement.exec();
+			CCachedStatement statement = CACHED_STATEMENT("INSERT INTO UserDailyReward VALUES (?, ?, ?)");
+			statement->bind(1, userID);
+			statement->bind(2, dailyRewards.day);
+			statement->bind(3, dailyRewards.canGetReward);
+			statement->exec();
 		}
 
-		SQLite::Statement statement_updateItems(m_Database, OBFUSCATE("SELECT EXISTS(SELECT 1 FROM UserDailyRewardItems WHERE userID = ? LIMIT 1)"));
-		statement_updateItems.bind(1, userID);
+		CCachedStatement statement_updateItems = CACHED_STATEMENT("SELECT EXISTS(SELECT 1 FROM UserDailyRewardItems WHERE userID = ? LIMIT 1)");
+		statement_updateItems->bind(1, userID);
 		
-		if (statement_updateItems.executeStep())
+		if (statement_updateItems->executeStep())
 		{
-			if ((int)statement_updateItems.getColumn(0))
+			if ((int)statement_updateItems->getColumn(0))
 			{
-				SQLite::Statement statement_deleteItems(m_Database, OBFUSCATE("DELETE FROM UserDailyRewardItems WHERE userID = ?"));
-				statement_deleteItems.bind(1, userID);
-				statement_deleteItems.exec();
+				CCachedStatement statement_deleteItems = CACHED_STATEMENT("DELETE FROM UserDailyRewardItems WHERE userID = ?");
+				statement_deleteItems->bind(1, userID);
+				statement_deleteItems->exec();
 			}
 			else
 			{
-				SQLite::Statement statement_addItems(m_Database, OBFUSCATE("INSERT INTO UserDailyRewardItems VALUES (?, ?, ?, ?, ?)"));
+				CCachedStatement statement_addItems = CACHED_STATEMENT("INSERT INTO UserDailyRewardItems VALUES (?, ?, ?, ?, ?)");
 				for (RewardItem& item : dailyRewards.randomItems)
 				{
-					statement_addItems.bind(1, userID);
-					statement_addItems.bind(2, item.itemID);
-					statement_addItems.bind(3, item.count);
-					statement_addItems.bind(4, item.duration);
-					statement_addItems.bind(5, item.eventFlag);
-					statement_addItems.exec();
-					statement_addItems.reset();
+					statement_addItems->bind(1, userID);
+					statement_addItems->bind(2, item.itemID);
+					statement_addItems->bind(3, item.count);
+					statement_addItems->bind(4, item.duration);
+					statement_addItems->bind(5, item.eventFlag);
+					statement_addItems->exec();
+					statement_addItems->reset();
 				}
 			}
 		}
 	}
 	catch (exception& e)
 	{
-		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::UpdateDailyRewards: database internal error: %s, %d\n"), e.what(), m_Database.getErrorCode());
+		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::UpdateDailyRewards: database internal error: %s, %d\n"), e.what(), GetDatabase().getErrorCode());
 		return 0;
 	}
 
@@ -3066,31 +4408,34 @@ int CUserDatabaseSQLite::UpdateDailyRewards(int userID, UserDailyRewards& dailyR
 
 int CUserDatabaseSQLite::GetQuestsProgress(int userID, vector<UserQuestProgress>& questsProgress)
 {
+	PROFILE_DB();
+	lock_guard<recursive_mutex> lock(GetMutex());
+
 	try
 	{
-		SQLite::Statement statement(m_Database, OBFUSCATE("SELECT questID, status, favourite, started FROM UserQuestProgress WHERE userID = ?"));
-		statement.bind(1, userID);
-		while (statement.executeStep())
+		CCachedStatement statement = CACHED_STATEMENT("SELECT questID, status, favourite, started FROM UserQuestProgress WHERE userID = ?");
+		statement->bind(1, userID);
+		while (statement->executeStep())
 		{
 			UserQuestProgress progress;
-			progress.questID = statement.getColumn(0);
-			progress.status = statement.getColumn(1);
-			progress.favourite = (char)statement.getColumn(2);
-			progress.started = (char)statement.getColumn(3);
+			progress.questID = statement->getColumn(0);
+			progress.status = statement->getColumn(1);
+			progress.favourite = (char)statement->getColumn(2);
+			progress.started = (char)statement->getColumn(3);
 
 			questsProgress.push_back(progress);
 		}
 
 		{
-			SQLite::Statement statement(m_Database, OBFUSCATE("SELECT questID, taskID, unitsDone, taskVar FROM UserQuestTaskProgress WHERE userID = ?"));
-			statement.bind(1, userID);
-			while (statement.executeStep())
+			CCachedStatement statement = CACHED_STATEMENT("SELECT questID, taskID, unitsDone, taskVar FROM UserQuestTaskProgress WHERE userID = ?");
+			statement->bind(1, userID);
+			while (statement->executeStep())
 			{
 				UserQuestTaskProgress progress;
-				int questID = statement.getColumn(0);
-				progress.taskID = statement.getColumn(1);
-				progress.unitsDone = statement.getColumn(2);
-				progress.taskVar = statement.getColumn(3);
+				int questID = statement->getColumn(0);
+				progress.taskID = statement->getColumn(1);
+				progress.unitsDone = statement->getColumn(2);
+				progress.taskVar = statement->getColumn(3);
 
 				vector<UserQuestProgress>::iterator userProgressIt = find_if(questsProgress.begin(), questsProgress.end(),
 					[questID](UserQuestProgress& userProgress) { return userProgress.questID == questID; });
@@ -3113,7 +4458,7 @@ int CUserDatabaseSQLite::GetQuestsProgress(int userID, vector<UserQuestProgress>
 	}
 	catch (exception& e)
 	{
-		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::GetQuestProgress: database internal error: %s, %d\n"), e.what(), m_Database.getErrorCode());
+		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::GetQuestProgress: database internal error: %s, %d\n"), e.what(), GetDatabase().getErrorCode());
 		return 0;
 	}
 
@@ -3122,23 +4467,26 @@ int CUserDatabaseSQLite::GetQuestsProgress(int userID, vector<UserQuestProgress>
 
 int CUserDatabaseSQLite::GetQuestProgress(int userID, int questID, UserQuestProgress& questProgress)
 {
+	PROFILE_DB();
+	lock_guard<recursive_mutex> lock(GetMutex());
+
 	try
 	{
-		SQLite::Statement statement(m_Database, OBFUSCATE("SELECT status, favourite, started FROM UserQuestProgress WHERE userID = ? AND questID = ? LIMIT 1"));
-		statement.bind(1, userID);
-		statement.bind(2, questID);
-		if (statement.executeStep())
+		CCachedStatement statement = CACHED_STATEMENT("SELECT status, favourite, started FROM UserQuestProgress WHERE userID = ? AND questID = ? LIMIT 1");
+		statement->bind(1, userID);
+		statement->bind(2, questID);
+		if (statement->executeStep())
 		{
-			questProgress.status = statement.getColumn(0);
-			questProgress.favourite = (char)statement.getColumn(1);
-			questProgress.started = (char)statement.getColumn(2);
+			questProgress.status = statement->getColumn(0);
+			questProgress.favourite = (char)statement->getColumn(1);
+			questProgress.started = (char)statement->getColumn(2);
 		}
 		
 		questProgress.questID = questID;
 	}
 	catch (exception& e)
 	{
-		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::GetQuestProgress: database internal error: %s, %d\n"), e.what(), m_Database.getErrorCode());
+		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::GetQuestProgress: database internal error: %s, %d\n"), e.what(), GetDatabase().getErrorCode());
 		return 0;
 	}
 
@@ -3147,28 +4495,31 @@ int CUserDatabaseSQLite::GetQuestProgress(int userID, int questID, UserQuestProg
 
 int CUserDatabaseSQLite::UpdateQuestProgress(int userID, UserQuestProgress& questProgress)
 {
+	PROFILE_DB();
+	lock_guard<recursive_mutex> lock(GetMutex());
+
 	try
 	{
-		SQLite::Statement statement(m_Database, OBFUSCATE("UPDATE UserQuestProgress SET status = ?, favourite = ?, started = ? WHERE userID = ? AND questID = ?"));
-		statement.bind(1, questProgress.status);
-		statement.bind(2, questProgress.favourite);
-		statement.bind(3, questProgress.started);
-		statement.bind(4, userID);
-		statement.bind(5, questProgress.questID);
-		if (!statement.exec())
+		CCachedStatement statement = CACHED_STATEMENT("UPDATE UserQuestProgress SET status = ?, favourite = ?, started = ? WHERE userID = ? AND questID = ?");
+		statement->bind(1, questProgress.status);
+		statement->bind(2, questProgress.favourite);
+		statement->bind(3, questProgress.started);
+		statement->bind(4, userID);
+		statement->bind(5, questProgress.questID);
+		if (!statement->exec())
 		{
-			SQLite::Statement statement(m_Database, OBFUSCATE("INSERT INTO UserQuestProgress VALUES (?, ?, ?, ?, ?)"));
-			statement.bind(1, userID);
-			statement.bind(2, questProgress.questID);
-			statement.bind(3, questProgress.status);
-			statement.bind(4, questProgress.favourite);
-			statement.bind(5, questProgress.started);
-			statement.exec();
+			CCachedStatement statement = CACHED_STATEMENT("INSERT INTO UserQuestProgress VALUES (?, ?, ?, ?, ?)");
+			statement->bind(1, userID);
+			statement->bind(2, questProgress.questID);
+			statement->bind(3, questProgress.status);
+			statement->bind(4, questProgress.favourite);
+			statement->bind(5, questProgress.started);
+			statement->exec();
 		}
 	}
 	catch (exception& e)
 	{
-		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::UpdateQuestProgress: database internal error: %s, %d\n"), e.what(), m_Database.getErrorCode());
+		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::UpdateQuestProgress: database internal error: %s, %d\n"), e.what(), GetDatabase().getErrorCode());
 		return 0;
 	}
 
@@ -3177,24 +4528,27 @@ int CUserDatabaseSQLite::UpdateQuestProgress(int userID, UserQuestProgress& ques
 
 int CUserDatabaseSQLite::GetQuestTaskProgress(int userID, int questID, int taskID, UserQuestTaskProgress& taskProgress)
 {
+	PROFILE_DB();
+	lock_guard<recursive_mutex> lock(GetMutex());
+
 	try
 	{
-		SQLite::Statement statement(m_Database, OBFUSCATE("SELECT unitsDone, taskVar, finished FROM UserQuestTaskProgress WHERE userID = ? AND questID = ? AND taskID = ? LIMIT 1"));
-		statement.bind(1, userID);
-		statement.bind(2, questID);
-		statement.bind(3, taskID);
-		if (statement.executeStep())
+		CCachedStatement statement = CACHED_STATEMENT("SELECT unitsDone, taskVar, finished FROM UserQuestTaskProgress WHERE userID = ? AND questID = ? AND taskID = ? LIMIT 1");
+		statement->bind(1, userID);
+		statement->bind(2, questID);
+		statement->bind(3, taskID);
+		if (statement->executeStep())
 		{
-			taskProgress.unitsDone = statement.getColumn(0);
-			taskProgress.taskVar = statement.getColumn(1);
-			taskProgress.finished = (char)statement.getColumn(2);
+			taskProgress.unitsDone = statement->getColumn(0);
+			taskProgress.taskVar = statement->getColumn(1);
+			taskProgress.finished = (char)statement->getColumn(2);
 		}
 		
 		taskProgress.taskID = taskID;
 	}
 	catch (exception& e)
 	{
-		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::GetQuestTaskProgress: database internal error: %s, %d\n"), e.what(), m_Database.getErrorCode());
+		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::GetQuestTaskProgress: database internal error: %s, %d\n"), e.what(), GetDatabase().getErrorCode());
 		return 0;
 	}
 
@@ -3203,30 +4557,33 @@ int CUserDatabaseSQLite::GetQuestTaskProgress(int userID, int questID, int taskI
 
 int CUserDatabaseSQLite::UpdateQuestTaskProgress(int userID, int questID, UserQuestTaskProgress& taskProgress)
 {
+	PROFILE_DB();
+	lock_guard<recursive_mutex> lock(GetMutex());
+
 	try
 	{
-		SQLite::Statement statement(m_Database, OBFUSCATE("UPDATE UserQuestTaskProgress SET unitsDone = ?, taskVar = ?, finished = ? WHERE userID = ? AND questID = ? AND taskID = ?"));
-		statement.bind(1, taskProgress.unitsDone);
-		statement.bind(2, taskProgress.taskVar);
-		statement.bind(3, taskProgress.finished);
-		statement.bind(4, userID);
-		statement.bind(5, questID);
-		statement.bind(6, taskProgress.taskID);
-		if (!statement.exec())
+		CCachedStatement statement = CACHED_STATEMENT("UPDATE UserQuestTaskProgress SET unitsDone = ?, taskVar = ?, finished = ? WHERE userID = ? AND questID = ? AND taskID = ?");
+		statement->bind(1, taskProgress.unitsDone);
+		statement->bind(2, taskProgress.taskVar);
+		statement->bind(3, taskProgress.finished);
+		statement->bind(4, userID);
+		statement->bind(5, questID);
+		statement->bind(6, taskProgress.taskID);
+		if (!statement->exec())
 		{
-			SQLite::Statement statement(m_Database, OBFUSCATE("INSERT INTO UserQuestTaskProgress VALUES (?, ?, ?, ?, ?, ?)"));
-			statement.bind(1, userID);
-			statement.bind(2, questID);
-			statement.bind(3, taskProgress.taskID);
-			statement.bind(4, taskProgress.unitsDone);
-			statement.bind(5, taskProgress.taskVar);
-			statement.bind(6, taskProgress.finished);
-			statement.exec();
+			CCachedStatement statement = CACHED_STATEMENT("INSERT INTO UserQuestTaskProgress VALUES (?, ?, ?, ?, ?, ?)");
+			statement->bind(1, userID);
+			statement->bind(2, questID);
+			statement->bind(3, taskProgress.taskID);
+			statement->bind(4, taskProgress.unitsDone);
+			statement->bind(5, taskProgress.taskVar);
+			statement->bind(6, taskProgress.finished);
+			statement->exec();
 		}
 	}
 	catch (exception& e)
 	{
-		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::UpdateQuestTaskProgress: database internal error: %s, %d\n"), e.what(), m_Database.getErrorCode());
+		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::UpdateQuestTaskProgress: database internal error: %s, %d\n"), e.what(), GetDatabase().getErrorCode());
 		return 0;
 	}
 
@@ -3235,16 +4592,19 @@ int CUserDatabaseSQLite::UpdateQuestTaskProgress(int userID, int questID, UserQu
 
 bool CUserDatabaseSQLite::IsQuestTaskFinished(int userID, int questID, int taskID)
 {
+	PROFILE_DB();
+	lock_guard<recursive_mutex> lock(GetMutex());
+
 	try
 	{
-		SQLite::Statement query(m_Database, OBFUSCATE("SELECT EXISTS(SELECT 1 FROM UserQuestTaskProgress WHERE userID = ? AND questID = ? AND taskID = ? AND finished = 0 LIMIT 1)"));
-		query.bind(1, userID);
-		query.bind(2, questID);
-		query.bind(3, taskID);
+		CCachedStatement query = CACHED_STATEMENT("SELECT EXISTS(SELECT 1 FROM UserQuestTaskProgress WHERE userID = ? AND questID = ? AND taskID = ? AND finished = 0 LIMIT 1)");
+		query->bind(1, userID);
+		query->bind(2, questID);
+		query->bind(3, taskID);
 
-		if (query.executeStep())
+		if (query->executeStep())
 		{
-			if ((int)query.getColumn(0))
+			if ((int)query->getColumn(0))
 			{
 				return false;
 			}
@@ -3252,7 +4612,7 @@ bool CUserDatabaseSQLite::IsQuestTaskFinished(int userID, int questID, int taskI
 	}
 	catch (exception& e)
 	{
-		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::IsAllQuestTasksFinished: database internal error: %s, %d\n"), e.what(), m_Database.getErrorCode());
+		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::IsAllQuestTasksFinished: database internal error: %s, %d\n"), e.what(), GetDatabase().getErrorCode());
 		return false;
 	}
 
@@ -3275,6 +4635,9 @@ string GetQuestStatString(int flag, bool update)
 
 int CUserDatabaseSQLite::GetQuestStat(int userID, int flag, UserQuestStat& stat)
 {
+	PROFILE_DB();
+	lock_guard<recursive_mutex> lock(GetMutex());
+
 	try
 	{
 		// format query
@@ -3282,28 +4645,28 @@ int CUserDatabaseSQLite::GetQuestStat(int userID, int flag, UserQuestStat& stat)
 		query[query.size() - 1] = ' ';
 		query += OBFUSCATE("FROM UserQuestStat WHERE userID = ? LIMIT 1"); // TODO: use stringstream
 
-		SQLite::Statement statement(m_Database, query);
-		statement.bind(1, userID);
-		if (statement.executeStep())
+		CCachedStatement statement = GetStatement(query);
+		statement->bind(1, userID);
+		if (statement->executeStep())
 		{
 			int index = 0;
 			if (flag & 0x2)
 			{
-				stat.continiousSpecialQuest = statement.getColumn(index++);
+				stat.continiousSpecialQuest = statement->getColumn(index++);
 			}
 			if (flag & 0x8)
 			{
-				stat.dailyMissionsCompletedToday = statement.getColumn(index++);
+				stat.dailyMissionsCompletedToday = statement->getColumn(index++);
 			}
 			if (flag & 0x20)
 			{
-				stat.dailyMissionsCleared = statement.getColumn(index++);
+				stat.dailyMissionsCleared = statement->getColumn(index++);
 			}
 		}
 	}
 	catch (exception& e)
 	{
-		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::GetQuestStat: database internal error: %s, %d\n"), e.what(), m_Database.getErrorCode());
+		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::GetQuestStat: database internal error: %s, %d\n"), e.what(), GetDatabase().getErrorCode());
 		return 0;
 	}
 
@@ -3312,6 +4675,9 @@ int CUserDatabaseSQLite::GetQuestStat(int userID, int flag, UserQuestStat& stat)
 
 int CUserDatabaseSQLite::UpdateQuestStat(int userID, int flag, UserQuestStat& stat)
 {
+	PROFILE_DB();
+	lock_guard<recursive_mutex> lock(GetMutex());
+
 	try
 	{
 		// format query
@@ -3319,29 +4685,29 @@ int CUserDatabaseSQLite::UpdateQuestStat(int userID, int flag, UserQuestStat& st
 		query[query.size() - 1] = ' ';
 		query += OBFUSCATE("WHERE userID = ?"); // TODO: use stringstream
 
-		SQLite::Statement statement(m_Database, query);
+		CCachedStatement statement = GetStatement(query);
 		int index = 1;
 
 		if (flag & 0x2)
 		{
-			statement.bind(index++, stat.continiousSpecialQuest);
+			statement->bind(index++, stat.continiousSpecialQuest);
 		}
 		if (flag & 0x8)
 		{
-			statement.bind(index++, stat.dailyMissionsCompletedToday);
+			statement->bind(index++, stat.dailyMissionsCompletedToday);
 		}
 		if (flag & 0x20)
 		{
-			statement.bind(index++, stat.dailyMissionsCleared);
+			statement->bind(index++, stat.dailyMissionsCleared);
 		}
 
-		statement.bind(index++, userID);
+		statement->bind(index++, userID);
 
-		statement.exec();
+		statement->exec();
 	}
 	catch (exception& e)
 	{
-		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::UpdateQuestStat: database internal error: %s, %d\n"), e.what(), m_Database.getErrorCode());
+		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::UpdateQuestStat: database internal error: %s, %d\n"), e.what(), GetDatabase().getErrorCode());
 		return 0;
 	}
 
@@ -3350,19 +4716,22 @@ int CUserDatabaseSQLite::UpdateQuestStat(int userID, int flag, UserQuestStat& st
 
 int CUserDatabaseSQLite::GetBingoProgress(int userID, UserBingo& bingo)
 {
+	PROFILE_DB();
+	lock_guard<recursive_mutex> lock(GetMutex());
+
 	try
 	{
-		SQLite::Statement statement(m_Database, OBFUSCATE("SELECT status, canPlay FROM UserMiniGameBingo WHERE userID = ? LIMIT 1"));
-		statement.bind(1, userID);
-		if (statement.executeStep())
+		CCachedStatement statement = CACHED_STATEMENT("SELECT status, canPlay FROM UserMiniGameBingo WHERE userID = ? LIMIT 1");
+		statement->bind(1, userID);
+		if (statement->executeStep())
 		{
-			bingo.status = statement.getColumn(0);
-			bingo.canPlay = (char)statement.getColumn(1);
+			bingo.status = statement->getColumn(0);
+			bingo.canPlay = (char)statement->getColumn(1);
 		}
 	}
 	catch (exception& e)
 	{
-		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::GetBingoProgress: database internal error: %s, %d\n"), e.what(), m_Database.getErrorCode());
+		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::GetBingoProgress: database internal error: %s, %d\n"), e.what(), GetDatabase().getErrorCode());
 		return 0;
 	}
 
@@ -3371,24 +4740,27 @@ int CUserDatabaseSQLite::GetBingoProgress(int userID, UserBingo& bingo)
 
 int CUserDatabaseSQLite::UpdateBingoProgress(int userID, UserBingo& bingo)
 {
+	PROFILE_DB();
+	lock_guard<recursive_mutex> lock(GetMutex());
+
 	try
 	{
-		SQLite::Statement statement(m_Database, OBFUSCATE("UPDATE UserMiniGameBingo SET status = ?, canPlay = ? WHERE userID = ?"));
-		statement.bind(1, bingo.status);
-		statement.bind(2, bingo.canPlay);
-		statement.bind(3, userID);
-		if (!statement.exec())
+		CCachedStatement statement = CACHED_STATEMENT("UPDATE UserMiniGameBingo SET status = ?, canPlay = ? WHERE userID = ?");
+		statement->bind(1, bingo.status);
+		statement->bind(2, bingo.canPlay);
+		statement->bind(3, userID);
+		if (!statement->exec())
 		{
-			SQLite::Statement statement(m_Database, OBFUSCATE("INSERT INTO UserMiniGameBingo VALUES (?, ?, ?)"));
-			statement.bind(1, userID);
-			statement.bind(2, bingo.status);
-			statement.bind(3, bingo.canPlay);
-			statement.exec();
+			CCachedStatement statement = CACHED_STATEMENT("INSERT INTO UserMiniGameBingo VALUES (?, ?, ?)");
+			statement->bind(1, userID);
+			statement->bind(2, bingo.status);
+			statement->bind(3, bingo.canPlay);
+			statement->exec();
 		}
 	}
 	catch (exception& e)
 	{
-		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::UpdateBingoProgress: database internal error: %s, %d\n"), e.what(), m_Database.getErrorCode());
+		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::UpdateBingoProgress: database internal error: %s, %d\n"), e.what(), GetDatabase().getErrorCode());
 		return 0;
 	}
 
@@ -3397,22 +4769,25 @@ int CUserDatabaseSQLite::UpdateBingoProgress(int userID, UserBingo& bingo)
 
 int CUserDatabaseSQLite::GetBingoSlot(int userID, vector<UserBingoSlot>& slots)
 {
+	PROFILE_DB();
+	lock_guard<recursive_mutex> lock(GetMutex());
+
 	try
 	{
-		SQLite::Statement statement(m_Database, OBFUSCATE("SELECT number, opened FROM UserMiniGameBingoSlot WHERE userID = ?"));
-		statement.bind(1, userID);
-		while (statement.executeStep())
+		CCachedStatement statement = CACHED_STATEMENT("SELECT number, opened FROM UserMiniGameBingoSlot WHERE userID = ?");
+		statement->bind(1, userID);
+		while (statement->executeStep())
 		{
 			UserBingoSlot slot;
-			slot.number = statement.getColumn(0);
-			slot.opened = (char)statement.getColumn(1);
+			slot.number = statement->getColumn(0);
+			slot.opened = (char)statement->getColumn(1);
 
 			slots.push_back(slot);
 		}
 	}
 	catch (exception& e)
 	{
-		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::GetBingoSlot: database internal error: %s, %d\n"), e.what(), m_Database.getErrorCode());
+		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::GetBingoSlot: database internal error: %s, %d\n"), e.what(), GetDatabase().getErrorCode());
 		return 0;
 	}
 
@@ -3421,31 +4796,34 @@ int CUserDatabaseSQLite::GetBingoSlot(int userID, vector<UserBingoSlot>& slots)
 
 int CUserDatabaseSQLite::UpdateBingoSlot(int userID, vector<UserBingoSlot>& slots, bool remove)
 {
+	PROFILE_DB();
+	lock_guard<recursive_mutex> lock(GetMutex());
+
 	try
 	{
 		if (remove)
 		{
-			SQLite::Statement statement(m_Database, OBFUSCATE("DELETE FROM UserMiniGameBingoSlot WHERE userID = ?"));
-			statement.bind(1, userID);
-			statement.exec();
+			CCachedStatement statement = CACHED_STATEMENT("DELETE FROM UserMiniGameBingoSlot WHERE userID = ?");
+			statement->bind(1, userID);
+			statement->exec();
 		}
 
 		for (UserBingoSlot& slot : slots)
 		{
-			SQLite::Statement statement(m_Database, OBFUSCATE("UPDATE UserMiniGameBingoSlot SET opened = ? WHERE userID = ? AND number = ?"));
-			statement.bind(1, slot.opened);
-			statement.bind(2, userID);
-			statement.bind(3, slot.number);
-			if (!statement.exec())
+			CCachedStatement statement = CACHED_STATEMENT("UPDATE UserMiniGameBingoSlot SET opened = ? WHERE userID = ? AND number = ?");
+			statement->bind(1, slot.opened);
+			statement->bind(2, userID);
+			statement->bind(3, slot.number);
+			if (!statement->exec())
 			{
 				// TODO: use transaction or multiple insert
 				for (UserBingoSlot& slot : slots)
 				{
-					SQLite::Statement statement(m_Database, OBFUSCATE("INSERT INTO UserMiniGameBingoSlot VALUES (?, ?, ?)"));
-					statement.bind(1, userID);
-					statement.bind(2, slot.number);
-					statement.bind(3, slot.opened);
-					statement.exec();
+					CCachedStatement statement = CACHED_STATEMENT("INSERT INTO UserMiniGameBingoSlot VALUES (?, ?, ?)");
+					statement->bind(1, userID);
+					statement->bind(2, slot.number);
+					statement->bind(3, slot.opened);
+					statement->exec();
 				}
 				break;
 			}
@@ -3453,7 +4831,7 @@ int CUserDatabaseSQLite::UpdateBingoSlot(int userID, vector<UserBingoSlot>& slot
 	}
 	catch (exception& e)
 	{
-		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::UpdateBingoSlot: database internal error: %s, %d\n"), e.what(), m_Database.getErrorCode());
+		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::UpdateBingoSlot: database internal error: %s, %d\n"), e.what(), GetDatabase().getErrorCode());
 		return 0;
 	}
 
@@ -3462,27 +4840,30 @@ int CUserDatabaseSQLite::UpdateBingoSlot(int userID, vector<UserBingoSlot>& slot
 
 int CUserDatabaseSQLite::GetBingoPrizeSlot(int userID, vector<UserBingoPrizeSlot>& prizes)
 {
+	PROFILE_DB();
+	lock_guard<recursive_mutex> lock(GetMutex());
+
 	try
 	{
-		SQLite::Statement statement(m_Database, OBFUSCATE("SELECT idx, opened, itemID, count, duration, relatesTo FROM UserMiniGameBingoPrizeSlot WHERE userID = ?"));
-		statement.bind(1, userID);
-		while (statement.executeStep())
+		CCachedStatement statement = CACHED_STATEMENT("SELECT idx, opened, itemID, count, duration, relatesTo FROM UserMiniGameBingoPrizeSlot WHERE userID = ?");
+		statement->bind(1, userID);
+		while (statement->executeStep())
 		{
 			UserBingoPrizeSlot slot;
-			slot.index = statement.getColumn(0);
-			slot.opened = (char)statement.getColumn(1);
-			slot.item.itemID = statement.getColumn(2);
-			slot.item.count = statement.getColumn(3);
-			slot.item.duration = statement.getColumn(4);
-			slot.bingoIndexes = deserialize_array_int(statement.getColumn(5));
+			slot.index = statement->getColumn(0);
+			slot.opened = (char)statement->getColumn(1);
+			slot.item.itemID = statement->getColumn(2);
+			slot.item.count = statement->getColumn(3);
+			slot.item.duration = statement->getColumn(4);
+			slot.bingoIndexes = deserialize_array_int(statement->getColumn(5));
 
 			prizes.push_back(slot);
 		}
-		statement.reset();
+		statement->reset();
 	}
 	catch (exception& e)
 	{
-		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::GetBingoPrizeSlot: database internal error: %s, %d\n"), e.what(), m_Database.getErrorCode());
+		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::GetBingoPrizeSlot: database internal error: %s, %d\n"), e.what(), GetDatabase().getErrorCode());
 		return 0;
 	}
 
@@ -3491,35 +4872,38 @@ int CUserDatabaseSQLite::GetBingoPrizeSlot(int userID, vector<UserBingoPrizeSlot
 
 int CUserDatabaseSQLite::UpdateBingoPrizeSlot(int userID, vector<UserBingoPrizeSlot>& prizes, bool remove)
 {
+	PROFILE_DB();
+	lock_guard<recursive_mutex> lock(GetMutex());
+
 	try
 	{
 		if (remove)
 		{
-			SQLite::Statement statement(m_Database, OBFUSCATE("DELETE FROM UserMiniGameBingoPrizeSlot WHERE userID = ?"));
-			statement.bind(1, userID);
-			statement.exec();
+			CCachedStatement statement = CACHED_STATEMENT("DELETE FROM UserMiniGameBingoPrizeSlot WHERE userID = ?");
+			statement->bind(1, userID);
+			statement->exec();
 		}
 
 		for (UserBingoPrizeSlot& prize : prizes)
 		{
-			SQLite::Statement statement(m_Database, OBFUSCATE("UPDATE UserMiniGameBingoPrizeSlot SET opened = ? WHERE userID = ? AND idx = ?"));
-			statement.bind(1, prize.opened);
-			statement.bind(2, userID);
-			statement.bind(3, prize.index);
-			if (!statement.exec())
+			CCachedStatement statement = CACHED_STATEMENT("UPDATE UserMiniGameBingoPrizeSlot SET opened = ? WHERE userID = ? AND idx = ?");
+			statement->bind(1, prize.opened);
+			statement->bind(2, userID);
+			statement->bind(3, prize.index);
+			if (!statement->exec())
 			{
 				// TODO: use transaction or multiple insert
 				for (UserBingoPrizeSlot& prize : prizes)
 				{
-					SQLite::Statement statement(m_Database, OBFUSCATE("INSERT INTO UserMiniGameBingoPrizeSlot VALUES (?, ?, ?, ?, ?, ?, ?)"));
-					statement.bind(1, userID);
-					statement.bind(2, prize.index);
-					statement.bind(3, prize.opened);
-					statement.bind(4, prize.item.itemID);
-					statement.bind(5, prize.item.count);
-					statement.bind(6, prize.item.duration);
-					statement.bind(7, serialize_array_int(prize.bingoIndexes));
-					statement.exec();
+					CCachedStatement statement = CACHED_STATEMENT("INSERT INTO UserMiniGameBingoPrizeSlot VALUES (?, ?, ?, ?, ?, ?, ?)");
+					statement->bind(1, userID);
+					statement->bind(2, prize.index);
+					statement->bind(3, prize.opened);
+					statement->bind(4, prize.item.itemID);
+					statement->bind(5, prize.item.count);
+					statement->bind(6, prize.item.duration);
+					statement->bind(7, serialize_array_int(prize.bingoIndexes));
+					statement->exec();
 				}
 				break;
 			}
@@ -3527,7 +4911,7 @@ int CUserDatabaseSQLite::UpdateBingoPrizeSlot(int userID, vector<UserBingoPrizeS
 	}
 	catch (exception& e)
 	{
-		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::UpdateBingoPrizeSlot: database internal error: %s, %d\n"), e.what(), m_Database.getErrorCode());
+		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::UpdateBingoPrizeSlot: database internal error: %s, %d\n"), e.what(), GetDatabase().getErrorCode());
 		return 0;
 	}
 
@@ -3538,20 +4922,23 @@ int CUserDatabaseSQLite::UpdateBingoPrizeSlot(int userID, vector<UserBingoPrizeS
 // returns 0 == database error, 1 on success
 int CUserDatabaseSQLite::GetUserRank(int userID, CUserCharacter& character)
 {
+	PROFILE_DB();
+	lock_guard<recursive_mutex> lock(GetMutex());
+
 	try
 	{
-		SQLite::Statement statement(m_Database, OBFUSCATE("SELECT tierOri, tierZM, tierZPVE, tierDM FROM UserRank WHERE userID = ? LIMIT 1"));
-		statement.bind(1, userID);
+		CCachedStatement statement = CACHED_STATEMENT("SELECT tierOri, tierZM, tierZPVE, tierDM FROM UserRank WHERE userID = ? LIMIT 1");
+		statement->bind(1, userID);
 
-		if (statement.executeStep())
+		if (statement->executeStep())
 		{
 			for (int i = 0; i < 4; i++)
-				character.tier[i] = statement.getColumn(i);
+				character.tier[i] = statement->getColumn(i);
 		}
 	}
 	catch (exception& e)
 	{
-		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::GetUserRank: database internal error: %s, %d\n"), e.what(), m_Database.getErrorCode());
+		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::GetUserRank: database internal error: %s, %d\n"), e.what(), GetDatabase().getErrorCode());
 		return 0;
 	}
 
@@ -3562,20 +4949,23 @@ int CUserDatabaseSQLite::GetUserRank(int userID, CUserCharacter& character)
 // returns 0 == database error, 1 on success
 int CUserDatabaseSQLite::UpdateUserRank(int userID, CUserCharacter& character)
 {
+	PROFILE_DB();
+	lock_guard<recursive_mutex> lock(GetMutex());
+
 	try
 	{
-		SQLite::Statement statement(m_Database, OBFUSCATE("UPDATE UserRank SET tierOri = ?, tierZM = ?, tierZPVE = ?, tierDM = ? WHERE userID = ?"));
+		CCachedStatement statement = CACHED_STATEMENT("UPDATE UserRank SET tierOri = ?, tierZM = ?, tierZPVE = ?, tierDM = ? WHERE userID = ?");
 		int index = 1;
 		for (int i = 0; i < 4; i++)
-			statement.bind(index++, character.tier[i]);
+			statement->bind(index++, character.tier[i]);
 
-		statement.bind(index++, userID);
+		statement->bind(index++, userID);
 
-		statement.exec();
+		statement->exec();
 	}
 	catch (exception& e)
 	{
-		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::UpdateUserRank: database internal error: %s, %d\n"), e.what(), m_Database.getErrorCode());
+		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::UpdateUserRank: database internal error: %s, %d\n"), e.what(), GetDatabase().getErrorCode());
 		return 0;
 	}
 
@@ -3586,18 +4976,21 @@ int CUserDatabaseSQLite::UpdateUserRank(int userID, CUserCharacter& character)
 // returns 0 == database error, 1 on success
 int CUserDatabaseSQLite::GetBanList(int userID, vector<string>& banList)
 {
+	PROFILE_DB();
+	lock_guard<recursive_mutex> lock(GetMutex());
+
 	try
 	{
-		SQLite::Statement query(m_Database, OBFUSCATE("SELECT gameName, (SELECT NOT EXISTS(SELECT 1 FROM UserCharacter WHERE gameName = UserBanList.gameName LIMIT 1)) FROM UserBanList WHERE userID = ?"));
-		query.bind(1, userID);
-		while (query.executeStep())
+		CCachedStatement query = CACHED_STATEMENT("SELECT gameName, (SELECT NOT EXISTS(SELECT 1 FROM UserCharacter WHERE gameName = UserBanList.gameName LIMIT 1)) FROM UserBanList WHERE userID = ?");
+		query->bind(1, userID);
+		while (query->executeStep())
 		{
-			banList.push_back((const char*)query.getColumn(0));
+			banList.push_back((const char*)query->getColumn(0));
 		}
 	}
 	catch (exception& e)
 	{
-		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::GetBanList: database internal error: %s, %d\n"), e.what(), m_Database.getErrorCode());
+		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::GetBanList: database internal error: %s, %d\n"), e.what(), GetDatabase().getErrorCode());
 		return 0;
 	}
 
@@ -3608,14 +5001,17 @@ int CUserDatabaseSQLite::GetBanList(int userID, vector<string>& banList)
 // returns 0 == database error, -1 on user not exists, -2 on user exists(add), -3 on limit exceeded(add), 1 on success
 int CUserDatabaseSQLite::UpdateBanList(int userID, string gameName, bool remove)
 {
+	PROFILE_DB();
+	lock_guard<recursive_mutex> lock(GetMutex());
+
 	try
 	{
 		if (remove)
 		{
-			SQLite::Statement query(m_Database, OBFUSCATE("DELETE FROM UserBanList WHERE userID = ? AND gameName = ?"));
-			query.bind(1, userID);
-			query.bind(2, gameName);
-			if (!query.exec())
+			CCachedStatement query = CACHED_STATEMENT("DELETE FROM UserBanList WHERE userID = ? AND gameName = ?");
+			query->bind(1, userID);
+			query->bind(2, gameName);
+			if (!query->exec())
 			{
 				return -1;
 			}
@@ -3623,43 +5019,43 @@ int CUserDatabaseSQLite::UpdateBanList(int userID, string gameName, bool remove)
 		else
 		{
 			{
-				SQLite::Statement query(m_Database, OBFUSCATE("SELECT EXISTS(SELECT 1 FROM UserCharacter WHERE gameName = ? LIMIT 1)"));
-				query.bind(1, gameName);
-				if (query.executeStep())
+				CCachedStatement query = CACHED_STATEMENT("SELECT EXISTS(SELECT 1 FROM UserCharacter WHERE gameName = ? LIMIT 1)");
+				query->bind(1, gameName);
+				if (query->executeStep())
 				{
-					if (!(int)query.getColumn(0))
+					if (!(int)query->getColumn(0))
 					{
 						return -1;
 					}
 				}
 			}
 			{
-				SQLite::Statement query(m_Database, OBFUSCATE("SELECT EXISTS(SELECT 1 FROM UserBanList WHERE userID = ? AND gameName = ? LIMIT 1)"));
-				query.bind(1, userID);
-				query.bind(2, gameName);
-				if (query.executeStep())
+				CCachedStatement query = CACHED_STATEMENT("SELECT EXISTS(SELECT 1 FROM UserBanList WHERE userID = ? AND gameName = ? LIMIT 1)");
+				query->bind(1, userID);
+				query->bind(2, gameName);
+				if (query->executeStep())
 				{
-					if ((int)query.getColumn(0))
+					if ((int)query->getColumn(0))
 					{
 						return -2;
 					}
 				}
 			}
 			{
-				SQLite::Statement query(m_Database, OBFUSCATE("SELECT COUNT(1) FROM UserBanList WHERE userID = ?"));
-				query.bind(1, userID);
-				if (query.executeStep())
+				CCachedStatement query = CACHED_STATEMENT("SELECT COUNT(1) FROM UserBanList WHERE userID = ?");
+				query->bind(1, userID);
+				if (query->executeStep())
 				{
-					if ((int)query.getColumn(0) >= g_pServerConfig->banListMaxSize)
+					if ((int)query->getColumn(0) >= g_pServerConfig->banListMaxSize)
 					{
 						return -3;
 					}
 				}
 			}
-			SQLite::Statement query(m_Database, OBFUSCATE("INSERT INTO UserBanList VALUES (?, ?)"));
-			query.bind(1, userID);
-			query.bind(2, gameName);
-			if (!query.exec())
+			CCachedStatement query = CACHED_STATEMENT("INSERT INTO UserBanList VALUES (?, ?)");
+			query->bind(1, userID);
+			query->bind(2, gameName);
+			if (!query->exec())
 			{
 				return 0;
 			}
@@ -3667,7 +5063,7 @@ int CUserDatabaseSQLite::UpdateBanList(int userID, string gameName, bool remove)
 	}
 	catch (exception& e)
 	{
-		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::UpdateBanList: database internal error: %s, %d\n"), e.what(), m_Database.getErrorCode());
+		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::UpdateBanList: database internal error: %s, %d\n"), e.what(), GetDatabase().getErrorCode());
 		return 0;
 	}
 
@@ -3678,14 +5074,17 @@ int CUserDatabaseSQLite::UpdateBanList(int userID, string gameName, bool remove)
 // returns 0 == database error or user not in ban list, 1 on user in ban list
 bool CUserDatabaseSQLite::IsInBanList(int userID, int destUserID)
 {
+	PROFILE_DB();
+	lock_guard<recursive_mutex> lock(GetMutex());
+
 	try
 	{
-		SQLite::Statement query(m_Database, OBFUSCATE("SELECT NOT EXISTS(SELECT 1 FROM UserBanList WHERE userID = ? AND gameName = (SELECT gameName FROM UserCharacter WHERE userID = ? LIMIT 1) LIMIT 1)"));
-		query.bind(1, userID);
-		query.bind(2, destUserID);
-		if (query.executeStep())
+		CCachedStatement query = CACHED_STATEMENT("SELECT NOT EXISTS(SELECT 1 FROM UserBanList WHERE userID = ? AND gameName = (SELECT gameName FROM UserCharacter WHERE userID = ? LIMIT 1) LIMIT 1)");
+		query->bind(1, userID);
+		query->bind(2, destUserID);
+		if (query->executeStep())
 		{
-			if ((int)query.getColumn(0))
+			if ((int)query->getColumn(0))
 			{
 				return false;
 			}
@@ -3694,7 +5093,7 @@ bool CUserDatabaseSQLite::IsInBanList(int userID, int destUserID)
 	}
 	catch (exception& e)
 	{
-		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::IsInBanList: database internal error: %s, %d\n"), e.what(), m_Database.getErrorCode());
+		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::IsInBanList: database internal error: %s, %d\n"), e.what(), GetDatabase().getErrorCode());
 		return false;
 	}
 
@@ -3703,19 +5102,22 @@ bool CUserDatabaseSQLite::IsInBanList(int userID, int destUserID)
 
 bool CUserDatabaseSQLite::IsSurveyAnswered(int userID, int surveyID)
 {
+	PROFILE_DB();
+	lock_guard<recursive_mutex> lock(GetMutex());
+
 	try
 	{
-		SQLite::Statement query(m_Database, OBFUSCATE("SELECT EXISTS(SELECT 1 FROM UserSurveyAnswer WHERE userID = ? AND surveyID = ? LIMIT 1)"));
-		query.bind(1, userID);
-		query.bind(2, surveyID);
-		if (query.executeStep())
+		CCachedStatement query = CACHED_STATEMENT("SELECT EXISTS(SELECT 1 FROM UserSurveyAnswer WHERE userID = ? AND surveyID = ? LIMIT 1)");
+		query->bind(1, userID);
+		query->bind(2, surveyID);
+		if (query->executeStep())
 		{
-			return (char)query.getColumn(0);
+			return (char)query->getColumn(0);
 		}
 	}
 	catch (exception& e)
 	{
-		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::IsSurveyAnswered: database internal error: %s, %d\n"), e.what(), m_Database.getErrorCode());
+		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::IsSurveyAnswered: database internal error: %s, %d\n"), e.what(), GetDatabase().getErrorCode());
 		return true;
 	}
 
@@ -3724,6 +5126,9 @@ bool CUserDatabaseSQLite::IsSurveyAnswered(int userID, int surveyID)
 
 int CUserDatabaseSQLite::SurveyAnswer(int userID, UserSurveyAnswer& answer)
 {
+	PROFILE_DB();
+	lock_guard<recursive_mutex> lock(GetMutex());
+
 	try
 	{
 		for (auto& questionAnswer : answer.questionsAnswers)
@@ -3732,12 +5137,12 @@ int CUserDatabaseSQLite::SurveyAnswer(int userID, UserSurveyAnswer& answer)
 			{
 				for (auto& answerStr : questionAnswer.answers)
 				{
-					SQLite::Statement query(m_Database, OBFUSCATE("INSERT INTO UserSurveyAnswer VALUES (?, ?, ?, ?)"));
-					query.bind(1, answer.surveyID);
-					query.bind(2, questionAnswer.questionID);
-					query.bind(3, userID);
-					query.bind(4, answerStr);
-					if (!query.exec())
+					CCachedStatement query = CACHED_STATEMENT("INSERT INTO UserSurveyAnswer VALUES (?, ?, ?, ?)");
+					query->bind(1, answer.surveyID);
+					query->bind(2, questionAnswer.questionID);
+					query->bind(3, userID);
+					query->bind(4, answerStr);
+					if (!query->exec())
 					{
 						return 0;
 					}
@@ -3745,12 +5150,12 @@ int CUserDatabaseSQLite::SurveyAnswer(int userID, UserSurveyAnswer& answer)
 			}
 			else
 			{
-				SQLite::Statement query(m_Database, OBFUSCATE("INSERT INTO UserSurveyAnswer VALUES (?, ?, ?, ?)"));
-				query.bind(1, answer.surveyID);
-				query.bind(2, questionAnswer.questionID);
-				query.bind(3, userID);
-				query.bind(4, questionAnswer.answers[0]);
-				if (!query.exec())
+				CCachedStatement query = CACHED_STATEMENT("INSERT INTO UserSurveyAnswer VALUES (?, ?, ?, ?)");
+				query->bind(1, answer.surveyID);
+				query->bind(2, questionAnswer.questionID);
+				query->bind(3, userID);
+				query->bind(4, questionAnswer.answers[0]);
+				if (!query->exec())
 				{
 					return 0;
 				}
@@ -3759,7 +5164,7 @@ int CUserDatabaseSQLite::SurveyAnswer(int userID, UserSurveyAnswer& answer)
 	}
 	catch (exception& e)
 	{
-		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::SurveyAnswer: database internal error: %s, %d\n"), e.what(), m_Database.getErrorCode());
+		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::SurveyAnswer: database internal error: %s, %d\n"), e.what(), GetDatabase().getErrorCode());
 		return 0;
 	}
 
@@ -3768,23 +5173,26 @@ int CUserDatabaseSQLite::SurveyAnswer(int userID, UserSurveyAnswer& answer)
 
 int CUserDatabaseSQLite::GetWeaponReleaseRows(int userID, vector<UserWeaponReleaseRow>& rows)
 {
+	PROFILE_DB();
+	lock_guard<recursive_mutex> lock(GetMutex());
+
 	try
 	{
-		SQLite::Statement query(m_Database, OBFUSCATE("SELECT slot, character, opened FROM UserMiniGameWeaponReleaseItemProgress WHERE userID = ?"));
-		query.bind(1, userID);
-		while (query.executeStep())
+		CCachedStatement query = CACHED_STATEMENT("SELECT slot, character, opened FROM UserMiniGameWeaponReleaseItemProgress WHERE userID = ?");
+		query->bind(1, userID);
+		while (query->executeStep())
 		{
 			UserWeaponReleaseRow row;
-			row.id = query.getColumn(0);
-			row.progress = query.getColumn(1);
-			row.opened = (char)query.getColumn(2);
+			row.id = query->getColumn(0);
+			row.progress = query->getColumn(1);
+			row.opened = (char)query->getColumn(2);
 
 			rows.push_back(row);
 		}
 	}
 	catch (exception& e)
 	{
-		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::GetWeaponReleaseProgress: database internal error: %s, %d\n"), e.what(), m_Database.getErrorCode());
+		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::GetWeaponReleaseProgress: database internal error: %s, %d\n"), e.what(), GetDatabase().getErrorCode());
 		return 0;
 	}
 
@@ -3793,20 +5201,23 @@ int CUserDatabaseSQLite::GetWeaponReleaseRows(int userID, vector<UserWeaponRelea
 
 int CUserDatabaseSQLite::GetWeaponReleaseRow(int userID, UserWeaponReleaseRow& row)
 {
+	PROFILE_DB();
+	lock_guard<recursive_mutex> lock(GetMutex());
+
 	try
 	{
-		SQLite::Statement query(m_Database, OBFUSCATE("SELECT character, opened FROM UserMiniGameWeaponReleaseItemProgress WHERE userID = ? AND slot = ? LIMIT 1"));
-		query.bind(1, userID);
-		query.bind(2, row.id);
-		if (query.executeStep())
+		CCachedStatement query = CACHED_STATEMENT("SELECT character, opened FROM UserMiniGameWeaponReleaseItemProgress WHERE userID = ? AND slot = ? LIMIT 1");
+		query->bind(1, userID);
+		query->bind(2, row.id);
+		if (query->executeStep())
 		{
-			row.progress = query.getColumn(0);
-			row.opened = (char)query.getColumn(1);
+			row.progress = query->getColumn(0);
+			row.opened = (char)query->getColumn(1);
 		}
 	}
 	catch (exception& e)
 	{
-		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::GetWeaponReleaseRow: database internal error: %s, %d\n"), e.what(), m_Database.getErrorCode());
+		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::GetWeaponReleaseRow: database internal error: %s, %d\n"), e.what(), GetDatabase().getErrorCode());
 		return 0;
 	}
 
@@ -3815,26 +5226,29 @@ int CUserDatabaseSQLite::GetWeaponReleaseRow(int userID, UserWeaponReleaseRow& r
 
 int CUserDatabaseSQLite::UpdateWeaponReleaseRow(int userID, UserWeaponReleaseRow& row)
 {
+	PROFILE_DB();
+	lock_guard<recursive_mutex> lock(GetMutex());
+
 	try
 	{
-		SQLite::Statement query(m_Database, OBFUSCATE("UPDATE UserMiniGameWeaponReleaseItemProgress SET character = ?, opened = ? WHERE userID = ? AND slot = ?"));
-		query.bind(1, row.progress);
-		query.bind(2, row.opened);
-		query.bind(3, userID);
-		query.bind(4, row.id);
-		if (!query.exec())
+		CCachedStatement query = CACHED_STATEMENT("UPDATE UserMiniGameWeaponReleaseItemProgress SET character = ?, opened = ? WHERE userID = ? AND slot = ?");
+		query->bind(1, row.progress);
+		query->bind(2, row.opened);
+		query->bind(3, userID);
+		query->bind(4, row.id);
+		if (!query->exec())
 		{
-			SQLite::Statement query(m_Database, OBFUSCATE("INSERT INTO UserMiniGameWeaponReleaseItemProgress VALUES (?, ?, ?, ?)"));
-			query.bind(1, userID);
-			query.bind(2, row.id);
-			query.bind(3, row.progress);
-			query.bind(4, row.opened);
-			query.exec();
+			CCachedStatement query = CACHED_STATEMENT("INSERT INTO UserMiniGameWeaponReleaseItemProgress VALUES (?, ?, ?, ?)");
+			query->bind(1, userID);
+			query->bind(2, row.id);
+			query->bind(3, row.progress);
+			query->bind(4, row.opened);
+			query->exec();
 		}
 	}
 	catch (exception& e)
 	{
-		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::UpdateWeaponReleaseRow: database internal error: %s, %d\n"), e.what(), m_Database.getErrorCode());
+		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::UpdateWeaponReleaseRow: database internal error: %s, %d\n"), e.what(), GetDatabase().getErrorCode());
 		return 0;
 	}
 
@@ -3843,15 +5257,18 @@ int CUserDatabaseSQLite::UpdateWeaponReleaseRow(int userID, UserWeaponReleaseRow
 
 int CUserDatabaseSQLite::GetWeaponReleaseCharacters(int userID, vector<UserWeaponReleaseCharacter>& characters, int& totalCount)
 {
+	PROFILE_DB();
+	lock_guard<recursive_mutex> lock(GetMutex());
+
 	try
 	{
-		SQLite::Statement query(m_Database, OBFUSCATE("SELECT character, count FROM UserMiniGameWeaponReleaseCharacters WHERE userID = ?"));
-		query.bind(1, userID);
-		while (query.executeStep())
+		CCachedStatement query = CACHED_STATEMENT("SELECT character, count FROM UserMiniGameWeaponReleaseCharacters WHERE userID = ?");
+		query->bind(1, userID);
+		while (query->executeStep())
 		{
 			UserWeaponReleaseCharacter character;
-			character.character = query.getColumn(0);
-			character.count = query.getColumn(1);
+			character.character = query->getColumn(0);
+			character.count = query->getColumn(1);
 
 			totalCount += character.count;
 
@@ -3860,7 +5277,7 @@ int CUserDatabaseSQLite::GetWeaponReleaseCharacters(int userID, vector<UserWeapo
 	}
 	catch (exception& e)
 	{
-		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::GetWeaponReleaseCharacters: database internal error: %s, %d\n"), e.what(), m_Database.getErrorCode());
+		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::GetWeaponReleaseCharacters: database internal error: %s, %d\n"), e.what(), GetDatabase().getErrorCode());
 		return 0;
 	}
 
@@ -3869,14 +5286,17 @@ int CUserDatabaseSQLite::GetWeaponReleaseCharacters(int userID, vector<UserWeapo
 
 int CUserDatabaseSQLite::GetWeaponReleaseCharacter(int userID, UserWeaponReleaseCharacter& character)
 {
+	PROFILE_DB();
+	lock_guard<recursive_mutex> lock(GetMutex());
+
 	try
 	{
-		SQLite::Statement query(m_Database, OBFUSCATE("SELECT count FROM UserMiniGameWeaponReleaseCharacters WHERE userID = ? AND character = ? LIMIT 1"));
-		query.bind(1, userID);
-		query.bind(2, character.character);
-		if (query.executeStep())
+		CCachedStatement query = CACHED_STATEMENT("SELECT count FROM UserMiniGameWeaponReleaseCharacters WHERE userID = ? AND character = ? LIMIT 1");
+		query->bind(1, userID);
+		query->bind(2, character.character);
+		if (query->executeStep())
 		{
-			character.count = query.getColumn(0);
+			character.count = query->getColumn(0);
 		}
 		else
 		{
@@ -3885,7 +5305,7 @@ int CUserDatabaseSQLite::GetWeaponReleaseCharacter(int userID, UserWeaponRelease
 	}
 	catch (exception& e)
 	{
-		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::GetWeaponReleaseCharacter: database internal error: %s, %d\n"), e.what(), m_Database.getErrorCode());
+		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::GetWeaponReleaseCharacter: database internal error: %s, %d\n"), e.what(), GetDatabase().getErrorCode());
 		return 0;
 	}
 
@@ -3894,24 +5314,27 @@ int CUserDatabaseSQLite::GetWeaponReleaseCharacter(int userID, UserWeaponRelease
 
 int CUserDatabaseSQLite::UpdateWeaponReleaseCharacter(int userID, UserWeaponReleaseCharacter& character)
 {
+	PROFILE_DB();
+	lock_guard<recursive_mutex> lock(GetMutex());
+
 	try
 	{
-		SQLite::Statement query(m_Database, OBFUSCATE("UPDATE UserMiniGameWeaponReleaseCharacters SET count = count + ? WHERE userID = ? AND character = ?"));
-		query.bind(1, character.count);
-		query.bind(2, userID);
-		query.bind(3, character.character);
-		if (!query.exec())
+		CCachedStatement query = CACHED_STATEMENT("UPDATE UserMiniGameWeaponReleaseCharacters SET count = count + ? WHERE userID = ? AND character = ?");
+		query->bind(1, character.count);
+		query->bind(2, userID);
+		query->bind(3, character.character);
+		if (!query->exec())
 		{
-			SQLite::Statement query(m_Database, OBFUSCATE("INSERT INTO UserMiniGameWeaponReleaseCharacters VALUES (?, ?, ?)"));
-			query.bind(1, userID);
-			query.bind(2, character.character);
-			query.bind(3, character.count);
-			query.exec();
+			CCachedStatement query = CACHED_STATEMENT("INSERT INTO UserMiniGameWeaponReleaseCharacters VALUES (?, ?, ?)");
+			query->bind(1, userID);
+			query->bind(2, character.character);
+			query->bind(3, character.count);
+			query->exec();
 		}
 	}
 	catch (exception& e)
 	{
-		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::UpdateWeaponReleaseCharacter: database internal error: %s, %d\n"), e.what(), m_Database.getErrorCode());
+		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::UpdateWeaponReleaseCharacter: database internal error: %s, %d\n"), e.what(), GetDatabase().getErrorCode());
 		return 0;
 	}
 
@@ -3920,42 +5343,45 @@ int CUserDatabaseSQLite::UpdateWeaponReleaseCharacter(int userID, UserWeaponRele
 
 int CUserDatabaseSQLite::SetWeaponReleaseCharacter(int userID, int weaponSlot, int slot, int character, bool opened)
 {
+	PROFILE_DB();
+	lock_guard<recursive_mutex> lock(GetMutex());
+
 	try
 	{
-		SQLite::Transaction transaction(m_Database);
+		CWriteTransaction transaction(GetDatabase());
 		{
-			SQLite::Statement query(m_Database, OBFUSCATE("UPDATE UserMiniGameWeaponReleaseItemProgress SET character = character | (1 << ?), opened = ? WHERE userID = ? AND slot = ?"));
-			query.bind(1, slot);
-			query.bind(2, opened);
-			query.bind(3, userID);
-			query.bind(4, weaponSlot);
-			if (!query.exec())
+			CCachedStatement query = CACHED_STATEMENT("UPDATE UserMiniGameWeaponReleaseItemProgress SET character = character | (1 << ?), opened = ? WHERE userID = ? AND slot = ?");
+			query->bind(1, slot);
+			query->bind(2, opened);
+			query->bind(3, userID);
+			query->bind(4, weaponSlot);
+			if (!query->exec())
 			{
-				SQLite::Statement query(m_Database, OBFUSCATE("INSERT INTO UserMiniGameWeaponReleaseItemProgress VALUES(?, ?, (1 << ?), ?)"));
-				query.bind(1, userID);
-				query.bind(2, weaponSlot);
-				query.bind(3, slot);
-				query.bind(4, opened);
-				if (!query.exec())
+				CCachedStatement query = CACHED_STATEMENT("INSERT INTO UserMiniGameWeaponReleaseItemProgress VALUES(?, ?, (1 << ?), ?)");
+				query->bind(1, userID);
+				query->bind(2, weaponSlot);
+				query->bind(3, slot);
+				query->bind(4, opened);
+				if (!query->exec())
 				{
 					return -1;
 				}
 			}
 		}
 		{
-			SQLite::Statement query(m_Database, OBFUSCATE("UPDATE UserMiniGameWeaponReleaseCharacters SET count = count - 1 WHERE userID = ? AND character = ?"));
-			query.bind(1, userID);
-			query.bind(2, character);
-			if (!query.exec())
+			CCachedStatement query = CACHED_STATEMENT("UPDATE UserMiniGameWeaponReleaseCharacters SET count = count - 1 WHERE userID = ? AND character = ?");
+			query->bind(1, userID);
+			query->bind(2, character);
+			if (!query->exec())
 			{
 				return -1;
 			}
 		}
-		transaction.commit();
+		transaction.Commit();
 	}
 	catch (exception& e)
 	{
-		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::UpdateWeaponReleaseCharacter: database internal error: %s, %d\n"), e.what(), m_Database.getErrorCode());
+		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::UpdateWeaponReleaseCharacter: database internal error: %s, %d\n"), e.what(), GetDatabase().getErrorCode());
 		return 0;
 	}
 
@@ -3965,19 +5391,22 @@ int CUserDatabaseSQLite::SetWeaponReleaseCharacter(int userID, int weaponSlot, i
 
 int CUserDatabaseSQLite::GetAddons(int userID, vector<int>& addons)
 {
+	PROFILE_DB();
+	lock_guard<recursive_mutex> lock(GetMutex());
+
 	try
 	{
-		SQLite::Statement query(m_Database, OBFUSCATE("SELECT itemID FROM UserAddon WHERE userID = ? LIMIT ?"));
-		query.bind(1, userID);
-		query.bind(2, ADDON_COUNT);
-		while (query.executeStep())
+		CCachedStatement query = CACHED_STATEMENT("SELECT itemID FROM UserAddon WHERE userID = ? LIMIT ?");
+		query->bind(1, userID);
+		query->bind(2, ADDON_COUNT);
+		while (query->executeStep())
 		{
-			addons.push_back(query.getColumn(0));
+			addons.push_back(query->getColumn(0));
 		}
 	}
 	catch (exception& e)
 	{
-		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::GetAddons: database internal error: %s, %d\n"), e.what(), m_Database.getErrorCode());
+		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::GetAddons: database internal error: %s, %d\n"), e.what(), GetDatabase().getErrorCode());
 		return 0;
 	}
 
@@ -3986,63 +5415,69 @@ int CUserDatabaseSQLite::GetAddons(int userID, vector<int>& addons)
 
 int CUserDatabaseSQLite::SetAddons(int userID, vector<int>& addons)
 {
+	PROFILE_DB();
+	lock_guard<recursive_mutex> lock(GetMutex());
+
 	try
 	{
-		SQLite::Transaction transaction(m_Database);
+		CWriteTransaction transaction(GetDatabase());
 
-		SQLite::Statement query(m_Database, OBFUSCATE("DELETE FROM UserAddon WHERE userID = ?"));
-		query.bind(1, userID);
-		query.exec();
+		CCachedStatement query = CACHED_STATEMENT("DELETE FROM UserAddon WHERE userID = ?");
+		query->bind(1, userID);
+		query->exec();
 
 		{
-			SQLite::Statement query(m_Database, OBFUSCATE("INSERT INTO UserAddon VALUES (?, ?)"));
+			CCachedStatement query = CACHED_STATEMENT("INSERT INTO UserAddon VALUES (?, ?)");
 
 			for (auto itemID : addons)
 			{
-				query.bind(1, userID);
-				query.bind(2, itemID);
-				if (!query.exec())
+				query->bind(1, userID);
+				query->bind(2, itemID);
+				if (!query->exec())
 				{
 					return -1;
 				}
-				query.reset();
-				query.clearBindings();
+				query->reset();
+				query->clearBindings();
 			}
 		}
 
-		transaction.commit();
+		transaction.Commit();
 	}
 	catch (exception& e)
 	{
-		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::SetAddons: database internal error: %s, %d\n"), e.what(), m_Database.getErrorCode());
+		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::SetAddons: database internal error: %s, %d\n"), e.what(), GetDatabase().getErrorCode());
 		return 0;
 	}
 
 	return 1;
 }
 
+// uses read-only connection, can be called by any thread
 int CUserDatabaseSQLite::GetUsersAssociatedWithIP(const string& ip, vector<CUserData>& userData)
 {
+	PROFILE_DB();
 	try
 	{
-		SQLite::Statement query(m_Database, "SELECT DISTINCT User.userID, User.userName FROM User "
+		CReadConnection connection(*this);
+		CCachedStatement query = READ_STATEMENT(connection, "SELECT DISTINCT User.userID, User.userName FROM User "
 			"INNER JOIN UserSessionHistory "
 			"ON User.userID = UserSessionHistory.userID "
 			"AND UserSessionHistory.ip = ? "
 			"GROUP BY User.userID "
 			"HAVING COUNT(DISTINCT User.userID) = 1");
-		query.bind(1, ip);
-		while (query.executeStep())
+		query->bind(1, ip);
+		while (query->executeStep())
 		{
 			CUserData data;
-			data.userID = query.getColumn(0);
-			data.userName = query.getColumn(1).getString();
+			data.userID = query->getColumn(0);
+			data.userName = query->getColumn(1).getString();
 			userData.push_back(data);
 		}
 	}
 	catch (exception& e)
 	{
-		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::GetUsersAssociatedWithIP: database internal error: %s, %d\n"), e.what(), m_Database.getErrorCode());
+		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::GetUsersAssociatedWithIP: database internal error: %s\n"), e.what());
 		return 0;
 	}
 
@@ -4051,9 +5486,12 @@ int CUserDatabaseSQLite::GetUsersAssociatedWithIP(const string& ip, vector<CUser
 
 int CUserDatabaseSQLite::GetUsersAssociatedWithHWID(const vector<unsigned char>& hwid, vector<CUserData>& userData)
 {
+	PROFILE_DB();
+	lock_guard<recursive_mutex> lock(GetMutex());
+
 	try
 	{
-		SQLite::Statement query(m_Database, "SELECT DISTINCT User.userID, User.userName FROM User "
+		SQLite::Statement query(GetDatabase(), "SELECT DISTINCT User.userID, User.userName FROM User "
 			"INNER JOIN UserSessionHistory "
 			"ON User.userID = UserSessionHistory.userID "
 			"AND UserSessionHistory.hwid = ? "
@@ -4070,7 +5508,7 @@ int CUserDatabaseSQLite::GetUsersAssociatedWithHWID(const vector<unsigned char>&
 	}
 	catch (exception& e)
 	{
-		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::GetUsersAssociatedWithHWID: database internal error: %s, %d\n"), e.what(), m_Database.getErrorCode());
+		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::GetUsersAssociatedWithHWID: database internal error: %s, %d\n"), e.what(), GetDatabase().getErrorCode());
 		return 0;
 	}
 
@@ -4079,94 +5517,76 @@ int CUserDatabaseSQLite::GetUsersAssociatedWithHWID(const vector<unsigned char>&
 
 int CUserDatabaseSQLite::CreateClan(ClanCreateConfig& clanCfg)
 {
+	PROFILE_DB();
+	lock_guard<recursive_mutex> lock(GetMutex());
+
 	int clanID = 0;
 	try
 	{
 		{
-			SQLite::Statement query(m_Database, OBFUSCATE("SELECT EXISTS(SELECT 1 FROM Clan WHERE name = ? LIMIT 1)"));
-			query.bind(1, clanCfg.name);
-			if (query.executeStep())
+			CCachedStatement query = CACHED_STATEMENT("SELECT EXISTS(SELECT 1 FROM Clan WHERE name = ? LIMIT 1)");
+			query->bind(1, clanCfg.name);
+			if (query->executeStep())
 			{
-				if ((int)query.getColumn(0))
+				if ((int)query->getColumn(0))
 					return -1;
 			}
 		}
 
 		{
-			SQLite::Statement query(m_Database, OBFUSCATE("SELECT EXISTS(SELECT 1 FROM ClanMember WHERE userID = ? LIMIT 1)"));
-			query.bind(1, clanCfg.masterUserID);
-			if (query.executeStep())
+			CCachedStatement query = CACHED_STATEMENT("SELECT EXISTS(SELECT 1 FROM ClanMember WHERE userID = ? LIMIT 1)");
+			query->bind(1, clanCfg.masterUserID);
+			if (query->executeStep())
 			{
-				if ((int)query.getColumn(0))
+				if ((int)query->getColumn(0))
 					return -2;
 			}
 		}
 
 		{
-			SQLite::Statement query(m_Database, OBFUSCATE("SELECT EXISTS(SELECT 1 FROM ClanMemberRequest WHERE userID = ? LIMIT 1)"));
-			query.bind(1, clanCfg.masterUserID);
-			if (query.executeStep())
+			CCachedStatement query = CACHED_STATEMENT("SELECT EXISTS(SELECT 1 FROM ClanMemberRequest WHERE userID = ? LIMIT 1)");
+			query->bind(1, clanCfg.masterUserID);
+			if (query->executeStep())
 			{
-				if ((int)query.getColumn(0))
+				if ((int)query->getColumn(0))
 					return -2;
 			}
 		}
 
+		CWriteTransaction transaction(GetDatabase());
 		{
-			SQLite::Statement query(m_Database, OBFUSCATE("SELECT points FROM UserCharacter WHERE userID = ? LIMIT 1"));
-			query.bind(1, clanCfg.masterUserID);
-			if (query.executeStep())
-			{
-				int points = query.getColumn(0);
-				if (points < 30000) // 30k points
-				{
-					return -3;
-				}
-			}
-		}
-
-		SQLite::Transaction transaction(m_Database);
-		{
-			IUser* user = g_UserManager.GetUserById(clanCfg.masterUserID);
-			if (!user->UpdatePoints(-30000))
-			{
-				return 0;
-			}
-		}
-
-		{
-			SQLite::Statement query(m_Database, OBFUSCATE("SELECT clanIDNext FROM UserDist"));
-			query.executeStep();
-			clanID = query.getColumn(0);
+			CCachedStatement query = CACHED_STATEMENT("SELECT clanIDNext FROM UserDist");
+			query->executeStep();
+			clanID = query->getColumn(0);
 		}
 
 		{
-			SQLite::Statement query(m_Database, OBFUSCATE("INSERT INTO Clan VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?)"));
-			query.bind(1, clanID);
-			query.bind(2, clanCfg.masterUserID);
-			query.bind(3, clanCfg.name);
-			query.bind(4, clanCfg.description);
-			query.bind(5, clanCfg.noticeMsg);
-			query.bind(6, clanCfg.gameModeID);
-			query.bind(7, clanCfg.mapID);
-			query.bind(8, clanCfg.time);
-			query.bind(9, 1); // member count
-			query.bind(10, clanCfg.expBoost);
-			query.bind(11, clanCfg.pointBoost);
-			query.bind(12, clanCfg.region);
-			query.bind(13, clanCfg.joinMethod);
-			query.bind(14, clanCfg.points); // score
-			query.bind(15, 0); // markID
-			query.bind(16, 0); // markColor
-			query.bind(17, clanCfg.markChangeCount); // markChangeCount
-			query.bind(18, 450); // max member count
+			CCachedStatement query = CACHED_STATEMENT("INSERT INTO Clan VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?)");
+			query->bind(1, clanID);
+			query->bind(2, clanCfg.masterUserID);
+			query->bind(3, clanCfg.name);
+			query->bind(4, clanCfg.description);
+			query->bind(5, clanCfg.noticeMsg);
+			query->bind(6, clanCfg.gameModeID);
+			query->bind(7, clanCfg.mapID);
+			query->bind(8, clanCfg.time);
+			query->bind(9, 1); // member count
+			query->bind(10, clanCfg.expBoost);
+			query->bind(11, clanCfg.pointBoost);
+			query->bind(12, clanCfg.region);
+			query->bind(13, clanCfg.joinMethod);
+			query->bind(14, clanCfg.points); // score
+			query->bind(15, 0); // markID
+			query->bind(16, 0); // markColor
+			query->bind(17, clanCfg.markChangeCount); // markChangeCount
+			query->bind(18, 450); // max member count
 
-			query.exec();
+			query->exec();
 		}
 
 		{
-			SQLite::Statement query(m_Database, OBFUSCATE("UPDATE UserDist SET clanIDNext = clanIDNext + 1"));
-			query.exec();
+			CCachedStatement query = CACHED_STATEMENT("UPDATE UserDist SET clanIDNext = clanIDNext + 1");
+			query->exec();
 		}
 
 		CUserCharacter character = {};
@@ -4177,11 +5597,11 @@ int CUserDatabaseSQLite::CreateClan(ClanCreateConfig& clanCfg)
 		}
 
 		{
-			SQLite::Statement query(m_Database, OBFUSCATE("INSERT INTO ClanMember VALUES (?, ?, ?)"));
-			query.bind(1, clanID);
-			query.bind(2, clanCfg.masterUserID);
-			query.bind(3, 0);
-			if (!query.exec())
+			CCachedStatement query = CACHED_STATEMENT("INSERT INTO ClanMember VALUES (?, ?, ?)");
+			query->bind(1, clanID);
+			query->bind(2, clanCfg.masterUserID);
+			query->bind(3, 0);
+			if (!query->exec())
 			{
 				return 0;
 			}
@@ -4190,26 +5610,26 @@ int CUserDatabaseSQLite::CreateClan(ClanCreateConfig& clanCfg)
 		{
 			for (int i = 0; i < 5; i++)
 			{
-				SQLite::Statement query(m_Database, OBFUSCATE("INSERT INTO ClanStoragePage VALUES (?, ?, ?)"));
-				query.bind(1, clanID);
-				query.bind(2, i);
-				query.bind(3, 3);
-				if (!query.exec())
+				CCachedStatement query = CACHED_STATEMENT("INSERT INTO ClanStoragePage VALUES (?, ?, ?)");
+				query->bind(1, clanID);
+				query->bind(2, i);
+				query->bind(3, 3);
+				if (!query->exec())
 				{
 					return 0;
 				}
 
 				for (int k = 0; k < 20; k++)
 				{
-					SQLite::Statement query(m_Database, OBFUSCATE("INSERT INTO ClanStorageItem VALUES (?, ?, ?, ?, ?, ?, ?)"));
-					query.bind(1, clanID);
-					query.bind(2, i);
-					query.bind(3, k);
-					query.bind(4, 0);
-					query.bind(5, 0);
-					query.bind(6, 0);
-					query.bind(7, 0);
-					if (!query.exec())
+					CCachedStatement query = CACHED_STATEMENT("INSERT INTO ClanStorageItem VALUES (?, ?, ?, ?, ?, ?, ?)");
+					query->bind(1, clanID);
+					query->bind(2, i);
+					query->bind(3, k);
+					query->bind(4, 0);
+					query->bind(5, 0);
+					query->bind(6, 0);
+					query->bind(7, 0);
+					if (!query->exec())
 					{
 						return 0;
 					}
@@ -4217,21 +5637,21 @@ int CUserDatabaseSQLite::CreateClan(ClanCreateConfig& clanCfg)
 			}
 		}
 		{
-			SQLite::Statement query(m_Database, OBFUSCATE("INSERT INTO ClanChronicle VALUES (?, strftime('%Y%m%d', datetime(?, 'unixepoch')), ?, '')"));
-			query.bind(1, clanID);
-			query.bind(2, g_pServerInstance->GetCurrentTime() * 60); // convert minutes to seconds
-			query.bind(3, 0); // clan create
-			if (!query.exec())
+			CCachedStatement query = CACHED_STATEMENT("INSERT INTO ClanChronicle VALUES (?, strftime('%Y%m%d', datetime(?, 'unixepoch')), ?, '')");
+			query->bind(1, clanID);
+			query->bind(2, g_pServerInstance->GetCurrentTime() * 60); // convert minutes to seconds
+			query->bind(3, 0); // clan create
+			if (!query->exec())
 			{
 				return 0;
 			}
 		}
 
-		transaction.commit();
+		transaction.Commit();
 	}
 	catch (exception& e)
 	{
-		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::CreateClan: database internal error: %s, %d\n"), e.what(), m_Database.getErrorCode());
+		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::CreateClan: database internal error: %s, %d\n"), e.what(), GetDatabase().getErrorCode());
 		return 0;
 	}
 
@@ -4240,15 +5660,18 @@ int CUserDatabaseSQLite::CreateClan(ClanCreateConfig& clanCfg)
 
 int CUserDatabaseSQLite::JoinClan(int userID, int clanID, string& clanName)
 {
+	PROFILE_DB();
+	lock_guard<recursive_mutex> lock(GetMutex());
+
 	try
 	{
 		{
-			SQLite::Statement query(m_Database, OBFUSCATE("SELECT EXISTS(SELECT 1 FROM ClanMember WHERE userID = ? AND clanID = ? LIMIT 1)"));
-			query.bind(1, userID);
-			query.bind(2, clanID);
-			if (query.executeStep())
+			CCachedStatement query = CACHED_STATEMENT("SELECT EXISTS(SELECT 1 FROM ClanMember WHERE userID = ? AND clanID = ? LIMIT 1)");
+			query->bind(1, userID);
+			query->bind(2, clanID);
+			if (query->executeStep())
 			{
-				if ((int)query.getColumn(0))
+				if ((int)query->getColumn(0))
 				{
 					if (0)
 					{
@@ -4265,12 +5688,12 @@ int CUserDatabaseSQLite::JoinClan(int userID, int clanID, string& clanName)
 			}
 		}
 		{
-			SQLite::Statement query(m_Database, OBFUSCATE("SELECT maxMemberCount, memberCount FROM Clan WHERE clanID = ? LIMIT 1"));
-			query.bind(1, clanID);
-			if (query.executeStep())
+			CCachedStatement query = CACHED_STATEMENT("SELECT maxMemberCount, memberCount FROM Clan WHERE clanID = ? LIMIT 1");
+			query->bind(1, clanID);
+			if (query->executeStep())
 			{
-				int maxMemberCount = query.getColumn(0);
-				int memberCount = query.getColumn(1);
+				int maxMemberCount = query->getColumn(0);
+				int memberCount = query->getColumn(1);
 				if (memberCount >= maxMemberCount)
 				{
 					return -6;
@@ -4282,11 +5705,11 @@ int CUserDatabaseSQLite::JoinClan(int userID, int clanID, string& clanName)
 			}
 		}
 		{
-			SQLite::Statement query(m_Database, OBFUSCATE("SELECT joinMethod FROM Clan WHERE clanID = ? LIMIT 1"));
-			query.bind(1, clanID);
-			if (query.executeStep())
+			CCachedStatement query = CACHED_STATEMENT("SELECT joinMethod FROM Clan WHERE clanID = ? LIMIT 1");
+			query->bind(1, clanID);
+			if (query->executeStep())
 			{
-				int joinMethod = query.getColumn(0);
+				int joinMethod = query->getColumn(0);
 				switch (joinMethod)
 				{
 				case 0:
@@ -4299,22 +5722,22 @@ int CUserDatabaseSQLite::JoinClan(int userID, int clanID, string& clanName)
 				case 2:
 				{
 					{
-						SQLite::Statement query(m_Database, OBFUSCATE("SELECT clanID FROM ClanMemberRequest WHERE userID = ? LIMIT 1"));
-						query.bind(1, userID);
-						if (query.executeStep())
+						CCachedStatement query = CACHED_STATEMENT("SELECT clanID FROM ClanMemberRequest WHERE userID = ? LIMIT 1");
+						query->bind(1, userID);
+						if (query->executeStep())
 						{
-							int reqClanID = query.getColumn(0);
+							int reqClanID = query->getColumn(0);
 							if (reqClanID == clanID)
 							{
 								return -2; // already sent join request
 							}
 							else
 							{
-								SQLite::Statement query(m_Database, OBFUSCATE("SELECT name FROM Clan WHERE clanID = ? LIMIT 1"));
-								query.bind(1, reqClanID);
-								if (query.executeStep())
+								CCachedStatement query = CACHED_STATEMENT("SELECT name FROM Clan WHERE clanID = ? LIMIT 1");
+								query->bind(1, reqClanID);
+								if (query->executeStep())
 								{
-									clanName = (const char*)query.getColumn(0);
+									clanName = (const char*)query->getColumn(0);
 								}
 
 								return -7;
@@ -4325,26 +5748,26 @@ int CUserDatabaseSQLite::JoinClan(int userID, int clanID, string& clanName)
 					// add to member request list
 					int inviterUserID = 0;
 					{
-						SQLite::Statement query(m_Database, OBFUSCATE("SELECT userID FROM ClanInvite WHERE destUserID = ? AND clanID = ? LIMIT 1"));
-						query.bind(1, userID);
-						query.bind(2, clanID);
-						if (query.executeStep())
+						CCachedStatement query = CACHED_STATEMENT("SELECT userID FROM ClanInvite WHERE destUserID = ? AND clanID = ? LIMIT 1");
+						query->bind(1, userID);
+						query->bind(2, clanID);
+						if (query->executeStep())
 						{
-							inviterUserID = query.getColumn(0);
+							inviterUserID = query->getColumn(0);
 
-							SQLite::Statement query(m_Database, OBFUSCATE("DELETE FROM ClanInvite WHERE destUserID = ? AND clanID = ?"));
-							query.bind(1, userID);
-							query.bind(2, clanID);
-							query.exec();
+							CCachedStatement query = CACHED_STATEMENT("DELETE FROM ClanInvite WHERE destUserID = ? AND clanID = ?");
+							query->bind(1, userID);
+							query->bind(2, clanID);
+							query->exec();
 						}
 					}
 					{
-						SQLite::Statement query(m_Database, OBFUSCATE("INSERT INTO ClanMemberRequest VALUES (?, ?, ?, strftime('%Y%m%d', datetime(?, 'unixepoch')))"));
-						query.bind(1, clanID);
-						query.bind(2, userID);
-						query.bind(3, inviterUserID);
-						query.bind(4, g_pServerInstance->GetCurrentTime() * 60); // convert minutes to seconds
-						if (!query.exec())
+						CCachedStatement query = CACHED_STATEMENT("INSERT INTO ClanMemberRequest VALUES (?, ?, ?, strftime('%Y%m%d', datetime(?, 'unixepoch')))");
+						query->bind(1, clanID);
+						query->bind(2, userID);
+						query->bind(3, inviterUserID);
+						query->bind(4, g_pServerInstance->GetCurrentTime() * 60); // convert minutes to seconds
+						if (!query->exec())
 						{
 							return 0;
 						}
@@ -4356,19 +5779,19 @@ int CUserDatabaseSQLite::JoinClan(int userID, int clanID, string& clanName)
 			}
 		}
 		{
-			SQLite::Statement query(m_Database, OBFUSCATE("INSERT INTO ClanMember VALUES (?, ?, ?)"));
-			query.bind(1, clanID);
-			query.bind(2, userID);
-			query.bind(3, 3); // Associate Member by default
-			if (!query.exec())
+			CCachedStatement query = CACHED_STATEMENT("INSERT INTO ClanMember VALUES (?, ?, ?)");
+			query->bind(1, clanID);
+			query->bind(2, userID);
+			query->bind(3, 3); // Associate Member by default
+			if (!query->exec())
 			{
 				return 0;
 			}
 		}
 		{
-			SQLite::Statement query(m_Database, OBFUSCATE("UPDATE Clan SET memberCount = memberCount + 1 WHERE clanID = ?"));
-			query.bind(1, clanID);
-			if (!query.exec())
+			CCachedStatement query = CACHED_STATEMENT("UPDATE Clan SET memberCount = memberCount + 1 WHERE clanID = ?");
+			query->bind(1, clanID);
+			if (!query->exec())
 			{
 				return 0;
 			}
@@ -4376,7 +5799,7 @@ int CUserDatabaseSQLite::JoinClan(int userID, int clanID, string& clanName)
 	}
 	catch (exception& e)
 	{
-		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::JoinClan: database internal error: %s, %d\n"), e.what(), m_Database.getErrorCode());
+		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::JoinClan: database internal error: %s, %d\n"), e.what(), GetDatabase().getErrorCode());
 		return 0;
 	}
 
@@ -4385,19 +5808,22 @@ int CUserDatabaseSQLite::JoinClan(int userID, int clanID, string& clanName)
 
 int CUserDatabaseSQLite::CancelJoin(int userID, int clanID)
 {
+	PROFILE_DB();
+	lock_guard<recursive_mutex> lock(GetMutex());
+
 	try
 	{
-		SQLite::Statement query(m_Database, OBFUSCATE("DELETE FROM ClanMemberRequest WHERE userID = ? AND clanID = ?"));
-		query.bind(1, userID);
-		query.bind(2, clanID);
-		if (!query.exec())
+		CCachedStatement query = CACHED_STATEMENT("DELETE FROM ClanMemberRequest WHERE userID = ? AND clanID = ?");
+		query->bind(1, userID);
+		query->bind(2, clanID);
+		if (!query->exec())
 		{
 			return -1; // not in request list
 		}
 	}
 	catch (exception& e)
 	{
-		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::CancelJoin: database internal error: %s, %d\n"), e.what(), m_Database.getErrorCode());
+		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::CancelJoin: database internal error: %s, %d\n"), e.what(), GetDatabase().getErrorCode());
 		return 0;
 	}
 
@@ -4406,34 +5832,37 @@ int CUserDatabaseSQLite::CancelJoin(int userID, int clanID)
 
 int CUserDatabaseSQLite::LeaveClan(int userID)
 {
+	PROFILE_DB();
+	lock_guard<recursive_mutex> lock(GetMutex());
+
 	try
 	{
 		int clanID = 0;
 		{
-			SQLite::Statement query(m_Database, OBFUSCATE("SELECT clanID FROM ClanMember WHERE userID = ? AND memberGrade != 0 LIMIT 1"));
-			query.bind(1, userID);
-			if (!query.executeStep())
+			CCachedStatement query = CACHED_STATEMENT("SELECT clanID FROM ClanMember WHERE userID = ? AND memberGrade != 0 LIMIT 1");
+			query->bind(1, userID);
+			if (!query->executeStep())
 			{
 				return -1; // user not in clan or has no permission to leave
 			}
 			else
 			{
-				clanID = query.getColumn(0);
+				clanID = query->getColumn(0);
 			}
 		}
 		{
-			SQLite::Statement query(m_Database, OBFUSCATE("DELETE FROM ClanMember WHERE clanID = ? AND userID = ?"));
-			query.bind(1, clanID);
-			query.bind(2, userID);
-			if (!query.exec())
+			CCachedStatement query = CACHED_STATEMENT("DELETE FROM ClanMember WHERE clanID = ? AND userID = ?");
+			query->bind(1, clanID);
+			query->bind(2, userID);
+			if (!query->exec())
 			{
 				return 0;
 			}
 		}
 		{
-			SQLite::Statement query(m_Database, OBFUSCATE("UPDATE Clan SET memberCount = memberCount - 1 WHERE clanID = ?"));
-			query.bind(1, clanID);
-			if (!query.exec())
+			CCachedStatement query = CACHED_STATEMENT("UPDATE Clan SET memberCount = memberCount - 1 WHERE clanID = ?");
+			query->bind(1, clanID);
+			if (!query->exec())
 			{
 				return 0;
 			}
@@ -4441,7 +5870,7 @@ int CUserDatabaseSQLite::LeaveClan(int userID)
 	}
 	catch (exception& e)
 	{
-		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::LeaveClan: database internal error: %s, %d\n"), e.what(), m_Database.getErrorCode());
+		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::LeaveClan: database internal error: %s, %d\n"), e.what(), GetDatabase().getErrorCode());
 		return 0;
 	}
 
@@ -4450,26 +5879,29 @@ int CUserDatabaseSQLite::LeaveClan(int userID)
 
 int CUserDatabaseSQLite::DissolveClan(int userID)
 {
+	PROFILE_DB();
+	lock_guard<recursive_mutex> lock(GetMutex());
+
 	try
 	{
 		int clanID = 0;
 		{
-			SQLite::Statement query(m_Database, OBFUSCATE("SELECT clanID FROM ClanMember WHERE userID = ? AND memberGrade <= 1 LIMIT 1"));
-			query.bind(1, userID);
-			if (!query.executeStep())
+			CCachedStatement query = CACHED_STATEMENT("SELECT clanID FROM ClanMember WHERE userID = ? AND memberGrade <= 1 LIMIT 1");
+			query->bind(1, userID);
+			if (!query->executeStep())
 			{
 				return -1; // user not in clan or not admin
 			}
 			else
 			{
-				clanID = query.getColumn(0);
+				clanID = query->getColumn(0);
 			}
 		}
 
 		{
-			SQLite::Statement query(m_Database, OBFUSCATE("DELETE FROM Clan WHERE clanID = ?"));
-			query.bind(1, clanID);
-			if (!query.exec())
+			CCachedStatement query = CACHED_STATEMENT("DELETE FROM Clan WHERE clanID = ?");
+			query->bind(1, clanID);
+			if (!query->exec())
 			{
 				return 0;
 			}
@@ -4477,67 +5909,65 @@ int CUserDatabaseSQLite::DissolveClan(int userID)
 	}
 	catch (exception& e)
 	{
-		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::DissolveClan: database internal error: %s, %d\n"), e.what(), m_Database.getErrorCode());
+		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::DissolveClan: database internal error: %s, %d\n"), e.what(), GetDatabase().getErrorCode());
 		return 0;
 	}
 
 	return 1;
 }
 
+// uses read-only connection, can be called by any thread
 int CUserDatabaseSQLite::GetClanList(vector<ClanList_s>& clans, string clanName, int flag, int gameModeID, int playTime, int pageID, int &pageMax)
 {
+	PROFILE_DB();
 	try
 	{
-		static SQLite::Statement query(m_Database, OBFUSCATE("SELECT Clan.clanID, gameName, name, notice, gameModeID, time, region, memberCount, joinMethod, score, markID FROM Clan, UserCharacter WHERE userID = Clan.masterUserID AND CASE WHEN ? == 0 THEN name LIKE ('%' || ? || '%') WHEN ? == 1 THEN gameModeID = ? WHEN ? == 2 THEN time = ? WHEN ? == 3 THEN gameModeID = ? AND time = ? END ORDER BY score DESC LIMIT 15 OFFSET ? * 15"));
-		if (query.getErrorCode())
-			query.reset();
+		CReadConnection connection(*this);
+		CCachedStatement query = READ_STATEMENT(connection, "SELECT Clan.clanID, gameName, name, notice, gameModeID, time, region, memberCount, joinMethod, score, markID FROM Clan, UserCharacter WHERE userID = Clan.masterUserID AND CASE WHEN ? == 0 THEN name LIKE ('%' || ? || '%') WHEN ? == 1 THEN gameModeID = ? WHEN ? == 2 THEN time = ? WHEN ? == 3 THEN gameModeID = ? AND time = ? END ORDER BY score DESC LIMIT 15 OFFSET ? * 15");
 
-		query.bind(1, flag);
-		query.bind(2, clanName);
-		query.bind(3, flag);
-		query.bind(4, gameModeID);
-		query.bind(5, flag);
-		query.bind(6, playTime);
-		query.bind(7, flag);
-		query.bind(8, gameModeID);
-		query.bind(9, playTime);
-		query.bind(10, pageID);
-		while (query.executeStep())
+		query->bind(1, flag);
+		query->bind(2, clanName);
+		query->bind(3, flag);
+		query->bind(4, gameModeID);
+		query->bind(5, flag);
+		query->bind(6, playTime);
+		query->bind(7, flag);
+		query->bind(8, gameModeID);
+		query->bind(9, playTime);
+		query->bind(10, pageID);
+		while (query->executeStep())
 		{
 			ClanList_s clanList = {};
-			clanList.id = query.getColumn(0);
-			clanList.clanMaster = (const char*)query.getColumn(1);
-			clanList.name = (const char*)query.getColumn(2);
-			clanList.noticeMsg = (const char*)query.getColumn(3);
-			clanList.gameModeID = query.getColumn(4);
-			clanList.time = query.getColumn(5);
-			clanList.region = query.getColumn(6);
-			clanList.memberCount = query.getColumn(7);
-			clanList.joinMethod = query.getColumn(8);
-			clanList.score = query.getColumn(9);
-			clanList.markID = query.getColumn(10);
+			clanList.id = query->getColumn(0);
+			clanList.clanMaster = (const char*)query->getColumn(1);
+			clanList.name = (const char*)query->getColumn(2);
+			clanList.noticeMsg = (const char*)query->getColumn(3);
+			clanList.gameModeID = query->getColumn(4);
+			clanList.time = query->getColumn(5);
+			clanList.region = query->getColumn(6);
+			clanList.memberCount = query->getColumn(7);
+			clanList.joinMethod = query->getColumn(8);
+			clanList.score = query->getColumn(9);
+			clanList.markID = query->getColumn(10);
 
 			clans.push_back(clanList);
 		}
 
-		query.reset();
+		query->reset();
 
 		{
-			static SQLite::Statement query(m_Database, OBFUSCATE("SELECT COUNT(1) / 15 + 1 FROM Clan"));
-			if (query.getErrorCode())
-				query.reset();
-
-			if (query.executeStep())
+			CCachedStatement query = READ_STATEMENT(connection, "SELECT COUNT(1) / 15 + 1 FROM Clan");
+			if (query->executeStep())
 			{
-				pageMax = query.getColumn(0);
+				pageMax = query->getColumn(0);
 			}
 
-			query.reset();
+			query->reset();
 		}
 	}
 	catch (exception& e)
 	{
-		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::GetClanList: database internal error: %s, %d\n"), e.what(), m_Database.getErrorCode());
+		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::GetClanList: database internal error: %s\n"), e.what());
 		return 0;
 	}
 
@@ -4546,47 +5976,50 @@ int CUserDatabaseSQLite::GetClanList(vector<ClanList_s>& clans, string clanName,
 
 int CUserDatabaseSQLite::GetClanInfo(int clanID, Clan_s& clan)
 {
+	PROFILE_DB();
+	lock_guard<recursive_mutex> lock(GetMutex());
+
 	try
 	{
-		SQLite::Statement query(m_Database, OBFUSCATE("SELECT Clan.clanID, gameName, name, notice, gameModeID, mapID, time, memberCount, expBonus, pointBonus, markID, maxMemberCount FROM Clan, UserCharacter WHERE userID = Clan.masterUserID AND Clan.clanID = ? LIMIT 1"));
-		query.bind(1, clanID);
-		if (query.executeStep())
+		CCachedStatement query = CACHED_STATEMENT("SELECT Clan.clanID, gameName, name, notice, gameModeID, mapID, time, memberCount, expBonus, pointBonus, markID, maxMemberCount FROM Clan, UserCharacter WHERE userID = Clan.masterUserID AND Clan.clanID = ? LIMIT 1");
+		query->bind(1, clanID);
+		if (query->executeStep())
 		{
-			clan.id = query.getColumn(0);
-			clan.clanMaster = (const char*)query.getColumn(1);
-			clan.name = (const char*)query.getColumn(2);
-			clan.noticeMsg = (const char*)query.getColumn(3);
-			clan.gameModeID = query.getColumn(4);
-			clan.mapID = query.getColumn(5);
-			clan.time = query.getColumn(6);
-			clan.memberCount = query.getColumn(7);
-			clan.expBoost = query.getColumn(8);
-			clan.pointBoost = query.getColumn(9);
-			clan.markID = query.getColumn(10);
-			clan.maxMemberCount = query.getColumn(11);
+			clan.id = query->getColumn(0);
+			clan.clanMaster = (const char*)query->getColumn(1);
+			clan.name = (const char*)query->getColumn(2);
+			clan.noticeMsg = (const char*)query->getColumn(3);
+			clan.gameModeID = query->getColumn(4);
+			clan.mapID = query->getColumn(5);
+			clan.time = query->getColumn(6);
+			clan.memberCount = query->getColumn(7);
+			clan.expBoost = query->getColumn(8);
+			clan.pointBoost = query->getColumn(9);
+			clan.markID = query->getColumn(10);
+			clan.maxMemberCount = query->getColumn(11);
 		}
 		{
-			SQLite::Statement query(m_Database, OBFUSCATE("SELECT itemID, itemCount, itemDuration FROM ClanStorageItem WHERE clanID = ? AND itemID != 0 LIMIT 10"));
-			query.bind(1, clanID);
-			while (query.executeStep())
+			CCachedStatement query = CACHED_STATEMENT("SELECT itemID, itemCount, itemDuration FROM ClanStorageItem WHERE clanID = ? AND itemID != 0 LIMIT 10");
+			query->bind(1, clanID);
+			while (query->executeStep())
 			{
 				RewardItem item;
-				item.itemID = query.getColumn(0);
-				item.count = query.getColumn(1);
-				item.duration = query.getColumn(2);
+				item.itemID = query->getColumn(0);
+				item.count = query->getColumn(1);
+				item.duration = query->getColumn(2);
 
 				clan.lastStorageItems.push_back(item);
 			}
 		}
 		{
-			SQLite::Statement query(m_Database, OBFUSCATE("SELECT date, type, string FROM ClanChronicle WHERE clanID = ?"));
-			query.bind(1, clanID);
-			while (query.executeStep())
+			CCachedStatement query = CACHED_STATEMENT("SELECT date, type, string FROM ClanChronicle WHERE clanID = ?");
+			query->bind(1, clanID);
+			while (query->executeStep())
 			{
 				ClanChronicle chr;
-				chr.date = query.getColumn(0);
-				chr.type = query.getColumn(1);
-				chr.str = (const char*)query.getColumn(2);
+				chr.date = query->getColumn(0);
+				chr.type = query->getColumn(1);
+				chr.str = (const char*)query->getColumn(2);
 
 				clan.chronicle.push_back(chr);
 			}
@@ -4594,7 +6027,7 @@ int CUserDatabaseSQLite::GetClanInfo(int clanID, Clan_s& clan)
 	}
 	catch (exception& e)
 	{
-		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::GetClanInfo: database internal error: %s, %d\n"), e.what(), m_Database.getErrorCode());
+		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::GetClanInfo: database internal error: %s, %d\n"), e.what(), GetDatabase().getErrorCode());
 		return 0;
 	}
 
@@ -4603,38 +6036,41 @@ int CUserDatabaseSQLite::GetClanInfo(int clanID, Clan_s& clan)
 
 int CUserDatabaseSQLite::AddClanStorageItem(int userID, int pageID, CUserInventoryItem& item)
 {
+	PROFILE_DB();
+	lock_guard<recursive_mutex> lock(GetMutex());
+
 	try
 	{
-		SQLite::Transaction transaction(m_Database);
+		CWriteTransaction transaction(GetDatabase());
 
 		int clanID = 0;
 		{
-			SQLite::Statement query(m_Database, OBFUSCATE("SELECT clanID FROM ClanMember WHERE userID = ? AND memberGrade <= (SELECT accessGrade FROM ClanStoragePage WHERE clanID = ClanMember.clanID AND pageID = ? LIMIT 1) LIMIT 1"));
-			query.bind(1, userID);
-			query.bind(2, pageID);
-			if (!query.executeStep())
+			CCachedStatement query = CACHED_STATEMENT("SELECT clanID FROM ClanMember WHERE userID = ? AND memberGrade <= (SELECT accessGrade FROM ClanStoragePage WHERE clanID = ClanMember.clanID AND pageID = ? LIMIT 1) LIMIT 1");
+			query->bind(1, userID);
+			query->bind(2, pageID);
+			if (!query->executeStep())
 			{
 				// user not in clan or access grade is lower than user's member grade
 				return -1;
 			}
 			else
 			{
-				clanID = query.getColumn(0);
+				clanID = query->getColumn(0);
 			}
 		}
 
 		int slot = 0;
 		{
-			SQLite::Statement query(m_Database, OBFUSCATE("SELECT slot FROM ClanStorageItem WHERE clanID = ? AND pageID = ? AND itemID = 0 LIMIT 1"));
-			query.bind(1, clanID);
-			query.bind(2, pageID);
-			if (!query.executeStep())
+			CCachedStatement query = CACHED_STATEMENT("SELECT slot FROM ClanStorageItem WHERE clanID = ? AND pageID = ? AND itemID = 0 LIMIT 1");
+			query->bind(1, clanID);
+			query->bind(2, pageID);
+			if (!query->executeStep())
 			{
 				return -3;
 			}
 			else
 			{
-				slot = query.getColumn(0);
+				slot = query->getColumn(0);
 			}
 		}
 
@@ -4649,16 +6085,17 @@ int CUserDatabaseSQLite::AddClanStorageItem(int userID, int pageID, CUserInvento
 			return -2;
 		}
 
+		int itemDuration = item.m_nExpiryDate * CSO_24_HOURS_IN_MINUTES + g_pServerInstance->GetCurrentTime();
 		{
-			SQLite::Statement query(m_Database, OBFUSCATE("UPDATE ClanStorageItem SET itemID = ?, itemCount = ?, itemDuration = ?, itemEnhValue = ? WHERE clanID = ? AND pageID = ? AND slot = ?"));
-			query.bind(1, item.m_nItemID);
-			query.bind(2, item.m_nCount);
-			query.bind(3, item.m_nExpiryDate * CSO_24_HOURS_IN_MINUTES + g_pServerInstance->GetCurrentTime());
-			query.bind(4, item.m_nEnhanceValue);
-			query.bind(5, clanID);
-			query.bind(6, pageID);
-			query.bind(7, slot);
-			if (!query.exec())
+			CCachedStatement query = CACHED_STATEMENT("UPDATE ClanStorageItem SET itemID = ?, itemCount = ?, itemDuration = ?, itemEnhValue = ? WHERE clanID = ? AND pageID = ? AND slot = ?");
+			query->bind(1, item.m_nItemID);
+			query->bind(2, item.m_nCount);
+			query->bind(3, itemDuration);
+			query->bind(4, item.m_nEnhanceValue);
+			query->bind(5, clanID);
+			query->bind(6, pageID);
+			query->bind(7, slot);
+			if (!query->exec())
 			{
 				return 0;
 			}
@@ -4670,11 +6107,13 @@ int CUserDatabaseSQLite::AddClanStorageItem(int userID, int pageID, CUserInvento
 			return -2;
 		}
 
-		transaction.commit();
+		transaction.Commit();
+
+		m_ExpiryTimers.Schedule(itemDuration, ExpiryTimer_s{ EXPIRY_TIMER_CLAN_STORAGE, clanID, pageID, slot });
 	}
 	catch (exception& e)
 	{
-		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::AddClanStorageItem: database internal error: %s, %d\n"), e.what(), m_Database.getErrorCode());
+		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::AddClanStorageItem: database internal error: %s, %d\n"), e.what(), GetDatabase().getErrorCode());
 		return 0;
 	}
 
@@ -4683,30 +6122,33 @@ int CUserDatabaseSQLite::AddClanStorageItem(int userID, int pageID, CUserInvento
 
 int CUserDatabaseSQLite::DeleteClanStorageItem(int userID, int pageID, int slot)
 {
+	PROFILE_DB();
+	lock_guard<recursive_mutex> lock(GetMutex());
+
 	try
 	{
 		int clanID = 0;
 		{
-			SQLite::Statement query(m_Database, OBFUSCATE("SELECT clanID FROM ClanMember WHERE userID = ? AND memberGrade <= (SELECT accessGrade FROM ClanStoragePage WHERE clanID = ClanMember.clanID AND pageID = ? LIMIT 1) LIMIT 1"));
-			query.bind(1, userID);
-			query.bind(2, pageID);
-			if (!query.executeStep())
+			CCachedStatement query = CACHED_STATEMENT("SELECT clanID FROM ClanMember WHERE userID = ? AND memberGrade <= (SELECT accessGrade FROM ClanStoragePage WHERE clanID = ClanMember.clanID AND pageID = ? LIMIT 1) LIMIT 1");
+			query->bind(1, userID);
+			query->bind(2, pageID);
+			if (!query->executeStep())
 			{
 				// user not in clan or access grade is lower than user's member grade
 				return -1;
 			}
 			else
 			{
-				clanID = query.getColumn(0);
+				clanID = query->getColumn(0);
 			}
 		}
 
 		{
-			SQLite::Statement query(m_Database, OBFUSCATE("UPDATE ClanStorageItem SET itemID = 0, itemCount = 0, itemDuration = 0 WHERE clanID = ? AND pageID = ? AND slot = ?"));
-			query.bind(1, clanID);
-			query.bind(2, pageID);
-			query.bind(3, slot);
-			if (!query.exec())
+			CCachedStatement query = CACHED_STATEMENT("UPDATE ClanStorageItem SET itemID = 0, itemCount = 0, itemDuration = 0 WHERE clanID = ? AND pageID = ? AND slot = ?");
+			query->bind(1, clanID);
+			query->bind(2, pageID);
+			query->bind(3, slot);
+			if (!query->exec())
 			{
 				return -1;
 			}
@@ -4714,7 +6156,7 @@ int CUserDatabaseSQLite::DeleteClanStorageItem(int userID, int pageID, int slot)
 	}
 	catch (exception& e)
 	{
-		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::DeleteClanStorageItem: database internal error: %s, %d\n"), e.what(), m_Database.getErrorCode());
+		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::DeleteClanStorageItem: database internal error: %s, %d\n"), e.what(), GetDatabase().getErrorCode());
 		return 0;
 	}
 
@@ -4723,25 +6165,28 @@ int CUserDatabaseSQLite::DeleteClanStorageItem(int userID, int pageID, int slot)
 
 int CUserDatabaseSQLite::GetClanStorageItem(int userID, int pageID, int slot, CUserInventoryItem& item)
 {
+	PROFILE_DB();
+	lock_guard<recursive_mutex> lock(GetMutex());
+
 	// TODO: check for item limit
 	try
 	{
 		//int clanID = 0;
 		{
 			// SELECT itemID, itemCount, itemDuration FROM ClanStorageItem INNER JOIN Clan ON ClanStorageItem.clanID = Clan.clanID INNER JOIN ClanStoragePage ON Clan.clanID = ClanStoragePage.clanID AND ClanStoragePage.pageID = ClanStorageItem.pageID INNER JOIN ClanMember ON ClanMember.userID = ? WHERE ClanMember.memberGrade <= ClanStoragePage.accessGrade AND ClanStorageItem.pageID = ? AND ClanStorageItem.slot = ?
-			SQLite::Statement query(m_Database, OBFUSCATE("SELECT itemID, itemCount FROM ClanStorageItem INNER JOIN ClanStoragePage ON ClanStorageItem.clanID = ClanStoragePage.clanID AND ClanStoragePage.pageID = ClanStorageItem.pageID INNER JOIN ClanMember ON ClanMember.userID = ? WHERE ClanMember.memberGrade <= ClanStoragePage.accessGrade AND ClanStorageItem.clanID = ClanMember.clanID AND ClanStorageItem.pageID = ? AND ClanStorageItem.slot = ? AND ClanStorageItem.itemID != 0 LIMIT 1"));
-			query.bind(1, userID);
-			query.bind(2, pageID);
-			query.bind(3, slot);
-			if (!query.executeStep())
+			CCachedStatement query = CACHED_STATEMENT("SELECT itemID, itemCount FROM ClanStorageItem INNER JOIN ClanStoragePage ON ClanStorageItem.clanID = ClanStoragePage.clanID AND ClanStoragePage.pageID = ClanStorageItem.pageID INNER JOIN ClanMember ON ClanMember.userID = ? WHERE ClanMember.memberGrade <= ClanStoragePage.accessGrade AND ClanStorageItem.clanID = ClanMember.clanID AND ClanStorageItem.pageID = ? AND ClanStorageItem.slot = ? AND ClanStorageItem.itemID != 0 LIMIT 1");
+			query->bind(1, userID);
+			query->bind(2, pageID);
+			query->bind(3, slot);
+			if (!query->executeStep())
 			{
 				// user not in clan or access grade is lower than user's member grade or there is no item slot
 				return -1;
 			}
 			else
 			{
-				item.m_nItemID = query.getColumn(0);
-				item.m_nCount = query.getColumn(1);
+				item.m_nItemID = query->getColumn(0);
+				item.m_nCount = query->getColumn(1);
 				item.m_nExpiryDate = 1;
 				item.ConvertDurationToExpiryDate();
 				item.m_nIsClanItem = true;
@@ -4769,7 +6214,7 @@ int CUserDatabaseSQLite::GetClanStorageItem(int userID, int pageID, int slot, CU
 	}
 	catch (exception& e)
 	{
-		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::GetClanStorageItem: database internal error: %s, %d\n"), e.what(), m_Database.getErrorCode());
+		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::GetClanStorageItem: database internal error: %s, %d\n"), e.what(), GetDatabase().getErrorCode());
 		return 0;
 	}
 
@@ -4778,32 +6223,38 @@ int CUserDatabaseSQLite::GetClanStorageItem(int userID, int pageID, int slot, CU
 
 int CUserDatabaseSQLite::GetClanStorageLastItems(int userID, std::vector<RewardItem>& items)
 {
+	PROFILE_DB();
+	lock_guard<recursive_mutex> lock(GetMutex());
+
 	Logger().Warn("CUserDatabaseSQLite::GetClanStorageLastItems: not implemented\n");
 	return 0;
 }
 
 int CUserDatabaseSQLite::GetClanStoragePage(int userID, ClanStoragePage& clanStoragePage)
 {
+	PROFILE_DB();
+	lock_guard<recursive_mutex> lock(GetMutex());
+
 	try
 	{
-		SQLite::Statement statement(m_Database, OBFUSCATE("SELECT slot, itemID, itemCount, itemDuration, itemEnhValue FROM ClanStorageItem WHERE clanID = (SELECT clanID FROM ClanMember WHERE userID = ? LIMIT 1) AND pageID = ? AND itemID != 0"));
-		statement.bind(1, userID);
-		statement.bind(2, clanStoragePage.pageID);
-		while (statement.executeStep())
+		CCachedStatement statement = CACHED_STATEMENT("SELECT slot, itemID, itemCount, itemDuration, itemEnhValue FROM ClanStorageItem WHERE clanID = (SELECT clanID FROM ClanMember WHERE userID = ? LIMIT 1) AND pageID = ? AND itemID != 0");
+		statement->bind(1, userID);
+		statement->bind(2, clanStoragePage.pageID);
+		while (statement->executeStep())
 		{
 			RewardItem item;
-			item.selectID = statement.getColumn(0);
-			item.itemID = statement.getColumn(1);
-			item.count = statement.getColumn(2);
-			item.duration = statement.getColumn(3);
-			item.enhValue = statement.getColumn(4);
+			item.selectID = statement->getColumn(0);
+			item.itemID = statement->getColumn(1);
+			item.count = statement->getColumn(2);
+			item.duration = statement->getColumn(3);
+			item.enhValue = statement->getColumn(4);
 
 			clanStoragePage.items.push_back(item);
 		}
 	}
 	catch (exception& e)
 	{
-		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::GetClanStoragePage: database internal error: %s, %d\n"), e.what(), m_Database.getErrorCode());
+		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::GetClanStoragePage: database internal error: %s, %d\n"), e.what(), GetDatabase().getErrorCode());
 		return 0;
 	}
 
@@ -4812,23 +6263,29 @@ int CUserDatabaseSQLite::GetClanStoragePage(int userID, ClanStoragePage& clanSto
 
 int CUserDatabaseSQLite::GetClanStorageHistory(int userID, ClanStorageHistory& clanStorageHistory)
 {
+	PROFILE_DB();
+	lock_guard<recursive_mutex> lock(GetMutex());
+
 	return false;
 }
 
 int CUserDatabaseSQLite::GetClanStorageAccessGrade(int userID, vector<int>& accessGrade)
 {
+	PROFILE_DB();
+	lock_guard<recursive_mutex> lock(GetMutex());
+
 	try
 	{
-		SQLite::Statement query(m_Database, OBFUSCATE("SELECT accessGrade FROM ClanStoragePage WHERE clanID = (SELECT clanID FROM ClanMember WHERE userID = ? LIMIT 1)"));
-		query.bind(1, userID);
-		while (query.executeStep())
+		CCachedStatement query = CACHED_STATEMENT("SELECT accessGrade FROM ClanStoragePage WHERE clanID = (SELECT clanID FROM ClanMember WHERE userID = ? LIMIT 1)");
+		query->bind(1, userID);
+		while (query->executeStep())
 		{
-			accessGrade.push_back(query.getColumn(0));
+			accessGrade.push_back(query->getColumn(0));
 		}
 	}
 	catch (exception& e)
 	{
-		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::GetClanStorageAccessGrade: database internal error: %s, %d\n"), e.what(), m_Database.getErrorCode());
+		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::GetClanStorageAccessGrade: database internal error: %s, %d\n"), e.what(), GetDatabase().getErrorCode());
 		return 0;
 	}
 
@@ -4837,21 +6294,24 @@ int CUserDatabaseSQLite::GetClanStorageAccessGrade(int userID, vector<int>& acce
 
 int CUserDatabaseSQLite::UpdateClanStorageAccessGrade(int userID, int pageID, int accessGrade)
 {
+	PROFILE_DB();
+	lock_guard<recursive_mutex> lock(GetMutex());
+
 	try
 	{
-		SQLite::Statement statement(m_Database, OBFUSCATE("UPDATE ClanStoragePage SET accessGrade = ? WHERE clanID = (SELECT clanID FROM ClanMember WHERE userID = ? LIMIT 1) AND pageID = ? AND (SELECT memberGrade FROM ClanMember WHERE userID = ? LIMIT 1) <= 1"));
-		statement.bind(1, accessGrade);
-		statement.bind(2, userID);
-		statement.bind(3, pageID);
-		statement.bind(4, userID);
-		if (!statement.exec())
+		CCachedStatement statement = CACHED_STATEMENT("UPDATE ClanStoragePage SET accessGrade = ? WHERE clanID = (SELECT clanID FROM ClanMember WHERE userID = ? LIMIT 1) AND pageID = ? AND (SELECT memberGrade FROM ClanMember WHERE userID = ? LIMIT 1) <= 1");
+		statement->bind(1, accessGrade);
+		statement->bind(2, userID);
+		statement->bind(3, pageID);
+		statement->bind(4, userID);
+		if (!statement->exec())
 		{
 			return 0;
 		}
 	}
 	catch (exception& e)
 	{
-		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::UpdateClanStorageAccessGrade: database internal error: %s, %d\n"), e.what(), m_Database.getErrorCode());
+		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::UpdateClanStorageAccessGrade: database internal error: %s, %d\n"), e.what(), GetDatabase().getErrorCode());
 		return 0;
 	}
 
@@ -4860,6 +6320,9 @@ int CUserDatabaseSQLite::UpdateClanStorageAccessGrade(int userID, int pageID, in
 
 int CUserDatabaseSQLite::GetClanUserList(int id, bool byUser, vector<ClanUser>& users)
 {
+	PROFILE_DB();
+	lock_guard<recursive_mutex> lock(GetMutex());
+
 	try
 	{
 		// get clan user list by clanID or by userID
@@ -4873,23 +6336,22 @@ int CUserDatabaseSQLite::GetClanUserList(int id, bool byUser, vector<ClanUser>&
 			strQuery = OBFUSCATE("SELECT ClanMember.userID, gameName, userName, memberGrade FROM ClanMember INNER JOIN UserCharacter ON UserCharacter.userID = ClanMember.userID AND ClanMember.clanID = (SELECT clanID FROM UserCharacter WHERE userID = ? LIMIT 1) INNER JOIN User ON UserCharacter.userID = User.userID");
 		}
 
-		SQLite::Statement query(m_Database, strQuery);
-		query.bind(1, id);
-		while (query.executeStep())
+		CCachedStatement query = GetStatement(strQuery);
+		query->bind(1, id);
+		while (query->executeStep())
 		{
 			ClanUser clanUser = {};
-			clanUser.userID = query.getColumn(0);
-			clanUser.character.gameName = (const char*)query.getColumn(1);
-			clanUser.userName = (const char*)query.getColumn(2);
-			clanUser.user = g_UserManager.GetUserById(clanUser.userID);
-			clanUser.memberGrade = query.getColumn(3);
+			clanUser.userID = query->getColumn(0);
+			clanUser.character.gameName = (const char*)query->getColumn(1);
+			clanUser.userName = (const char*)query->getColumn(2);
+			clanUser.memberGrade = query->getColumn(3);
 
 			users.push_back(clanUser);
 		}
 	}
 	catch (exception& e)
 	{
-		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::GetClanUserList: database internal error: %s, %d\n"), e.what(), m_Database.getErrorCode());
+		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::GetClanUserList: database internal error: %s, %d\n"), e.what(), GetDatabase().getErrorCode());
 		return 0;
 	}
 
@@ -4898,28 +6360,30 @@ int CUserDatabaseSQLite::GetClanUserList(int id, bool byUser, vector<ClanUser>&
 
 int CUserDatabaseSQLite::GetClanMemberList(int userID, vector<ClanUser>& users)
 {
+	PROFILE_DB();
+	lock_guard<recursive_mutex> lock(GetMutex());
+
 	try
 	{
-		SQLite::Statement query(m_Database, OBFUSCATE("SELECT ClanMember.userID, memberGrade, gameName, userName, level, kills, deaths FROM ClanMember INNER JOIN UserCharacter ON ClanMember.userID = UserCharacter.userID INNER JOIN User ON UserCharacter.userID = User.userID WHERE (SELECT clanID FROM ClanMember WHERE userID = ? AND memberGrade <= 1 LIMIT 1) = ClanMember.clanID"));
-		query.bind(1, userID);
-		while (query.executeStep())
+		CCachedStatement query = CACHED_STATEMENT("SELECT ClanMember.userID, memberGrade, gameName, userName, level, kills, deaths FROM ClanMember INNER JOIN UserCharacter ON ClanMember.userID = UserCharacter.userID INNER JOIN User ON UserCharacter.userID = User.userID WHERE (SELECT clanID FROM ClanMember WHERE userID = ? AND memberGrade <= 1 LIMIT 1) = ClanMember.clanID");
+		query->bind(1, userID);
+		while (query->executeStep())
 		{
 			ClanUser clanUser = {};
-			clanUser.userID = query.getColumn(0);
-			clanUser.memberGrade = query.getColumn(1);
-			clanUser.character.gameName = (const char*)query.getColumn(2);
-			clanUser.userName = (const char*)query.getColumn(3);
-			clanUser.character.level = query.getColumn(4);
-			clanUser.character.kills = query.getColumn(5);
-			clanUser.character.deaths = query.getColumn(6);
-			clanUser.user = g_UserManager.GetUserById(clanUser.userID);
+			clanUser.userID = query->getColumn(0);
+			clanUser.memberGrade = query->getColumn(1);
+			clanUser.character.gameName = (const char*)query->getColumn(2);
+			clanUser.userName = (const char*)query->getColumn(3);
+			clanUser.character.level = query->getColumn(4);
+			clanUser.character.kills = query->getColumn(5);
+			clanUser.character.deaths = query->getColumn(6);
 
 			users.push_back(clanUser);
 		}
 	}
 	catch (exception& e)
 	{
-		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::GetClanMemberList: database internal error: %s, %d\n"), e.what(), m_Database.getErrorCode());
+		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::GetClanMemberList: database internal error: %s, %d\n"), e.what(), GetDatabase().getErrorCode());
 		return 0;
 	}
 
@@ -4928,28 +6392,31 @@ int CUserDatabaseSQLite::GetClanMemberList(int userID, vector<ClanUser>& users)
 
 int CUserDatabaseSQLite::GetClanMemberJoinUserList(int userID, vector<ClanUserJoinRequest>& users)
 {
+	PROFILE_DB();
+	lock_guard<recursive_mutex> lock(GetMutex());
+
 	try
 	{
-		SQLite::Statement statement(m_Database, OBFUSCATE("SELECT ClanMemberRequest.userID, userName, gameName, level, kills, deaths, (SELECT gameName FROM UserCharacter WHERE userID = inviterUserID LIMIT 1), date FROM ClanMemberRequest INNER JOIN UserCharacter ON ClanMemberRequest.userID = UserCharacter.userID INNER JOIN ClanMember ON ClanMember.userID = ? AND ClanMember.memberGrade <= 1 AND ClanMember.clanID = ClanMemberRequest.clanID INNER JOIN User ON User.userID = ClanMemberRequest.userID"));
-		statement.bind(1, userID);
-		while (statement.executeStep())
+		CCachedStatement statement = CACHED_STATEMENT("SELECT ClanMemberRequest.userID, userName, gameName, level, kills, deaths, (SELECT gameName FROM UserCharacter WHERE userID = inviterUserID LIMIT 1), date FROM ClanMemberRequest INNER JOIN UserCharacter ON ClanMemberRequest.userID = UserCharacter.userID INNER JOIN ClanMember ON ClanMember.userID = ? AND ClanMember.memberGrade <= 1 AND ClanMember.clanID = ClanMemberRequest.clanID INNER JOIN User ON User.userID = ClanMemberRequest.userID");
+		statement->bind(1, userID);
+		while (statement->executeStep())
 		{
 			ClanUserJoinRequest clanUser;
-			clanUser.userID = statement.getColumn(0);
-			clanUser.userName = (const char*)statement.getColumn(1);
-			clanUser.character.gameName = (const char*)statement.getColumn(2);
-			clanUser.character.level = statement.getColumn(3);
-			clanUser.character.kills = statement.getColumn(4);
-			clanUser.character.deaths = statement.getColumn(5);
-			clanUser.inviterGameName = (const char*)statement.getColumn(6);
-			clanUser.date = statement.getColumn(7);
+			clanUser.userID = statement->getColumn(0);
+			clanUser.userName = (const char*)statement->getColumn(1);
+			clanUser.character.gameName = (const char*)statement->getColumn(2);
+			clanUser.character.level = statement->getColumn(3);
+			clanUser.character.kills = statement->getColumn(4);
+			clanUser.character.deaths = statement->getColumn(5);
+			clanUser.inviterGameName = (const char*)statement->getColumn(6);
+			clanUser.date = statement->getColumn(7);
 
 			users.push_back(clanUser);
 		}
 	}
 	catch (exception& e)
 	{
-		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::GetClanMemberJoinUserList: database internal error: %s, %d\n"), e.what(), m_Database.getErrorCode());
+		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::GetClanMemberJoinUserList: database internal error: %s, %d\n"), e.what(), GetDatabase().getErrorCode());
 		return 0;
 	}
 
@@ -5000,6 +6467,9 @@ string GetClanString(int flag, bool update)
 
 int CUserDatabaseSQLite::GetClan(int userID, int flag, Clan_s& clan)
 {
+	PROFILE_DB();
+	lock_guard<recursive_mutex> lock(GetMutex());
+
 	try
 	{
 		// format query
@@ -5007,92 +6477,92 @@ int CUserDatabaseSQLite::GetClan(int userID, int flag, Clan_s& clan)
 		query[query.size() - 1] = ' ';
 		query += OBFUSCATE("FROM Clan WHERE clanID = (SELECT clanID FROM ClanMember WHERE userID = ? LIMIT 1) LIMIT 1"); // TODO: use stringstream
 
-		SQLite::Statement statement(m_Database, query);
-		statement.bind(1, userID);
+		CCachedStatement statement = GetStatement(query);
+		statement->bind(1, userID);
 
-		if (statement.executeStep())
+		if (statement->executeStep())
 		{
 			int index = 0;
 			if (flag & CFLAG_NAME)
 			{
-				clan.name = (const char*)statement.getColumn(index++);
+				clan.name = (const char*)statement->getColumn(index++);
 			}
 			if (flag & CFLAG_MASTERUID)
 			{
-				clan.masterUserID = statement.getColumn(index++);
+				clan.masterUserID = statement->getColumn(index++);
 			}
 			if (flag & CFLAG_TIME)
 			{
-				clan.time = statement.getColumn(index++);
+				clan.time = statement->getColumn(index++);
 			}
 			if (flag & CFLAG_GAMEMODEID)
 			{
-				clan.gameModeID = statement.getColumn(index++);
+				clan.gameModeID = statement->getColumn(index++);
 			}
 			if (flag & CFLAG_MAPID)
 			{
-				clan.mapID = statement.getColumn(index++);
+				clan.mapID = statement->getColumn(index++);
 			}
 			if (flag & CFLAG_REGION)
 			{
-				clan.region = statement.getColumn(index++);
+				clan.region = statement->getColumn(index++);
 			}
 			if (flag & CFLAG_JOINMETHOD)
 			{
-				clan.joinMethod = statement.getColumn(index++);
+				clan.joinMethod = statement->getColumn(index++);
 			}
 			if (flag & CFLAG_EXPBOOST)
 			{
-				clan.expBoost = statement.getColumn(index++);
+				clan.expBoost = statement->getColumn(index++);
 			}
 			if (flag & CFLAG_POINTBOOST)
 			{
-				clan.pointBoost = statement.getColumn(index++);
+				clan.pointBoost = statement->getColumn(index++);
 			}
 			if (flag & CFLAG_NOTICEMSG)
 			{
-				clan.noticeMsg = (const char*)statement.getColumn(index++);
+				clan.noticeMsg = (const char*)statement->getColumn(index++);
 			}
 			if (flag & CFLAG_SCORE)
 			{
-				clan.score = statement.getColumn(index++);
+				clan.score = statement->getColumn(index++);
 			}
 			if (flag & CFLAG_MARKID)
 			{
-				clan.markID = statement.getColumn(index++);
+				clan.markID = statement->getColumn(index++);
 			}
 			if (flag & CFLAG_MARKCOLOR)
 			{
-				clan.markColor = statement.getColumn(index++);
+				clan.markColor = statement->getColumn(index++);
 			}
 			if (flag & CFLAG_ID)
 			{
-				clan.id = statement.getColumn(index++);
+				clan.id = statement->getColumn(index++);
 			}
 			if (flag & CFLAG_CLANMASTER)
 			{
-				clan.clanMaster = (const char*)statement.getColumn(index++);
+				clan.clanMaster = (const char*)statement->getColumn(index++);
 			}
 			if (flag & CFLAG_MARKCHANGECOUNT)
 			{
-				clan.markChangeCount = statement.getColumn(index++);
+				clan.markChangeCount = statement->getColumn(index++);
 			}
 			if (flag & CFLAG_MAXMEMBERCOUNT)
 			{
-				clan.maxMemberCount = statement.getColumn(index++);
+				clan.maxMemberCount = statement->getColumn(index++);
 			}
 			if (flag & CFLAG_CHRONICLE)
 			{
 				// TODO: rewrite
 				{
-					SQLite::Statement query(m_Database, OBFUSCATE("SELECT date, type, string FROM ClanChronicle WHERE clanID = (SELECT clanID FROM ClanMember WHERE userID = ? LIMIT 1)"));
-					query.bind(1, userID);
-					while (query.executeStep())
+					CCachedStatement query = CACHED_STATEMENT("SELECT date, type, string FROM ClanChronicle WHERE clanID = (SELECT clanID FROM ClanMember WHERE userID = ? LIMIT 1)");
+					query->bind(1, userID);
+					while (query->executeStep())
 					{
 						ClanChronicle chr;
-						chr.date = query.getColumn(0);
-						chr.type = query.getColumn(1);
-						chr.str = (const char*)query.getColumn(2);
+						chr.date = query->getColumn(0);
+						chr.type = query->getColumn(1);
+						chr.str = (const char*)query->getColumn(2);
 
 						clan.chronicle.push_back(chr);
 					}
@@ -5106,7 +6576,7 @@ int CUserDatabaseSQLite::GetClan(int userID, int flag, Clan_s& clan)
 	}
 	catch (exception& e)
 	{
-		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::GetClan: database internal error: %s, %d\n"), e.what(), m_Database.getErrorCode());
+		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::GetClan: database internal error: %s, %d\n"), e.what(), GetDatabase().getErrorCode());
 		return 0;
 	}
 
@@ -5115,26 +6585,28 @@ int CUserDatabaseSQLite::GetClan(int userID, int flag, Clan_s& clan)
 
 int CUserDatabaseSQLite::GetClanMember(int userID, ClanUser& clanUser)
 {
+	PROFILE_DB();
+	lock_guard<recursive_mutex> lock(GetMutex());
+
 	try
 	{
-		SQLite::Statement query(m_Database, OBFUSCATE("SELECT ClanMember.userID, memberGrade, gameName, userName, level, kills, deaths FROM ClanMember INNER JOIN UserCharacter ON UserCharacter.userID = ClanMember.userID AND ClanMember.clanID = (SELECT clanID FROM UserCharacter WHERE userID = ? LIMIT 1) INNER JOIN User ON User.userID = UserCharacter.userID LIMIT 1"));
-		query.bind(1, userID);
-		if (query.executeStep())
+		CCachedStatement query = CACHED_STATEMENT("SELECT ClanMember.userID, memberGrade, gameName, userName, level, kills, deaths FROM ClanMember INNER JOIN UserCharacter ON UserCharacter.userID = ClanMember.userID AND ClanMember.clanID = (SELECT clanID FROM UserCharacter WHERE userID = ? LIMIT 1) INNER JOIN User ON User.userID = UserCharacter.userID LIMIT 1");
+		query->bind(1, userID);
+		if (query->executeStep())
 		{
 			ClanUser clanUser = {};
-			clanUser.userID = query.getColumn(0);
-			clanUser.memberGrade = query.getColumn(1);
-			clanUser.character.gameName = (const char*)query.getColumn(2);
-			clanUser.userName = (const char*)query.getColumn(3);
-			clanUser.character.level = query.getColumn(4);
-			clanUser.character.kills = query.getColumn(5);
-			clanUser.character.deaths = query.getColumn(6);
-			clanUser.user = g_UserManager.GetUserById(clanUser.userID);
+			clanUser.userID = query->getColumn(0);
+			clanUser.memberGrade = query->getColumn(1);
+			clanUser.character.gameName = (const char*)query->getColumn(2);
+			clanUser.userName = (const char*)query->getColumn(3);
+			clanUser.character.level = query->getColumn(4);
+			clanUser.character.kills = query->getColumn(5);
+			clanUser.character.deaths = query->getColumn(6);
 		}
 	}
 	catch (exception& e)
 	{
-		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::GetClanMember: database internal error: %s, %d\n"), e.what(), m_Database.getErrorCode());
+		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::GetClanMember: database internal error: %s, %d\n"), e.what(), GetDatabase().getErrorCode());
 		return 0;
 	}
 
@@ -5143,6 +6615,9 @@ int CUserDatabaseSQLite::GetClanMember(int userID, ClanUser& clanUser)
 
 int CUserDatabaseSQLite::UpdateClan(int userID, int flag, Clan_s clan)
 {
+	PROFILE_DB();
+	lock_guard<recursive_mutex> lock(GetMutex());
+
 	try
 	{
 		// format query
@@ -5150,80 +6625,80 @@ int CUserDatabaseSQLite::UpdateClan(int userID, int flag, Clan_s clan)
 		query[query.size() - 1] = ' ';
 		query += OBFUSCATE("WHERE clanID = (SELECT clanID FROM ClanMember WHERE userID = ? AND memberGrade <= 1 LIMIT 1)"); // TODO: use stringstream
 
-		SQLite::Statement statement(m_Database, query);
+		CCachedStatement statement = GetStatement(query);
 		int index = 1;
 
 		if (flag & CFLAG_NAME)
 		{
-			statement.bind(index++, clan.name);
+			statement->bind(index++, clan.name);
 		}
 		if (flag & CFLAG_MASTERUID)
 		{
-			statement.bind(index++, clan.masterUserID);
+			statement->bind(index++, clan.masterUserID);
 		}
 		if (flag & CFLAG_TIME)
 		{
-			statement.bind(index++, clan.time);
+			statement->bind(index++, clan.time);
 		}
 		if (flag & CFLAG_GAMEMODEID)
 		{
-			statement.bind(index++, clan.gameModeID);
+			statement->bind(index++, clan.gameModeID);
 		}
 		if (flag & CFLAG_MAPID)
 		{
-			statement.bind(index++, clan.mapID);
+			statement->bind(index++, clan.mapID);
 		}
 		if (flag & CFLAG_REGION)
 		{
-			statement.bind(index++, clan.region);
+			statement->bind(index++, clan.region);
 		}
 		if (flag & CFLAG_JOINMETHOD)
 		{
-			statement.bind(index++, clan.joinMethod);
+			statement->bind(index++, clan.joinMethod);
 		}
 		if (flag & CFLAG_EXPBOOST)
 		{
-			statement.bind(index++, clan.expBoost);
+			statement->bind(index++, clan.expBoost);
 		}
 		if (flag & CFLAG_POINTBOOST)
 		{
-			statement.bind(index++, clan.pointBoost);
+			statement->bind(index++, clan.pointBoost);
 		}
 		if (flag & CFLAG_NOTICEMSG)
 		{
-			statement.bind(index++, clan.noticeMsg);
+			statement->bind(index++, clan.noticeMsg);
 		}
 		if (flag & CFLAG_SCORE)
 		{
-			statement.bind(index++, clan.score);
+			statement->bind(index++, clan.score);
 		}
 		if (flag & CFLAG_MARKID)
 		{
-			statement.bind(index++, clan.markID);
+			statement->bind(index++, clan.markID);
 		}
 		if (flag & CFLAG_MARKCOLOR)
 		{
-			statement.bind(index++, clan.markColor);
+			statement->bind(index++, clan.markColor);
 		}
 		if (flag & CFLAG_MARKCHANGECOUNT)
 		{
-			statement.bind(index++, clan.markChangeCount);
+			statement->bind(index++, clan.markChangeCount);
 		}
 		if (flag & CFLAG_MAXMEMBERCOUNT)
 		{
-			statement.bind(index++, clan.maxMemberCount);
+			statement->bind(index++, clan.maxMemberCount);
 		}
 
-		statement.bind(index++, userID);
+		statement->bind(index++, userID);
 
-		if (!statement.exec())
+		if (!statement->exec())
 		{
 			return -1; // not clan master
 		}
 	}
 	catch (exception& e)
 	{
-		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::UpdateClan: database internal error: %s, %d\n"), e.what(), m_Database.getErrorCode());
+		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::UpdateClan: database internal error: %s, %d\n"), e.what(), GetDatabase().getErrorCode());
 		return 0;
 	}
 
@@ -5232,36 +6707,38 @@ int CUserDatabaseSQLite::UpdateClan(int userID, int flag, Clan_s clan)
 
 int CUserDatabaseSQLite::UpdateClanMemberGrade(int userID, const string& targetUserName, int newGrade, ClanUser& targetMember)
 {
+	PROFILE_DB();
+	lock_guard<recursive_mutex> lock(GetMutex());
+
 	try
 	{
-		SQLite::Statement query(m_Database, OBFUSCATE("UPDATE ClanMember SET memberGrade = ? WHERE clanID = (SELECT clanID FROM ClanMember WHERE userID = ? AND memberGrade = 0 LIMIT 1) AND userID = (SELECT userID FROM User WHERE userName = ? LIMIT 1)"));
-		query.bind(1, newGrade);
-		query.bind(2, userID);
-		query.bind(3, targetUserName);
-		if (!query.exec())
+		CCachedStatement query = CACHED_STATEMENT("UPDATE ClanMember SET memberGrade = ? WHERE clanID = (SELECT clanID FROM ClanMember WHERE userID = ? AND memberGrade = 0 LIMIT 1) AND userID = (SELECT userID FROM User WHERE userName = ? LIMIT 1)");
+		query->bind(1, newGrade);
+		query->bind(2, userID);
+		query->bind(3, targetUserName);
+		if (!query->exec())
 		{
 			return -1; // not clan master
 		}
 
 		{
-			SQLite::Statement query(m_Database, OBFUSCATE("SELECT ClanMember.userID, memberGrade, gameName, userName, level, kills, deaths FROM ClanMember INNER JOIN UserCharacter ON UserCharacter.userID = ClanMember.userID INNER JOIN User ON User.userID = UserCharacter.userID AND User.userName = ? LIMIT 1"));
-			query.bind(1, targetUserName);
-			if (query.executeStep())
+			CCachedStatement query = CACHED_STATEMENT("SELECT ClanMember.userID, memberGrade, gameName, userName, level, kills, deaths FROM ClanMember INNER JOIN UserCharacter ON UserCharacter.userID = ClanMember.userID INNER JOIN User ON User.userID = UserCharacter.userID AND User.userName = ? LIMIT 1");
+			query->bind(1, targetUserName);
+			if (query->executeStep())
 			{
-				targetMember.userID = query.getColumn(0);
-				targetMember.memberGrade = query.getColumn(1);
-				targetMember.character.gameName = (const char*)query.getColumn(2);
-				targetMember.userName = (const char*)query.getColumn(3);
-				targetMember.character.level = query.getColumn(4);
-				targetMember.character.kills = query.getColumn(5);
-				targetMember.character.deaths = query.getColumn(6);
-				targetMember.user = g_UserManager.GetUserByUsername(targetUserName);
+				targetMember.userID = query->getColumn(0);
+				targetMember.memberGrade = query->getColumn(1);
+				targetMember.character.gameName = (const char*)query->getColumn(2);
+				targetMember.userName = (const char*)query->getColumn(3);
+				targetMember.character.level = query->getColumn(4);
+				targetMember.character.kills = query->getColumn(5);
+				targetMember.character.deaths = query->getColumn(6);
 			}
 		}
 	}
 	catch (exception& e)
 	{
-		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::UpdateClanMemberGrade: database internal error: %s, %d\n"), e.what(), m_Database.getErrorCode());
+		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::UpdateClanMemberGrade: database internal error: %s, %d\n"), e.what(), GetDatabase().getErrorCode());
 		return 0;
 	}
 
@@ -5270,19 +6747,22 @@ int CUserDatabaseSQLite::UpdateClanMemberGrade(int userID, const string& targetU
 
 int CUserDatabaseSQLite::ClanReject(int userID, const string& userName)
 {
+	PROFILE_DB();
+	lock_guard<recursive_mutex> lock(GetMutex());
+
 	try
 	{
-		SQLite::Statement query(m_Database, OBFUSCATE("DELETE FROM ClanMemberRequest WHERE clanID = (SELECT clanID FROM ClanMember WHERE userID = ? AND memberGrade <= 1 LIMIT 1) AND userID = (SELECT userID FROM User WHERE userName = ? LIMIT 1)"));
-		query.bind(1, userID);
-		query.bind(2, userName);
-		if (!query.exec())
+		CCachedStatement query = CACHED_STATEMENT("DELETE FROM ClanMemberRequest WHERE clanID = (SELECT clanID FROM ClanMember WHERE userID = ? AND memberGrade <= 1 LIMIT 1) AND userID = (SELECT userID FROM User WHERE userName = ? LIMIT 1)");
+		query->bind(1, userID);
+		query->bind(2, userName);
+		if (!query->exec())
 		{
 			return -1; // not clan master
 		}
 	}
 	catch (exception& e)
 	{
-		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::ClanReject: database internal error: %s, %d\n"), e.what(), m_Database.getErrorCode());
+		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::ClanReject: database internal error: %s, %d\n"), e.what(), GetDatabase().getErrorCode());
 		return 0;
 	}
 
@@ -5291,18 +6771,21 @@ int CUserDatabaseSQLite::ClanReject(int userID, const string& userName)
 
 int CUserDatabaseSQLite::ClanRejectAll(int userID)
 {
+	PROFILE_DB();
+	lock_guard<recursive_mutex> lock(GetMutex());
+
 	try
 	{
-		SQLite::Statement query(m_Database, OBFUSCATE("DELETE FROM ClanMemberRequest WHERE clanID = (SELECT clanID FROM ClanMember WHERE userID = ? AND memberGrade = 0 LIMIT 1)"));
-		query.bind(1, userID);
-		if (!query.exec())
+		CCachedStatement query = CACHED_STATEMENT("DELETE FROM ClanMemberRequest WHERE clanID = (SELECT clanID FROM ClanMember WHERE userID = ? AND memberGrade = 0 LIMIT 1)");
+		query->bind(1, userID);
+		if (!query->exec())
 		{
 			return -1; // not clan master
 		}
 	}
 	catch (exception& e)
 	{
-		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::ClanRejectAll: database internal error: %s, %d\n"), e.what(), m_Database.getErrorCode());
+		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::ClanRejectAll: database internal error: %s, %d\n"), e.what(), GetDatabase().getErrorCode());
 		return 0;
 	}
 
@@ -5311,40 +6794,43 @@ int CUserDatabaseSQLite::ClanRejectAll(int userID)
 
 int CUserDatabaseSQLite::ClanApprove(int userID, const string& userName)
 {
+	PROFILE_DB();
+	lock_guard<recursive_mutex> lock(GetMutex());
+
 	try
 	{
 		{
-			SQLite::Statement query(m_Database, OBFUSCATE("DELETE FROM ClanMemberRequest WHERE clanID = (SELECT clanID FROM ClanMember WHERE userID = ? AND memberGrade <= 1 LIMIT 1) AND userID = (SELECT userID FROM User WHERE userName = ? LIMIT 1)"));
-			query.bind(1, userID);
-			query.bind(2, userName);
-			if (!query.exec())
+			CCachedStatement query = CACHED_STATEMENT("DELETE FROM ClanMemberRequest WHERE clanID = (SELECT clanID FROM ClanMember WHERE userID = ? AND memberGrade <= 1 LIMIT 1) AND userID = (SELECT userID FROM User WHERE userName = ? LIMIT 1)");
+			query->bind(1, userID);
+			query->bind(2, userName);
+			if (!query->exec())
 			{
 				return -1; // not clan master
 			}
 		}
 		{
-			SQLite::Statement query(m_Database, OBFUSCATE("INSERT INTO ClanMember VALUES ((SELECT clanID FROM ClanMember WHERE userID = ? LIMIT 1), (SELECT userID FROM User WHERE userName = ? LIMIT 1), ?)"));
-			query.bind(1, userID);
-			query.bind(2, userName);
-			query.bind(3, 3);
-			if (!query.exec())
+			CCachedStatement query = CACHED_STATEMENT("INSERT INTO ClanMember VALUES ((SELECT clanID FROM ClanMember WHERE userID = ? LIMIT 1), (SELECT userID FROM User WHERE userName = ? LIMIT 1), ?)");
+			query->bind(1, userID);
+			query->bind(2, userName);
+			query->bind(3, 3);
+			if (!query->exec())
 			{
 				return -1;
 			}
 		}
 		{
-			SQLite::Statement query(m_Database, OBFUSCATE("UPDATE Clan SET memberCount = memberCount + 1 WHERE clanID = (SELECT clanID FROM ClanMember WHERE userID = ? LIMIT 1)"));
-			query.bind(1, userID);
-			if (!query.exec())
+			CCachedStatement query = CACHED_STATEMENT("UPDATE Clan SET memberCount = memberCount + 1 WHERE clanID = (SELECT clanID FROM ClanMember WHERE userID = ? LIMIT 1)");
+			query->bind(1, userID);
+			if (!query->exec())
 			{
 				return 0;
 			}
 		}
 		{
-			SQLite::Statement query(m_Database, OBFUSCATE("UPDATE UserCharacter SET clanID = (SELECT clanID FROM ClanMember WHERE userID = ? LIMIT 1) WHERE userID = (SELECT userID FROM User WHERE userName = ? LIMIT 1)"));
-			query.bind(1, userID);
-			query.bind(2, userName);
-			if (!query.exec())
+			CCachedStatement query = CACHED_STATEMENT("UPDATE UserCharacter SET clanID = (SELECT clanID FROM ClanMember WHERE userID = ? LIMIT 1) WHERE userID = (SELECT userID FROM User WHERE userName = ? LIMIT 1)");
+			query->bind(1, userID);
+			query->bind(2, userName);
+			if (!query->exec())
 			{
 				return 0;
 			}
@@ -5352,7 +6838,7 @@ int CUserDatabaseSQLite::ClanApprove(int userID, const string& userName)
 	}
 	catch (exception& e)
 	{
-		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::ClanApprove: database internal error: %s, %d\n"), e.what(), m_Database.getErrorCode());
+		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::ClanApprove: database internal error: %s, %d\n"), e.what(), GetDatabase().getErrorCode());
 		return 0;
 	}
 
@@ -5361,68 +6847,59 @@ int CUserDatabaseSQLite::ClanApprove(int userID, const string& userName)
 
 int CUserDatabaseSQLite::IsClanWithMarkExists(int markID)
 {
+	PROFILE_DB();
+	lock_guard<recursive_mutex> lock(GetMutex());
+
 	try
 	{
-		SQLite::Statement query(m_Database, OBFUSCATE("SELECT NOT EXISTS(SELECT 1 FROM Clan WHERE markID = ? LIMIT 1)"));
-		query.bind(1, markID);
-		if (query.executeStep())
+		CCachedStatement query = CACHED_STATEMENT("SELECT NOT EXISTS(SELECT 1 FROM Clan WHERE markID = ? LIMIT 1)");
+		query->bind(1, markID);
+		if (query->executeStep())
 		{
-			if ((int)query.getColumn(0))
+			if ((int)query->getColumn(0))
 				return -1;
 		}
 	}
 	catch (exception& e)
 	{
-		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::IsClanWithMarkExists: database internal error: %s, %d\n"), e.what(), m_Database.getErrorCode());
+		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::IsClanWithMarkExists: database internal error: %s, %d\n"), e.what(), GetDatabase().getErrorCode());
 		return 0;
 	}
 
 	return 1;
 }
 
-int CUserDatabaseSQLite::ClanInvite(int userID, const string& gameName, IUser*& destUser, int& clanID)
+int CUserDatabaseSQLite::ClanInvite(int userID, int destUserID, int& clanID)
 {
+	PROFILE_DB();
+	lock_guard<recursive_mutex> lock(GetMutex());
+
 	try
 	{
 		{
-			SQLite::Statement query(m_Database, OBFUSCATE("SELECT clanID FROM ClanMember WHERE userID = ? AND memberGrade <= 1 LIMIT 1"));
-			query.bind(1, userID);
-			if (!query.executeStep())
+			CCachedStatement query = CACHED_STATEMENT("SELECT clanID FROM ClanMember WHERE userID = ? AND memberGrade <= 1 LIMIT 1");
+			query->bind(1, userID);
+			if (!query->executeStep())
 			{
 				return -1; // only admin and family master can invite other users
 			}
 			else
 			{
-				clanID = query.getColumn(0);
-			}
-		}
-		int destUserID = 0;
-		{
-			SQLite::Statement query(m_Database, OBFUSCATE("SELECT userID FROM UserCharacter WHERE gameName = ? LIMIT 1"));
-			query.bind(1, gameName);
-			if (!query.executeStep())
-			{
-				return -3; // user does not exist
-			}
-			else
-			{
-				destUserID = query.getColumn(0);
+				clanID = query->getColumn(0);
 			}
 		}
-
-		destUser = g_UserManager.GetUserById(destUserID);
-		if (!destUser)
+		if (!destUserID)
 		{
-			return -2; // user is offline(TODO: are there more conditions?)
+			return -3; // user does not exist
 		}
 
 		{
-			SQLite::Statement query(m_Database, OBFUSCATE("SELECT clanID, memberGrade FROM ClanMember WHERE userID = ? LIMIT 1"));
-			query.bind(1, destUserID);
-			if (query.executeStep())
+			CCachedStatement query = CACHED_STATEMENT("SELECT clanID, memberGrade FROM ClanMember WHERE userID = ? LIMIT 1");
+			query->bind(1, destUserID);
+			if (query->executeStep())
 			{
-				int destClanID = query.getColumn(0);
-				int destMemberGrade = query.getColumn(1);
+				int destClanID = query->getColumn(0);
+				int destMemberGrade = query->getColumn(1);
 
 				if (destMemberGrade == 0)
 				{
@@ -5436,16 +6913,16 @@ int CUserDatabaseSQLite::ClanInvite(int userID, const string& gameName, IUser*&
 		}
 
 		{
-			SQLite::Statement query(m_Database, OBFUSCATE("INSERT INTO ClanInvite VALUES(?, ?, ?)"));
-			query.bind(1, clanID);
-			query.bind(2, userID);
-			query.bind(3, destUserID);
-			query.exec();
+			CCachedStatement query = CACHED_STATEMENT("INSERT INTO ClanInvite VALUES(?, ?, ?)");
+			query->bind(1, clanID);
+			query->bind(2, userID);
+			query->bind(3, destUserID);
+			query->exec();
 		}
 	}
 	catch (exception& e)
 	{
-		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::ClanInvite: database internal error: %s, %d\n"), e.what(), m_Database.getErrorCode());
+		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::ClanInvite: database internal error: %s, %d\n"), e.what(), GetDatabase().getErrorCode());
 		return 0;
 	}
 
@@ -5454,49 +6931,52 @@ int CUserDatabaseSQLite::ClanInvite(int userID, const string& gameName, IUser*&
 
 int CUserDatabaseSQLite::ClanKick(int userID, const string& userName)
 {
+	PROFILE_DB();
+	lock_guard<recursive_mutex> lock(GetMutex());
+
 	try
 	{
 		int clanID = 0;
 		{
 			// TODO: rewrite query (family master can't kick admins)
-			SQLite::Statement query(m_Database, OBFUSCATE("SELECT clanID FROM ClanMember WHERE userID = ? AND memberGrade <= 1 LIMIT 1"));
-			query.bind(1, userID);
-			if (!query.executeStep())
+			CCachedStatement query = CACHED_STATEMENT("SELECT clanID FROM ClanMember WHERE userID = ? AND memberGrade <= 1 LIMIT 1");
+			query->bind(1, userID);
+			if (!query->executeStep())
 			{
 				return -1; // only admin and family master can kick other users
 			}
 			else
 			{
-				clanID = query.getColumn(0);
+				clanID = query->getColumn(0);
 			}
 		}
 		int targetUserID = 0;
 		{
-			SQLite::Statement query(m_Database, OBFUSCATE("SELECT userID FROM ClanMember WHERE userID = (SELECT userID FROM User WHERE userName = ? LIMIT 1) AND memberGrade > (SELECT memberGrade FROM ClanMember WHERE userID = ? LIMIT 1) LIMIT 1"));
-			query.bind(1, userName);
-			query.bind(2, userID);
-			if (!query.executeStep())
+			CCachedStatement query = CACHED_STATEMENT("SELECT userID FROM ClanMember WHERE userID = (SELECT userID FROM User WHERE userName = ? LIMIT 1) AND memberGrade > (SELECT memberGrade FROM ClanMember WHERE userID = ? LIMIT 1) LIMIT 1");
+			query->bind(1, userName);
+			query->bind(2, userID);
+			if (!query->executeStep())
 			{
 				return -1;
 			}
 			else
 			{
-				targetUserID = query.getColumn(0);
+				targetUserID = query->getColumn(0);
 			}
 		}
 		{
-			SQLite::Statement query(m_Database, OBFUSCATE("DELETE FROM ClanMember WHERE clanID = ? AND userID = ?"));
-			query.bind(1, clanID);
-			query.bind(2, targetUserID);
-			if (!query.exec())
+			CCachedStatement query = CACHED_STATEMENT("DELETE FROM ClanMember WHERE clanID = ? AND userID = ?");
+			query->bind(1, clanID);
+			query->bind(2, targetUserID);
+			if (!query->exec())
 			{
 				return 0;
 			}
 		}
 		{
-			SQLite::Statement query(m_Database, OBFUSCATE("UPDATE Clan SET memberCount = memberCount - 1 WHERE clanID = ?"));
-			query.bind(1, clanID);
-			if (!query.exec())
+			CCachedStatement query = CACHED_STATEMENT("UPDATE Clan SET memberCount = memberCount - 1 WHERE clanID = ?");
+			query->bind(1, clanID);
+			if (!query->exec())
 			{
 				return 0;
 			}
@@ -5504,7 +6984,7 @@ int CUserDatabaseSQLite::ClanKick(int userID, const string& userName)
 	}
 	catch (exception& e)
 	{
-		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::ClanKick: database internal error: %s, %d\n"), e.what(), m_Database.getErrorCode());
+		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::ClanKick: database internal error: %s, %d\n"), e.what(), GetDatabase().getErrorCode());
 		return 0;
 	}
 
@@ -5513,32 +6993,35 @@ int CUserDatabaseSQLite::ClanKick(int userID, const string& userName)
 
 int CUserDatabaseSQLite::ClanMasterDelegate(int userID, const string& userName)
 {
+	PROFILE_DB();
+	lock_guard<recursive_mutex> lock(GetMutex());
+
 	try
 	{
 		{
-			SQLite::Statement query(m_Database, OBFUSCATE("UPDATE ClanMember SET memberGrade = 0 WHERE userID = (SELECT userID FROM User WHERE userName = ? LIMIT 1) AND memberGrade = 1 AND (SELECT memberGrade FROM ClanMember WHERE userID = ? LIMIT 1) = 0"));
-			query.bind(1, userName);
-			query.bind(2, userID);
-			if (!query.exec())
+			CCachedStatement query = CACHED_STATEMENT("UPDATE ClanMember SET memberGrade = 0 WHERE userID = (SELECT userID FROM User WHERE userName = ? LIMIT 1) AND memberGrade = 1 AND (SELECT memberGrade FROM ClanMember WHERE userID = ? LIMIT 1) = 0");
+			query->bind(1, userName);
+			query->bind(2, userID);
+			if (!query->exec())
 			{
 				return -1;
 			}
 		}
 		{
-			SQLite::Statement query(m_Database, OBFUSCATE("UPDATE ClanMember SET memberGrade = 1 WHERE userID = ?"));
-			query.bind(1, userID);
-			if (!query.exec())
+			CCachedStatement query = CACHED_STATEMENT("UPDATE ClanMember SET memberGrade = 1 WHERE userID = ?");
+			query->bind(1, userID);
+			if (!query->exec())
 			{
 				return 0;
 			}
 		}
 		{
-			SQLite::Statement query(m_Database, OBFUSCATE("INSERT INTO ClanChronicle VALUES ((SELECT clanID FROM ClanMember WHERE userID = ? LIMIT 1), strftime('%Y%m%d', datetime(?, 'unixepoch')), ?, ?)"));
-			query.bind(1, userID);
-			query.bind(2, g_pServerInstance->GetCurrentTime() * 60); // convert minutes to seconds
-			query.bind(3, 1); // master change
-			query.bind(4, userName);
-			if (!query.exec())
+			CCachedStatement query = CACHED_STATEMENT("INSERT INTO ClanChronicle VALUES ((SELECT clanID FROM ClanMember WHERE userID = ? LIMIT 1), strftime('%Y%m%d', datetime(?, 'unixepoch')), ?, ?)");
+			query->bind(1, userID);
+			query->bind(2, g_pServerInstance->GetCurrentTime() * 60); // convert minutes to seconds
+			query->bind(3, 1); // master change
+			query->bind(4, userName);
+			if (!query->exec())
 			{
 				return 0;
 			}
@@ -5546,7 +7029,7 @@ int CUserDatabaseSQLite::ClanMasterDelegate(int userID, const string& userName)
 	}
 	catch (exception& e)
 	{
-		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::ClanMasterDelegate: database internal error: %s, %d\n"), e.what(), m_Database.getErrorCode());
+		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::ClanMasterDelegate: database internal error: %s, %d\n"), e.what(), GetDatabase().getErrorCode());
 		return 0;
 	}
 
@@ -5555,19 +7038,22 @@ int CUserDatabaseSQLite::ClanMasterDelegate(int userID, const string& userName)
 
 int CUserDatabaseSQLite::IsClanExists(const string& clanName)
 {
+	PROFILE_DB();
+	lock_guard<recursive_mutex> lock(GetMutex());
+
 	int clanID = 0;
 	try
 	{
-		SQLite::Statement query(m_Database, OBFUSCATE("SELECT clanID FROM Clan WHERE name = ? LIMIT 1"));
-		query.bind(1, clanName);
-		if (query.executeStep())
+		CCachedStatement query = CACHED_STATEMENT("SELECT clanID FROM Clan WHERE name = ? LIMIT 1");
+		query->bind(1, clanName);
+		if (query->executeStep())
 		{
-			clanID = query.getColumn(0);
+			clanID = query->getColumn(0);
 		}
 	}
 	catch (exception& e)
 	{
-		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::IsClanExists: database internal error: %s, %d\n"), e.what(), m_Database.getErrorCode());
+		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::IsClanExists: database internal error: %s, %d\n"), e.what(), GetDatabase().getErrorCode());
 		return 0;
 	}
 
@@ -5577,23 +7063,26 @@ int CUserDatabaseSQLite::IsClanExists(const string& clanName)
 
 int CUserDatabaseSQLite::GetQuestEventProgress(int userID, int questID, UserQuestProgress& questProgress)
 {
+	PROFILE_DB();
+	lock_guard<recursive_mutex> lock(GetMutex());
+
 	try
 	{
-		SQLite::Statement statement(m_Database, OBFUSCATE("SELECT status, favourite, started FROM UserQuestEventProgress WHERE userID = ? AND questID = ? LIMIT 1"));
-		statement.bind(1, userID);
-		statement.bind(2, questID);
-		if (statement.executeStep())
+		CCachedStatement statement = CACHED_STATEMENT("SELECT status, favourite, started FROM UserQuestEventProgress WHERE userID = ? AND questID = ? LIMIT 1");
+		statement->bind(1, userID);
+		statement->bind(2, questID);
+		if (statement->executeStep())
 		{
-			questProgress.status = statement.getColumn(0);
-			questProgress.favourite = (char)statement.getColumn(1);
-			questProgress.started = (char)statement.getColumn(2);
+			questProgress.status = statement->getColumn(0);
+			questProgress.favourite = (char)statement->getColumn(1);
+			questProgress.started = (char)statement->getColumn(2);
 		}
 
 		questProgress.questID = questID;
 	}
 	catch (exception& e)
 	{
-		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::GetQuestEventProgress: database internal error: %s, %d\n"), e.what(), m_Database.getErrorCode());
+		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::GetQuestEventProgress: database internal error: %s, %d\n"), e.what(), GetDatabase().getErrorCode());
 		return 0;
 	}
 
@@ -5602,28 +7091,31 @@ int CUserDatabaseSQLite::GetQuestEventProgress(int userID, int questID, UserQues
 
 int CUserDatabaseSQLite::UpdateQuestEventProgress(int userID, const UserQuestProgress& questProgress)
 {
+	PROFILE_DB();
+	lock_guard<recursive_mutex> lock(GetMutex());
+
 	try
 	{
-		SQLite::Statement statement(m_Database, OBFUSCATE("UPDATE UserQuestEventProgress SET status = ?, favourite = ?, started = ? WHERE userID = ? AND questID = ?"));
-		statement.bind(1, questProgress.status);
-		statement.bind(2, questProgress.favourite);
-		statement.bind(3, questProgress.started);
-		statement.bind(4, userID);
-		statement.bind(5, questProgress.questID);
-		if (!statement.exec())
+		CCachedStatement statement = CACHED_STATEMENT("UPDATE UserQuestEventProgress SET status = ?, favourite = ?, started = ? WHERE userID = ? AND questID = ?");
+		statement->bind(1, questProgress.status);
+		statement->bind(2, questProgress.favourite);
+		statement->bind(3, questProgress.started);
+		statement->bind(4, userID);
+		statement->bind(5, questProgress.questID);
+		if (!statement->exec())
 		{
-			SQLite::Statement statement(m_Database, OBFUSCATE("INSERT INTO UserQuestEventProgress VALUES (?, ?, ?, ?, ?)"));
-			statement.bind(1, userID);
-			statement.bind(2, questProgress.questID);
-			statement.bind(3, questProgress.status);
-			statement.bind(4, questProgress.favourite);
-			statement.bind(5, questProgress.started);
-			statement.exec();
+			CCachedStatement statement = CACHED_STATEMENT("INSERT INTO UserQuestEventProgress VALUES (?, ?, ?, ?, ?)");
+			statement->bind(1, userID);
+			statement->bind(2, questProgress.questID);
+			statement->bind(3, questProgress.status);
+			statement->bind(4, questProgress.favourite);
+			statement->bind(5, questProgress.started);
+			statement->exec();
 		}
 	}
 	catch (exception& e)
 	{
-		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::UpdateQuestEventProgress: database internal error: %s, %d\n"), e.what(), m_Database.getErrorCode());
+		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::UpdateQuestEventProgress: database internal error: %s, %d\n"), e.what(), GetDatabase().getErrorCode());
 		return 0;
 	}
 
@@ -5632,24 +7124,27 @@ int CUserDatabaseSQLite::UpdateQuestEventProgress(int userID, const UserQuestPro
 
 int CUserDatabaseSQLite::GetQuestEventTaskProgress(int userID, int questID, int taskID, UserQuestTaskProgress& taskProgress)
 {
+	PROFILE_DB();
+	lock_guard<recursive_mutex> lock(GetMutex());
+
 	try
 	{
-		SQLite::Statement statement(m_Database, OBFUSCATE("SELECT unitsDone, taskVar, finished FROM UserQuestEventTaskProgress WHERE userID = ? AND questID = ? AND taskID = ? LIMIT 1"));
-		statement.bind(1, userID);
-		statement.bind(2, questID);
-		statement.bind(3, taskID);
-		if (statement.executeStep())
+		CCachedStatement statement = CACHED_STATEMENT("SELECT unitsDone, taskVar, finished FROM UserQuestEventTaskProgress WHERE userID = ? AND questID = ? AND taskID = ? LIMIT 1");
+		statement->bind(1, userID);
+		statement->bind(2, questID);
+		statement->bind(3, taskID);
+		if (statement->executeStep())
 		{
-			taskProgress.unitsDone = statement.getColumn(0);
-			taskProgress.taskVar = statement.getColumn(1);
-			taskProgress.finished = (char)statement.getColumn(2);
+			taskProgress.unitsDone = statement->getColumn(0);
+			taskProgress.taskVar = statement->getColumn(1);
+			taskProgress.finished = (char)statement->getColumn(2);
 		}
 
 		taskProgress.taskID = taskID;
 	}
 	catch (exception& e)
 	{
-		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::GetQuestEventTaskProgress: database internal error: %s, %d\n"), e.what(), m_Database.getErrorCode());
+		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::GetQuestEventTaskProgress: database internal error: %s, %d\n"), e.what(), GetDatabase().getErrorCode());
 		return 0;
 	}
 
@@ -5658,30 +7153,33 @@ int CUserDatabaseSQLite::GetQuestEventTaskProgress(int userID, int questID, int
 
 int CUserDatabaseSQLite::UpdateQuestEventTaskProgress(int userID, int questID, const UserQuestTaskProgress& taskProgress)
 {
+	PROFILE_DB();
+	lock_guard<recursive_mutex> lock(GetMutex());
+
 	try
 	{
-		SQLite::Statement statement(m_Database, OBFUSCATE("UPDATE UserQuestEventTaskProgress SET unitsDone = ?, taskVar = ?, finished = ? WHERE userID = ? AND questID = ? AND taskID = ?"));
-		statement.bind(1, taskProgress.unitsDone);
-		statement.bind(2, taskProgress.taskVar);
-		statement.bind(3, taskProgress.finished);
-		statement.bind(4, userID);
-		statement.bind(5, questID);
-		statement.bind(6, taskProgress.taskID);
-		if (!statement.exec())
+		CCachedStatement statement = CACHED_STATEMENT("UPDATE UserQuestEventTaskProgress SET unitsDone = ?, taskVar = ?, finished = ? WHERE userID = ? AND questID = ? AND taskID = ?");
+		statement->bind(1, taskProgress.unitsDone);
+		statement->bind(2, taskProgress.taskVar);
+		statement->bind(3, taskProgress.finished);
+		statement->bind(4, userID);
+		statement->bind(5, questID);
+		statement->bind(6, taskProgress.taskID);
+		if (!statement->exec())
 		{
-			SQLite::Statement statement(m_Database, OBFUSCATE("INSERT INTO UserQuestEventTaskProgress VALUES (?, ?, ?, ?, ?, ?)"));
-			statement.bind(1, userID);
-			statement.bind(2, questID);
-			statement.bind(3, taskProgress.taskID);
-			statement.bind(4, taskProgress.unitsDone);
-			statement.bind(5, taskProgress.taskVar);
-			statement.bind(6, taskProgress.finished);
-			statement.exec();
+			CCachedStatement statement = CACHED_STATEMENT("INSERT INTO UserQuestEventTaskProgress VALUES (?, ?, ?, ?, ?, ?)");
+			statement->bind(1, userID);
+			statement->bind(2, questID);
+			statement->bind(3, taskProgress.taskID);
+			statement->bind(4, taskProgress.unitsDone);
+			statement->bind(5, taskProgress.taskVar);
+			statement->bind(6, taskProgress.finished);
+			statement->exec();
 		}
 	}
 	catch (exception& e)
 	{
-		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::UpdateQuestEventTaskProgress: database internal error: %s, %d\n"), e.what(), m_Database.getErrorCode());
+		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::UpdateQuestEventTaskProgress: database internal error: %s, %d\n"), e.what(), GetDatabase().getErrorCode());
 		return 0;
 	}
 
@@ -5690,21 +7188,24 @@ int CUserDatabaseSQLite::UpdateQuestEventTaskProgress(int userID, int questID, c
 
 bool CUserDatabaseSQLite::IsQuestEventTaskFinished(int userID, int questID, int taskID)
 {
+	PROFILE_DB();
+	lock_guard<recursive_mutex> lock(GetMutex());
+
 	try
 	{
-		SQLite::Statement query(m_Database, OBFUSCATE("SELECT NOT EXISTS(SELECT 1 FROM UserQuestEventTaskProgress WHERE userID = ? AND questID = ? AND taskID = ? AND finished = 1 LIMIT 1)"));
-		query.bind(1, userID);
-		query.bind(2, questID);
-		query.bind(3, taskID);
-		if (query.executeStep())
+		CCachedStatement query = CACHED_STATEMENT("SELECT NOT EXISTS(SELECT 1 FROM UserQuestEventTaskProgress WHERE userID = ? AND questID = ? AND taskID = ? AND finished = 1 LIMIT 1)");
+		query->bind(1, userID);
+		query->bind(2, questID);
+		query->bind(3, taskID);
+		if (query->executeStep())
 		{
-			if ((int)query.getColumn(0))
+			if ((int)query->getColumn(0))
 				return false;
 		}
 	}
 	catch (exception& e)
 	{
-		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::IsQuestEventTaskFinished: database internal error: %s, %d\n"), e.what(), m_Database.getErrorCode());
+		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::IsQuestEventTaskFinished: database internal error: %s, %d\n"), e.what(), GetDatabase().getErrorCode());
 		return false;
 	}
 
@@ -5715,19 +7216,22 @@ bool CUserDatabaseSQLite::IsQuestEventTaskFinished(int userID, int questID, int
 // returns 0 == database error, 1 == user exists
 int CUserDatabaseSQLite::IsUserExists(int userID)
 {
+	PROFILE_DB();
+	lock_guard<recursive_mutex> lock(GetMutex());
+
 	int retVal = 0;
 	try
 	{
-		SQLite::Statement statement(m_Database, OBFUSCATE("SELECT EXISTS(SELECT 1 FROM User WHERE userID = ? LIMIT 1)"));
-		statement.bind(1, userID);
-		if (statement.executeStep())
+		CCachedStatement statement = CACHED_STATEMENT("SELECT EXISTS(SELECT 1 FROM User WHERE userID = ? LIMIT 1)");
+		statement->bind(1, userID);
+		if (statement->executeStep())
 		{
-			return statement.getColumn(0);
+			return statement->getColumn(0);
 		}
 	}
 	catch (exception& e)
 	{
-		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::IsUserExists: database internal error: %s, %d\n"), e.what(), m_Database.getErrorCode());
+		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::IsUserExists: database internal error: %s, %d\n"), e.what(), GetDatabase().getErrorCode());
 		return 0;
 	}
 
@@ -5738,21 +7242,24 @@ int CUserDatabaseSQLite::IsUserExists(int userID)
 // returns 0 == database error or user does not exists, > 0 == userID
 int CUserDatabaseSQLite::IsUserExists(const string& userName, bool searchByUserName)
 {
+	PROFILE_DB();
+	lock_guard<recursive_mutex> lock(GetMutex());
+
 	int userID = 0;
 	try
 	{
 		string query = searchByUserName ? OBFUSCATE("SELECT userID FROM User WHERE userName = ? LIMIT 1") : OBFUSCATE("SELECT userID FROM UserCharacter WHERE gameName = ? LIMIT 1");
 
-		SQLite::Statement statement(m_Database, query);
-		statement.bind(1, userName);
-		if (statement.executeStep())
+		CCachedStatement statement = GetStatement(query);
+		statement->bind(1, userName);
+		if (statement->executeStep())
 		{
-			userID = statement.getColumn(0);
+			userID = statement->getColumn(0);
 		}
 	}
 	catch (exception& e)
 	{
-		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::IsUserExists: database internal error: %s, %d\n"), e.what(), m_Database.getErrorCode());
+		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::IsUserExists: database internal error: %s, %d\n"), e.what(), GetDatabase().getErrorCode());
 		return 0;
 	}
 
@@ -5764,17 +7271,20 @@ int CUserDatabaseSQLite::IsUserExists(const string& userName, bool searchByUserN
 // returns 0 == database error, 1 on success
 int CUserDatabaseSQLite::SuspectAddAction(const vector<unsigned char>& hwid, int actionID)
 {
+	PROFILE_DB();
+	lock_guard<recursive_mutex> lock(GetMutex());
+
 	try
 	{
-		SQLite::Statement query(m_Database, OBFUSCATE("INSERT INTO SuspectAction VALUES (?, ?, ?)"));
-		query.bind(1, hwid.data(), hwid.size());
-		query.bind(2, actionID);
-		query.bind(3, g_pServerInstance->GetCurrentTime());
-		query.exec();
+		CCachedStatement query = CACHED_STATEMENT("INSERT INTO SuspectAction VALUES (?, ?, ?)");
+		query->bind(1, hwid.data(), hwid.size());
+		query->bind(2, actionID);
+		query->bind(3, g_pServerInstance->GetCurrentTime());
+		query->exec();
 	}
 	catch (exception& e)
 	{
-		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::SuspectAddAction: database internal error: %s, %d\n"), e.what(), m_Database.getErrorCode());
+		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::SuspectAddAction: database internal error: %s, %d\n"), e.what(), GetDatabase().getErrorCode());
 		return 0;
 	}
 
@@ -5785,341 +7295,402 @@ int CUserDatabaseSQLite::SuspectAddAction(const vector<unsigned char>& hwid, int
 // returns 0 == database error or user not in suspect list, 1 on user is not suspect
 int CUserDatabaseSQLite::IsUserSuspect(int userID)
 {
+	PROFILE_DB();
+	lock_guard<recursive_mutex> lock(GetMutex());
+
 	try
 	{
 		// TODO: check all hwid logged in on this account
-		SQLite::Statement query(m_Database, OBFUSCATE("SELECT EXISTS(SELECT 1 FROM SuspectAction WHERE hwid = (SELECT lastHWID FROM User WHERE userID = ? LIMIT 1) LIMIT 1)"));
-		query.bind(1, userID);
-		if (query.executeStep())
+		CCachedStatement query = CACHED_STATEMENT("SELECT EXISTS(SELECT 1 FROM SuspectAction WHERE hwid = (SELECT lastHWID FROM User WHERE userID = ? LIMIT 1) LIMIT 1)");
+		query->bind(1, userID);
+		if (query->executeStep())
 		{
-			return query.getColumn(0);
+			return query->getColumn(0);
 		}
 	}
 	catch (exception& e)
 	{
-		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::IsUserSuspect: database internal error: %s, %d\n"), e.what(), m_Database.getErrorCode());
+		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::IsUserSuspect: database internal error: %s, %d\n"), e.what(), GetDatabase().getErrorCode());
 		return 0;
 	}
 
 	return 0;
 }
 
-// processes user database every minute
-void CUserDatabaseSQLite::OnMinuteTick(time_t curTime)
+// runs every second, queues the next step of running online backup and quest reset to the database thread
+void CUserDatabaseSQLite::OnSecondTick(time_t curTime)
 {
-	try
+	if (m_bBackupRunning && !m_bBackupStepQueued)
 	{
-		// process inventory
+		m_bBackupStepQueued = true;
+		g_UserDatabaseAsync.AddJob([this]()
 		{
-			SQLite::Statement query(m_Database, OBFUSCATE("SELECT userID, slot, itemID, status, inUse FROM UserInventory WHERE expiryDate != 0 AND inUse = 1 AND expiryDate < ?"));
-			query.bind(1, curTime);
+			BackupStep();
+			m_bBackupStepQueued = false;
+		});
+	}
 
-			while (query.executeStep())
-			{
-				CUserInventoryItem item(query.getColumn(1), query.getColumn(2), 0, query.getColumn(3), query.getColumn(4), 0, 0, 0, 0, 0, 0, 0, {}, 0, 0, 0);
-				int userID = query.getColumn(0);
+	if (m_nQuestResetFlags && !m_bQuestResetStepQueued)
+	{
+		m_bQuestResetStepQueued = true;
+		g_UserDatabaseAsync.AddJob([this]()
+		{
+			QuestResetStep();
+			m_bQuestResetStepQueued = false;
+		});
+	}
+}
 
-				IUser* user = g_UserManager.GetUserById(userID);
-				if (user)
-				{
-					g_PacketManager.SendUMsgExpiryNotice(user->GetExtendedSocket(), vector<int>{ item.m_nItemID });
+// returns the minute of 6 AM local time after given number of days
+time_t CUserDatabaseSQLite::GetNextResetTime(time_t curTime, int days)
+{
+	time_t tempCurTime = curTime;
+	tempCurTime *= 60;
+	tempCurTime += CSO_24_HOURS_IN_SECONDS * days;
+	tm* localTime = localtime(&tempCurTime);
+	localTime->tm_hour = 6;
+	localTime->tm_sec = 0;
+	localTime->tm_min = 0;
 
-					g_ItemManager.RemoveItem(userID, user, item);
-				}
-				else
-				{
-					// add to notice list
-					UpdateExpiryNotices(userID, item.m_nItemID);
+	return mktime(localTime) / 60;
+}
 
-					g_ItemManager.RemoveItem(userID, user, item);
-				}
-			}
+void CUserDatabaseSQLite::OnMinuteTick(time_t curTime)
+{
+	PROFILE_DB();
+	g_UserDatabaseAsync.AddJob([this, curTime]()
+	{
+		Checkpoint();
+		CheckResetTime(curTime);
+	});
 
-			query.reset();
-		}
+	lock_guard<recursive_mutex> lock(GetMutex());
 
-		// delete ban rows with expired term
+	try
+	{
+		// process expired inventory and clan storage items
 		{
-			SQLite::Statement query(m_Database, OBFUSCATE("DELETE FROM UserBan WHERE term <= ?"));
-			query.bind(1, curTime);
-			query.exec();
-		}
+			vector<ExpiryTimer_s> timers;
+			m_ExpiryTimers.Advance(curTime, timers);
 
-		// update session time for user session
-		{
-			SQLite::Statement query(m_Database, OBFUSCATE("UPDATE UserSession SET sessionTime = sessionTime + 1"));
-			query.exec();
+			for (auto& timer : timers)
+			{
+				if (timer.type == EXPIRY_TIMER_INVENTORY)
+					ExpireInventoryItem(timer.id, timer.slot, curTime);
+				else
+					ExpireClanStorageItem(timer.id, timer.pageID, timer.slot, curTime);
+			}
 		}
 
-		// delete storage items with expired date
+		// save the time the server was last alive, used to end sessions left by a crash
 		{
-			SQLite::Statement query(m_Database, OBFUSCATE("UPDATE ClanStorageItem SET itemID = 0, itemDuration = 0, itemCount = 0 WHERE itemID != 0 AND itemDuration <= ?"));
-			query.bind(1, curTime);
-			query.exec();
+			CCachedStatement query = CACHED_STATEMENT("UPDATE TimeConfig SET lastAliveTime = ?");
+			query->bind(1, curTime);
+			query->exec();
 		}
 
-		// check if day tick need to be done
+		// delete ban rows with expired term
 		{
-			SQLite::Statement query(m_Database, OBFUSCATE("SELECT nextDayResetTime FROM TimeConfig WHERE ? >= nextDayResetTime"));
-			query.bind(1, curTime);
-			if (query.executeStep())
-			{				
-				time_t tempCurTime = curTime;
-				tempCurTime *= 60;
-				tempCurTime += CSO_24_HOURS_IN_SECONDS;
-				tm* localTime = localtime(&tempCurTime);
-				localTime->tm_hour = 6;
-				localTime->tm_sec = 0;
-				localTime->tm_min = 0;
-
-				time_t dayTick = mktime(localTime);
-				dayTick /= 60;
+			CCachedStatement query = CACHED_STATEMENT("DELETE FROM UserBan WHERE term <= ?");
+			query->bind(1, curTime);
+			query->exec();
+		}
+	}
+	catch (exception& e)
+	{
+		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::OnMinuteTick: database internal error: %s, %d\n"), e.what(), GetDatabase().getErrorCode());
+	}
+}
 
-				SQLite::Statement query(m_Database, OBFUSCATE("UPDATE TimeConfig SET nextDayResetTime = ?"));
-				query.bind(1, dayTick);
-				if (!query.exec())
-				{
-					SQLite::Statement query(m_Database, OBFUSCATE("INSERT INTO TimeConfig VALUES (?, 0)"));
-					query.bind(1, dayTick);
-					query.exec();
-				}
+// checks if day or week tick need to be done. Called on the database thread, which owns the quest reset state
+void CUserDatabaseSQLite::CheckResetTime(time_t curTime)
+{
+	PROFILE_DB();
+	lock_guard<recursive_mutex> lock(GetMutex());
 
-				OnDayTick();
-			}
+	try
+	{
+		CCachedStatement query = CACHED_STATEMENT("SELECT nextDayResetTime, nextWeekResetTime FROM TimeConfig LIMIT 1");
+		time_t nextDayResetTime = 0;
+		time_t nextWeekResetTime = 0;
+		if (query->executeStep())
+		{
+			nextDayResetTime = query->getColumn(0).getInt64();
+			nextWeekResetTime = query->getColumn(1).getInt64();
 		}
 
-		// check if week tick need to be done
+		bool dayTick = curTime >= nextDayResetTime;
+		bool weekTick = curTime >= nextWeekResetTime;
+		if (dayTick || weekTick)
 		{
-			SQLite::Statement query(m_Database, OBFUSCATE("SELECT nextWeekResetTime FROM TimeConfig WHERE ? >= nextWeekResetTime"));
-			query.bind(1, curTime);
-			if (query.executeStep())
+			int resetFlags = m_nQuestResetFlags;
+			if (dayTick)
 			{
-				time_t tempCurTime = curTime;
-				tempCurTime *= 60;
-				tempCurTime += CSO_24_HOURS_IN_SECONDS * 7;
-				tm* localTime = localtime(&tempCurTime);
-				localTime->tm_hour = 6;
-				localTime->tm_sec = 0;
-				localTime->tm_min = 0;
-
-				time_t weekTick = mktime(localTime);
-				weekTick /= 60;
+				nextDayResetTime = GetNextResetTime(curTime, 1);
+				resetFlags |= QUEST_RESET_DAY;
+			}
+			if (weekTick)
+			{
+				nextWeekResetTime = GetNextResetTime(curTime, 7);
+				resetFlags |= QUEST_RESET_WEEK;
+			}
 
-				SQLite::Statement query(m_Database, OBFUSCATE("UPDATE TimeConfig SET nextWeekResetTime = ?"));
-				query.bind(1, weekTick);
-				if (!query.exec())
-				{
-					query.bind(1, weekTick);
-					query.exec();
-				}
+			// the next reset time and the quest reset state are written together, so a crash can't skip the reset or run it twice
+			CCachedStatement query = CACHED_STATEMENT("UPDATE TimeConfig SET nextDayResetTime = ?, nextWeekResetTime = ?, resetFlags = ?, resetUserID = 0");
+			query->bind(1, nextDayResetTime);
+			query->bind(2, nextWeekResetTime);
+			query->bind(3, resetFlags);
+			if (!query->exec())
+			{
+				CCachedStatement query = CACHED_STATEMENT("INSERT INTO TimeConfig (nextDayResetTime, nextWeekResetTime, resetFlags, resetUserID) VALUES (?, ?, ?, 0)");
+				query->bind(1, nextDayResetTime);
+				query->bind(2, nextWeekResetTime);
+				query->bind(3, resetFlags);
+				query->exec();
+			}
 
+			if (dayTick)
+				OnDayTick();
+			if (weekTick)
 				OnWeekTick();
-			}
 		}
 	}
 	catch (exception& e)
 	{
-		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::OnMinuteTick: database internal error: %s, %d\n"), e.what(), m_Database.getErrorCode());
+		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::CheckResetTime: database internal error: %s, %d\n"), e.what(), GetDatabase().getErrorCode());
 	}
 }
 
-// processes user database every day
-// returns 0 == database error, 1 on success
+// processes user database every day, called on the database thread
 void CUserDatabaseSQLite::OnDayTick()
 {
-	try
-	{
+	PROFILE_DB();
+	lock_guard<recursive_mutex> lock(GetMutex());
+
 #ifndef PUBLIC_RELEASE
-		// do backup
-		tm* time = g_pServerInstance->GetCurrentLocalTime();
-		m_Database.backup(va(OBFUSCATE("UserDatabase_%d_%d_%d_%d.db3"), time->tm_year + 1900, time->tm_mon, time->tm_mday, time->tm_hour), SQLite::Database::BackupType::Save);
+	// do backup, the file name is made from the server time of the event thread
+	g_Events.AddEventFunction([this]() { StartBackup(); });
 #endif
 
-		// quests
-		// reset daily/special quest progress
-		int dailyQuests = 0;
-		{
-			//SQLite::Statement query(m_Database, OBFUSCATE("UPDATE UserQuestProgress SET status = 0 WHERE questID > 0 AND questID < 2000 AND (? - (SELECT lastLogonTime FROM User)) <= 1440"));
-			//query.bind(1, g_pServerInstance->GetCurrentTime());
-			SQLite::Statement query(m_Database, OBFUSCATE("UPDATE UserQuestProgress SET status = 0 WHERE questID > 0 AND questID < 2000"));
-			dailyQuests = query.exec();
-		}
-		// reset task daily/special quest progress
-		{
-			//SQLite::Statement query(m_Database, OBFUSCATE("DELETE FROM UserQuestTaskProgress WHERE questID > 0 AND questID < 2000 AND (? - (SELECT lastLogonTime FROM User)) <= 1440"));
-			//query.bind(1, g_pServerInstance->GetCurrentTime());
-			SQLite::Statement query(m_Database, OBFUSCATE("DELETE FROM UserQuestTaskProgress WHERE questID > 0 AND questID < 2000"));
-			query.exec();
-		}
+	// reset daily/special quest and daily event quest progress
+	StartQuestReset(QUEST_RESET_DAY);
 
-		// event quests
-		// reset daily quest progress
-		int dailyEventQuests = 0;
-		{
-			// shitty condition
-			//SQLite::Statement query(m_Database, OBFUSCATE("DELETE FROM UserQuestEventProgress WHERE questID > 2000 AND questID < 4000 AND (? - (SELECT lastLogonTime FROM User)) <= 1440"));
-			//query.bind(1, g_pServerInstance->GetCurrentTime());
-			SQLite::Statement query(m_Database, OBFUSCATE("DELETE FROM UserQuestEventProgress WHERE questID > 2000 AND questID < 4000"));
-			dailyEventQuests = query.exec();
-		}
-		// reset task daily quest progress
-		{
-			//SQLite::Statement query(m_Database, OBFUSCATE("DELETE FROM UserQuestEventTaskProgress WHERE questID > 2000 AND questID < 4000 AND (? - (SELECT lastLogonTime FROM User)) <= 1440"));
-			//query.bind(1, g_pServerInstance->GetCurrentTime());
-			SQLite::Statement query(m_Database, OBFUSCATE("DELETE FROM UserQuestEventTaskProgress WHERE questID > 2000 AND questID < 4000"));
-			query.exec();
-		}
+	Logger().Warn(OBFUSCATE("CUserDatabaseSQLite::OnWeekTick: TODO: impl userdailyreward\n"));
+	/*
+	// reset daily rewards random items
+	m_Database.exec(OBFUSCATE("DELETE FROM UserDailyRewardItems"));
+	{
+		CCachedStatement query = CACHED_STATEMENT("UPDATE UserDailyReward SET day = 0 WHERE canGetReward = 1 OR day >= 7");
+		query->exec();
+	}
+	{
+		CCachedStatement query = CACHED_STATEMENT("UPDATE UserDailyReward SET canGetReward = 1");
+		query->exec();
+	}
+	// update daily reward items
+	for (auto user : g_UserManager.users)
+	{
+		UserDailyRewards dailyReward = {};
+		GetDailyRewards(user->GetID(), dailyReward);
+		g_ItemManager.UpdateDailyRewardsRandomItems(dailyReward);
+		UpdateDailyRewards(user->GetID(), dailyReward);
 
-		Logger().Info(OBFUSCATE("CUserDatabaseSQLite::OnDayTick: daily quest: %d, daily event quest: %d\n"), dailyQuests, dailyEventQuests);
+		g_PacketManager.SendItemDailyRewardsUpdate(user->GetExtendedSocket(), g_pServerConfig->dailyRewardsItems, dailyReward);
+	}*/
+}
 
-		// get affected users and send quest update
-		{
-			SQLite::Statement query(m_Database, OBFUSCATE("SELECT userID FROM UserSession WHERE (? - (SELECT lastLogonTime FROM User)) < 1440"));
-			query.bind(1, g_pServerInstance->GetCurrentTime());
-			while (query.executeStep())
-			{
-				int userID = query.getColumn(0);
-				IUser* user = g_UserManager.GetUserById(userID);
-				if (user)
-				{
-					Logger().Info(OBFUSCATE("CUserDatabaseSQLite::OnDayTick: TODO: fix user client-side quest update\n"));
+// processes user database every week, called on the database thread
+void CUserDatabaseSQLite::OnWeekTick()
+{
+	PROFILE_DB();
+	lock_guard<recursive_mutex> lock(GetMutex());
 
-					vector<UserQuestProgress> progress;
-					GetQuestsProgress(userID, progress);
-					g_PacketManager.SendQuests(user->GetExtendedSocket(), userID, g_QuestManager.GetQuests(), progress, 0xFFFF, 0, 0, 0);
-				}
-			}
-		}
+	// reset weekly quest and weekly event quest progress
+	StartQuestReset(QUEST_RESET_WEEK);
+}
 
-		Logger().Warn(OBFUSCATE("CUserDatabaseSQLite::OnWeekTick: TODO: impl userdailyreward\n"));
-		/*
-		// reset daily rewards random items
-		m_Database.exec(OBFUSCATE("DELETE FROM UserDailyRewardItems"));
-		{
-			SQLite::Statement query(m_Database, OBFUSCATE("UPDATE UserDailyReward SET day = 0 WHERE canGetReward = 1 OR day >= 7"));
-			query.exec();
-		}
-		{
-			SQLite::Statement query(m_Database, OBFUSCATE("UPDATE UserDailyReward SET canGetReward = 1"));
-			query.exec();
-		}
-		// update daily reward items
-		for (auto user : g_UserManager.users)
-		{
-			UserDailyRewards dailyReward = {};
-			GetDailyRewards(user->GetID(), dailyReward);
-			g_ItemManager.UpdateDailyRewardsRandomItems(dailyReward);
-			UpdateDailyRewards(user->GetID(), dailyReward);
+// starts quest reset from the first user. Running reset is restarted with both flags, users that are already reset are reset again.
+// The reset state is saved by CheckResetTime in the same statement as the next reset time
+void CUserDatabaseSQLite::StartQuestReset(int flag)
+{
+	m_nQuestResetFlags |= flag;
+	m_nQuestResetUserID = 0;
+	m_QuestResetStartTime = chrono::steady_clock::now();
 
-			g_PacketManager.SendItemDailyRewardsUpdate(user->GetExtendedSocket(), g_pServerConfig->dailyRewardsItems, dailyReward);
-		}*/
-	}
-	catch (exception& e)
+	Logger().Info(OBFUSCATE("CUserDatabaseSQLite::StartQuestReset: quest reset started (flags: %d)\n"), (int)m_nQuestResetFlags);
+}
+
+// resets batches of users for up to DB_QUEST_RESET_STEP_TIME ms. Called on the database thread,
+// each batch is one write transaction, so writes of the event thread wait for one batch at most
+void CUserDatabaseSQLite::QuestResetStep()
+{
+	auto start = chrono::steady_clock::now();
+	while (m_nQuestResetFlags && chrono::steady_clock::now() - start < chrono::milliseconds(DB_QUEST_RESET_STEP_TIME))
 	{
-		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::OnDayTick: database internal error: %s, %d\n"), e.what(), m_Database.getErrorCode());
+		if (!ResetQuestBatch())
+			break;
 	}
 }
 
-// processes user database every week
-// returns 0 == database error, 1 on success
-void CUserDatabaseSQLite::OnWeekTick()
+// resets quest progress of the next DB_QUEST_RESET_BATCH users and saves the position in the same transaction,
+// online users of the batch get their quest list again on the next quest request
+// returns false on database error, the batch is retried on the next second
+bool CUserDatabaseSQLite::ResetQuestBatch()
 {
+	lock_guard<recursive_mutex> lock(GetMutex());
+
+	int flags = m_nQuestResetFlags;
+	if (!flags)
+		return false;
+
+	vector<int> onlineUsers;
 	try
 	{
-		// reset week quest progress
-		{
-			// questID 1-500 = daily quests
-			// questID 500-1000 = weekly quests
-			// questID 1000-2000 = special quests
-			// questID 2000-? = honor quests
+		CWriteTransaction transaction(GetDatabase());
 
-			// TODO: affect only users who logged in last week at least once
-			SQLite::Statement query(m_Database, OBFUSCATE("UPDATE UserQuestProgress SET status = 0 WHERE questID > 500 AND questID < 1000"));
-			query.exec();
+		int firstUserID = m_nQuestResetUserID;
+		int lastUserID = 0;
+		{
+			CCachedStatement query = CACHED_STATEMENT("SELECT MAX(userID) FROM (SELECT userID FROM User WHERE userID > ? ORDER BY userID LIMIT ?)");
+			query->bind(1, firstUserID);
+			query->bind(2, DB_QUEST_RESET_BATCH);
+			if (query->executeStep() && !query->getColumn(0).isNull())
+				lastUserID = query->getColumn(0);
 		}
-		// reset task week quest progress
+
+		if (!lastUserID)
 		{
-			SQLite::Statement query(m_Database, OBFUSCATE("DELETE FROM UserQuestTaskProgress WHERE questID > 500 AND questID < 1000"));
-			query.exec();
+			// all users are reset
+			CCachedStatement query = CACHED_STATEMENT("UPDATE TimeConfig SET resetFlags = 0, resetUserID = 0");
+			query->exec();
+
+			transaction.Commit();
+
+			m_nQuestResetFlags = 0;
+			m_nQuestResetUserID = 0;
+
+			Logger().Info(OBFUSCATE("CUserDatabaseSQLite::ResetQuestBatch: quest reset (flags: %d) finished in %d ms\n"), flags,
+				(int)chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now() - m_QuestResetStartTime).count());
+			return true;
 		}
 
+		// questID 1-500 = daily quests
+		// questID 500-1000 = weekly quests
+		// questID 1000-2000 = special quests
+		// questID 2000-? = honor quests
 		// event quests
 		// questID 0-2000 = non resetable quests
 		// questID 2000-4000 = daily quests
 		// questID 4000-6000 = weekly quests
-		// reset week quest progress
-		{
-			SQLite::Statement query(m_Database, OBFUSCATE("DELETE FROM UserQuestEventProgress WHERE questID > 4000 AND questID < 6000"));
-			query.exec();
-		}
-		// reset task week quest progress
+		if (flags & QUEST_RESET_DAY)
 		{
-			SQLite::Statement query(m_Database, OBFUSCATE("DELETE FROM UserQuestEventTaskProgress WHERE questID > 4000 AND questID < 6000"));
-			query.exec();
+			{
+				CCachedStatement query = CACHED_STATEMENT("UPDATE UserQuestProgress SET status = 0 WHERE userID > ? AND userID <= ? AND questID > 0 AND questID < 2000");
+				query->bind(1, firstUserID);
+				query->bind(2, lastUserID);
+				query->exec();
+			}
+			{
+				CCachedStatement query = CACHED_STATEMENT("DELETE FROM UserQuestTaskProgress WHERE userID > ? AND userID <= ? AND questID > 0 AND questID < 2000");
+				query->bind(1, firstUserID);
+				query->bind(2, lastUserID);
+				query->exec();
+			}
+			{
+				CCachedStatement query = CACHED_STATEMENT("DELETE FROM UserQuestEventProgress WHERE userID > ? AND userID <= ? AND questID > 2000 AND questID < 4000");
+				query->bind(1, firstUserID);
+				query->bind(2, lastUserID);
+				query->exec();
+			}
+			{
+				CCachedStatement query = CACHED_STATEMENT("DELETE FROM UserQuestEventTaskProgress WHERE userID > ? AND userID <= ? AND questID > 2000 AND questID < 4000");
+				query->bind(1, firstUserID);
+				query->bind(2, lastUserID);
+				query->exec();
+			}
 		}
 
-		// get affected users and send quest update
+		if (flags & QUEST_RESET_WEEK)
 		{
-			SQLite::Statement query(m_Database, OBFUSCATE("SELECT userID FROM UserSession WHERE (? - (SELECT lastLogonTime FROM User)) <= 10080"));
-			query.bind(1, g_pServerInstance->GetCurrentTime());
-			while (query.executeStep())
 			{
-				int userID = query.getColumn(0);
-				IUser* user = g_UserManager.GetUserById(userID);
-				if (user)
-				{
-					Logger().Warn(OBFUSCATE("CUserDatabaseSQLite::OnWeekTick: TODO: fix user client-side quest update\n"));
+				CCachedStatement query = CACHED_STATEMENT("UPDATE UserQuestProgress SET status = 0 WHERE userID > ? AND userID <= ? AND questID > 500 AND questID < 1000");
+				query->bind(1, firstUserID);
+				query->bind(2, lastUserID);
+				query->exec();
+			}
+			{
+				CCachedStatement query = CACHED_STATEMENT("DELETE FROM UserQuestTaskProgress WHERE userID > ? AND userID <= ? AND questID > 500 AND questID < 1000");
+				query->bind(1, firstUserID);
+				query->bind(2, lastUserID);
+				query->exec();
+			}
+			{
+				CCachedStatement query = CACHED_STATEMENT("DELETE FROM UserQuestEventProgress WHERE userID > ? AND userID <= ? AND questID > 4000 AND questID < 6000");
+				query->bind(1, firstUserID);
+				query->bind(2, lastUserID);
+				query->exec();
+			}
+			{
+				CCachedStatement query = CACHED_STATEMENT("DELETE FROM UserQuestEventTaskProgress WHERE userID > ? AND userID <= ? AND questID > 4000 AND questID < 6000");
+				query->bind(1, firstUserID);
+				query->bind(2, lastUserID);
+				query->exec();
+			}
+		}
 
-					vector<UserQuestProgress> progress;
-					GetQuestsProgress(userID, progress);
-					g_PacketManager.SendQuests(user->GetExtendedSocket(), userID, g_QuestManager.GetQuests(), progress, 0xFFFF, 0xFFFF, 0, 0);
+		{
+			CCachedStatement query = CACHED_STATEMENT("SELECT userID FROM UserSession WHERE userID > ? AND userID <= ?");
+			query->bind(1, firstUserID);
+			query->bind(2, lastUserID);
+			while (query->executeStep())
+				onlineUsers.push_back(query->getColumn(0));
+		}
 
-					/*vector<Quest_s> quests;
-					vector<UserQuestProgress> questsProgress;
-					SQLite::Statement query(m_Database, OBFUSCATE("SELECT questID FROM UserQuestProgress WHERE questID > 500 AND questID < 1000 AND userID = ?"));
-					query.bind(1, userID);
-					while (query.executeStep())
-					{
-					UserQuestProgress progress;
-					progress.questID = query.getColumn(0);
-					progress.status = 0;
-					questsProgress.push_back(progress);
-
-					Quest_s quest;
-					quest.id = progress.questID;
-					quests.push_back(quest);
-					}
-					g_PacketManager.SendQuests(user->GetExtendedSocket(), userID, quests, questsProgress, 0x20, 0, 0, 0);*/
-				}
-			}
+		{
+			CCachedStatement query = CACHED_STATEMENT("UPDATE TimeConfig SET resetUserID = ?");
+			query->bind(1, lastUserID);
+			query->exec();
 		}
+
+		transaction.Commit();
+
+		m_nQuestResetUserID = lastUserID;
 	}
 	catch (exception& e)
 	{
-		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::OnWeekTick: database internal error: %s, %d\n"), e.what(), m_Database.getErrorCode());
+		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::ResetQuestBatch: database internal error: %s, %d\n"), e.what(), GetDatabase().getErrorCode());
+		return false;
 	}
+
+	if (!onlineUsers.empty())
+		g_Events.AddEventFunction([onlineUsers]() { g_QuestManager.OnQuestsReset(onlineUsers); });
+
+	return true;
 }
 
 map<int, UserBan> CUserDatabaseSQLite::GetUserBanList()
 {
+	PROFILE_DB();
+	lock_guard<recursive_mutex> lock(GetMutex());
+
 	map<int, UserBan> banList;
 	try
 	{
-		SQLite::Statement statement(m_Database, OBFUSCATE("SELECT * FROM UserBan"));
-		while (statement.executeStep())
+		CCachedStatement statement = CACHED_STATEMENT("SELECT * FROM UserBan");
+		while (statement->executeStep())
 		{
 			UserBan ban;
-			ban.banType = statement.getColumn(1);
-			string reason = statement.getColumn(2);
+			ban.banType = statement->getColumn(1);
+			string reason = statement->getColumn(2);
 			ban.reason = reason;
-			ban.term = statement.getColumn(3);
+			ban.term = statement->getColumn(3);
 
-			banList.insert(pair<int, UserBan>(statement.getColumn(0), ban));
+			banList.insert(pair<int, UserBan>(statement->getColumn(0), ban));
 		}
 	}
 	catch (exception& e)
 	{
-		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::GetUserBanList: database internal error: %s, %d\n"), e.what(), m_Database.getErrorCode());
+		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::GetUserBanList: database internal error: %s, %d\n"), e.what(), GetDatabase().getErrorCode());
 		return banList;
 	}
 
@@ -6128,12 +7699,15 @@ map<int, UserBan> CUserDatabaseSQLite::GetUserBanList()
 
 vector<int> CUserDatabaseSQLite::GetUsers(int lastLoginTime)
 {
+	PROFILE_DB();
+	lock_guard<recursive_mutex> lock(GetMutex());
+
 	vector<int> users;
 	try
 	{
 		string query = OBFUSCATE("SELECT userID FROM User");
 
-		SQLite::Statement statement(m_Database, query);
+		SQLite::Statement statement(GetDatabase(), query);
 		while (statement.executeStep())
 		{
 			users.push_back(statement.getColumn(0));
@@ -6141,7 +7715,7 @@ vector<int> CUserDatabaseSQLite::GetUsers(int lastLoginTime)
 	}
 	catch (exception& e)
 	{
-		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::GetUsers: database internal error: %s, %d\n"), e.what(), m_Database.getErrorCode());
+		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::GetUsers: database internal error: %s, %d\n"), e.what(), GetDatabase().getErrorCode());
 		return users;
 	}
 
@@ -6150,91 +7724,101 @@ vector<int> CUserDatabaseSQLite::GetUsers(int lastLoginTime)
 
 int CUserDatabaseSQLite::UpdateIPBanList(const string& ip, bool remove)
 {
+	PROFILE_DB();
+	lock_guard<recursive_mutex> lock(GetMutex());
+
 	try
 	{
 		if (remove)
 		{
-			SQLite::Statement query(m_Database, OBFUSCATE("DELETE FROM IPBanList WHERE ip = ?"));
-			query.bind(1, ip);
-			query.exec();
+			CCachedStatement query = CACHED_STATEMENT("DELETE FROM IPBanList WHERE ip = ?");
+			query->bind(1, ip);
+			query->exec();
 		}
 		else
 		{
-			SQLite::Statement query(m_Database, OBFUSCATE("INSERT or IGNORE INTO IPBanList VALUES (?)"));
-			query.bind(1, ip);
-			query.exec();
+			CCachedStatement query = CACHED_STATEMENT("INSERT or IGNORE INTO IPBanList VALUES (?)");
+			query->bind(1, ip);
+			query->exec();
 		}
+
+		lock_guard<mutex> lockBanList(m_IPBanMutex);
+		if (remove)
+			m_IPBanList.erase(ip);
+		else
+			m_IPBanList.insert(ip);
 	}
 	catch (exception& e)
 	{
-		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::UpdateIPBanList: database internal error: %s, %d\n"), e.what(), m_Database.getErrorCode());
+		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::UpdateIPBanList: database internal error: %s, %d\n"), e.what(), GetDatabase().getErrorCode());
 		return 0;
 	}
 
 	return 1;
 }
 
+// loads IP ban list to memory, the copy is updated by UpdateIPBanList
+void CUserDatabaseSQLite::LoadIPBanList()
+{
+	vector<string> banList = GetIPBanList();
+
+	lock_guard<mutex> lock(m_IPBanMutex);
+	m_IPBanList = unordered_set<string>(banList.begin(), banList.end());
+}
+
 vector<string> CUserDatabaseSQLite::GetIPBanList()
 {
+	PROFILE_DB();
+	lock_guard<recursive_mutex> lock(GetMutex());
+
 	vector<string> ip;
 	try
 	{
-		SQLite::Statement statement(m_Database, OBFUSCATE("SELECT ip FROM IPBanList"));
-		while (statement.executeStep())
+		CCachedStatement statement = CACHED_STATEMENT("SELECT ip FROM IPBanList");
+		while (statement->executeStep())
 		{
-			ip.push_back(statement.getColumn(0));
+			ip.push_back(statement->getColumn(0));
 		}
 	}
 	catch (exception& e)
 	{
-		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::GetIPBanList: database internal error: %s, %d\n"), e.what(), m_Database.getErrorCode());
+		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::GetIPBanList: database internal error: %s, %d\n"), e.what(), GetDatabase().getErrorCode());
 		return ip;
 	}
 
 	return ip;
 }
 
+// checks the in-memory copy of the IP ban list, called by I/O workers on connect, so the database isn't touched
 bool CUserDatabaseSQLite::IsIPBanned(const string& ip)
 {
-	try
-	{
-		SQLite::Statement query(m_Database, OBFUSCATE("SELECT NOT EXISTS(SELECT 1 FROM IPBanList WHERE ip = ? LIMIT 1)"));
-		query.bind(1, ip);
-		if (query.executeStep())
-		{
-			if ((int)query.getColumn(0))
-				return false;
-		}
-	}
-	catch (exception& e)
-	{
-		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::IsIPBanned: database internal error: %s, %d\n"), e.what(), m_Database.getErrorCode());
-		return false;
-	}
-
-	return true;
+	lock_guard<mutex> lock(m_IPBanMutex);
+	return m_IPBanList.count(ip) != 0;
 }
 
 int CUserDatabaseSQLite::UpdateHWIDBanList(const vector<unsigned char>& hwid, bool remove)
 {
+	PROFILE_DB();
+	lock_guard<recursive_mutex> lock(GetMutex());
+
 	try
 	{
 		if (remove)
 		{
-			SQLite::Statement query(m_Database, OBFUSCATE("DELETE FROM HWIDBanList WHERE hwid = ?"));
-			query.bind(1, hwid.data(), hwid.size());
-			query.exec();
+			CCachedStatement query = CACHED_STATEMENT("DELETE FROM HWIDBanList WHERE hwid = ?");
+			query->bind(1, hwid.data(), hwid.size());
+			query->exec();
 		}
 		else
 		{
-			SQLite::Statement query(m_Database, OBFUSCATE("INSERT or IGNORE INTO HWIDBanList VALUES (?)"));
-			query.bind(1, hwid.data(), hwid.size());
-			query.exec();
+			CCachedStatement query = CACHED_STATEMENT("INSERT or IGNORE INTO HWIDBanList VALUES (?)");
+			query->bind(1, hwid.data(), hwid.size());
+			query->exec();
 		}
 	}
 	catch (exception& e)
 	{
-		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::UpdateHWIDBanList: database internal error: %s, %d\n"), e.what(), m_Database.getErrorCode());
+		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::UpdateHWIDBanList: database internal error: %s, %d\n"), e.what(), GetDatabase().getErrorCode());
 		return 0;
 	}
 
@@ -6243,21 +7827,24 @@ int CUserDatabaseSQLite::UpdateHWIDBanList(const vector<unsigned char>& hwid, bo
 
 vector<vector<unsigned char>> CUserDatabaseSQLite::GetHWIDBanList()
 {
+	PROFILE_DB();
+	lock_guard<recursive_mutex> lock(GetMutex());
+
 	vector<vector<unsigned char>> hwidList;
 	try
 	{
-		SQLite::Statement statement(m_Database, OBFUSCATE("SELECT hwid FROM HWIDBanList"));
-		while (statement.executeStep())
+		CCachedStatement statement = CACHED_STATEMENT("SELECT hwid FROM HWIDBanList");
+		while (statement->executeStep())
 		{
 			vector<unsigned char> hwid;
-			SQLite::Column lastHWID = statement.getColumn(0);
+			SQLite::Column lastHWID = statement->getColumn(0);
 			hwid.assign((unsigned char*)lastHWID.getBlob(), (unsigned char*)lastHWID.getBlob() + lastHWID.getBytes());
 			hwidList.push_back(hwid);
 		}
 	}
 	catch (exception& e)
 	{
-		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::GetHWIDBanList: database internal error: %s, %d\n"), e.what(), m_Database.getErrorCode());
+		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::GetHWIDBanList: database internal error: %s, %d\n"), e.what(), GetDatabase().getErrorCode());
 		return hwidList;
 	}
 
@@ -6266,38 +7853,65 @@ vector<vector<unsigned char>> CUserDatabaseSQLite::GetHWIDBanList()
 
 bool CUserDatabaseSQLite::IsHWIDBanned(vector<unsigned char>& hwid)
 {
+	PROFILE_DB();
+	lock_guard<recursive_mutex> lock(GetMutex());
+
 	try
 	{
-		SQLite::Statement statement(m_Database, OBFUSCATE("SELECT NOT EXISTS(SELECT 1 FROM HWIDBanList WHERE hwid = ? LIMIT 1)"));
-		statement.bind(1, hwid.data(), hwid.size());
-		if (statement.executeStep())
+		CCachedStatement statement = CACHED_STATEMENT("SELECT NOT EXISTS(SELECT 1 FROM HWIDBanList WHERE hwid = ? LIMIT 1)");
+		statement->bind(1, hwid.data(), hwid.size());
+		if (statement->executeStep())
 		{
-			if ((int)statement.getColumn(0))
+			if ((int)statement->getColumn(0))
 				return false;
 		}
 	}
 	catch (exception& e)
 	{
-		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::IsHWIDBanned: database internal error: %s, %d\n"), e.what(), m_Database.getErrorCode());
+		Logger().Error(OBFUSCATE("CUserDatabaseSQLite::IsHWIDBanned: database internal error: %s, %d\n"), e.what(), GetDatabase().getErrorCode());
 		return false;
 	}
 
 	return true;
 }
 
+// the database stays locked for the calling thread until CommitTransaction
 void CUserDatabaseSQLite::CreateTransaction()
 {
+	PROFILE_DB();
+	m_Mutex.lock();
+
 	if (!m_pTransaction)
 	{
-		m_pTransaction = new SQLite::Transaction(m_Database);
+		try
+		{
+			m_pTransaction = new CWriteTransaction(m_Database);
+		}
+		catch (exception& e)
+		{
+			// the writes are made without transaction, CommitTransaction reports the failure
+			Logger().Error(OBFUSCATE("CUserDatabaseSQLite::CreateTransaction: database internal error: %s, %d\n"), e.what(), m_Database.getErrorCode());
+		}
+	}
+	else
+	{
+		// nested call, the lock is already held
+		m_Mutex.unlock();
 	}
 }
 
 bool CUserDatabaseSQLite::CommitTransaction()
 {
+	PROFILE_DB();
+	if (!m_pTransaction)
+	{
+		m_Mutex.unlock();
+		return false;
+	}
+
 	try
 	{
-		m_pTransaction->commit();
+		m_pTransaction->Commit();
 	}
 	catch (exception& e)
 	{
@@ -6306,11 +7920,18 @@ bool CUserDatabaseSQLite::CommitTransaction()
 		delete m_pTransaction;
 		m_pTransaction = NULL;
 
+		m_Mutex.unlock();
+
 		return false;
 	}
 
 	delete m_pTransaction;
 	m_pTransaction = NULL;
 
+	// inventory rows written without the inventory cache are visible to other connections now
+	m_nInventoryVersion++;
+
+	m_Mutex.unlock();
+
 	return true;
 }
\ No newline at end of file
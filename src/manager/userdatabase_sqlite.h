@@ -2,8 +2,19 @@
 #pragma once
 
 #include <SQLiteCpp/SQLiteCpp.h>
+#include <unordered_map>
+#include <set>
+#include <unordered_set>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <chrono>
 #include "manager.h"
 #include "interface/iuserdatabase.h"
+#include "common/timerwheel.h"
+#include "common/profiler.h"
+
+struct sqlite3_backup;
 
 class IUser;
 class CUserInventory;
@@ -16,8 +27,123 @@ struct RewardItem;
 struct UserQuestProgress;
 class CClan;
 
+struct CachedStatement_s
+{
+	SQLite::Statement* statement; // NULL if not prepared yet
+	unsigned long long executions;
+	bool inUse;
+	bool write; // not a SELECT, changed rows are counted by the profiler
+};
+
+/**
+ * Statement taken from the statement cache, it is reset and its bindings are cleared when the object goes out of scope.
+ * If the cached statement is already in use (the same call site is reached again while the statement is stepping),
+ * a temporary statement is prepared instead
+ */
+class CCachedStatement
+{
+public:
+	CCachedStatement(SQLite::Database& database, CachedStatement_s& cached, const char* sql);
+	~CCachedStatement();
+
+	CCachedStatement(const CCachedStatement&) = delete;
+	CCachedStatement& operator=(const CCachedStatement&) = delete;
+
+	SQLite::Statement* operator->()
+	{
+		return m_pStatement;
+	}
+
+private:
+	CachedStatement_s& m_Cached;
+	SQLite::Statement* m_pStatement;
+	sqlite3* m_pDatabase;
+	int m_nTotalChanges; // changes of the connection when the statement was taken, -1 for SELECT
+};
+
+#define DB_READ_CONNECTIONS 2 // read-only connections for heavy queries
+#define DB_BUSY_TIMEOUT 5000 // max time (ms) a write waits for the write lock of the other thread's connection
+#define DB_WAL_SIZE_LIMIT (64 * 1024 * 1024) // WAL file is truncated to this size after checkpoint
+#define DB_BACKUP_STEP_PAGES 64 // pages copied by one sqlite3_backup_step call
+#define DB_BACKUP_STEP_TIME 50 // max time (ms) the database thread spends on backup every second
+#define DB_BACKUP_RETENTION 7 // number of kept backup files, older ones are deleted
+#define DB_QUEST_RESET_BATCH 256 // users reset by one quest reset transaction
+#define DB_QUEST_RESET_STEP_TIME 50 // max time (ms) the database thread spends on quest reset every second
+
+enum QuestResetFlag
+{
+	QUEST_RESET_DAY = 1,
+	QUEST_RESET_WEEK = 2,
+};
+
+enum ExpiryTimerType
+{
+	EXPIRY_TIMER_INVENTORY = 0,
+	EXPIRY_TIMER_CLAN_STORAGE,
+};
+
+struct ExpiryTimer_s
+{
+	int type;
+	int id; // userID or clanID
+	int pageID; // clan storage page
+	int slot;
+};
+
+/**
+ * Transaction that takes the write lock when it begins (BEGIN IMMEDIATE). The event thread and the database thread write through
+ * their own connections, a deferred transaction that reads first would fail with SQLITE_BUSY instead of waiting for the other one.
+ * Rolled back when the object goes out of scope without Commit
+ */
+class CWriteTransaction
+{
+public:
+	CWriteTransaction(SQLite::Database& database);
+	~CWriteTransaction();
+
+	CWriteTransaction(const CWriteTransaction&) = delete;
+	CWriteTransaction& operator=(const CWriteTransaction&) = delete;
+
+	void Commit();
+
+private:
+	SQLite::Database& m_Database;
+	bool m_bCommitted;
+};
+
+struct ReadConnection_s
+{
+	SQLite::Database* database;
+	std::unordered_map<int, CachedStatement_s> statements; // key is call site
+};
+
+class CUserDatabaseSQLite;
+
+/**
+ * Connection taken from the read-only pool, it is returned to the pool when the object goes out of scope.
+ * Readers see the last committed data and don't wait for the main connection. If the pool is empty
+ * (WAL is not available), the main connection is locked and used instead
+ */
+class CReadConnection
+{
+public:
+	CReadConnection(CUserDatabaseSQLite& userDatabase);
+	~CReadConnection();
+
+	CReadConnection(const CReadConnection&) = delete;
+	CReadConnection& operator=(const CReadConnection&) = delete;
+
+	CCachedStatement GetStatement(int callSite, const char* sql);
+
+private:
+	CUserDatabaseSQLite& m_UserDatabase;
+	ReadConnection_s* m_pConnection;
+};
+
 class CUserDatabaseSQLite : public CBaseManager<IUserDatabase>
 {
+	friend class CReadConnection;
+
 public:
 	CUserDatabaseSQLite();
 	~CUserDatabaseSQLite();
@@ -26,7 +152,8 @@ public:
 
 	bool ExecuteScript(std::string scriptPath);
 
-	int Login(const std::string& userName, const std::string& password, IExtendedSocket* socket, UserBan& ban, UserRestoreData* restoreData);
+	int Login(const std::string& userName, const std::string& password, UserBan& ban, UserRestoreData* restoreData);
+	int CreateSession(int userID, const std::string& ip, const std::vector<unsigned char>& hwid);
 	int AddToRestoreList(int userID, int channelServerID, int channelID);
 	int Register(const std::string& userName, const std::string& password, const std::string& ip);
 	int GetUserSessions(std::vector<UserSession>& sessions);
@@ -46,6 +173,11 @@ public:
 	int GetFirstExtendableItemByItemID(int userID, int itemID, CUserInventoryItem& item);
 	int GetInventoryItemsCount(int userID);
 	int IsInventoryFull(int userID);
+	int ReadInventory(int userID, std::vector<CUserInventoryItem>& items, int& nextSlot, unsigned int& version);
+	int CacheInventory(int userID, const std::vector<CUserInventoryItem>& items, int nextSlot, unsigned int version);
+	int FlushInventory(int userID);
+	void OnInventoryFlushed(int userID, bool committed);
+	void UnloadInventory(int userID);
 	int GetUserData(int userID, CUserData& data);
 	int UpdateUserData(int userID, CUserData data);
 	int CreateCharacter(int userID, const std::string& gameName);
@@ -137,7 +269,7 @@ public:
 	int ClanRejectAll(int userID);
 	int ClanApprove(int userID, const std::string& userName);
 	int IsClanWithMarkExists(int markID);
-	int ClanInvite(int userID, const std::string& gameName, IUser*& destUser, int& clanID);
+	int ClanInvite(int userID, int destUserID, int& clanID);
 	int ClanKick(int userID, const std::string& userName);
 	int ClanMasterDelegate(int userID, const std::string& userName);
 	int IsClanExists(const std::string& clanName);
@@ -156,6 +288,7 @@ public:
 	int SuspectAddAction(const std::vector<unsigned char>& hwid, int actionID);
 	int IsUserSuspect(int userID);
 
+	virtual void OnSecondTick(time_t curTime);
 	virtual void OnMinuteTick(time_t curTime);
 	void OnDayTick();
 	void OnWeekTick();
@@ -174,9 +307,14 @@ public:
 	void PrintUserList();
 
 	void LoadBackup(const std::string& backupDate);
+	void StartBackup();
 	void PrintBackupList();
 	void ResetQuestEvent(int questID);
 
+	void RecordStatements(bool record);
+	int AuditQueryPlans();
+	void PrintStatementStats(int count);
+
 	void WriteUserStatistic(const std::string& fdate, const std::string& sdate);
 
 	void CreateTransaction();
@@ -186,10 +324,82 @@ private:
 	bool CheckForTables();
 	bool UpgradeDatabase(int& currentDatabaseVer);
 	bool ExecuteOnce();
+	void ConfigureConnection(SQLite::Database& database);
+	void OpenAsyncConnection();
+	SQLite::Database& GetDatabase();
+	std::recursive_mutex& GetMutex();
+	CUserInventory* GetCachedInventory(int userID);
+	CCachedStatement GetStatement(int callSite, const char* sql);
+	CCachedStatement GetStatement(const std::string& sql);
+	void ClearStatementCache();
+	void OpenReadConnections();
+	void CloseReadConnections();
+	void Checkpoint();
+	void LoadExpiryTimers(time_t curTime);
+	void LoadIPBanList();
+	void ScheduleItemExpiry(int userID, const CUserInventoryItem& item);
+	void ScheduleItemExpiry(int userID, int slot);
+	void ExpireInventoryItem(int userID, int slot, time_t curTime);
+	void ExpireClanStorageItem(int clanID, int pageID, int slot, time_t curTime);
+	void BeginBackup(const std::string& fileName);
+	void BackupStep();
+	void EndBackup(bool success);
+	void RotateBackups();
+	time_t GetNextResetTime(time_t curTime, int days);
+	void CheckResetTime(time_t curTime);
+	void StartQuestReset(int flag);
+	void QuestResetStep();
+	bool ResetQuestBatch();
+	void GetBackupFiles(std::vector<std::pair<std::string, time_t>>& files);
+	bool GetFullScans(const std::string& statement, std::vector<std::string>& scans);
+	static int OnStatementTrace(unsigned int type, void* context, void* p, void* x);
 
-	SQLite::Database m_Database;
-	SQLite::Transaction* m_pTransaction;
+	SQLite::Database m_Database; // main connection, used by the event thread
+	CWriteTransaction* m_pTransaction;
+	std::recursive_mutex m_Mutex; // protects the main connection, held from CreateTransaction to CommitTransaction
 	bool m_bInited;
+	std::unordered_map<int, CachedStatement_s> m_Statements; // statements with constant SQL, key is call site
+	std::unordered_map<std::string, CachedStatement_s> m_QueryStatements; // statements with SQL built from flags, key is SQL
+	std::unordered_map<int, CUserInventory*> m_Inventories; // inventories of online users, userID -> inventory, used only by the event thread
+	std::atomic<unsigned int> m_nInventoryVersion; // changed by writes that bypass m_Inventories, inventory rows read before the change are outdated
+	std::set<std::string> m_RecordedStatements; // statements executed while recording is enabled, checked by AuditQueryPlans
+	CTimerWheel<ExpiryTimer_s> m_ExpiryTimers; // expiry of in use inventory items and clan storage items, timers may be outdated
+	std::unordered_set<std::string> m_IPBanList; // copy of IPBanList table, checked by I/O workers on connect
+	std::mutex m_IPBanMutex;
+
+	// read-only connection pool, filled only in WAL mode
+	std::vector<ReadConnection_s*> m_ReadConnections;
+	std::vector<ReadConnection_s*> m_FreeReadConnections;
+	std::mutex m_ReadMutex;
+	std::condition_variable m_ReadCondition;
+
+	SQLite::Database* m_pCheckpointDatabase; // used by Checkpoint on the database thread
+	bool m_bWAL;
+
+	// connection of the database thread, so jobs and the event thread don't wait for each other's queries. NULL if it failed to open,
+	// jobs use the main connection then
+	SQLite::Database* m_pAsyncDatabase;
+	std::unordered_map<int, CachedStatement_s> m_AsyncStatements;
+	std::unordered_map<std::string, CachedStatement_s> m_AsyncQueryStatements;
+	std::recursive_mutex m_AsyncMutex; // locked only by the database thread, taken where the main connection takes m_Mutex
+
+	// online backup, used only on the database thread
+	SQLite::Database* m_pBackupSource;
+	sqlite3* m_pBackupDest;
+	sqlite3_backup* m_pBackup;
+	std::string m_BackupFileName;
+	time_t m_BackupStartTime;
+	int m_nBackupProgress; // last logged percent
+	std::atomic<bool> m_bBackupRunning;
+	std::atomic<bool> m_bBackupStepQueued;
+
+	// daily/weekly quest reset, started and run on the database thread in batches of users, the position is saved in TimeConfig
+	std::atomic<int> m_nQuestResetFlags; // QUEST_RESET_*
+	int m_nQuestResetUserID; // last reset userID
+	std::chrono::steady_clock::time_point m_QuestResetStartTime;
+	std::atomic<bool> m_bQuestResetStepQueued;
 };
 
-#endif
\ No newline at end of file
+#endif
+
+extern CProfiler g_UserDatabaseProfiler;
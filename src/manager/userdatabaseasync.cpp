@@ -0,0 +1,115 @@
+#include "userdatabaseasync.h"
+
+#include "common/logger.h"
+
+using namespace std;
+
+CUserDatabaseAsync g_UserDatabaseAsync;
+
+static void* DatabaseThread(void* data)
+{
+	((CUserDatabaseAsync*)data)->Run();
+	return NULL;
+}
+
+CUserDatabaseAsync::CUserDatabaseAsync() : CBaseManager("UserDatabaseAsync"), m_Thread(DatabaseThread, this)
+{
+	m_bRunning = false;
+
+	SetCanReload(false);
+}
+
+CUserDatabaseAsync::~CUserDatabaseAsync()
+{
+	Shutdown();
+}
+
+bool CUserDatabaseAsync::Init()
+{
+	if (m_bRunning)
+		return true;
+
+	m_bRunning = true;
+	if (!m_Thread.Start())
+	{
+		m_bRunning = false;
+
+		Logger().Error("CUserDatabaseAsync::Init: failed to start database thread\n");
+		return false;
+	}
+
+	return true;
+}
+
+/**
+ * Executes queued jobs and stops the database thread. Callbacks of the last jobs are left in the event queue
+ */
+void CUserDatabaseAsync::Shutdown()
+{
+	if (!m_bRunning)
+		return;
+
+	m_Mutex.Enter();
+	m_bRunning = false;
+	m_Mutex.Leave();
+
+	m_Signal.Signal();
+	m_Thread.Join();
+}
+
+/**
+ * Queues job for the database thread. The job is executed right away if the thread is not running (before Init, after Shutdown)
+ */
+void CUserDatabaseAsync::AddJob(const function<void()>& job)
+{
+	m_Mutex.Enter();
+
+	if (!m_bRunning)
+	{
+		m_Mutex.Leave();
+
+		job();
+		return;
+	}
+
+	m_Jobs.push_back(job);
+
+	m_Mutex.Leave();
+
+	m_Signal.Signal();
+}
+
+bool CUserDatabaseAsync::IsDatabaseThread()
+{
+	return m_Thread.IsCurrentThreadSame();
+}
+
+/**
+ * Database thread loop. Runs until Shutdown is called and the queue is empty
+ */
+void CUserDatabaseAsync::Run()
+{
+	while (true)
+	{
+		m_Mutex.Enter();
+
+		if (m_Jobs.empty())
+		{
+			bool running = m_bRunning;
+			m_Mutex.Leave();
+
+			if (!running)
+				break;
+
+			m_Signal.WaitForSignal();
+			continue;
+		}
+
+		function<void()> job = move(m_Jobs.front());
+		m_Jobs.pop_front();
+
+		m_Mutex.Leave();
+
+		job();
+	}
+}
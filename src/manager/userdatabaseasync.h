@@ -0,0 +1,68 @@
+#pragma once
+
+#include "interface/iuserdatabaseasync.h"
+#include "manager/manager.h"
+
+#include "common/thread.h"
+#include "event.h"
+
+#include <deque>
+#include <atomic>
+#include <type_traits>
+
+extern CEvents g_Events;
+
+/**
+ * Database thread. Jobs call g_UserDatabase off the event thread, so a slow query doesn't stall packet handling,
+ * their results come back to the event thread as events. Jobs must only use the database, everything else
+ * (users, sockets, packets) belongs in the callback. Sockets may disconnect while the job runs, callbacks find them again by ID.
+ * The user database gives this thread its own SQLite connection, jobs don't wait for queries of the event thread
+ */
+class CUserDatabaseAsync : public CBaseManager<IUserDatabaseAsync>
+{
+public:
+	CUserDatabaseAsync();
+	~CUserDatabaseAsync();
+
+	virtual bool Init();
+	virtual void Shutdown();
+
+	virtual void AddJob(const std::function<void()>& job);
+	virtual bool IsDatabaseThread();
+
+	void Run();
+
+	/**
+	 * Runs job on the database thread and then callback with the job result on the event thread
+	 * @param job Function that returns a copyable result or void
+	 * @param callback Function that takes the result, or no arguments if job returns void
+	 */
+	template <typename Job, typename Callback>
+	void Execute(const Job& job, const Callback& callback)
+	{
+		AddJob([job, callback]()
+		{
+			if constexpr (std::is_void_v<decltype(job())>)
+			{
+				job();
+				g_Events.AddEventFunction(callback);
+			}
+			else
+			{
+				auto result = job();
+				g_Events.AddEventFunction([callback, result]() { callback(result); });
+			}
+		});
+	}
+
+private:
+	CThread m_Thread;
+	CObjectSync m_Signal;
+
+	// protects the job queue
+	CCriticalSection m_Mutex;
+	std::deque<std::function<void()>> m_Jobs;
+	std::atomic<bool> m_bRunning;
+};
+
+extern CUserDatabaseAsync g_UserDatabaseAsync;
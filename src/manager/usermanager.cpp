@@ -1,6 +1,7 @@
 #include "usermanager.h"
 #include "channelmanager.h"
 #include "userdatabase.h"
+#include "userdatabaseasync.h"
 #include "itemmanager.h"
 #include "packetmanager.h"
 #include "shopmanager.h"
@@ -24,7 +25,7 @@ using namespace std;
 
 CUserManager g_UserManager;
 
-CUserManager::CUserManager() : CBaseManager("UserManager", true)
+CUserManager::CUserManager() : CBaseManager("UserManager", true, true)
 {
 }
 
@@ -48,6 +49,8 @@ bool CUserManager::Init()
 
 void CUserManager::Shutdown()
 {
+	FlushUserCache();
+
 	m_DefaultItems.clear();
 	m_ZombieWarWeaponList.clear();
 	m_RandomWeaponList.clear();
@@ -173,7 +176,7 @@ bool CUserManager::OnUdpPacket(CReceivePacket* msg, IExtendedSocket* socket)
 {
 	LOG_PACKET;
 
-	IUser* user = GetUserBySocket(socket);
+	IUser* user = socket->GetUser();
 	if (user == NULL)
 		return false;
 
@@ -259,7 +262,7 @@ bool CUserManager::OnOptionPacket(CReceivePacket* msg, IExtendedSocket* socket)
 {
 	LOG_PACKET;
 
-	IUser* user = GetUserBySocket(socket);
+	IUser* user = socket->GetUser();
 	if (user == NULL)
 		return false;
 
@@ -271,7 +274,7 @@ bool CUserManager::OnOptionPacket(CReceivePacket* msg, IExtendedSocket* socket)
 		CUserCharacterExtended character(EXT_UFLAG_CONFIG);
 		character.config = msg->ReadArray(msg->ReadUInt16());
 
-		g_UserDatabase.UpdateCharacterExtended(user->GetID(), character);
+		user->UpdateCharacterExtended(character);
 		break;
 	}
 	case 2: // called when joining the game
@@ -288,7 +291,7 @@ bool CUserManager::OnVersionPacket(CReceivePacket* msg, IExtendedSocket* socket)
 {
 	LOG_PACKET;
 
-	if (!GetUserBySocket(socket))
+	if (!socket->GetUser())
 	{
 		int launcherVersion = msg->ReadUInt8();  // const 67
 		int gameVersion = msg->ReadUInt16(); // const 26
@@ -336,7 +339,7 @@ bool CUserManager::OnFavoritePacket(CReceivePacket* msg, IExtendedSocket* socket
 {
 	LOG_PACKET;
 
-	IUser* user = GetUserBySocket(socket);
+	IUser* user = socket->GetUser();
 	if (user == NULL)
 		return false;
 
@@ -428,7 +431,7 @@ bool CUserManager::OnFavoriteSetLoadout(CReceivePacket* msg, IUser* user)
 		// change current loadout
 		character.flag = EXT_UFLAG_CURLOADOUT;
 		character.curLoadout = loadoutID;
-		g_UserDatabase.UpdateCharacterExtended(user->GetID(), character);
+		user->UpdateCharacterExtended(character);
 		return true;
 	}
 	else if (loadoutType == (character.curLoadout + 1) * 10 ||
@@ -454,7 +457,7 @@ bool CUserManager::OnFavoriteSetLoadout(CReceivePacket* msg, IUser* user)
 		if (!g_UserDatabase.GetInventoryItemsByID(user->GetID(), itemID, items))
 			return false;
 
-		int category = g_pItemTable->GetCell<int>("Category", to_string(itemID));
+		int category = g_pItemAttributeTable->GetCategory(itemID);
 
 		if (category != 11 && (category < 1 || category > 6))
 			return false;
@@ -468,7 +471,7 @@ bool CUserManager::OnFavoriteSetLoadout(CReceivePacket* msg, IUser* user)
 		if (!g_UserDatabase.GetInventoryItemsByID(user->GetID(), itemID, items))
 			return false;
 
-		int category = g_pItemTable->GetCell<int>("Category", to_string(itemID));
+		int category = g_pItemAttributeTable->GetCategory(itemID);
 
 		if (category != 7)
 			return false;
@@ -476,7 +479,7 @@ bool CUserManager::OnFavoriteSetLoadout(CReceivePacket* msg, IUser* user)
 		// change bg character...
 		character.flag = EXT_UFLAG_CHARACTERID;
 		character.characterID = itemID;
-		g_UserDatabase.UpdateCharacterExtended(user->GetID(), character);
+		user->UpdateCharacterExtended(character);
 	}
 	else
 	{
@@ -583,8 +586,7 @@ void CUserManager::SendLoginPacket(IUser* user, const CUserCharacter& character)
 	if (characterExtended.config.size())
 		g_PacketManager.SendOption(socket, characterExtended.config);
 
-	vector<string> banList;
-	g_UserDatabase.GetBanList(user->GetID(), banList);
+	vector<string> banList = user->GetBanList();
 	if (!banList.empty())
 		g_PacketManager.SendBanList(socket, banList);
 
@@ -754,8 +756,7 @@ void CUserManager::SendUserLoadout(IUser* user)
 	vector<CUserBuyMenu> buyMenu;
 	g_UserDatabase.GetBuyMenu(user->GetID(), buyMenu);
 
-	CUserCharacterExtended character(EXT_UFLAG_CURLOADOUT | EXT_UFLAG_CHARACTERID);
-	g_UserDatabase.GetCharacterExtended(user->GetID(), character);
+	CUserCharacterExtended character = user->GetCharacterExtended(EXT_UFLAG_CURLOADOUT | EXT_UFLAG_CHARACTERID);
 
 	vector<int> bookmark;
 	g_UserDatabase.GetBookmark(user->GetID(), bookmark);
@@ -780,7 +781,7 @@ bool CUserManager::OnCharacterPacket(CReceivePacket* msg, IExtendedSocket* socke
 
 	string name = msg->ReadString();
 
-	IUser* user = GetUserBySocket(socket);
+	IUser* user = socket->GetUser();
 
 	int replyCode = ChangeUserNickname(user, name, true);
 	switch (replyCode)
@@ -821,7 +822,7 @@ bool CUserManager::OnUserMessage(CReceivePacket* msg, IExtendedSocket* socket)
 {
 	LOG_PACKET;
 
-	IUser* user = GetUserBySocket(socket);
+	IUser* user = socket->GetUser();
 
 	int type = msg->ReadUInt8();
 	switch (type)
@@ -863,7 +864,7 @@ bool CUserManager::OnUpdateInfoPacket(CReceivePacket* msg, IExtendedSocket* sock
 {
 	LOG_PACKET;
 
-	IUser* user = GetUserBySocket(socket);
+	IUser* user = socket->GetUser();
 	if (user == NULL)
 		return false;
 
@@ -895,7 +896,7 @@ bool CUserManager::OnUpdateInfoPacket(CReceivePacket* msg, IExtendedSocket* sock
 
 		if (chatColorID)
 		{
-			string resourceName = g_pItemTable->GetCell<string>("recourcename", to_string(chatColorID));
+			string resourceName = g_pItemAttributeTable->GetResourceName(chatColorID);
 			if (resourceName.find("chatcolor_") == std::string::npos)
 				return true;
 
@@ -925,22 +926,94 @@ void CUserManager::OnSecondTick(time_t curTime)
 		u->OnTick();
 }
 
-void CUserManager::SendNoticeMessageToAll(const string& msg)
+void CUserManager::OnMinuteTick(time_t curTime)
+{
+	FlushUserCache();
+}
+
+/**
+ * Writes dirty character data of all online users in one transaction
+ */
+void CUserManager::FlushUserCache()
 {
+	g_UserDatabase.CreateTransaction();
+
 	for (auto u : m_Users)
-		g_PacketManager.SendUMsgNoticeMessageInChat(u->GetExtendedSocket(), msg);
+		u->FlushCache();
+
+	bool committed = g_UserDatabase.CommitTransaction();
+
+	for (auto u : m_Users)
+		u->OnCacheFlushed(committed);
+
+	g_UserCacheStats.flushes++;
+}
+
+void CUserManager::SendNoticeMessageToAll(const string& msg)
+{
+	g_PacketManager.SendUMsgNoticeMessageInChat(GetUserSockets(), msg);
 }
 
 void CUserManager::SendNoticeMsgBoxToAll(const string& msg)
 {
+	g_PacketManager.SendUMsgNoticeMsgBoxToUuid(GetUserSockets(), msg);
+}
+
+/**
+ * Gets sockets of all logged in users, recipients of server-wide broadcasts
+ */
+vector<IExtendedSocket*> CUserManager::GetUserSockets()
+{
+	vector<IExtendedSocket*> sockets;
+	sockets.reserve(m_Users.size());
 	for (auto u : m_Users)
-		g_PacketManager.SendUMsgNoticeMsgBoxToUuid(u->GetExtendedSocket(), msg);
+		sockets.push_back(u->GetExtendedSocket());
+
+	return sockets;
+}
+
+struct LoginAuthResult_s
+{
+	int userID;
+	UserBan ban;
+};
+
+/**
+ * Starts login. Credentials are checked and the session is created on the database thread, onResult is called on the event thread
+ * with the login result (LOGIN_*) unless the client disconnects in the meantime
+ */
+void CUserManager::LoginUser(IExtendedSocket* socket, const string& userName, const string& password, const function<void(IExtendedSocket*, int)>& onResult)
+{
+	unsigned int socketID = socket->GetID();
+	if (m_PendingLoginSockets.count(socketID))
+		return; // previous login of this client is not finished yet
+
+	m_PendingLoginSockets.insert(socketID);
+
+	g_UserDatabaseAsync.Execute([userName, password]()
+	{
+		LoginAuthResult_s result = {};
+		result.userID = g_UserDatabase.Login(userName, password, result.ban, NULL);
+		return result;
+	},
+	[this, socketID, userName, onResult](const LoginAuthResult_s& result)
+	{
+		OnLoginAuthenticated(socketID, userName, result.userID, result.ban, onResult);
+	});
 }
 
-int CUserManager::LoginUser(IExtendedSocket* socket, const string& userName, const string& password)
+/**
+ * Called on the event thread after credentials are checked, disconnects the online user with the same ID and creates the session
+ */
+void CUserManager::OnLoginAuthenticated(unsigned int socketID, const string& userName, int userID, const UserBan& ban, const function<void(IExtendedSocket*, int)>& onResult)
 {
-	UserBan ban = {};
-	int userID = g_UserDatabase.Login(userName, password, socket, ban, NULL);
+	IExtendedSocket* socket = g_pServerInstance->GetSocketByID(socketID);
+	if (!socket)
+	{
+		m_PendingLoginSockets.erase(socketID);
+		return;
+	}
+
 	if (userID <= 0)
 	{
 		switch (userID)
@@ -951,9 +1024,69 @@ int CUserManager::LoginUser(IExtendedSocket* socket, const string& userName, con
 			break;
 		}
 		Logger().Info(OBFUSCATE("Login failed (code: %d)\n"), userID);
-		return userID;
+
+		m_PendingLoginSockets.erase(socketID);
+		onResult(socket, userID);
+		return;
+	}
+
+	if (m_PendingLoginUsers.count(userID)) // if the same user is logging in from another client
+	{
+		Logger().Info("Login failed (code: %d)\n", LOGIN_USER_ALREADY_LOGGED_IN_UID);
+
+		g_PacketManager.SendReply(socket, ServerReply::S_REPLY_PLAYING);
+
+		m_PendingLoginSockets.erase(socketID);
+		onResult(socket, LOGIN_USER_ALREADY_LOGGED_IN_UID);
+		return;
 	}
 
+	// the new login replaces the online session, the user is disconnected before the session is created
+	IUser* onlineUser = GetUserById(userID);
+	if (onlineUser && onlineUser->GetExtendedSocket() != socket)
+		DisconnectUser(onlineUser);
+
+	m_PendingLoginUsers.insert(userID);
+
+	string ip = socket->GetIP();
+	vector<unsigned char> hwid = socket->GetHWID();
+
+	g_UserDatabaseAsync.Execute([userID, ip, hwid]()
+	{
+		return g_UserDatabase.CreateSession(userID, ip, hwid);
+	},
+	[this, socketID, userID, userName, onResult](int result)
+	{
+		m_PendingLoginSockets.erase(socketID);
+		m_PendingLoginUsers.erase(userID);
+
+		IExtendedSocket* socket = g_pServerInstance->GetSocketByID(socketID);
+		if (!socket)
+		{
+			if (result > 0 && !GetUserById(userID))
+				g_UserDatabase.DropSession(userID);
+
+			return;
+		}
+
+		if (result <= 0)
+		{
+			Logger().Info(OBFUSCATE("Login failed (code: %d)\n"), LOGIN_DB_ERROR);
+
+			onResult(socket, LOGIN_DB_ERROR);
+			return;
+		}
+
+		onResult(socket, OnLoginSessionCreated(socket, userID, userName));
+	});
+}
+
+/**
+ * Adds the user after the session is created
+ * @return Login result (LOGIN_*)
+ */
+int CUserManager::OnLoginSessionCreated(IExtendedSocket* socket, int userID, const string& userName)
+{
 	if (GetUserById(userID)) // if user with this uid is already on server
 	{
 		Logger().Info("Login failed (code: %d)\n", LOGIN_USER_ALREADY_LOGGED_IN_UID);
@@ -963,7 +1096,7 @@ int CUserManager::LoginUser(IExtendedSocket* socket, const string& userName, con
 		return LOGIN_USER_ALREADY_LOGGED_IN_UID;
 	}
 
-	if (GetUserBySocket(socket)) // if user with the same socket object is already on server
+	if (socket->GetUser()) // if user with the same socket object is already on server
 	{
 		Logger().Info("Login failed (code: %d)\n", LOGIN_USER_ALREADY_LOGGED_IN_UUID);
 
@@ -998,7 +1131,7 @@ int CUserManager::LoginUser(IExtendedSocket* socket, const string& userName, con
 	data.lastIP = socket->GetIP();
 	data.lastHWID = socket->GetHWID();
 
-	g_UserDatabase.UpdateUserData(userID, data);
+	newUser->UpdateUser(data);
 		
 	g_PacketManager.SendReply(socket, ServerReply::S_REPLY_YES);
 
@@ -1047,7 +1180,9 @@ void CUserManager::DisconnectUser(IUser* user)
 
 void CUserManager::DisconnectAllFromServer()
 {
-	for (auto u : m_Users)
+	// disconnected users are removed from m_Users right away
+	vector<IUser*> users = m_Users;
+	for (auto u : users)
 	{
 		DisconnectUser(u);
 	}
@@ -1058,41 +1193,45 @@ IUser* CUserManager::AddUser(IExtendedSocket* socket, int userID, const string&
 	if ((int)m_Users.size() >= g_pServerConfig->maxPlayers)
 		return NULL;
 
-	m_Users.push_back(new CUser(socket, userID, userName));
-	return m_Users.back();
+	CUser* user = new CUser(socket, userID, userName);
+	user->LoadCache(); // character doesn't exist yet for new users, loaded on first access after creation
+
+	m_Users.push_back(user);
+
+	// the first user keeps the key if keys are duplicated, the same as the linear search did
+	m_UsersByID.emplace(userID, user);
+	m_UsersByName.emplace(userName, user);
+
+	if (!socket->GetUser())
+		socket->SetUser(user);
+
+	return user;
 }
 
 IUser* CUserManager::GetUserById(int userId)
 {
-	for (auto u : m_Users)
-	{
-		if (u->GetID() == userId)
-			return u;
-	}
+	auto it = m_UsersByID.find(userId);
+	if (it == m_UsersByID.end())
+		return NULL;
 
-	return NULL;
+	return it->second;
 }
 
 IUser* CUserManager::GetUserBySocket(IExtendedSocket* socket)
 {
-	for (auto u : m_Users)
-	{
-		if (u->GetExtendedSocket() == socket)
-			return u;
-	}
+	if (!socket)
+		return NULL;
 
-	return NULL;
+	return socket->GetUser();
 }
 
 IUser* CUserManager::GetUserByUsername(const string& username)
 {
-	for (auto u : m_Users)
-	{
-		if (u->GetUsername() == username)
-			return u;
-	}
+	auto it = m_UsersByName.find(username);
+	if (it == m_UsersByName.end())
+		return NULL;
 
-	return NULL;
+	return it->second;
 }
 
 IUser* CUserManager::GetUserByNickname(const string& nickname)
@@ -1102,37 +1241,52 @@ IUser* CUserManager::GetUserByNickname(const string& nickname)
 	return GetUserById(userID);
 }
 
+/**
+ * Sets user of clan members that are online, the user database doesn't know who is online
+ * @param clanUsers Clan members read from the user database
+ */
+void CUserManager::FindClanUsers(vector<ClanUser>& clanUsers)
+{
+	for (auto& clanUser : clanUsers)
+		clanUser.user = GetUserById(clanUser.userID);
+}
+
 void CUserManager::RemoveUser(IUser* user)
 {
-	for (auto u : m_Users)
-	{
-		if (u == user && RemoveUserInternal(u))
-			break;
-	}
+	if (find(m_Users.begin(), m_Users.end(), user) != m_Users.end())
+		RemoveUserInternal(user);
 }
 
 void CUserManager::RemoveUserById(int userId)
 {
-	for (auto u : m_Users)
-	{
-		if (u->GetID() == userId && RemoveUserInternal(u))
-			break;
-	}
+	IUser* user = GetUserById(userId);
+	if (user)
+		RemoveUserInternal(user);
 }
 
 void CUserManager::RemoveUserBySocket(IExtendedSocket* socket)
 {
-	for (auto u : m_Users)
-	{
-		if (u->GetExtendedSocket() == socket && RemoveUserInternal(u))
-			break;
-	}
+	IUser* user = socket->GetUser();
+	if (user)
+		RemoveUserInternal(user);
 }
 
 bool CUserManager::RemoveUserInternal(IUser* user)
 {
 	m_Users.erase(remove(begin(m_Users), end(m_Users), user), end(m_Users));
 
+	auto itID = m_UsersByID.find(user->GetID());
+	if (itID != m_UsersByID.end() && itID->second == user)
+		m_UsersByID.erase(itID);
+
+	IExtendedSocket* socket = user->GetExtendedSocket();
+	if (socket && socket->GetUser() == user)
+		socket->SetUser(NULL);
+
+	auto itName = m_UsersByName.find(user->GetUsername());
+	if (itName != m_UsersByName.end() && itName->second == user)
+		m_UsersByName.erase(itName);
+
 	CleanUpUser(user);
 	delete user;
 
@@ -1152,7 +1306,10 @@ void CUserManager::CleanUpUser(IUser* user)
 	user->SetCurrentChannel(NULL);
 }
 
-std::vector<IUser*> CUserManager::GetUsers()
+/**
+ * Gets online users. The vector changes when users log in or disconnect, copy it to disconnect users while iterating
+ */
+const std::vector<IUser*>& CUserManager::GetUsers()
 {
 	return m_Users;
 }
@@ -1161,7 +1318,7 @@ bool CUserManager::OnReportPacket(CReceivePacket* msg, IExtendedSocket* socket)
 {
 	LOG_PACKET;
 #if 0
-	IUser* user = GetUserBySocket(socket);
+	IUser* user = socket->GetUser();
 	if (user == NULL)
 		return false;
 
@@ -1196,7 +1353,7 @@ bool CUserManager::OnAlarmPacket(CReceivePacket* msg, IExtendedSocket* socket)
 {
 	LOG_PACKET;
 
-	IUser* user = GetUserBySocket(socket);
+	IUser* user = socket->GetUser();
 	if (user == NULL)
 	{
 		return false;
@@ -1217,7 +1374,7 @@ bool CUserManager::OnUserSurveyPacket(CReceivePacket* msg, IExtendedSocket* sock
 {
 	LOG_PACKET;
 
-	IUser* user = GetUserBySocket(socket);
+	IUser* user = socket->GetUser();
 	if (user == NULL)
 		return false;
 
@@ -1245,7 +1402,7 @@ bool CUserManager::OnBanPacket(CReceivePacket* msg, IExtendedSocket* socket)
 {
 	LOG_PACKET;
 
-	IUser* user = GetUserBySocket(socket);
+	IUser* user = socket->GetUser();
 	if (user == NULL)
 		return false;
 
@@ -1276,7 +1433,7 @@ bool CUserManager::OnMessengerPacket(CReceivePacket* msg, IExtendedSocket* socke
 {
 	LOG_PACKET;
 
-	IUser* user = GetUserBySocket(socket);
+	IUser* user = socket->GetUser();
 	if (user == NULL)
 		return false;
 
@@ -1306,7 +1463,7 @@ bool CUserManager::OnAddonPacket(CReceivePacket* msg, IExtendedSocket* socket)
 {
 	LOG_PACKET;
 
-	IUser* user = GetUserBySocket(socket);
+	IUser* user = socket->GetUser();
 	if (user == NULL)
 		return false;
 
@@ -1324,7 +1481,7 @@ bool CUserManager::OnLeaguePacket(CReceivePacket* msg, IExtendedSocket* socket)
 {
 	LOG_PACKET;
 
-	IUser* user = GetUserBySocket(socket);
+	IUser* user = socket->GetUser();
 	if (user == NULL)
 		return false;
 
@@ -1354,7 +1511,7 @@ bool CUserManager::OnKickPacket(CReceivePacket* msg, IExtendedSocket* socket)
 {
 	LOG_PACKET;
 
-	IUser* user = GetUserBySocket(socket);
+	IUser* user = socket->GetUser();
 	if (user == NULL)
 		return false;
 
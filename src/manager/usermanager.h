@@ -5,6 +5,9 @@
 #include "user/user.h"
 #include "manager/manager.h"
 
+#include <unordered_set>
+#include <unordered_map>
+
 class CUserManager : public CBaseManager<IUserManager>
 {
 public:
@@ -14,6 +17,7 @@ public:
 	virtual bool Init();
 	virtual void Shutdown();
 	virtual void OnSecondTick(time_t curTime);
+	virtual void OnMinuteTick(time_t curTime);
 
 	bool LoadZombieWarWeaponList();
 	bool LoadRandomWeaponList();
@@ -38,7 +42,7 @@ public:
 	void SendNoticeMessageToAll(const std::string& msg);
 	void SendNoticeMsgBoxToAll(const std::string& msg);
 
-	int LoginUser(IExtendedSocket* socket, const std::string& userName, const std::string& password);
+	void LoginUser(IExtendedSocket* socket, const std::string& userName, const std::string& password, const std::function<void(IExtendedSocket*, int)>& onResult);
 	int RegisterUser(IExtendedSocket* socket, const std::string& userName, const std::string& password);
 	void DisconnectUser(IUser* user);
 	void DisconnectAllFromServer();
@@ -47,6 +51,7 @@ public:
 	IUser* GetUserBySocket(IExtendedSocket* socket);
 	IUser* GetUserByUsername(const std::string& username);
 	IUser* GetUserByNickname(const std::string& nickname);
+	void FindClanUsers(std::vector<ClanUser>& clanUsers);
 
 	void RemoveUser(IUser* user);
 	void RemoveUserById(int userId);
@@ -54,7 +59,8 @@ public:
 	void CleanUpUser(IUser* user);
 	bool RemoveUserInternal(IUser* user);
 
-	std::vector<IUser*> GetUsers();
+	const std::vector<IUser*>& GetUsers();
+	void FlushUserCache();
 
 	int ChangeUserNickname(IUser* user, const std::string& newNickname, bool createCharacter = false);
 
@@ -64,11 +70,14 @@ public:
 	void SendCrypt(IExtendedSocket* socket);
 
 private:
+	void OnLoginAuthenticated(unsigned int socketID, const std::string& userName, int userID, const UserBan& ban, const std::function<void(IExtendedSocket*, int)>& onResult);
+	int OnLoginSessionCreated(IExtendedSocket* socket, int userID, const std::string& userName);
 	void SendGuestUserPacket(IExtendedSocket* socket);
 	void SendLoginPacket(IUser* user, const CUserCharacter& character);
 	void SendUserInventory(IUser* user);
 	void SendUserLoadout(IUser* user);
 	void SendUserNotices(IUser* user);
+	std::vector<IExtendedSocket*> GetUserSockets();
 	bool OnFavoriteSetLoadout(CReceivePacket* msg, IUser* user);
 	bool OnFavoriteSetBuyMenu(CReceivePacket* msg, IUser* user);
 	bool OnFavoriteSetFastBuy(CReceivePacket* msg, IUser* user);
@@ -80,7 +89,11 @@ private:
 	void OnBanRemoveNicknameRequest(CReceivePacket* msg, IUser* user);
 	void OnBanSettingsRequest(CReceivePacket* msg, IUser* user);
 
-	std::vector<IUser*> m_Users;
+	std::vector<IUser*> m_Users; // online users in login order
+	std::unordered_map<int, IUser*> m_UsersByID;
+	std::unordered_map<std::string, IUser*> m_UsersByName;
+	std::unordered_set<unsigned int> m_PendingLoginSockets; // IDs of clients waiting for the database
+	std::unordered_set<int> m_PendingLoginUsers;
 	std::vector<CUserInventoryItem> m_DefaultItems;
 	std::vector<int> m_ZombieWarWeaponList;
 	std::vector<RandomWeapon> m_RandomWeaponList;
@@ -2,6 +2,7 @@
 #include <wolfssl/openssl/evp.h>
 
 #include "net/extendedsocket.h"
+#include "net/tcpserverworker.h"
 #include "net/sendpacket.h"
 #include "net/receivepacket.h"
 
@@ -9,6 +10,13 @@
 #include "common/logger.h"
 #include "common/utils.h"
 
+#include <atomic>
+#include <algorithm>
+
+#ifndef WIN32
+#include <sys/uio.h>
+#endif
+
 using namespace std;
 
 /**
@@ -23,11 +31,17 @@ CExtendedSocket::CExtendedSocket(SOCKET socket, unsigned int id)
 	m_nSequence = 0;
 	m_nBytesReceived = 0;
 	m_nBytesSent = 0;
-	m_nPacketReceivedSize = 0;
+	m_nRecvStart = 0;
+	m_nRecvDecrypted = 0;
+	m_nRecvEnd = 0;
+	m_nRecvPacketSize = 0;
 	m_nPacketSentSize = 0;
+	m_nSendOffset = 0;
+	m_nSendQueueBytes = 0;
+	m_nSendQueueLimit = 0;
+	m_bSendQueueOverflow = false;
 	m_nReadResult = 0;
 	m_nNextExpectedSeq = 1;
-	m_pMsg = NULL;
 	m_pEncEVPCTX = NULL;
 	m_pDecEVPCTX = NULL;
 	m_bCryptInput = false;
@@ -35,17 +49,18 @@ CExtendedSocket::CExtendedSocket(SOCKET socket, unsigned int id)
 	memset(m_pCryptKey, 0, 64);
 	memset(m_pCryptIV, 0, 64);
 	m_pSSL = NULL;
+	m_bHandshaking = false;
+	m_pWorker = NULL;
+	m_pUser = NULL;
+	m_pServer = NULL;
 }
 
 /**
  * Destructor.
- * Deletes unsent and unreceived packets
+ * Deletes unsent packets
  */
 CExtendedSocket::~CExtendedSocket()
 {
-	if (m_pMsg)
-		delete m_pMsg;
-
 	for (auto msg : m_SendPackets)
 		delete msg;
 
@@ -159,6 +174,48 @@ void CExtendedSocket::ResetSeq()
 	m_nSequence = -1;
 }
 
+/**
+ * Attaches TLS session to accepted socket. The handshake is continued by the worker when the socket is readable or writable
+ * @param ssl
+ */
+void CExtendedSocket::StartHandshake(WOLFSSL* ssl)
+{
+	m_pSSL = ssl;
+	m_bHandshaking = true;
+	m_HandshakeStartTime = chrono::steady_clock::now();
+}
+
+/**
+ * Continues TLS handshake without blocking
+ * @return False if handshake failed
+ */
+bool CExtendedSocket::ContinueHandshake()
+{
+	int result = wolfSSL_accept(m_pSSL);
+	if (result == WOLFSSL_SUCCESS)
+	{
+		m_bHandshaking = false;
+		return true;
+	}
+
+	int err = wolfSSL_get_error(m_pSSL, result);
+	if (err == WOLFSSL_ERROR_WANT_READ)
+		return true;
+
+	if (err == WOLFSSL_ERROR_WANT_WRITE)
+	{
+		// continue on write readiness
+		if (m_pWorker)
+			m_pWorker->WatchWritable(this, true);
+
+		return true;
+	}
+
+	Logger().Warn("CExtendedSocket::ContinueHandshake(%s): wolfSSL_accept() failed with error: %d\n", GetIP().c_str(), err);
+
+	return false;
+}
+
 /**
  * Reads data on a socket
  * @param buf Pointer to received data
@@ -170,9 +227,9 @@ int CExtendedSocket::Read(char* buf, int len)
 	int recvResult = 0;
 
 	if (m_pSSL)
-		recvResult = wolfSSL_recv(m_pSSL, buf, len, 0);
+		recvResult = wolfSSL_recv(m_pSSL, buf, len, MSG_DONTWAIT);
 	else
-		recvResult = recv(m_Socket, buf, len, 0);
+		recvResult = recv(m_Socket, buf, len, MSG_DONTWAIT);
 
 	m_nReadResult += recvResult;
 	m_nBytesReceived += recvResult;
@@ -183,140 +240,187 @@ int CExtendedSocket::Read(char* buf, int len)
 }
 
 /**
- * Receives incoming packet or packets
- * @return Pointer to received message if entire message has been read, NULL on error or if waiting for the rest of message
+ * Receives incoming packets. Packets that are already in the receive buffer are returned first,
+ * otherwise everything the socket has (up to free buffer space) is read with a single recv call
+ * @return Pointer to received message, NULL if there is no complete message. GetReadResult() tells why:
+ *         0 - connection closed, SOCKET_ERROR - recv error (WSAEWOULDBLOCK if there is nothing to read),
+ *         PACKET_READ_INVALID - invalid packet, > 0 - waiting for the rest of message
  */
 CReceivePacket* CExtendedSocket::Read()
 {
 	m_nReadResult = 0;
-	vector<unsigned char> packetDataBuf;
-	int recvResult = 0;
 
-	if (!m_pMsg)
+	CReceivePacket* msg = ParsePacket();
+	if (msg || m_nReadResult == PACKET_READ_INVALID)
+		return msg;
+
+	PrepareRecvBuffer();
+
+	int recvResult = Read((char*)m_pRecvBuffer->data() + m_nRecvEnd, m_pRecvBuffer->size() - m_nRecvEnd);
+	if (recvResult <= 0) // error or peer disconnected
 	{
-		packetDataBuf.resize(PACKET_HEADER_SIZE);
+		if (recvResult < 0 && GetNetworkError() != WSAEWOULDBLOCK)
+			Logger().Error("CExtendedSocket::Read(%s): result < 0, %d\n", GetIP().c_str(), GetNetworkError());
 
-		// first of all read the packet header to know is received packet is valid
-		recvResult = Read((char*)packetDataBuf.data(), packetDataBuf.size());
-		if (recvResult < PACKET_HEADER_SIZE)
-		{
-			if (recvResult > 0)
-				Logger().Error("CExtendedSocket::Read(%s): result < PACKET_HEADER_SIZE, %d\n", GetIP().c_str(), GetNetworkError());
+		return NULL;
+	}
 
-			return NULL;
-		}
+	m_nRecvEnd += recvResult;
 
-		// decrypt header if encrypted
-		if (m_bCryptInput)
-		{
-			int outLen = 0;
-			if (EVP_DecryptUpdate(m_pDecEVPCTX, packetDataBuf.data(), &outLen, packetDataBuf.data(), recvResult) != 1)
-			{
-				Logger().Error("CExtendedSocket::Read(%s): EVP_DecryptUpdate failed\n", GetIP().c_str());
-				return NULL;
-			}
+	if (!DecryptReceived())
+	{
+		m_nReadResult = PACKET_READ_INVALID;
+		return NULL;
+	}
 
-			int finalLen = 0;
-			if (EVP_DecryptFinal_ex(m_pDecEVPCTX, packetDataBuf.data() + outLen, &finalLen) != 1)
-			{
-				Logger().Error("CExtendedSocket::Read(%s): EVP_DecryptUpdate failed\n", GetIP().c_str());
-				return NULL;
-			}
-		}
+	msg = ParsePacket();
 
-		// when a people may incorrect once packet data, might spammed this message forever....
-		m_pMsg = new CReceivePacket(Buffer(packetDataBuf));
-		if (!m_pMsg->IsValid())
-		{
-			Logger().Error("CExtendedSocket::Read(%s): received invalid packet\n", GetIP().c_str());
-			delete m_pMsg;
-			m_pMsg = NULL;
-			return NULL;
-		}
+#if 0
+	Logger().Info("CExtendedSocket::Read(%s): recvResult: %d, m_nRecvStart: %d, m_nRecvEnd: %d, m_nRecvPacketSize: %d\n", GetIP().c_str(), recvResult, m_nRecvStart, m_nRecvEnd, m_nRecvPacketSize);
+#endif
 
-		if (m_pMsg->GetSequence() != m_nNextExpectedSeq)
-		{
-			Logger().Error("CExtendedSocket::Read(%s): sequence mismatch, got: %d, expected: %d\n", GetIP().c_str(), m_pMsg->GetSequence(), m_nNextExpectedSeq);
-			delete m_pMsg;
-			m_pMsg = NULL;
-			return NULL;
-		}
+	return msg;
+}
+
+/**
+ * Makes room for the next recv call. Unparsed data is moved to the beginning of the receive buffer
+ * or to a new buffer if received packets still reference the current one
+ */
+void CExtendedSocket::PrepareRecvBuffer()
+{
+	size_t bufferSize = max((size_t)RECV_BUFFER_SIZE, m_nRecvPacketSize);
+	bool shared = m_pRecvBuffer && m_pRecvBuffer.use_count() > 1;
+
+	if (m_pRecvBuffer && m_nRecvStart == m_nRecvEnd && !shared)
+	{
+		// nothing is pending and nobody references parsed data, start over
+		m_nRecvStart = m_nRecvDecrypted = m_nRecvEnd = 0;
+	}
+
+	if (m_pRecvBuffer && m_pRecvBuffer->size() - m_nRecvEnd >= RECV_BUFFER_MIN_FREE && m_nRecvStart + m_nRecvPacketSize <= m_pRecvBuffer->size())
+		return;
+
+	size_t pending = m_nRecvEnd - m_nRecvStart;
+
+	if (m_pRecvBuffer && !shared && m_pRecvBuffer->size() >= bufferSize)
+	{
+		// the last packet referencing the buffer may have been deleted by another thread, make its reads visible before overwriting
+		atomic_thread_fence(memory_order_acquire);
+		memmove(m_pRecvBuffer->data(), m_pRecvBuffer->data() + m_nRecvStart, pending);
+	}
+	else
+	{
+		auto recvBuffer = make_shared<vector<unsigned char>>(bufferSize);
+		if (pending)
+			memcpy(recvBuffer->data(), m_pRecvBuffer->data() + m_nRecvStart, pending);
 
-		// Reset m_nNextExpectedSeq
-		if (m_nNextExpectedSeq == MAX_SEQUENCE)
-			m_nNextExpectedSeq = -1;
+		m_pRecvBuffer = recvBuffer;
+	}
 
-		m_nNextExpectedSeq++;
+	m_nRecvDecrypted -= m_nRecvStart;
+	m_nRecvEnd = pending;
+	m_nRecvStart = 0;
+}
 
-		m_nPacketReceivedSize = 0;
+/**
+ * Decrypts received data in place if input encryption is enabled
+ * @return False if decryption failed
+ */
+bool CExtendedSocket::DecryptReceived()
+{
+	if (!m_bCryptInput || m_nRecvDecrypted == m_nRecvEnd)
+	{
+		m_nRecvDecrypted = m_nRecvEnd;
+		return true;
 	}
 
-	// if there is data to read
-	if (m_pMsg->GetLength() > 0)
+	unsigned char* data = m_pRecvBuffer->data() + m_nRecvDecrypted;
+	int len = m_nRecvEnd - m_nRecvDecrypted;
+
+	int outLen = 0;
+	if (EVP_DecryptUpdate(m_pDecEVPCTX, data, &outLen, data, len) != 1)
 	{
-		packetDataBuf.resize(m_pMsg->GetLength() - m_nPacketReceivedSize);
+		Logger().Error("CExtendedSocket::Read(%s): EVP_DecryptUpdate failed\n", GetIP().c_str());
+		return false;
+	}
 
-		recvResult = Read((char*)packetDataBuf.data(), packetDataBuf.size());
-		if (recvResult <= 0) // error or peer disconnected
-		{
-			if (recvResult < 0)
-				Logger().Error("CExtendedSocket::Read(%s): result < 0, %d\n", GetIP().c_str(), GetNetworkError());
+	int finalLen = 0;
+	if (EVP_DecryptFinal_ex(m_pDecEVPCTX, data + outLen, &finalLen) != 1)
+	{
+		Logger().Error("CExtendedSocket::Read(%s): EVP_DecryptUpdate failed\n", GetIP().c_str());
+		return false;
+	}
 
-			delete m_pMsg;
-			m_pMsg = NULL;
-			return NULL;
-		}
+	m_nRecvDecrypted = m_nRecvEnd;
 
-		if (recvResult < packetDataBuf.size())
-			packetDataBuf.resize(recvResult);
+	return true;
+}
 
-		m_nPacketReceivedSize += recvResult;
+/**
+ * Parses the next complete packet from the receive buffer
+ * @return Pointer to packet, NULL if there is no complete packet or packet is invalid (m_nReadResult is set to PACKET_READ_INVALID)
+ */
+CReceivePacket* CExtendedSocket::ParsePacket()
+{
+	size_t available = m_nRecvDecrypted - m_nRecvStart;
+	if (available < PACKET_HEADER_SIZE)
+		return NULL;
 
-		// decrypt the rest part of packet
-		if (m_bCryptInput)
-		{
-			int outLen = 0;
-			if (EVP_DecryptUpdate(m_pDecEVPCTX, packetDataBuf.data(), &outLen, packetDataBuf.data(), recvResult) != 1)
-			{
-				Logger().Error("CExtendedSocket::Read(%s): EVP_DecryptUpdate failed\n", GetIP().c_str());
-				delete m_pMsg;
-				m_pMsg = NULL;
-				return NULL;
-			}
+	const unsigned char* header = m_pRecvBuffer->data() + m_nRecvStart;
 
-			int finalLen = 0;
-			if (EVP_DecryptFinal_ex(m_pDecEVPCTX, packetDataBuf.data() + outLen, &finalLen) != 1)
-			{
-				Logger().Error("CExtendedSocket::Read(%s): EVP_DecryptUpdate failed\n", GetIP().c_str());
-				delete m_pMsg;
-				m_pMsg = NULL;
-				return NULL;
-			}
-		}
+	// when a people may incorrect once packet data, might spammed this message forever....
+	if (header[0] != TCP_PACKET_SIGNATURE)
+	{
+		Logger().Error("CExtendedSocket::Read(%s): received invalid packet\n", GetIP().c_str());
+		m_nReadResult = PACKET_READ_INVALID;
+		return NULL;
+	}
+
+	m_nRecvPacketSize = PACKET_HEADER_SIZE + (header[2] | (header[3] << 8));
+	if (available < m_nRecvPacketSize)
+	{
+		// wait for rest of message
+		return NULL;
+	}
+
+	CReceivePacket* msg = new CReceivePacket(Buffer(m_pRecvBuffer, m_nRecvStart, m_nRecvPacketSize));
 
-		// append read data to packet buffer
-		Buffer& buf = m_pMsg->GetData();
-		/// @todo: rewrite
-		vector<unsigned char> vecBuf = buf.getBuffer();
-		vecBuf.insert(vecBuf.end(), packetDataBuf.begin(), packetDataBuf.end());
-		buf.setBuffer(vecBuf);
+	m_nRecvStart += m_nRecvPacketSize;
+	m_nRecvPacketSize = 0;
 
-		// if not full message read
-		if (m_nPacketReceivedSize < m_pMsg->GetLength())
+	if (msg->GetSequence() != m_nNextExpectedSeq)
+	{
+		Logger().Error("CExtendedSocket::Read(%s): sequence mismatch, got: %d, expected: %d\n", GetIP().c_str(), msg->GetSequence(), m_nNextExpectedSeq);
+		delete msg;
+		m_nReadResult = PACKET_READ_INVALID;
+		return NULL;
+	}
+
+	// Reset m_nNextExpectedSeq
+	if (m_nNextExpectedSeq == MAX_SEQUENCE)
+		m_nNextExpectedSeq = -1;
+
+	m_nNextExpectedSeq++;
+
+	// the client encrypts everything after RecvCrypt. Switch here, the next packets are read by the worker thread
+	// before the event thread handles RecvCrypt. m_pDecEVPCTX is set only if crypt is enabled (see SetupCrypt)
+	if (msg->GetID() == PACKET_ID_RECVCRYPT && m_pDecEVPCTX && !m_pSSL && !m_bCryptInput)
+	{
+		m_bCryptInput = true;
+
+		// the rest of data has been received together with RecvCrypt and is still encrypted
+		m_nRecvDecrypted = m_nRecvStart;
+		if (!DecryptReceived())
 		{
-			// wait for rest of message
+			delete msg;
+			m_nReadResult = PACKET_READ_INVALID;
 			return NULL;
 		}
 	}
 
-#if 0
-	Logger().Info("CExtendedSocket::Read(%s): recvResult: %d, packetDataBuf.size: %d, m_nPacketReceivedSize: %d, m_pMsg->GetLength: %d, m_pMsg->GetSequence: %d, m_nPacketToReceiveFullSize: %d\n", GetIP().c_str(), recvResult, packetDataBuf.size(), m_nPacketReceivedSize, m_pMsg->GetLength(), m_pMsg->GetSequence(), m_nPacketToReceiveFullSize);
-#endif
+	m_nReadResult = msg->GetLength() + PACKET_HEADER_SIZE;
 
-	m_pMsg->GetData().setReadOffset(0);
-	m_pMsg->ParseHeader();
-
-	return m_pMsg;
+	return msg;
 }
 
 /**
@@ -395,33 +499,281 @@ int CExtendedSocket::Send(vector<unsigned char>& buffer, bool serverHelloMsg)
 }
 
 /**
- * Sends packet
+ * Encodes packet and adds it to the send queue. The packet is sent by the worker thread (or by SendQueuedPackets() for client sockets)
  * @param msg
- * @param ignoreQueue Used to send a packet ignoring the queue of them (used but need to make sure that the data is ready to be sent)
- * @return Number of bytes sent, SOCKET_ERROR on error
+ * @return Packet size, 0 if packet is too big, SOCKET_ERROR if the send queue limit has been exceeded
  */
-int CExtendedSocket::Send(CSendPacket* msg, bool ignoreQueue)
+int CExtendedSocket::Send(CSendPacket* msg)
 {
-	int result = 1;
+	msg->WritePacketLength();
 
-	if (!ignoreQueue)
+	Buffer& buf = msg->m_OutStream;
+	int size = msg->GetSize();
+	if (size > PACKET_MAX_SIZE)
 	{
-		// add to the send queue
-		m_SendPackets.push_back(msg);
+		Logger().Error("CExtendedSocket::Send(%s) buffer.size(): %d > PACKET_MAX_SIZE!!!, ID: %d, seq: %d. Packet not sent.\n", GetIP().c_str(), size, msg->m_nPacketID, msg->m_nSequence);
+		delete msg;
+		return 0;
 	}
-	else
+
+	m_SendPacketsMutex.Enter();
+
+	if (m_bSendQueueOverflow)
 	{
-		auto data = msg->SetPacketLength();
-		result = Send(data);
+		// already waiting for disconnect
+		m_SendPacketsMutex.Leave();
+		delete msg;
+		return SOCKET_ERROR;
+	}
+
+	if (m_nSendQueueLimit && m_nSendQueueBytes + size > m_nSendQueueLimit)
+	{
+		Logger().Warn("CExtendedSocket::Send(%s): send queue limit exceeded (%d bytes, %d packets), disconnecting client\n", GetIP().c_str(), m_nSendQueueBytes, m_SendPackets.size());
+
+		// the worker disconnects the client on the next flush
+		m_bSendQueueOverflow = true;
+		if (m_pWorker)
+			m_pWorker->WatchWritable(this, true);
 
-		if (result > 0 && msg->m_nPacketID == 7 && !m_bCryptOutput)
-			SetCryptOutput(true);
+		m_SendPacketsMutex.Leave();
+		delete msg;
+		return SOCKET_ERROR;
+	}
 
-		if (GetNetworkError() != WSAEWOULDBLOCK)
+	// encrypt in the queue order, the cipher is a stream one
+	if (m_bCryptOutput)
+	{
+		unsigned char* data = buf.getWritableData();
+		if (!EncryptOutput(data, data, buf.getSize()))
+		{
+			m_SendPacketsMutex.Leave();
 			delete msg;
+			return 0;
+		}
+
+		// shared data is the same for every socket, so it's encrypted to the packet's own copy.
+		// Data that isn't referenced by anything else (the last recipient of a broadcast) is encrypted in place
+		const shared_ptr<vector<unsigned char>>& sharedData = msg->GetSharedData();
+		if (sharedData && !sharedData->empty() && sharedData.use_count() == 1)
+		{
+			if (!EncryptOutput(sharedData->data(), sharedData->data(), sharedData->size()))
+			{
+				m_SendPacketsMutex.Leave();
+				delete msg;
+				return 0;
+			}
+		}
+		else if (sharedData && !sharedData->empty())
+		{
+			shared_ptr<vector<unsigned char>> encrypted = make_shared<vector<unsigned char>>(sharedData->size());
+			if (!EncryptOutput(encrypted->data(), sharedData->data(), sharedData->size()))
+			{
+				m_SendPacketsMutex.Leave();
+				delete msg;
+				return 0;
+			}
+
+			msg->WriteSharedData(move(encrypted));
+		}
+	}
+
+	if (msg->m_nPacketID == PACKET_ID_CRYPT && !m_bCryptOutput)
+		m_bCryptOutput = true;
+
+#ifdef _DEBUG
+	Logger().Debug("CExtendedSocket::Send(%s) seq: %d, buffer.size(): %d, id: %d\n", GetIP().c_str(), msg->m_nSequence, size, msg->m_nPacketID);
+#endif
+
+	m_SendPackets.push_back(msg);
+	m_nSendQueueBytes += size;
+
+	// ask the worker to notify about write readiness
+	if (m_pWorker && m_SendPackets.size() == 1)
+		m_pWorker->WatchWritable(this, true);
+
+	m_SendPacketsMutex.Leave();
+
+	return size;
+}
+
+/**
+ * Encrypts outgoing data with the socket's cipher. Must be called in the order data is sent
+ * @param out Output buffer, can be the same as in
+ * @param in Data to encrypt
+ * @param len Data length
+ * @return True on success, false on failure
+ */
+bool CExtendedSocket::EncryptOutput(unsigned char* out, const unsigned char* in, int len)
+{
+	int encLen = 0;
+	if (EVP_EncryptUpdate(m_pEncEVPCTX, out, &encLen, in, len) != 1)
+	{
+		Logger().Info("CExtendedSocket::Send(%s): EVP_EncryptUpdate failed\n", GetIP().c_str());
+		return false;
+	}
+
+	int finalLen = 0;
+	if (EVP_EncryptFinal_ex(m_pEncEVPCTX, out + encLen, &finalLen) != 1)
+	{
+		Logger().Info("CExtendedSocket::Send(%s): EVP_EncryptFinal_ex failed\n", GetIP().c_str());
+		return false;
 	}
 
-	return result;
+	return true;
+}
+
+#ifdef WIN32
+static inline void SetSendBuffer(WSABUF& buffer, const unsigned char* data, size_t len)
+{
+	buffer.buf = (CHAR*)data;
+	buffer.len = len;
+}
+#else
+static inline void SetSendBuffer(iovec& buffer, const unsigned char* data, size_t len)
+{
+	buffer.iov_base = (void*)data;
+	buffer.iov_len = len;
+}
+#endif
+
+/**
+ * Sends queued packets until the queue is empty or the socket would block.
+ * Up to SEND_BATCH_SIZE buffers are sent with one writev call (a packet takes two of them if it has shared data),
+ * partially sent packet is continued from where it stopped.
+ * Write readiness notifications are disabled once the queue is empty
+ * @return Number of packets left in the queue, SOCKET_ERROR on error or if the send queue limit has been exceeded
+ */
+int CExtendedSocket::SendQueuedPackets()
+{
+#ifdef WIN32
+	WSABUF buffers[SEND_BATCH_SIZE];
+#else
+	iovec buffers[SEND_BATCH_SIZE];
+#endif
+
+	while (true)
+	{
+		m_SendPacketsMutex.Enter();
+
+		if (m_bSendQueueOverflow)
+		{
+			m_SendPacketsMutex.Leave();
+			return SOCKET_ERROR;
+		}
+
+		if (m_SendPackets.empty())
+		{
+			// done inside the lock, a packet queued right after that enables notifications again
+			if (m_pWorker)
+				m_pWorker->WatchWritable(this, false);
+
+			m_SendPacketsMutex.Leave();
+
+			return 0;
+		}
+
+		// only the worker thread removes packets, so the queued packets stay valid without the lock
+		int count = 0;
+		for (size_t i = 0; i < m_SendPackets.size() && count + 2 <= SEND_BATCH_SIZE; i++)
+		{
+			CSendPacket* msg = m_SendPackets[i];
+			const Buffer& buf = msg->m_OutStream;
+			const shared_ptr<vector<unsigned char>>& sharedData = msg->GetSharedData();
+			size_t offset = i == 0 ? m_nSendOffset : 0;
+
+			if (offset < buf.getSize())
+			{
+				SetSendBuffer(buffers[count++], buf.getData() + offset, buf.getSize() - offset);
+				offset = 0;
+			}
+			else
+			{
+				offset -= buf.getSize();
+			}
+
+			if (sharedData && offset < sharedData->size())
+				SetSendBuffer(buffers[count++], sharedData->data() + offset, sharedData->size() - offset);
+		}
+
+		m_SendPacketsMutex.Leave();
+
+		int bytesSent = 0;
+		if (m_pSSL)
+		{
+			// no scatter/gather for TLS records, send packets one by one
+			for (int i = 0; i < count; i++)
+			{
+#ifdef WIN32
+				int result = wolfSSL_send(m_pSSL, buffers[i].buf, buffers[i].len, 0);
+				int len = buffers[i].len;
+#else
+				int result = wolfSSL_send(m_pSSL, buffers[i].iov_base, buffers[i].iov_len, 0);
+				int len = buffers[i].iov_len;
+#endif
+				if (result <= 0)
+				{
+					if (!bytesSent)
+						bytesSent = SOCKET_ERROR;
+
+					break;
+				}
+
+				bytesSent += result;
+				if (result < len)
+					break;
+			}
+		}
+		else
+		{
+#ifdef WIN32
+			DWORD sent = 0;
+			bytesSent = WSASend(m_Socket, buffers, count, &sent, 0, NULL, NULL) == SOCKET_ERROR ? SOCKET_ERROR : sent;
+#else
+			bytesSent = writev(m_Socket, buffers, count);
+#endif
+		}
+
+		m_SendPacketsMutex.Enter();
+
+		if (bytesSent < 0)
+		{
+			int packetsLeft = m_SendPackets.size();
+
+			m_SendPacketsMutex.Leave();
+
+			// wait for the next write readiness notification
+			if (GetNetworkError() == WSAEWOULDBLOCK)
+				return packetsLeft;
+
+			return SOCKET_ERROR;
+		}
+
+		m_nBytesSent += bytesSent;
+		if (m_nBytesSent < 0)
+			m_nBytesSent = 0;
+
+		m_nSendQueueBytes -= bytesSent;
+
+		// remove sent packets, the last one may be sent partially
+		size_t bytesLeft = bytesSent;
+		while (bytesLeft)
+		{
+			CSendPacket* msg = m_SendPackets.front();
+			size_t packetBytesLeft = msg->GetSize() - m_nSendOffset;
+			if (bytesLeft < packetBytesLeft)
+			{
+				m_nSendOffset += bytesLeft;
+				break;
+			}
+
+			bytesLeft -= packetBytesLeft;
+			m_nSendOffset = 0;
+			m_SendPackets.pop_front();
+			delete msg;
+		}
+
+		m_SendPacketsMutex.Leave();
+	}
 }
 
 /**
@@ -433,7 +785,7 @@ bool CExtendedSocket::OnServerConnected()
 	vector<unsigned char> data;
 	data.resize(sizeof(TCP_CONNECTED_MESSAGE));
 
-	if (Read((char*)data.data(), data.size()) != data.size() - 1)
+	if (Read((char*)data.data(), data.size() - 1) != data.size() - 1)
 	{
 		// doesn't look like TCP_CONNECTED_MESSAGE
 		return false;
@@ -466,24 +818,6 @@ SOCKET CExtendedSocket::GetSocket()
 	return m_Socket;
 }
 
-/**
- * Gets received message
- * @return Pointer to received message
- */
-CReceivePacket* CExtendedSocket::GetMsg()
-{
-	return m_pMsg;
-}
-
-/**
- * Sets received message
- * @param msg
- */
-void CExtendedSocket::SetMsg(CReceivePacket* msg)
-{
-	m_pMsg = msg;
-}
-
 /**
  * Gets read result
  * @return Last Read() result
@@ -515,7 +849,7 @@ int CExtendedSocket::GetBytesSent()
  * Gets packets that are in the queue for sending
  * @return Vector of packets to send
  */
-vector<CSendPacket*>& CExtendedSocket::GetPacketsToSend()
+deque<CSendPacket*>& CExtendedSocket::GetPacketsToSend()
 {
 	return m_SendPackets;
 }
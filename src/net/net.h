@@ -3,6 +3,8 @@
 #include <ws2tcpip.h>
 
 #define poll WSAPoll
+
+#define MSG_DONTWAIT 0
 #else
 #include <sys/ioctl.h>
 #include <sys/socket.h>
@@ -12,6 +14,7 @@
 #include <poll.h>
 
 #define WSAEWOULDBLOCK		EWOULDBLOCK
+#define WSAEINPROGRESS		EINPROGRESS
 #define WSAECONNREFUSED     ECONNREFUSED
 #define WSAECONNABORTED		ECONNABORTED
 #define WSAECONNRESET		ECONNRESET
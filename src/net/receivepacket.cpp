@@ -248,7 +248,7 @@ void CReceivePacket::ParseHeader()
 	m_nLength = m_Buffer.readUInt16_LE();
 
 	// check the buf size because packet ID is not part of header?
-	if (m_Buffer.getBuffer().size() > 4)
+	if (m_Buffer.getSize() > 4)
 	{
 		m_nPacketID = m_Buffer.readUInt8();
 
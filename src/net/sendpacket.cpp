@@ -46,11 +46,25 @@ vector<unsigned char> CSendPacket::SetPacketLength()
 	return v;
 }
 
+/**
+ * Writes packet length to buffer in place. Called when the packet is queued for sending
+ */
+void CSendPacket::WritePacketLength()
+{
+	if (m_OutStream.getSize() < PACKET_HEADER_SIZE)
+		return;
+
+	unsigned char* data = m_OutStream.getWritableData();
+	uint16_t size = (uint16_t)(GetSize() - PACKET_HEADER_SIZE);
+	data[2] = (uint8_t)(size & 0xff);
+	data[3] = (uint8_t)(size >> 8);
+}
+
 /**
  * Gets data buffer
  * @return buffer
  */
-Buffer CSendPacket::GetData()
+Buffer& CSendPacket::GetData()
 {
 	return m_OutStream;
 }
@@ -170,6 +184,44 @@ void CSendPacket::WriteArray(const vector<unsigned char>& arr)
 	m_OutStream.writeArray(arr);
 }
 
+/**
+ * Appends shared data to the packet without copying it. Data is sent after everything written to the buffer,
+ * so it must be the last part of the packet and must not be modified after that
+ * @param data
+ */
+void CSendPacket::WriteSharedData(const shared_ptr<vector<unsigned char>>& data)
+{
+	m_pSharedData = data;
+}
+
+/**
+ * Appends shared data to the packet taking over the caller's reference.
+ * If the packet holds the only reference, the data is encrypted in place when sending
+ * @param data
+ */
+void CSendPacket::WriteSharedData(shared_ptr<vector<unsigned char>>&& data)
+{
+	m_pSharedData = move(data);
+}
+
+/**
+ * Gets shared data of the packet
+ * @return Shared data, NULL if there is no shared data
+ */
+const shared_ptr<vector<unsigned char>>& CSendPacket::GetSharedData()
+{
+	return m_pSharedData;
+}
+
+/**
+ * Gets full packet size
+ * @return Size of the buffer and shared data
+ */
+size_t CSendPacket::GetSize()
+{
+	return m_OutStream.getSize() + (m_pSharedData ? m_pSharedData->size() : 0);
+}
+
 /**
  * Sets write offset for buffer
  * @param offset
@@ -194,7 +246,7 @@ void CSendPacket::SetOverride(bool override)
  */
 bool CSendPacket::IsBufferFull()
 {
-	return m_OutStream.getBuffer().size() > PACKET_MAX_SIZE;
+	return GetSize() > PACKET_MAX_SIZE;
 }
 
 /**
@@ -4,6 +4,7 @@
 
 #include "interface/net/iserverlistener.h"
 
+#include "common/net/netdefs.h"
 #include "common/utils.h"
 #include "common/logger.h"
 
@@ -42,6 +43,9 @@ CTCPClient::~CTCPClient()
 {
 	Stop();
 
+	// listen thread could stop the client itself (on disconnect), wait for it before deleting the socket
+	m_ListenThread.Join();
+
 	if (m_pSocket)
 		delete m_pSocket;
 }
@@ -82,7 +86,7 @@ bool CTCPClient::Start(const string& ip, const string& port)
 		return false;
 	}
 
-	if (connect(sock, result->ai_addr, result->ai_addrlen) == SOCKET_ERROR && GetNetworkError() != WSAEWOULDBLOCK)
+	if (connect(sock, result->ai_addr, result->ai_addrlen) == SOCKET_ERROR && GetNetworkError() != WSAEWOULDBLOCK && GetNetworkError() != WSAEINPROGRESS)
 	{
 		Logger().Fatal("connect() failed with error: %d\n%s\n", GetNetworkError(), WSAGetLastErrorString());
 		freeaddrinfo(result);
@@ -135,7 +139,7 @@ void CTCPClient::Listen()
 	tv.tv_sec = 1;
 	tv.tv_usec = 0;
 
-	int activity = select(1, &m_FdsRead, &m_FdsWrite, &m_FdsExcept, &tv);
+	int activity = select(m_pSocket->GetSocket() + 1, &m_FdsRead, &m_FdsWrite, &m_FdsExcept, &tv);
 	if (activity == SOCKET_ERROR)
 	{
 		Logger().Fatal("select() failed with error: %d\n", GetNetworkError());
@@ -170,61 +174,55 @@ void CTCPClient::Listen()
 		}
 		else
 		{
-			CReceivePacket* msg = m_pSocket->Read();
-			int readResult = m_pSocket->GetReadResult();
-			if (readResult == 0)
-			{
-				// connection closed
-				Stop();
-			}
-			else if (readResult == SOCKET_ERROR)
+			// one recv may bring several messages, pass all of them
+			CReceivePacket* msg;
+			do
 			{
-				// error, close connection
-				Stop();
-
-				if (m_pListener)
-					m_pListener->OnTCPError(0);
-			}
-			else if (!msg)
-			{
-				// packet is not valid or wrong sequence or decryption failed
-				/// @fixme should we disconnect here?
-
-				// exclude case when message is not fully read
-				if (!m_pSocket->GetMsg())
+				msg = m_pSocket->Read();
+				int readResult = m_pSocket->GetReadResult();
+				if (msg)
+				{
+					// Important: responsibility for deleting the message is assumed by the listener
+					/// @todo use shared_ptr for messages?
+					if (m_pListener)
+						m_pListener->OnTCPMessage(msg);
+					else
+						delete msg;
+				}
+				else if (readResult == 0)
+				{
+					// connection closed
 					Stop();
-			}
-			else
-			{
-				// Call this to mark that socket is ready to receive a new message
-				m_pSocket->SetMsg(NULL);
-
-				// Important: responsibility for deleting the message is assumed by the listener
-				/// @todo use shared_ptr for messages?
-				if (m_pListener)
-					m_pListener->OnTCPMessage(msg);
-				else
-					delete msg;
-			}
+				}
+				else if (readResult == SOCKET_ERROR)
+				{
+					// error, close connection
+					if (GetNetworkError() != WSAEWOULDBLOCK)
+					{
+						Stop();
+
+						if (m_pListener)
+							m_pListener->OnTCPError(0);
+					}
+				}
+				else if (readResult == PACKET_READ_INVALID)
+				{
+					// packet is not valid or wrong sequence or decryption failed
+					/// @fixme should we disconnect here?
+					Stop();
+				}
+			} while (msg);
 		}
 	}
 
 	if (FD_ISSET(m_pSocket->GetSocket(), &m_FdsWrite)) // data to write
 	{
- 		if (m_pSocket->GetPacketsToSend().size())
+		// send queued packets
+		if (m_pSocket->SendQueuedPackets() == SOCKET_ERROR)
 		{
-			// send the first packet from the queue
-			CSendPacket* msg = m_pSocket->GetPacketsToSend()[0];
-			if (m_pSocket->Send(msg, true) <= 0)
-			{
-				Logger().Fatal("An error occurred while sending packet from queue: WSAGetLastError: %d, queue.size: %d\n", GetNetworkError(), m_pSocket->GetPacketsToSend().size());
+			Logger().Fatal("An error occurred while sending packet from queue: WSAGetLastError: %d, queue.size: %d\n", GetNetworkError(), m_pSocket->GetPacketsToSend().size());
 
-				Stop();
-			}
-			else
-			{
-				m_pSocket->GetPacketsToSend().erase(m_pSocket->GetPacketsToSend().begin());
-			}
+			Stop();
 		}
 	}
 
@@ -7,6 +7,8 @@
 #include "common/utils.h"
 #include "common/logger.h"
 
+#include <algorithm>
+
 #define CERT_FILE "Data/Certs/server-cert.pem"
 #define KEY_FILE  "Data/Certs/server-key.pem"
 
@@ -15,9 +17,8 @@ using namespace std;
 /** 
  * Constructor.
  */
-CTCPServer::CTCPServer() : m_ListenThread(ListenThread, this)
+CTCPServer::CTCPServer()
 {
-	m_Socket = INVALID_SOCKET;
 	m_bIsRunning = false;
 	m_pListener = NULL;
 	m_pCriticalSection = NULL;
@@ -44,13 +45,14 @@ CTCPServer::~CTCPServer()
 }
 
 /** 
- * Create socket and start listening.
+ * Create listen sockets and start worker threads.
  * @param port Server's port
  * @param tcpSendBufferSize Send buffer size for TCP
  * @param ssl Whether or not to use SSL
+ * @param workerCount Number of I/O threads, each one gets its own listen socket bound with SO_REUSEPORT
  * @return True on success, false on error
  */
-bool CTCPServer::Start(const string& port, int tcpSendBufferSize, bool ssl)
+bool CTCPServer::Start(const string& port, int tcpSendBufferSize, bool ssl, int workerCount)
 {
 	if (IsRunning())
 		return false;
@@ -61,6 +63,46 @@ bool CTCPServer::Start(const string& port, int tcpSendBufferSize, bool ssl)
 	if (ssl)
 		InitSSLContext();
 
+#ifdef WIN32
+	// there is no SO_REUSEPORT load balancing on Windows
+	if (workerCount > 1)
+	{
+		Logger().Warn("CTCPServer::Start: multiple I/O threads are not supported on this platform, using 1\n");
+		workerCount = 1;
+	}
+#endif
+	if (workerCount < 1)
+		workerCount = 1;
+
+	for (int i = 0; i < workerCount; i++)
+	{
+		CTCPServerWorker* worker = new CTCPServerWorker(this, i);
+		m_Workers.push_back(worker);
+
+		SOCKET listenSocket = CreateListenSocket(port, tcpSendBufferSize, workerCount > 1);
+		if (listenSocket == INVALID_SOCKET || !worker->Start(listenSocket))
+		{
+			// stop workers that have already been started
+			m_bIsRunning = true;
+			Stop();
+			return false;
+		}
+	}
+
+	m_bIsRunning = true;
+
+	return true;
+}
+
+/**
+ * Creates listening socket
+ * @param port Server's port
+ * @param tcpSendBufferSize Send buffer size for TCP
+ * @param reusePort Allow several sockets to be bound to the same port
+ * @return Listening socket, INVALID_SOCKET on error
+ */
+SOCKET CTCPServer::CreateListenSocket(const string& port, int tcpSendBufferSize, bool reusePort)
+{
 	struct addrinfo* result = NULL;
 	struct addrinfo hints;
 
@@ -75,68 +117,79 @@ bool CTCPServer::Start(const string& port, int tcpSendBufferSize, bool ssl)
 	if (m_nResult != 0)
 	{
 		Logger().Fatal("getaddrinfo() failed with error: %d\n%s\n", m_nResult, WSAGetLastErrorString());
-		return false;
+		return INVALID_SOCKET;
 	}
 
 	// Create a SOCKET for connecting to server
-	m_Socket = socket(result->ai_family, result->ai_socktype, result->ai_protocol);
-	if (m_Socket == INVALID_SOCKET)
+	SOCKET listenSocket = socket(result->ai_family, result->ai_socktype, result->ai_protocol);
+	if (listenSocket == INVALID_SOCKET)
 	{
 		Logger().Fatal("socket() failed with error: %ld\n%s\n", GetNetworkError(), WSAGetLastErrorString());
 		freeaddrinfo(result);
-		return false;
+		return INVALID_SOCKET;
 	}
 	
 	// Set the mode of the socket to be nonblocking
 	u_long iMode = 1;
-	m_nResult = ioctlsocket(m_Socket, FIONBIO, &iMode);
+	m_nResult = ioctlsocket(listenSocket, FIONBIO, &iMode);
 	if (m_nResult == SOCKET_ERROR)
 	{
 		Logger().Fatal("ioctlsocket() failed with error: %d\n%s\n", GetNetworkError(), WSAGetLastErrorString());
-		closesocket(m_Socket);
-		return false;
+		freeaddrinfo(result);
+		closesocket(listenSocket);
+		return INVALID_SOCKET;
 	}
 
+#ifndef WIN32
+	// slow clients are disconnected by the server, allow restarting while their connections are in TIME_WAIT
+	int reuseAddr = 1;
+	setsockopt(listenSocket, SOL_SOCKET, SO_REUSEADDR, (char*)&reuseAddr, sizeof(reuseAddr));
+
+	if (reusePort)
+	{
+		// the kernel distributes incoming connections between all sockets bound to the port
+		int value = 1;
+		m_nResult = setsockopt(listenSocket, SOL_SOCKET, SO_REUSEPORT, (char*)&value, sizeof(value));
+		if (m_nResult == SOCKET_ERROR)
+		{
+			Logger().Fatal("setsockopt(SO_REUSEPORT) failed with error %d\n%s\n", GetNetworkError(), WSAGetLastErrorString());
+			freeaddrinfo(result);
+			closesocket(listenSocket);
+			return INVALID_SOCKET;
+		}
+	}
+#endif
+
 	// Setup the TCP listening socket
-	m_nResult = ::bind(m_Socket, result->ai_addr, (int)result->ai_addrlen);
+	m_nResult = ::bind(listenSocket, result->ai_addr, (int)result->ai_addrlen);
 	if (m_nResult == SOCKET_ERROR)
 	{
 		Logger().Fatal("bind failed with error: %d\n%s\n", GetNetworkError(), WSAGetLastErrorString());
 		freeaddrinfo(result);
-		closesocket(m_Socket);
-		return false;
+		closesocket(listenSocket);
+		return INVALID_SOCKET;
 	}
 
 	freeaddrinfo(result);
 
 	// start listening for new clients attempting to connect
-	m_nResult = listen(m_Socket, SOMAXCONN);
+	m_nResult = listen(listenSocket, SOMAXCONN);
 	if (m_nResult == SOCKET_ERROR)
 	{
 		Logger().Fatal("listen() failed with error: %d\n%s\n", GetNetworkError(), WSAGetLastErrorString());
-		closesocket(m_Socket);
-		return false;
+		closesocket(listenSocket);
+		return INVALID_SOCKET;
 	}
 
-	m_nResult = setsockopt(m_Socket, SOL_SOCKET, SO_SNDBUF, (char*)&tcpSendBufferSize, sizeof(tcpSendBufferSize));
+	m_nResult = setsockopt(listenSocket, SOL_SOCKET, SO_SNDBUF, (char*)&tcpSendBufferSize, sizeof(tcpSendBufferSize));
 	if (m_nResult == SOCKET_ERROR)
 	{
 		Logger().Fatal("setsockopt failed with error %d\n%s\n", GetNetworkError(), WSAGetLastErrorString());
-		closesocket(m_Socket);
-		return false;
+		closesocket(listenSocket);
+		return INVALID_SOCKET;
 	}
 
-	WSAPOLLFD fd;
-	fd.fd = m_Socket;
-	fd.events = POLLRDNORM;
-	fd.revents = 0;
-	m_fds.push_back(fd);
-
-	m_bIsRunning = true;
-	
-	m_ListenThread.Start();
-
-	return true;
+	return listenSocket;
 }
 
 /** 
@@ -148,21 +201,30 @@ void CTCPServer::Stop()
 	{
 		m_bIsRunning = false;
 
-		m_ListenThread.Join();
+		// stop I/O first, workers delete clients they have already removed
+		for (auto worker : m_Workers)
+			worker->Stop();
 
 		for (auto client : m_Clients)
 		{
 			delete client;
 		}
 
-		m_fds.clear();
+		m_Clients.clear();
+		m_ClientIndices.clear();
+		m_ClientSockets.clear();
+		m_ClientIDs.clear();
 
-		closesocket(m_Socket);
+		for (auto worker : m_Workers)
+			delete worker;
+
+		m_Workers.clear();
 
 		if (m_pCTX)
 		{
 			// Free the wolfSSL context object
 			wolfSSL_CTX_free(m_pCTX);
+			m_pCTX = NULL;
 		}
 
 		// Cleanup the wolfSSL environment
@@ -170,157 +232,6 @@ void CTCPServer::Stop()
 	}
 }
 
-/**
- * Listen and wait for incoming data
- */
-void CTCPServer::Listen()
-{	
-	int result = poll(m_fds.data(), m_fds.size(), 1000);
-	if (result == SOCKET_ERROR)
-	{
-		Logger().Error("poll() failed with error: %d\n", GetNetworkError());
-
-		if (m_pListener)
-			m_pListener->OnTCPError(0);
-
-		return;
-	}
-
-	// nothing happens
-	if (!result)
-		return;
-
-	if (m_pCriticalSection)
-		m_pCriticalSection->Enter();
-
-	for (auto it = m_fds.begin(); it != m_fds.end(); it++)
-	{
-		if (it->revents & POLLRDNORM)
-		{
-			if (it->fd == m_Socket)
-			{
-				IExtendedSocket* socket = Accept(m_nNextClientIndex);
-				if (!socket)
-					continue;
-
-				Logger().Info("Client (%d, %s) has been connected to the server\n", m_nNextClientIndex, socket->GetIP().c_str());
-
-				if (m_pListener)
-				{
-					if (!m_pListener->OnTCPConnectionCreated(socket))
-					{
-						// start cycle from the beginning after disconnecting the IP banned client, probably not the best solution
-						it = m_fds.begin();
-						continue;
-					}
-				}
-
-				m_nNextClientIndex++;
-
-				WSAPOLLFD fd;
-				fd.fd = socket->GetSocket();
-				fd.events = POLLRDNORM | POLLWRNORM;
-				fd.revents = 0;
-				m_fds.push_back(fd);
-
-				// start cycle from the beginning after pushing to vector, probably not the best solution
-				it = m_fds.begin();
-				continue;
-			}
-			// read from client
-			else
-			{
-				IExtendedSocket* socket = GetExSocketBySocket(it->fd);
-				if (!socket)
-					continue;
-
-				CReceivePacket* msg = socket->Read();
-				int readResult = socket->GetReadResult();
-				if (readResult == 0)
-				{
-					it->revents |= POLLHUP;
-				}
-				else if (readResult == SOCKET_ERROR)
-				{
-					it->revents |= POLLERR;
-
-					if (m_pListener)
-						m_pListener->OnTCPError(0);
-				}
-				else if (!msg)
-				{
-					// packet is not valid or wrong sequence or decryption failed
-					// exclude case when message is not fully read
-					if (!socket->GetMsg())
-					{
-						it->revents |= POLLERR;
-
-						if (m_pListener)
-							m_pListener->OnTCPError(0);
-					}
-				}
-				else
-				{
-					// Call this to mark that socket is ready to receive a new message
-					socket->SetMsg(NULL);
-
-					// Important: responsibility for deleting the message is assumed by the listener
-					/// @todo use shared_ptr for messages?
-					if (m_pListener)
-						m_pListener->OnTCPMessage(socket, msg);
-					else
-						delete msg;
-				}
-			}
-		}
-
-		// write to client
-		if (it->revents & POLLWRNORM && !(it->revents & (POLLERR | POLLHUP)))
-		{
-			IExtendedSocket* socket = GetExSocketBySocket(it->fd);
-			if (!socket)
-				continue;
-
-			if (socket->GetPacketsToSend().size())
-			{
-				CSendPacket* msg = socket->GetPacketsToSend().at(0);
-				int sendResult = socket->Send(msg, true);
-				if (sendResult <= 0)
-				{
-					int error = GetNetworkError();
-					if (error != WSAEWOULDBLOCK)
-					{
-						it->revents |= POLLERR;
-
-						Logger().Warn("An error occurred while sending packet from queue: WSAGetLastError: %d, queue.size: %d\n", error, socket->GetPacketsToSend().size());
-
-						if (m_pListener)
-							m_pListener->OnTCPError(0);
-					}
-				}
-				else
-				{
-					socket->GetPacketsToSend().erase(socket->GetPacketsToSend().begin());
-				}
-			}
-		}
-
-		// client closed the connection or had a socket error or sent an invalid packet or sent wrong sequence or decryption failed
-		if (it->revents & (POLLERR | POLLHUP) && it->fd != m_Socket)
-		{
-			IExtendedSocket* socket = GetExSocketBySocket(it->fd);
-			if (socket)
-				DisconnectClient(socket);
-
-			it = m_fds.begin(); // not the best solution
-			continue;
-		}
-	}
-
-	if (m_pCriticalSection)
-		m_pCriticalSection->Leave();
-}
-
 /**
  * Initialize SSL context
  */
@@ -359,18 +270,31 @@ void CTCPServer::InitSSLContext()
 
 /**
  * Accepts connection on a socket
- * @param id Number 
- * @return Pointer to CExtendedSocket, NULL on error
+ * @param listenSocket Listening socket of the worker
+ * @param worker Worker that will serve the connection
+ * @return Pointer to CExtendedSocket, NULL on error or if there are no pending connections
  */
-IExtendedSocket* CTCPServer::Accept(unsigned int id)
+CExtendedSocket* CTCPServer::Accept(SOCKET listenSocket, CTCPServerWorker* worker)
 {
 	sockaddr_in addr;
 	socklen_t addrlen = sizeof(addr);
 
-	SOCKET clientSocket = accept(m_Socket, (sockaddr*)&addr, &addrlen);
+	SOCKET clientSocket = accept(listenSocket, (sockaddr*)&addr, &addrlen);
 	if (clientSocket == INVALID_SOCKET)
 	{
-		Logger().Fatal("accept() failed with error: %d\n%s\n", GetNetworkError(), WSAGetLastErrorString());
+		// no pending connections left
+		if (GetNetworkError() != WSAEWOULDBLOCK)
+			Logger().Fatal("accept() failed with error: %d\n%s\n", GetNetworkError(), WSAGetLastErrorString());
+
+		return NULL;
+	}
+
+	// the worker flushes the send queue on EPOLLOUT, a blocking writev() to a client that doesn't read would stall every client of the worker
+	u_long iMode = 1;
+	if (ioctlsocket(clientSocket, FIONBIO, &iMode) == SOCKET_ERROR)
+	{
+		Logger().Error("ioctlsocket() failed with error: %d\n%s\n", GetNetworkError(), WSAGetLastErrorString());
+		closesocket(clientSocket);
 		return NULL;
 	}
 
@@ -382,10 +306,10 @@ IExtendedSocket* CTCPServer::Accept(unsigned int id)
 	char ip[INET_ADDRSTRLEN];
 	inet_ntop(AF_INET, &addr.sin_addr, ip, INET_ADDRSTRLEN);
 
-	CExtendedSocket* newSocket = new CExtendedSocket(clientSocket, id);
+	CExtendedSocket* newSocket = new CExtendedSocket(clientSocket, m_nNextClientIndex++);
 	newSocket->SetIP(ip);
-
-	m_Clients.push_back(newSocket);
+	newSocket->SetWorker(worker);
+	newSocket->SetSendQueueLimit(max(g_pServerConfig->tcpSendQueueLimit, 0));
 
 	// send server connected message
 	static const string connectedMsg = TCP_CONNECTED_MESSAGE;
@@ -399,26 +323,44 @@ IExtendedSocket* CTCPServer::Accept(unsigned int id)
 		if (newSSL == NULL)
 		{
 			Logger().Fatal("wolfSSL_new() failed to create WOLFSSL object\n");
+			delete newSocket;
 			return NULL;
 		}
 
 		// Attach wolfSSL to the socket
 		wolfSSL_set_fd(newSSL, clientSocket);
 
-		// Establish TLS connection
-		int ret, err;
-		do
-		{
-			ret = wolfSSL_accept(newSSL);
-			err = wolfSSL_get_error(newSSL, ret);
-		} while (err == WOLFSSL_ERROR_WANT_READ || err == WOLFSSL_ERROR_WANT_WRITE);
-
-		newSocket->SetSSLObject(newSSL);
+		// the socket is non-blocking, TLS connection is established by the worker
+		newSocket->StartHandshake(newSSL);
 	}
 
 	return newSocket;
 }
 
+/**
+ * Adds accepted client to the client list, starts serving it by its worker and notifies the listener
+ * @param socket
+ */
+void CTCPServer::AddClient(CExtendedSocket* socket)
+{
+	Lock();
+
+	m_ClientIndices[socket] = m_Clients.size();
+	m_ClientSockets[socket->GetSocket()] = socket;
+	m_ClientIDs[socket->GetID()] = socket;
+	m_Clients.push_back(socket);
+
+	socket->GetWorker()->AddClient(socket);
+
+	Logger().Info("Client (%d, %s) has been connected to the server\n", socket->GetID(), socket->GetIP().c_str());
+
+	// the listener disconnects IP banned clients by itself
+	if (m_pListener)
+		m_pListener->OnTCPConnectionCreated(socket);
+
+	Unlock();
+}
+
 /**
  * Gets extended socket by socket descriptor value
  * @param socket
@@ -426,42 +368,58 @@ IExtendedSocket* CTCPServer::Accept(unsigned int id)
  */
 IExtendedSocket* CTCPServer::GetExSocketBySocket(SOCKET socket)
 {
-	for (auto s : m_Clients)
-	{
-		if (s->GetSocket() == socket)
-			return s;
-	}
+	auto it = m_ClientSockets.find(socket);
+	if (it == m_ClientSockets.end())
+		return NULL;
 
-	return NULL;
+	return it->second;
 }
 
 /**
- * Disconnects client by extended socket object and deletes it
+ * Gets extended socket by client ID
+ * @param id
+ * @return Pointer to CExtendedSocket, NULL if not exists
+ */
+IExtendedSocket* CTCPServer::GetExSocketByID(unsigned int id)
+{
+	auto it = m_ClientIDs.find(id);
+	if (it == m_ClientIDs.end())
+		return NULL;
+
+	return it->second;
+}
+
+/**
+ * Disconnects client by extended socket object. The socket is deleted by its worker after the current listen pass.
+ * Must be called inside the critical section
  * @param socket
  */
 void CTCPServer::DisconnectClient(IExtendedSocket* socket)
 {
+	auto it = m_ClientIndices.find(socket);
+	if (it == m_ClientIndices.end())
+		return; // already disconnected
+
+	// swap with the last client to remove it in O(1)
+	size_t index = it->second;
+	IExtendedSocket* lastSocket = m_Clients.back();
+	m_Clients[index] = lastSocket;
+	m_ClientIndices[lastSocket] = index;
+	m_Clients.pop_back();
+	m_ClientIndices.erase(socket);
+
+	m_ClientSockets.erase(socket->GetSocket());
+	m_ClientIDs.erase(socket->GetID());
+
+	// all clients are accepted by the server, no more messages from this socket after that
+	CExtendedSocket* exSocket = static_cast<CExtendedSocket*>(socket);
+	exSocket->GetWorker()->RemoveClient(exSocket);
+
 	// connection closed
 	if (m_pListener)
 		m_pListener->OnTCPConnectionClosed(socket);
 
 	Logger().Info("Client (%d, %s) has been disconnected from the server\n", socket->GetID(), socket->GetIP().c_str());
-
-	SOCKET s = socket->GetSocket();
-	m_fds.erase(remove_if(m_fds.begin(), m_fds.end(),
-		[s](WSAPOLLFD fd)
-		{
-			if (fd.fd == s)
-			{
-				return true;
-			}
-
-			return false;
-		}
-	), m_fds.end());
-
-	delete socket;
-	m_Clients.erase(remove(m_Clients.begin(), m_Clients.end(), socket), m_Clients.end());
 }
 
 /**
@@ -482,6 +440,19 @@ bool CTCPServer::IsRunning()
 	return m_bIsRunning;
 }
 
+/**
+ * Gets counters of I/O threads
+ * @return Vector of worker stats
+ */
+vector<TCPWorkerStats_s> CTCPServer::GetWorkerStats()
+{
+	vector<TCPWorkerStats_s> stats;
+	for (auto worker : m_Workers)
+		stats.push_back(worker->GetStats());
+
+	return stats;
+}
+
 /**
  * Sets listen object
  * @param listener Listener object
@@ -498,4 +469,30 @@ void CTCPServer::SetListener(IServerListenerTCP* listener)
 void CTCPServer::SetCriticalSection(CCriticalSection* criticalSection)
 {
 	m_pCriticalSection = criticalSection;
-}
\ No newline at end of file
+}
+/**
+ * Gets listen object
+ * @return Listener object
+ */
+IServerListenerTCP* CTCPServer::GetListener()
+{
+	return m_pListener;
+}
+
+/**
+ * Enters critical section if it's set
+ */
+void CTCPServer::Lock()
+{
+	if (m_pCriticalSection)
+		m_pCriticalSection->Enter();
+}
+
+/**
+ * Leaves critical section if it's set
+ */
+void CTCPServer::Unlock()
+{
+	if (m_pCriticalSection)
+		m_pCriticalSection->Leave();
+}
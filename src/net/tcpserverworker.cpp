@@ -0,0 +1,594 @@
+#include "net/tcpserverworker.h"
+#include "net/tcpserver.h"
+#include "net/extendedsocket.h"
+#include "interface/net/iserverlistener.h"
+
+#include "common/net/netdefs.h"
+#include "common/utils.h"
+#include "common/logger.h"
+
+#include <algorithm>
+#include <chrono>
+
+using namespace std;
+
+/**
+ * Constructor.
+ * @param server Server that owns this worker
+ * @param id Worker number
+ */
+CTCPServerWorker::CTCPServerWorker(CTCPServer* server, int id) : m_ListenThread(ListenThread, this)
+{
+	m_pServer = server;
+	m_nID = id;
+	m_Socket = INVALID_SOCKET;
+	m_bIsRunning = false;
+#ifndef WIN32
+	m_nEpollFD = -1;
+#endif
+	m_nAcceptedConnections = 0;
+	m_nPacketsReceived = 0;
+	m_nBytesReceived = 0;
+	m_nBytesSent = 0;
+}
+
+/**
+ * Destructor.
+ */
+CTCPServerWorker::~CTCPServerWorker()
+{
+	Stop();
+}
+
+/**
+ * Starts the worker thread
+ * @param listenSocket Listening socket, the worker takes ownership of it
+ * @return True on success, false on error
+ */
+bool CTCPServerWorker::Start(SOCKET listenSocket)
+{
+	if (IsRunning())
+		return false;
+
+	m_Socket = listenSocket;
+
+#ifdef WIN32
+	WSAPOLLFD fd;
+	fd.fd = m_Socket;
+	fd.events = POLLRDNORM;
+	fd.revents = 0;
+	m_fds.push_back(fd);
+#else
+	m_nEpollFD = epoll_create1(0);
+	if (m_nEpollFD == SOCKET_ERROR)
+	{
+		Logger().Fatal("epoll_create1() failed with error: %d\n%s\n", GetNetworkError(), WSAGetLastErrorString());
+		closesocket(m_Socket);
+		m_Socket = INVALID_SOCKET;
+		return false;
+	}
+
+	// listen socket is the only one registered with NULL user data
+	epoll_event ev = {};
+	ev.events = EPOLLIN | EPOLLET;
+	ev.data.ptr = NULL;
+	if (epoll_ctl(m_nEpollFD, EPOLL_CTL_ADD, m_Socket, &ev) == SOCKET_ERROR)
+	{
+		Logger().Fatal("epoll_ctl() failed with error: %d\n%s\n", GetNetworkError(), WSAGetLastErrorString());
+		closesocket(m_nEpollFD);
+		closesocket(m_Socket);
+		m_nEpollFD = -1;
+		m_Socket = INVALID_SOCKET;
+		return false;
+	}
+
+	m_EpollEvents.resize(64);
+#endif
+
+	m_bIsRunning = true;
+
+	m_ListenThread.Start();
+
+	return true;
+}
+
+/**
+ * Stops the worker thread. Client sockets are deleted by the server, only already removed ones are deleted here
+ */
+void CTCPServerWorker::Stop()
+{
+	if (!IsRunning())
+		return;
+
+	m_bIsRunning = false;
+
+	m_ListenThread.Join();
+
+	m_Mutex.Enter();
+
+	m_Clients.clear();
+	m_HandshakingClients.clear();
+
+	for (auto socket : m_RemovedClients)
+		delete socket;
+
+	m_RemovedClients.clear();
+
+#ifdef WIN32
+	m_fds.clear();
+#else
+	closesocket(m_nEpollFD);
+	m_nEpollFD = -1;
+#endif
+
+	m_Mutex.Leave();
+
+	closesocket(m_Socket);
+	m_Socket = INVALID_SOCKET;
+}
+
+/**
+ * Waits for incoming data and handles it. The server critical section is entered only to accept and disconnect clients,
+ * received messages are passed to the listener after the worker mutex is released
+ */
+void CTCPServerWorker::Listen()
+{
+	IServerListenerTCP* listener = m_pServer->GetListener();
+	bool acceptReady = false;
+	vector<CExtendedSocket*> disconnectedClients;
+	vector<pair<CExtendedSocket*, CReceivePacket*>> messages;
+
+#ifdef WIN32
+	// poll a copy, other threads add and remove descriptors
+	m_Mutex.Enter();
+	vector<WSAPOLLFD> fds = m_fds;
+	m_Mutex.Leave();
+
+	int result = poll(fds.data(), fds.size(), 1000);
+#else
+	int result = epoll_wait(m_nEpollFD, m_EpollEvents.data(), m_EpollEvents.size(), 1000);
+	if (result == SOCKET_ERROR && GetNetworkError() == EINTR)
+		return;
+#endif
+	if (result == SOCKET_ERROR)
+	{
+		Logger().Error("poll() failed with error: %d\n", GetNetworkError());
+
+		if (listener)
+			listener->OnTCPError(0);
+
+		return;
+	}
+
+	m_Mutex.Enter();
+
+#ifdef WIN32
+	for (auto& fd : fds)
+	{
+		if (!fd.revents)
+			continue;
+
+		if (fd.fd == m_Socket)
+		{
+			if (fd.revents & POLLRDNORM)
+				acceptReady = true;
+
+			continue;
+		}
+
+		auto it = m_Clients.find(fd.fd);
+		if (it == m_Clients.end())
+			continue;
+
+		CExtendedSocket* socket = it->second;
+		int bytesReceived = socket->GetBytesReceived();
+		int bytesSent = socket->GetBytesSent();
+		bool connected = true;
+		bool readable = fd.revents & (POLLRDNORM | POLLERR | POLLHUP);
+		bool writable = fd.revents & POLLWRNORM;
+
+		// once TLS handshake is done, read data that came with the last handshake message and send packets queued meanwhile
+		if (socket->IsHandshaking())
+		{
+			connected = HandshakeClient(socket);
+			readable = writable = connected && !socket->IsHandshaking();
+		}
+
+		if (connected && readable)
+			connected = ReadClient(socket, false, messages);
+
+		if (connected && writable)
+			connected = FlushClient(socket);
+
+		m_nBytesReceived += max(socket->GetBytesReceived() - bytesReceived, 0);
+		m_nBytesSent += max(socket->GetBytesSent() - bytesSent, 0);
+
+		// client closed the connection or had a socket error or sent an invalid packet or sent wrong sequence or decryption failed
+		if (!connected)
+			disconnectedClients.push_back(socket);
+	}
+#else
+	for (int i = 0; i < result; i++)
+	{
+		epoll_event& ev = m_EpollEvents[i];
+		if (!ev.data.ptr)
+		{
+			acceptReady = true;
+			continue;
+		}
+
+		CExtendedSocket* socket = static_cast<CExtendedSocket*>(ev.data.ptr);
+
+		// skip clients that were removed by another thread while we were waiting, they are deleted at the end of this pass
+		auto it = m_Clients.find(socket->GetSocket());
+		if (it == m_Clients.end() || it->second != socket)
+			continue;
+
+		int bytesReceived = socket->GetBytesReceived();
+		int bytesSent = socket->GetBytesSent();
+		bool connected = true;
+		bool readable = ev.events & (EPOLLIN | EPOLLRDHUP | EPOLLERR | EPOLLHUP);
+		bool writable = ev.events & EPOLLOUT;
+
+		// once TLS handshake is done, read data that came with the last handshake message and send packets queued meanwhile
+		if (socket->IsHandshaking())
+		{
+			connected = HandshakeClient(socket);
+			readable = writable = connected && !socket->IsHandshaking();
+		}
+
+		// hangups and errors are detected by recv() result
+		if (connected && readable)
+			connected = ReadClient(socket, true, messages);
+
+		if (connected && writable)
+			connected = FlushClient(socket);
+
+		m_nBytesReceived += max(socket->GetBytesReceived() - bytesReceived, 0);
+		m_nBytesSent += max(socket->GetBytesSent() - bytesSent, 0);
+
+		// client closed the connection or had a socket error or sent an invalid packet or sent wrong sequence or decryption failed
+		if (!connected)
+			disconnectedClients.push_back(socket);
+	}
+
+	// all slots were used, there may be more ready sockets than we can take per call
+	if (result == (int)m_EpollEvents.size())
+		m_EpollEvents.resize(m_EpollEvents.size() * 2);
+#endif
+
+	CheckHandshakeTimeouts(disconnectedClients);
+
+	// publish messages without holding the worker mutex, the listener may block on the event queue
+	// while the event thread waits for the mutex to remove a client
+	if (!messages.empty())
+	{
+		m_PublishMutex.Enter();
+		m_Mutex.Leave();
+
+		PublishMessages(messages);
+
+		m_PublishMutex.Leave();
+	}
+	else
+	{
+		m_Mutex.Leave();
+	}
+
+	if (!disconnectedClients.empty())
+	{
+		m_pServer->Lock();
+
+		for (auto socket : disconnectedClients)
+			m_pServer->DisconnectClient(socket);
+
+		m_pServer->Unlock();
+	}
+
+	if (acceptReady)
+		AcceptClients();
+
+	DeleteRemovedClients();
+}
+
+/**
+ * Checks if worker is running
+ * @return Running status
+ */
+bool CTCPServerWorker::IsRunning()
+{
+	return m_bIsRunning;
+}
+
+/**
+ * Accepts all pending connections on the worker's listen socket
+ */
+void CTCPServerWorker::AcceptClients()
+{
+	while (CExtendedSocket* socket = m_pServer->Accept(m_Socket, this))
+	{
+		m_nAcceptedConnections++;
+
+		m_pServer->AddClient(socket);
+
+#ifdef WIN32
+		// WSAPoll is level-triggered, accept the rest on the next call
+		break;
+#endif
+	}
+}
+
+/**
+ * Starts watching client socket
+ * @param socket
+ */
+void CTCPServerWorker::AddClient(CExtendedSocket* socket)
+{
+	m_Mutex.Enter();
+
+	m_Clients[socket->GetSocket()] = socket;
+
+	if (socket->IsHandshaking())
+		m_HandshakingClients.insert(socket);
+
+#ifdef WIN32
+	WSAPOLLFD fd;
+	fd.fd = socket->GetSocket();
+	fd.events = POLLRDNORM | POLLWRNORM;
+	fd.revents = 0;
+	m_fds.push_back(fd);
+#else
+	epoll_event ev = {};
+	ev.events = EPOLLIN | EPOLLRDHUP | EPOLLET;
+	ev.data.ptr = socket;
+	if (epoll_ctl(m_nEpollFD, EPOLL_CTL_ADD, socket->GetSocket(), &ev) == SOCKET_ERROR)
+		Logger().Error("epoll_ctl() failed to add client socket with error: %d\n", GetNetworkError());
+#endif
+
+	m_Mutex.Leave();
+}
+
+/**
+ * Stops watching client socket. The socket is deleted by the worker thread after its current listen pass.
+ * No messages of the client are passed to the listener after the call. Must not be called from the listener's OnTCPMessage
+ * @param socket
+ */
+void CTCPServerWorker::RemoveClient(CExtendedSocket* socket)
+{
+	m_Mutex.Enter();
+
+	SOCKET s = socket->GetSocket();
+	m_Clients.erase(s);
+	m_HandshakingClients.erase(socket);
+
+#ifdef WIN32
+	m_fds.erase(remove_if(m_fds.begin(), m_fds.end(),
+		[s](WSAPOLLFD fd)
+		{
+			if (fd.fd == s)
+			{
+				return true;
+			}
+
+			return false;
+		}
+	), m_fds.end());
+#else
+	epoll_ctl(m_nEpollFD, EPOLL_CTL_DEL, s, NULL);
+#endif
+
+	m_RemovedClients.push_back(socket);
+
+	m_Mutex.Leave();
+
+	// wait until messages of the client read in the current listen pass are published
+	m_PublishMutex.Enter();
+	m_PublishMutex.Leave();
+}
+
+/**
+ * Enables or disables write readiness notifications for client. Enabled only while the send queue is not empty
+ * @param socket
+ * @param watch
+ */
+void CTCPServerWorker::WatchWritable(CExtendedSocket* socket, bool watch)
+{
+#ifndef WIN32
+	epoll_event ev = {};
+	ev.events = EPOLLIN | EPOLLRDHUP | EPOLLET;
+	if (watch)
+		ev.events |= EPOLLOUT;
+
+	ev.data.ptr = socket;
+
+	// EPOLL_CTL_MOD reports EPOLLOUT right away if the socket is already writable.
+	// Fails with ENOENT if the client has already been removed, that's fine
+	epoll_ctl(m_nEpollFD, EPOLL_CTL_MOD, socket->GetSocket(), &ev);
+#endif
+}
+
+/**
+ * Gets worker counters
+ * @return Worker stats
+ */
+TCPWorkerStats_s CTCPServerWorker::GetStats()
+{
+	TCPWorkerStats_s stats;
+	stats.id = m_nID;
+
+	m_Mutex.Enter();
+	stats.connections = m_Clients.size();
+	m_Mutex.Leave();
+
+	stats.acceptedConnections = m_nAcceptedConnections;
+	stats.packetsReceived = m_nPacketsReceived;
+	stats.bytesReceived = m_nBytesReceived;
+	stats.bytesSent = m_nBytesSent;
+
+	return stats;
+}
+
+/**
+ * Continues TLS handshake of client, called when the socket is readable or writable
+ * @param socket
+ * @return False if client must be disconnected
+ */
+bool CTCPServerWorker::HandshakeClient(CExtendedSocket* socket)
+{
+	if (!socket->ContinueHandshake())
+	{
+		IServerListenerTCP* listener = m_pServer->GetListener();
+		if (listener)
+			listener->OnTCPError(0);
+
+		return false;
+	}
+
+	if (!socket->IsHandshaking())
+		m_HandshakingClients.erase(socket);
+
+	return true;
+}
+
+/**
+ * Collects clients that didn't finish TLS handshake in TCP_SSL_HANDSHAKE_TIMEOUT seconds.
+ * Called every listen pass, poll returns at least once a second
+ * @param disconnectedClients Receives clients to disconnect
+ */
+void CTCPServerWorker::CheckHandshakeTimeouts(vector<CExtendedSocket*>& disconnectedClients)
+{
+	if (m_HandshakingClients.empty())
+		return;
+
+	auto now = chrono::steady_clock::now();
+	for (auto socket : m_HandshakingClients)
+	{
+		if (now - socket->GetHandshakeStartTime() < chrono::seconds(TCP_SSL_HANDSHAKE_TIMEOUT))
+			continue;
+
+		Logger().Warn("Client (%d, %s) didn't finish TLS handshake in %d seconds\n", socket->GetID(), socket->GetIP().c_str(), TCP_SSL_HANDSHAKE_TIMEOUT);
+
+		if (find(disconnectedClients.begin(), disconnectedClients.end(), socket) == disconnectedClients.end())
+			disconnectedClients.push_back(socket);
+	}
+}
+
+/**
+ * Reads incoming data and collects received messages, they are passed to the listener after the worker mutex is released
+ * @param socket
+ * @param drain Read until the socket would block (required by edge-triggered epoll).
+ *              Otherwise reads once, but still collects every complete message from the receive buffer
+ * @param messages Receives messages in the order they were read
+ * @return False if client must be disconnected
+ */
+bool CTCPServerWorker::ReadClient(CExtendedSocket* socket, bool drain, vector<pair<CExtendedSocket*, CReceivePacket*>>& messages)
+{
+	IServerListenerTCP* listener = m_pServer->GetListener();
+	CReceivePacket* msg;
+
+	do
+	{
+		msg = socket->Read();
+		int readResult = socket->GetReadResult();
+		if (msg)
+		{
+			m_nPacketsReceived++;
+			messages.push_back(make_pair(socket, msg));
+		}
+		else if (readResult == 0)
+		{
+			// connection closed
+			return false;
+		}
+		else if (readResult == SOCKET_ERROR)
+		{
+			// nothing left to read
+			if (GetNetworkError() == WSAEWOULDBLOCK)
+				return true;
+
+			if (listener)
+				listener->OnTCPError(0);
+
+			return false;
+		}
+		else if (readResult == PACKET_READ_INVALID)
+		{
+			// packet is not valid or wrong sequence or decryption failed
+			if (listener)
+				listener->OnTCPError(0);
+
+			return false;
+		}
+
+		// otherwise the message is not fully read
+	} while (drain || msg);
+
+	return true;
+}
+
+/**
+ * Passes messages read in the current listen pass to the listener.
+ * Sockets stay valid, removed clients are deleted by this thread after the pass
+ * @param messages
+ */
+void CTCPServerWorker::PublishMessages(vector<pair<CExtendedSocket*, CReceivePacket*>>& messages)
+{
+	IServerListenerTCP* listener = m_pServer->GetListener();
+
+	for (auto& message : messages)
+	{
+		// Important: responsibility for deleting the message is assumed by the listener
+		/// @todo use shared_ptr for messages?
+		if (listener)
+			listener->OnTCPMessage(message.first, message.second);
+		else
+			delete message.second;
+	}
+
+	messages.clear();
+}
+
+/**
+ * Sends queued packets until the queue is empty or the socket would block
+ * @param socket
+ * @return False if client must be disconnected
+ */
+bool CTCPServerWorker::FlushClient(CExtendedSocket* socket)
+{
+	if (socket->SendQueuedPackets() == SOCKET_ERROR)
+	{
+		Logger().Warn("An error occurred while sending packet from queue: WSAGetLastError: %d\n", GetNetworkError());
+
+		IServerListenerTCP* listener = m_pServer->GetListener();
+		if (listener)
+			listener->OnTCPError(0);
+
+		return false;
+	}
+
+	return true;
+}
+
+/**
+ * Deletes clients removed during the last listen pass.
+ * Deletion is deferred because events returned by poll may still refer to them.
+ * Done under the server critical section because the listener may still use a socket right after disconnecting it
+ */
+void CTCPServerWorker::DeleteRemovedClients()
+{
+	vector<CExtendedSocket*> removedClients;
+
+	m_Mutex.Enter();
+	removedClients.swap(m_RemovedClients);
+	m_Mutex.Leave();
+
+	if (removedClients.empty())
+		return;
+
+	m_pServer->Lock();
+
+	for (auto socket : removedClients)
+		delete socket;
+
+	m_pServer->Unlock();
+}
@@ -2,6 +2,10 @@
 
 #include "interface/net/iextendedsocket.h"
 #include "common/buffer.h"
+#include "common/thread.h"
+
+#include <memory>
+#include <chrono>
 
 struct GuestData_s
 {
@@ -15,6 +19,7 @@ struct GuestData_s
 
 class CSendPacket;
 class CReceivePacket;
+class CTCPServerWorker;
 struct WOLFSSL_EVP_CIPHER_CTX;
 
 /**
@@ -38,28 +43,43 @@ public:
 	unsigned char* GetCryptIV() { return m_pCryptIV; }
 	WOLFSSL*& GetSSLObject() { return m_pSSL; }
 	void SetSSLObject(WOLFSSL* ssl) { m_pSSL = ssl; }
+	void StartHandshake(WOLFSSL* ssl);
+	bool ContinueHandshake();
+	bool IsHandshaking() { return m_bHandshaking; }
+	std::chrono::steady_clock::time_point GetHandshakeStartTime() { return m_HandshakeStartTime; }
+	void SetWorker(CTCPServerWorker* worker) { m_pWorker = worker; }
+	void SetSendQueueLimit(size_t limit) { m_nSendQueueLimit = limit; }
+	CTCPServerWorker* GetWorker() { return m_pWorker; }
+	IUser* GetUser() { return m_pUser; }
+	void SetUser(IUser* user) { m_pUser = user; }
+	CDedicatedServer* GetServer() { return m_pServer; }
+	void SetServer(CDedicatedServer* server) { m_pServer = server; }
 	int GetSeq();
 	int LoggerGetSeq();
 	void ResetSeq();
 	int Read(char* buf, int len);
 	CReceivePacket* Read();
 	int Send(std::vector<unsigned char>& buffer, bool serverHelloMsg = false);
-	int Send(CSendPacket* msg, bool ignoreQueue = false);
+	int Send(CSendPacket* msg);
+	int SendQueuedPackets();
 
 	// tcp client method
 	bool OnServerConnected();
 
 	unsigned int GetID();
 	SOCKET GetSocket();
-	void SetMsg(CReceivePacket* msg);
-	CReceivePacket* GetMsg();
 	int GetReadResult();
 	int GetBytesReceived();
 	int GetBytesSent();
-	std::vector<CSendPacket*>& GetPacketsToSend();
+	std::deque<CSendPacket*>& GetPacketsToSend();
 	GuestData_s& GetGuestData();
 
 private:
+	void PrepareRecvBuffer();
+	bool DecryptReceived();
+	CReceivePacket* ParsePacket();
+	bool EncryptOutput(unsigned char* out, const unsigned char* in, int len);
+
 	unsigned int m_nID;
 	SOCKET m_Socket;
 	int m_nSequence;
@@ -68,9 +88,18 @@ private:
 
 	GuestData_s m_GuestData;
 
-	CReceivePacket* m_pMsg;
-	
-	int m_nPacketReceivedSize;
+	// logged in user or registered dedicated server, not owned. Used only by the event thread
+	IUser* m_pUser;
+	CDedicatedServer* m_pServer;
+
+	// receive buffer: [start, decrypted) is ready to be parsed, [decrypted, end) is waiting for decryption.
+	// Parsed packets reference the buffer instead of copying their bytes
+	std::shared_ptr<std::vector<unsigned char>> m_pRecvBuffer;
+	size_t m_nRecvStart;
+	size_t m_nRecvDecrypted;
+	size_t m_nRecvEnd;
+	size_t m_nRecvPacketSize; // size of partially received packet, 0 if its header is not received yet
+
 	int m_nPacketSentSize;
 	
 	int m_nReadResult;
@@ -78,7 +107,13 @@ private:
 
 	std::string m_IP;
 	std::vector<unsigned char> m_HWID;
-	std::vector<CSendPacket*> m_SendPackets;
+	// encoded packets waiting to be sent. Queued by the event thread and sent by the worker thread
+	std::deque<CSendPacket*> m_SendPackets;
+	CCriticalSection m_SendPacketsMutex;
+	size_t m_nSendOffset; // bytes of the first queued packet that have already been sent
+	size_t m_nSendQueueBytes;
+	size_t m_nSendQueueLimit; // 0 - no limit
+	bool m_bSendQueueOverflow; // the client doesn't read fast enough and must be disconnected
 
 	// crypt things
 	WOLFSSL_EVP_CIPHER_CTX* m_pDecEVPCTX;
@@ -88,4 +123,8 @@ private:
 	unsigned char m_pCryptKey[64];
 	unsigned char m_pCryptIV[64];
 	WOLFSSL* m_pSSL;
+	bool m_bHandshaking; // TLS handshake is driven by the worker on socket readiness, no packets are read or sent until it's done
+	std::chrono::steady_clock::time_point m_HandshakeStartTime;
+
+	CTCPServerWorker* m_pWorker; // worker that serves this socket, NULL for client sockets
 };
@@ -12,7 +12,8 @@ public:
 	~CSendPacket();
 
 	std::vector<unsigned char> SetPacketLength();
-	Buffer GetData();
+	void WritePacketLength();
+	Buffer& GetData();
 	void WriteInt8(int number);
 	void WriteInt16(int number, bool littleEndian = true);
 	void WriteInt32(int number, bool littleEndian = true);
@@ -25,6 +26,10 @@ public:
 	void WriteWString(const std::wstring& str);
 	void WriteData(void* data, size_t len);
 	void WriteArray(const std::vector<unsigned char>& arr);
+	void WriteSharedData(const std::shared_ptr<std::vector<unsigned char>>& data);
+	void WriteSharedData(std::shared_ptr<std::vector<unsigned char>>&& data);
+	const std::shared_ptr<std::vector<unsigned char>>& GetSharedData();
+	size_t GetSize();
 	void SetWriteOffset(int offset);
 	void SetOverride(bool override);
 	bool IsBufferFull();
@@ -35,4 +40,7 @@ public:
 	int m_nSequence;
 
 	Buffer m_OutStream;
+
+	// immutable data sent after m_OutStream, shared between packets of different sockets
+	std::shared_ptr<std::vector<unsigned char>> m_pSharedData;
 };
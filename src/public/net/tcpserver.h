@@ -4,48 +4,60 @@
 #include "common/thread.h"
 #include <wolfssl/ssl.h>
 
+#include "tcpserverworker.h"
+
 #include <string>
 #include <vector>
-#include <chrono>
+#include <unordered_map>
+#include <atomic>
 
 class IExtendedSocket;
 class CExtendedSocket;
 class IServerListenerTCP;
 
 /**
- * Class that accepts TCP connection
+ * Class that accepts TCP connection.
+ * Connections are served by a pool of CTCPServerWorker I/O threads, one listen socket per worker.
+ * The client list is modified and the listener is notified about connections only inside the critical section
  */
-class CTCPServer : public ISocketListenable
+class CTCPServer
 {
 public:
 	CTCPServer();
 	~CTCPServer();
-	
-	bool Start(const std::string& port, int tcpSendBufferSize, bool ssl);
+
+	bool Start(const std::string& port, int tcpSendBufferSize, bool ssl = false, int workerCount = 1);
 	void Stop();
-	void Listen();
 	void InitSSLContext();
 
-	IExtendedSocket* Accept(unsigned int id);
+	CExtendedSocket* Accept(SOCKET listenSocket, CTCPServerWorker* worker);
+	void AddClient(CExtendedSocket* socket);
 	IExtendedSocket* GetExSocketBySocket(SOCKET socket);
+	IExtendedSocket* GetExSocketByID(unsigned int id);
 	void DisconnectClient(IExtendedSocket* socket);
 	std::vector<IExtendedSocket*>& GetClients();
+	std::vector<TCPWorkerStats_s> GetWorkerStats();
 
 	bool IsRunning();
 
 	void SetListener(IServerListenerTCP* listener);
+	IServerListenerTCP* GetListener();
 	void SetCriticalSection(CCriticalSection* criticalSection);
+	void Lock();
+	void Unlock();
 
 private:
-	SOCKET m_Socket;
+	SOCKET CreateListenSocket(const std::string& port, int tcpSendBufferSize, bool reusePort);
+
 	bool m_bIsRunning;
 	int m_nResult;
-	CThread m_ListenThread;
-	unsigned int m_nNextClientIndex;
+	std::atomic<unsigned int> m_nNextClientIndex;
+	std::vector<CTCPServerWorker*> m_Workers;
 	std::vector<IExtendedSocket*> m_Clients;
+	std::unordered_map<IExtendedSocket*, size_t> m_ClientIndices; // position in m_Clients, used to remove clients in O(1)
+	std::unordered_map<SOCKET, IExtendedSocket*> m_ClientSockets;
+	std::unordered_map<unsigned int, IExtendedSocket*> m_ClientIDs;
 	IServerListenerTCP* m_pListener;
 	CCriticalSection* m_pCriticalSection;
-
-	std::vector<WSAPOLLFD> m_fds;
 	WOLFSSL_CTX* m_pCTX;
-};
\ No newline at end of file
+};
@@ -0,0 +1,91 @@
+#pragma once
+
+#include "socketshared.h"
+#include "common/thread.h"
+
+#ifndef WIN32
+#include <sys/epoll.h>
+#endif
+
+#include <vector>
+#include <unordered_map>
+#include <unordered_set>
+#include <atomic>
+#include <utility>
+
+class IExtendedSocket;
+class CExtendedSocket;
+class CTCPServer;
+class CReceivePacket;
+
+/**
+ * Network counters of TCP server worker
+ */
+struct TCPWorkerStats_s
+{
+	int id;
+	int connections;
+	unsigned long long acceptedConnections;
+	unsigned long long packetsReceived;
+	unsigned long long bytesReceived;
+	unsigned long long bytesSent;
+};
+
+/**
+ * I/O thread of TCP server. Owns a listen socket (bound with SO_REUSEPORT, so the kernel balances new connections between workers)
+ * and the connections accepted on it: reads and decodes incoming packets, encrypts and sends queued packets.
+ * Only complete packets leave the worker (via IServerListenerTCP::OnTCPMessage).
+ * Uses edge-triggered epoll on Linux and WSAPoll on Windows.
+ */
+class CTCPServerWorker : public ISocketListenable
+{
+public:
+	CTCPServerWorker(CTCPServer* server, int id);
+	~CTCPServerWorker();
+
+	bool Start(SOCKET listenSocket);
+	void Stop();
+	void Listen();
+	bool IsRunning();
+
+	void AddClient(CExtendedSocket* socket);
+	void RemoveClient(CExtendedSocket* socket);
+	void WatchWritable(CExtendedSocket* socket, bool watch);
+	TCPWorkerStats_s GetStats();
+
+private:
+	void AcceptClients();
+	bool HandshakeClient(CExtendedSocket* socket);
+	void CheckHandshakeTimeouts(std::vector<CExtendedSocket*>& disconnectedClients);
+	bool ReadClient(CExtendedSocket* socket, bool drain, std::vector<std::pair<CExtendedSocket*, CReceivePacket*>>& messages);
+	void PublishMessages(std::vector<std::pair<CExtendedSocket*, CReceivePacket*>>& messages);
+	bool FlushClient(CExtendedSocket* socket);
+	void DeleteRemovedClients();
+
+	CTCPServer* m_pServer;
+	int m_nID;
+	SOCKET m_Socket;
+	std::atomic<bool> m_bIsRunning; // read by the worker thread
+	CThread m_ListenThread;
+
+	// held while messages read in the current pass are passed to the listener, RemoveClient() waits for it,
+	// so no messages of a removed client are published after it returns. Lock order: worker mutex -> publish mutex
+	CCriticalSection m_PublishMutex;
+
+	// protects everything below. Lock order: server critical section -> worker mutex, never the other way
+	CCriticalSection m_Mutex;
+	std::unordered_map<SOCKET, CExtendedSocket*> m_Clients;
+	std::vector<CExtendedSocket*> m_RemovedClients; // deleted after the current listen pass
+	std::unordered_set<CExtendedSocket*> m_HandshakingClients; // clients with unfinished TLS handshake, checked for timeout every listen pass
+#ifdef WIN32
+	std::vector<WSAPOLLFD> m_fds;
+#else
+	int m_nEpollFD;
+	std::vector<epoll_event> m_EpollEvents;
+#endif
+
+	std::atomic<unsigned long long> m_nAcceptedConnections;
+	std::atomic<unsigned long long> m_nPacketsReceived;
+	std::atomic<unsigned long long> m_nBytesReceived;
+	std::atomic<unsigned long long> m_nBytesSent;
+};
@@ -311,9 +311,7 @@ void CGameMatch::OnKillEvent(IUser* user, GameMatch_KillEvent& killEvent)
 
 	// TODO: rewrite
 	// random gachapon item for each 100 kills
-	CUserCharacterExtended character = {};
-	character.flag = EXT_UFLAG_KILLSTOGETGACHAPONITEM;
-	g_UserDatabase.GetCharacterExtended(user->GetID(), character);
+	CUserCharacterExtended character = user->GetCharacterExtended(EXT_UFLAG_KILLSTOGETGACHAPONITEM);
 
 	character.killsToGetGachaponItem--;
 	if (character.killsToGetGachaponItem <= 0)
@@ -329,7 +327,7 @@ void CGameMatch::OnKillEvent(IUser* user, GameMatch_KillEvent& killEvent)
 		g_ItemManager.AddItem(user->GetID(), user, randomItemID, 1, 0);
 	}
 
-	g_UserDatabase.UpdateCharacterExtended(user->GetID(), character);
+	user->UpdateCharacterExtended(character);
 }
 
 void CGameMatch::OnUpdateWinCounter(int ctWinCount, int tWinCount)
@@ -101,6 +101,8 @@ void CRoom::AddUser(IUser* user)
 
 	user->SetRoomData(new CRoomUser(user, RoomTeamNum::CounterTerrorist, RoomReadyStatus::READY_STATUS_NO));
 	user->SetStatus(UserStatus::STATUS_INROOM);
+
+	m_pParentChannel->SendUpdateRoomList(this, RLFLAG_PLAYERS, 0);
 }
 
 void CRoom::RemoveUser(IUser* targetUser)
@@ -110,6 +112,9 @@ void CRoom::RemoveUser(IUser* targetUser)
 	delete targetUser->GetRoomData();
 	targetUser->SetRoomData(NULL);
 
+	// before OnUserRemoved, the room is deleted when the last user leaves
+	m_pParentChannel->SendUpdateRoomList(this, RLFLAG_PLAYERS, 0);
+
 	OnUserRemoved(targetUser);
 
 	targetUser->SetCurrentRoom(NULL);
@@ -234,6 +239,8 @@ void CRoom::SetStatus(RoomStatus newStatus)
 {
 	m_pSettings->status = newStatus;
 	m_pSettings->statusSymbol = newStatus == RoomStatus::STATUS_INGAME ? 3 : 0;
+
+	m_pParentChannel->SendUpdateRoomList(this, RLFLAG_STATUSSYMBOL, 0);
 }
 
 void CRoom::SendJoinNewRoom(IUser* user)
@@ -598,10 +605,8 @@ void CRoom::OnUserMessage(CReceivePacket* msg, IUser* user)
 						m_pSettings->voxel_creator_username = user->GetUsername();
 					}
 
-					for (auto u : m_Users) // send gamemode update to all users
-					{
-						g_PacketManager.SendRoomUpdateSettings(u->GetExtendedSocket(), m_pSettings, ROOM_LOW_GAMEMODEID, voxelFlag);
-					}
+					// send gamemode update to all users
+					g_PacketManager.SendRoomUpdateSettings(GetUserSockets(), m_pSettings, ROOM_LOW_GAMEMODEID, voxelFlag);
 				}
 				else
 				{
@@ -628,10 +633,7 @@ void CRoom::OnUserMessage(CReceivePacket* msg, IUser* user)
 					m_pSettings->mapId = stoi(results[1]);
 					m_pSettings->mapId2 = m_pSettings->mapId;
 
-					for (auto u : m_Users)
-					{
-						g_PacketManager.SendRoomUpdateSettings(u->GetExtendedSocket(), m_pSettings, ROOM_LOW_MAPID, ROOM_LOWMID_MAPID2);
-					}
+					g_PacketManager.SendRoomUpdateSettings(GetUserSockets(), m_pSettings, ROOM_LOW_MAPID, ROOM_LOWMID_MAPID2);
 				}
 				else
 				{
@@ -659,10 +661,7 @@ void CRoom::OnUserMessage(CReceivePacket* msg, IUser* user)
 					m_pSettings->friendlyBots = stoi(results[2]);
 					m_pSettings->botAdd = 1;
 
-					for (auto u : m_Users)
-					{
-						g_PacketManager.SendRoomUpdateSettings(u->GetExtendedSocket(), m_pSettings, 0, ROOM_LOWMID_BOT);
-					}
+					g_PacketManager.SendRoomUpdateSettings(GetUserSockets(), m_pSettings, 0, ROOM_LOWMID_BOT);
 				}
 			}
 			else
@@ -684,10 +683,8 @@ void CRoom::OnUserMessage(CReceivePacket* msg, IUser* user)
 				{
 					m_pSettings->maxPlayers = stoi(results[1]);
 
-					for (auto u : m_Users) // send max players update to all users
-					{
-						g_PacketManager.SendRoomUpdateSettings(u->GetExtendedSocket(), m_pSettings, ROOM_LOW_MAXPLAYERS);
-					}
+					// send max players update to all users
+					g_PacketManager.SendRoomUpdateSettings(GetUserSockets(), m_pSettings, ROOM_LOW_MAXPLAYERS);
 				}
 				else
 				{
@@ -709,14 +706,16 @@ void CRoom::OnUserMessage(CReceivePacket* msg, IUser* user)
 		}
 	}
 
+	vector<IExtendedSocket*> sockets;
+	sockets.reserve(m_Users.size());
 	for (auto userDest : m_Users)
 	{
-		CUserCharacterExtended characterExtendedDest = userDest->GetCharacterExtended(EXT_UFLAG_BANSETTINGS);
-
 		// you can't send room message if dest is blocking your chat
-		if (~characterExtendedDest.banSettings & 2 || characterExtendedDest.banSettings & 2 && !g_UserDatabase.IsInBanList(userDest->GetID(), user->GetID()))
-			g_PacketManager.SendUMsgUserMessage(userDest->GetExtendedSocket(), UMsgPacketType::RoomUserMessage, senderName, message);
+		if (!userDest->IsBlocking(senderName, BANSETTINGS_CHAT))
+			sockets.push_back(userDest->GetExtendedSocket());
 	}
+
+	g_PacketManager.SendUMsgUserMessage(sockets, UMsgPacketType::RoomUserMessage, senderName, message);
 }
 
 void CRoom::OnUserTeamMessage(CReceivePacket* msg, IUser* user)
@@ -726,17 +725,15 @@ void CRoom::OnUserTeamMessage(CReceivePacket* msg, IUser* user)
 
 	CUserCharacter character = user->GetCharacter(UFLAG_LOW_GAMENAME);
 
+	vector<IExtendedSocket*> sockets;
 	for (auto userDest : m_Users)
 	{
-		if (userTeam == GetUserTeam(userDest))
-		{
-			CUserCharacterExtended characterExtendedDest = userDest->GetCharacterExtended(EXT_UFLAG_BANSETTINGS);
-
-			// you can't send team message if dest is blocking your chat
-			if (~characterExtendedDest.banSettings & 2 || characterExtendedDest.banSettings & 2 && !g_UserDatabase.IsInBanList(userDest->GetID(), user->GetID()))
-				g_PacketManager.SendUMsgUserMessage(userDest->GetExtendedSocket(), UMsgPacketType::RoomTeamUserMessage, character.gameName, message);
-		}
+		// you can't send team message if dest is blocking your chat
+		if (userTeam == GetUserTeam(userDest) && !userDest->IsBlocking(character.gameName, BANSETTINGS_CHAT))
+			sockets.push_back(userDest->GetExtendedSocket());
 	}
+
+	g_PacketManager.SendUMsgUserMessage(sockets, UMsgPacketType::RoomTeamUserMessage, character.gameName, message);
 }
 
 void CRoom::OnGameStart()
@@ -904,28 +901,19 @@ void CRoom::CheckForHostItems()
 	CUserInventoryItem item;
 	m_pSettings->superRoom = g_UserDatabase.GetFirstActiveItemByItemID(m_pHostUser->GetID(), 8357 /* superRoom */, item);
 
-	for (auto u : m_Users)
-	{
-		g_PacketManager.SendRoomUpdateSettings(u->GetExtendedSocket(), m_pSettings, 0, ROOM_LOWMID_SUPERROOM);
-	}
+	g_PacketManager.SendRoomUpdateSettings(GetUserSockets(), m_pSettings, 0, ROOM_LOWMID_SUPERROOM);
 
 	CUserInventoryItem item2;
 	m_pSettings->c4Timer = g_UserDatabase.GetFirstActiveItemByItemID(m_pHostUser->GetID(), 112 /* c4Timer */, item2);
 
-	for (auto u : m_Users)
-	{
-		g_PacketManager.SendRoomUpdateSettings(u->GetExtendedSocket(), m_pSettings, 0, ROOM_LOWMID_C4TIMER);
-	}
+	g_PacketManager.SendRoomUpdateSettings(GetUserSockets(), m_pSettings, 0, ROOM_LOWMID_C4TIMER);
 
 	if (m_pSettings->gameModeId == 3 || m_pSettings->gameModeId == 4 || m_pSettings->gameModeId == 5 || m_pSettings->gameModeId == 15 || m_pSettings->gameModeId == 24)
 	{
 		CUserInventoryItem item;
 		m_pSettings->sd = g_UserDatabase.GetFirstActiveItemByItemID(m_pHostUser->GetID(), 439 /* BigHeadEvent */, item);
 
-		for (auto u : m_Users)
-		{
-			g_PacketManager.SendRoomUpdateSettings(u->GetExtendedSocket(), m_pSettings, 0, ROOM_LOWMID_SD);
-		}
+		g_PacketManager.SendRoomUpdateSettings(GetUserSockets(), m_pSettings, 0, ROOM_LOWMID_SD);
 	}
 }
 
@@ -954,10 +942,7 @@ void CRoom::OnUserRemoved(IUser* user)
 
 void CRoom::SendRemovedUser(IUser* deletedUser)
 {
-	for (auto u : m_Users)
-	{
-		g_PacketManager.SendRoomPlayerLeave(u->GetExtendedSocket(), deletedUser->GetID());
-	}
+	g_PacketManager.SendRoomPlayerLeave(GetUserSockets(), deletedUser->GetID());
 
 	if (m_pServer)
 	{
@@ -970,10 +955,7 @@ void CRoom::UpdateHost(IUser* newHost)
 {
 	m_pHostUser = newHost;
 
-	for (auto u : m_Users)
-	{
-		g_PacketManager.SendRoomSetHost(u->GetExtendedSocket(), newHost);
-	}
+	g_PacketManager.SendRoomSetHost(GetUserSockets(), newHost);
 
 	CheckForHostItems();
 	ClearKickedUsers();
@@ -1044,10 +1026,7 @@ void CRoom::HostStartGame()
 		m_pSettings->mapId = zbCompetitiveMaps[randomMap()];
 		m_pSettings->mapId2 = m_pSettings->mapId;
 
-		for (auto u : m_Users)
-		{
-			g_PacketManager.SendRoomUpdateSettings(u->GetExtendedSocket(), m_pSettings, ROOM_LOW_MAPID, ROOM_LOWMID_MAPID2);
-		}
+		g_PacketManager.SendRoomUpdateSettings(GetUserSockets(), m_pSettings, ROOM_LOW_MAPID, ROOM_LOWMID_MAPID2);
 	}
 
 	if (!m_pGameMatch)
@@ -1066,8 +1045,6 @@ void CRoom::HostStartGame()
 
 	SendReadyStatusToAll();
 
-	m_pHostUser->GetCurrentChannel()->SendUpdateRoomList(this);
-
 	if (m_pServer)
 	{
 		string ip = ip_to_string(m_pServer->GetIP());
@@ -1127,10 +1104,7 @@ void CRoom::EndGame(bool forcedEnd)
 			m_pSettings->mapId2 = m_pSettings->mapId;
 			m_pSettings->mapPlaylistIndex = 1;
 
-			for (auto u : m_Users)
-			{
-				g_PacketManager.SendRoomUpdateSettings(u->GetExtendedSocket(), m_pSettings, ROOM_LOW_MAPID, ROOM_LOWMID_MAPID2 | ROOM_LOWMID_MAPPLAYLISTINDEX);
-			}
+			g_PacketManager.SendRoomUpdateSettings(GetUserSockets(), m_pSettings, ROOM_LOW_MAPID, ROOM_LOWMID_MAPID2 | ROOM_LOWMID_MAPPLAYLISTINDEX);
 		}
 		else
 		{
@@ -1146,10 +1120,7 @@ void CRoom::EndGame(bool forcedEnd)
 					m_pSettings->mapId2 = m_pSettings->mapId;
 					m_pSettings->mapPlaylistIndex = nextMap + 1;
 
-					for (auto u : m_Users)
-					{
-						g_PacketManager.SendRoomUpdateSettings(u->GetExtendedSocket(), m_pSettings, ROOM_LOW_MAPID, ROOM_LOWMID_MAPID2 | ROOM_LOWMID_MAPPLAYLISTINDEX);
-					}
+					g_PacketManager.SendRoomUpdateSettings(GetUserSockets(), m_pSettings, ROOM_LOW_MAPID, ROOM_LOWMID_MAPID2 | ROOM_LOWMID_MAPPLAYLISTINDEX);
 					break;
 				}
 			}
@@ -1225,10 +1196,20 @@ void CRoom::ChangeMap(int mapId)
 		g_PacketManager.SendRoomUpdateSettings(m_pServer->GetSocket(), m_pSettings, ROOM_LOW_MAPID, ROOM_LOWMID_MAPID2);
 	}
 
+	g_PacketManager.SendRoomUpdateSettings(GetUserSockets(), m_pSettings, ROOM_LOW_MAPID, ROOM_LOWMID_MAPID2);
+}
+
+/**
+ * Gets sockets of room users, recipients of room broadcasts
+ */
+vector<IExtendedSocket*> CRoom::GetUserSockets()
+{
+	vector<IExtendedSocket*> sockets;
+	sockets.reserve(m_Users.size());
 	for (auto u : m_Users)
-	{
-		g_PacketManager.SendRoomUpdateSettings(u->GetExtendedSocket(), m_pSettings, ROOM_LOW_MAPID, ROOM_LOWMID_MAPID2);
-	}
+		sockets.push_back(u->GetExtendedSocket());
+
+	return sockets;
 }
 
 bool CRoom::IsUserInFamilyBattleUsers(int userId)
@@ -104,6 +104,8 @@ public:
 	bool IsUserInFamilyBattleUsers(int userId);
 
 private:
+	std::vector<IExtendedSocket*> GetUserSockets();
+
 	IUser* m_pHostUser;
 	class CChannel* m_pParentChannel;
 	CRoomSettings* m_pSettings;
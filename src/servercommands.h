@@ -275,6 +275,11 @@ void CommandToggleGameMaster(CCommand* cmd, const std::vector<std::string>& args
 	Logger().Info(OBFUSCATE("Updated '%d' gameMaster privilege to '%s'\n"), userID, character.gameMaster ? (const char*)OBFUSCATE("true") : (const char*)OBFUSCATE("false"));
 
 	g_UserDatabase.UpdateCharacterExtended(userID, character);
+
+	// reload changed character of online user
+	IUser* user = g_UserManager.GetUserById(userID);
+	if (user)
+		user->InvalidateCache();
 }
 
 void CommandShopReload(CCommand* cmd, const std::vector<std::string>& args)
@@ -418,6 +423,9 @@ void CommandGiveItem(CCommand* cmd, const std::vector<std::string>& args)
 
 	IUser* user = g_UserManager.GetUserById(userID);
 	int status = g_ItemManager.AddItem(userID, user, itemID, count, duration); // add permanent item by default
+	if (user)
+		user->InvalidateCache(); // item use can change character data in the database
+
 	switch (status)
 	{
 	case ITEM_ADD_INVENTORY_FULL:
@@ -462,6 +470,192 @@ void CommandStatus(CCommand* cmd, const std::vector<std::string>& args)
 	Logger().Info("%s\n", g_pServerInstance->GetMainInfo());
 }
 
+void CommandNetStats(CCommand* cmd, const std::vector<std::string>& args)
+{
+	Logger().Info(va("%-6s|%-11s|%-10s|%-12s|%-14s|%-14s\n", "Thread", "Connections", "Accepted", "Packets", "Bytes received", "Bytes sent"));
+
+	for (auto& stats : g_pServerInstance->GetTCPWorkerStats())
+	{
+		Logger().Info(va("%-6d|%-11d|%-10llu|%-12llu|%-14llu|%-14llu\n",
+			stats.id,
+			stats.connections,
+			stats.acceptedConnections,
+			stats.packetsReceived,
+			stats.bytesReceived,
+			stats.bytesSent));
+	}
+}
+
+void CommandEventStats(CCommand* cmd, const std::vector<std::string>& args)
+{
+	Logger().Info(va("%-13s|%-12s\n", "Queue depth", "Events"));
+
+	std::vector<unsigned long long> histogram = g_Events.GetQueueDepthHistogram();
+	for (int i = 0; i < (int)histogram.size(); i++)
+	{
+		std::string depth;
+		if (i == 0)
+			depth = "0";
+		else if (i == (int)histogram.size() - 1)
+			depth = va("%d+", 1 << (i - 1));
+		else
+			depth = va("%d-%d", 1 << (i - 1), (1 << i) - 1);
+
+		Logger().Info(va("%-13s|%-12llu\n", depth.c_str(), histogram[i]));
+	}
+
+	Logger().Info(va("Overflowed events: %llu\n", g_Events.GetOverflowEvents()));
+}
+
+void CommandPacketStats(CCommand* cmd, const std::vector<std::string>& args)
+{
+	CPacketStats& packetStats = g_pServerInstance->GetPacketStats();
+	if (args.size() >= 2 && args[1] == "reset")
+	{
+		packetStats.Reset();
+		Logger().Info("Packet counters reset\n");
+		return;
+	}
+
+	int count = 20;
+	if (args.size() >= 2 && isNumber(args[1]))
+		count = stoi(args[1]);
+
+	Logger().Info(va("%-6s|%-7s|%-10s|%-12s|%-12s|%-9s|%-9s|%-9s|%-9s\n", "ID", "Type", "Packets", "Bytes", "Time (us)", "p50 (us)", "p99 (us)", "p50 size", "p99 size"));
+
+	std::vector<PacketStats_s> stats = packetStats.GetStats();
+	stats.push_back(packetStats.GetTotal());
+	for (int i = 0; i < (int)stats.size(); i++)
+	{
+		// always print the total line
+		if (i >= count && i != (int)stats.size() - 1)
+			continue;
+
+		PacketStats_s& s = stats[i];
+		Logger().Info(va("%-6s|%-7s|%-10llu|%-12llu|%-12llu|%-9llu|%-9llu|%-9llu|%-9llu\n",
+			s.id == -1 ? "total" : va("%d", s.id),
+			s.subType == PACKET_STATS_NO_SUBTYPE ? "-" : va("%d", s.subType),
+			s.count,
+			s.bytes,
+			s.time,
+			CPacketStats::GetPercentile(s.latency, PACKET_STATS_LATENCY_BUCKETS, 50),
+			CPacketStats::GetPercentile(s.latency, PACKET_STATS_LATENCY_BUCKETS, 99),
+			CPacketStats::GetPercentile(s.size, PACKET_STATS_SIZE_BUCKETS, 50),
+			CPacketStats::GetPercentile(s.size, PACKET_STATS_SIZE_BUCKETS, 99)));
+	}
+}
+
+void CommandUserCache(CCommand* cmd, const std::vector<std::string>& args)
+{
+	if (args.size() >= 2 && args[1] == "flush")
+	{
+		g_UserManager.FlushUserCache();
+		Logger().Info("User cache flushed\n");
+	}
+
+	unsigned long long requests = g_UserCacheStats.hits + g_UserCacheStats.misses;
+	Logger().Info(va("%-12s|%-12s|%-8s|%-10s|%-12s\n", "Hits", "Misses", "Hit rate", "Flushes", "Rows written"));
+	Logger().Info(va("%-12llu|%-12llu|%-7.1f%%|%-10llu|%-12llu\n",
+		g_UserCacheStats.hits,
+		g_UserCacheStats.misses,
+		requests ? g_UserCacheStats.hits * 100.0 / requests : 0.0,
+		g_UserCacheStats.flushes,
+		g_UserCacheStats.rowsWritten));
+}
+
+void CommandDbQueryPlan(CCommand* cmd, const std::vector<std::string>& args)
+{
+	if (args.size() >= 2 && args[1] == "record")
+	{
+		g_UserDatabase.RecordStatements(true);
+		Logger().Info("Recording executed database statements, run dbqueryplan to check them\n");
+		return;
+	}
+
+	if (args.size() >= 2 && args[1] == "stop")
+	{
+		g_UserDatabase.RecordStatements(false);
+		Logger().Info("Database statement recording stopped\n");
+		return;
+	}
+
+	g_UserDatabase.AuditQueryPlans();
+}
+
+void CommandDbStatements(CCommand* cmd, const std::vector<std::string>& args)
+{
+	int count = 20;
+	if (args.size() >= 2 && isNumber(args[1]))
+		count = stoi(args[1]);
+
+	g_UserDatabase.PrintStatementStats(count);
+}
+
+void CommandDbProfile(CCommand* cmd, const std::vector<std::string>& args)
+{
+	CProfiler& profiler = g_UserDatabaseProfiler;
+	if (args.size() >= 2)
+	{
+		if (args[1] == "reset")
+		{
+			profiler.Reset();
+			Logger().Info("Database profiler counters reset\n");
+			return;
+		}
+		else if (args[1] == "on" || args[1] == "off")
+		{
+			profiler.SetEnabled(args[1] == "on");
+			Logger().Info("Database profiler %s\n", profiler.IsEnabled() ? "enabled" : "disabled");
+			return;
+		}
+		else if (args[1] == "sample" || args[1] == "slow")
+		{
+			if (args.size() < 3 || !isNumber(args[2]))
+			{
+				Logger().Info("%s\n", cmd->GetUsage().c_str());
+				return;
+			}
+
+			if (args[1] == "sample")
+				profiler.SetSampleRate(stoi(args[2]));
+			else
+				profiler.SetSlowThreshold(stoi(args[2]));
+		}
+	}
+
+	int count = 20;
+	if (args.size() >= 2 && isNumber(args[1]))
+		count = stoi(args[1]);
+
+	Logger().Info("Database profiler: %s, timing 1 of %d calls, slow call threshold: %d ms\n", profiler.IsEnabled() ? "enabled" : "disabled", profiler.GetSampleRate(), profiler.GetSlowThreshold());
+	Logger().Info(va("%-32s|%-10s|%-10s|%-12s|%-10s|%-10s|%-10s\n", "Method", "Calls", "Sampled", "Time (us)", "Avg (us)", "Max (us)", "Rows"));
+
+	std::vector<ProfilerStats_s> stats = profiler.GetStats();
+	for (int i = 0; i < count && i < (int)stats.size(); i++)
+	{
+		ProfilerStats_s& s = stats[i];
+		Logger().Info(va("%-32s|%-10llu|%-10llu|%-12llu|%-10llu|%-10llu|%-10llu\n",
+			s.name.c_str(),
+			s.calls,
+			s.sampledCalls,
+			s.time,
+			s.sampledCalls ? s.time / s.sampledCalls : 0,
+			s.maxTime,
+			s.rows));
+	}
+}
+
+void CommandDbBackup(CCommand* cmd, const std::vector<std::string>& args)
+{
+	if (args.size() >= 2 && args[1] == "start")
+	{
+		g_UserDatabase.StartBackup();
+		return;
+	}
+
+	g_UserDatabase.PrintBackupList();
+}
+
 void CommandSendEvent(CCommand* cmd, const std::vector<std::string>& args)
 {
 	if (args.size() < 3 || !isNumber(args[1]) || !isNumber(args[2]))
@@ -572,6 +766,14 @@ CCommand dbreload("dbreload", "Reload server (dangerous command)", "", CommandDb
 CCommand bans("bans", "Print ban list", "", CommandBans);
 CCommand giveitem("giveitem", "Give item to user", "giveitem <gameName/userID> <itemID> <count> <duration>", CommandGiveItem);
 CCommand status("status", "Print server status", "", CommandStatus);
+CCommand netstats("netstats", "Print TCP I/O thread counters", "", CommandNetStats);
+CCommand eventstats("eventstats", "Print event queue depth histogram", "", CommandEventStats);
+CCommand packetstats("packetstats", "Print packet counts, handler latency and size percentiles by packet ID and type", "packetstats [count/reset]", CommandPacketStats);
+CCommand usercache("usercache", "Print user character cache counters or write dirty data", "usercache [flush]", CommandUserCache);
+CCommand dbqueryplan("dbqueryplan", "Print database statements which scan whole tables, record executed statements to check them too", "dbqueryplan [record/stop]", CommandDbQueryPlan);
+CCommand dbstatements("dbstatements", "Print cached database statements with the most executions", "dbstatements [count]", CommandDbStatements);
+CCommand dbprofile("dbprofile", "Print database method calls, latency and changed rows, or change profiler settings", "dbprofile [count/reset/on/off/sample <N>/slow <ms>]", CommandDbProfile);
+CCommand dbbackup("dbbackup", "Print user database backups or start a new backup", "dbbackup [start]", CommandDbBackup);
 CCommand sendevent("sendevent", "Send event packet", "sendevent <userID> <event>", CommandSendEvent);
 CCommand sendevent2("sendevent2", "Send weapon release event update", "sendevent2 <userID>", CommandSendEvent2);
 CCommand sendinventory("sendinventory", "Send inventory packet to user by userID", "sendinventory <userID>", CommandSendInventory);
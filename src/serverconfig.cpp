@@ -12,6 +12,8 @@ using namespace std;
 CServerConfig::CServerConfig()
 {
 	tcpSendBufferSize = 0;
+	tcpIOThreads = 0;
+	tcpSendQueueLimit = 0;
 	maxPlayers = 0;
 	restartOnCrash = false;
 	inventorySlotMax = 0;
@@ -52,6 +54,8 @@ const char* defaultServerConfig = R"(
 	"Description": "",
 	"Port": "30002",
 	"TCPSendBufferSize": 131072,
+	"TCPIOThreads": 1,
+	"TCPSendQueueLimit": 4194304,
 	"MaxPlayers": 100,
 	"WelcomeMessage": "https://discord.gg/EvUAY6D",
 	"RestartOnCrash": false,
@@ -984,6 +988,8 @@ bool CServerConfig::Load()
 		description = cfg.value("Description", "");
 		tcpPort = udpPort = cfg.value("Port", DEFAULT_PORT);
 		tcpSendBufferSize = cfg.value("TCPSendBufferSize", 131072);
+		tcpIOThreads = cfg.value("TCPIOThreads", 1);
+		tcpSendQueueLimit = cfg.value("TCPSendQueueLimit", 4194304);
 		maxPlayers = cfg.value("MaxPlayers", 100);
 		welcomeMessage = cfg.value("WelcomeMessage", "");
 		restartOnCrash = cfg.value("RestartOnCrash", false);
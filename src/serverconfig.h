@@ -20,6 +20,8 @@ public:
 	std::string tcpPort;
 	std::string udpPort;
 	int tcpSendBufferSize;
+	int tcpIOThreads;
+	int tcpSendQueueLimit;
 	int maxPlayers;
 	std::string welcomeMessage;
 	bool restartOnCrash;
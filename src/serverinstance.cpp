@@ -27,10 +27,13 @@
 #include "gui/igui.h"
 #endif
 
+#include <chrono>
+
 using namespace std;
 
 CServerConfig* g_pServerConfig;
 CCSVTable* g_pItemTable;
+CItemAttributeTable* g_pItemAttributeTable;
 CCSVTable* g_pMapListTable;
 CCSVTable* g_pGameModeListTable;
 
@@ -45,6 +48,8 @@ CServerInstance::CServerInstance()
 	m_TCPServer.SetListener(this);
 	m_UDPServer.SetCriticalSection(&g_ServerCriticalSection);
 	m_UDPServer.SetListener(this);
+
+	RegisterPacketHandlers();
 }
 
 CServerInstance::~CServerInstance()
@@ -52,6 +57,7 @@ CServerInstance::~CServerInstance()
 	Manager().ShutdownAll();
 
 	delete g_pItemTable;
+	delete g_pItemAttributeTable;
 	delete g_pMapListTable;
 	delete g_pGameModeListTable;
 	delete g_pServerConfig;
@@ -70,18 +76,20 @@ bool CServerInstance::Init()
 	}
 
 	g_pItemTable = new CCSVTable("Data/Item.csv", rapidcsv::LabelParams(0, 0), rapidcsv::SeparatorParams(), rapidcsv::ConverterParams(true), rapidcsv::LineReaderParams(), true);
+	g_pItemAttributeTable = new CItemAttributeTable();
+	bool itemTableLoaded = !g_pItemTable->IsLoadFailed() && g_pItemAttributeTable->Load(g_pItemTable);
 	g_pMapListTable = new CCSVTable("Data/MapList.csv", rapidcsv::LabelParams(0, 0), rapidcsv::SeparatorParams(), rapidcsv::ConverterParams(true), rapidcsv::LineReaderParams());
 	g_pGameModeListTable = new CCSVTable("Data/GameModeList.csv", rapidcsv::LabelParams(0, 0), rapidcsv::SeparatorParams(), rapidcsv::ConverterParams(true), rapidcsv::LineReaderParams());
 
 	if (!Manager().InitAll() ||
-		!m_TCPServer.Start(g_pServerConfig->tcpPort, g_pServerConfig->tcpSendBufferSize, g_pServerConfig->ssl) ||
+		!m_TCPServer.Start(g_pServerConfig->tcpPort, g_pServerConfig->tcpSendBufferSize, g_pServerConfig->ssl, g_pServerConfig->tcpIOThreads) ||
 		!m_UDPServer.Start(g_pServerConfig->udpPort))
 	{
 		Logger().Error("Server initialization failed.\n");
 		m_bIsServerActive = false;
 		return false;
 	}
-	else if (g_pItemTable->IsLoadFailed())
+	else if (!itemTableLoaded)
 	{
 		Logger().Error("Server initialization failed. Couldn't load Item.csv.\n");
 		m_bIsServerActive = false;
@@ -134,12 +142,42 @@ bool CServerInstance::Reload()
 			m_TCPServer.InitSSLContext();
 	}
 
+	if (!ReloadItemTable())
+		return false;
+
 	if (!Manager().ReloadAll())
 		return false;
 
 	return true;
 }
 
+/**
+ * Reloads Item.csv and its attribute table. Both are built aside and swapped only if the load succeeded, so the item
+ * lookups never see a partially loaded table
+ */
+bool CServerInstance::ReloadItemTable()
+{
+	CCSVTable* itemTable = new CCSVTable("Data/Item.csv", rapidcsv::LabelParams(0, 0), rapidcsv::SeparatorParams(), rapidcsv::ConverterParams(true), rapidcsv::LineReaderParams(), true);
+	CItemAttributeTable* itemAttributeTable = new CItemAttributeTable();
+	if (itemTable->IsLoadFailed() || !itemAttributeTable->Load(itemTable))
+	{
+		Logger().Error("CServerInstance::ReloadItemTable: couldn't load Item.csv, keeping the current table\n");
+		delete itemTable;
+		delete itemAttributeTable;
+		return false;
+	}
+
+	swap(g_pItemTable, itemTable);
+	swap(g_pItemAttributeTable, itemAttributeTable);
+
+	delete itemTable;
+	delete itemAttributeTable;
+
+	Logger().Info("Item table reloaded, %d items\n", g_pItemAttributeTable->GetItemCount());
+
+	return true;
+}
+
 bool CServerInstance::LoadConfigs()
 {
 	g_pServerConfig = new CServerConfig();
@@ -170,8 +208,8 @@ void CServerInstance::OnTCPConnectionClosed(IExtendedSocket* socket)
 	int bytesReceived = socket->GetBytesReceived();
 	int sock = socket->GetSocket();
 
-	// clean up user/dedicated server
-	IUser* user = g_UserManager.GetUserBySocket(socket);
+	// clean up user/dedicated server, their managers clear the socket session
+	IUser* user = socket->GetUser();
 	if (user)
 	{
 		int userID = user->GetID();
@@ -180,7 +218,7 @@ void CServerInstance::OnTCPConnectionClosed(IExtendedSocket* socket)
 
 		Logger().Info("User logged out (%d, '%s', 0x%X)\n", userID, userName.c_str(), user);
 	}
-	else
+	else if (socket->GetServer())
 	{
 		g_DedicatedServerManager.RemoveServer(socket);
 	}
@@ -336,128 +374,128 @@ bool CServerInstance::IsServerActive()
  */
 void CServerInstance::OnEvent()
 {
-	IEvent* ev = g_Events.GetNextEvent();
-	while (ev)
+	// execute events in batches to enter the critical section once per batch without blocking I/O threads for too long
+	size_t count;
+	do
 	{
 		g_ServerCriticalSection.Enter();
-			
-		ev->Execute();
 
-		g_ServerCriticalSection.Leave();
+		count = g_Events.ExecuteEvents(EVENT_BATCH_SIZE);
 
-		ev = g_Events.GetNextEvent();
-	}
+		g_ServerCriticalSection.Leave();
+	} while (count == EVENT_BATCH_SIZE);
 }
 
 void CServerInstance::OnPackets(IExtendedSocket* s, CReceivePacket* msg)
 {
-	switch (msg->GetID())
+	int id = msg->GetID();
+	PacketHandler* handler = id >= 0 && id < PACKET_HANDLERS_SIZE && m_PacketHandlers[id] ? &m_PacketHandlers[id] : NULL;
+	if (!handler)
+	{
+		Logger().Warn("Unimplemented packet: %d\n", id);
+		delete msg;
+		return;
+	}
+
+	// most packets have the request type in the first byte, peek it without moving the read offset
+	int subType = PACKET_STATS_NO_SUBTYPE;
+	Buffer& data = msg->GetData();
+	if (msg->CanReadBytes(1))
 	{
-	case PacketId::Version:
-		g_UserManager.OnVersionPacket(msg, s);
-		break;
-	case PacketId::CreateCharacter:
-		g_UserManager.OnCharacterPacket(msg, s);
-		break;
-	case PacketId::Login:
-		g_UserManager.OnLoginPacket(msg, s);
-		break;
-	case PacketId::RequestServerList:
-		g_ChannelManager.OnChannelListPacket(s);
-		break;
-	case PacketId::RequestTransfer:
-		g_ChannelManager.OnRoomListPacket(msg, s);
-		break;
-	case PacketId::RecvCrypt:
-		g_UserManager.OnCryptPacket(msg, s);
-		break;
-	case PacketId::Room:
-		g_ChannelManager.OnRoomRequest(msg, s);
-		break;
-	case PacketId::Shop:
-		g_ShopManager.OnShopPacket(msg, s);
-		break;
-	case PacketId::UMsg:
-		g_UserManager.OnUserMessage(msg, s);
-		break;
-	case PacketId::Host:
-		g_HostManager.OnPacket(msg, s);
-		break;
-	case PacketId::Favorite:
-		g_UserManager.OnFavoritePacket(msg, s);
-		break;
-	case PacketId::Option:
-		g_UserManager.OnOptionPacket(msg, s);
-		break;
-	case PacketId::Udp:
-		g_UserManager.OnUdpPacket(msg, s);
-		break;
-	case PacketId::Item:
-		g_ItemManager.OnItemPacket(msg, s);
-		break;
-	case PacketId::MiniGame:
-		g_MiniGameManager.OnPacket(msg, s);
-		break;
-	case PacketId::MileageBingo:
-		break;
-	case PacketId::UpdateInfo:
-		g_UserManager.OnUpdateInfoPacket(msg, s);
-		break;
-	case PacketId::Clan:
-		g_ClanManager.OnPacket(msg, s);
-		break;
-	case PacketId::Statistic:
-		g_PacketManager.SendStatistic(s);
-		break;
-	case PacketId::Rank:
-		g_RankManager.OnRankPacket(msg, s);
-		break;
-	case PacketId::Hack:
-		break;
-	case PacketId::Report:
-		g_UserManager.OnReportPacket(msg, s);
-		break;
-	case PacketId::Alarm:
-		g_UserManager.OnAlarmPacket(msg, s);
-		break;
-	case PacketId::Quest:
-		g_QuestManager.OnPacket(msg, s);
-		break;
-	case PacketId::Title:
-		g_QuestManager.OnTitlePacket(msg, s);
-		break;
-	case PacketId::HostServer:
-		g_DedicatedServerManager.OnPacket(msg, s);
-		break;
-	case PacketId::Messenger:
-		g_UserManager.OnMessengerPacket(msg, s);
-		break;
-	case PacketId::UserSurvey:
-		g_UserManager.OnUserSurveyPacket(msg, s);
-		break;
-	case PacketId::Addon:
-		g_UserManager.OnAddonPacket(msg, s);
-		break;
-	case PacketId::Ban:
-		g_UserManager.OnBanPacket(msg, s);
-		break;
-	case PacketId::League:
-		g_UserManager.OnLeaguePacket(msg, s);
-		break;
-	case PacketId::Kick:
-		g_UserManager.OnKickPacket(msg, s);
-		break;
-	case PacketId::Voxel:
-		g_VoxelManager.OnPacket(msg, s);
-		break;
-	default:
-		Logger().Warn("Unimplemented packet: %d\n", msg->GetID());
-		break;
+		unsigned long long offset = data.getReadOffset();
+		subType = data.readUInt8();
+		data.setReadOffset(offset);
 	}
 
+	chrono::steady_clock::time_point start = chrono::steady_clock::now();
+
+	(*handler)(msg, s);
+
+	unsigned long long elapsed = chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now() - start).count();
+	m_PacketStats.Add(id, subType, msg->GetLength(), elapsed);
+	m_MinutePacketStats.Add(id, subType, msg->GetLength(), elapsed);
+
 	delete msg;
 }
 
+/**
+ * Sets handler of packet ID, replaces the previous one
+ */
+void CServerInstance::RegisterPacketHandler(int id, const PacketHandler& handler)
+{
+	if (id < 0 || id >= PACKET_HANDLERS_SIZE)
+	{
+		Logger().Error("CServerInstance::RegisterPacketHandler: invalid packet id %d\n", id);
+		return;
+	}
+
+	m_PacketHandlers[id] = handler;
+}
+
+CPacketStats& CServerInstance::GetPacketStats()
+{
+	return m_PacketStats;
+}
+
+void CServerInstance::RegisterPacketHandlers()
+{
+	RegisterPacketHandler(PacketId::Version, [](CReceivePacket* msg, IExtendedSocket* s) { g_UserManager.OnVersionPacket(msg, s); });
+	RegisterPacketHandler(PacketId::CreateCharacter, [](CReceivePacket* msg, IExtendedSocket* s) { g_UserManager.OnCharacterPacket(msg, s); });
+	RegisterPacketHandler(PacketId::Login, [](CReceivePacket* msg, IExtendedSocket* s) { g_UserManager.OnLoginPacket(msg, s); });
+	RegisterPacketHandler(PacketId::RequestServerList, [](CReceivePacket* msg, IExtendedSocket* s) { g_ChannelManager.OnChannelListPacket(s); });
+	RegisterPacketHandler(PacketId::RequestTransfer, [](CReceivePacket* msg, IExtendedSocket* s) { g_ChannelManager.OnRoomListPacket(msg, s); });
+	RegisterPacketHandler(PacketId::RecvCrypt, [](CReceivePacket* msg, IExtendedSocket* s) { g_UserManager.OnCryptPacket(msg, s); });
+	RegisterPacketHandler(PacketId::Room, [](CReceivePacket* msg, IExtendedSocket* s) { g_ChannelManager.OnRoomRequest(msg, s); });
+	RegisterPacketHandler(PacketId::Shop, [](CReceivePacket* msg, IExtendedSocket* s) { g_ShopManager.OnShopPacket(msg, s); });
+	RegisterPacketHandler(PacketId::UMsg, [](CReceivePacket* msg, IExtendedSocket* s) { g_UserManager.OnUserMessage(msg, s); });
+	RegisterPacketHandler(PacketId::Host, [](CReceivePacket* msg, IExtendedSocket* s) { g_HostManager.OnPacket(msg, s); });
+	RegisterPacketHandler(PacketId::Favorite, [](CReceivePacket* msg, IExtendedSocket* s) { g_UserManager.OnFavoritePacket(msg, s); });
+	RegisterPacketHandler(PacketId::Option, [](CReceivePacket* msg, IExtendedSocket* s) { g_UserManager.OnOptionPacket(msg, s); });
+	RegisterPacketHandler(PacketId::Udp, [](CReceivePacket* msg, IExtendedSocket* s) { g_UserManager.OnUdpPacket(msg, s); });
+	RegisterPacketHandler(PacketId::Item, [](CReceivePacket* msg, IExtendedSocket* s) { g_ItemManager.OnItemPacket(msg, s); });
+	RegisterPacketHandler(PacketId::MiniGame, [](CReceivePacket* msg, IExtendedSocket* s) { g_MiniGameManager.OnPacket(msg, s); });
+	RegisterPacketHandler(PacketId::MileageBingo, [](CReceivePacket* msg, IExtendedSocket* s) {});
+	RegisterPacketHandler(PacketId::UpdateInfo, [](CReceivePacket* msg, IExtendedSocket* s) { g_UserManager.OnUpdateInfoPacket(msg, s); });
+	RegisterPacketHandler(PacketId::Clan, [](CReceivePacket* msg, IExtendedSocket* s) { g_ClanManager.OnPacket(msg, s); });
+	RegisterPacketHandler(PacketId::Statistic, [](CReceivePacket* msg, IExtendedSocket* s) { g_PacketManager.SendStatistic(s); });
+	RegisterPacketHandler(PacketId::Rank, [](CReceivePacket* msg, IExtendedSocket* s) { g_RankManager.OnRankPacket(msg, s); });
+	RegisterPacketHandler(PacketId::Hack, [](CReceivePacket* msg, IExtendedSocket* s) {});
+	RegisterPacketHandler(PacketId::Report, [](CReceivePacket* msg, IExtendedSocket* s) { g_UserManager.OnReportPacket(msg, s); });
+	RegisterPacketHandler(PacketId::Alarm, [](CReceivePacket* msg, IExtendedSocket* s) { g_UserManager.OnAlarmPacket(msg, s); });
+	RegisterPacketHandler(PacketId::Quest, [](CReceivePacket* msg, IExtendedSocket* s) { g_QuestManager.OnPacket(msg, s); });
+	RegisterPacketHandler(PacketId::Title, [](CReceivePacket* msg, IExtendedSocket* s) { g_QuestManager.OnTitlePacket(msg, s); });
+	RegisterPacketHandler(PacketId::HostServer, [](CReceivePacket* msg, IExtendedSocket* s) { g_DedicatedServerManager.OnPacket(msg, s); });
+	RegisterPacketHandler(PacketId::Messenger, [](CReceivePacket* msg, IExtendedSocket* s) { g_UserManager.OnMessengerPacket(msg, s); });
+	RegisterPacketHandler(PacketId::UserSurvey, [](CReceivePacket* msg, IExtendedSocket* s) { g_UserManager.OnUserSurveyPacket(msg, s); });
+	RegisterPacketHandler(PacketId::Addon, [](CReceivePacket* msg, IExtendedSocket* s) { g_UserManager.OnAddonPacket(msg, s); });
+	RegisterPacketHandler(PacketId::Ban, [](CReceivePacket* msg, IExtendedSocket* s) { g_UserManager.OnBanPacket(msg, s); });
+	RegisterPacketHandler(PacketId::League, [](CReceivePacket* msg, IExtendedSocket* s) { g_UserManager.OnLeaguePacket(msg, s); });
+	RegisterPacketHandler(PacketId::Kick, [](CReceivePacket* msg, IExtendedSocket* s) { g_UserManager.OnKickPacket(msg, s); });
+	RegisterPacketHandler(PacketId::Voxel, [](CReceivePacket* msg, IExtendedSocket* s) { g_VoxelManager.OnPacket(msg, s); });
+}
+
+/**
+ * Logs packets handled since the last minute tick
+ */
+void CServerInstance::LogPacketStats()
+{
+	PacketStats_s total = m_MinutePacketStats.GetTotal();
+	if (!total.count)
+		return;
+
+	vector<PacketStats_s> stats = m_MinutePacketStats.GetStats();
+	const PacketStats_s& top = stats.front();
+
+	Logger().Info("Packets: %llu, %llu bytes, handler time: %llu us, p50: %llu us, p99: %llu us. Most expensive: %d/%d, %llu packets, %llu us, p99: %llu us\n",
+		total.count, total.bytes, total.time,
+		CPacketStats::GetPercentile(total.latency, PACKET_STATS_LATENCY_BUCKETS, 50),
+		CPacketStats::GetPercentile(total.latency, PACKET_STATS_LATENCY_BUCKETS, 99),
+		top.id, top.subType, top.count, top.time,
+		CPacketStats::GetPercentile(top.latency, PACKET_STATS_LATENCY_BUCKETS, 99));
+
+	m_MinutePacketStats.Reset();
+}
+
 void CServerInstance::OnSecondTick()
 {
 	// update current time
@@ -482,6 +520,7 @@ void CServerInstance::OnSecondTick()
 void CServerInstance::OnMinuteTick()
 {
 	Logger().Info("%s\n", GetMainInfo());
+	LogPacketStats();
 
 	Manager().MinuteTick(m_CurrentTime);
 }
@@ -526,13 +565,14 @@ std::vector<IExtendedSocket*> CServerInstance::GetClients()
 	return m_TCPServer.GetClients();
 }
 
-IExtendedSocket* CServerInstance::GetSocketByID(unsigned int id)
+vector<TCPWorkerStats_s> CServerInstance::GetTCPWorkerStats()
 {
-	for (auto s : m_TCPServer.GetClients())
-		if (s->GetID() == id)
-			return s;
+	return m_TCPServer.GetWorkerStats();
+}
 
-	return NULL;
+IExtendedSocket* CServerInstance::GetSocketByID(unsigned int id)
+{
+	return m_TCPServer.GetExSocketByID(id);
 }
 
 time_t CServerInstance::GetCurrentTime()
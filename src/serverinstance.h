@@ -3,10 +3,16 @@
 #include "interface/iserverinstance.h"
 #include "interface/net/iserverlistener.h"
 #include "csvtable.h"
+#include "itemattributetable.h"
+#include "common/packetstats.h"
 
 #include "net/tcpserver.h"
 #include "net/udpserver.h"
 
+#define PACKET_HANDLERS_SIZE 256 // packet ID is one byte
+
+typedef std::function<void(CReceivePacket* msg, IExtendedSocket* socket)> PacketHandler;
+
 class CServerInstance : public IServerInstance, IServerListenerTCP, IServerListenerUDP
 {
 public:
@@ -15,6 +21,7 @@ public:
 
 	bool Init();
 	bool Reload();
+	bool ReloadItemTable();
 	bool LoadConfigs();
 	void UnloadConfigs();
 
@@ -41,8 +48,14 @@ public:
 	virtual void DisconnectClient(IExtendedSocket* socket);
 	virtual std::vector<IExtendedSocket*> GetClients();
 	virtual IExtendedSocket* GetSocketByID(unsigned int id);
+	std::vector<TCPWorkerStats_s> GetTCPWorkerStats();
+	void RegisterPacketHandler(int id, const PacketHandler& handler);
+	CPacketStats& GetPacketStats();
 
 private:
+	void RegisterPacketHandlers();
+	void LogPacketStats();
+
 	bool m_bIsServerActive;
 
 	time_t m_CurrentTime;
@@ -51,11 +64,16 @@ private:
 
 	CTCPServer m_TCPServer;
 	CUDPServer m_UDPServer;
+
+	PacketHandler m_PacketHandlers[PACKET_HANDLERS_SIZE];
+	CPacketStats m_PacketStats; // since start
+	CPacketStats m_MinutePacketStats; // since the last minute tick
 };
 
 extern CServerInstance* g_pServerInstance;
 
 extern CCSVTable* g_pItemTable;
+extern CItemAttributeTable* g_pItemAttributeTable;
 extern CCSVTable* g_pMapListTable;
 extern CCSVTable* g_pGameModeListTable;
 
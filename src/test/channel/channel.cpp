@@ -0,0 +1,160 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <doctest/doctest.h>
+
+#include "channel/channel.h"
+#include "user/user.h"
+#include "manager/packetmanager.h"
+#include "net/sendpacket.h"
+#include "net/extendedsocket.h"
+
+#include <chrono>
+#include <stdio.h>
+
+#define BENCH_CHANNEL_USERS 1000
+#define BENCH_BANLIST_SIZE 20
+#define BENCH_MESSAGES 1000
+
+using namespace std;
+
+// defined by main.cpp in the server
+CServerInstance* g_pServerInstance;
+CEvents g_Events;
+CCriticalSection g_ServerCriticalSection;
+
+/*
+ * Socket that counts packets instead of sending them
+ */
+class CTestSocket : public IExtendedSocket
+{
+public:
+	CTestSocket(unsigned int id)
+	{
+		m_nID = id;
+		m_nSeq = 0;
+		m_pSSL = NULL;
+		m_nPackets = 0;
+		m_nBytesSent = 0;
+		m_pUser = NULL;
+	}
+
+	bool SetupCrypt() { return true; }
+	void SetCryptInput(bool val) {}
+	void SetCryptOutput(bool val) {}
+	unsigned char* GetCryptKey() { return NULL; }
+	unsigned char* GetCryptIV() { return NULL; }
+	WOLFSSL*& GetSSLObject() { return m_pSSL; }
+	void SetSSLObject(WOLFSSL* ssl) { m_pSSL = ssl; }
+	void SetIP(const string& addr) { m_IP = addr; }
+	void SetHWID(const vector<unsigned char>& hwid) { m_HWID = hwid; }
+	const string& GetIP() { return m_IP; }
+	const vector<unsigned char>& GetHWID() { return m_HWID; }
+	int GetSeq() { return m_nSeq++ & 0xFF; }
+	int LoggerGetSeq() { return m_nSeq & 0xFF; }
+	void ResetSeq() { m_nSeq = 0; }
+	CReceivePacket* Read() { return NULL; }
+	int Send(vector<unsigned char>& buffer, bool serverHelloMsg = false) { return buffer.size(); }
+
+	int Send(CSendPacket* msg)
+	{
+		int size = msg->GetSize();
+		m_nPackets++;
+		m_nBytesSent += size;
+		delete msg;
+
+		return size;
+	}
+
+	unsigned int GetID() { return m_nID; }
+	SOCKET GetSocket() { return m_nID; }
+	int GetReadResult() { return 0; }
+	int GetBytesReceived() { return 0; }
+	int GetBytesSent() { return m_nBytesSent; }
+	deque<CSendPacket*>& GetPacketsToSend() { return m_PacketsToSend; }
+	GuestData_s& GetGuestData() { return m_GuestData; }
+
+	IUser* GetUser() { return m_pUser; }
+	void SetUser(IUser* user) { m_pUser = user; }
+	CDedicatedServer* GetServer() { return NULL; }
+	void SetServer(CDedicatedServer* server) {}
+
+	unsigned int m_nID;
+	int m_nSeq;
+	WOLFSSL* m_pSSL;
+	string m_IP;
+	vector<unsigned char> m_HWID;
+	deque<CSendPacket*> m_PacketsToSend;
+	GuestData_s m_GuestData;
+	IUser* m_pUser;
+	int m_nPackets;
+	int m_nBytesSent;
+};
+
+/*
+ * User that exists only in memory. Character fields that aren't cached (clan, rank) are not read from the database
+ */
+class CBenchUser : public CUser
+{
+public:
+	CBenchUser(IExtendedSocket* socket, int userID, const string& userName) : CUser(socket, userID, userName)
+	{
+	}
+
+	CUserCharacter GetCharacter(int lowFlag, int highFlag)
+	{
+		return CUser::GetCharacter(lowFlag & USER_CACHE_LOW_FLAGS, highFlag & USER_CACHE_HIGH_FLAGS);
+	}
+};
+
+TEST_CASE("Channel - chat fan-out throughput")
+{
+	CChannel channel(NULL, 1, "Benchmark", BENCH_CHANNEL_USERS, "");
+
+	vector<CTestSocket*> sockets;
+	vector<string> gameNames;
+	for (int i = 0; i < BENCH_CHANNEL_USERS; i++)
+	{
+		sockets.push_back(new CTestSocket(i + 1));
+		gameNames.push_back("player" + to_string(i));
+	}
+
+	// every user bans the next users, half of them have chat blocking enabled
+	for (int i = 0; i < BENCH_CHANNEL_USERS; i++)
+	{
+		UserCache_s cache;
+		cache.character.lowFlag = USER_CACHE_LOW_FLAGS;
+		cache.character.highFlag = USER_CACHE_HIGH_FLAGS;
+		cache.character.gameName = gameNames[i];
+		cache.characterExt.flag = USER_CACHE_EXT_FLAGS;
+		cache.characterExt.banSettings = i % 2 ? BANSETTINGS_CHAT : 0;
+		for (int j = 1; j <= BENCH_BANLIST_SIZE; j++)
+			cache.banList.push_back(gameNames[(i + j) % BENCH_CHANNEL_USERS]);
+
+		// users are not deleted, CUser's destructor ends the session in the user database, which isn't initialized here
+		CBenchUser* user = new CBenchUser(sockets[i], i + 1, gameNames[i]);
+		user->ApplyCache(cache);
+		sockets[i]->SetUser(user);
+
+		REQUIRE(channel.UserJoin(user, false));
+	}
+
+	for (auto socket : sockets)
+		socket->m_nPackets = 0;
+
+	auto start = chrono::steady_clock::now();
+	for (int i = 0; i < BENCH_MESSAGES; i++)
+	{
+		int sender = i % BENCH_CHANNEL_USERS;
+		channel.SendUserMessageToAllUser(UMsgPacketType::LobbyUserMessage, sender + 1, gameNames[sender], "Hello from benchmark");
+	}
+	double time = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+	unsigned long long delivered = 0;
+	for (auto socket : sockets)
+		delivered += socket->m_nPackets;
+
+	// half of the users banning the sender have chat blocking enabled
+	CHECK(delivered == (unsigned long long)BENCH_MESSAGES * (BENCH_CHANNEL_USERS - BENCH_BANLIST_SIZE / 2));
+
+	printf("Channel chat fan-out at %d users: %.1f us per message, %.0f ns per recipient\n",
+		BENCH_CHANNEL_USERS, time / BENCH_MESSAGES * 1000000, time / (double)delivered * 1000000000);
+}
@@ -3,8 +3,21 @@
 
 #include "testbasicfuncs.h"
 #include "testpacketsequence.h"
+#include "testioworkers.h"
+#include "testcoalescedpackets.h"
+#include "testsendqueue.h"
+#include "testslowreader.h"
+
+#include <chrono>
 
 #define TEST_PORT "30002"
+#define TEST_IO_WORKERS 4
+#define TEST_IO_WORKERS_CLIENTS 16
+#define TEST_SEND_QUEUE_PACKETS 1024 // 4 MB, more than socket buffers can hold
+#define TEST_SEND_QUEUE_LIMIT 65536
+#define TEST_SLOW_READER_PACKETS 4096 // 16 MB
+#define TEST_SLOW_READER_ROUND_TRIPS 100
+#define TEST_SLOW_READER_TIMEOUT 10 // seconds
 
 using namespace std;
 
@@ -28,4 +41,136 @@ TEST_CASE("Network (TCP) - Test packet sequence and/or segmentation")
 	{
 		// wait for the test finish/error
 	}
-}
\ No newline at end of file
+}
+
+TEST_CASE("Network (TCP) - Test several packets in one segment")
+{
+	CTCPServer_TestCoalescedPackets server(TEST_PORT);
+	CTCPClient_TestCoalescedPackets client("127.0.0.1", TEST_PORT);
+
+	while (!server.m_bFailed && !server.m_bFinished)
+	{
+		// wait for the test finish/error
+	}
+
+	CHECK(server.m_bFailed == false);
+}
+
+TEST_CASE("Network (TCP) - Test send queue")
+{
+	CTCPServer_TestSendQueue server(TEST_PORT, TEST_SEND_QUEUE_PACKETS, 0);
+	CTCPClient_TestSendQueue client("127.0.0.1", TEST_PORT);
+
+	while (!client.m_bFailed && client.m_nReceived < TEST_SEND_QUEUE_PACKETS)
+	{
+		// wait for the test finish/error
+	}
+
+	CHECK(client.m_bFailed == false);
+	CHECK(server.m_bQueueOverflow == false);
+}
+
+TEST_CASE("Network (TCP) - Test send queue with shared data")
+{
+	CTCPServer_TestSendQueue server(TEST_PORT, TEST_SEND_QUEUE_PACKETS, 0, true);
+	CTCPClient_TestSendQueue client("127.0.0.1", TEST_PORT, true);
+
+	while (!client.m_bFailed && client.m_nReceived < TEST_SEND_QUEUE_PACKETS)
+	{
+		// wait for the test finish/error
+	}
+
+	CHECK(client.m_bFailed == false);
+	CHECK(server.m_bQueueOverflow == false);
+}
+
+TEST_CASE("Network (TCP) - Test shared data ownership")
+{
+	// a moved payload is referenced only by the packet, so the socket can encrypt it in place
+	shared_ptr<vector<unsigned char>> payload = make_shared<vector<unsigned char>>(TEST_SEND_QUEUE_PACKET_SIZE);
+
+	CSendPacket copied(0, 1);
+	copied.WriteSharedData(payload);
+	CHECK(payload.use_count() == 2);
+
+	CSendPacket moved(0, 1);
+	moved.WriteSharedData(move(payload));
+	CHECK(payload == NULL);
+	CHECK(moved.GetSharedData().use_count() == 2);
+
+	copied.WriteSharedData(NULL);
+	CHECK(moved.GetSharedData().use_count() == 1);
+}
+
+TEST_CASE("Network (TCP) - Test send queue limit")
+{
+	CTCPServer_TestSendQueue server(TEST_PORT, TEST_SEND_QUEUE_PACKETS, TEST_SEND_QUEUE_LIMIT);
+	CTCPClient_TestSendQueue client("127.0.0.1", TEST_PORT);
+
+	while (!server.m_bDisconnected)
+	{
+		// wait for the server to disconnect the client
+	}
+
+	CHECK(server.m_bQueueOverflow == true);
+	CHECK(client.m_bFailed == false);
+	CHECK(client.m_nReceived < TEST_SEND_QUEUE_PACKETS);
+}
+
+TEST_CASE("Network (TCP) - Test slow reader doesn't block other clients")
+{
+	CTCPServer_TestSlowReader server(TEST_PORT, TEST_SLOW_READER_PACKETS);
+	CTCPClient_TestSlowReader slowClient("127.0.0.1", TEST_PORT);
+
+	while (server.m_nConnections < 1)
+	{
+		// wait for the server to queue packets to the slow client
+	}
+
+	CTCPClient_TestRoundTrip client("127.0.0.1", TEST_PORT);
+
+	auto deadline = chrono::steady_clock::now() + chrono::seconds(TEST_SLOW_READER_TIMEOUT);
+	while (!client.m_bFailed && client.m_nReceived < TEST_SLOW_READER_ROUND_TRIPS && chrono::steady_clock::now() < deadline)
+	{
+		// wait for the test finish/error
+	}
+
+	CHECK(server.m_bFailed == false);
+	CHECK(client.m_bFailed == false);
+	CHECK(client.m_nReceived >= TEST_SLOW_READER_ROUND_TRIPS);
+}
+
+TEST_CASE("Network (TCP) - Test multiple I/O threads")
+{
+	CTCPServer_TestIOWorkers server(TEST_PORT, TEST_IO_WORKERS);
+
+	{
+		vector<unique_ptr<CTCPClient_TestBasicFuncs>> clients;
+		for (int i = 0; i < TEST_IO_WORKERS_CLIENTS; i++)
+			clients.push_back(make_unique<CTCPClient_TestBasicFuncs>("127.0.0.1", TEST_PORT));
+
+		while (!server.m_bFailed && server.m_nFinished < TEST_IO_WORKERS_CLIENTS)
+		{
+			// wait for the test finish/error
+		}
+	}
+
+	CHECK(server.m_bFailed == false);
+
+	vector<TCPWorkerStats_s> stats = server.m_Server.GetWorkerStats();
+#ifdef WIN32
+	CHECK(stats.size() == 1);
+#else
+	CHECK(stats.size() == TEST_IO_WORKERS);
+#endif
+
+	unsigned long long accepted = 0, packets = 0;
+	for (auto& s : stats)
+	{
+		accepted += s.acceptedConnections;
+		packets += s.packetsReceived;
+	}
+
+	CHECK(accepted == TEST_IO_WORKERS_CLIENTS);
+	CHECK(packets == TEST_IO_WORKERS_CLIENTS);
+}
@@ -0,0 +1,142 @@
+#include <doctest/doctest.h>
+
+#include "net/tcpserver.h"
+#include "net/tcpclient.h"
+#include "net/sendpacket.h"
+#include "net/receivepacket.h"
+#include "net/extendedsocket.h"
+#include "common/net/netdefs.h"
+
+#include "interface/net/iserverlistener.h"
+
+#include <atomic>
+
+using namespace std;
+
+#define TEST_COALESCED_BATCHES 4
+#define TEST_COALESCED_PACKETS_PER_BATCH 16
+#define TEST_COALESCED_LARGE_PACKET_SIZE 40000 // larger than the initial receive buffer
+
+/*
+ * Server class to test several packets received with one recv call
+ */
+class CTCPServer_TestCoalescedPackets : public IServerListenerTCP
+{
+public:
+	CTCPServer_TestCoalescedPackets(const string& port)
+	{
+		m_bFinished = false;
+		m_bFailed = false;
+		m_nReceived = 0;
+
+		m_Server.SetListener(this);
+		REQUIRE(m_Server.Start(port, 128, false) == true);
+	}
+
+	bool OnTCPConnectionCreated(IExtendedSocket* socket)
+	{
+		return true;
+	}
+
+	void OnTCPConnectionClosed(IExtendedSocket* socket)
+	{
+		REQUIRE(m_bFinished == true);
+		if (!m_bFinished)
+		{
+			m_bFailed = true;
+		}
+	}
+
+	void OnTCPMessage(IExtendedSocket* socket, CReceivePacket* msg)
+	{
+		// every packet carries its index, the first packet of a batch is large
+		int index = msg->ReadUInt16();
+		int size = msg->ReadUInt16();
+		vector<unsigned char> data = msg->ReadArray(size);
+
+		bool valid = index == m_nReceived && data.size() == size;
+		for (int i = 0; valid && i < size; i++)
+			valid = data[i] == (unsigned char)(index + i);
+
+		delete msg;
+
+		if (!valid)
+		{
+			m_bFailed = true;
+			return;
+		}
+
+		if (++m_nReceived == TEST_COALESCED_BATCHES * TEST_COALESCED_PACKETS_PER_BATCH)
+			m_bFinished = true;
+	}
+
+	void OnTCPError(int errorCode)
+	{
+		FAIL("Server error occurred");
+		m_bFailed = true;
+	}
+
+	CTCPServer m_Server;
+	atomic<bool> m_bFailed;
+	atomic<bool> m_bFinished;
+	int m_nReceived;
+};
+
+/*
+ * Client class to test several packets received with one recv call. Sends batches of packets with one send call
+ */
+class CTCPClient_TestCoalescedPackets : public IClientListenerTCP
+{
+public:
+	CTCPClient_TestCoalescedPackets(const string& ip, const string& port)
+	{
+		m_Client.SetListener(this);
+		REQUIRE(m_Client.Start(ip, port) == true);
+	}
+
+	void OnTCPServerConnected()
+	{
+		int index = 0;
+		for (int batch = 0; batch < TEST_COALESCED_BATCHES; batch++)
+		{
+			vector<unsigned char> batchData;
+			for (int i = 0; i < TEST_COALESCED_PACKETS_PER_BATCH; i++, index++)
+			{
+				int size = i == 0 ? TEST_COALESCED_LARGE_PACKET_SIZE : i;
+
+				vector<unsigned char> data(size);
+				for (int j = 0; j < size; j++)
+					data[j] = (unsigned char)(index + j);
+
+				CSendPacket msg(m_Client.GetSocket()->GetSeq(), 1);
+				msg.BuildHeader();
+				msg.WriteUInt16(index);
+				msg.WriteUInt16(size);
+				msg.WriteArray(data);
+
+				vector<unsigned char> packet = msg.SetPacketLength();
+				batchData.insert(batchData.end(), packet.begin(), packet.end());
+			}
+
+			// the batch is larger than PACKET_MAX_SIZE, skip the size check
+			REQUIRE(m_Client.GetSocket()->Send(batchData, true) == batchData.size());
+		}
+	}
+
+	void OnTCPServerConnectFailed()
+	{
+		FAIL("Server connect failed");
+	}
+
+	void OnTCPMessage(CReceivePacket* msg)
+	{
+		delete msg;
+	}
+
+	void OnTCPError(int errorCode)
+	{
+		FAIL("Client error occurred");
+	}
+
+	CTCPClient m_Client;
+};
@@ -0,0 +1,67 @@
+#include <doctest/doctest.h>
+
+#include "net/tcpserver.h"
+#include "net/tcpclient.h"
+#include "net/sendpacket.h"
+#include "net/receivepacket.h"
+#include "net/extendedsocket.h"
+
+#include "interface/net/iserverlistener.h"
+
+#include <atomic>
+#include <memory>
+
+using namespace std;
+
+/*
+ * Server class to test connections served by several I/O threads.
+ * Uses the same exchange as CTCPServer_TestBasicFuncs, listener methods are called from different worker threads
+ */
+class CTCPServer_TestIOWorkers : public IServerListenerTCP
+{
+public:
+	CTCPServer_TestIOWorkers(const string& port, int workerCount)
+	{
+		m_nFinished = 0;
+		m_bFailed = false;
+
+		// workers accept and disconnect clients concurrently, the client list is protected by critical section
+		m_Server.SetCriticalSection(&m_CriticalSection);
+		m_Server.SetListener(this);
+		REQUIRE(m_Server.Start(port, 128, false, workerCount) == true);
+	}
+
+	bool OnTCPConnectionCreated(IExtendedSocket* socket)
+	{
+		// send message with id 1
+		CSendPacket* msg = new CSendPacket(socket->GetSeq(), 1);
+		msg->BuildHeader();
+		msg->WriteString("Hello from server");
+		socket->Send(msg);
+
+		return true;
+	}
+
+	void OnTCPConnectionClosed(IExtendedSocket* socket)
+	{
+	}
+
+	void OnTCPMessage(IExtendedSocket* socket, CReceivePacket* msg)
+	{
+		if (msg->GetSequence() != 1 || msg->GetID() != 2 || msg->ReadString() != "Hello from client")
+			m_bFailed = true;
+
+		m_nFinished++;
+		delete msg;
+	}
+
+	void OnTCPError(int errorCode)
+	{
+		m_bFailed = true;
+	}
+
+	CCriticalSection m_CriticalSection;
+	CTCPServer m_Server;
+	atomic<bool> m_bFailed;
+	atomic<int> m_nFinished;
+};
@@ -0,0 +1,154 @@
+#include <doctest/doctest.h>
+
+#include "net/tcpserver.h"
+#include "net/tcpclient.h"
+#include "net/sendpacket.h"
+#include "net/receivepacket.h"
+#include "net/extendedsocket.h"
+#include "common/net/netdefs.h"
+#include "serverconfig.h"
+
+#include "interface/net/iserverlistener.h"
+
+#include <atomic>
+
+using namespace std;
+
+#define TEST_SEND_QUEUE_PACKET_SIZE 4096
+
+/*
+ * Server class to test the send queue. Queues all packets at once when client connects,
+ * so they are sent with several writev calls and some of them partially.
+ * With shared data all packets send the same data buffer after their own header
+ */
+class CTCPServer_TestSendQueue : public IServerListenerTCP
+{
+public:
+	CTCPServer_TestSendQueue(const string& port, int packetCount, int sendQueueLimit, bool sharedData = false)
+	{
+		m_nPacketCount = packetCount;
+		m_bSharedData = sharedData;
+		m_bQueueOverflow = false;
+		m_bDisconnected = false;
+
+		m_nOldSendQueueLimit = g_pServerConfig->tcpSendQueueLimit;
+		g_pServerConfig->tcpSendQueueLimit = sendQueueLimit;
+
+		m_Server.SetListener(this);
+		REQUIRE(m_Server.Start(port, 128, false) == true);
+	}
+
+	~CTCPServer_TestSendQueue()
+	{
+		g_pServerConfig->tcpSendQueueLimit = m_nOldSendQueueLimit;
+	}
+
+	bool OnTCPConnectionCreated(IExtendedSocket* socket)
+	{
+		vector<unsigned char> data(TEST_SEND_QUEUE_PACKET_SIZE);
+		shared_ptr<vector<unsigned char>> sharedData = make_shared<vector<unsigned char>>(TEST_SEND_QUEUE_PACKET_SIZE);
+		for (int j = 0; j < TEST_SEND_QUEUE_PACKET_SIZE; j++)
+			(*sharedData)[j] = (unsigned char)j;
+
+		for (int i = 0; i < m_nPacketCount; i++)
+		{
+			CSendPacket* msg = new CSendPacket(socket->GetSeq(), 1);
+			msg->BuildHeader();
+			msg->WriteUInt32(i);
+
+			if (m_bSharedData)
+			{
+				msg->WriteSharedData(sharedData);
+			}
+			else
+			{
+				for (int j = 0; j < TEST_SEND_QUEUE_PACKET_SIZE; j++)
+					data[j] = (unsigned char)(i + j);
+
+				msg->WriteArray(data);
+			}
+
+			if (socket->Send(msg) == SOCKET_ERROR)
+			{
+				m_bQueueOverflow = true;
+				break;
+			}
+		}
+
+		return true;
+	}
+
+	void OnTCPConnectionClosed(IExtendedSocket* socket)
+	{
+		m_bDisconnected = true;
+	}
+
+	void OnTCPMessage(IExtendedSocket* socket, CReceivePacket* msg)
+	{
+		delete msg;
+	}
+
+	void OnTCPError(int errorCode)
+	{
+		// expected when the send queue overflows
+	}
+
+	CTCPServer m_Server;
+	int m_nPacketCount;
+	bool m_bSharedData;
+	int m_nOldSendQueueLimit;
+	atomic<bool> m_bQueueOverflow;
+	atomic<bool> m_bDisconnected;
+};
+
+/*
+ * Client class to test the send queue. Checks order and contents of received packets
+ */
+class CTCPClient_TestSendQueue : public IClientListenerTCP
+{
+public:
+	CTCPClient_TestSendQueue(const string& ip, const string& port, bool sharedData = false)
+	{
+		m_nReceived = 0;
+		m_bSharedData = sharedData;
+		m_bFailed = false;
+
+		m_Client.SetListener(this);
+		REQUIRE(m_Client.Start(ip, port) == true);
+	}
+
+	void OnTCPServerConnected()
+	{
+	}
+
+	void OnTCPServerConnectFailed()
+	{
+		m_bFailed = true;
+	}
+
+	void OnTCPMessage(CReceivePacket* msg)
+	{
+		int index = msg->ReadUInt32();
+		vector<unsigned char> data = msg->ReadArray(TEST_SEND_QUEUE_PACKET_SIZE);
+
+		bool valid = index == m_nReceived && data.size() == TEST_SEND_QUEUE_PACKET_SIZE;
+		for (int j = 0; valid && j < TEST_SEND_QUEUE_PACKET_SIZE; j++)
+			valid = data[j] == (unsigned char)((m_bSharedData ? 0 : index) + j);
+
+		if (!valid)
+			m_bFailed = true;
+
+		m_nReceived++;
+		delete msg;
+	}
+
+	void OnTCPError(int errorCode)
+	{
+		// the server may reset the connection in the queue limit test
+	}
+
+	CTCPClient m_Client;
+	bool m_bSharedData;
+	atomic<int> m_nReceived;
+	atomic<bool> m_bFailed;
+};
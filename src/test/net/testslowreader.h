@@ -0,0 +1,177 @@
+#include <doctest/doctest.h>
+
+#include "net/tcpserver.h"
+#include "net/tcpclient.h"
+#include "net/sendpacket.h"
+#include "net/receivepacket.h"
+#include "net/extendedsocket.h"
+#include "common/net/netdefs.h"
+#include "serverconfig.h"
+
+#include "interface/net/iserverlistener.h"
+
+#include <atomic>
+
+using namespace std;
+
+#define TEST_SLOW_READER_PACKET_SIZE 4096
+
+/*
+ * Server class to test that a client which doesn't read doesn't stall other clients of the same worker.
+ * Queues much more data than socket buffers can hold to the first client, answers every message of other clients
+ */
+class CTCPServer_TestSlowReader : public IServerListenerTCP
+{
+public:
+	CTCPServer_TestSlowReader(const string& port, int floodPackets)
+	{
+		m_nFloodPackets = floodPackets;
+		m_nConnections = 0;
+		m_bFailed = false;
+
+		// the slow client must keep all its packets queued
+		m_nOldSendQueueLimit = g_pServerConfig->tcpSendQueueLimit;
+		g_pServerConfig->tcpSendQueueLimit = 0;
+
+		// all clients are served by one worker
+		m_Server.SetListener(this);
+		REQUIRE(m_Server.Start(port, 128, false, 1) == true);
+	}
+
+	~CTCPServer_TestSlowReader()
+	{
+		g_pServerConfig->tcpSendQueueLimit = m_nOldSendQueueLimit;
+	}
+
+	bool OnTCPConnectionCreated(IExtendedSocket* socket)
+	{
+		if (m_nConnections++ == 0)
+		{
+			vector<unsigned char> data(TEST_SLOW_READER_PACKET_SIZE);
+			for (int i = 0; i < m_nFloodPackets; i++)
+			{
+				CSendPacket* msg = new CSendPacket(socket->GetSeq(), 1);
+				msg->BuildHeader();
+				msg->WriteArray(data);
+				socket->Send(msg);
+			}
+		}
+
+		return true;
+	}
+
+	void OnTCPConnectionClosed(IExtendedSocket* socket)
+	{
+	}
+
+	void OnTCPMessage(IExtendedSocket* socket, CReceivePacket* msg)
+	{
+		if (msg->GetID() != 2)
+			m_bFailed = true;
+
+		// echo the counter back
+		CSendPacket* reply = new CSendPacket(socket->GetSeq(), 1);
+		reply->BuildHeader();
+		reply->WriteUInt32(msg->ReadUInt32());
+		socket->Send(reply);
+
+		delete msg;
+	}
+
+	void OnTCPError(int errorCode)
+	{
+	}
+
+	CTCPServer m_Server;
+	int m_nFloodPackets;
+	int m_nOldSendQueueLimit;
+	atomic<int> m_nConnections;
+	atomic<bool> m_bFailed;
+};
+
+/*
+ * Client that connects with a small receive buffer and never reads
+ */
+class CTCPClient_TestSlowReader
+{
+public:
+	CTCPClient_TestSlowReader(const string& ip, const string& port)
+	{
+		addrinfo hints = {};
+		addrinfo* result = NULL;
+		hints.ai_family = AF_INET;
+		hints.ai_socktype = SOCK_STREAM;
+		hints.ai_protocol = IPPROTO_TCP;
+		REQUIRE(getaddrinfo(ip.data(), port.data(), &hints, &result) == 0);
+
+		m_Socket = socket(result->ai_family, result->ai_socktype, result->ai_protocol);
+		REQUIRE(m_Socket != INVALID_SOCKET);
+
+		int bufSize = 4096;
+		setsockopt(m_Socket, SOL_SOCKET, SO_RCVBUF, (char*)&bufSize, sizeof(bufSize));
+
+		REQUIRE(connect(m_Socket, result->ai_addr, result->ai_addrlen) != SOCKET_ERROR);
+		freeaddrinfo(result);
+	}
+
+	~CTCPClient_TestSlowReader()
+	{
+		closesocket(m_Socket);
+	}
+
+	SOCKET m_Socket;
+};
+
+/*
+ * Client class that exchanges messages with the server one by one
+ */
+class CTCPClient_TestRoundTrip : public IClientListenerTCP
+{
+public:
+	CTCPClient_TestRoundTrip(const string& ip, const string& port)
+	{
+		m_nReceived = 0;
+		m_bFailed = false;
+
+		m_Client.SetListener(this);
+		REQUIRE(m_Client.Start(ip, port) == true);
+	}
+
+	void OnTCPServerConnected()
+	{
+		SendCounter(0);
+	}
+
+	void OnTCPServerConnectFailed()
+	{
+		m_bFailed = true;
+	}
+
+	void OnTCPMessage(CReceivePacket* msg)
+	{
+		if ((int)msg->ReadUInt32() != m_nReceived)
+			m_bFailed = true;
+
+		m_nReceived++;
+		SendCounter(m_nReceived);
+
+		delete msg;
+	}
+
+	void OnTCPError(int errorCode)
+	{
+		m_bFailed = true;
+	}
+
+	void SendCounter(int counter)
+	{
+		CSendPacket* msg = new CSendPacket(m_Client.GetSocket()->GetSeq(), 2);
+		msg->BuildHeader();
+		msg->WriteUInt32(counter);
+		m_Client.GetSocket()->Send(msg);
+	}
+
+	CTCPClient m_Client;
+	atomic<int> m_nReceived;
+	atomic<bool> m_bFailed;
+};
@@ -0,0 +1,89 @@
+#include <doctest/doctest.h>
+#include "common/banlist.h"
+#include <chrono>
+#include <string>
+#include <stdio.h>
+
+#define BENCH_CHANNEL_USERS 1000
+#define BENCH_BANLIST_SIZE 20
+#define BENCH_MESSAGES 1000
+
+using namespace std;
+
+TEST_CASE("BanList - add, remove and lookup")
+{
+	CBanList banList;
+	banList.Load(vector<string>{ "alpha", "beta" });
+	CHECK(banList.Contains("alpha"));
+	CHECK(!banList.Contains("Alpha")); // game names are compared as stored in the database
+
+	banList.Add("gamma");
+	banList.Add("alpha"); // already banned
+	CHECK((banList.Get() == vector<string>{ "alpha", "beta", "gamma" }));
+
+	banList.Remove("beta");
+	banList.Remove("delta"); // not banned
+	CHECK((banList.Get() == vector<string>{ "alpha", "gamma" }));
+	CHECK(!banList.Contains("beta"));
+
+	CHECK(banList.IsBlocking(BANSETTINGS_CHAT, BANSETTINGS_CHAT, "alpha"));
+	CHECK(!banList.IsBlocking(BANSETTINGS_ROOMJOIN, BANSETTINGS_CHAT, "alpha"));
+	CHECK(!banList.IsBlocking(BANSETTINGS_CHAT, BANSETTINGS_CHAT, "beta"));
+
+	banList.Clear();
+	CHECK(banList.Get().empty());
+	CHECK(!banList.Contains("alpha"));
+}
+
+struct BenchUser_s
+{
+	string gameName;
+	int banSettings;
+	CBanList banList;
+};
+
+// CBanList micro-benchmark: only the ban checks of a lobby message, without channel, user and packet costs.
+// The full fan-out through CChannel::SendUserMessageToAllUser is measured by test_channel
+TEST_CASE("BanList - micro-benchmark: ban checks of chat fan-out")
+{
+	vector<BenchUser_s> users(BENCH_CHANNEL_USERS);
+	for (int i = 0; i < BENCH_CHANNEL_USERS; i++)
+	{
+		users[i].gameName = "player" + to_string(i);
+		users[i].banSettings = i % 2 ? BANSETTINGS_CHAT : 0;
+	}
+
+	// every user bans the next users
+	for (int i = 0; i < BENCH_CHANNEL_USERS; i++)
+	{
+		for (int j = 1; j <= BENCH_BANLIST_SIZE; j++)
+			users[i].banList.Add(users[(i + j) % BENCH_CHANNEL_USERS].gameName);
+	}
+
+	unsigned long long delivered = 0;
+	vector<int> recipients;
+	recipients.reserve(BENCH_CHANNEL_USERS);
+
+	auto start = chrono::steady_clock::now();
+	for (int i = 0; i < BENCH_MESSAGES; i++)
+	{
+		const string& senderName = users[i % BENCH_CHANNEL_USERS].gameName;
+
+		recipients.clear();
+		for (int j = 0; j < BENCH_CHANNEL_USERS; j++)
+		{
+			const BenchUser_s& userDest = users[j];
+			if (!userDest.banList.IsBlocking(userDest.banSettings, BANSETTINGS_CHAT, senderName))
+				recipients.push_back(j);
+		}
+
+		delivered += recipients.size();
+	}
+	double time = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+	// half of the users banning the sender have chat blocking enabled
+	CHECK(delivered == (unsigned long long)BENCH_MESSAGES * (BENCH_CHANNEL_USERS - BENCH_BANLIST_SIZE / 2));
+
+	printf("Ban checks of chat fan-out at %d channel users: %.1f us per message, %.0f ns per recipient\n",
+		BENCH_CHANNEL_USERS, time / BENCH_MESSAGES * 1000000, time / ((double)BENCH_MESSAGES * BENCH_CHANNEL_USERS) * 1000000000);
+}
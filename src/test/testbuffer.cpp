@@ -0,0 +1,179 @@
+#include <doctest/doctest.h>
+#include "common/buffer.h"
+#include <thread>
+#include <chrono>
+#include <string>
+#include <stdio.h>
+
+#define BENCH_PACKETS 200000
+
+using namespace std;
+
+TEST_CASE("Buffer - write and read")
+{
+	Buffer buf;
+	buf.writeUInt8(0x55);
+	buf.writeUInt16_LE(0x1234);
+	buf.writeUInt32_BE(0x11223344);
+	buf.writeStr("test");
+	buf.writeArray(vector<unsigned char>{ 1, 2, 3 });
+	buf.writeInt64_LE(-2);
+
+	CHECK(buf.getSize() == 1 + 2 + 4 + 5 + 3 + 8);
+	CHECK(buf.readUInt8() == 0x55);
+	CHECK(buf.readUInt16_LE() == 0x1234);
+	CHECK(buf.readUInt32_BE() == 0x11223344);
+	CHECK(buf.readStr() == "test");
+	CHECK((buf.readArr(3) == vector<unsigned char>{ 1, 2, 3 }));
+	CHECK(buf.readInt64_LE() == -2);
+
+	// insert in the middle
+	buf.setWriteOffset(1);
+	buf.writeUInt8(0xAA);
+	CHECK(buf.getSize() == 24);
+	CHECK(buf.getBuffer()[1] == 0xAA);
+	CHECK(buf.getBuffer()[2] == 0x34);
+
+	// override
+	buf.setWriteOffset(1);
+	buf.setOverride(true);
+	buf.writeUInt16_LE(0xBBCC);
+	buf.setOverride(false);
+	CHECK(buf.getSize() == 24);
+	CHECK(buf.getBuffer()[1] == 0xCC);
+	CHECK(buf.getBuffer()[2] == 0xBB);
+
+	// grow through all size classes
+	Buffer big;
+	for (int i = 0; i < 100000; i++)
+		big.writeUInt8(i);
+
+	CHECK(big.getSize() == 100000);
+	for (int i = 0; i < 100000; i++)
+		REQUIRE(big.readUInt8() == (unsigned char)i);
+}
+
+TEST_CASE("Buffer - pooled storage")
+{
+	const unsigned char* data;
+	{
+		Buffer buf;
+		buf.writeUInt32_LE(1);
+		data = buf.getData();
+	}
+
+	// the last released buffer of the class is taken first
+	Buffer buf;
+	buf.writeUInt32_LE(2);
+	CHECK(buf.getData() == data);
+
+	// buffers built by one thread and released by another
+	vector<Buffer*> buffers;
+	for (int i = 0; i < 1000; i++)
+	{
+		Buffer* b = new Buffer();
+		b->writeUInt32_LE(i);
+		buffers.push_back(b);
+	}
+
+	thread t([&buffers]() {
+		for (auto b : buffers)
+			delete b;
+	});
+	t.join();
+
+	for (int i = 0; i < 1000; i++)
+	{
+		Buffer b;
+		b.writeUInt32_LE(i);
+		REQUIRE(b.readUInt32_LE() == i);
+	}
+}
+
+/**
+ * Buffer write path before pooling: 20 KB reserved per buffer, every byte inserted separately
+ */
+class CLegacyBuffer
+{
+public:
+	CLegacyBuffer()
+	{
+		buffer.reserve(20000);
+		writeOffset = 0;
+	}
+
+	template <class T> void writeBytes(const T& val)
+	{
+		for (unsigned int i = 0, mask = 0; i < sizeof(T); ++i, mask += 8)
+			buffer.insert(buffer.begin() + writeOffset + i, val >> mask);
+
+		writeOffset += sizeof(T);
+	}
+
+	void writeStr(const string& str)
+	{
+		for (unsigned char s : str) writeBytes<char>(s);
+		writeBytes<char>('\0');
+	}
+
+	vector<unsigned char> buffer;
+	unsigned long long writeOffset;
+};
+
+template <class T> static void BuildPacket(T& buf, int i)
+{
+	// typical lobby packet: header, a few numbers and a string
+	buf.writeStr(string("U"));
+	buf.writeUInt8(i);
+	buf.writeUInt16_LE(0);
+	buf.writeUInt8(65);
+	buf.writeUInt32_LE(i);
+	buf.writeUInt32_LE(i * 2);
+	buf.writeStr("player name");
+	for (int j = 0; j < 16; j++)
+		buf.writeUInt16_LE(j);
+}
+
+struct LegacyWriter_s
+{
+	CLegacyBuffer buf;
+	void writeStr(const string& str) { buf.writeStr(str); }
+	void writeUInt8(unsigned char val) { buf.writeBytes(val); }
+	void writeUInt16_LE(unsigned short val) { buf.writeBytes(val); }
+	void writeUInt32_LE(unsigned int val) { buf.writeBytes(val); }
+};
+
+TEST_CASE("Buffer - write throughput")
+{
+	unsigned long long legacyBytes = 0, bytes = 0;
+
+	auto start = chrono::steady_clock::now();
+	for (int i = 0; i < BENCH_PACKETS; i++)
+	{
+		LegacyWriter_s writer;
+		BuildPacket(writer, i);
+		legacyBytes += writer.buf.buffer.size();
+	}
+	double legacyTime = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+	start = chrono::steady_clock::now();
+	for (int i = 0; i < BENCH_PACKETS; i++)
+	{
+		Buffer buf;
+		BuildPacket(buf, i);
+		bytes += buf.getSize();
+	}
+	double time = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+	CHECK(legacyBytes == bytes);
+
+	// both implementations must produce the same data
+	LegacyWriter_s writer;
+	Buffer buf;
+	BuildPacket(writer, 7);
+	BuildPacket(buf, 7);
+	CHECK(writer.buf.buffer == buf.getBuffer());
+
+	printf("Buffer write throughput: legacy %.1f MB/s (%.0f packets/s), pooled %.1f MB/s (%.0f packets/s)\n",
+		legacyBytes / legacyTime / 1048576, BENCH_PACKETS / legacyTime, bytes / time / 1048576, BENCH_PACKETS / time);
+}
@@ -49,3 +49,108 @@ TEST_CASE("Events - test events")
 
 	CHECK(counter == 2);
 }
+
+TEST_CASE("Events - remove events by socket")
+{
+	// events queued before RemoveEventsBySocket() are skipped, events queued after it are executed
+	vector<int> executed;
+	IExtendedSocket* socket1 = reinterpret_cast<IExtendedSocket*>(0x1000);
+	IExtendedSocket* socket2 = reinterpret_cast<IExtendedSocket*>(0x2000);
+
+	CEvents events;
+	events.AddEventTCPPacket(socket1, [&executed]() { executed.push_back(1); });
+	events.AddEventTCPPacket(socket2, [&executed]() { executed.push_back(2); });
+	events.AddEventTCPPacket(socket1, [&executed]() { executed.push_back(3); });
+	events.AddEventFunction([&executed]() { executed.push_back(4); });
+
+	events.RemoveEventsBySocket(socket1);
+
+	// new socket object may get the same address
+	events.AddEventTCPPacket(socket1, [&executed]() { executed.push_back(5); });
+
+	CHECK(events.ExecuteEvents(100) == 3);
+	CHECK(executed == vector<int>({ 2, 4, 5 }));
+	CHECK(events.GetNextEvent() == NULL);
+}
+
+TEST_CASE("Events - multiple producers")
+{
+	// events of every producer are executed once and in order
+	const int producerCount = 4;
+	const int eventCount = 20000;
+
+	vector<int> lastValues(producerCount, -1);
+	atomic<int> outOfOrder{ 0 };
+	atomic<int> executed{ 0 };
+
+	CEvents events;
+
+	vector<thread> producers;
+	for (int i = 0; i < producerCount; i++)
+	{
+		producers.emplace_back([&, i]() {
+			for (int j = 0; j < eventCount; j++)
+			{
+				events.AddEventFunction([&, i, j]() {
+					if (lastValues[i] != j - 1)
+						outOfOrder++;
+
+					lastValues[i] = j;
+					executed++;
+				});
+			}
+		});
+	}
+
+	while (executed < producerCount * eventCount)
+	{
+		events.WaitForSignal();
+		while (events.ExecuteEvents(EVENT_BATCH_SIZE) == EVENT_BATCH_SIZE);
+	}
+
+	for (auto& t : producers)
+		t.join();
+
+	CHECK(executed == producerCount * eventCount);
+	CHECK(outOfOrder == 0);
+	CHECK(events.GetNextEvent() == NULL);
+
+	unsigned long long added = 0;
+	for (auto count : events.GetQueueDepthHistogram())
+		added += count;
+
+	CHECK(added == producerCount * eventCount);
+}
+
+TEST_CASE("Events - full queue overflows instead of blocking")
+{
+	// the event thread adds more events than the ring holds, none of them may block or get lost
+	const int eventCount = EVENT_QUEUE_SIZE + 1000;
+	IExtendedSocket* socket = reinterpret_cast<IExtendedSocket*>(0x1000);
+
+	vector<int> executed;
+	CEvents events;
+	for (int i = 0; i < eventCount; i++)
+		events.AddEventFunction([&executed, i]() { executed.push_back(i); });
+
+	// events of the socket in the ring and in the overflow list are skipped
+	events.AddEventTCPPacket(socket, [&executed]() { executed.push_back(-1); });
+	events.RemoveEventsBySocket(socket);
+	events.AddEventFunction([&executed, eventCount]() { executed.push_back(eventCount); });
+
+	CHECK(events.GetOverflowEvents() == 1002);
+
+	while (events.ExecuteEvents(EVENT_BATCH_SIZE) == EVENT_BATCH_SIZE);
+
+	bool inOrder = (int)executed.size() == eventCount + 1;
+	for (int i = 0; inOrder && i <= eventCount; i++)
+		inOrder = executed[i] == i;
+
+	CHECK(inOrder);
+	CHECK(events.GetNextEvent() == NULL);
+
+	// the queue takes events again after the overflow list is drained
+	events.AddEventFunction([]() {});
+	CHECK(events.GetOverflowEvents() == 1002);
+	CHECK(events.ExecuteEvents(EVENT_BATCH_SIZE) == 1);
+}
@@ -0,0 +1,55 @@
+#include <doctest/doctest.h>
+#include "common/packetstats.h"
+
+using namespace std;
+
+TEST_CASE("PacketStats - counts packets by ID and sub type")
+{
+	CPacketStats stats;
+	stats.Add(1, 0, 10, 5);
+	stats.Add(1, 0, 20, 5);
+	stats.Add(1, 3, 10, 1000);
+	stats.Add(2, PACKET_STATS_NO_SUBTYPE, 0, 0);
+
+	vector<PacketStats_s> list = stats.GetStats();
+	REQUIRE(list.size() == 3);
+
+	// the most expensive first
+	CHECK(list[0].id == 1);
+	CHECK(list[0].subType == 3);
+	CHECK(list[1].id == 1);
+	CHECK(list[1].subType == 0);
+	CHECK(list[1].count == 2);
+	CHECK(list[1].bytes == 30);
+	CHECK(list[1].time == 10);
+	CHECK(list[2].id == 2);
+	CHECK(list[2].subType == PACKET_STATS_NO_SUBTYPE);
+
+	PacketStats_s total = stats.GetTotal();
+	CHECK(total.count == 4);
+	CHECK(total.bytes == 40);
+	CHECK(total.time == 1010);
+
+	stats.Reset();
+	CHECK(stats.GetStats().empty());
+	CHECK(stats.GetTotal().count == 0);
+}
+
+TEST_CASE("PacketStats - percentiles")
+{
+	CPacketStats stats;
+	for (int i = 0; i < 98; i++)
+		stats.Add(1, 0, 100, 3); // bucket 2-3
+
+	stats.Add(1, 0, 100, 700); // bucket 512-1023
+	stats.Add(1, 0, 100, 100000000); // last bucket
+
+	PacketStats_s total = stats.GetTotal();
+	CHECK(CPacketStats::GetPercentile(total.latency, PACKET_STATS_LATENCY_BUCKETS, 50) == 3);
+	CHECK(CPacketStats::GetPercentile(total.latency, PACKET_STATS_LATENCY_BUCKETS, 98.5) == 1023);
+	CHECK(CPacketStats::GetPercentile(total.latency, PACKET_STATS_LATENCY_BUCKETS, 100) == 1ULL << (PACKET_STATS_LATENCY_BUCKETS - 2));
+	CHECK(CPacketStats::GetPercentile(total.size, PACKET_STATS_SIZE_BUCKETS, 99) == 127);
+
+	unsigned long long empty[PACKET_STATS_LATENCY_BUCKETS] = {};
+	CHECK(CPacketStats::GetPercentile(empty, PACKET_STATS_LATENCY_BUCKETS, 99) == 0);
+}
@@ -0,0 +1,84 @@
+#include <doctest/doctest.h>
+#include "common/profiler.h"
+
+#include <thread>
+
+using namespace std;
+
+static CProfiler s_Profiler("Test");
+
+static void ProfiledInner(int rows)
+{
+	PROFILE_SCOPE(s_Profiler, "Inner");
+	CProfiler::AddRows(rows);
+}
+
+static void ProfiledOuter()
+{
+	PROFILE_SCOPE(s_Profiler, "Outer");
+	CProfiler::AddRows(1);
+	ProfiledInner(5);
+	CProfiler::AddRows(2);
+}
+
+static ProfilerStats_s FindStats(const string& name)
+{
+	for (auto& stats : s_Profiler.GetStats())
+	{
+		if (stats.name == name)
+			return stats;
+	}
+
+	return ProfilerStats_s{ name, 0, 0, 0, 0, 0 };
+}
+
+TEST_CASE("Profiler - counts calls and rows of the innermost scope")
+{
+	s_Profiler.Reset();
+	s_Profiler.SetEnabled(true);
+	s_Profiler.SetSampleRate(1);
+	s_Profiler.SetSlowThreshold(0);
+
+	ProfiledOuter();
+	ProfiledOuter();
+	ProfiledInner(1);
+	CProfiler::AddRows(100); // outside of profiled calls
+
+	ProfilerStats_s outer = FindStats("Outer");
+	CHECK(outer.calls == 2);
+	CHECK(outer.sampledCalls == 2);
+	CHECK(outer.rows == 6);
+
+	ProfilerStats_s inner = FindStats("Inner");
+	CHECK(inner.calls == 3);
+	CHECK(inner.rows == 11);
+
+	s_Profiler.Reset();
+	CHECK(s_Profiler.GetStats().empty());
+}
+
+TEST_CASE("Profiler - sampling and disabling")
+{
+	s_Profiler.Reset();
+	s_Profiler.SetSampleRate(4);
+
+	// sample counter is per thread, use a new one to start from zero
+	thread([]()
+	{
+		for (int i = 0; i < 100; i++)
+			ProfiledInner(1);
+	}).join();
+
+	ProfilerStats_s inner = FindStats("Inner");
+	CHECK(inner.calls == 100);
+	CHECK(inner.sampledCalls == 25);
+	CHECK(inner.rows == 100);
+
+	s_Profiler.SetEnabled(false);
+	ProfiledInner(1);
+	CHECK(FindStats("Inner").calls == 100);
+
+	s_Profiler.SetEnabled(true);
+	s_Profiler.SetSampleRate(0);
+	CHECK(s_Profiler.GetSampleRate() == 1);
+}
@@ -0,0 +1,85 @@
+#include <doctest/doctest.h>
+#include "common/timerwheel.h"
+#include <vector>
+#include <algorithm>
+#include <stdlib.h>
+
+using namespace std;
+
+TEST_CASE("TimerWheel - expires timers on their tick")
+{
+	CTimerWheel<int> wheel;
+	wheel.Reset(1000);
+
+	wheel.Schedule(1001, 1);
+	wheel.Schedule(1063, 2);
+	wheel.Schedule(1064, 3);
+	wheel.Schedule(1000 + 5000, 4);
+	wheel.Schedule(990, 5); // in the past
+	CHECK(wheel.Size() == 5);
+
+	vector<int> expired;
+	wheel.Advance(1001, expired);
+	sort(expired.begin(), expired.end());
+	CHECK((expired == vector<int>{ 1, 5 }));
+
+	expired.clear();
+	wheel.Advance(1062, expired);
+	CHECK(expired.empty());
+
+	wheel.Advance(1064, expired);
+	CHECK((expired == vector<int>{ 2, 3 }));
+
+	expired.clear();
+	wheel.Advance(5999, expired);
+	CHECK(expired.empty());
+
+	wheel.Advance(6000, expired);
+	CHECK((expired == vector<int>{ 4 }));
+	CHECK(wheel.Size() == 0);
+}
+
+TEST_CASE("TimerWheel - random timers across all levels")
+{
+	CTimerWheel<int> wheel;
+	time_t start = 29000000; // minutes since epoch
+	wheel.Reset(start);
+
+	srand(1);
+
+	vector<time_t> ticks;
+	for (int i = 0; i < 2000; i++)
+	{
+		time_t tick = start + (rand() % 4 == 0 ? rand() % 64 : (time_t)rand() % (1 << 20));
+		ticks.push_back(tick);
+		wheel.Schedule(tick, i);
+	}
+
+	// far timer goes to the overflow list
+	ticks.push_back(start + (1 << 24) + 100);
+	wheel.Schedule(ticks.back(), (int)ticks.size() - 1);
+
+	// advance with uneven steps, every timer must expire in the step that contains its tick
+	time_t cur = start;
+	int count = 0;
+	bool ok = true;
+	while (wheel.Size())
+	{
+		time_t prev = cur;
+		cur += rand() % 3 == 0 ? 1 : rand() % 5000;
+
+		vector<int> expired;
+		wheel.Advance(cur, expired);
+
+		for (int id : expired)
+		{
+			if (ticks[id] > cur || (ticks[id] <= prev && ticks[id] > start))
+				ok = false;
+		}
+
+		count += expired.size();
+	}
+
+	CHECK(ok);
+	CHECK(count == (int)ticks.size());
+}
@@ -0,0 +1,150 @@
+#include <doctest/doctest.h>
+#include "user/usercache.h"
+
+using namespace std;
+
+TEST_CASE("UserCache - copies selected character fields")
+{
+	CUserCharacter src = {};
+	src.gameName = "player";
+	src.level = 10;
+	src.points = 500;
+	src.battles = 1;
+	src.win = 2;
+	src.kills = 3;
+	src.deaths = 4;
+	src.honorPoints = 5;
+	src.prefixId = 6;
+	src.chatColorID = 7;
+
+	CUserCharacter dest = {};
+	CopyCharacter(dest, src, UFLAG_LOW_GAMENAME | UFLAG_LOW_STAT | UFLAG_LOW_ACHIEVEMENT, UFLAG_HIGH_CHATCOLOR, 0x2 | 0x8, 0x2);
+	CHECK(dest.gameName == "player");
+	CHECK(dest.level == 0);
+	CHECK(dest.points == 0);
+	CHECK(dest.battles == 0);
+	CHECK(dest.win == 2);
+	CHECK(dest.kills == 0);
+	CHECK(dest.deaths == 4);
+	CHECK(dest.honorPoints == 0);
+	CHECK(dest.prefixId == 6);
+	CHECK(dest.chatColorID == 7);
+
+	// all stat and achievement fields by default
+	CUserCharacter all = {};
+	CopyCharacter(all, src, UFLAG_LOW_STAT | UFLAG_LOW_ACHIEVEMENT, 0);
+	CHECK(all.battles == 1);
+	CHECK(all.kills == 3);
+	CHECK(all.honorPoints == 5);
+	CHECK(all.gameName.empty());
+	CHECK(all.chatColorID == 0);
+}
+
+TEST_CASE("UserCache - copies selected extended character and user data fields")
+{
+	CUserCharacterExtended src = {};
+	src.banSettings = 2;
+	src.curLoadout = 1;
+	src._2ndPassword = { 1, 2 };
+
+	CUserCharacterExtended dest = {};
+	CopyCharacterExtended(dest, src, EXT_UFLAG_BANSETTINGS | EXT_UFLAG_2NDPASSWORD);
+	CHECK(dest.banSettings == 2);
+	CHECK(dest.curLoadout == 0);
+	CHECK(dest._2ndPassword == src._2ndPassword);
+
+	CUserData srcData = {};
+	srcData.userName = "user";
+	srcData.password = "secret";
+	CUserData destData = {};
+	CopyUserData(destData, srcData, USER_CACHE_DATA_FLAGS);
+	CHECK(destData.userName == "user");
+	CHECK(destData.password.empty()); // password is not cached
+}
+
+static CUserCharacter Update(int lowFlag, int highFlag = 0, int statFlag = 0, int achievementFlag = 0)
+{
+	CUserCharacter character = {};
+	character.lowFlag = lowFlag;
+	character.highFlag = highFlag;
+	character.statFlag = statFlag;
+	character.achievementFlag = achievementFlag;
+
+	return character;
+}
+
+TEST_CASE("UserCache - marks cached fields dirty")
+{
+	CUserCacheFlags flags;
+	CHECK(!flags.IsCharacterDirty());
+
+	// write-through and uncached fields are never dirty
+	flags.MarkCharacter(Update(UFLAG_LOW_GAMENAME | UFLAG_LOW_CLAN | UFLAG_LOW_RANK));
+	flags.MarkCharacterExtended(EXT_UFLAG_NEXTINVENTORYSLOT | EXT_UFLAG_2NDPASSWORD);
+	CHECK(!flags.IsCharacterDirty());
+	CHECK(flags.GetDirtyExtFlag() == 0);
+
+	// stat and achievement without sub fields are not dirty
+	flags.MarkCharacter(Update(UFLAG_LOW_STAT | UFLAG_LOW_ACHIEVEMENT));
+	CHECK(!flags.IsCharacterDirty());
+
+	flags.MarkCharacter(Update(UFLAG_LOW_POINTS | UFLAG_LOW_STAT, UFLAG_HIGH_CHATCOLOR, 0x1));
+	flags.MarkCharacter(Update(UFLAG_LOW_STAT | UFLAG_LOW_ACHIEVEMENT, 0, 0x4, 0x2));
+	flags.MarkCharacterExtended(EXT_UFLAG_BANSETTINGS);
+	CHECK(flags.IsCharacterDirty());
+
+	CUserCharacter dirty = {};
+	flags.GetDirtyCharacter(dirty);
+	CHECK(dirty.lowFlag == (UFLAG_LOW_POINTS | UFLAG_LOW_STAT | UFLAG_LOW_ACHIEVEMENT));
+	CHECK(dirty.highFlag == UFLAG_HIGH_CHATCOLOR);
+	CHECK(dirty.statFlag == (0x1 | 0x4));
+	CHECK(dirty.achievementFlag == 0x2);
+	CHECK(flags.GetDirtyExtFlag() == EXT_UFLAG_BANSETTINGS);
+}
+
+TEST_CASE("UserCache - committed flush clears dirty fields")
+{
+	CUserCacheFlags flags;
+	flags.MarkCharacter(Update(UFLAG_LOW_EXP));
+	flags.MarkCharacterExtended(EXT_UFLAG_CONFIG);
+
+	flags.OnCharacterWritten();
+	flags.OnCharacterExtendedWritten();
+	CHECK(!flags.IsCharacterDirty());
+	CHECK(flags.GetDirtyExtFlag() == 0);
+
+	flags.OnFlushed(true);
+	CHECK(!flags.IsCharacterDirty());
+	CHECK(flags.GetDirtyExtFlag() == 0);
+
+	// nothing is flushed anymore, a failed next transaction doesn't bring the fields back
+	flags.OnFlushed(false);
+	CHECK(!flags.IsCharacterDirty());
+}
+
+TEST_CASE("UserCache - failed flush marks written fields dirty again")
+{
+	CUserCacheFlags flags;
+	flags.MarkCharacter(Update(UFLAG_LOW_EXP | UFLAG_LOW_STAT, 0, 0x2));
+	flags.MarkCharacterExtended(EXT_UFLAG_CONFIG);
+	flags.OnCharacterWritten();
+	flags.OnCharacterExtendedWritten();
+
+	// updated while the transaction is open
+	flags.MarkCharacter(Update(UFLAG_LOW_CASH));
+
+	flags.OnFlushed(false);
+
+	CUserCharacter dirty = {};
+	flags.GetDirtyCharacter(dirty);
+	CHECK(dirty.lowFlag == (UFLAG_LOW_EXP | UFLAG_LOW_STAT | UFLAG_LOW_CASH));
+	CHECK(dirty.statFlag == 0x2);
+	CHECK(flags.GetDirtyExtFlag() == EXT_UFLAG_CONFIG);
+
+	// extended fields not written, only character fields are flushed
+	flags.OnCharacterWritten();
+	flags.OnFlushed(false);
+	flags.GetDirtyCharacter(dirty);
+	CHECK(dirty.lowFlag == (UFLAG_LOW_EXP | UFLAG_LOW_STAT | UFLAG_LOW_CASH));
+	CHECK(flags.GetDirtyExtFlag() == EXT_UFLAG_CONFIG);
+}
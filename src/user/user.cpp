@@ -6,6 +6,8 @@
 
 using namespace std;
 
+UserCacheStats_s g_UserCacheStats;
+
 CUser::CUser(IExtendedSocket* sock, int userID, const std::string& userName)
 {
 	m_pCurrentRoom = NULL;
@@ -27,10 +29,18 @@ CUser::CUser(IExtendedSocket* sock, int userID, const std::string& userName)
 	m_NetworkData.m_nLocalServerPort = 27015;
 
 	m_nUptime = 0;
+
+	m_bCharacterCached = false;
+	m_bUserDataCached = false;
 }
 
 CUser::~CUser()
 {
+	g_UserDatabase.CreateTransaction();
+	FlushCache();
+	OnCacheFlushed(g_UserDatabase.CommitTransaction());
+
+	g_UserDatabase.UnloadInventory(m_nID);
 	g_UserDatabase.DropSession(m_nID);
 
 	if (m_pCurrentRoom)
@@ -132,7 +142,28 @@ CUserData CUser::GetUser(int flag)
 {
 	CUserData data = {};
 	data.flag = flag;
-	g_UserDatabase.GetUserData(m_nID, data);
+
+	if (!m_bUserDataCached)
+	{
+		CUserData cached = {};
+		cached.flag = USER_CACHE_DATA_FLAGS;
+		if (g_UserDatabase.GetUserData(m_nID, cached) > 0)
+		{
+			m_UserData = cached;
+			m_bUserDataCached = true;
+		}
+	}
+
+	if (!m_bUserDataCached || (flag & ~USER_CACHE_DATA_FLAGS))
+	{
+		g_UserCacheStats.misses++;
+		g_UserDatabase.GetUserData(m_nID, data);
+	}
+	else
+	{
+		g_UserCacheStats.hits++;
+		CopyUserData(data, m_UserData, flag);
+	}
 
 	return data;
 }
@@ -143,10 +174,42 @@ CUserCharacter CUser::GetCharacter(int lowFlag, int highFlag)
 	character.lowFlag = lowFlag;
 	character.highFlag = highFlag;
 
-	if (g_UserDatabase.GetCharacter(m_nID, character) <= 0)
+	if (!LoadCache())
+	{
+		g_UserCacheStats.misses++;
+
+		if (g_UserDatabase.GetCharacter(m_nID, character) <= 0)
+		{
+			character.lowFlag = 0;
+			character.highFlag = 0;
+		}
+
+		return character;
+	}
+
+	CopyCharacter(character, m_Character, lowFlag & USER_CACHE_LOW_FLAGS, highFlag & USER_CACHE_HIGH_FLAGS);
+
+	// read the rest from the database
+	CUserCharacter uncached = {};
+	uncached.lowFlag = lowFlag & ~USER_CACHE_LOW_FLAGS;
+	uncached.highFlag = highFlag & ~USER_CACHE_HIGH_FLAGS;
+	if (uncached.lowFlag & (UFLAG_LOW_CLAN | UFLAG_LOW_RANK))
+	{
+		g_UserCacheStats.misses++;
+
+		if (g_UserDatabase.GetCharacter(m_nID, uncached) <= 0)
+		{
+			character.lowFlag = 0;
+			character.highFlag = 0;
+
+			return character;
+		}
+
+		CopyCharacter(character, uncached, uncached.lowFlag, uncached.highFlag);
+	}
+	else
 	{
-		character.lowFlag = 0;
-		character.highFlag = 0;
+		g_UserCacheStats.hits++;
 	}
 
 	return character;
@@ -157,12 +220,111 @@ CUserCharacterExtended CUser::GetCharacterExtended(int flag)
 	CUserCharacterExtended character = {};
 	character.flag = flag;
 
-	if (g_UserDatabase.GetCharacterExtended(m_nID, character) <= 0)
-		character.flag = 0;
+	if (!LoadCache() || (flag & ~USER_CACHE_EXT_FLAGS))
+	{
+		g_UserCacheStats.misses++;
+
+		if (g_UserDatabase.GetCharacterExtended(m_nID, character) <= 0)
+			character.flag = 0;
+
+		if (m_bCharacterCached)
+			CopyCharacterExtended(character, m_CharacterExtended, flag & m_CacheFlags.GetDirtyExtFlag());
+
+		return character;
+	}
+
+	g_UserCacheStats.hits++;
+	CopyCharacterExtended(character, m_CharacterExtended, flag);
 
 	return character;
 }
 
+vector<string> CUser::GetBanList()
+{
+	if (!LoadCache())
+	{
+		vector<string> banList;
+		g_UserDatabase.GetBanList(m_nID, banList);
+
+		return banList;
+	}
+
+	return m_BanList.Get();
+}
+
+/**
+ * Checks if the user blocks other user, called for every recipient of chat messages so it must not query the database
+ * @param gameName Game name of the other user
+ * @param setting BANSETTINGS_* feature to check
+ */
+bool CUser::IsBlocking(const string& gameName, int setting)
+{
+	if (!LoadCache())
+	{
+		CUserCharacterExtended characterExt = GetCharacterExtended(EXT_UFLAG_BANSETTINGS);
+		if (!(characterExt.banSettings & setting))
+			return false;
+
+		vector<string> banList = GetBanList();
+
+		return find(banList.begin(), banList.end(), gameName) != banList.end();
+	}
+
+	return m_BanList.IsBlocking(m_CharacterExtended.banSettings, setting, gameName);
+}
+
+/**
+ * Updates user data in the database and in the cache
+ */
+void CUser::UpdateUser(CUserData& data)
+{
+	g_UserDatabase.UpdateUserData(m_nID, data);
+
+	if (m_bUserDataCached)
+		CopyUserData(m_UserData, data, data.flag & USER_CACHE_DATA_FLAGS);
+}
+
+/**
+ * Updates character fields, cached fields are written to the database on the next flush
+ * @return 0 on database error, 1 on success
+ */
+int CUser::UpdateCharacter(CUserCharacter& character)
+{
+	if (!LoadCache())
+		return g_UserDatabase.UpdateCharacter(m_nID, character);
+
+	CUserCharacter writeThrough = character;
+	writeThrough.lowFlag = character.lowFlag & USER_CACHE_WRITETHROUGH_LOW_FLAGS;
+	writeThrough.highFlag = 0;
+	if (writeThrough.lowFlag && g_UserDatabase.UpdateCharacter(m_nID, writeThrough) <= 0)
+		return 0;
+
+	CopyCharacter(m_Character, character, character.lowFlag & USER_CACHE_LOW_FLAGS, character.highFlag & USER_CACHE_HIGH_FLAGS, character.statFlag, character.achievementFlag);
+	m_CacheFlags.MarkCharacter(character);
+
+	return 1;
+}
+
+/**
+ * Updates extended character fields, cached fields are written to the database on the next flush
+ * @return 0 on database error, 1 on success
+ */
+int CUser::UpdateCharacterExtended(CUserCharacterExtended& character)
+{
+	if (!LoadCache())
+		return g_UserDatabase.UpdateCharacterExtended(m_nID, character);
+
+	CUserCharacterExtended writeThrough = character;
+	writeThrough.flag = character.flag & USER_CACHE_WRITETHROUGH_EXT_FLAGS;
+	if (writeThrough.flag && g_UserDatabase.UpdateCharacterExtended(m_nID, writeThrough) <= 0)
+		return 0;
+
+	CopyCharacterExtended(m_CharacterExtended, character, character.flag & USER_CACHE_EXT_FLAGS);
+	m_CacheFlags.MarkCharacterExtended(character.flag);
+
+	return 1;
+}
+
 int CUser::UpdateHolepunch(int portId, const string& localIpAddress, int localPort, int externalPort)
 {
 	switch (portId)
@@ -199,7 +361,7 @@ void CUser::UpdateGameName(const string& gameName)
 	character.gameName = gameName;
 	character.lowFlag = UFLAG_LOW_GAMENAME | UFLAG_LOW_GAMENAME2;
 
-	g_UserDatabase.UpdateCharacter(m_nID, character);
+	UpdateCharacter(character);
 
 	UpdateClientUserInfo(character);
 }
@@ -209,7 +371,7 @@ int CUser::UpdatePoints(int64_t points)
 	CUserCharacter character = GetCharacter(UFLAG_LOW_POINTS);
 	character.points += points;
 
-	if (g_UserDatabase.UpdateCharacter(m_nID, character) <= 0)
+	if (UpdateCharacter(character) <= 0)
 	{
 		return 0;
 	}
@@ -224,7 +386,7 @@ void CUser::UpdateCash(int64_t cash)
 	CUserCharacter character = GetCharacter(UFLAG_LOW_CASH | UFLAG_LOW_CASH2);
 	character.cash += cash;
 
-	g_UserDatabase.UpdateCharacter(m_nID, character);
+	UpdateCharacter(character);
 
 	UpdateClientUserInfo(character);
 }
@@ -235,7 +397,7 @@ void CUser::UpdateHonorPoints(int honorPoints)
 	character.honorPoints += honorPoints;
 	character.achievementFlag = 1;
 
-	g_UserDatabase.UpdateCharacter(m_nID, character);
+	UpdateCharacter(character);
 
 	UpdateClientUserInfo(character);
 }
@@ -246,7 +408,7 @@ void CUser::UpdatePrefix(int prefixID)
 	character.prefixId = prefixID;
 	character.achievementFlag = 2;
 
-	g_UserDatabase.UpdateCharacter(m_nID, character);
+	UpdateCharacter(character);
 
 	UpdateClientUserInfo(character);
 }
@@ -260,7 +422,7 @@ void CUser::UpdateStat(int battles, int win, int kills, int deaths)
 	character.deaths += deaths;
 	character.statFlag |= 0x1 | 0x2 | 0x4 | 0x8;
 
-	g_UserDatabase.UpdateCharacter(m_nID, character);
+	UpdateCharacter(character);
 
 	UpdateClientUserInfo(character);
 }
@@ -273,7 +435,7 @@ void CUser::UpdateLocation(int nation, int city, int town)
 	character.city = city;
 	character.town = town;
 
-	g_UserDatabase.UpdateCharacter(m_nID, character);
+	UpdateCharacter(character);
 
 	UpdateClientUserInfo(character);
 }
@@ -283,7 +445,7 @@ void CUser::UpdateRank(int leagueID)
 	CUserCharacter character = GetCharacter(UFLAG_LOW_RANK);
 	character.leagueID = leagueID;
 
-	g_UserDatabase.UpdateCharacter(m_nID, character);
+	UpdateCharacter(character);
 
 	UpdateClientUserInfo(character);
 }
@@ -311,7 +473,7 @@ void CUser::UpdateExp(int64_t exp)
 		character.level = newLvl;
 	}
 
-	g_UserDatabase.UpdateCharacter(m_nID, character);
+	UpdateCharacter(character);
 
 	// update userinfo on client side
 	UpdateClientUserInfo(character);
@@ -325,7 +487,7 @@ int CUser::UpdatePasswordBoxes(int passwordBoxes)
 
 	character.passwordBoxes += passwordBoxes;
 
-	if (g_UserDatabase.UpdateCharacter(m_nID, character) <= 0)
+	if (UpdateCharacter(character) <= 0)
 		return 0;
 
 	UpdateClientUserInfo(character);
@@ -338,7 +500,7 @@ void CUser::UpdateTitles(int slot, int titleID)
 	CUserCharacter character = GetCharacter(UFLAG_LOW_TITLES);
 	character.titles[slot] = titleID;
 
-	g_UserDatabase.UpdateCharacter(m_nID, character);
+	UpdateCharacter(character);
 
 	UpdateClientUserInfo(character);
 }
@@ -348,7 +510,7 @@ void CUser::UpdateAchievementList(int titleID)
 	CUserCharacter character = GetCharacter(UFLAG_LOW_ACHIEVEMENTLIST);
 	character.achievementList.push_back(titleID);
 
-	g_UserDatabase.UpdateCharacter(m_nID, character);
+	UpdateCharacter(character);
 
 	UpdateClientUserInfo(character);
 }
@@ -359,7 +521,7 @@ void CUser::UpdateClan(int clanID)
 	character.lowFlag = UFLAG_LOW_CLAN;
 	character.clanID = clanID;
 
-	g_UserDatabase.UpdateCharacter(m_nID, character);
+	UpdateCharacter(character);
 	g_UserDatabase.GetCharacter(m_nID, character); // get clan mark, name
 
 	UpdateClientUserInfo(character);
@@ -371,7 +533,7 @@ void CUser::UpdateTournament(int tournament)
 	character.lowFlag = UFLAG_LOW_TOURNAMENT;
 	character.tournament = tournament;
 
-	g_UserDatabase.UpdateCharacter(m_nID, character);
+	UpdateCharacter(character);
 
 	UpdateClientUserInfo(character);
 }
@@ -379,6 +541,13 @@ void CUser::UpdateTournament(int tournament)
 int CUser::UpdateBanList(const string& gameName, bool remove)
 {
 	int result = g_UserDatabase.UpdateBanList(m_nID, gameName, remove);
+	if (result == 1 && m_bCharacterCached)
+	{
+		if (remove)
+			m_BanList.Remove(gameName);
+		else
+			m_BanList.Add(gameName);
+	}
 
 	// TODO: update channel user info
 
@@ -391,7 +560,7 @@ void CUser::UpdateBanSettings(int settings)
 	characterExt.flag = EXT_UFLAG_BANSETTINGS;
 	characterExt.banSettings = settings;
 
-	g_UserDatabase.UpdateCharacterExtended(m_nID, characterExt);
+	UpdateCharacterExtended(characterExt);
 }
 
 void CUser::UpdateNameplate(int nameplateID)
@@ -400,7 +569,7 @@ void CUser::UpdateNameplate(int nameplateID)
 	character.lowFlag = UFLAG_LOW_NAMEPLATE;
 	character.nameplateID = nameplateID;
 
-	g_UserDatabase.UpdateCharacter(m_nID, character);
+	UpdateCharacter(character);
 
 	UpdateClientUserInfo(character);
 }
@@ -411,7 +580,7 @@ void CUser::UpdateZbRespawnEffect(int zbRespawnEffect)
 	characterExt.flag = EXT_UFLAG_ZBRESPAWNEFFECT;
 	characterExt.zbRespawnEffect = zbRespawnEffect;
 
-	g_UserDatabase.UpdateCharacterExtended(m_nID, characterExt);
+	UpdateCharacterExtended(characterExt);
 }
 
 void CUser::UpdateKillerMarkEffect(int killerMarkEffect)
@@ -420,7 +589,7 @@ void CUser::UpdateKillerMarkEffect(int killerMarkEffect)
 	characterExt.flag = EXT_UFLAG_KILLERMARKEFFECT;
 	characterExt.killerMarkEffect = killerMarkEffect;
 
-	g_UserDatabase.UpdateCharacterExtended(m_nID, characterExt);
+	UpdateCharacterExtended(characterExt);
 }
 
 void CUser::UpdateChatColor(int chatColorID)
@@ -429,7 +598,7 @@ void CUser::UpdateChatColor(int chatColorID)
 	character.highFlag = UFLAG_HIGH_CHATCOLOR;
 	character.chatColorID = chatColorID;
 
-	g_UserDatabase.UpdateCharacter(m_nID, character);
+	UpdateCharacter(character);
 
 	UpdateClientUserInfo(character);
 }
@@ -494,6 +663,9 @@ void CUser::OnTick()
 
 bool CUser::IsCharacterExists()
 {
+	if (m_bCharacterCached)
+		return true;
+
 	CUserCharacter character = {};
 	character.lowFlag = UFLAG_LOW_GAMENAME;
 
@@ -513,4 +685,143 @@ bool CUser::CreateCharacter(const string& gameName)
 	g_QuestManager.OnLevelUpEvent(this, 1, 1);
 
 	return true;
-}
\ No newline at end of file
+}
+/**
+ * Loads character data and inventory to the cache if it's not loaded yet
+ * @return false if character doesn't exist yet or database error occured
+ */
+bool CUser::LoadCache()
+{
+	if (m_bCharacterCached)
+		return true;
+
+	UserCache_s cache;
+	if (!ReadCache(m_nID, cache))
+		return false;
+
+	ApplyCache(cache);
+
+	return true;
+}
+
+/**
+ * Checks if character data and inventory are in memory, so accessing them doesn't query the database
+ */
+bool CUser::IsCacheLoaded()
+{
+	return m_bCharacterCached;
+}
+
+/**
+ * Fills the cache with rows read by ReadCache and passes the inventory rows to the user database.
+ * Does nothing if the cache was loaded in the meantime, it's newer than the rows
+ * @param cache
+ */
+void CUser::ApplyCache(const UserCache_s& cache)
+{
+	if (m_bCharacterCached)
+		return;
+
+	m_Character = cache.character;
+	m_CharacterExtended = cache.characterExt;
+	m_BanList.Load(cache.banList);
+	m_bCharacterCached = true;
+
+	if (cache.inventoryRead)
+		g_UserDatabase.CacheInventory(m_nID, cache.inventory, cache.nextInventorySlot, cache.inventoryVersion);
+}
+
+/**
+ * Reads cached character data and inventory of the user.
+ * Uses only the database, so it may be called from the database thread
+ * @param userID
+ * @param cache Receives the rows
+ * @return false if character doesn't exist yet or database error occured
+ */
+bool CUser::ReadCache(int userID, UserCache_s& cache)
+{
+	cache.character = {};
+	cache.character.lowFlag = USER_CACHE_LOW_FLAGS;
+	cache.character.highFlag = USER_CACHE_HIGH_FLAGS;
+	if (g_UserDatabase.GetCharacter(userID, cache.character) <= 0)
+		return false;
+
+	cache.characterExt = CUserCharacterExtended(USER_CACHE_EXT_FLAGS);
+	if (g_UserDatabase.GetCharacterExtended(userID, cache.characterExt) <= 0)
+		return false;
+
+	if (!g_UserDatabase.GetBanList(userID, cache.banList))
+		return false;
+
+	if (!g_UserDatabase.ReadInventory(userID, cache.inventory, cache.nextInventorySlot, cache.inventoryVersion))
+		return false;
+
+	cache.inventoryRead = true;
+
+	return true;
+}
+
+/**
+ * Writes dirty character fields and inventory rows to the database. Called inside transaction, OnCacheFlushed must be called after commit
+ * @return Number of updated rows
+ */
+int CUser::FlushCache()
+{
+	int rows = 0;
+
+	if (m_CacheFlags.IsCharacterDirty())
+	{
+		CUserCharacter character = m_Character;
+		m_CacheFlags.GetDirtyCharacter(character);
+
+		if (g_UserDatabase.UpdateCharacter(m_nID, character) > 0)
+		{
+			m_CacheFlags.OnCharacterWritten();
+			rows++;
+		}
+	}
+
+	if (m_CacheFlags.GetDirtyExtFlag())
+	{
+		CUserCharacterExtended characterExt = m_CharacterExtended;
+		characterExt.flag = m_CacheFlags.GetDirtyExtFlag();
+
+		if (g_UserDatabase.UpdateCharacterExtended(m_nID, characterExt) > 0)
+		{
+			m_CacheFlags.OnCharacterExtendedWritten();
+			rows++;
+		}
+	}
+
+	int inventoryRows = g_UserDatabase.FlushInventory(m_nID);
+	if (inventoryRows > 0)
+		rows += inventoryRows;
+
+	g_UserCacheStats.rowsWritten += rows;
+
+	return rows;
+}
+
+/**
+ * Called after the flush transaction is finished
+ * @param committed false if transaction failed and flushed fields must be written again
+ */
+void CUser::OnCacheFlushed(bool committed)
+{
+	m_CacheFlags.OnFlushed(committed);
+
+	g_UserDatabase.OnInventoryFlushed(m_nID, committed);
+}
+
+/**
+ * Writes dirty fields and drops the cache, so the next access reloads it from the database.
+ * Must be called after changing character of online user directly in the database
+ */
+void CUser::InvalidateCache()
+{
+	FlushCache();
+	OnCacheFlushed(true);
+
+	m_bCharacterCached = false;
+	m_bUserDataCached = false;
+}
@@ -5,6 +5,18 @@
 #include "net/extendedsocket.h"
 #include "channel/channel.h"
 #include "definitions.h"
+#include "usercache.h"
+#include "common/banlist.h"
+
+struct UserCacheStats_s
+{
+	unsigned long long hits;
+	unsigned long long misses;
+	unsigned long long flushes;
+	unsigned long long rowsWritten;
+};
+
+extern UserCacheStats_s g_UserCacheStats;
 
 class CUser : public IUser
 {
@@ -33,6 +45,12 @@ public:
 	CUserData GetUser(int flag);
 	CUserCharacter GetCharacter(int lowFlag, int highFlag = 0);
 	CUserCharacterExtended GetCharacterExtended(int flag);
+	std::vector<std::string> GetBanList();
+	bool IsBlocking(const std::string& gameName, int setting);
+
+	void UpdateUser(CUserData& data);
+	int UpdateCharacter(CUserCharacter& character);
+	int UpdateCharacterExtended(CUserCharacterExtended& character);
 
 	int UpdateHolepunch(int portId, const std::string& localIpAddress, int localPort, int externalPort);
 	void UpdateClientUserInfo(CUserCharacter character);
@@ -65,6 +83,14 @@ public:
 	bool IsCharacterExists();
 	bool CreateCharacter(const std::string& gameName);
 
+	bool LoadCache();
+	bool IsCacheLoaded();
+	void ApplyCache(const UserCache_s& cache);
+	static bool ReadCache(int userID, UserCache_s& cache);
+	int FlushCache();
+	void OnCacheFlushed(bool committed);
+	void InvalidateCache();
+
 private:
 	IExtendedSocket* m_pSocket;
 
@@ -80,4 +106,13 @@ private:
 	int m_nUptime;
 	int m_nID;
 	std::string m_UserName;
+
+	// character cache, dirty fields are written to the database by CUserManager every minute and on logout
+	bool m_bCharacterCached;
+	bool m_bUserDataCached;
+	CUserData m_UserData;
+	CUserCharacter m_Character;
+	CUserCharacterExtended m_CharacterExtended;
+	CBanList m_BanList; // written through, loaded with the cache
+	CUserCacheFlags m_CacheFlags;
 };
\ No newline at end of file
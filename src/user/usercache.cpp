@@ -0,0 +1,214 @@
+#include "usercache.h"
+
+using namespace std;
+
+/**
+ * Copies character fields selected by flags
+ */
+void CopyCharacter(CUserCharacter& dest, const CUserCharacter& src, int lowFlag, int highFlag, int statFlag, int achievementFlag)
+{
+	if (lowFlag & UFLAG_LOW_NAMEPLATE)
+		dest.nameplateID = src.nameplateID;
+	if (lowFlag & UFLAG_LOW_GAMENAME)
+		dest.gameName = src.gameName;
+	if (lowFlag & UFLAG_LOW_LEVEL)
+		dest.level = src.level;
+	if (lowFlag & UFLAG_LOW_EXP)
+		dest.exp = src.exp;
+	if (lowFlag & UFLAG_LOW_CASH)
+		dest.cash = src.cash;
+	if (lowFlag & UFLAG_LOW_POINTS)
+		dest.points = src.points;
+	if (lowFlag & UFLAG_LOW_STAT)
+	{
+		if (statFlag & 0x1)
+			dest.battles = src.battles;
+		if (statFlag & 0x2)
+			dest.win = src.win;
+		if (statFlag & 0x4)
+			dest.kills = src.kills;
+		if (statFlag & 0x8)
+			dest.deaths = src.deaths;
+	}
+	if (lowFlag & UFLAG_LOW_LOCATION)
+	{
+		dest.nation = src.nation;
+		dest.city = src.city;
+		dest.town = src.town;
+	}
+	if (lowFlag & UFLAG_LOW_RANK)
+	{
+		dest.leagueID = src.leagueID;
+		for (int i = 0; i < 4; i++)
+			dest.tier[i] = src.tier[i];
+	}
+	if (lowFlag & UFLAG_LOW_PASSWORDBOXES)
+		dest.passwordBoxes = src.passwordBoxes;
+	if (lowFlag & UFLAG_LOW_ACHIEVEMENT)
+	{
+		if (achievementFlag & 0x1)
+			dest.honorPoints = src.honorPoints;
+		if (achievementFlag & 0x2)
+			dest.prefixId = src.prefixId;
+	}
+	if (lowFlag & UFLAG_LOW_ACHIEVEMENTLIST)
+		dest.achievementList = src.achievementList;
+	if (lowFlag & UFLAG_LOW_TITLES)
+		dest.titles = src.titles;
+	if (lowFlag & UFLAG_LOW_CLAN)
+	{
+		dest.clanID = src.clanID;
+		dest.clanMarkID = src.clanMarkID;
+		dest.clanName = src.clanName;
+	}
+	if (lowFlag & UFLAG_LOW_TOURNAMENT)
+		dest.tournament = src.tournament;
+	if (lowFlag & UFLAG_LOW_UNK26)
+		dest.mileagePoints = src.mileagePoints;
+	if (highFlag & UFLAG_HIGH_CHATCOLOR)
+		dest.chatColorID = src.chatColorID;
+}
+
+/**
+ * Copies extended character fields selected by flag
+ */
+void CopyCharacterExtended(CUserCharacterExtended& dest, const CUserCharacterExtended& src, int flag)
+{
+	if (flag & EXT_UFLAG_GAMEMASTER)
+		dest.gameMaster = src.gameMaster;
+	if (flag & EXT_UFLAG_KILLSTOGETGACHAPONITEM)
+		dest.killsToGetGachaponItem = src.killsToGetGachaponItem;
+	if (flag & EXT_UFLAG_NEXTINVENTORYSLOT)
+		dest.nextInventorySlot = src.nextInventorySlot;
+	if (flag & EXT_UFLAG_CONFIG)
+		dest.config = src.config;
+	if (flag & EXT_UFLAG_CURLOADOUT)
+		dest.curLoadout = src.curLoadout;
+	if (flag & EXT_UFLAG_CHARACTERID)
+		dest.characterID = src.characterID;
+	if (flag & EXT_UFLAG_BANSETTINGS)
+		dest.banSettings = src.banSettings;
+	if (flag & EXT_UFLAG_2NDPASSWORD)
+		dest._2ndPassword = src._2ndPassword;
+	if (flag & EXT_UFLAG_SECURITYQNA)
+	{
+		dest.securityQuestion = src.securityQuestion;
+		dest.securityAnswer = src.securityAnswer;
+	}
+	if (flag & EXT_UFLAG_ZBRESPAWNEFFECT)
+		dest.zbRespawnEffect = src.zbRespawnEffect;
+	if (flag & EXT_UFLAG_KILLERMARKEFFECT)
+		dest.killerMarkEffect = src.killerMarkEffect;
+}
+
+/**
+ * Copies user data fields selected by flag
+ */
+void CopyUserData(CUserData& dest, const CUserData& src, int flag)
+{
+	if (flag & UDATA_FLAG_USERNAME)
+		dest.userName = src.userName;
+	if (flag & UDATA_FLAG_PASSWORD)
+		dest.password = src.password;
+	if (flag & UDATA_FLAG_REGISTERTIME)
+		dest.registerTime = src.registerTime;
+	if (flag & UDATA_FLAG_REGISTERIP)
+		dest.registerIP = src.registerIP;
+	if (flag & UDATA_FLAG_FIRSTLOGONTIME)
+		dest.firstLogonTime = src.firstLogonTime;
+	if (flag & UDATA_FLAG_LASTLOGONTIME)
+		dest.lastLogonTime = src.lastLogonTime;
+	if (flag & UDATA_FLAG_LASTIP)
+		dest.lastIP = src.lastIP;
+	if (flag & UDATA_FLAG_LASTHWID)
+		dest.lastHWID = src.lastHWID;
+}
+
+CUserCacheFlags::CUserCacheFlags()
+{
+	m_nDirtyLowFlag = m_nDirtyHighFlag = m_nDirtyStatFlag = m_nDirtyAchievementFlag = m_nDirtyExtFlag = 0;
+	m_nFlushedLowFlag = m_nFlushedHighFlag = m_nFlushedStatFlag = m_nFlushedAchievementFlag = m_nFlushedExtFlag = 0;
+}
+
+/**
+ * Marks cached character fields of the update as dirty. Write-through fields are written by the caller and never dirty,
+ * stat and achievement fields are dirty only if one of their sub fields is updated
+ */
+void CUserCacheFlags::MarkCharacter(const CUserCharacter& character)
+{
+	int lowFlag = character.lowFlag & USER_CACHE_LOW_FLAGS & ~USER_CACHE_WRITETHROUGH_LOW_FLAGS;
+	int highFlag = character.highFlag & USER_CACHE_HIGH_FLAGS;
+	if (!(character.statFlag & 0xF))
+		lowFlag &= ~UFLAG_LOW_STAT;
+	if (!(character.achievementFlag & 0x3))
+		lowFlag &= ~UFLAG_LOW_ACHIEVEMENT;
+
+	m_nDirtyLowFlag |= lowFlag;
+	m_nDirtyHighFlag |= highFlag;
+	if (lowFlag & UFLAG_LOW_STAT)
+		m_nDirtyStatFlag |= character.statFlag & 0xF;
+	if (lowFlag & UFLAG_LOW_ACHIEVEMENT)
+		m_nDirtyAchievementFlag |= character.achievementFlag & 0x3;
+}
+
+void CUserCacheFlags::MarkCharacterExtended(int flag)
+{
+	m_nDirtyExtFlag |= flag & USER_CACHE_EXT_FLAGS & ~USER_CACHE_WRITETHROUGH_EXT_FLAGS;
+}
+
+bool CUserCacheFlags::IsCharacterDirty() const
+{
+	return m_nDirtyLowFlag || m_nDirtyHighFlag;
+}
+
+/**
+ * Sets flags of the character to its dirty fields
+ */
+void CUserCacheFlags::GetDirtyCharacter(CUserCharacter& character) const
+{
+	character.lowFlag = m_nDirtyLowFlag;
+	character.highFlag = m_nDirtyHighFlag;
+	character.statFlag = m_nDirtyStatFlag;
+	character.achievementFlag = m_nDirtyAchievementFlag;
+}
+
+int CUserCacheFlags::GetDirtyExtFlag() const
+{
+	return m_nDirtyExtFlag;
+}
+
+/**
+ * Called after dirty character fields were written in the flush transaction
+ */
+void CUserCacheFlags::OnCharacterWritten()
+{
+	m_nFlushedLowFlag |= m_nDirtyLowFlag;
+	m_nFlushedHighFlag |= m_nDirtyHighFlag;
+	m_nFlushedStatFlag |= m_nDirtyStatFlag;
+	m_nFlushedAchievementFlag |= m_nDirtyAchievementFlag;
+	m_nDirtyLowFlag = m_nDirtyHighFlag = m_nDirtyStatFlag = m_nDirtyAchievementFlag = 0;
+}
+
+void CUserCacheFlags::OnCharacterExtendedWritten()
+{
+	m_nFlushedExtFlag |= m_nDirtyExtFlag;
+	m_nDirtyExtFlag = 0;
+}
+
+/**
+ * Called after the flush transaction is finished
+ * @param committed false if transaction failed and flushed fields must be written again
+ */
+void CUserCacheFlags::OnFlushed(bool committed)
+{
+	if (!committed)
+	{
+		m_nDirtyLowFlag |= m_nFlushedLowFlag;
+		m_nDirtyHighFlag |= m_nFlushedHighFlag;
+		m_nDirtyStatFlag |= m_nFlushedStatFlag;
+		m_nDirtyAchievementFlag |= m_nFlushedAchievementFlag;
+		m_nDirtyExtFlag |= m_nFlushedExtFlag;
+	}
+
+	m_nFlushedLowFlag = m_nFlushedHighFlag = m_nFlushedStatFlag = m_nFlushedAchievementFlag = m_nFlushedExtFlag = 0;
+}
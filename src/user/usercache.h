@@ -0,0 +1,71 @@
+#pragma once
+
+#include "definitions.h"
+#include "user/userinventoryitem.h"
+
+// character fields kept in memory while the user is online
+#define USER_CACHE_LOW_FLAGS (UFLAG_LOW_NAMEPLATE | UFLAG_LOW_GAMENAME | UFLAG_LOW_LEVEL | UFLAG_LOW_EXP | UFLAG_LOW_CASH | UFLAG_LOW_POINTS | UFLAG_LOW_STAT | UFLAG_LOW_LOCATION | \
+	UFLAG_LOW_TOURNAMENT | UFLAG_LOW_PASSWORDBOXES | UFLAG_LOW_ACHIEVEMENT | UFLAG_LOW_ACHIEVEMENTLIST | UFLAG_LOW_TITLES | UFLAG_LOW_UNK26)
+#define USER_CACHE_HIGH_FLAGS UFLAG_HIGH_CHATCOLOR
+#define USER_CACHE_EXT_FLAGS (EXT_UFLAG_GAMEMASTER | EXT_UFLAG_KILLSTOGETGACHAPONITEM | EXT_UFLAG_CONFIG | EXT_UFLAG_CURLOADOUT | EXT_UFLAG_CHARACTERID | EXT_UFLAG_BANSETTINGS | \
+	EXT_UFLAG_ZBRESPAWNEFFECT | EXT_UFLAG_KILLERMARKEFFECT)
+#define USER_CACHE_DATA_FLAGS (UDATA_FLAG_USERNAME | UDATA_FLAG_REGISTERTIME | UDATA_FLAG_REGISTERIP | UDATA_FLAG_FIRSTLOGONTIME | UDATA_FLAG_LASTLOGONTIME | UDATA_FLAG_LASTIP | UDATA_FLAG_LASTHWID)
+
+// clan and rank are changed by other users' queries, game name is looked up by other queries, so these are written immediately
+#define USER_CACHE_WRITETHROUGH_LOW_FLAGS (UFLAG_LOW_GAMENAME | UFLAG_LOW_CLAN | UFLAG_LOW_RANK)
+#define USER_CACHE_WRITETHROUGH_EXT_FLAGS (EXT_UFLAG_NEXTINVENTORYSLOT | EXT_UFLAG_2NDPASSWORD | EXT_UFLAG_SECURITYQNA)
+
+/**
+ * Database rows of the user cache. Read by CUser::ReadCache on any thread, applied by the event thread
+ */
+struct UserCache_s
+{
+	CUserCharacter character;
+	CUserCharacterExtended characterExt;
+	std::vector<std::string> banList;
+
+	// inventory rows for the inventory cache of the user database, not read if inventoryRead is false
+	std::vector<CUserInventoryItem> inventory;
+	int nextInventorySlot;
+	unsigned int inventoryVersion;
+	bool inventoryRead = false;
+};
+
+void CopyCharacter(CUserCharacter& dest, const CUserCharacter& src, int lowFlag, int highFlag, int statFlag = 0xF, int achievementFlag = 0x3);
+void CopyCharacterExtended(CUserCharacterExtended& dest, const CUserCharacterExtended& src, int flag);
+void CopyUserData(CUserData& dest, const CUserData& src, int flag);
+
+/**
+ * Dirty and flushed fields of the user cache. Updated fields are dirty until they are written to the database, written fields
+ * stay flushed until the transaction is finished and become dirty again if it failed
+ */
+class CUserCacheFlags
+{
+public:
+	CUserCacheFlags();
+
+	void MarkCharacter(const CUserCharacter& character);
+	void MarkCharacterExtended(int flag);
+
+	bool IsCharacterDirty() const;
+	void GetDirtyCharacter(CUserCharacter& character) const;
+	int GetDirtyExtFlag() const;
+
+	void OnCharacterWritten();
+	void OnCharacterExtendedWritten();
+	void OnFlushed(bool committed);
+
+private:
+	int m_nDirtyLowFlag;
+	int m_nDirtyHighFlag;
+	int m_nDirtyStatFlag;
+	int m_nDirtyAchievementFlag;
+	int m_nDirtyExtFlag;
+
+	// fields written in the current transaction, marked dirty again if the commit fails
+	int m_nFlushedLowFlag;
+	int m_nFlushedHighFlag;
+	int m_nFlushedStatFlag;
+	int m_nFlushedAchievementFlag;
+	int m_nFlushedExtFlag;
+};
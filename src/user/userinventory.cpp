@@ -0,0 +1,277 @@
+#include "userinventory.h"
+
+using namespace std;
+
+CUserInventory::CUserInventory(const vector<CUserInventoryItem>& items, int nextSlot)
+{
+	m_nItemCount = 0;
+	m_nNextSlot = nextSlot;
+
+	for (auto& item : items)
+	{
+		if (item.m_nSlot >= m_nNextSlot)
+			m_nNextSlot = item.m_nSlot + 1;
+	}
+
+	// mark slots without rows
+	m_Items.resize(m_nNextSlot);
+	for (auto& item : m_Items)
+		item.m_nSlot = -1;
+
+	for (auto& item : items)
+	{
+		// the table has no primary key, use the first row if the slot is duplicated
+		if (item.m_nSlot < 0 || m_Items[item.m_nSlot].m_nSlot >= 0)
+			continue;
+
+		m_Items[item.m_nSlot] = item;
+		IndexItem(item);
+	}
+}
+
+/**
+ * Gets item by slot
+ * @return Pointer to the item, NULL if there is no such slot
+ */
+CUserInventoryItem* CUserInventory::GetItemBySlot(int slot)
+{
+	if (slot < 0 || slot >= (int)m_Items.size() || m_Items[slot].m_nSlot < 0)
+		return NULL;
+
+	return &m_Items[slot];
+}
+
+/**
+ * Gets item with the lowest slot by itemID
+ * @param itemID
+ * @param filter Additional condition, can be NULL
+ * @return Pointer to the item, NULL if there is no such item
+ */
+CUserInventoryItem* CUserInventory::GetFirstItem(int itemID, const function<bool(const CUserInventoryItem&)>& filter)
+{
+	const set<int>* slots;
+	if (itemID)
+	{
+		auto it = m_ItemSlots.find(itemID);
+		if (it == m_ItemSlots.end())
+			return NULL;
+
+		slots = &it->second;
+	}
+	else
+	{
+		slots = &m_FreeSlots;
+	}
+
+	for (int slot : *slots)
+	{
+		if (!filter || filter(m_Items[slot]))
+			return &m_Items[slot];
+	}
+
+	return NULL;
+}
+
+/**
+ * Gets all rows including empty slots, ordered by slot
+ */
+void CUserInventory::GetItems(vector<CUserInventoryItem>& items)
+{
+	items.reserve(items.size() + m_nItemCount + m_FreeSlots.size());
+
+	for (auto& item : m_Items)
+	{
+		if (item.m_nSlot >= 0)
+			items.push_back(item);
+	}
+}
+
+void CUserInventory::GetItemsByID(int itemID, vector<CUserInventoryItem>& items)
+{
+	const set<int>* slots;
+	if (itemID)
+	{
+		auto it = m_ItemSlots.find(itemID);
+		if (it == m_ItemSlots.end())
+			return;
+
+		slots = &it->second;
+	}
+	else
+	{
+		slots = &m_FreeSlots;
+	}
+
+	for (int slot : *slots)
+		items.push_back(m_Items[slot]);
+}
+
+/**
+ * Gets number of occupied slots
+ */
+int CUserInventory::GetItemCount()
+{
+	return m_nItemCount;
+}
+
+int CUserInventory::GetNextSlot()
+{
+	return m_nNextSlot;
+}
+
+/**
+ * Adds item to the first free slot or to a new slot
+ * @param item Item to add, m_nSlot is set to the taken slot
+ */
+void CUserInventory::AddItem(CUserInventoryItem& item)
+{
+	if (!m_FreeSlots.empty())
+	{
+		item.m_nSlot = *m_FreeSlots.begin();
+		m_UpdatedSlots.insert(item.m_nSlot);
+
+		UnindexItem(m_Items[item.m_nSlot]);
+	}
+	else
+	{
+		item.m_nSlot = m_nNextSlot++;
+		m_InsertedSlots.insert(item.m_nSlot);
+
+		m_Items.resize(m_nNextSlot);
+	}
+
+	m_Items[item.m_nSlot] = item;
+	IndexItem(item);
+}
+
+/**
+ * Updates fields of item in the slot of passed item
+ * @param item Item with new data
+ * @param flag Fields to update (UITEM_FLAG_*)
+ */
+void CUserInventory::UpdateItem(const CUserInventoryItem& item, int flag)
+{
+	CUserInventoryItem* dest = GetItemBySlot(item.m_nSlot);
+	if (!dest)
+		return;
+
+	UnindexItem(*dest);
+
+	if (flag & UITEM_FLAG_ITEMID)
+		dest->m_nItemID = item.m_nItemID;
+	if (flag & UITEM_FLAG_COUNT)
+		dest->m_nCount = item.m_nCount;
+	if (flag & UITEM_FLAG_STATUS)
+		dest->m_nStatus = item.m_nStatus;
+	if (flag & UITEM_FLAG_INUSE)
+		dest->m_nInUse = item.m_nInUse;
+	if (flag & UITEM_FLAG_OBTAINDATE)
+		dest->m_nObtainDate = item.m_nObtainDate;
+	if (flag & UITEM_FLAG_EXPIRYDATE)
+		dest->m_nExpiryDate = item.m_nExpiryDate;
+	if (flag & UITEM_FLAG_ISCLANITEM)
+		dest->m_nIsClanItem = item.m_nIsClanItem;
+	if (flag & UITEM_FLAG_ENHANCEMENTLEVEL)
+		dest->m_nEnhancementLevel = item.m_nEnhancementLevel;
+	if (flag & UITEM_FLAG_ENHANCEMENTEXP)
+		dest->m_nEnhancementExp = item.m_nEnhancementExp;
+	if (flag & UITEM_FLAG_ENHANCEVALUE)
+		dest->m_nEnhanceValue = item.m_nEnhanceValue;
+	if (flag & UITEM_FLAG_PAINTID)
+		dest->m_nPaintID = item.m_nPaintID;
+	if (flag & UITEM_FLAG_PAINTIDLIST)
+		dest->m_nPaintIDList = item.m_nPaintIDList;
+	if (flag & UITEM_FLAG_PARTSLOT1)
+		dest->m_nPartSlot1 = item.m_nPartSlot1;
+	if (flag & UITEM_FLAG_PARTSLOT2)
+		dest->m_nPartSlot2 = item.m_nPartSlot2;
+	if (flag & UITEM_FLAG_LOCKSTATUS)
+		dest->m_nLockStatus = item.m_nLockStatus;
+
+	IndexItem(*dest);
+
+	if (!m_InsertedSlots.count(dest->m_nSlot))
+		m_UpdatedSlots.insert(dest->m_nSlot);
+}
+
+bool CUserInventory::IsDirty()
+{
+	return !m_InsertedSlots.empty() || !m_UpdatedSlots.empty();
+}
+
+/**
+ * Gets rows to write to the database. Rows are remembered until OnFlushed is called
+ * @param insertedItems Rows that don't exist in the database yet
+ * @param updatedItems Changed rows
+ */
+void CUserInventory::GetChanges(vector<CUserInventoryItem>& insertedItems, vector<CUserInventoryItem>& updatedItems)
+{
+	for (int slot : m_InsertedSlots)
+		insertedItems.push_back(m_Items[slot]);
+
+	for (int slot : m_UpdatedSlots)
+		updatedItems.push_back(m_Items[slot]);
+
+	m_FlushedInsertedSlots.insert(m_InsertedSlots.begin(), m_InsertedSlots.end());
+	m_FlushedUpdatedSlots.insert(m_UpdatedSlots.begin(), m_UpdatedSlots.end());
+	m_InsertedSlots.clear();
+	m_UpdatedSlots.clear();
+}
+
+/**
+ * Called after the flush transaction is finished
+ * @param committed false if transaction failed and flushed rows must be written again
+ */
+void CUserInventory::OnFlushed(bool committed)
+{
+	if (!committed)
+	{
+		for (int slot : m_FlushedInsertedSlots)
+		{
+			m_InsertedSlots.insert(slot);
+			m_UpdatedSlots.erase(slot);
+		}
+
+		for (int slot : m_FlushedUpdatedSlots)
+		{
+			if (!m_InsertedSlots.count(slot))
+				m_UpdatedSlots.insert(slot);
+		}
+	}
+
+	m_FlushedInsertedSlots.clear();
+	m_FlushedUpdatedSlots.clear();
+}
+
+void CUserInventory::IndexItem(const CUserInventoryItem& item)
+{
+	if (item.m_nItemID)
+	{
+		m_ItemSlots[item.m_nItemID].insert(item.m_nSlot);
+		m_nItemCount++;
+	}
+	else
+	{
+		m_FreeSlots.insert(item.m_nSlot);
+	}
+}
+
+void CUserInventory::UnindexItem(const CUserInventoryItem& item)
+{
+	if (item.m_nItemID)
+	{
+		auto it = m_ItemSlots.find(item.m_nItemID);
+		if (it != m_ItemSlots.end())
+		{
+			it->second.erase(item.m_nSlot);
+			if (it->second.empty())
+				m_ItemSlots.erase(it);
+		}
+
+		m_nItemCount--;
+	}
+	else
+	{
+		m_FreeSlots.erase(item.m_nSlot);
+	}
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include "userinventoryitem.h"
+
+#include <vector>
+#include <set>
+#include <unordered_map>
+#include <functional>
+
+/**
+ * In-memory copy of UserInventory rows of online user. Rows are indexed by slot and by itemID.
+ * Changes are only remembered here, the database writes them back with FlushInventory
+ */
+class CUserInventory
+{
+public:
+	CUserInventory(const std::vector<CUserInventoryItem>& items, int nextSlot);
+
+	CUserInventoryItem* GetItemBySlot(int slot);
+	CUserInventoryItem* GetFirstItem(int itemID, const std::function<bool(const CUserInventoryItem&)>& filter = nullptr);
+	void GetItems(std::vector<CUserInventoryItem>& items);
+	void GetItemsByID(int itemID, std::vector<CUserInventoryItem>& items);
+	int GetItemCount();
+	int GetNextSlot();
+
+	void AddItem(CUserInventoryItem& item);
+	void UpdateItem(const CUserInventoryItem& item, int flag);
+
+	bool IsDirty();
+	void GetChanges(std::vector<CUserInventoryItem>& insertedItems, std::vector<CUserInventoryItem>& updatedItems);
+	void OnFlushed(bool committed);
+
+private:
+	void IndexItem(const CUserInventoryItem& item);
+	void UnindexItem(const CUserInventoryItem& item);
+
+	std::vector<CUserInventoryItem> m_Items; // index is slot, m_nSlot == -1 if there is no row for the slot
+	std::unordered_map<int, std::set<int>> m_ItemSlots; // itemID -> slots
+	std::set<int> m_FreeSlots; // rows with itemID 0
+	int m_nItemCount;
+	int m_nNextSlot;
+
+	// write-behind queue
+	std::set<int> m_InsertedSlots;
+	std::set<int> m_UpdatedSlots;
+	std::set<int> m_FlushedInsertedSlots;
+	std::set<int> m_FlushedUpdatedSlots;
+};